@@ -10,6 +10,7 @@
 #include "screenshot.h"
 #include "screenshot_storage.h"
 #include "sdcard_manager.h"
+#include "image_codec.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
@@ -210,24 +211,17 @@ esp_err_t gallery_view_image(const char *filename)
     char filepath[256];
     screenshot_storage_get_path(filename, filepath, sizeof(filepath));
 
-    /* Open BMP file */
-    FILE *f = fopen(filepath, "rb");
-    if (f == NULL) {
-        ESP_LOGE(TAG, "Failed to open file: %s", filepath);
-        return ESP_ERR_NOT_FOUND;
+    /* Open image (BMP, QOI or PNG, recognised by content) */
+    image_decoder_t dec;
+    esp_err_t ret = image_decoder_open(&dec, filepath);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open image %s: %s", filepath, esp_err_to_name(ret));
+        return ret;
     }
 
-    /* Read BMP header */
-    uint8_t header[54];
-    fread(header, 1, 54, f);
-
-    /* Parse dimensions */
-    int width = header[18] | (header[19] << 8) | (header[20] << 16) | (header[21] << 24);
-    int height = header[22] | (header[23] << 8) | (header[24] << 16) | (header[25] << 24);
-    
-    if (height < 0) height = -height;  /* Handle top-down BMPs */
-
-    ESP_LOGI(TAG, "Image size: %dx%d", width, height);
+    int width = dec.width;
+    int height = dec.height;
+    ESP_LOGI(TAG, "Image size: %dx%d (%s)", width, height, image_format_name(dec.format));
 
     /* Allocate buffer for image */
     size_t buffer_size = width * height * sizeof(lv_color_t);
@@ -238,35 +232,20 @@ esp_err_t gallery_view_image(const char *filename)
     
     g_image_buffer = heap_caps_malloc(buffer_size, MALLOC_CAP_SPIRAM);
     if (g_image_buffer == NULL) {
-        fclose(f);
+        image_decoder_close(&dec);
         ESP_LOGE(TAG, "Failed to allocate image buffer");
         return ESP_ERR_NO_MEM;
     }
 
-    /* Read and convert BMP data (bottom-up, BGR) to LVGL format */
-    int row_size = ((width * 3 + 3) / 4) * 4;
-    uint8_t *row_buffer = malloc(row_size);
-    
-    if (row_buffer == NULL) {
-        fclose(f);
-        return ESP_ERR_NO_MEM;
+    /* Decode straight into the buffer (lv_color_t is RGB565 with LV_COLOR_DEPTH 16, no swap) */
+    ret = image_decoder_read(&dec, (uint16_t *)g_image_buffer);
+    image_decoder_close(&dec);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to decode image: %s", esp_err_to_name(ret));
+        gallery_close_viewer();     /* Hides the viewer before the buffer it shows is freed */
+        return ret;
     }
 
-    for (int y = height - 1; y >= 0; y--) {
-        fread(row_buffer, 1, row_size, f);
-        
-        for (int x = 0; x < width; x++) {
-            uint8_t b = row_buffer[x * 3 + 0];
-            uint8_t g = row_buffer[x * 3 + 1];
-            uint8_t r = row_buffer[x * 3 + 2];
-            
-            g_image_buffer[y * width + x] = lv_color_make(r, g, b);
-        }
-    }
-
-    free(row_buffer);
-    fclose(f);
-
     /* Show image viewer */
     if (g_ui->scrSettings_contImageViewer) {
         lv_obj_clear_flag(g_ui->scrSettings_contImageViewer, LV_OBJ_FLAG_HIDDEN);
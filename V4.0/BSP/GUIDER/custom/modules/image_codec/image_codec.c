@@ -0,0 +1,932 @@
+/**
+ * @file image_codec.c
+ * @brief Streaming BMP / QOI / PNG encoder from RGB565 rows, and decoder to RGB565
+ */
+
+#include "image_codec.h"
+#include "esp_heap_caps.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/* Encoder stages */
+enum {
+    STAGE_HEADER = 0,
+    STAGE_ROWS,
+    STAGE_TRAILER,
+    STAGE_DONE,
+};
+
+#define BMP_HEADER_SIZE     54
+#define QOI_HEADER_SIZE     14
+#define QOI_END_SIZE        8
+#define PNG_SIGNATURE_SIZE  8
+#define PNG_CHUNK_OVERHEAD  12              // Length, type, CRC
+#define PNG_IHDR_SIZE       13
+#define PNG_HEADER_SIZE     (PNG_SIGNATURE_SIZE + PNG_CHUNK_OVERHEAD + PNG_IHDR_SIZE)
+#define PNG_TRAILER_SIZE    (2 * PNG_CHUNK_OVERHEAD + IMAGE_DEFLATE_FINISH_BOUND)
+
+/* QOI ops */
+#define QOI_OP_INDEX        0x00
+#define QOI_OP_DIFF         0x40
+#define QOI_OP_LUMA         0x80
+#define QOI_OP_RUN          0xC0
+#define QOI_OP_RGB          0xFE
+#define QOI_OP_RGBA         0xFF
+#define QOI_MASK            0xC0
+#define QOI_RUN_MAX         62
+#define QOI_PIXEL(r, g, b)  (0xFF000000u | ((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (b))
+#define QOI_HASH(r, g, b)   (((r) * 3 + (g) * 5 + (b) * 7 + 255 * 11) & 63)
+
+/* PNG filter types */
+#define PNG_FILTER_NONE     0
+#define PNG_FILTER_SUB      1
+#define PNG_FILTER_UP       2
+#define PNG_FILTER_AVERAGE  3
+#define PNG_FILTER_PAETH    4
+
+/* RGB565 <-> 8-bit channels; widening by shift keeps the round trip exact */
+#define RGB565_R(p)         ((uint8_t)(((p) >> 11) << 3))
+#define RGB565_G(p)         ((uint8_t)((((p) >> 5) & 0x3F) << 2))
+#define RGB565_B(p)         ((uint8_t)(((p) & 0x1F) << 3))
+#define RGB565(r, g, b)     ((uint16_t)((((r) >> 3) << 11) | (((g) >> 2) << 5) | ((b) >> 3)))
+
+#define DECODE_INPUT        4096
+
+static const uint8_t s_png_signature[PNG_SIGNATURE_SIZE] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+static const char *const s_format_names[IMAGE_FORMAT_COUNT] = {"BMP", "QOI", "PNG"};
+static const char *const s_format_exts[IMAGE_FORMAT_COUNT] = {".bmp", ".qoi", ".png"};
+
+static uint32_t s_crc_table[4][256];            // Slicing-by-4
+static bool s_crc_ready = false;
+
+/* Internal RAM first (the hot encoder and decoder state), PSRAM otherwise */
+static void *codec_alloc(size_t size)
+{
+    void *p = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (p == NULL) {
+        p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    }
+    return p;
+}
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+}
+
+static void put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint32_t get_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+/**
+ * @brief Name of a format
+ */
+const char *image_format_name(image_format_t format)
+{
+    return (unsigned)format < IMAGE_FORMAT_COUNT ? s_format_names[format] : "?";
+}
+
+/**
+ * @brief File extension of a format
+ */
+const char *image_format_ext(image_format_t format)
+{
+    return (unsigned)format < IMAGE_FORMAT_COUNT ? s_format_exts[format] : "";
+}
+
+/**
+ * @brief Format from a file name's extension
+ */
+bool image_format_from_path(const char *path, image_format_t *format)
+{
+    const char *ext = path != NULL ? strrchr(path, '.') : NULL;
+    if (ext == NULL) return false;
+
+    for (int i = 0; i < IMAGE_FORMAT_COUNT; i++) {
+        if (strcasecmp(ext, s_format_exts[i]) == 0) {
+            *format = (image_format_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ---------------------------------------------------------------- BMP */
+
+static size_t bmp_row_size(int width)
+{
+    return ((size_t)width * 3 + 3) & ~(size_t)3;    /* Rows are 4-byte aligned */
+}
+
+static size_t bmp_header(const image_encoder_t *enc, uint8_t *out)
+{
+    uint32_t image_size = (uint32_t)(bmp_row_size(enc->width) * enc->height);
+
+    memset(out, 0, BMP_HEADER_SIZE);
+    out[0] = 'B';
+    out[1] = 'M';
+    put_le32(out + 2, BMP_HEADER_SIZE + image_size);
+    put_le32(out + 10, BMP_HEADER_SIZE);            /* Data offset */
+    put_le32(out + 14, 40);                         /* DIB header size */
+    put_le32(out + 18, enc->width);
+    put_le32(out + 22, enc->height);                /* Positive: bottom-up */
+    put_le16(out + 26, 1);                          /* Planes */
+    put_le16(out + 28, 24);                         /* Bits per pixel */
+    put_le32(out + 34, image_size);
+    put_le32(out + 38, 2835);                       /* 72 DPI */
+    put_le32(out + 42, 2835);
+    return BMP_HEADER_SIZE;
+}
+
+static size_t bmp_row(const image_encoder_t *enc, const uint16_t *src, uint8_t *out)
+{
+    uint8_t *p = out;
+    for (int x = 0; x < enc->width; x++) {
+        uint16_t pixel = src[x];
+        *p++ = RGB565_B(pixel);
+        *p++ = RGB565_G(pixel);
+        *p++ = RGB565_R(pixel);
+    }
+    while ((size_t)(p - out) < enc->row_bound) {
+        *p++ = 0;
+    }
+    return enc->row_bound;
+}
+
+/* ---------------------------------------------------------------- QOI */
+
+static size_t qoi_header(const image_encoder_t *enc, uint8_t *out)
+{
+    memcpy(out, "qoif", 4);
+    put_be32(out + 4, enc->width);
+    put_be32(out + 8, enc->height);
+    out[12] = 3;                                    /* RGB */
+    out[13] = 0;                                    /* sRGB */
+    return QOI_HEADER_SIZE;
+}
+
+/* The pixel run carries over from one row to the next, as in one long row */
+static size_t qoi_row(image_encoder_t *enc, const uint16_t *src, uint8_t *out)
+{
+    uint8_t *p = out;
+    uint32_t prev = enc->qoi_prev;
+    int run = enc->qoi_run;
+
+    for (int x = 0; x < enc->width; x++) {
+        uint16_t c = src[x];
+        uint8_t r = RGB565_R(c), g = RGB565_G(c), b = RGB565_B(c);
+        uint32_t px = QOI_PIXEL(r, g, b);
+
+        if (px == prev) {
+            if (++run == QOI_RUN_MAX) {
+                *p++ = QOI_OP_RUN | (run - 1);
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *p++ = QOI_OP_RUN | (run - 1);
+            run = 0;
+        }
+
+        int h = QOI_HASH(r, g, b);
+        if (enc->qoi_index[h] == px) {
+            *p++ = QOI_OP_INDEX | h;
+        } else {
+            enc->qoi_index[h] = px;
+            int8_t dr = (int8_t)(r - (uint8_t)(prev >> 16));
+            int8_t dg = (int8_t)(g - (uint8_t)(prev >> 8));
+            int8_t db = (int8_t)(b - (uint8_t)prev);
+            int dr_dg = dr - dg;
+            int db_dg = db - dg;
+
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                *p++ = QOI_OP_DIFF | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2);
+            } else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7) {
+                *p++ = QOI_OP_LUMA | (dg + 32);
+                *p++ = ((dr_dg + 8) << 4) | (db_dg + 8);
+            } else {
+                *p++ = QOI_OP_RGB;
+                *p++ = r;
+                *p++ = g;
+                *p++ = b;
+            }
+        }
+        prev = px;
+    }
+
+    enc->qoi_prev = prev;
+    enc->qoi_run = run;
+    return p - out;
+}
+
+static size_t qoi_trailer(image_encoder_t *enc, uint8_t *out)
+{
+    uint8_t *p = out;
+    if (enc->qoi_run > 0) {
+        *p++ = QOI_OP_RUN | (enc->qoi_run - 1);
+        enc->qoi_run = 0;
+    }
+    memset(p, 0, QOI_END_SIZE - 1);
+    p[QOI_END_SIZE - 1] = 1;
+    return p + QOI_END_SIZE - out;
+}
+
+/* ---------------------------------------------------------------- PNG */
+
+static void crc_init(void)
+{
+    if (s_crc_ready) return;
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        s_crc_table[0][n] = c;
+    }
+    for (uint32_t n = 0; n < 256; n++) {
+        for (int t = 1; t < 4; t++) {
+            uint32_t c = s_crc_table[t - 1][n];
+            s_crc_table[t][n] = s_crc_table[0][c & 0xFF] ^ (c >> 8);
+        }
+    }
+    s_crc_ready = true;
+}
+
+/* CRC-32 as PNG uses it, four bytes per step (chunks run to tens of KB) */
+static uint32_t crc32(const uint8_t *data, size_t len)
+{
+    uint32_t c = 0xFFFFFFFFu;
+    while (len >= 4) {
+        c ^= data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+        c = s_crc_table[3][c & 0xFF] ^ s_crc_table[2][(c >> 8) & 0xFF] ^
+            s_crc_table[1][(c >> 16) & 0xFF] ^ s_crc_table[0][c >> 24];
+        data += 4;
+        len -= 4;
+    }
+    while (len-- > 0) {
+        c = s_crc_table[0][(c ^ *data++) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+/* Complete a chunk whose data is already at chunk + 8; returns its full size */
+static size_t png_chunk(uint8_t *chunk, const char *type, size_t data_len)
+{
+    put_be32(chunk, (uint32_t)data_len);
+    memcpy(chunk + 4, type, 4);
+    put_be32(chunk + 8 + data_len, crc32(chunk + 4, 4 + data_len));
+    return PNG_CHUNK_OVERHEAD + data_len;
+}
+
+static size_t png_header(const image_encoder_t *enc, uint8_t *out)
+{
+    memcpy(out, s_png_signature, PNG_SIGNATURE_SIZE);
+
+    uint8_t *ihdr = out + PNG_SIGNATURE_SIZE;
+    put_be32(ihdr + 8, enc->width);
+    put_be32(ihdr + 12, enc->height);
+    ihdr[16] = 8;                                   /* Bit depth */
+    ihdr[17] = 2;                                   /* Colour type: RGB */
+    ihdr[18] = 0;                                   /* Deflate */
+    ihdr[19] = 0;                                   /* Adaptive filtering */
+    ihdr[20] = 0;                                   /* Not interlaced */
+    return PNG_SIGNATURE_SIZE + png_chunk(ihdr, "IHDR", PNG_IHDR_SIZE);
+}
+
+static uint8_t paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+/* Widen a row to RGB888 behind its filter byte, applying Up against the previous row if used */
+static size_t png_row(image_encoder_t *enc, const uint16_t *src, uint8_t *out)
+{
+    uint8_t *row = enc->scan + 1;
+    size_t n = (size_t)enc->width * 3;
+
+    enc->scan[0] = enc->png_filter;
+    if (enc->png_filter == PNG_FILTER_UP) {
+        uint8_t *prior = enc->prior;
+        for (int x = 0; x < enc->width; x++, row += 3, prior += 3) {
+            uint16_t pixel = src[x];
+            uint8_t r = RGB565_R(pixel), g = RGB565_G(pixel), b = RGB565_B(pixel);
+            row[0] = r - prior[0];
+            row[1] = g - prior[1];
+            row[2] = b - prior[2];
+            prior[0] = r;
+            prior[1] = g;
+            prior[2] = b;
+        }
+    } else {
+        for (int x = 0; x < enc->width; x++, row += 3) {
+            uint16_t pixel = src[x];
+            row[0] = RGB565_R(pixel);
+            row[1] = RGB565_G(pixel);
+            row[2] = RGB565_B(pixel);
+        }
+    }
+
+    return image_deflate_write(enc->deflate, enc->scan, n + 1, out);
+}
+
+static size_t png_trailer(image_encoder_t *enc, uint8_t *out)
+{
+    size_t len = image_deflate_finish(enc->deflate, out + 8);
+    size_t used = png_chunk(out, "IDAT", len);
+    return used + png_chunk(out + used, "IEND", 0);
+}
+
+/* ---------------------------------------------------------------- Encoder */
+
+/**
+ * @brief Set up an encoder
+ */
+esp_err_t image_encoder_init(image_encoder_t *enc, image_format_t format, int level,
+                             int width, int height, image_row_fn get_row, void *user)
+{
+    if (enc == NULL || get_row == NULL || (unsigned)format >= IMAGE_FORMAT_COUNT ||
+        width <= 0 || height <= 0 || width > IMAGE_CODEC_MAX_DIM || height > IMAGE_CODEC_MAX_DIM) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(enc, 0, sizeof(*enc));
+    enc->format = format;
+    enc->width = width;
+    enc->height = height;
+    enc->get_row = get_row;
+    enc->user = user;
+    enc->stage = STAGE_HEADER;
+
+    switch (format) {
+    case IMAGE_FORMAT_BMP:
+        enc->row_bound = bmp_row_size(width);
+        break;
+
+    case IMAGE_FORMAT_QOI:
+        enc->row_bound = (size_t)width * 4 + 1;     /* QOI_OP_RGB per pixel, plus a run ended */
+        enc->qoi_prev = QOI_PIXEL(0, 0, 0);
+        break;
+
+    case IMAGE_FORMAT_PNG: {
+        size_t n = (size_t)width * 3;
+
+        /*
+         * On UI screens Up only pays at level 1, where the short hash-chain
+         * search rarely reaches the row above by itself (5% smaller, and
+         * faster); from level 2 up the unfiltered rows compress better.
+         */
+        enc->png_filter = (level == 1) ? PNG_FILTER_UP : PNG_FILTER_NONE;
+        enc->deflate = codec_alloc(sizeof(image_deflate_t));
+        enc->scan = codec_alloc(n + 1);
+        if (enc->png_filter == PNG_FILTER_UP) {
+            enc->prior = codec_alloc(n);
+        }
+        if (enc->deflate == NULL || enc->scan == NULL ||
+            (enc->png_filter == PNG_FILTER_UP && enc->prior == NULL)) {
+            image_encoder_deinit(enc);
+            return ESP_ERR_NO_MEM;
+        }
+        if (enc->prior != NULL) {
+            memset(enc->prior, 0, n);
+        }
+        crc_init();
+        image_deflate_init(enc->deflate, level);
+        enc->row_bound = image_deflate_bound(enc->deflate, n + 1);
+        break;
+    }
+
+    default:
+        break;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Free the encoder's buffers
+ */
+void image_encoder_deinit(image_encoder_t *enc)
+{
+    if (enc == NULL) return;
+    heap_caps_free(enc->deflate);
+    heap_caps_free(enc->scan);
+    heap_caps_free(enc->prior);
+    enc->deflate = NULL;
+    enc->scan = NULL;
+    enc->prior = NULL;
+}
+
+static size_t header_size(const image_encoder_t *enc)
+{
+    switch (enc->format) {
+    case IMAGE_FORMAT_BMP: return BMP_HEADER_SIZE;
+    case IMAGE_FORMAT_QOI: return QOI_HEADER_SIZE;
+    default:               return PNG_HEADER_SIZE;
+    }
+}
+
+static size_t trailer_size(const image_encoder_t *enc)
+{
+    switch (enc->format) {
+    case IMAGE_FORMAT_BMP: return 0;
+    case IMAGE_FORMAT_QOI: return 1 + QOI_END_SIZE;
+    default:               return PNG_TRAILER_SIZE;
+    }
+}
+
+/* Room one more row needs, including a PNG chunk around it */
+static size_t row_room(const image_encoder_t *enc)
+{
+    return enc->row_bound + (enc->format == IMAGE_FORMAT_PNG ? PNG_CHUNK_OVERHEAD : 0);
+}
+
+/**
+ * @brief Smallest buffer image_encoder_fill() can always make progress with
+ */
+size_t image_encoder_min_buffer(const image_encoder_t *enc)
+{
+    size_t min = header_size(enc);
+    if (row_room(enc) > min) min = row_room(enc);
+    if (trailer_size(enc) > min) min = trailer_size(enc);
+    return min;
+}
+
+/* Encode whole rows while they fit; PNG rows go into one IDAT chunk per call */
+static size_t encode_rows(image_encoder_t *enc, uint8_t *out, size_t size)
+{
+    bool png = (enc->format == IMAGE_FORMAT_PNG);
+    size_t used = png ? 8 : 0;
+    size_t reserve = png ? 4 : 0;
+
+    while (enc->rows_done < enc->height && size >= used + enc->row_bound + reserve) {
+        int y = (enc->format == IMAGE_FORMAT_BMP) ? enc->height - 1 - enc->rows_done : enc->rows_done;
+        const uint16_t *src = enc->get_row(enc->user, y);
+
+        switch (enc->format) {
+        case IMAGE_FORMAT_BMP: used += bmp_row(enc, src, out + used); break;
+        case IMAGE_FORMAT_QOI: used += qoi_row(enc, src, out + used); break;
+        default:               used += png_row(enc, src, out + used); break;
+        }
+        enc->rows_done++;
+    }
+
+    if (png) {
+        /* Rows can compress to nothing yet (bits pending); skip the empty chunk */
+        return used > 8 ? png_chunk(out, "IDAT", used - 8) : 0;
+    }
+    return used;
+}
+
+/**
+ * @brief Write the next part of the file
+ */
+esp_err_t image_encoder_fill(image_encoder_t *enc, uint8_t *buf, size_t size, size_t *len)
+{
+    size_t used = 0;
+    *len = 0;
+
+    if (enc->stage == STAGE_HEADER) {
+        if (size < header_size(enc)) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        switch (enc->format) {
+        case IMAGE_FORMAT_BMP: used = bmp_header(enc, buf); break;
+        case IMAGE_FORMAT_QOI: used = qoi_header(enc, buf); break;
+        default:               used = png_header(enc, buf); break;
+        }
+        enc->stage = STAGE_ROWS;
+    }
+
+    if (enc->stage == STAGE_ROWS) {
+        int rows = enc->rows_done;
+        used += encode_rows(enc, buf + used, size - used);
+        if (enc->rows_done == enc->height) {
+            enc->stage = STAGE_TRAILER;
+        } else if (used == 0 && enc->rows_done == rows) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    if (enc->stage == STAGE_TRAILER) {
+        if (size - used >= trailer_size(enc)) {
+            switch (enc->format) {
+            case IMAGE_FORMAT_BMP: break;
+            case IMAGE_FORMAT_QOI: used += qoi_trailer(enc, buf + used); break;
+            default:               used += png_trailer(enc, buf + used); break;
+            }
+            enc->stage = STAGE_DONE;
+        } else if (used == 0) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+
+    enc->bytes += used;
+    *len = used;
+    return ESP_OK;
+}
+
+/**
+ * @brief Bytes written so far
+ */
+uint64_t image_encoder_bytes(const image_encoder_t *enc)
+{
+    return enc->bytes;
+}
+
+/* ---------------------------------------------------------------- Decoder */
+
+/**
+ * @brief Open an image file and read its header
+ */
+esp_err_t image_decoder_open(image_decoder_t *dec, const char *path)
+{
+    if (dec == NULL || path == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(dec, 0, sizeof(*dec));
+    dec->f = fopen(path, "rb");
+    if (dec->f == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    uint8_t h[BMP_HEADER_SIZE];
+    size_t n = fread(h, 1, sizeof(h), dec->f);
+    esp_err_t ret = ESP_OK;
+
+    if (n >= BMP_HEADER_SIZE && h[0] == 'B' && h[1] == 'M') {
+        int32_t height = (int32_t)get_le32(h + 22);
+        uint32_t compression = get_le32(h + 30);
+        dec->format = IMAGE_FORMAT_BMP;
+        dec->width = (int32_t)get_le32(h + 18);
+        dec->height = height < 0 ? -height : height;
+        dec->bmp_bottom_up = height > 0;
+        dec->bmp_offset = get_le32(h + 10);
+        dec->bmp_bpp = h[28] | (h[29] << 8);
+        if ((dec->bmp_bpp != 24 && dec->bmp_bpp != 32) || compression != 0) {
+            ret = ESP_ERR_NOT_SUPPORTED;
+        }
+    } else if (n >= QOI_HEADER_SIZE && memcmp(h, "qoif", 4) == 0) {
+        dec->format = IMAGE_FORMAT_QOI;
+        dec->width = (int)get_be32(h + 4);
+        dec->height = (int)get_be32(h + 8);
+    } else if (n >= PNG_HEADER_SIZE && memcmp(h, s_png_signature, PNG_SIGNATURE_SIZE) == 0 &&
+               memcmp(h + 12, "IHDR", 4) == 0) {
+        uint8_t depth = h[24], color = h[25], interlace = h[28];
+        dec->format = IMAGE_FORMAT_PNG;
+        dec->width = (int)get_be32(h + 16);
+        dec->height = (int)get_be32(h + 20);
+        dec->png_color_type = color;
+        if (depth != 8 || interlace != 0 || color == 1 || color == 5 || color > 6) {
+            ret = ESP_ERR_NOT_SUPPORTED;
+        }
+    } else {
+        ret = ESP_ERR_INVALID_ARG;
+    }
+
+    if (ret == ESP_OK && (dec->width <= 0 || dec->height <= 0 ||
+                          dec->width > IMAGE_CODEC_MAX_DIM || dec->height > IMAGE_CODEC_MAX_DIM)) {
+        ret = ESP_ERR_NOT_SUPPORTED;
+    }
+    if (ret != ESP_OK) {
+        image_decoder_close(dec);
+    }
+    return ret;
+}
+
+static esp_err_t bmp_read(image_decoder_t *dec, uint16_t *pixels)
+{
+    int bytes_pp = dec->bmp_bpp / 8;
+    size_t row_size = ((size_t)dec->width * bytes_pp + 3) & ~(size_t)3;
+    uint8_t *row = codec_alloc(row_size);
+    if (row == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = ESP_OK;
+    if (fseek(dec->f, dec->bmp_offset, SEEK_SET) != 0) {
+        ret = ESP_ERR_INVALID_ARG;
+    }
+
+    for (int i = 0; i < dec->height && ret == ESP_OK; i++) {
+        if (fread(row, 1, row_size, dec->f) != row_size) {
+            ret = ESP_ERR_INVALID_ARG;
+            break;
+        }
+        int y = dec->bmp_bottom_up ? dec->height - 1 - i : i;
+        uint16_t *dst = pixels + (size_t)y * dec->width;
+        const uint8_t *p = row;
+        for (int x = 0; x < dec->width; x++, p += bytes_pp) {
+            dst[x] = RGB565(p[2], p[1], p[0]);
+        }
+    }
+
+    heap_caps_free(row);
+    return ret;
+}
+
+static esp_err_t qoi_read(image_decoder_t *dec, uint16_t *pixels)
+{
+    uint8_t *in = codec_alloc(DECODE_INPUT);
+    if (in == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    fseek(dec->f, QOI_HEADER_SIZE, SEEK_SET);
+
+    uint32_t index[64] = {0};
+    uint8_t r = 0, g = 0, b = 0, a = 255;
+    uint16_t pixel = 0;
+    size_t total = (size_t)dec->width * dec->height;
+    size_t pos = 0, avail = 0;
+    int run = 0;
+    bool bad = false;
+
+    for (size_t i = 0; i < total; i++) {
+        if (run > 0) {
+            run--;
+            pixels[i] = pixel;
+            continue;
+        }
+
+        /* Every op but the end marker is at most 5 bytes */
+        if (avail - pos < 5) {
+            memmove(in, in + pos, avail - pos);
+            avail -= pos;
+            pos = 0;
+            avail += fread(in + avail, 1, DECODE_INPUT - avail, dec->f);
+            if (avail == 0) {
+                bad = true;
+                break;
+            }
+        }
+
+        uint8_t op = in[pos++];
+        if (op == QOI_OP_RGB) {
+            r = in[pos];
+            g = in[pos + 1];
+            b = in[pos + 2];
+            pos += 3;
+        } else if (op == QOI_OP_RGBA) {
+            r = in[pos];
+            g = in[pos + 1];
+            b = in[pos + 2];
+            a = in[pos + 3];
+            pos += 4;
+        } else if ((op & QOI_MASK) == QOI_OP_INDEX) {
+            uint32_t px = index[op];
+            r = px >> 24;
+            g = px >> 16;
+            b = px >> 8;
+            a = px;
+        } else if ((op & QOI_MASK) == QOI_OP_DIFF) {
+            r += ((op >> 4) & 3) - 2;
+            g += ((op >> 2) & 3) - 2;
+            b += (op & 3) - 2;
+        } else if ((op & QOI_MASK) == QOI_OP_LUMA) {
+            uint8_t next = in[pos++];
+            int dg = (op & 0x3F) - 32;
+            g += dg;
+            r += dg - 8 + (next >> 4);
+            b += dg - 8 + (next & 0x0F);
+        } else {
+            run = op & 0x3F;
+        }
+
+        index[(r * 3 + g * 5 + b * 7 + a * 11) & 63] =
+            ((uint32_t)r << 24) | ((uint32_t)g << 16) | ((uint32_t)b << 8) | a;
+        pixel = RGB565(r, g, b);
+        pixels[i] = pixel;
+        if (pos > avail) {
+            bad = true;                             /* Op ran past the end of the file */
+            break;
+        }
+    }
+
+    heap_caps_free(in);
+    return bad ? ESP_ERR_INVALID_ARG : ESP_OK;
+}
+
+/* PNG decode state shared by the inflate callbacks */
+typedef struct {
+    image_decoder_t *dec;
+    uint16_t *pixels;
+    uint32_t chunk_left;                            // Bytes left in the current IDAT
+    bool idat_done;
+    size_t stride;                                  // Bytes per row, filter byte excluded
+    int bpp;                                        // Bytes per pixel
+    uint8_t *cur;                                   // Filter byte + row being received
+    uint8_t *prev;                                  // Previous row, unfiltered (after its filter byte)
+    size_t fill;
+    int y;
+} png_read_t;
+
+static size_t png_idat_read(void *user, uint8_t *buf, size_t size)
+{
+    png_read_t *rd = (png_read_t *)user;
+    FILE *f = rd->dec->f;
+
+    while (rd->chunk_left == 0) {
+        uint8_t hdr[12];                            /* CRC of this chunk, header of the next */
+        if (rd->idat_done || fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr) ||
+            memcmp(hdr + 8, "IDAT", 4) != 0) {
+            rd->idat_done = true;
+            return 0;
+        }
+        rd->chunk_left = get_be32(hdr + 4);
+    }
+
+    size_t n = size < rd->chunk_left ? size : rd->chunk_left;
+    n = fread(buf, 1, n, f);
+    if (n == 0) {
+        rd->idat_done = true;
+    }
+    rd->chunk_left -= n;
+    return n;
+}
+
+static void png_unfilter(png_read_t *rd)
+{
+    uint8_t *row = rd->cur + 1;
+    const uint8_t *prior = rd->prev + 1;
+    int bpp = rd->bpp;
+    size_t n = rd->stride;
+
+    switch (rd->cur[0]) {
+    case PNG_FILTER_SUB:
+        for (size_t i = bpp; i < n; i++) row[i] += row[i - bpp];
+        break;
+    case PNG_FILTER_UP:
+        for (size_t i = 0; i < n; i++) row[i] += prior[i];
+        break;
+    case PNG_FILTER_AVERAGE:
+        for (size_t i = 0; i < n; i++) {
+            int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+            row[i] += (a + prior[i]) >> 1;
+        }
+        break;
+    case PNG_FILTER_PAETH:
+        for (size_t i = 0; i < n; i++) {
+            int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+            int c = i >= (size_t)bpp ? prior[i - bpp] : 0;
+            row[i] += paeth(a, prior[i], c);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void png_convert_row(png_read_t *rd)
+{
+    const uint8_t *p = rd->cur + 1;
+    uint16_t *dst = rd->pixels + (size_t)rd->y * rd->dec->width;
+    int width = rd->dec->width;
+
+    switch (rd->dec->png_color_type) {
+    case 0:                                         /* Grey */
+    case 4:                                         /* Grey + alpha */
+        for (int x = 0; x < width; x++, p += rd->bpp) dst[x] = RGB565(p[0], p[0], p[0]);
+        break;
+    case 3:                                         /* Palette */
+        for (int x = 0; x < width; x++) dst[x] = rd->dec->png_palette[p[x]];
+        break;
+    default:                                        /* RGB, RGB + alpha (alpha dropped) */
+        for (int x = 0; x < width; x++, p += rd->bpp) dst[x] = RGB565(p[0], p[1], p[2]);
+        break;
+    }
+}
+
+static bool png_write_rows(void *user, const uint8_t *data, size_t len)
+{
+    png_read_t *rd = (png_read_t *)user;
+    size_t row_len = rd->stride + 1;
+
+    while (len > 0 && rd->y < rd->dec->height) {
+        size_t n = row_len - rd->fill;
+        if (n > len) n = len;
+        memcpy(rd->cur + rd->fill, data, n);
+        rd->fill += n;
+        data += n;
+        len -= n;
+
+        if (rd->fill == row_len) {
+            png_unfilter(rd);
+            png_convert_row(rd);
+            uint8_t *t = rd->prev;
+            rd->prev = rd->cur;
+            rd->cur = t;
+            rd->fill = 0;
+            rd->y++;
+        }
+    }
+    return true;                                    /* Anything past the last row is ignored */
+}
+
+static esp_err_t png_read(image_decoder_t *dec, uint16_t *pixels)
+{
+    static const uint8_t channels[7] = {1, 0, 3, 1, 2, 0, 4};
+    png_read_t rd = {
+        .dec = dec,
+        .pixels = pixels,
+        .bpp = channels[dec->png_color_type],
+    };
+    rd.stride = (size_t)dec->width * rd.bpp;
+
+    /* Walk the chunks up to the first IDAT, keeping the palette */
+    fseek(dec->f, PNG_SIGNATURE_SIZE, SEEK_SET);
+    for (;;) {
+        uint8_t hdr[8];
+        if (fread(hdr, 1, sizeof(hdr), dec->f) != sizeof(hdr)) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        uint32_t len = get_be32(hdr);
+        if (memcmp(hdr + 4, "IDAT", 4) == 0) {
+            rd.chunk_left = len;
+            break;
+        }
+        if (memcmp(hdr + 4, "IEND", 4) == 0) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (memcmp(hdr + 4, "PLTE", 4) == 0 && len <= 3 * 256 && len % 3 == 0) {
+            uint8_t rgb[3];
+            for (uint32_t i = 0; i < len / 3; i++) {
+                if (fread(rgb, 1, 3, dec->f) != 3) return ESP_ERR_INVALID_ARG;
+                dec->png_palette[i] = RGB565(rgb[0], rgb[1], rgb[2]);
+            }
+            len = 0;
+        }
+        if (fseek(dec->f, len + 4, SEEK_CUR) != 0) {    /* Data and CRC */
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    image_inflate_t *z = codec_alloc(sizeof(image_inflate_t));
+    rd.cur = codec_alloc(rd.stride + 1);
+    rd.prev = codec_alloc(rd.stride + 1);
+    esp_err_t ret = ESP_ERR_NO_MEM;
+
+    if (z != NULL && rd.cur != NULL && rd.prev != NULL) {
+        memset(rd.prev, 0, rd.stride + 1);
+        image_inflate_result_t result = image_inflate(z, png_idat_read, png_write_rows, &rd);
+        ret = (result == IMAGE_INFLATE_OK && rd.y == dec->height) ? ESP_OK : ESP_ERR_INVALID_ARG;
+    }
+
+    heap_caps_free(z);
+    heap_caps_free(rd.cur);
+    heap_caps_free(rd.prev);
+    return ret;
+}
+
+/**
+ * @brief Decode the whole image
+ */
+esp_err_t image_decoder_read(image_decoder_t *dec, uint16_t *pixels)
+{
+    if (dec == NULL || dec->f == NULL || pixels == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    switch (dec->format) {
+    case IMAGE_FORMAT_BMP: return bmp_read(dec, pixels);
+    case IMAGE_FORMAT_QOI: return qoi_read(dec, pixels);
+    default:               return png_read(dec, pixels);
+    }
+}
+
+/**
+ * @brief Close the file
+ */
+void image_decoder_close(image_decoder_t *dec)
+{
+    if (dec != NULL && dec->f != NULL) {
+        fclose(dec->f);
+        dec->f = NULL;
+    }
+}
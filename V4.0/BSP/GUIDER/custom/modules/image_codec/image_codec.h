@@ -0,0 +1,171 @@
+/**
+ * @file image_codec.h
+ * @brief Streaming BMP / QOI / PNG encoder from RGB565 rows, and decoder to RGB565
+ *
+ * The encoder pulls source rows one at a time through a callback and writes
+ * the file into whatever buffer it is handed, so it plugs straight into a
+ * storage_writer fill function: no RGB888 copy of the image is made and the
+ * memory used is a few scanlines plus, for PNG, the compressor state.
+ *
+ *   BMP  24-bit bottom-up, uncompressed (rows are pulled last to first)
+ *   QOI  lossless, single pass, no tables beyond the 64-entry index
+ *   PNG  8-bit RGB; level 0 is stored deflate, 1..6 trade time for size
+ *
+ * RGB565 is widened by shifting (r << 3, g << 2, b << 3), so a file written
+ * here decodes back to the exact source pixels.
+ *
+ * The decoder reads any of the three formats (detected by content, not by
+ * name) into an RGB565 buffer: 24/32-bit uncompressed BMP, QOI, and 8-bit
+ * non-interlaced PNG of every colour type.
+ */
+
+#ifndef IMAGE_CODEC_H
+#define IMAGE_CODEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include "image_zlib.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define IMAGE_CODEC_MAX_DIM         4096
+#define IMAGE_CODEC_PNG_LEVEL       1       // Default PNG compression level
+
+/* File formats */
+typedef enum {
+    IMAGE_FORMAT_BMP = 0,
+    IMAGE_FORMAT_QOI,
+    IMAGE_FORMAT_PNG,
+    IMAGE_FORMAT_COUNT,
+} image_format_t;
+
+/**
+ * @brief Source row for the encoder
+ *
+ * @param y Row, 0 at the top
+ * @return width RGB565 pixels, valid until the next call
+ */
+typedef const uint16_t *(*image_row_fn)(void *user, int y);
+
+/* Encoder (fields are private; use the functions below) */
+typedef struct {
+    image_format_t format;
+    int width;
+    int height;
+    image_row_fn get_row;
+    void *user;
+    int stage;                      // Header, rows, trailer, done
+    int rows_done;
+    size_t row_bound;               // Most bytes one row can produce
+    uint64_t bytes;                 // Output so far
+    /* QOI */
+    uint32_t qoi_index[64];
+    uint32_t qoi_prev;
+    int qoi_run;
+    /* PNG */
+    image_deflate_t *deflate;
+    uint8_t png_filter;             // Filter type used for every row
+    uint8_t *scan;                  // Filter byte + filtered RGB888 of the current row
+    uint8_t *prior;                 // RGB888 of the row above (Up filter only)
+} image_encoder_t;
+
+/* Decoder (fields are private) */
+typedef struct {
+    FILE *f;
+    image_format_t format;
+    int width;
+    int height;
+    /* BMP */
+    uint32_t bmp_offset;
+    int bmp_bpp;
+    bool bmp_bottom_up;
+    /* PNG */
+    uint8_t png_color_type;
+    uint16_t png_palette[256];      // RGB565
+} image_decoder_t;
+
+/**
+ * @brief Name of a format ("BMP", "QOI", "PNG")
+ */
+const char *image_format_name(image_format_t format);
+
+/**
+ * @brief File extension of a format, with the dot (".bmp", ...)
+ */
+const char *image_format_ext(image_format_t format);
+
+/**
+ * @brief Format from a file name's extension
+ *
+ * @return true if the extension is one of the three
+ */
+bool image_format_from_path(const char *path, image_format_t *format);
+
+/**
+ * @brief Set up an encoder
+ *
+ * @param format File format
+ * @param level PNG compression level, 0 (stored) .. IMAGE_DEFLATE_MAX_LEVEL; ignored otherwise
+ * @param get_row Source of RGB565 rows
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM
+ */
+esp_err_t image_encoder_init(image_encoder_t *enc, image_format_t format, int level,
+                             int width, int height, image_row_fn get_row, void *user);
+
+/**
+ * @brief Free the encoder's buffers
+ */
+void image_encoder_deinit(image_encoder_t *enc);
+
+/**
+ * @brief Smallest buffer image_encoder_fill() can always make progress with
+ */
+size_t image_encoder_min_buffer(const image_encoder_t *enc);
+
+/**
+ * @brief Write the next part of the file (storage_writer fill semantics)
+ *
+ * Writes as many whole rows as fit in the buffer.
+ *
+ * @param len Bytes written, 0 once the file is complete
+ * @return ESP_OK, ESP_ERR_INVALID_SIZE if size < image_encoder_min_buffer()
+ */
+esp_err_t image_encoder_fill(image_encoder_t *enc, uint8_t *buf, size_t size, size_t *len);
+
+/**
+ * @brief Bytes written so far (the file size once complete)
+ */
+uint64_t image_encoder_bytes(const image_encoder_t *enc);
+
+/**
+ * @brief Open an image file and read its header
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND, ESP_ERR_INVALID_ARG (unknown or damaged
+ *         file), ESP_ERR_NOT_SUPPORTED (a variant the decoder does not read)
+ */
+esp_err_t image_decoder_open(image_decoder_t *dec, const char *path);
+
+/**
+ * @brief Decode the whole image
+ *
+ * @param pixels width * height RGB565 pixels, top row first
+ * @return ESP_OK, ESP_ERR_NO_MEM, ESP_ERR_INVALID_ARG if the data is damaged
+ *         (rows decoded so far are kept)
+ */
+esp_err_t image_decoder_read(image_decoder_t *dec, uint16_t *pixels);
+
+/**
+ * @brief Close the file
+ */
+void image_decoder_close(image_decoder_t *dec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IMAGE_CODEC_H */
@@ -0,0 +1,656 @@
+/**
+ * @file image_zlib.c
+ * @brief Small streaming zlib compressor and decompressor
+ */
+
+#include "image_zlib.h"
+#include <string.h>
+
+#define WINDOW_MASK     (IMAGE_DEFLATE_WINDOW - 1)
+#define HASH_SIZE       (1 << IMAGE_DEFLATE_HASH_BITS)
+#define NIL             0xFFFF
+#define MIN_MATCH       3
+#define MAX_MATCH       258
+#define STORED_MAX      65535
+
+/* Per level: hash-chain candidates, match length that ends the search */
+static const struct {
+    uint16_t max_chain;
+    uint16_t nice_len;
+} s_levels[IMAGE_DEFLATE_MAX_LEVEL + 1] = {
+    { 0, 0 }, { 4, 16 }, { 8, 32 }, { 16, 64 }, { 32, 128 }, { 64, 258 }, { 128, 258 },
+};
+
+/* Length and distance codes (RFC 1951 3.2.5) */
+static const uint16_t s_len_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const uint8_t s_len_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const uint16_t s_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const uint8_t s_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+/**
+ * @brief Adler-32 of data, continuing from adler
+ */
+uint32_t image_adler32(uint32_t adler, const uint8_t *data, size_t len)
+{
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+
+    while (len > 0) {
+        size_t n = len < 5552 ? len : 5552;    // Largest run before the sums can overflow
+        len -= n;
+        while (n-- > 0) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
+
+/* ----- Compressor ----- */
+
+/* Reverse the low n bits of code (Huffman codes go out MSB first) */
+static uint32_t reverse_bits(uint32_t code, int n)
+{
+    uint32_t r = 0;
+    while (n-- > 0) {
+        r = (r << 1) | (code & 1);
+        code >>= 1;
+    }
+    return r;
+}
+
+static uint8_t *put_bits(image_deflate_t *z, uint8_t *out, uint32_t value, int n)
+{
+    z->bits |= value << z->nbits;
+    z->nbits += n;
+    while (z->nbits >= 8) {
+        *out++ = (uint8_t)z->bits;
+        z->bits >>= 8;
+        z->nbits -= 8;
+    }
+    return out;
+}
+
+/* Literal/length symbol in the fixed Huffman code */
+static uint8_t *put_symbol(image_deflate_t *z, uint8_t *out, int sym)
+{
+    if (sym < 144) return put_bits(z, out, reverse_bits(0x30 + sym, 8), 8);
+    if (sym < 256) return put_bits(z, out, reverse_bits(0x190 + sym - 144, 9), 9);
+    if (sym < 280) return put_bits(z, out, reverse_bits(sym - 256, 7), 7);
+    return put_bits(z, out, reverse_bits(0xC0 + sym - 280, 8), 8);
+}
+
+static uint8_t *put_match(image_deflate_t *z, uint8_t *out, unsigned len, unsigned dist)
+{
+    /* Length 3..258 -> symbol 257..285 */
+    unsigned v = len - MIN_MATCH;
+    int code;
+    if (v < 8) {
+        code = (int)v;
+    } else if (len == MAX_MATCH) {
+        code = 28;
+    } else {
+        int n = 31 - __builtin_clz(v);
+        code = 4 * (n - 1) + (int)((v >> (n - 2)) & 3);
+    }
+    out = put_symbol(z, out, 257 + code);
+    if (s_len_extra[code] > 0) {
+        out = put_bits(z, out, len - s_len_base[code], s_len_extra[code]);
+    }
+
+    /* Distance 1..32768 -> code 0..29, five bits each in the fixed code */
+    unsigned d = dist - 1;
+    if (d < 4) {
+        code = (int)d;
+    } else {
+        int n = 31 - __builtin_clz(d);
+        code = 2 * n + (int)((d >> (n - 1)) & 1);
+    }
+    out = put_bits(z, out, reverse_bits(code, 5), 5);
+    if (s_dist_extra[code] > 0) {
+        out = put_bits(z, out, dist - s_dist_base[code], s_dist_extra[code]);
+    }
+    return out;
+}
+
+static uint32_t hash3(const uint8_t *p)
+{
+    uint32_t v = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+    return (v * 2654435761u) >> (32 - IMAGE_DEFLATE_HASH_BITS);
+}
+
+/* Chain every position below limit that has three bytes to hash */
+static void insert_upto(image_deflate_t *z, size_t limit)
+{
+    while (z->ins < limit && z->ins + MIN_MATCH <= z->len) {
+        uint32_t h = hash3(&z->win[z->ins]);
+        z->prev[z->ins & WINDOW_MASK] = z->head[h];
+        z->head[h] = (uint16_t)z->ins;
+        z->ins++;
+    }
+}
+
+/* Drop the older half of the window */
+static void slide(image_deflate_t *z)
+{
+    memmove(z->win, z->win + IMAGE_DEFLATE_WINDOW, z->len - IMAGE_DEFLATE_WINDOW);
+    z->len -= IMAGE_DEFLATE_WINDOW;
+    z->ins = (z->ins > IMAGE_DEFLATE_WINDOW) ? z->ins - IMAGE_DEFLATE_WINDOW : 0;
+
+    for (int i = 0; i < HASH_SIZE; i++) {
+        uint16_t v = z->head[i];
+        z->head[i] = (v != NIL && v >= IMAGE_DEFLATE_WINDOW) ? v - IMAGE_DEFLATE_WINDOW : NIL;
+    }
+    for (int i = 0; i < IMAGE_DEFLATE_WINDOW; i++) {
+        uint16_t v = z->prev[i];
+        z->prev[i] = (v != NIL && v >= IMAGE_DEFLATE_WINDOW) ? v - IMAGE_DEFLATE_WINDOW : NIL;
+    }
+}
+
+/* Longest earlier match for position p (greedy, bounded by the level) */
+static unsigned longest_match(const image_deflate_t *z, size_t p, unsigned *dist)
+{
+    size_t avail = z->len - p;
+    if (avail < MIN_MATCH) return 0;
+
+    unsigned max_len = avail < MAX_MATCH ? (unsigned)avail : MAX_MATCH;
+    unsigned best = MIN_MATCH - 1;
+    const uint8_t *cur = &z->win[p];
+    uint16_t cand = z->head[hash3(cur)];
+    int chain = z->max_chain;
+
+    while (cand != NIL && cand < p && chain-- > 0) {
+        if (p - cand > IMAGE_DEFLATE_WINDOW) break;
+
+        const uint8_t *m = &z->win[cand];
+        if (m[best] == cur[best] && m[0] == cur[0] && m[1] == cur[1]) {
+            unsigned n = 2;
+            while (n < max_len && m[n] == cur[n]) n++;
+            if (n > best) {
+                best = n;
+                *dist = (unsigned)(p - cand);
+                if (n >= z->nice_len || n == max_len) break;
+            }
+        }
+
+        uint16_t next = z->prev[cand & WINDOW_MASK];
+        if (next >= cand) break;    // Slot reused by a newer position: chain ends
+        cand = next;
+    }
+    return best >= MIN_MATCH ? best : 0;
+}
+
+/* Encode win[p..len) */
+static uint8_t *compress(image_deflate_t *z, size_t p, uint8_t *out)
+{
+    while (p < z->len) {
+        insert_upto(z, p);
+
+        unsigned dist = 0;
+        unsigned len = longest_match(z, p, &dist);
+        if (len > 0) {
+            out = put_match(z, out, len, dist);
+            p += len;
+        } else {
+            out = put_symbol(z, out, z->win[p]);
+            p++;
+        }
+    }
+    return out;
+}
+
+static uint8_t *put_header(image_deflate_t *z, uint8_t *out)
+{
+    /* CMF: deflate, 32K window; FLG: level hint, check bits */
+    *out++ = 0x78;
+    *out++ = (z->level <= 1) ? 0x01 : (z->level < 6) ? 0x5E : 0x9C;
+    z->header_done = true;
+
+    if (z->level > 0) {
+        out = put_bits(z, out, 0, 1);       // BFINAL = 0
+        out = put_bits(z, out, 1, 2);       // BTYPE = fixed Huffman
+    }
+    return out;
+}
+
+/**
+ * @brief Start a compressed stream
+ */
+void image_deflate_init(image_deflate_t *z, int level)
+{
+    if (level < 0) level = 0;
+    if (level > IMAGE_DEFLATE_MAX_LEVEL) level = IMAGE_DEFLATE_MAX_LEVEL;
+
+    z->level = level;
+    z->max_chain = s_levels[level].max_chain;
+    z->nice_len = s_levels[level].nice_len;
+    z->header_done = false;
+    z->adler = 1;
+    z->bits = 0;
+    z->nbits = 0;
+    z->len = 0;
+    z->ins = 0;
+    memset(z->head, 0xFF, sizeof(z->head));
+    memset(z->prev, 0xFF, sizeof(z->prev));
+}
+
+/**
+ * @brief Largest output of one write of len bytes
+ */
+size_t image_deflate_bound(const image_deflate_t *z, size_t len)
+{
+    size_t header = z->header_done ? 0 : 3;
+    if (z->level == 0) {
+        return header + len + 5 * ((len + STORED_MAX - 1) / STORED_MAX);
+    }
+    return header + len + len / 8 + 2;     // At most 9 bits per input byte
+}
+
+/**
+ * @brief Compress bytes
+ */
+size_t image_deflate_write(image_deflate_t *z, const uint8_t *data, size_t len, uint8_t *out)
+{
+    uint8_t *start = out;
+    if (len == 0) return 0;
+    if (!z->header_done) {
+        out = put_header(z, out);
+    }
+    z->adler = image_adler32(z->adler, data, len);
+
+    if (z->level == 0) {
+        while (len > 0) {
+            size_t n = len < STORED_MAX ? len : STORED_MAX;
+            *out++ = 0x00;                  // BFINAL = 0, BTYPE = stored
+            *out++ = (uint8_t)n;
+            *out++ = (uint8_t)(n >> 8);
+            *out++ = (uint8_t)~n;
+            *out++ = (uint8_t)(~n >> 8);
+            memcpy(out, data, n);
+            out += n;
+            data += n;
+            len -= n;
+        }
+        return (size_t)(out - start);
+    }
+
+    while (len > 0) {
+        if (z->len == sizeof(z->win)) {
+            slide(z);
+        }
+        size_t n = sizeof(z->win) - z->len;
+        if (n > len) n = len;
+        memcpy(&z->win[z->len], data, n);
+        size_t p = z->len;
+        z->len += n;
+        out = compress(z, p, out);
+        data += n;
+        len -= n;
+    }
+    return (size_t)(out - start);
+}
+
+/**
+ * @brief End the stream
+ */
+size_t image_deflate_finish(image_deflate_t *z, uint8_t *out)
+{
+    uint8_t *start = out;
+    bool open_block = z->header_done && z->level > 0;
+    if (!z->header_done) {
+        *out++ = 0x78;
+        *out++ = 0x01;
+        z->header_done = true;
+    }
+
+    if (open_block) {
+        out = put_symbol(z, out, 256);      // End of the open block
+        out = put_bits(z, out, 1, 1);       // Empty final fixed block
+        out = put_bits(z, out, 1, 2);
+        out = put_symbol(z, out, 256);
+        if (z->nbits > 0) {
+            out = put_bits(z, out, 0, 8 - z->nbits);
+        }
+    } else {
+        *out++ = 0x01;                      // Empty final stored block
+        *out++ = 0x00;
+        *out++ = 0x00;
+        *out++ = 0xFF;
+        *out++ = 0xFF;
+    }
+
+    *out++ = (uint8_t)(z->adler >> 24);
+    *out++ = (uint8_t)(z->adler >> 16);
+    *out++ = (uint8_t)(z->adler >> 8);
+    *out++ = (uint8_t)z->adler;
+    return (size_t)(out - start);
+}
+
+/* ----- Decompressor ----- */
+
+/* Read more input once in..in_end is used up; false at the end of the input */
+static bool refill(image_inflate_t *z)
+{
+    if (z->in != z->in_end) return true;
+
+    size_t got = z->read(z->user, z->input, sizeof(z->input));
+    if (got == 0) {
+        z->truncated = true;
+        return false;
+    }
+    z->in = z->input;
+    z->in_end = z->input + got;
+    return true;
+}
+
+/* Make n (<= 24) bits available; false once the input has run out */
+static bool need_bits(image_inflate_t *z, int n)
+{
+    while (z->nbits < n) {
+        if (!refill(z)) return false;
+        z->bits |= (uint32_t)*z->in++ << z->nbits;
+        z->nbits += 8;
+    }
+    return true;
+}
+
+static uint32_t get_bits(image_inflate_t *z, int n)
+{
+    if (n == 0 || !need_bits(z, n)) return 0;
+    uint32_t v = z->bits & ((1u << n) - 1);
+    z->bits >>= n;
+    z->nbits -= n;
+    return v;
+}
+
+/* Hand win[flushed..pos) to the writer */
+static void flush_window(image_inflate_t *z)
+{
+    if (z->pos > z->flushed && !z->stopped) {
+        z->adler = image_adler32(z->adler, &z->win[z->flushed], z->pos - z->flushed);
+        if (!z->write(z->user, &z->win[z->flushed], z->pos - z->flushed)) {
+            z->stopped = true;
+        }
+    }
+    z->flushed = z->pos;
+}
+
+static void put_byte(image_inflate_t *z, uint8_t b)
+{
+    z->win[z->pos++] = b;
+    z->total++;
+    if (z->pos == IMAGE_INFLATE_WINDOW) {
+        flush_window(z);
+        z->pos = 0;
+        z->flushed = 0;
+    }
+}
+
+/**
+ * @brief Build a canonical Huffman table from code lengths
+ *
+ * @return false if the lengths over-subscribe the code
+ */
+static bool build_table(uint16_t *count, uint16_t *symbol, const uint8_t *lengths, int n)
+{
+    uint16_t offs[16];
+
+    memset(count, 0, 16 * sizeof(uint16_t));
+    for (int i = 0; i < n; i++) {
+        count[lengths[i]]++;
+    }
+
+    int left = 1;
+    for (int len = 1; len < 16; len++) {
+        left = (left << 1) - count[len];
+        if (left < 0) return false;
+    }
+
+    offs[1] = 0;
+    for (int len = 1; len < 15; len++) {
+        offs[len + 1] = offs[len] + count[len];
+    }
+    for (int i = 0; i < n; i++) {
+        if (lengths[i] != 0) {
+            symbol[offs[lengths[i]]++] = (uint16_t)i;
+        }
+    }
+    count[0] = 0;
+    return true;
+}
+
+/* Decode one symbol, -1 for an invalid code */
+static int decode_symbol(image_inflate_t *z, const uint16_t *count, const uint16_t *symbol)
+{
+    int code = 0;
+    int first = 0;
+    int index = 0;
+
+    for (int len = 1; len < 16; len++) {
+        if (z->nbits == 0 && !need_bits(z, 1)) return -1;
+        code |= (int)(z->bits & 1);
+        z->bits >>= 1;
+        z->nbits--;
+
+        int n = count[len];
+        if (code - n < first) {
+            return symbol[index + (code - first)];
+        }
+        index += n;
+        first = (first + n) << 1;
+        code <<= 1;
+    }
+    return -1;
+}
+
+/* Literal/length and distance codes of one compressed block */
+static image_inflate_result_t inflate_codes(image_inflate_t *z)
+{
+    while (!z->stopped) {
+        int sym = decode_symbol(z, z->lit_count, z->lit_symbol);
+        if (sym < 0) break;
+        if (sym < 256) {
+            put_byte(z, (uint8_t)sym);
+            continue;
+        }
+        if (sym == 256) {
+            return IMAGE_INFLATE_OK;
+        }
+
+        sym -= 257;
+        if (sym >= 29) return IMAGE_INFLATE_ERR_DATA;
+        unsigned len = s_len_base[sym] + get_bits(z, s_len_extra[sym]);
+
+        int dsym = decode_symbol(z, z->dist_count, z->dist_symbol);
+        if (dsym < 0) break;
+        if (dsym >= 30) return IMAGE_INFLATE_ERR_DATA;
+        size_t dist = s_dist_base[dsym] + get_bits(z, s_dist_extra[dsym]);
+        if (dist > z->total || z->truncated) break;
+
+        size_t from = (z->pos - dist) & (IMAGE_INFLATE_WINDOW - 1);
+        if (z->pos + len < IMAGE_INFLATE_WINDOW && from + len < IMAGE_INFLATE_WINDOW) {
+            /* Neither end wraps: copy forward (overlap repeats the pattern, as it must) */
+            uint8_t *dst = &z->win[z->pos];
+            const uint8_t *src = &z->win[from];
+            for (unsigned i = 0; i < len; i++) {
+                dst[i] = src[i];
+            }
+            z->pos += len;
+            z->total += len;
+            continue;
+        }
+        while (len-- > 0) {
+            put_byte(z, z->win[from]);
+            from = (from + 1) & (IMAGE_INFLATE_WINDOW - 1);
+        }
+    }
+    if (z->stopped) return IMAGE_INFLATE_STOPPED;
+    return z->truncated ? IMAGE_INFLATE_ERR_TRUNCATED : IMAGE_INFLATE_ERR_DATA;
+}
+
+static image_inflate_result_t inflate_stored(image_inflate_t *z)
+{
+    /* Skip to the byte boundary */
+    get_bits(z, z->nbits & 7);
+    uint32_t len = get_bits(z, 16);
+    uint32_t nlen = get_bits(z, 16);
+    if (z->truncated) return IMAGE_INFLATE_ERR_TRUNCATED;
+    if (len != (~nlen & 0xFFFF)) return IMAGE_INFLATE_ERR_DATA;
+
+    /* Whole bytes left in the bit buffer, then straight from the input */
+    while (len > 0 && z->nbits >= 8) {
+        put_byte(z, (uint8_t)get_bits(z, 8));
+        len--;
+    }
+    while (len > 0) {
+        if (!refill(z)) return IMAGE_INFLATE_ERR_TRUNCATED;
+        size_t n = (size_t)(z->in_end - z->in);
+        if (n > len) n = len;
+        if (n > IMAGE_INFLATE_WINDOW - z->pos) n = IMAGE_INFLATE_WINDOW - z->pos;
+
+        memcpy(&z->win[z->pos], z->in, n);
+        z->in += n;
+        z->pos += n;
+        z->total += n;
+        len -= n;
+        if (z->pos == IMAGE_INFLATE_WINDOW) {
+            flush_window(z);
+            z->pos = 0;
+            z->flushed = 0;
+        }
+        if (z->stopped) return IMAGE_INFLATE_STOPPED;
+    }
+    return IMAGE_INFLATE_OK;
+}
+
+static image_inflate_result_t inflate_fixed(image_inflate_t *z)
+{
+    uint8_t lengths[288 + 30];
+    int i = 0;
+    for (; i < 144; i++) lengths[i] = 8;
+    for (; i < 256; i++) lengths[i] = 9;
+    for (; i < 280; i++) lengths[i] = 7;
+    for (; i < 288; i++) lengths[i] = 8;
+    for (; i < 288 + 30; i++) lengths[i] = 5;
+
+    build_table(z->lit_count, z->lit_symbol, lengths, 288);
+    build_table(z->dist_count, z->dist_symbol, lengths + 288, 30);
+    return inflate_codes(z);
+}
+
+static image_inflate_result_t inflate_dynamic(image_inflate_t *z)
+{
+    static const uint8_t order[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+    uint8_t lengths[288 + 32];
+
+    int nlen = (int)get_bits(z, 5) + 257;
+    int ndist = (int)get_bits(z, 5) + 1;
+    int ncode = (int)get_bits(z, 4) + 4;
+    if (z->truncated) return IMAGE_INFLATE_ERR_TRUNCATED;
+    if (nlen > 286 || ndist > 30) return IMAGE_INFLATE_ERR_DATA;
+
+    /* Code-length code, built in the literal table for now */
+    memset(lengths, 0, 19);
+    for (int i = 0; i < ncode; i++) {
+        lengths[order[i]] = (uint8_t)get_bits(z, 3);
+    }
+    if (!build_table(z->lit_count, z->lit_symbol, lengths, 19)) return IMAGE_INFLATE_ERR_DATA;
+
+    int i = 0;
+    while (i < nlen + ndist) {
+        int sym = decode_symbol(z, z->lit_count, z->lit_symbol);
+        if (sym < 0) return z->truncated ? IMAGE_INFLATE_ERR_TRUNCATED : IMAGE_INFLATE_ERR_DATA;
+        if (sym < 16) {
+            lengths[i++] = (uint8_t)sym;
+            continue;
+        }
+
+        uint8_t value = 0;
+        int repeat;
+        if (sym == 16) {
+            if (i == 0) return IMAGE_INFLATE_ERR_DATA;
+            value = lengths[i - 1];
+            repeat = 3 + (int)get_bits(z, 2);
+        } else if (sym == 17) {
+            repeat = 3 + (int)get_bits(z, 3);
+        } else {
+            repeat = 11 + (int)get_bits(z, 7);
+        }
+        if (i + repeat > nlen + ndist) return IMAGE_INFLATE_ERR_DATA;
+        while (repeat-- > 0) {
+            lengths[i++] = value;
+        }
+    }
+    if (lengths[256] == 0) return IMAGE_INFLATE_ERR_DATA;
+
+    if (!build_table(z->lit_count, z->lit_symbol, lengths, nlen) ||
+        !build_table(z->dist_count, z->dist_symbol, lengths + nlen, ndist)) {
+        return IMAGE_INFLATE_ERR_DATA;
+    }
+    return inflate_codes(z);
+}
+
+/**
+ * @brief Decompress a whole zlib stream
+ */
+image_inflate_result_t image_inflate(image_inflate_t *z, image_inflate_read_fn read,
+                                     image_inflate_write_fn write, void *user)
+{
+    z->read = read;
+    z->write = write;
+    z->user = user;
+    z->in = z->in_end = z->input;
+    z->bits = 0;
+    z->nbits = 0;
+    z->truncated = false;
+    z->adler = 1;
+    z->pos = 0;
+    z->flushed = 0;
+    z->total = 0;
+    z->stopped = false;
+
+    uint32_t cmf = get_bits(z, 8);
+    uint32_t flg = get_bits(z, 8);
+    if (z->truncated) return IMAGE_INFLATE_ERR_TRUNCATED;
+    if ((cmf & 0x0F) != 8 || (cmf >> 4) > 7 || ((cmf << 8) | flg) % 31 != 0 || (flg & 0x20)) {
+        return IMAGE_INFLATE_ERR_HEADER;
+    }
+
+    image_inflate_result_t ret;
+    bool last;
+    do {
+        last = get_bits(z, 1) != 0;
+        switch (get_bits(z, 2)) {
+        case 0:  ret = inflate_stored(z); break;
+        case 1:  ret = inflate_fixed(z); break;
+        case 2:  ret = inflate_dynamic(z); break;
+        default: ret = IMAGE_INFLATE_ERR_DATA; break;
+        }
+        if (ret == IMAGE_INFLATE_OK && z->truncated) ret = IMAGE_INFLATE_ERR_TRUNCATED;
+        if (ret == IMAGE_INFLATE_OK && z->stopped) ret = IMAGE_INFLATE_STOPPED;
+    } while (ret == IMAGE_INFLATE_OK && !last);
+
+    flush_window(z);
+    if (ret != IMAGE_INFLATE_OK) return ret;
+    if (z->stopped) return IMAGE_INFLATE_STOPPED;
+
+    get_bits(z, z->nbits & 7);
+    uint32_t adler = get_bits(z, 8) << 24;
+    adler |= get_bits(z, 8) << 16;
+    adler |= get_bits(z, 8) << 8;
+    adler |= get_bits(z, 8);
+    if (z->truncated) return IMAGE_INFLATE_ERR_TRUNCATED;
+    return adler == z->adler ? IMAGE_INFLATE_OK : IMAGE_INFLATE_ERR_CHECKSUM;
+}
@@ -0,0 +1,151 @@
+/**
+ * @file image_zlib.h
+ * @brief Small streaming zlib (RFC 1950/1951) compressor and decompressor
+ *
+ * Just enough deflate for PNG files written and read on the device.
+ *
+ * The compressor takes its input in pieces (one PNG scanline at a time) and
+ * writes the compressed bytes straight into the caller's buffer, so memory
+ * stays at the fixed state below whatever the image size. Level 0 writes
+ * stored blocks; levels 1..6 use LZ77 over an IMAGE_DEFLATE_WINDOW history
+ * with one fixed-Huffman block, the level setting how many hash-chain
+ * candidates are tried for each match. Matches do not reach past the end of
+ * the piece given, so a piece should be at least a scanline.
+ *
+ * The decompressor reads every block type (stored, fixed, dynamic) from a
+ * read callback and hands the output to a write callback in window-sized
+ * pieces.
+ *
+ * Pure C with no RTOS calls and no allocation: the caller supplies the state
+ * (a few tens of KB, so not on a task stack).
+ */
+
+#ifndef IMAGE_ZLIB_H
+#define IMAGE_ZLIB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define IMAGE_DEFLATE_WINDOW        16384   // History searched for matches (power of two, <= 16384)
+#define IMAGE_DEFLATE_HASH_BITS     13
+#define IMAGE_DEFLATE_MAX_LEVEL     6
+
+#define IMAGE_INFLATE_WINDOW        32768   // Largest distance deflate allows
+#define IMAGE_INFLATE_INPUT         4096
+
+/* Worst-case output of image_deflate_finish() */
+#define IMAGE_DEFLATE_FINISH_BOUND  16
+
+/* Compressor state (fields are private) */
+typedef struct {
+    int level;
+    uint16_t max_chain;             // Hash-chain candidates per match
+    uint16_t nice_len;              // Stop searching at a match this long
+    bool header_done;
+    uint32_t adler;
+    uint32_t bits;                  // Pending output bits, LSB first
+    int nbits;
+    size_t len;                     // Bytes in win
+    size_t ins;                     // Positions below this are in the hash chains
+    uint8_t win[2 * IMAGE_DEFLATE_WINDOW];
+    uint16_t head[1 << IMAGE_DEFLATE_HASH_BITS];
+    uint16_t prev[IMAGE_DEFLATE_WINDOW];
+} image_deflate_t;
+
+/**
+ * @brief Read up to size bytes of compressed input
+ *
+ * @return Bytes read, 0 at the end of the input
+ */
+typedef size_t (*image_inflate_read_fn)(void *user, uint8_t *buf, size_t size);
+
+/**
+ * @brief Take decompressed bytes
+ *
+ * @return false to stop decompressing
+ */
+typedef bool (*image_inflate_write_fn)(void *user, const uint8_t *data, size_t len);
+
+/* Decompression result */
+typedef enum {
+    IMAGE_INFLATE_OK = 0,
+    IMAGE_INFLATE_ERR_HEADER,       // Not a zlib stream deflate can read
+    IMAGE_INFLATE_ERR_DATA,         // Invalid block, code or distance
+    IMAGE_INFLATE_ERR_TRUNCATED,    // Input ended inside the stream
+    IMAGE_INFLATE_ERR_CHECKSUM,     // Adler-32 mismatch
+    IMAGE_INFLATE_STOPPED,          // The write callback returned false
+} image_inflate_result_t;
+
+/* Decompressor state (fields are private) */
+typedef struct {
+    image_inflate_read_fn read;
+    image_inflate_write_fn write;
+    void *user;
+    const uint8_t *in;              // Next input byte
+    const uint8_t *in_end;
+    uint32_t bits;
+    int nbits;
+    bool truncated;
+    uint32_t adler;
+    size_t pos;                     // Next byte of win to write
+    size_t flushed;                 // win[flushed..pos) not yet handed to write
+    size_t total;                   // Bytes decompressed (bounds match distances)
+    bool stopped;
+    uint8_t win[IMAGE_INFLATE_WINDOW];
+    uint8_t input[IMAGE_INFLATE_INPUT];
+    /* Huffman tables: code counts per length and symbols in code order */
+    uint16_t lit_count[16];
+    uint16_t lit_symbol[288];
+    uint16_t dist_count[16];
+    uint16_t dist_symbol[32];
+} image_inflate_t;
+
+/**
+ * @brief Start a compressed stream
+ *
+ * @param level 0 (stored) .. IMAGE_DEFLATE_MAX_LEVEL, clamped
+ */
+void image_deflate_init(image_deflate_t *z, int level);
+
+/**
+ * @brief Largest output of one image_deflate_write() of len bytes
+ */
+size_t image_deflate_bound(const image_deflate_t *z, size_t len);
+
+/**
+ * @brief Compress bytes
+ *
+ * @param out Output, at least image_deflate_bound(z, len) bytes
+ * @return Bytes written to out
+ */
+size_t image_deflate_write(image_deflate_t *z, const uint8_t *data, size_t len, uint8_t *out);
+
+/**
+ * @brief End the stream (final block and Adler-32)
+ *
+ * @param out Output, at least IMAGE_DEFLATE_FINISH_BOUND bytes
+ * @return Bytes written to out
+ */
+size_t image_deflate_finish(image_deflate_t *z, uint8_t *out);
+
+/**
+ * @brief Decompress a whole zlib stream, through the final block and checksum
+ */
+image_inflate_result_t image_inflate(image_inflate_t *z, image_inflate_read_fn read,
+                                     image_inflate_write_fn write, void *user);
+
+/**
+ * @brief Adler-32 of data, continuing from adler (start with 1)
+ */
+uint32_t image_adler32(uint32_t adler, const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IMAGE_ZLIB_H */
@@ -19,6 +19,7 @@
 #include "driver/jpeg_decode.h"
 #include "driver/i2s_std.h"
 #include "avi_player.h"
+#include "image_codec.h"
 #include <string.h>
 #include <stdio.h>
 #include <sys/stat.h>
@@ -59,7 +60,7 @@ static size_t s_decode_buffer_size = 0;
 static lv_obj_t *s_player_screen = NULL;
 static lv_obj_t *s_touch_layer = NULL;
 
-/* BMP Image Display */
+/* Image Display */
 static lv_color_t *s_image_buffer = NULL;
 static lv_img_dsc_t s_img_dsc = {0};
 static lv_obj_t *s_image_obj = NULL;
@@ -69,7 +70,7 @@ static lv_obj_t *s_info_label = NULL;
 /* Forward Declarations */
 static void notify_state(media_player_state_t state);
 static esp_err_t play_video(const char *filepath);
-static esp_err_t show_bmp_image(const char *filepath);
+static esp_err_t show_image(const char *filepath);
 static void cleanup_playback(void);
 
 /* JPEG Decoder */
@@ -254,7 +255,7 @@ static esp_err_t play_video(const char *filepath)
     return ESP_OK;
 }
 
-/* BMP Image Display */
+/* Image Display */
 static void create_image_ui(void)
 {
     if (!bsp_display_lock(100)) return;
@@ -284,60 +285,35 @@ static void create_image_ui(void)
     bsp_display_unlock();
 }
 
-static esp_err_t show_bmp_image(const char *filepath)
+static esp_err_t show_image(const char *filepath)
 {
-    FILE *f = fopen(filepath, "rb");
-    if (!f) return ESP_ERR_NOT_FOUND;
-    
-    uint8_t header[54];
-    if (fread(header, 1, 54, f) != 54 || header[0] != 'B' || header[1] != 'M') {
-        fclose(f);
-        return ESP_ERR_INVALID_ARG;
-    }
-    
-    uint32_t data_offset = header[10] | (header[11] << 8) | (header[12] << 16) | (header[13] << 24);
-    int32_t w = (int32_t)(header[18] | (header[19] << 8) | (header[20] << 16) | (header[21] << 24));
-    int32_t h = (int32_t)(header[22] | (header[23] << 8) | (header[24] << 16) | (header[25] << 24));
-    uint16_t bpp = header[28] | (header[29] << 8);
-    
-    bool bottom_up = (h > 0);
-    if (h < 0) h = -h;
-    
-    if (w <= 0 || w > 4096 || h <= 0 || h > 4096 || bpp != 24) {
-        fclose(f);
-        return ESP_ERR_NOT_SUPPORTED;
-    }
+    image_decoder_t dec;
+    esp_err_t ret = image_decoder_open(&dec, filepath);
+    if (ret != ESP_OK) return ret;
     
+    int32_t w = dec.width;
+    int32_t h = dec.height;
     s_media_info.width = w;
     s_media_info.height = h;
     
+    /* LV_COLOR_DEPTH 16 without byte swap: lv_color_t is plain RGB565 */
     size_t buf_size = w * h * sizeof(lv_color_t);
     s_image_buffer = heap_caps_malloc(buf_size, MALLOC_CAP_SPIRAM);
     if (!s_image_buffer) {
-        fclose(f);
+        image_decoder_close(&dec);
         return ESP_ERR_NO_MEM;
     }
     
-    fseek(f, data_offset, SEEK_SET);
-    
-    int row_size = ((w * 3 + 3) / 4) * 4;
-    uint8_t *row = malloc(row_size);
-    if (!row) {
+    int64_t start_us = esp_timer_get_time();
+    ret = image_decoder_read(&dec, (uint16_t *)s_image_buffer);
+    image_decoder_close(&dec);
+    if (ret != ESP_OK) {
         heap_caps_free(s_image_buffer);
         s_image_buffer = NULL;
-        fclose(f);
-        return ESP_ERR_NO_MEM;
-    }
-    
-    for (int y = 0; y < h; y++) {
-        int dest_y = bottom_up ? (h - 1 - y) : y;
-        if (fread(row, 1, row_size, f) != (size_t)row_size) break;
-        for (int x = 0; x < w; x++) {
-            s_image_buffer[dest_y * w + x] = lv_color_make(row[x*3+2], row[x*3+1], row[x*3]);
-        }
+        return ret;
     }
-    free(row);
-    fclose(f);
+    ESP_LOGI(TAG, "%s %ldx%ld decoded in %lld ms", image_format_name(dec.format), (long)w, (long)h,
+             (esp_timer_get_time() - start_us) / 1000);
     
     create_image_ui();
     
@@ -360,7 +336,7 @@ static esp_err_t show_bmp_image(const char *filepath)
         
         if (s_info_label) {
             char info[64];
-            snprintf(info, sizeof(info), "%ldx%ld BMP", (long)w, (long)h);
+            snprintf(info, sizeof(info), "%ldx%ld %s", (long)w, (long)h, image_format_name(dec.format));
             lv_label_set_text(s_info_label, info);
         }
         
@@ -389,7 +365,7 @@ static void cleanup_playback(void)
             s_disp_drv = NULL;
         }
         
-        /* Delete player screen UI (for BMP images) */
+        /* Delete player screen UI (for images) */
         if (s_player_screen && lv_obj_is_valid(s_player_screen)) {
             lv_obj_del(s_player_screen);
             s_player_screen = NULL;
@@ -487,7 +463,9 @@ esp_err_t media_player_play(const char *filepath)
     esp_err_t ret = ESP_FAIL;
     switch (type) {
         case MEDIA_TYPE_BMP:
-            ret = show_bmp_image(filepath);
+        case MEDIA_TYPE_PNG:
+        case MEDIA_TYPE_QOI:
+            ret = show_image(filepath);
             break;
         case MEDIA_TYPE_AVI:
             ret = play_video(filepath);
@@ -547,6 +525,8 @@ media_type_t media_player_get_type(const char *filepath)
     ext++;
     
     if (strcasecmp(ext, "bmp") == 0) return MEDIA_TYPE_BMP;
+    if (strcasecmp(ext, "png") == 0) return MEDIA_TYPE_PNG;
+    if (strcasecmp(ext, "qoi") == 0) return MEDIA_TYPE_QOI;
     if (strcasecmp(ext, "avi") == 0) return MEDIA_TYPE_AVI;
     
     return MEDIA_TYPE_UNKNOWN;
@@ -555,13 +535,15 @@ media_type_t media_player_get_type(const char *filepath)
 bool media_player_is_supported(const char *filepath)
 {
     media_type_t t = media_player_get_type(filepath);
-    return t == MEDIA_TYPE_BMP || t == MEDIA_TYPE_AVI;
+    return t == MEDIA_TYPE_BMP || t == MEDIA_TYPE_PNG || t == MEDIA_TYPE_QOI || t == MEDIA_TYPE_AVI;
 }
 
 const char* media_player_get_type_name(media_type_t type)
 {
     switch (type) {
         case MEDIA_TYPE_BMP: return "BMP";
+        case MEDIA_TYPE_PNG: return "PNG";
+        case MEDIA_TYPE_QOI: return "QOI";
         case MEDIA_TYPE_AVI: return "AVI Video";
         default: return "Unknown";
     }
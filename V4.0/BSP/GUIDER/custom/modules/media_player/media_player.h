@@ -3,7 +3,7 @@
  * @brief Media Player Module - Image viewing and Video playback
  * 
  * Supports:
- * - PNG/BMP image viewing (fullscreen)
+ * - BMP/PNG/QOI image viewing (fullscreen)
  * - AVI video playback (MJPEG/H.264 + PCM audio) using ESP-IDF avi_player
  */
 
@@ -25,7 +25,8 @@ typedef enum {
     MEDIA_TYPE_PNG,
     MEDIA_TYPE_JPEG,
     MEDIA_TYPE_BMP,
-    MEDIA_TYPE_AVI
+    MEDIA_TYPE_AVI,
+    MEDIA_TYPE_QOI
 } media_type_t;
 
 typedef enum {
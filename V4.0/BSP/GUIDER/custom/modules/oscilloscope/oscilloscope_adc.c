@@ -38,10 +38,28 @@ struct osc_adc_ctx_t {
     osc_trigger_config_t trigger;
     bool trigger_armed;             // Waiting for trigger
     uint32_t trigger_position;      // Position where trigger occurred
+    osc_trigger_ctx_t *detector;    // Streaming detector (enabled trigger only)
+    uint32_t armed_samples;         // Samples stored since (re-)arming, saturates at storage_depth
+    bool trigger_pending;           // Triggered, storing post-trigger samples
+    uint32_t post_remaining;        // Post-trigger samples still to store
+    bool frame_ready;               // Triggered frame complete, held until read
+    
+    /* Filter stage (between acquisition and storage) */
+    osc_filter_ctx_t *filter;
+    float *filtered_buffer;         // Filtered voltages, same indexing as sample_buffer
+    bool filter_active;
+    
+    /* Deep-memory record being filled (raw codes, detached when full) */
+    osc_deepmem_t *deep_record;
+    
+    /* Raw block consumer (streaming recorder) */
+    osc_adc_block_hook_t block_hook;
+    void *block_hook_user;
     
     /* Synchronization */
     SemaphoreHandle_t mutex;
     TaskHandle_t sampling_task;
+    volatile uint32_t rate_generation;  // Bumped by an in-place sample rate change
     
     /* Status */
     bool running;
@@ -58,6 +76,172 @@ static const uint32_t sample_rate_table[] = {
     [OSC_SAMPLE_RATE_1KSPS]   = 1000,       // 1 kSa/s
 };
 
+/**
+ * @brief Start the buffer, trigger and filter history over (mutex held)
+ */
+static void reset_acquisition(osc_adc_ctx_t *ctx)
+{
+    ctx->buffer_write_idx = 0;
+    ctx->buffer_full = false;
+    ctx->new_data_available = false;
+    ctx->trigger_armed = true;
+    ctx->armed_samples = 0;
+    ctx->trigger_pending = false;
+    ctx->post_remaining = 0;
+    ctx->frame_ready = false;
+    
+    osc_filter_reset(ctx->filter);
+    osc_trigger_reset(ctx->detector);
+}
+
+/**
+ * @brief Post-trigger samples per frame
+ */
+static uint32_t post_trigger_samples(osc_adc_ctx_t *ctx)
+{
+    uint32_t pre = (uint32_t)(ctx->storage_depth * ctx->trigger.pre_trigger_ratio);
+    if (pre >= ctx->storage_depth) pre = ctx->storage_depth - 1;
+    return ctx->storage_depth - pre;
+}
+
+/**
+ * @brief Run the trigger detector over one block
+ *
+ * @return Number of samples of the block to store (fewer than len when the frame completes)
+ */
+static uint32_t scan_trigger_block(osc_adc_ctx_t *ctx, const float *volts, uint32_t len)
+{
+    uint32_t pos = 0;
+    uint32_t post = post_trigger_samples(ctx);
+    uint32_t pre = ctx->storage_depth - post;
+    
+    // Look for a trigger once enough pre-trigger history is stored
+    while (!ctx->trigger_pending && pos < len) {
+        int32_t hit = osc_trigger_process(ctx->detector, volts + pos, len - pos);
+        if (hit < 0) break;
+        pos += (uint32_t)hit;
+        if (ctx->armed_samples + pos >= pre) {
+            ctx->trigger_pending = true;
+            ctx->post_remaining = post;
+        } else {
+            pos++;
+        }
+    }
+    
+    if (!ctx->trigger_pending) return len;
+    
+    // Count post-trigger samples (the triggering sample included)
+    uint32_t available = len - pos;
+    if (available < ctx->post_remaining) {
+        ctx->post_remaining -= available;
+        return len;
+    }
+    
+    uint32_t keep = pos + ctx->post_remaining;
+    ctx->post_remaining = 0;
+    ctx->trigger_pending = false;
+    ctx->frame_ready = true;
+    return keep;
+}
+
+/**
+ * @brief Store one block of raw samples (filtered when a filter is active)
+ *
+ * A block sampled at a rate that has since been changed is dropped.
+ */
+static void store_block(osc_adc_ctx_t *ctx, const uint16_t *raw, float *volts, uint32_t len,
+                        uint32_t generation)
+{
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    if (generation != ctx->rate_generation) {
+        xSemaphoreGive(ctx->mutex);
+        return;
+    }
+    
+    // Deep record takes the raw stream regardless of trigger state
+    if (ctx->deep_record != NULL) {
+        osc_deepmem_append(ctx->deep_record, raw, len);
+        if (osc_deepmem_is_finished(ctx->deep_record)) {
+            ctx->deep_record = NULL;
+        }
+    }
+    
+    // Streaming consumers see every block too; the hook copies and returns
+    if (ctx->block_hook != NULL) {
+        ctx->block_hook(ctx->block_hook_user, raw, len, ctx->sample_rate_hz);
+    }
+    
+    // Hold a triggered frame until it has been read
+    if (ctx->trigger.enabled && ctx->frame_ready) {
+        xSemaphoreGive(ctx->mutex);
+        return;
+    }
+    
+    if (ctx->filter_active || ctx->trigger.enabled) {
+        for (uint32_t i = 0; i < len; i++) {
+            volts[i] = osc_adc_raw_to_voltage(raw[i]);
+        }
+        if (ctx->filter_active) {
+            osc_filter_process(ctx->filter, volts, volts, len);
+        }
+    }
+    
+    // Trigger on what is stored (filtered when a filter is active)
+    if (ctx->trigger.enabled && ctx->detector != NULL) {
+        len = scan_trigger_block(ctx, volts, len);
+        ctx->armed_samples += len;
+        if (ctx->armed_samples > ctx->storage_depth) ctx->armed_samples = ctx->storage_depth;
+    }
+    
+    for (uint32_t i = 0; i < len; i++) {
+        ctx->sample_buffer[ctx->buffer_write_idx] = raw[i];
+        if (ctx->filter_active) {
+            ctx->filtered_buffer[ctx->buffer_write_idx] = volts[i];
+        }
+        ctx->buffer_write_idx++;
+        
+        if (ctx->buffer_write_idx >= ctx->storage_depth) {
+            ctx->buffer_write_idx = 0;
+            
+            // Log when buffer first fills up
+            if (!ctx->buffer_full) {
+                ESP_LOGI(TAG, "✅ Circular buffer filled, continuous sampling active");
+            }
+            ctx->buffer_full = true;
+        }
+    }
+    
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Pace the sampling loop for a rate
+ *
+ * @param delay_ticks Output: delay between samples (0 = continuous)
+ * @param block_len Output: samples per stored block
+ */
+static void sampling_pace(uint32_t rate_hz, TickType_t *delay_ticks, uint32_t *block_len)
+{
+    // Calculate delay between samples based on sample rate
+    *delay_ticks = 0;
+    if (rate_hz < 10000) {
+        // Low sample rate: add delay
+        uint32_t delay_us = 1000000 / rate_hz;
+        *delay_ticks = pdMS_TO_TICKS(delay_us / 1000);
+        if (*delay_ticks == 0) *delay_ticks = 1;
+        ESP_LOGI(TAG, "ADC sampling with delay: %lu us for %lu Hz", delay_us, rate_hz);
+    } else {
+        // High sample rate: continuous sampling
+        ESP_LOGI(TAG, "ADC sampling: CONTINUOUS (no delay) for %lu Hz", rate_hz);
+    }
+    
+    // Block size: ~10ms of samples so slow rates still update promptly
+    *block_len = rate_hz / 100;
+    if (*block_len < 1) *block_len = 1;
+    if (*block_len > OSC_ADC_BLOCK_SIZE) *block_len = OSC_ADC_BLOCK_SIZE;
+}
+
 /**
  * @brief ADC sampling task (简化版：只负责持续采集)
  */
@@ -67,24 +251,32 @@ static void adc_sampling_task(void *arg)
     int adc_raw;
     uint32_t sample_count = 0;
     
-    // Calculate delay between samples based on sample rate
-    uint32_t delay_us = 0;
-    TickType_t delay_ticks = 0;
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    uint32_t generation = ctx->rate_generation;
+    uint32_t rate_hz = ctx->sample_rate_hz;
+    xSemaphoreGive(ctx->mutex);
     
-    if (ctx->sample_rate_hz < 10000) {
-        // Low sample rate: add delay
-        delay_us = 1000000 / ctx->sample_rate_hz;
-        delay_ticks = pdMS_TO_TICKS(delay_us / 1000);
-        if (delay_ticks == 0) delay_ticks = 1;
-        ESP_LOGI(TAG, "ADC sampling with delay: %lu us for %lu Hz", delay_us, ctx->sample_rate_hz);
-    } else {
-        // High sample rate: continuous sampling
-        ESP_LOGI(TAG, "ADC sampling: CONTINUOUS (no delay) for %lu Hz", ctx->sample_rate_hz);
-    }
+    TickType_t delay_ticks;
+    uint32_t block_len;
+    sampling_pace(rate_hz, &delay_ticks, &block_len);
+    
+    uint16_t raw_block[OSC_ADC_BLOCK_SIZE];
+    float volt_block[OSC_ADC_BLOCK_SIZE];
+    uint32_t block_fill = 0;
     
-    ESP_LOGI(TAG, "ADC sampling task started - direct circular buffer mode");
+    ESP_LOGI(TAG, "ADC sampling task started - block mode (%lu samples/block)", block_len);
     
     while (ctx->running) {
+        // Sample rate changed in place: re-pace and drop the partial block
+        if (ctx->rate_generation != generation) {
+            xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+            generation = ctx->rate_generation;
+            rate_hz = ctx->sample_rate_hz;
+            xSemaphoreGive(ctx->mutex);
+            sampling_pace(rate_hz, &delay_ticks, &block_len);
+            block_fill = 0;
+        }
+        
         // Read ADC value
         esp_err_t ret = adc_oneshot_read(ctx->adc_handle, OSC_ADC_CHANNEL, &adc_raw);
         if (ret == ESP_OK) {
@@ -95,23 +287,12 @@ static void adc_sampling_task(void *arg)
                 ESP_LOGI(TAG, "🔍 ADC Read #%lu: adc_raw=%d, adc_value=%u", sample_count, adc_raw, adc_value);
             }
             
-            xSemaphoreTake(ctx->mutex, portMAX_DELAY);
-            
-            // Store in circular buffer
-            ctx->sample_buffer[ctx->buffer_write_idx] = adc_value;
-            ctx->buffer_write_idx++;
-            
-            if (ctx->buffer_write_idx >= ctx->storage_depth) {
-                ctx->buffer_write_idx = 0;
-                ctx->buffer_full = true;
-                
-                // Log when buffer first fills up
-                if (sample_count < ctx->storage_depth + 10) {
-                    ESP_LOGI(TAG, "✅ Circular buffer filled, continuous sampling active");
-                }
+            // Collect a block, then filter and store it under one lock
+            raw_block[block_fill++] = adc_value;
+            if (block_fill >= block_len) {
+                store_block(ctx, raw_block, volt_block, block_fill, generation);
+                block_fill = 0;
             }
-            
-            xSemaphoreGive(ctx->mutex);
             sample_count++;
         }
         
@@ -126,6 +307,11 @@ static void adc_sampling_task(void *arg)
         }
     }
     
+    // Flush partial block
+    if (block_fill > 0) {
+        store_block(ctx, raw_block, volt_block, block_fill, generation);
+    }
+    
     ESP_LOGI(TAG, "ADC sampling task stopped");
     vTaskDelete(NULL);
 }
@@ -218,6 +404,18 @@ osc_adc_ctx_t *osc_adc_init(osc_sample_rate_t sample_rate, uint32_t storage_dept
         return NULL;
     }
     
+    // Trigger detector (only runs while the trigger is enabled)
+    ctx->detector = osc_trigger_init();
+    if (ctx->detector == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate trigger detector");
+        adc_oneshot_del_unit(ctx->adc_handle);
+        vSemaphoreDelete(ctx->mutex);
+        heap_caps_free(ctx->triggered_buffer);
+        heap_caps_free(ctx->sample_buffer);
+        free(ctx);
+        return NULL;
+    }
+    
     // Initialize trigger configuration (disabled by default for auto-trigger mode)
     ctx->trigger.enabled = false;  // Disabled = auto-trigger mode
     ctx->trigger.level_voltage = 0.0f;  // 0V (center of -50V to +50V range)
@@ -264,6 +462,13 @@ void osc_adc_deinit(osc_adc_ctx_t *ctx)
         heap_caps_free(ctx->sample_buffer);
     }
     
+    if (ctx->filtered_buffer) {
+        heap_caps_free(ctx->filtered_buffer);
+    }
+    
+    osc_filter_deinit(ctx->filter);
+    osc_trigger_deinit(ctx->detector);
+    
     free(ctx);
     ESP_LOGI(TAG, "ADC sampling deinitialized");
 }
@@ -282,11 +487,8 @@ esp_err_t osc_adc_start(osc_adc_ctx_t *ctx)
         return ESP_OK;
     }
     
-    // Reset buffers
-    ctx->buffer_write_idx = 0;
-    ctx->buffer_full = false;
-    ctx->new_data_available = false;
-    ctx->trigger_armed = true;
+    // Fresh acquisition: no samples, filter or trigger history from before the restart
+    reset_acquisition(ctx);
     ctx->running = true;
     
     xSemaphoreGive(ctx->mutex);
@@ -339,41 +541,147 @@ esp_err_t osc_adc_set_trigger(osc_adc_ctx_t *ctx, const osc_trigger_config_t *tr
     if (ctx == NULL || trigger == NULL) return ESP_ERR_INVALID_ARG;
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
-    memcpy(&ctx->trigger, trigger, sizeof(osc_trigger_config_t));
-    ctx->trigger_armed = true;
+    esp_err_t ret = osc_trigger_configure(ctx->detector, trigger, (float)ctx->sample_rate_hz);
+    if (ret == ESP_OK) {
+        memcpy(&ctx->trigger, trigger, sizeof(osc_trigger_config_t));
+        ctx->trigger_armed = true;
+        ctx->armed_samples = 0;
+        ctx->trigger_pending = false;
+        ctx->frame_ready = false;
+    }
+    xSemaphoreGive(ctx->mutex);
+    
+    return ret;
+}
+
+/**
+ * @brief Configure filter stage
+ */
+esp_err_t osc_adc_set_filter(osc_adc_ctx_t *ctx, const osc_filter_stage_config_t *stages, uint8_t num_stages)
+{
+    if (ctx == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    if (num_stages > 0) {
+        if (ctx->filter == NULL) {
+            ctx->filter = osc_filter_init();
+        }
+        if (ctx->filtered_buffer == NULL) {
+            ctx->filtered_buffer = heap_caps_malloc(ctx->storage_depth * sizeof(float), MALLOC_CAP_SPIRAM);
+        }
+        if (ctx->filter == NULL || ctx->filtered_buffer == NULL) {
+            xSemaphoreGive(ctx->mutex);
+            ESP_LOGE(TAG, "Failed to allocate filter stage");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    
+    esp_err_t ret = ESP_OK;
+    if (ctx->filter != NULL) {
+        ret = osc_filter_configure(ctx->filter, stages, num_stages, (float)ctx->sample_rate_hz);
+    }
+    
+    if (ret == ESP_OK) {
+        ctx->filter_active = (num_stages > 0);
+        
+        // Restart acquisition so the buffer, and any frame or trigger in
+        // progress, hold only data from the new chain
+        reset_acquisition(ctx);
+    }
+    
+    xSemaphoreGive(ctx->mutex);
+    
+    ESP_LOGI(TAG, "Filter stage: %u stage(s) (%s)", num_stages, esp_err_to_name(ret));
+    return ret;
+}
+
+/**
+ * @brief Stream raw samples into a deep-memory record
+ */
+esp_err_t osc_adc_set_deep_record(osc_adc_ctx_t *ctx, osc_deepmem_t *deep)
+{
+    if (ctx == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->deep_record = deep;
     xSemaphoreGive(ctx->mutex);
     
+    ESP_LOGI(TAG, "Deep record %s", deep ? "attached" : "detached");
     return ESP_OK;
 }
 
+/**
+ * @brief Hand every raw block to a consumer
+ */
+esp_err_t osc_adc_set_block_hook(osc_adc_ctx_t *ctx, osc_adc_block_hook_t hook, void *user)
+{
+    if (ctx == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->block_hook = hook;
+    ctx->block_hook_user = user;
+    xSemaphoreGive(ctx->mutex);
+    
+    ESP_LOGI(TAG, "Block hook %s", hook ? "attached" : "detached");
+    return ESP_OK;
+}
+
+/**
+ * @brief Check if a deep-memory record is still being filled
+ */
+bool osc_adc_is_deep_recording(osc_adc_ctx_t *ctx)
+{
+    if (ctx == NULL) return false;
+    return ctx->deep_record != NULL;
+}
+
 /**
  * @brief Set sampling rate
+ *
+ * In one-shot mode the rate is only the sampling task's pacing, so a running
+ * task is re-paced in place instead of being stopped and restarted; the
+ * buffer starts over so it never mixes rates.
  */
 esp_err_t osc_adc_set_sample_rate(osc_adc_ctx_t *ctx, osc_sample_rate_t sample_rate)
 {
     if (ctx == NULL) return ESP_ERR_INVALID_ARG;
-    
-    bool was_running = ctx->running;
-    if (was_running) {
-        osc_adc_stop(ctx);
-    }
+    if ((unsigned)sample_rate >= sizeof(sample_rate_table) / sizeof(sample_rate_table[0])) return ESP_ERR_INVALID_ARG;
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
     ctx->sample_rate = sample_rate;
     ctx->sample_rate_hz = sample_rate_table[sample_rate];
-    xSemaphoreGive(ctx->mutex);
     
-    // In one-shot mode, sample rate is controlled by task delay
-    // No need to reconfigure ADC hardware
-    
-    if (was_running) {
-        osc_adc_start(ctx);
+    // Filter coefficients depend on the sampling rate
+    if (ctx->filter_active) {
+        osc_filter_set_sample_rate(ctx->filter, (float)ctx->sample_rate_hz);
     }
     
+    // So do the trigger times in samples
+    osc_trigger_configure(ctx->detector, &ctx->trigger, (float)ctx->sample_rate_hz);
+    
+    reset_acquisition(ctx);
+    ctx->rate_generation++;
+    xSemaphoreGive(ctx->mutex);
+    
     ESP_LOGI(TAG, "Sample rate changed to %lu Hz", ctx->sample_rate_hz);
     return ESP_OK;
 }
 
+/**
+ * @brief Get trigger position of the last frame read
+ */
+uint32_t osc_adc_get_trigger_position(osc_adc_ctx_t *ctx)
+{
+    if (ctx == NULL) return 0;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    uint32_t position = ctx->trigger_position;
+    xSemaphoreGive(ctx->mutex);
+    
+    return position;
+}
+
 /**
  * @brief Get actual sampling rate in Hz
  */
@@ -383,6 +691,15 @@ uint32_t osc_adc_get_sample_rate_hz(osc_adc_ctx_t *ctx)
     return ctx->sample_rate_hz;
 }
 
+/**
+ * @brief Get rate of a sampling tier in Hz
+ */
+uint32_t osc_adc_get_tier_rate_hz(osc_sample_rate_t sample_rate)
+{
+    if ((unsigned)sample_rate >= sizeof(sample_rate_table) / sizeof(sample_rate_table[0])) return 0;
+    return sample_rate_table[sample_rate];
+}
+
 /**
  * @brief Check if new data is available (简化版：只要有足够数据就返回 true)
  */
@@ -393,7 +710,9 @@ bool osc_adc_has_new_data(osc_adc_ctx_t *ctx)
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
     
     // 只要缓冲区已满，或者有足够的数据（至少 1000 个样本），就认为有数据
-    bool has_data = ctx->buffer_full || (ctx->buffer_write_idx >= 1000);
+    // Triggered acquisition: only a completed frame counts
+    bool has_data = ctx->trigger.enabled ? ctx->frame_ready :
+                    (ctx->buffer_full || (ctx->buffer_write_idx >= 1000));
     
     xSemaphoreGive(ctx->mutex);
     
@@ -409,6 +728,13 @@ esp_err_t osc_adc_get_data(osc_adc_ctx_t *ctx, float *buffer, uint32_t buffer_si
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
     
+    // Triggered acquisition: wait for a completed frame
+    if (ctx->trigger.enabled && !ctx->frame_ready) {
+        xSemaphoreGive(ctx->mutex);
+        *actual_count = 0;
+        return ESP_ERR_NOT_FOUND;
+    }
+    
     // 检查是否有足够的数据（至少 1000 个样本）
     uint32_t min_samples = 1000;
     if (!ctx->buffer_full && ctx->buffer_write_idx < min_samples) {
@@ -441,10 +767,14 @@ esp_err_t osc_adc_get_data(osc_adc_ctx_t *ctx, float *buffer, uint32_t buffer_si
         start_idx = 0;
     }
     
-    // 读取数据并转换为电压
+    // 读取数据并转换为电压（滤波开启时直接使用滤波后的电压）
     for (uint32_t i = 0; i < count; i++) {
         uint32_t src_idx = (start_idx + i) % ctx->storage_depth;
-        buffer[i] = osc_adc_raw_to_voltage(ctx->sample_buffer[src_idx]);
+        if (ctx->filter_active) {
+            buffer[i] = ctx->filtered_buffer[src_idx];
+        } else {
+            buffer[i] = osc_adc_raw_to_voltage(ctx->sample_buffer[src_idx]);
+        }
     }
     
     // Debug: Log first few samples to verify conversion
@@ -466,6 +796,17 @@ esp_err_t osc_adc_get_data(osc_adc_ctx_t *ctx, float *buffer, uint32_t buffer_si
     
     *actual_count = count;
     
+    // Frame read: record where the trigger is and re-arm
+    if (ctx->trigger.enabled) {
+        uint32_t post = post_trigger_samples(ctx);
+        ctx->trigger_position = (count > post) ? count - post : 0;
+        ctx->frame_ready = false;
+        ctx->armed_samples = 0;
+        osc_trigger_reset(ctx->detector);
+    } else {
+        ctx->trigger_position = count / 2;
+    }
+    
     xSemaphoreGive(ctx->mutex);
     return ESP_OK;
 }
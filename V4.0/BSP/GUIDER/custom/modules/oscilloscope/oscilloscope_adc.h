@@ -13,6 +13,9 @@
 #define OSCILLOSCOPE_ADC_H
 
 #include "esp_err.h"
+#include "oscilloscope_filter.h"
+#include "oscilloscope_trigger.h"
+#include "oscilloscope_deepmem.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -23,6 +26,9 @@ extern "C" {
 /* Maximum storage depth (128K points like DS100 Mini) */
 #define OSC_MAX_STORAGE_DEPTH   (128 * 1024)
 
+/* Samples handed to the filter stage / circular buffer per block */
+#define OSC_ADC_BLOCK_SIZE      64
+
 /* ADC configuration for ESP32-P4 */
 #define OSC_ADC_UNIT            ADC_UNIT_1
 #define OSC_ADC_CHANNEL         ADC_CHANNEL_6  // GPIO7 for ESP32-P4 (避免与SDIO/LCD冲突)
@@ -53,14 +59,6 @@ typedef enum {
     OSC_SAMPLE_RATE_1KSPS,        // 1 kSa/s
 } osc_sample_rate_t;
 
-/* Trigger configuration */
-typedef struct {
-    bool enabled;                 // Trigger enabled
-    float level_voltage;          // Trigger level in volts
-    bool rising_edge;             // true = rising edge, false = falling edge
-    float pre_trigger_ratio;      // Pre-trigger ratio (0.0-1.0, typically 0.5)
-} osc_trigger_config_t;
-
 /* ADC sampling context */
 typedef struct osc_adc_ctx_t osc_adc_ctx_t;
 
@@ -99,15 +97,79 @@ esp_err_t osc_adc_stop(osc_adc_ctx_t *ctx);
 /**
  * @brief Configure trigger
  * 
+ * With the trigger enabled, every stored block is run through the trigger
+ * detector. After a trigger and the post-trigger samples, the frame is
+ * held until osc_adc_get_data() reads it, then the trigger re-arms.
+ * Disabled = free-running (AUTO) acquisition.
+ * 
  * @param ctx ADC context
  * @param trigger Trigger configuration
- * @return ESP_OK on success
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on an invalid configuration
  */
 esp_err_t osc_adc_set_trigger(osc_adc_ctx_t *ctx, const osc_trigger_config_t *trigger);
 
+/**
+ * @brief Configure filter stage between acquisition and storage
+ * 
+ * Samples are filtered block by block before they are stored; filter state
+ * persists across blocks. Changing the filter restarts acquisition so the
+ * capture buffer never mixes filtered and unfiltered data.
+ * 
+ * @param ctx ADC context
+ * @param stages Filter stages (NULL / 0 = unfiltered)
+ * @param num_stages Number of stages
+ * @return ESP_OK on success
+ */
+esp_err_t osc_adc_set_filter(osc_adc_ctx_t *ctx, const osc_filter_stage_config_t *stages, uint8_t num_stages);
+
+/**
+ * @brief Stream raw samples into a deep-memory record
+ * 
+ * Every acquired block is appended (unfiltered, independent of the trigger)
+ * to a record started with osc_deepmem_begin() until the record is full;
+ * the hook then detaches itself.
+ * 
+ * @param ctx ADC context
+ * @param deep Deep memory with a started record (NULL = detach)
+ * @return ESP_OK on success
+ */
+esp_err_t osc_adc_set_deep_record(osc_adc_ctx_t *ctx, osc_deepmem_t *deep);
+
+/**
+ * @brief Raw block consumer, called from the sampling task with the ADC lock held
+ * 
+ * Must not block: copy what is needed and return.
+ */
+typedef void (*osc_adc_block_hook_t)(void *user, const uint16_t *raw, uint32_t len, uint32_t sample_rate_hz);
+
+/**
+ * @brief Hand every raw block to a consumer
+ * 
+ * The hook sees each acquired block (unfiltered, independent of the trigger)
+ * before it is stored. Once this returns after detaching, the previous hook
+ * is no longer running.
+ * 
+ * @param ctx ADC context
+ * @param hook Consumer (NULL = detach)
+ * @param user Consumer context
+ * @return ESP_OK on success
+ */
+esp_err_t osc_adc_set_block_hook(osc_adc_ctx_t *ctx, osc_adc_block_hook_t hook, void *user);
+
+/**
+ * @brief Check if a deep-memory record is still being filled
+ * 
+ * @param ctx ADC context
+ * @return true while the deep record hook is attached
+ */
+bool osc_adc_is_deep_recording(osc_adc_ctx_t *ctx);
+
 /**
  * @brief Set sampling rate
  * 
+ * Takes effect without stopping a running acquisition; the capture buffer,
+ * filter and trigger history start over at the new rate.
+ * 
  * @param ctx ADC context
  * @param sample_rate New sampling rate
  * @return ESP_OK on success
@@ -122,6 +184,14 @@ esp_err_t osc_adc_set_sample_rate(osc_adc_ctx_t *ctx, osc_sample_rate_t sample_r
  */
 uint32_t osc_adc_get_sample_rate_hz(osc_adc_ctx_t *ctx);
 
+/**
+ * @brief Get rate of a sampling tier in Hz
+ * 
+ * @param sample_rate Sampling rate tier
+ * @return Sampling rate in Hz (0 for an invalid tier)
+ */
+uint32_t osc_adc_get_tier_rate_hz(osc_sample_rate_t sample_rate);
+
 /**
  * @brief Check if new data is available (trigger occurred)
  * 
@@ -130,6 +200,14 @@ uint32_t osc_adc_get_sample_rate_hz(osc_adc_ctx_t *ctx);
  */
 bool osc_adc_has_new_data(osc_adc_ctx_t *ctx);
 
+/**
+ * @brief Get trigger position of the last frame read by osc_adc_get_data()
+ * 
+ * @param ctx ADC context
+ * @return Index of the triggering sample in that frame (count / 2 if free-running)
+ */
+uint32_t osc_adc_get_trigger_position(osc_adc_ctx_t *ctx);
+
 /**
  * @brief Get captured waveform data
  * 
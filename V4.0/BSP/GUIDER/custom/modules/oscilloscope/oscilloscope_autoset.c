@@ -0,0 +1,249 @@
+/**
+ * @file oscilloscope_autoset.c
+ * @brief Signal analysis for AUTO set-up
+ */
+
+#include "oscilloscope_autoset.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+#include <math.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_dsp.h"
+#endif
+
+/* Signal class names */
+static const char *signal_strings[] = {
+    [OSC_AUTOSET_SIGNAL_NONE]     = "NONE",
+    [OSC_AUTOSET_SIGNAL_DC]       = "DC",
+    [OSC_AUTOSET_SIGNAL_NOISE]    = "NOISE",
+    [OSC_AUTOSET_SIGNAL_PERIODIC] = "PERIODIC",
+};
+
+#ifndef ESP_PLATFORM
+/* Portable stand-in for the esp-dsp dot product */
+static int dsps_dotprod_f32(const float *src1, const float *src2, float *dest, int len)
+{
+    float acc = 0.0f;
+    for (int i = 0; i < len; i++) {
+        acc += src1[i] * src2[i];
+    }
+    *dest = acc;
+    return 0;
+}
+#endif
+
+/**
+ * @brief Level of the most populated bin in [first_bin, last_bin]
+ */
+static float histogram_mode(const uint32_t *hist, int first_bin, int last_bin, float vmin, float bin_width)
+{
+    int best = first_bin;
+    for (int b = first_bin + 1; b <= last_bin; b++) {
+        if (hist[b] > hist[best]) best = b;
+    }
+    return vmin + (best + 0.5f) * bin_width;
+}
+
+/**
+ * @brief Value below which a fraction of the samples lie
+ */
+static float histogram_percentile(const uint32_t *hist, uint32_t total, float fraction, float vmin, float bin_width)
+{
+    uint32_t target = (uint32_t)(fraction * total);
+    uint32_t acc = 0;
+    for (int b = 0; b < OSC_AUTOSET_HIST_BINS; b++) {
+        acc += hist[b];
+        if (acc > target) return vmin + (b + 0.5f) * bin_width;
+    }
+    return vmin + OSC_AUTOSET_HIST_BINS * bin_width;
+}
+
+/**
+ * @brief Period (in samples of x) from the normalized autocorrelation
+ *
+ * x must be zero-mean. Each lag is normalized by the energy of the two
+ * overlapping segments, so a window that is not a whole number of periods
+ * does not pull the peak. Returns 0 if no peak stronger than the noise
+ * threshold exists within the first half of the buffer.
+ */
+static float acf_period(const float *x, int n, float *correlation)
+{
+    float r0;
+    dsps_dotprod_f32(x, x, &r0, n);
+    *correlation = 0.0f;
+    if (r0 <= 0.0f) return 0.0f;
+
+    int max_lag = n / 2;
+    float e_head = r0, e_tail = r0;     // Energy of x[0, n-k) and x[k, n)
+    float prev2 = 1.0f, prev = 1.0f;
+    bool went_negative = false;
+    float best_r = 0.0f, best_m = 0.0f, best_p = 0.0f;
+    int best_lag = 0;
+
+    for (int k = 1; k <= max_lag; k++) {
+        float rk;
+        dsps_dotprod_f32(x, x + k, &rk, n - k);
+        e_head -= x[n - k] * x[n - k];
+        e_tail -= x[k - 1] * x[k - 1];
+        float energy = e_head * e_tail;
+        rk = (energy > 0.0f) ? rk / sqrtf(energy) : 0.0f;
+
+        if (!went_negative) {
+            if (rk < 0.0f) went_negative = true;
+        } else if (k >= 2 && prev > prev2 && prev >= rk && prev > best_r) {
+            // Highest point of the first strong lobe is the fundamental;
+            // noise makes the lobe ragged, so keep looking until it ends
+            best_r = prev;
+            best_m = prev2;
+            best_p = rk;
+            best_lag = k - 1;
+        } else if (best_lag > 0 && rk < 0.0f && best_r >= OSC_AUTOSET_MIN_CORRELATION) {
+            // Past the first strong peak: later peaks are harmonics of the period
+            break;
+        }
+
+        prev2 = prev;
+        prev = rk;
+    }
+
+    if (best_lag == 0 || best_r < OSC_AUTOSET_MIN_CORRELATION) return 0.0f;
+
+    // Parabolic refinement of the peak position
+    float denom = best_m - 2.0f * best_r + best_p;
+    float delta = (fabsf(denom) > 1e-12f) ? 0.5f * (best_m - best_p) / denom : 0.0f;
+    if (delta > 0.5f) delta = 0.5f;
+    if (delta < -0.5f) delta = -0.5f;
+
+    *correlation = (best_r > 1.0f) ? 1.0f : best_r;
+    return (float)best_lag + delta;
+}
+
+/**
+ * @brief Box-decimate and remove the mean into out (at most OSC_AUTOSET_ACF_POINTS)
+ *
+ * @return Number of points written
+ */
+static int prepare_acf_input(const float *data, uint32_t num_points, uint32_t factor, float mean, float *out)
+{
+    uint32_t n = num_points / factor;
+    if (n > OSC_AUTOSET_ACF_POINTS) n = OSC_AUTOSET_ACF_POINTS;
+
+    float scale = 1.0f / (float)factor;
+    for (uint32_t i = 0; i < n; i++) {
+        const float *src = &data[i * factor];
+        float acc = 0.0f;
+        for (uint32_t j = 0; j < factor; j++) {
+            acc += src[j];
+        }
+        out[i] = acc * scale - mean;
+    }
+    return (int)n;
+}
+
+/**
+ * @brief Analyze a capture
+ */
+esp_err_t osc_autoset_analyze(const float *data, uint32_t num_points, float sample_rate_hz,
+                              osc_autoset_analysis_t *result)
+{
+    if (data == NULL || result == NULL || num_points < 16 || sample_rate_hz <= 0.0f) return ESP_ERR_INVALID_ARG;
+
+    memset(result, 0, sizeof(osc_autoset_analysis_t));
+
+    // Pass 1: extremes and mean
+    float lo = data[0], hi = data[0];
+    double sum = 0.0;
+    for (uint32_t i = 0; i < num_points; i++) {
+        float v = data[i];
+        if (v < lo) lo = v;
+        if (v > hi) hi = v;
+        sum += v;
+    }
+    float mean = (float)(sum / num_points);
+    result->mean = mean;
+
+    if (hi - lo < OSC_AUTOSET_DC_VPP) {
+        result->signal = OSC_AUTOSET_SIGNAL_DC;
+        result->vmax = result->top = hi;
+        result->vmin = result->base = lo;
+        return ESP_OK;
+    }
+
+    // Pass 2: amplitude histogram
+    uint32_t hist[OSC_AUTOSET_HIST_BINS];
+    memset(hist, 0, sizeof(hist));
+    float bin_width = (hi - lo) / OSC_AUTOSET_HIST_BINS;
+    float inv_bin = 1.0f / bin_width;
+    for (uint32_t i = 0; i < num_points; i++) {
+        int b = (int)((data[i] - lo) * inv_bin);
+        if (b >= OSC_AUTOSET_HIST_BINS) b = OSC_AUTOSET_HIST_BINS - 1;
+        hist[b]++;
+    }
+
+    result->vmin = histogram_percentile(hist, num_points, 0.005f, lo, bin_width);
+    result->vmax = histogram_percentile(hist, num_points, 0.995f, lo, bin_width);
+    result->base = histogram_mode(hist, 0, OSC_AUTOSET_HIST_BINS / 2 - 1, lo, bin_width);
+    result->top = histogram_mode(hist, OSC_AUTOSET_HIST_BINS / 2, OSC_AUTOSET_HIST_BINS - 1, lo, bin_width);
+
+    float mid = (result->top + result->base) * 0.5f;
+    uint32_t above = 0;
+    for (uint32_t i = 0; i < num_points; i++) {
+        above += (data[i] > mid);
+    }
+    result->duty = (float)above / num_points;
+
+    // Pass 3: period, full rate first, then decimated for periods longer than the window
+    // Internal RAM: the autocorrelation walks this buffer once per lag
+    float *acf = heap_caps_malloc(OSC_AUTOSET_ACF_POINTS * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (acf == NULL) return ESP_ERR_NO_MEM;
+
+    float period = 0.0f;
+    float correlation = 0.0f;
+    uint32_t factor = 1;
+    while (true) {
+        int n = prepare_acf_input(data, num_points, factor, mean, acf);
+        if (n < 16) break;
+
+        period = acf_period(acf, n, &correlation) * factor;
+        if (period > 0.0f) break;
+
+        // Next pass covers the whole record
+        uint32_t next = (num_points + OSC_AUTOSET_ACF_POINTS - 1) / OSC_AUTOSET_ACF_POINTS;
+        if (next <= factor) break;
+        factor = next;
+    }
+    heap_caps_free(acf);
+
+    result->correlation = correlation;
+    if (period > 0.0f) {
+        result->signal = OSC_AUTOSET_SIGNAL_PERIODIC;
+        result->frequency_hz = sample_rate_hz / period;
+    } else {
+        result->signal = OSC_AUTOSET_SIGNAL_NOISE;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Pick the smallest scale that is at least target
+ */
+uint32_t osc_autoset_pick_scale(const float *table, uint32_t count, float target)
+{
+    if (table == NULL || count == 0) return 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (table[i] >= target * 0.999f) return i;
+    }
+    return count - 1;
+}
+
+/**
+ * @brief Get signal class name
+ */
+const char *osc_autoset_get_signal_str(osc_autoset_signal_t signal)
+{
+    if (signal > OSC_AUTOSET_SIGNAL_PERIODIC) return "?";
+    return signal_strings[signal];
+}
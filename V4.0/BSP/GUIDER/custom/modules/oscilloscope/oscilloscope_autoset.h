@@ -0,0 +1,87 @@
+/**
+ * @file oscilloscope_autoset.h
+ * @brief Signal analysis for AUTO set-up
+ *
+ * One pass over a burst capture gives everything AUTO needs:
+ * - amplitude histogram: top/base levels (modes of the upper and lower half)
+ *   and spike-robust extremes (0.5% / 99.5% percentiles)
+ * - fundamental period from the normalized autocorrelation, first at full
+ *   rate (high frequencies) and then box-decimated (low frequencies)
+ * - classification into DC, noise (aperiodic) or periodic
+ *
+ * The module has no RTOS dependencies, so it also builds on a host.
+ */
+
+#ifndef OSCILLOSCOPE_AUTOSET_H
+#define OSCILLOSCOPE_AUTOSET_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Analysis limits */
+#define OSC_AUTOSET_HIST_BINS       256     // Amplitude histogram resolution
+#define OSC_AUTOSET_ACF_POINTS      2048    // Samples per autocorrelation pass
+#define OSC_AUTOSET_DC_VPP          0.03f   // Below this peak-peak the input is treated as DC
+#define OSC_AUTOSET_MIN_CORRELATION 0.3f    // Weaker autocorrelation peaks are noise
+
+/* Signal class */
+typedef enum {
+    OSC_AUTOSET_SIGNAL_NONE = 0,    // Not analyzed
+    OSC_AUTOSET_SIGNAL_DC,          // Flat
+    OSC_AUTOSET_SIGNAL_NOISE,       // Varies, but no period found
+    OSC_AUTOSET_SIGNAL_PERIODIC,
+} osc_autoset_signal_t;
+
+/* Analysis result */
+typedef struct {
+    osc_autoset_signal_t signal;
+    float vmax;                     // 99.5% percentile
+    float vmin;                     // 0.5% percentile
+    float top;                      // Most common level of the upper half
+    float base;                     // Most common level of the lower half
+    float mean;
+    float frequency_hz;             // 0 if not periodic
+    float duty;                     // Fraction of the record above (top + base) / 2
+    float correlation;              // Normalized autocorrelation at the period (0..1)
+} osc_autoset_analysis_t;
+
+/**
+ * @brief Analyze a capture
+ *
+ * @param data Samples (volts)
+ * @param num_points Number of samples (at least 16)
+ * @param sample_rate_hz Sampling rate
+ * @param result Output: analysis
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad input
+ */
+esp_err_t osc_autoset_analyze(const float *data, uint32_t num_points, float sample_rate_hz,
+                              osc_autoset_analysis_t *result);
+
+/**
+ * @brief Pick the smallest scale that is at least target
+ *
+ * @param table Ascending scale table
+ * @param count Number of entries
+ * @param target Wanted value
+ * @return Index into table (last entry if target is larger than all)
+ */
+uint32_t osc_autoset_pick_scale(const float *table, uint32_t count, float target);
+
+/**
+ * @brief Get signal class name for logs and labels
+ *
+ * @param signal Signal class
+ * @return Short name (e.g. "PERIODIC")
+ */
+const char *osc_autoset_get_signal_str(osc_autoset_signal_t signal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_AUTOSET_H
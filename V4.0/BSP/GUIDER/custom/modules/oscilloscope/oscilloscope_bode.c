@@ -0,0 +1,460 @@
+/**
+ * @file oscilloscope_bode.c
+ * @brief Frequency response (Bode) analyzer implementation
+ */
+
+#include "oscilloscope_bode.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <math.h>
+
+static const char *TAG = "OscBode";
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define OSC_BODE_SEGMENT        1024    // Goertzel segment length (float error stays bounded)
+#define OSC_BODE_SETTLE_FLOOR   0.002f  // Absolute settle floor, fraction of the stimulus amplitude
+#define OSC_BODE_TASK_STACK     4096
+#define OSC_BODE_TASK_PRIORITY  2
+
+/* Bode analyzer context */
+struct osc_bode_ctx_t {
+    float *buffer;                  // PSRAM, one capture
+    uint32_t max_samples;
+
+    osc_bode_point_t points[OSC_BODE_MAX_POINTS];
+    osc_bode_progress_t progress;
+    volatile bool cancel;
+
+    /* Background sweep */
+    osc_bode_config_t task_config;
+    osc_bode_io_t task_io;
+    TaskHandle_t task;
+
+    SemaphoreHandle_t mutex;
+};
+
+/**
+ * @brief Correlate samples [start, start + count) with e^(-jwn), n counted from sample 0
+ *
+ * Goertzel per segment; each segment result is rotated to the capture origin.
+ */
+static void correlate(const float *data, uint32_t start, uint32_t count, float w, float mean,
+                      double *re, double *im)
+{
+    float coeff = 2.0f * cosf(w);
+    float cw = cosf(w);
+    float sw = sinf(w);
+
+    for (uint32_t off = start; off < start + count; off += OSC_BODE_SEGMENT) {
+        uint32_t len = start + count - off;
+        if (len > OSC_BODE_SEGMENT) len = OSC_BODE_SEGMENT;
+
+        float s1 = 0.0f, s2 = 0.0f;
+        const float *x = data + off;
+        for (uint32_t i = 0; i < len; i++) {
+            float s0 = (x[i] - mean) + coeff * s1 - s2;
+            s2 = s1;
+            s1 = s0;
+        }
+
+        // Sum x[off + m] e^(-jwm) = e^(-jw(len - 1)) (s1 - e^(-jw) s2), then e^(-jw off)
+        float a = s1 - cw * s2;
+        float b = sw * s2;
+        double phi = fmod((double)w * (double)(off + len - 1), 2.0 * M_PI);
+        double cp = cos(phi), sp = sin(phi);
+        *re += a * cp + b * sp;
+        *im += b * cp - a * sp;
+    }
+}
+
+/**
+ * @brief Amplitude and sine phase of a correlation over count samples
+ */
+static void phasor_to_polar(double re, double im, uint32_t count, float *amplitude, float *phase)
+{
+    // x = A sin(wn + p)  =>  sum x e^(-jwn) = (A N / 2j) e^(jp)
+    *amplitude = (float)(2.0 * sqrt(re * re + im * im) / count);
+    *phase = (float)atan2(re, -im);
+}
+
+/**
+ * @brief Single-bin DFT of a capture at one frequency
+ */
+esp_err_t osc_bode_measure(const float *data, uint32_t count, float frequency, float sample_rate,
+                           float *amplitude, float *phase)
+{
+    if (data == NULL || count < 2 || amplitude == NULL || phase == NULL) return ESP_ERR_INVALID_ARG;
+    if (!(frequency > 0.0f) || !(sample_rate > 2.0f * frequency)) return ESP_ERR_INVALID_ARG;
+
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < count; i++) sum += data[i];
+
+    double re = 0.0, im = 0.0;
+    correlate(data, 0, count, 2.0f * (float)M_PI * frequency / sample_rate, sum / count, &re, &im);
+    phasor_to_polar(re, im, count, amplitude, phase);
+    return ESP_OK;
+}
+
+/**
+ * @brief Wrap a phase difference to (-180, 180] degrees
+ */
+static float wrap_degrees(float radians)
+{
+    float deg = fmodf(radians * (180.0f / (float)M_PI), 360.0f);
+    if (deg > 180.0f) deg -= 360.0f;
+    if (deg <= -180.0f) deg += 360.0f;
+    return deg;
+}
+
+/**
+ * @brief Measure one frequency: capture until the halves agree (or the capture limit)
+ */
+static esp_err_t measure_point(osc_bode_ctx_t *ctx, const osc_bode_config_t *cfg, const osc_bode_io_t *io,
+                               float frequency, osc_bode_point_t *point)
+{
+    memset(point, 0, sizeof(*point));
+    point->frequency = frequency;
+    point->gain_db = NAN;
+    point->phase_deg = NAN;
+
+    esp_err_t ret = io->set_stimulus(io->user, frequency);
+    if (ret != ESP_OK) return ret;
+
+    // A few cycles at low frequencies, at least min_capture_time at high ones
+    float cycles = ceilf(cfg->min_capture_time * frequency);
+    if (cycles < cfg->min_cycles) cycles = cfg->min_cycles;
+    float min_rate = frequency * OSC_BODE_MIN_SAMPLES_PER_CYCLE;
+    float max_rate = (float)cfg->max_samples * frequency / cycles;
+    if (max_rate < min_rate) max_rate = min_rate;
+
+    float rate = io->set_sample_rate(io->user, min_rate, max_rate);
+    if (!(rate > 0.0f)) return ESP_ERR_INVALID_STATE;
+    if (!(rate > 2.0f * frequency)) {
+        ESP_LOGW(TAG, "%.1f Hz: no sample rate above Nyquist (%.0f Hz)", frequency, rate);
+        return ESP_OK;  // Point left unmeasured, the sweep goes on
+    }
+
+    // Whole cycles that fit the capture limit at the rate obtained
+    float samples_per_cycle = rate / frequency;
+    if (cycles * samples_per_cycle > (float)cfg->max_samples) {
+        cycles = floorf((float)cfg->max_samples / samples_per_cycle);
+        if (cycles < 1.0f) cycles = 1.0f;
+    }
+    uint32_t count = (uint32_t)(cycles * samples_per_cycle + 0.5f);
+    if (count > cfg->max_samples) count = cfg->max_samples;
+    if (count < 4) count = 4;
+    uint32_t half = count / 2;
+    float w = 2.0f * (float)M_PI / samples_per_cycle;
+
+    float amplitude = 0.0f, phase = 0.0f, stimulus_phase = NAN;
+    for (uint8_t attempt = 0; attempt < cfg->max_captures && !ctx->cancel; attempt++) {
+        ret = io->capture(io->user, ctx->buffer, count, &stimulus_phase);
+        if (ret != ESP_OK) return ret;
+        point->captures++;
+
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < count; i++) sum += ctx->buffer[i];
+        float mean = sum / count;
+
+        double re1 = 0.0, im1 = 0.0, re2 = 0.0, im2 = 0.0;
+        correlate(ctx->buffer, 0, half, w, mean, &re1, &im1);
+        correlate(ctx->buffer, half, count - half, w, mean, &re2, &im2);
+        phasor_to_polar(re1 + re2, im1 + im2, count, &amplitude, &phase);
+
+        // Settled when both halves see the same phasor (a decaying transient makes them differ)
+        double k1 = 2.0 / half, k2 = 2.0 / (count - half);
+        double dre = re1 * k1 - re2 * k2, dim = im1 * k1 - im2 * k2;
+        float diff = (float)sqrt(dre * dre + dim * dim);
+        if (diff <= cfg->settle_tolerance * amplitude + OSC_BODE_SETTLE_FLOOR * cfg->amplitude) {
+            point->settled = true;
+            break;
+        }
+    }
+
+    point->samples = count;
+    point->gain_db = 20.0f * log10f(fmaxf(amplitude, 1e-9f) / cfg->amplitude);
+    if (!isnan(stimulus_phase)) {
+        point->phase_deg = wrap_degrees(phase - stimulus_phase);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Initialize Bode analyzer
+ */
+osc_bode_ctx_t *osc_bode_init(uint32_t max_samples)
+{
+    if (max_samples < 64) return NULL;
+
+    osc_bode_ctx_t *ctx = heap_caps_malloc(sizeof(osc_bode_ctx_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(osc_bode_ctx_t));
+
+    ctx->buffer = heap_caps_malloc(max_samples * sizeof(float), MALLOC_CAP_SPIRAM);
+    ctx->mutex = xSemaphoreCreateMutex();
+    if (ctx->buffer == NULL || ctx->mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate capture buffer");
+        if (ctx->buffer) heap_caps_free(ctx->buffer);
+        if (ctx->mutex) vSemaphoreDelete(ctx->mutex);
+        free(ctx);
+        return NULL;
+    }
+    ctx->max_samples = max_samples;
+    ctx->progress.result = ESP_OK;
+
+    ESP_LOGI(TAG, "Bode analyzer initialized (%lu samples per capture)", max_samples);
+    return ctx;
+}
+
+/**
+ * @brief Deinitialize Bode analyzer
+ */
+void osc_bode_deinit(osc_bode_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    osc_bode_cancel(ctx);
+    heap_caps_free(ctx->buffer);
+    vSemaphoreDelete(ctx->mutex);
+    free(ctx);
+}
+
+/**
+ * @brief Get default sweep configuration
+ */
+void osc_bode_get_default_config(osc_bode_config_t *config)
+{
+    if (config == NULL) return;
+
+    config->start_hz = 10.0f;
+    config->stop_hz = 100e3f;
+    config->points = 100;
+    config->amplitude = 1.0f;
+    config->min_cycles = 2;
+    config->min_capture_time = 0.005f;
+    config->max_samples = 8192;
+    config->settle_tolerance = 0.01f;
+    config->max_captures = 4;
+}
+
+/**
+ * @brief Run a sweep in the calling task
+ */
+esp_err_t osc_bode_run(osc_bode_ctx_t *ctx, const osc_bode_config_t *config, const osc_bode_io_t *io)
+{
+    if (ctx == NULL || config == NULL || io == NULL) return ESP_ERR_INVALID_ARG;
+    if (io->set_stimulus == NULL || io->set_sample_rate == NULL || io->capture == NULL) return ESP_ERR_INVALID_ARG;
+    if (config->points < 2 || config->points > OSC_BODE_MAX_POINTS || !(config->start_hz > 0.0f) ||
+        !(config->stop_hz > config->start_hz) || !(config->amplitude > 0.0f) || config->min_cycles < 2 ||
+        config->max_samples < 64 || config->max_samples > ctx->max_samples || config->max_captures == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    if (ctx->progress.running && ctx->task != xTaskGetCurrentTaskHandle()) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    ctx->progress.running = true;
+    ctx->progress.done = 0;
+    ctx->progress.total = config->points;
+    ctx->progress.generation++;
+    ctx->progress.elapsed_us = 0;
+    ctx->progress.result = ESP_OK;
+    xSemaphoreGive(ctx->mutex);
+
+    int64_t t_start = esp_timer_get_time();
+    float log_step = logf(config->stop_hz / config->start_hz) / (float)(config->points - 1);
+    uint32_t unsettled = 0;
+    esp_err_t ret = ESP_OK;
+
+    for (uint16_t i = 0; i < config->points; i++) {
+        if (ctx->cancel) {
+            ret = ESP_ERR_TIMEOUT;
+            break;
+        }
+
+        osc_bode_point_t point;
+        ret = measure_point(ctx, config, io, config->start_hz * expf(log_step * (float)i), &point);
+        if (ret != ESP_OK) break;
+        if (!point.settled) unsettled++;
+
+        xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+        ctx->points[i] = point;
+        ctx->progress.done = i + 1;
+        ctx->progress.generation++;
+        ctx->progress.elapsed_us = esp_timer_get_time() - t_start;
+        xSemaphoreGive(ctx->mutex);
+    }
+
+    if (io->finish != NULL) {
+        io->finish(io->user);
+    }
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->progress.running = false;
+    ctx->progress.generation++;
+    ctx->progress.result = ret;
+    ctx->progress.elapsed_us = esp_timer_get_time() - t_start;
+    xSemaphoreGive(ctx->mutex);
+
+    ESP_LOGI(TAG, "Sweep %.1f Hz - %.1f Hz: %u/%u points in %lld ms, %lu unsettled (%s)",
+             config->start_hz, config->stop_hz, ctx->progress.done, config->points,
+             ctx->progress.elapsed_us / 1000, unsettled, esp_err_to_name(ret));
+    return ret;
+}
+
+/**
+ * @brief Background sweep task
+ */
+static void bode_task(void *arg)
+{
+    osc_bode_ctx_t *ctx = (osc_bode_ctx_t *)arg;
+
+    osc_bode_run(ctx, &ctx->task_config, &ctx->task_io);
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->task = NULL;
+    xSemaphoreGive(ctx->mutex);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Start a sweep in a background task
+ */
+esp_err_t osc_bode_start(osc_bode_ctx_t *ctx, const osc_bode_config_t *config, const osc_bode_io_t *io)
+{
+    if (ctx == NULL || config == NULL || io == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    if (ctx->task != NULL || ctx->progress.running) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    ctx->task_config = *config;
+    ctx->task_io = *io;
+    ctx->cancel = false;
+    // Marked running here so progress never shows the previous sweep as current
+    ctx->progress.running = true;
+    ctx->progress.done = 0;
+    ctx->progress.total = config->points;
+
+    BaseType_t ok = xTaskCreate(bode_task, "osc_bode", OSC_BODE_TASK_STACK, ctx, OSC_BODE_TASK_PRIORITY, &ctx->task);
+    if (ok != pdPASS) {
+        ctx->task = NULL;
+        ctx->progress.running = false;
+        xSemaphoreGive(ctx->mutex);
+        ESP_LOGE(TAG, "Failed to create sweep task");
+        return ESP_FAIL;
+    }
+    xSemaphoreGive(ctx->mutex);
+
+    ESP_LOGI(TAG, "Sweep started: %.1f Hz - %.1f Hz, %u points", config->start_hz, config->stop_hz, config->points);
+    return ESP_OK;
+}
+
+/**
+ * @brief Cancel a running sweep
+ */
+void osc_bode_cancel(osc_bode_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    ctx->cancel = true;
+    while (true) {
+        xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+        bool busy = (ctx->task != NULL);
+        xSemaphoreGive(ctx->mutex);
+        if (!busy) break;
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    ctx->cancel = false;
+}
+
+/**
+ * @brief Get sweep progress
+ */
+esp_err_t osc_bode_get_progress(osc_bode_ctx_t *ctx, osc_bode_progress_t *progress)
+{
+    if (ctx == NULL || progress == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    *progress = ctx->progress;
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Copy the measured points
+ */
+esp_err_t osc_bode_get_points(osc_bode_ctx_t *ctx, osc_bode_point_t *points, uint16_t max_points,
+                              uint16_t *count)
+{
+    if (ctx == NULL || points == NULL || count == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    uint16_t n = (ctx->progress.done < max_points) ? ctx->progress.done : max_points;
+    memcpy(points, ctx->points, n * sizeof(osc_bode_point_t));
+    xSemaphoreGive(ctx->mutex);
+
+    *count = n;
+    return ESP_OK;
+}
+
+/**
+ * @brief Save the measured points as CSV
+ */
+esp_err_t osc_bode_save_csv(osc_bode_ctx_t *ctx, const char *path)
+{
+    if (ctx == NULL || path == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    uint16_t n = ctx->progress.done;
+    if (n == 0) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        xSemaphoreGive(ctx->mutex);
+        ESP_LOGE(TAG, "Failed to create %s: %s", path, strerror(errno));
+        return ESP_FAIL;
+    }
+
+    bool ok = fprintf(f, "frequency_hz,gain_db,phase_deg,samples,captures,settled\n") > 0;
+    for (uint16_t i = 0; i < n && ok; i++) {
+        const osc_bode_point_t *p = &ctx->points[i];
+        // Unknown phase is an empty field, not "nan"
+        char phase[16] = "";
+        if (!isnan(p->phase_deg)) {
+            snprintf(phase, sizeof(phase), "%.3f", p->phase_deg);
+        }
+        ok = fprintf(f, "%.6g,%.4f,%s,%lu,%u,%d\n", p->frequency, p->gain_db, phase,
+                     (unsigned long)p->samples, p->captures, p->settled ? 1 : 0) > 0;
+    }
+    ok = (fclose(f) == 0) && ok;
+
+    xSemaphoreGive(ctx->mutex);
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to write %s", path);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Bode plot saved: %s (%u points)", path, n);
+    return ESP_OK;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file oscilloscope_bode.h
+ * @brief Frequency response (Bode) analyzer
+ *
+ * Sweeps a stimulus over a logarithmic frequency grid. At every step one
+ * capture of the response is correlated with the stimulus frequency
+ * (single-bin Goertzel over whole cycles) for gain and phase. Settling is
+ * detected by comparing the two halves of a capture: a capture whose halves
+ * disagree still carries the transient of the frequency step and is taken
+ * again. Capture length adapts to the frequency (a few cycles at low
+ * frequencies, a minimum time at high ones), so the sweep time is bounded
+ * by the lowest decade.
+ *
+ * Generator and acquisition are reached through osc_bode_io_t, so the same
+ * sweep runs against the scope ADC or a simulated device under test.
+ */
+
+#ifndef OSCILLOSCOPE_BODE_H
+#define OSCILLOSCOPE_BODE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OSC_BODE_MAX_POINTS         200
+#define OSC_BODE_MIN_SAMPLES_PER_CYCLE  8   // Lowest sample rate requested per stimulus frequency
+
+/* Sweep configuration */
+typedef struct {
+    float start_hz;                 // First frequency
+    float stop_hz;                  // Last frequency
+    uint16_t points;                // Log-spaced points (2 .. OSC_BODE_MAX_POINTS)
+    float amplitude;                // Stimulus peak amplitude (volts), the 0 dB reference
+    uint8_t min_cycles;             // Least whole cycles per capture (>= 2, one per half)
+    float min_capture_time;         // Least capture time (seconds), more cycles at high frequencies
+    uint32_t max_samples;           // Capture length limit
+    float settle_tolerance;         // Allowed relative difference of the half-capture phasors
+    uint8_t max_captures;           // Captures per point before accepting an unsettled result
+} osc_bode_config_t;
+
+/* One measured point */
+typedef struct {
+    float frequency;                // Hz
+    float gain_db;                  // Response / stimulus amplitude
+    float phase_deg;                // Response - stimulus phase (-180 .. 180], NAN if unknown
+    uint32_t samples;               // Samples of the accepted capture
+    uint8_t captures;               // Captures taken
+    bool settled;                   // Halves agreed within the tolerance
+} osc_bode_point_t;
+
+/* Sweep progress */
+typedef struct {
+    bool running;
+    uint16_t done;                  // Points measured
+    uint16_t total;                 // Points in the sweep
+    uint32_t generation;            // Changes with every measured point, sweep start and end
+    int64_t elapsed_us;             // Sweep time so far
+    esp_err_t result;               // ESP_OK, or why the last sweep ended early
+} osc_bode_progress_t;
+
+/* Generator and acquisition used by a sweep */
+typedef struct {
+    /** Set the stimulus frequency (the generator keeps running) */
+    esp_err_t (*set_stimulus)(void *user, float frequency_hz);
+    /** Select a sample rate in [min_rate, max_rate] (nearest available); returns it, 0 on error */
+    float (*set_sample_rate)(void *user, float min_rate, float max_rate);
+    /** Capture count samples (volts); stimulus_phase = sine phase at the first sample (radians), NAN if unknown */
+    esp_err_t (*capture)(void *user, float *buffer, uint32_t count, float *stimulus_phase);
+    /** Optional: called once when the sweep ends */
+    void (*finish)(void *user);
+    void *user;
+} osc_bode_io_t;
+
+/* Bode analyzer context */
+typedef struct osc_bode_ctx_t osc_bode_ctx_t;
+
+/**
+ * @brief Initialize Bode analyzer
+ *
+ * @param max_samples Largest capture (samples buffer, PSRAM)
+ * @return Bode context or NULL on error
+ */
+osc_bode_ctx_t *osc_bode_init(uint32_t max_samples);
+
+/**
+ * @brief Deinitialize Bode analyzer (cancels a running sweep)
+ *
+ * @param ctx Bode context
+ */
+void osc_bode_deinit(osc_bode_ctx_t *ctx);
+
+/**
+ * @brief Get default sweep configuration (10 Hz - 100 kHz, 100 points)
+ *
+ * @param config Output: configuration
+ */
+void osc_bode_get_default_config(osc_bode_config_t *config);
+
+/**
+ * @brief Run a sweep in the calling task
+ *
+ * Results are available through osc_bode_get_points() while the sweep runs.
+ *
+ * @param ctx Bode context
+ * @param config Sweep configuration
+ * @param io Generator and acquisition
+ * @return ESP_OK when every point was measured, ESP_ERR_INVALID_ARG on a bad
+ *         configuration, ESP_ERR_INVALID_STATE if a sweep is already running,
+ *         ESP_ERR_TIMEOUT if cancelled, or the first io error
+ */
+esp_err_t osc_bode_run(osc_bode_ctx_t *ctx, const osc_bode_config_t *config, const osc_bode_io_t *io);
+
+/**
+ * @brief Start a sweep in a background task
+ *
+ * @param ctx Bode context
+ * @param config Sweep configuration (copied)
+ * @param io Generator and acquisition (copied)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if a sweep is already running
+ */
+esp_err_t osc_bode_start(osc_bode_ctx_t *ctx, const osc_bode_config_t *config, const osc_bode_io_t *io);
+
+/**
+ * @brief Cancel a running sweep (returns once it has ended)
+ *
+ * @param ctx Bode context
+ */
+void osc_bode_cancel(osc_bode_ctx_t *ctx);
+
+/**
+ * @brief Get sweep progress
+ *
+ * @param ctx Bode context
+ * @param progress Output: progress
+ * @return ESP_OK on success
+ */
+esp_err_t osc_bode_get_progress(osc_bode_ctx_t *ctx, osc_bode_progress_t *progress);
+
+/**
+ * @brief Copy the measured points
+ *
+ * @param ctx Bode context
+ * @param points Output: points in frequency order
+ * @param max_points Capacity of points
+ * @param count Output: number of points copied
+ * @return ESP_OK on success
+ */
+esp_err_t osc_bode_get_points(osc_bode_ctx_t *ctx, osc_bode_point_t *points, uint16_t max_points,
+                              uint16_t *count);
+
+/**
+ * @brief Save the measured points as CSV (frequency, gain, phase, samples, captures, settled)
+ *
+ * The phase field is left empty for points without a stimulus phase reference.
+ *
+ * @param ctx Bode context
+ * @param path File path
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if nothing was measured
+ */
+esp_err_t osc_bode_save_csv(osc_bode_ctx_t *ctx, const char *path);
+
+/**
+ * @brief Single-bin DFT of a capture at one frequency
+ *
+ * Correlates the capture (mean removed) with a sine of the given frequency
+ * using the Goertzel recurrence, in segments so float precision holds for
+ * long captures.
+ *
+ * @param data Samples
+ * @param count Number of samples (>= 2)
+ * @param frequency Frequency (Hz)
+ * @param sample_rate Sample rate (Hz)
+ * @param amplitude Output: peak amplitude of the component
+ * @param phase Output: sine phase of the component at the first sample (radians)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the frequency is not below Nyquist
+ */
+esp_err_t osc_bode_measure(const float *data, uint32_t count, float frequency, float sample_rate,
+                           float *amplitude, float *phase);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_BODE_H
@@ -5,15 +5,24 @@
 
 #include "oscilloscope_core.h"
 #include "oscilloscope_adc.h"
+#include "oscilloscope_wavefile.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <math.h>
 
 static const char *TAG = "OscCore";
 
+/* AUTO burst capture length (samples) */
+#define OSC_AUTO_BURST_POINTS   16384
+
+/* Deep record samples scanned for the frequency measurement (from the window start) */
+#define OSC_DEEP_FREQ_POINTS    65536
+
 /* Time scale lookup table (seconds per division) */
 static const float time_scale_table[] = {
     [OSC_TIME_8NS]    = 8e-9f,
@@ -131,6 +140,38 @@ struct osc_core_ctx_t {
     /* Trigger configuration */
     osc_trigger_config_t trigger;
     
+    /* Input coupling and filter chain */
+    osc_coupling_t coupling;
+    osc_filter_stage_config_t user_filters[OSC_FILTER_MAX_STAGES - 1];
+    uint8_t num_user_filters;
+    
+    /* Mask test (checked on every capture) */
+    osc_mask_ctx_t *mask;
+    bool mask_stop_on_fail;
+    
+    /* Histogram / eye accumulation (fed on every capture while enabled) */
+    osc_hist_ctx_t *hist;
+    osc_eye_ctx_t *eye;
+    
+    /* Min/max pyramid of the stopped record (built on demand for search) */
+    osc_pyramid_t *pyramid;
+    
+    /* Deep memory: raw record of the sample stream, used in STOP once shown */
+    osc_deepmem_t *deep;
+    bool deep_recording;
+    bool deep_shown;
+    uint32_t deep_meas_start;       // Window of the cached deep measurements
+    uint32_t deep_meas_count;
+    float deep_min[OSC_DISPLAY_WIDTH];
+    
+    /* Streaming recorder fed from the ADC block hook while recording */
+    osc_recorder_ctx_t *recorder;
+    
+    /* Captures read in place by remote transfers (not rewritten while pinned) */
+    uint32_t captured_pins;
+    uint32_t frozen_pins;
+    bool freeze_pending;            // STOP while frozen was pinned: freeze on release
+    
     /* Measurements cache */
     float measured_freq;
     float measured_vmax;
@@ -285,6 +326,105 @@ static void calculate_measurements(osc_core_ctx_t *ctx, const osc_waveform_t *wa
     }
 }
 
+/**
+ * @brief Visible window of the deep record (time zero at its middle)
+ */
+static void get_deep_window(osc_core_ctx_t *ctx, uint32_t *start_idx, float *sample_step)
+{
+    uint32_t length = osc_deepmem_get_length(ctx->deep);
+    float time_per_sample = osc_deepmem_get_time_per_sample(ctx->deep);
+    float display_time = time_scale_table[ctx->time_scale] * OSC_GRID_COLS;
+    
+    // Double keeps whole samples at 8M points
+    double start = (double)length / 2.0 + (ctx->x_offset - display_time / 2.0f) / time_per_sample;
+    if (start < 0.0) start = 0.0;
+    *start_idx = (start >= (double)length) ? length - 1 : (uint32_t)start;
+    *sample_step = (display_time / time_per_sample) / OSC_DISPLAY_WIDTH;
+}
+
+/**
+ * @brief Calculate measurements over the visible window of the deep record
+ *
+ * Min/max/mean/RMS come from the record summaries; frequency from the
+ * mid-level crossings of at most OSC_DEEP_FREQ_POINTS samples.
+ */
+static void calculate_deep_measurements(osc_core_ctx_t *ctx, uint32_t start_idx, uint32_t count)
+{
+    osc_deepmem_stats_t stats;
+    ctx->measurements_valid = false;
+    ctx->deep_meas_start = start_idx;
+    ctx->deep_meas_count = count;
+    if (osc_deepmem_get_stats(ctx->deep, start_idx, count, &stats) != ESP_OK) return;
+    
+    ctx->measured_vmax = stats.max;
+    ctx->measured_vmin = stats.min;
+    ctx->measured_vpp = stats.max - stats.min;
+    ctx->measured_vrms = stats.rms;
+    ctx->measured_freq = 0.0f;
+    
+    uint32_t edges = 0, first = 0, last = 0;
+    uint32_t scan = (stats.count > OSC_DEEP_FREQ_POINTS) ? OSC_DEEP_FREQ_POINTS : stats.count;
+    if (osc_deepmem_find_edges(ctx->deep, start_idx, scan, stats.mean, ctx->measured_vpp * 0.1f,
+                               &edges, &first, &last) == ESP_OK && edges >= 2 && last > first) {
+        ctx->measured_freq = (edges - 1) / ((last - first) * osc_deepmem_get_time_per_sample(ctx->deep));
+    }
+    
+    ctx->measurements_valid = true;
+}
+
+/**
+ * @brief End a deep capture (mutex held)
+ *
+ * @param keep true to finish the record and show it, false to discard it
+ */
+static void end_deep_capture(osc_core_ctx_t *ctx, bool keep)
+{
+    if (!ctx->deep_recording) return;
+    
+    osc_adc_set_deep_record(ctx->adc_ctx, NULL);
+    osc_deepmem_finish(ctx->deep);
+    ctx->deep_recording = false;
+    ctx->deep_shown = keep && osc_deepmem_get_length(ctx->deep) > 0;
+    ctx->measurements_valid = false;
+    
+    ESP_LOGI(TAG, "Deep capture %s: %lu of %lu points", keep ? "ended" : "cancelled",
+             osc_deepmem_get_length(ctx->deep), osc_deepmem_get_depth(ctx->deep));
+}
+
+/**
+ * @brief Copy the current capture into the frozen record (mutex held)
+ */
+static void freeze_capture(osc_core_ctx_t *ctx)
+{
+    memcpy(ctx->frozen_waveform.voltage_data, ctx->captured_waveform.voltage_data,
+           ctx->captured_waveform.num_points * sizeof(float));
+    ctx->frozen_waveform.num_points = ctx->captured_waveform.num_points;
+    ctx->frozen_waveform.time_per_sample = ctx->captured_waveform.time_per_sample;
+    ctx->frozen_waveform.trigger_position = ctx->captured_waveform.trigger_position;
+    ctx->frozen_waveform.time_scale = ctx->time_scale;
+    ctx->frozen_waveform.volt_scale = ctx->volt_scale;
+    ctx->frozen_waveform.generation = ctx->captured_waveform.generation;
+    ctx->has_frozen_data = true;
+    ctx->freeze_pending = false;
+}
+
+/**
+ * @brief End a recording (mutex held); the recorder writes out its backlog
+ */
+static void end_recording(osc_core_ctx_t *ctx)
+{
+    if (ctx->recorder == NULL) return;
+    
+    osc_adc_set_block_hook(ctx->adc_ctx, NULL, NULL);
+    osc_recorder_stop(ctx->recorder);
+    ctx->recorder = NULL;
+    
+    // STOP left the ADC running for the recording
+    if (ctx->state == OSC_STATE_STOPPED) {
+        osc_adc_stop(ctx->adc_ctx);
+    }
+}
+
 /**
  * @brief Initialize oscilloscope core
  */
@@ -353,6 +493,9 @@ osc_core_ctx_t *osc_core_init(void)
         return NULL;
     }
     
+    // Optional: search falls back to reading every sample without it
+    ctx->pyramid = osc_pyramid_init();
+    
     ESP_LOGI(TAG, "Oscilloscope core initialized successfully");
     return ctx;
 }
@@ -380,6 +523,8 @@ void osc_core_deinit(osc_core_ctx_t *ctx)
         heap_caps_free(ctx->frozen_waveform.voltage_data);
     }
     
+    osc_pyramid_deinit(ctx->pyramid);
+    
     if (ctx->mutex) {
         vSemaphoreDelete(ctx->mutex);
     }
@@ -402,11 +547,14 @@ esp_err_t osc_core_start(osc_core_ctx_t *ctx)
         return ESP_OK;
     }
     
-    // Start ADC sampling
-    esp_err_t ret = osc_adc_start(ctx->adc_ctx);
+    // Start ADC sampling (a recording kept it running through STOP: re-arm for a fresh frame)
+    esp_err_t ret = osc_adc_is_running(ctx->adc_ctx) ? osc_adc_set_trigger(ctx->adc_ctx, &ctx->trigger)
+                                                     : osc_adc_start(ctx->adc_ctx);
     if (ret == ESP_OK) {
         ctx->state = OSC_STATE_RUNNING;
         ctx->has_frozen_data = false;
+        ctx->freeze_pending = false;
+        ctx->deep_shown = false;
         ESP_LOGI(TAG, "Oscilloscope started");
     }
     
@@ -428,24 +576,28 @@ esp_err_t osc_core_stop(osc_core_ctx_t *ctx)
         return ESP_OK;
     }
     
-    // Stop ADC sampling
-    esp_err_t ret = osc_adc_stop(ctx->adc_ctx);
+    // Stop ADC sampling; a recording keeps it and the block hook running, only the display freezes
+    esp_err_t ret = ctx->recorder != NULL ? ESP_OK : osc_adc_stop(ctx->adc_ctx);
     if (ret == ESP_OK) {
         ctx->state = OSC_STATE_STOPPED;
         
-        // Freeze current waveform
+        // Freeze current waveform. While a remote transfer still reads the
+        // previous frozen record, show the capture itself (not rewritten
+        // while stopped) and freeze it once the transfer lets go
         if (ctx->captured_waveform.num_points > 0) {
-            memcpy(ctx->frozen_waveform.voltage_data, ctx->captured_waveform.voltage_data,
-                   ctx->captured_waveform.num_points * sizeof(float));
-            ctx->frozen_waveform.num_points = ctx->captured_waveform.num_points;
-            ctx->frozen_waveform.time_per_sample = ctx->captured_waveform.time_per_sample;
-            ctx->frozen_waveform.trigger_position = ctx->captured_waveform.trigger_position;
-            ctx->frozen_waveform.time_scale = ctx->time_scale;
-            ctx->frozen_waveform.volt_scale = ctx->volt_scale;
-            ctx->has_frozen_data = true;
+            if (ctx->frozen_pins == 0) {
+                freeze_capture(ctx);
+            } else {
+                ctx->has_frozen_data = false;
+                ctx->freeze_pending = true;
+            }
         }
         
-        ESP_LOGI(TAG, "Oscilloscope stopped (waveform frozen)");
+        // A deep capture in progress ends here and becomes the displayed record
+        end_deep_capture(ctx, true);
+        
+        ESP_LOGI(TAG, "Oscilloscope stopped (waveform frozen%s)",
+                 ctx->recorder != NULL ? ", recording continues" : "");
     }
     
     xSemaphoreGive(ctx->mutex);
@@ -470,8 +622,9 @@ esp_err_t osc_core_set_time_scale(osc_core_ctx_t *ctx, osc_time_scale_t time_sca
         ctx->mode = OSC_MODE_NORMAL;
     }
     
-    // Update ADC sampling rate if running
+    // Update ADC sampling rate if running (a deep record cannot change rate midway)
     if (ctx->state == OSC_STATE_RUNNING) {
+        end_deep_capture(ctx, false);
         osc_sample_rate_t sample_rate = get_sample_rate_for_time_scale(time_scale);
         osc_adc_set_sample_rate(ctx->adc_ctx, sample_rate);
     }
@@ -504,7 +657,14 @@ esp_err_t osc_core_set_x_offset(osc_core_ctx_t *ctx, float offset_seconds)
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
     
     // In STOP mode, limit offset to captured data range
-    if (ctx->state == OSC_STATE_STOPPED && ctx->has_frozen_data) {
+    if (ctx->state == OSC_STATE_STOPPED && ctx->deep_shown) {
+        float max_time = osc_deepmem_get_length(ctx->deep) * osc_deepmem_get_time_per_sample(ctx->deep);
+        float display_time = time_scale_table[ctx->time_scale] * OSC_GRID_COLS;
+        float max_offset = (max_time > display_time) ? (max_time - display_time) / 2.0f : 0.0f;
+        
+        if (offset_seconds > max_offset) offset_seconds = max_offset;
+        if (offset_seconds < -max_offset) offset_seconds = -max_offset;
+    } else if (ctx->state == OSC_STATE_STOPPED && ctx->has_frozen_data) {
         float max_time = ctx->frozen_waveform.num_points * ctx->frozen_waveform.time_per_sample;
         float display_time = time_scale_table[ctx->time_scale] * OSC_GRID_COLS;
         float max_offset = (max_time - display_time) / 2.0f;
@@ -541,83 +701,166 @@ esp_err_t osc_core_set_trigger(osc_core_ctx_t *ctx, const osc_trigger_config_t *
     if (ctx == NULL || trigger == NULL) return ESP_ERR_INVALID_ARG;
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
-    memcpy(&ctx->trigger, trigger, sizeof(osc_trigger_config_t));
-    osc_adc_set_trigger(ctx->adc_ctx, trigger);
+    esp_err_t ret = osc_adc_set_trigger(ctx->adc_ctx, trigger);
+    if (ret == ESP_OK) {
+        memcpy(&ctx->trigger, trigger, sizeof(osc_trigger_config_t));
+    }
     xSemaphoreGive(ctx->mutex);
     
-    return ESP_OK;
+    return ret;
 }
 
-// Continued in next part...
+/**
+ * @brief Push coupling + user filters to the acquisition path (mutex held)
+ */
+static esp_err_t apply_filter_chain(osc_core_ctx_t *ctx)
+{
+    osc_filter_stage_config_t chain[OSC_FILTER_MAX_STAGES];
+    uint8_t count = 0;
+    
+    if (ctx->coupling == OSC_COUPLING_AC) {
+        chain[count++] = (osc_filter_stage_config_t) {
+            .type = OSC_FILTER_DC_BLOCK,
+            .cutoff_hz = OSC_FILTER_AC_CUTOFF_HZ,
+        };
+    }
+    
+    memcpy(&chain[count], ctx->user_filters, ctx->num_user_filters * sizeof(osc_filter_stage_config_t));
+    count += ctx->num_user_filters;
+    
+    esp_err_t ret = osc_adc_set_filter(ctx->adc_ctx, chain, count);
+    if (ret == ESP_OK) {
+        ctx->measurements_valid = false;
+    }
+    return ret;
+}
 
 /**
- * @brief Get current waveform for display
+ * @brief Set input coupling
  */
-esp_err_t osc_core_get_display_waveform(osc_core_ctx_t *ctx, float *display_buffer, uint32_t *actual_count)
+esp_err_t osc_core_set_coupling(osc_core_ctx_t *ctx, osc_coupling_t coupling)
 {
-    if (ctx == NULL || display_buffer == NULL || actual_count == NULL) return ESP_ERR_INVALID_ARG;
+    if (ctx == NULL) return ESP_ERR_INVALID_ARG;
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->coupling = coupling;
+    esp_err_t ret = apply_filter_chain(ctx);
+    xSemaphoreGive(ctx->mutex);
     
-    osc_waveform_t *waveform = (ctx->state == OSC_STATE_STOPPED && ctx->has_frozen_data) ?
-                                &ctx->frozen_waveform : &ctx->captured_waveform;
+    ESP_LOGI(TAG, "Coupling: %s", (coupling == OSC_COUPLING_AC) ? "AC" : "DC");
+    return ret;
+}
+
+/**
+ * @brief Get input coupling
+ */
+osc_coupling_t osc_core_get_coupling(osc_core_ctx_t *ctx)
+{
+    if (ctx == NULL) return OSC_COUPLING_DC;
+    return ctx->coupling;
+}
+
+/**
+ * @brief Set user filter chain
+ */
+esp_err_t osc_core_set_filter(osc_core_ctx_t *ctx, const osc_filter_stage_config_t *stages, uint8_t num_stages)
+{
+    if (ctx == NULL || num_stages > OSC_FILTER_MAX_STAGES - 1) return ESP_ERR_INVALID_ARG;
+    if (num_stages > 0 && stages == NULL) return ESP_ERR_INVALID_ARG;
     
-    if (waveform->num_points == 0) {
-        xSemaphoreGive(ctx->mutex);
-        *actual_count = 0;
-        return ESP_ERR_NOT_FOUND;
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    osc_filter_stage_config_t previous[OSC_FILTER_MAX_STAGES - 1];
+    uint8_t previous_count = ctx->num_user_filters;
+    memcpy(previous, ctx->user_filters, sizeof(previous));
+    
+    if (num_stages > 0) {
+        memcpy(ctx->user_filters, stages, num_stages * sizeof(osc_filter_stage_config_t));
+    }
+    ctx->num_user_filters = num_stages;
+    
+    esp_err_t ret = apply_filter_chain(ctx);
+    if (ret != ESP_OK) {
+        // Keep the last working chain
+        memcpy(ctx->user_filters, previous, sizeof(previous));
+        ctx->num_user_filters = previous_count;
+        apply_filter_chain(ctx);
     }
     
-    // Calculate display parameters
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+// Continued in next part...
+
+/**
+ * @brief Get the waveform shown on screen (frozen copy in STOP mode)
+ */
+static osc_waveform_t *get_active_waveform(osc_core_ctx_t *ctx)
+{
+    return (ctx->state == OSC_STATE_STOPPED && ctx->has_frozen_data) ?
+            &ctx->frozen_waveform : &ctx->captured_waveform;
+}
+
+/**
+ * @brief Calculate first visible sample and samples per display pixel
+ */
+static void get_display_window(osc_core_ctx_t *ctx, const osc_waveform_t *waveform,
+                               uint32_t *start_idx, float *sample_step)
+{
     float time_per_div = time_scale_table[ctx->time_scale];
     float display_time = time_per_div * OSC_GRID_COLS;
     
-    // In STOP mode, time scale can be different from capture time scale
-    // This implements the zoom behavior
-    float time_scale_ratio = 1.0f;
-    if (ctx->state == OSC_STATE_STOPPED && ctx->has_frozen_data) {
-        float frozen_time_per_div = time_scale_table[waveform->time_scale];
-        time_scale_ratio = frozen_time_per_div / time_per_div;
-    }
-    
     // Calculate start position based on offset
     float trigger_time = waveform->trigger_position * waveform->time_per_sample;
     float start_time = trigger_time - (display_time / 2.0f) + ctx->x_offset;
     
     if (start_time < 0.0f) start_time = 0.0f;
     
-    uint32_t start_idx = (uint32_t)(start_time / waveform->time_per_sample);
-    if (start_idx >= waveform->num_points) start_idx = waveform->num_points - 1;
+    *start_idx = (uint32_t)(start_time / waveform->time_per_sample);
+    if (*start_idx >= waveform->num_points) *start_idx = waveform->num_points - 1;
     
     // Resample waveform data to display width
-    float sample_step = (display_time / waveform->time_per_sample) / OSC_DISPLAY_WIDTH;
-    
-    uint32_t count = 0;
-    for (uint32_t i = 0; i < OSC_DISPLAY_WIDTH && count < OSC_DISPLAY_WIDTH; i++) {
-        uint32_t src_idx = start_idx + (uint32_t)(i * sample_step);
-        
-        if (src_idx >= waveform->num_points) break;
-        
-        // Apply Y offset
-        display_buffer[count] = waveform->voltage_data[src_idx] + ctx->y_offset;
-        count++;
-    }
-    
-    *actual_count = count;
-    xSemaphoreGive(ctx->mutex);
-    
-    return ESP_OK;
+    *sample_step = (display_time / waveform->time_per_sample) / OSC_DISPLAY_WIDTH;
 }
 
 /**
- * @brief Get preview waveform
+ * @brief Number of record samples covered by the visible window
  */
-esp_err_t osc_core_get_preview_waveform(osc_core_ctx_t *ctx, float *preview_buffer, uint32_t preview_width, uint32_t *actual_count)
+static uint32_t get_visible_count(const osc_waveform_t *waveform, uint32_t start_idx, float sample_step)
 {
-    if (ctx == NULL || preview_buffer == NULL || actual_count == NULL) return ESP_ERR_INVALID_ARG;
+    uint32_t count = (uint32_t)(sample_step * OSC_DISPLAY_WIDTH + 0.5f);
+    if (count > waveform->num_points - start_idx) count = waveform->num_points - start_idx;
+    return count;
+}
+
+/**
+ * @brief Get current waveform for display
+ */
+esp_err_t osc_core_get_display_waveform(osc_core_ctx_t *ctx, float *display_buffer, uint32_t *actual_count)
+{
+    if (ctx == NULL || display_buffer == NULL || actual_count == NULL) return ESP_ERR_INVALID_ARG;
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
     
+    // Deep record: min/max envelope from its summaries, drawn alternately
+    // (max, min, max, ...) so one trace covers the envelope of every column
+    if (ctx->deep_shown) {
+        uint32_t start_idx;
+        float sample_step;
+        uint16_t filled = 0;
+        get_deep_window(ctx, &start_idx, &sample_step);
+        esp_err_t ret = osc_deepmem_get_envelope(ctx->deep, start_idx, sample_step, OSC_DISPLAY_WIDTH,
+                                                 ctx->deep_min, display_buffer, &filled);
+        for (uint16_t i = 0; i < filled; i++) {
+            if (i & 1) display_buffer[i] = ctx->deep_min[i];
+            display_buffer[i] += ctx->y_offset;
+        }
+        *actual_count = filled;
+        xSemaphoreGive(ctx->mutex);
+        return ret;
+    }
+    
     osc_waveform_t *waveform = (ctx->state == OSC_STATE_STOPPED && ctx->has_frozen_data) ?
                                 &ctx->frozen_waveform : &ctx->captured_waveform;
     
@@ -627,240 +870,928 @@ esp_err_t osc_core_get_preview_waveform(osc_core_ctx_t *ctx, float *preview_buff
         return ESP_ERR_NOT_FOUND;
     }
     
-    // Downsample complete waveform to preview width
-    float sample_step = (float)waveform->num_points / preview_width;
+    // Calculate visible window
+    uint32_t start_idx;
+    float sample_step;
+    get_display_window(ctx, waveform, &start_idx, &sample_step);
     
-    for (uint32_t i = 0; i < preview_width; i++) {
-        uint32_t src_idx = (uint32_t)(i * sample_step);
-        if (src_idx >= waveform->num_points) src_idx = waveform->num_points - 1;
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < OSC_DISPLAY_WIDTH && count < OSC_DISPLAY_WIDTH; i++) {
+        uint32_t src_idx = start_idx + (uint32_t)(i * sample_step);
         
-        preview_buffer[i] = waveform->voltage_data[src_idx];
+        if (src_idx >= waveform->num_points) break;
+        
+        // Apply Y offset
+        display_buffer[count] = waveform->voltage_data[src_idx] + ctx->y_offset;
+        count++;
     }
     
-    *actual_count = preview_width;
+    *actual_count = count;
     xSemaphoreGive(ctx->mutex);
     
     return ESP_OK;
 }
 
 /**
- * @brief Get visible window position in preview area
+ * @brief Get MATH trace for display
  */
-esp_err_t osc_core_get_preview_window(osc_core_ctx_t *ctx, uint32_t preview_width, float *window_start, float *window_width)
+esp_err_t osc_core_get_math_waveform(osc_core_ctx_t *ctx, osc_math_ctx_t *math, float *display_buffer,
+                                     uint32_t *actual_count, osc_math_info_t *info)
 {
-    if (ctx == NULL || window_start == NULL || window_width == NULL) return ESP_ERR_INVALID_ARG;
+    if (ctx == NULL || math == NULL || display_buffer == NULL || actual_count == NULL) return ESP_ERR_INVALID_ARG;
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
     
-    osc_waveform_t *waveform = (ctx->state == OSC_STATE_STOPPED && ctx->has_frozen_data) ?
-                                &ctx->frozen_waveform : &ctx->captured_waveform;
+    osc_waveform_t *waveform = get_active_waveform(ctx);
     
     if (waveform->num_points == 0) {
         xSemaphoreGive(ctx->mutex);
-        *window_start = 0.0f;
-        *window_width = 1.0f;
+        *actual_count = 0;
         return ESP_ERR_NOT_FOUND;
     }
     
-    // Calculate total captured time
-    float total_time = waveform->num_points * waveform->time_per_sample;
-    
-    // Calculate display time (visible window time)
-    float time_per_div = time_scale_table[ctx->time_scale];
-    float display_time = time_per_div * OSC_GRID_COLS;
-    
-    // Calculate window width as fraction of total time
-    *window_width = display_time / total_time;
-    if (*window_width > 1.0f) *window_width = 1.0f;
-    
-    // Calculate window start position
-    float trigger_time = waveform->trigger_position * waveform->time_per_sample;
-    float start_time = trigger_time - (display_time / 2.0f) + ctx->x_offset;
+    uint32_t start_idx;
+    float sample_step;
+    get_display_window(ctx, waveform, &start_idx, &sample_step);
     
-    if (start_time < 0.0f) start_time = 0.0f;
-    if (start_time > total_time - display_time) start_time = total_time - display_time;
+    osc_math_source_t src = {
+        .data = waveform->voltage_data,
+        .num_points = waveform->num_points,
+        .time_per_sample = waveform->time_per_sample,
+        .generation = waveform->generation,
+    };
     
-    *window_start = start_time / total_time;
+    esp_err_t ret = osc_math_evaluate(math, &src, start_idx, sample_step,
+                                      display_buffer, OSC_DISPLAY_WIDTH, actual_count, info);
     
     xSemaphoreGive(ctx->mutex);
-    return ESP_OK;
+    return ret;
 }
 
 /**
- * @brief Get current oscilloscope state
+ * @brief Get capture generation of the displayed waveform
  */
-osc_state_t osc_core_get_state(osc_core_ctx_t *ctx)
+uint32_t osc_core_get_capture_generation(osc_core_ctx_t *ctx)
 {
-    if (ctx == NULL) return OSC_STATE_STOPPED;
+    if (ctx == NULL) return 0;
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
-    osc_state_t state = ctx->state;
+    uint32_t generation = get_active_waveform(ctx)->generation;
     xSemaphoreGive(ctx->mutex);
     
-    return state;
+    return generation;
 }
 
 /**
- * @brief Get current operating mode
+ * @brief Attach a mask tester
  */
-osc_mode_t osc_core_get_mode(osc_core_ctx_t *ctx)
+esp_err_t osc_core_set_mask(osc_core_ctx_t *ctx, osc_mask_ctx_t *mask, bool stop_on_fail)
 {
-    if (ctx == NULL) return OSC_MODE_NORMAL;
+    if (ctx == NULL) return ESP_ERR_INVALID_ARG;
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
-    osc_mode_t mode = ctx->mode;
+    ctx->mask = mask;
+    ctx->mask_stop_on_fail = stop_on_fail;
     xSemaphoreGive(ctx->mutex);
     
-    return mode;
+    return ESP_OK;
 }
 
 /**
- * @brief Get time scale value in seconds per division
+ * @brief Build a mask from the displayed waveform
  */
-float osc_core_get_time_per_div(osc_time_scale_t time_scale)
+esp_err_t osc_core_create_mask(osc_core_ctx_t *ctx, osc_mask_ctx_t *mask, float tol_x_div, float tol_y_v)
 {
-    if (time_scale >= OSC_TIME_MAX) return 0.0f;
-    return time_scale_table[time_scale];
+    if (ctx == NULL || mask == NULL || tol_x_div < 0.0f) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    osc_waveform_t *waveform = get_active_waveform(ctx);
+    if (waveform->num_points == 0) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    uint32_t start_idx;
+    float sample_step;
+    get_display_window(ctx, waveform, &start_idx, &sample_step);
+    
+    uint16_t tol_x_columns = (uint16_t)(tol_x_div * OSC_DISPLAY_WIDTH / OSC_GRID_COLS + 0.5f);
+    esp_err_t ret = osc_mask_create(mask, waveform->voltage_data, waveform->num_points,
+                                    start_idx, sample_step, OSC_DISPLAY_WIDTH,
+                                    tol_x_columns, tol_y_v, sample_step * waveform->time_per_sample);
+    
+    xSemaphoreGive(ctx->mutex);
+    return ret;
 }
 
 /**
- * @brief Get voltage scale value in volts per division
+ * @brief Attach the histogram and eye accumulators
  */
-float osc_core_get_volts_per_div(osc_volt_scale_t volt_scale)
+esp_err_t osc_core_set_analysis(osc_core_ctx_t *ctx, osc_hist_ctx_t *hist, osc_eye_ctx_t *eye)
 {
-    if (volt_scale >= OSC_VOLT_MAX) return 0.0f;
-    return volt_scale_table[volt_scale];
+    if (ctx == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->hist = hist;
+    ctx->eye = eye;
+    xSemaphoreGive(ctx->mutex);
+    
+    return ESP_OK;
 }
 
 /**
- * @brief Get time scale string representation
+ * @brief Re-bin the histogram from the visible window of the displayed waveform
  */
-const char *osc_core_get_time_scale_str(osc_time_scale_t time_scale)
+esp_err_t osc_core_update_histogram(osc_core_ctx_t *ctx, osc_hist_ctx_t *hist)
 {
-    if (time_scale >= OSC_TIME_MAX) return "???";
-    return time_scale_strings[time_scale];
+    if (ctx == NULL || hist == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    osc_waveform_t *waveform = get_active_waveform(ctx);
+    if (waveform->num_points == 0) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    uint32_t start_idx;
+    float sample_step;
+    get_display_window(ctx, waveform, &start_idx, &sample_step);
+    osc_hist_reset(hist);
+    esp_err_t ret = osc_hist_accumulate(hist, &waveform->voltage_data[start_idx],
+                                        get_visible_count(waveform, start_idx, sample_step));
+    
+    xSemaphoreGive(ctx->mutex);
+    return ret;
 }
 
 /**
- * @brief Get voltage scale string representation
+ * @brief Store the visible window in a reference slot
  */
-const char *osc_core_get_volt_scale_str(osc_volt_scale_t volt_scale)
+esp_err_t osc_core_store_ref(osc_core_ctx_t *ctx, osc_ref_ctx_t *ref, uint8_t slot)
 {
-    if (volt_scale >= OSC_VOLT_MAX) return "???";
-    return volt_scale_strings[volt_scale];
+    if (ctx == NULL || ref == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    osc_waveform_t *waveform = get_active_waveform(ctx);
+    if (waveform->num_points < 2 || waveform->time_per_sample <= 0.0f) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    uint32_t start_idx;
+    float sample_step;
+    get_display_window(ctx, waveform, &start_idx, &sample_step);
+    
+    // Whole visible window, decimated to the slot size
+    uint32_t count = get_visible_count(waveform, start_idx, sample_step);
+    uint32_t stride = (count + OSC_REF_MAX_POINTS - 1) / OSC_REF_MAX_POINTS;
+    if (stride == 0) stride = 1;
+    
+    osc_ref_info_t info = {
+        .time_per_point = stride * waveform->time_per_sample,
+        .start_time = ((float)start_idx - (float)waveform->trigger_position) * waveform->time_per_sample,
+        .time_per_div = time_scale_table[ctx->time_scale],
+        .volts_per_div = volt_scale_table[ctx->volt_scale],
+    };
+    esp_err_t ret = osc_ref_store(ref, slot, &waveform->voltage_data[start_idx], count, stride, &info);
+    
+    xSemaphoreGive(ctx->mutex);
+    return ret;
 }
 
 /**
- * @brief Perform auto-adjust (improved algorithm for -50V to +50V range)
+ * @brief Attach deep memory
  */
-esp_err_t osc_core_auto_adjust(osc_core_ctx_t *ctx)
+esp_err_t osc_core_set_deep_memory(osc_core_ctx_t *ctx, osc_deepmem_t *deep)
 {
     if (ctx == NULL) return ESP_ERR_INVALID_ARG;
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    end_deep_capture(ctx, false);
+    ctx->deep = deep;
+    ctx->deep_shown = false;
+    xSemaphoreGive(ctx->mutex);
     
-    osc_waveform_t *waveform = (ctx->state == OSC_STATE_STOPPED && ctx->has_frozen_data) ?
-                                &ctx->frozen_waveform : &ctx->captured_waveform;
-    
-    if (waveform->num_points == 0) {
+    return ESP_OK;
+}
+
+/**
+ * @brief Start a deep capture
+ */
+esp_err_t osc_core_start_deep_capture(osc_core_ctx_t *ctx, uint32_t depth)
+{
+    if (ctx == NULL || depth == 0) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    if (ctx->deep == NULL || ctx->state != OSC_STATE_RUNNING) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    end_deep_capture(ctx, false);
+    
+    // Codes map linearly to volts: take gain and offset from the ADC conversion
+    float volts_offset = osc_adc_raw_to_voltage(0);
+    float volts_per_code = (osc_adc_raw_to_voltage(4095) - volts_offset) / 4095.0f;
+    float time_per_sample = 1.0f / osc_adc_get_sample_rate_hz(ctx->adc_ctx);
+    
+    esp_err_t ret = osc_deepmem_begin(ctx->deep, depth, time_per_sample, volts_per_code, volts_offset);
+    if (ret == ESP_OK) {
+        ret = osc_adc_set_deep_record(ctx->adc_ctx, ctx->deep);
+        ctx->deep_recording = (ret == ESP_OK);
+    }
+    
+    xSemaphoreGive(ctx->mutex);
+    
+    ESP_LOGI(TAG, "Deep capture of %lu points at %.0f Sa/s: %s", depth, 1.0f / time_per_sample, esp_err_to_name(ret));
+    return ret;
+}
+
+/**
+ * @brief Cancel a deep capture in progress
+ */
+void osc_core_cancel_deep_capture(osc_core_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    end_deep_capture(ctx, false);
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Get deep capture status
+ */
+esp_err_t osc_core_get_deep_status(osc_core_ctx_t *ctx, osc_deep_status_t *status)
+{
+    if (ctx == NULL || status == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    status->recording = ctx->deep_recording;
+    status->shown = ctx->deep_shown;
+    status->depth = osc_deepmem_get_depth(ctx->deep);
+    status->length = osc_deepmem_get_length(ctx->deep);
+    status->time_per_sample = osc_deepmem_get_time_per_sample(ctx->deep);
+    xSemaphoreGive(ctx->mutex);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Pin the displayed capture for reading in place
+ */
+esp_err_t osc_core_pin_waveform(osc_core_ctx_t *ctx, osc_waveform_view_t *view)
+{
+    if (ctx == NULL || view == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    if (ctx->deep_shown) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    
+    osc_waveform_t *waveform = get_active_waveform(ctx);
+    if (waveform->num_points == 0 || waveform->time_per_sample <= 0.0f) {
         xSemaphoreGive(ctx->mutex);
-        ESP_LOGW(TAG, "No waveform data for auto-adjust");
         return ESP_ERR_NOT_FOUND;
     }
     
-    // Calculate signal characteristics
-    float vmax = 50.0f;
-    float vmin = -50.0f;
-    int zero_crossings = 0;
-    int last_sign = 0;
+    if (waveform == &ctx->frozen_waveform) {
+        ctx->frozen_pins++;
+    } else {
+        ctx->captured_pins++;
+    }
+    view->volts = waveform->voltage_data;
+    view->num_points = waveform->num_points;
+    view->time_per_sample = waveform->time_per_sample;
+    view->trigger_index = waveform->trigger_position;
+    view->generation = waveform->generation;
     
-    for (uint32_t i = 0; i < waveform->num_points; i++) {
-        float v = waveform->voltage_data[i];
-        if (v > vmax) vmax = v;
-        if (v < vmin) vmin = v;
-        
-        // Count zero crossings for frequency estimation
-        int sign = (v >= 0.0f) ? 1 : -1;
-        if (last_sign != 0 && sign != last_sign) {
-            zero_crossings++;
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Release a pinned capture
+ */
+void osc_core_unpin_waveform(osc_core_ctx_t *ctx, const osc_waveform_view_t *view)
+{
+    if (ctx == NULL || view == NULL) return;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    if (view->volts == ctx->frozen_waveform.voltage_data) {
+        if (ctx->frozen_pins > 0) ctx->frozen_pins--;
+        // The STOP deferred while it was pinned
+        if (ctx->frozen_pins == 0 && ctx->freeze_pending && ctx->state == OSC_STATE_STOPPED) {
+            freeze_capture(ctx);
         }
-        last_sign = sign;
+    } else if (view->volts == ctx->captured_waveform.voltage_data) {
+        if (ctx->captured_pins > 0) ctx->captured_pins--;
     }
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Start streaming the raw acquisition to SD card
+ */
+esp_err_t osc_core_start_recording(osc_core_ctx_t *ctx, osc_recorder_ctx_t *recorder, const char *base_path)
+{
+    if (ctx == NULL || recorder == NULL || base_path == NULL) return ESP_ERR_INVALID_ARG;
     
-    float vpp = vmax - vmin;
-    float vcenter = (vmax + vmin) / 2.0f;
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
     
-    // Check if signal is valid
-    if (vpp < 0.01f) {
+    if (ctx->state != OSC_STATE_RUNNING || ctx->recorder != NULL) {
         xSemaphoreGive(ctx->mutex);
-        ESP_LOGW(TAG, "Signal too small for auto-adjust (Vpp=%.3fV)", vpp);
-        return ESP_ERR_INVALID_ARG;
+        return ESP_ERR_INVALID_STATE;
     }
     
-    // Auto-adjust voltage scale
-    // Target: signal occupies 6-7 divisions (out of 9 total) for good visibility
-    float target_volts_per_div = vpp / 6.5f;
-    osc_volt_scale_t best_volt_scale = OSC_VOLT_1V;
-    float best_diff = 1000.0f;
+    float volts_offset = osc_adc_raw_to_voltage(0);
+    float volts_per_code = (osc_adc_raw_to_voltage(4095) - volts_offset) / 4095.0f;
+    esp_err_t ret = osc_recorder_start(recorder, base_path, volts_per_code, volts_offset);
+    if (ret == ESP_OK) {
+        ret = osc_adc_set_block_hook(ctx->adc_ctx, osc_recorder_push, recorder);
+        if (ret == ESP_OK) {
+            ctx->recorder = recorder;
+        } else {
+            osc_recorder_stop(recorder);
+        }
+    }
+    
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Stop streaming to SD card
+ */
+void osc_core_stop_recording(osc_core_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    end_recording(ctx);
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Check if the raw acquisition is being recorded
+ */
+bool osc_core_is_recording(osc_core_ctx_t *ctx)
+{
+    if (ctx == NULL) return false;
     
-    for (int i = 0; i < OSC_VOLT_MAX; i++) {
-        float diff = fabsf(volt_scale_table[i] - target_volts_per_div);
-        if (diff < best_diff) {
-            best_diff = diff;
-            best_volt_scale = (osc_volt_scale_t)i;
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    bool recording = (ctx->recorder != NULL);
+    xSemaphoreGive(ctx->mutex);
+    return recording;
+}
+
+/**
+ * @brief Select the acquisition rate for external captures
+ */
+float osc_core_set_acquire_rate(osc_core_ctx_t *ctx, float min_rate, float max_rate)
+{
+    if (ctx == NULL) return 0.0f;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    if (ctx->state != OSC_STATE_RUNNING) {
+        xSemaphoreGive(ctx->mutex);
+        return 0.0f;
+    }
+    // The record would mix sample rates
+    end_deep_capture(ctx, false);
+    osc_trigger_config_t free_run = ctx->trigger;
+    free_run.enabled = false;
+    osc_adc_set_trigger(ctx->adc_ctx, &free_run);
+    xSemaphoreGive(ctx->mutex);
+    
+    // Tiers run from fastest to slowest
+    osc_sample_rate_t pick = OSC_SAMPLE_RATE_1MSPS;
+    bool found = false;
+    for (int r = OSC_SAMPLE_RATE_1MSPS; r <= OSC_SAMPLE_RATE_1KSPS && !found; r++) {
+        float hz = (float)osc_adc_get_tier_rate_hz((osc_sample_rate_t)r);
+        if (hz <= max_rate && hz >= min_rate) {
+            pick = (osc_sample_rate_t)r;
+            found = true;
+        }
+    }
+    for (int r = OSC_SAMPLE_RATE_1KSPS; r >= OSC_SAMPLE_RATE_1MSPS && !found; r--) {
+        if ((float)osc_adc_get_tier_rate_hz((osc_sample_rate_t)r) >= min_rate) {
+            pick = (osc_sample_rate_t)r;
+            found = true;
         }
     }
     
-    ctx->volt_scale = best_volt_scale;
+    // A rate change clears the capture buffer, so keep the current tier when it is the one
+    uint32_t rate_hz = osc_adc_get_tier_rate_hz(pick);
+    if (osc_adc_get_sample_rate_hz(ctx->adc_ctx) != rate_hz) {
+        osc_adc_set_sample_rate(ctx->adc_ctx, pick);
+    }
+    return (float)rate_hz;
+}
+
+/**
+ * @brief Get the longest capture osc_core_acquire() accepts
+ */
+uint32_t osc_core_get_acquire_depth(osc_core_ctx_t *ctx)
+{
+    if (ctx == NULL) return 0;
+    return osc_adc_get_storage_depth(ctx->adc_ctx);
+}
+
+/**
+ * @brief Capture the next samples at the acquisition rate
+ */
+esp_err_t osc_core_acquire(osc_core_ctx_t *ctx, float *buffer, uint32_t count, uint32_t timeout_ms)
+{
+    if (ctx == NULL || buffer == NULL || count == 0) return ESP_ERR_INVALID_ARG;
+    if (ctx->state != OSC_STATE_RUNNING) return ESP_ERR_INVALID_STATE;
+    if (count > osc_adc_get_storage_depth(ctx->adc_ctx)) return ESP_ERR_INVALID_SIZE;
+    
+    // The newest count samples are all acquired after this call once count
+    // samples (plus one block in flight) have been stored
+    uint32_t rate_hz = osc_adc_get_sample_rate_hz(ctx->adc_ctx);
+    uint32_t capture_ms = (uint32_t)(((uint64_t)(count + OSC_ADC_BLOCK_SIZE) * 1000 + rate_hz - 1) / rate_hz);
+    vTaskDelay(pdMS_TO_TICKS(capture_ms) + 1);
+    
+    uint32_t actual = 0;
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (true) {
+        if (osc_adc_get_data(ctx->adc_ctx, buffer, count, &actual) == ESP_OK && actual == count) {
+            return ESP_OK;
+        }
+        if (esp_timer_get_time() >= deadline) break;
+        vTaskDelay(pdMS_TO_TICKS(2));
+    }
     
-    // Auto-adjust time scale based on frequency
-    // Estimate frequency from zero crossings
-    if (zero_crossings >= 2) {
-        float total_time = waveform->num_points * waveform->time_per_sample;
-        float periods = zero_crossings / 2.0f;
-        float estimated_freq = periods / total_time;
+    ESP_LOGW(TAG, "Acquire: %lu of %lu samples at %lu Hz", actual, count, rate_hz);
+    return ESP_ERR_TIMEOUT;
+}
+
+/**
+ * @brief Restore trigger and sample rate after external captures
+ */
+void osc_core_end_acquire(osc_core_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    osc_adc_set_trigger(ctx->adc_ctx, &ctx->trigger);
+    if (ctx->state == OSC_STATE_RUNNING) {
+        osc_adc_set_sample_rate(ctx->adc_ctx, get_sample_rate_for_time_scale(ctx->time_scale));
+    }
+    ctx->measurements_valid = false;
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Get the visible window of the displayed waveform
+ */
+esp_err_t osc_core_get_display_window(osc_core_ctx_t *ctx, uint32_t *start_idx, float *sample_step)
+{
+    if (ctx == NULL || start_idx == NULL || sample_step == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    osc_waveform_t *waveform = get_active_waveform(ctx);
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    if (ctx->deep_shown) {
+        get_deep_window(ctx, start_idx, sample_step);
+        ret = ESP_OK;
+    } else if (waveform->num_points > 0) {
+        get_display_window(ctx, waveform, start_idx, sample_step);
+        ret = ESP_OK;
+    }
+    
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Run the protocol decoder over the next slice of the displayed waveform
+ */
+esp_err_t osc_core_decode_step(osc_core_ctx_t *ctx, osc_decode_ctx_t *decoder,
+                               uint32_t max_samples, bool *complete)
+{
+    if (ctx == NULL || decoder == NULL) return ESP_ERR_INVALID_ARG;
+    if (complete) *complete = false;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    osc_waveform_t *waveform = get_active_waveform(ctx);
+    if (waveform->num_points == 0 || waveform->time_per_sample <= 0.0f) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    uint32_t first_sample = 0;
+    if (ctx->state != OSC_STATE_STOPPED) {
+        // Live record is replaced every capture: decode the visible part only,
+        // starting 2 divisions early so the decoder is in sync when the window begins
+        uint32_t start_idx;
+        float sample_step;
+        get_display_window(ctx, waveform, &start_idx, &sample_step);
+        uint32_t lead = (uint32_t)(sample_step * OSC_DISPLAY_WIDTH * 2 / OSC_GRID_COLS);
+        first_sample = (start_idx > lead) ? start_idx - lead : 0;
+    }
+    
+    osc_decode_record_t record = {
+        .data = waveform->voltage_data,
+        .num_points = waveform->num_points,
+        .sample_rate_hz = 1.0f / waveform->time_per_sample,
+        .generation = waveform->generation,
+        .first_sample = first_sample,
+    };
+    
+    esp_err_t ret = osc_decode_feed_record(decoder, &record, max_samples, complete);
+    
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Search the stopped record for events
+ */
+esp_err_t osc_core_search(osc_core_ctx_t *ctx, osc_search_ctx_t *search, const osc_trigger_config_t *criteria)
+{
+    if (ctx == NULL || search == NULL || criteria == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    if (ctx->state != OSC_STATE_STOPPED) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    
+    int64_t start_us = esp_timer_get_time();
+    
+    // Deep record: searched through its own summaries
+    if (ctx->deep_shown) {
+        esp_err_t ret = osc_search_run_deep(search, ctx->deep, criteria);
+        xSemaphoreGive(ctx->mutex);
+        ESP_LOGI(TAG, "Deep search over %lu points took %lld us", osc_deepmem_get_length(ctx->deep),
+                 esp_timer_get_time() - start_us);
+        return ret;
+    }
+    
+    osc_waveform_t *waveform = get_active_waveform(ctx);
+    if (waveform->num_points == 0 || waveform->time_per_sample <= 0.0f) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    osc_pyramid_t *pyramid = ctx->pyramid;
+    if (pyramid != NULL &&
+        osc_pyramid_build(pyramid, waveform->voltage_data, waveform->num_points, waveform->generation) != ESP_OK) {
+        pyramid = NULL;
+    }
+    
+    esp_err_t ret = osc_search_run(search, waveform->voltage_data, waveform->num_points, pyramid,
+                                   criteria, 1.0f / waveform->time_per_sample);
+    
+    xSemaphoreGive(ctx->mutex);
+    
+    ESP_LOGI(TAG, "Search over %lu points took %lld us", waveform->num_points, esp_timer_get_time() - start_us);
+    return ret;
+}
+
+/**
+ * @brief Get time of a record sample relative to the trigger point
+ */
+esp_err_t osc_core_get_sample_time(osc_core_ctx_t *ctx, uint32_t sample, float *time_seconds)
+{
+    if (ctx == NULL || time_seconds == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    osc_waveform_t *waveform = get_active_waveform(ctx);
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    if (ctx->deep_shown) {
+        *time_seconds = (float)(((double)sample - osc_deepmem_get_length(ctx->deep) / 2.0) *
+                                osc_deepmem_get_time_per_sample(ctx->deep));
+        ret = ESP_OK;
+    } else if (waveform->num_points > 0) {
+        *time_seconds = ((float)sample - (float)waveform->trigger_position) * waveform->time_per_sample;
+        ret = ESP_OK;
+    }
+    
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Get preview waveform
+ */
+esp_err_t osc_core_get_preview_waveform(osc_core_ctx_t *ctx, float *preview_buffer, uint32_t preview_width, uint32_t *actual_count)
+{
+    if (ctx == NULL || preview_buffer == NULL || actual_count == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    // Deep record: envelope of the whole record, max/min alternating like the main trace
+    if (ctx->deep_shown && preview_width <= OSC_DISPLAY_WIDTH) {
+        uint16_t filled = 0;
+        float sample_step = (float)osc_deepmem_get_length(ctx->deep) / preview_width;
+        esp_err_t ret = osc_deepmem_get_envelope(ctx->deep, 0, sample_step, (uint16_t)preview_width,
+                                                 ctx->deep_min, preview_buffer, &filled);
+        for (uint16_t i = 1; i < filled; i += 2) {
+            preview_buffer[i] = ctx->deep_min[i];
+        }
+        *actual_count = filled;
+        xSemaphoreGive(ctx->mutex);
+        return ret;
+    }
+    
+    osc_waveform_t *waveform = (ctx->state == OSC_STATE_STOPPED && ctx->has_frozen_data) ?
+                                &ctx->frozen_waveform : &ctx->captured_waveform;
+    
+    if (waveform->num_points == 0) {
+        xSemaphoreGive(ctx->mutex);
+        *actual_count = 0;
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    // Downsample complete waveform to preview width
+    float sample_step = (float)waveform->num_points / preview_width;
+    
+    for (uint32_t i = 0; i < preview_width; i++) {
+        uint32_t src_idx = (uint32_t)(i * sample_step);
+        if (src_idx >= waveform->num_points) src_idx = waveform->num_points - 1;
         
-        if (estimated_freq > 0.1f) {
-            // Target: show 2-4 complete cycles on screen
-            float signal_period = 1.0f / estimated_freq;
-            float target_cycles = 3.0f;
-            float total_time_needed = signal_period * target_cycles;
-            float target_time_per_div = total_time_needed / OSC_GRID_COLS;
-            
-            osc_time_scale_t best_time_scale = OSC_TIME_2MS;
-            best_diff = 1000.0f;
-            
-            for (int i = 0; i < OSC_TIME_MAX; i++) {
-                // Skip ROLL mode time scales for auto-adjust
-                if (i >= OSC_TIME_200MS) break;
-                
-                float diff = fabsf(time_scale_table[i] - target_time_per_div);
-                if (diff < best_diff) {
-                    best_diff = diff;
-                    best_time_scale = (osc_time_scale_t)i;
-                }
-            }
-            
-            ctx->time_scale = best_time_scale;
+        preview_buffer[i] = waveform->voltage_data[src_idx];
+    }
+    
+    *actual_count = preview_width;
+    xSemaphoreGive(ctx->mutex);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Get visible window position in preview area
+ */
+esp_err_t osc_core_get_preview_window(osc_core_ctx_t *ctx, uint32_t preview_width, float *window_start, float *window_width)
+{
+    if (ctx == NULL || window_start == NULL || window_width == NULL) return ESP_ERR_INVALID_ARG;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    osc_waveform_t *waveform = (ctx->state == OSC_STATE_STOPPED && ctx->has_frozen_data) ?
+                                &ctx->frozen_waveform : &ctx->captured_waveform;
+    
+    if (waveform->num_points == 0) {
+        xSemaphoreGive(ctx->mutex);
+        *window_start = 0.0f;
+        *window_width = 1.0f;
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    // Calculate total captured time
+    float total_time = waveform->num_points * waveform->time_per_sample;
+    float trigger_time = waveform->trigger_position * waveform->time_per_sample;
+    if (ctx->deep_shown) {
+        // Deep record: time zero at its middle
+        total_time = osc_deepmem_get_length(ctx->deep) * osc_deepmem_get_time_per_sample(ctx->deep);
+        trigger_time = total_time / 2.0f;
+    }
+    
+    // Calculate display time (visible window time)
+    float time_per_div = time_scale_table[ctx->time_scale];
+    float display_time = time_per_div * OSC_GRID_COLS;
+    
+    // Calculate window width as fraction of total time
+    *window_width = display_time / total_time;
+    if (*window_width > 1.0f) *window_width = 1.0f;
+    
+    // Calculate window start position
+    float start_time = trigger_time - (display_time / 2.0f) + ctx->x_offset;
+    
+    if (start_time < 0.0f) start_time = 0.0f;
+    if (start_time > total_time - display_time) start_time = total_time - display_time;
+    
+    *window_start = start_time / total_time;
+    
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Get current oscilloscope state
+ */
+osc_state_t osc_core_get_state(osc_core_ctx_t *ctx)
+{
+    if (ctx == NULL) return OSC_STATE_STOPPED;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    osc_state_t state = ctx->state;
+    xSemaphoreGive(ctx->mutex);
+    
+    return state;
+}
+
+/**
+ * @brief Get current operating mode
+ */
+osc_mode_t osc_core_get_mode(osc_core_ctx_t *ctx)
+{
+    if (ctx == NULL) return OSC_MODE_NORMAL;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    osc_mode_t mode = ctx->mode;
+    xSemaphoreGive(ctx->mutex);
+    
+    return mode;
+}
+
+/**
+ * @brief Get time scale value in seconds per division
+ */
+float osc_core_get_time_per_div(osc_time_scale_t time_scale)
+{
+    if (time_scale >= OSC_TIME_MAX) return 0.0f;
+    return time_scale_table[time_scale];
+}
+
+/**
+ * @brief Get voltage scale value in volts per division
+ */
+float osc_core_get_volts_per_div(osc_volt_scale_t volt_scale)
+{
+    if (volt_scale >= OSC_VOLT_MAX) return 0.0f;
+    return volt_scale_table[volt_scale];
+}
+
+/**
+ * @brief Get time scale string representation
+ */
+const char *osc_core_get_time_scale_str(osc_time_scale_t time_scale)
+{
+    if (time_scale >= OSC_TIME_MAX) return "???";
+    return time_scale_strings[time_scale];
+}
+
+/**
+ * @brief Get voltage scale string representation
+ */
+const char *osc_core_get_volt_scale_str(osc_volt_scale_t volt_scale)
+{
+    if (volt_scale >= OSC_VOLT_MAX) return "???";
+    return volt_scale_strings[volt_scale];
+}
+
+/**
+ * @brief Capture a burst of the latest samples at the given rate
+ *
+ * Switches the ADC to sample_rate in place (the buffer starts over) and polls
+ * until max_points samples are buffered or timeout_ms elapses. Must be called
+ * without holding ctx->mutex.
+ *
+ * @return Number of samples copied to buffer (0 on failure)
+ */
+static uint32_t auto_burst_capture(osc_core_ctx_t *ctx, osc_sample_rate_t sample_rate,
+                                   float *buffer, uint32_t max_points, uint32_t timeout_ms,
+                                   float *sample_rate_hz)
+{
+    if (osc_adc_set_sample_rate(ctx->adc_ctx, sample_rate) != ESP_OK) return 0;
+    *sample_rate_hz = (float)osc_adc_get_sample_rate_hz(ctx->adc_ctx);
+
+    uint32_t count = 0;
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    do {
+        vTaskDelay(pdMS_TO_TICKS(2));
+        if (osc_adc_get_data(ctx->adc_ctx, buffer, max_points, &count) != ESP_OK) count = 0;
+    } while (count < max_points && esp_timer_get_time() < deadline);
+
+    return count;
+}
+
+/**
+ * @brief Perform auto-adjust from one histogram + autocorrelation analysis
+ */
+esp_err_t osc_core_auto_adjust(osc_core_ctx_t *ctx, osc_auto_result_t *result)
+{
+    if (ctx == NULL) return ESP_ERR_INVALID_ARG;
+    
+    int64_t t_start = esp_timer_get_time();
+    osc_autoset_analysis_t analysis = {0};
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    bool running = (ctx->state == OSC_STATE_RUNNING);
+    if (running) {
+        // Bursts change the sample rate under a deep record
+        end_deep_capture(ctx, false);
+    }
+    osc_time_scale_t old_time_scale = ctx->time_scale;
+    osc_trigger_config_t free_run = ctx->trigger;
+    xSemaphoreGive(ctx->mutex);
+    
+    if (running) {
+        // Burst captures: full rate for detail, then a slower one for periods the first cannot hold
+        uint32_t depth = osc_adc_get_storage_depth(ctx->adc_ctx);
+        uint32_t max_points = (depth < OSC_AUTO_BURST_POINTS) ? depth : OSC_AUTO_BURST_POINTS;
+        float *burst = heap_caps_malloc(max_points * sizeof(float), MALLOC_CAP_SPIRAM);
+        if (burst == NULL) return ESP_ERR_NO_MEM;
+        
+        // Bursts must not wait for a (possibly never matching) trigger
+        free_run.enabled = false;
+        osc_adc_set_trigger(ctx->adc_ctx, &free_run);
+        
+        static const osc_sample_rate_t burst_rates[] = { OSC_SAMPLE_RATE_1MSPS, OSC_SAMPLE_RATE_100KSPS };
+        static const uint32_t burst_timeout_ms[] = { 30, 90 };
+        for (int i = 0; i < 2; i++) {
+            float rate_hz = 0.0f;
+            uint32_t count = auto_burst_capture(ctx, burst_rates[i], burst, max_points,
+                                                burst_timeout_ms[i], &rate_hz);
+            osc_autoset_analysis_t pass;
+            if (count == 0 || osc_autoset_analyze(burst, count, rate_hz, &pass) != ESP_OK) continue;
             
-            ESP_LOGI(TAG, "Auto-adjust: Freq≈%.1fHz, T/div=%s", 
-                     estimated_freq, time_scale_strings[best_time_scale]);
+            analysis = pass;
+            ret = ESP_OK;
+            if (pass.signal != OSC_AUTOSET_SIGNAL_NOISE) break;
+        }
+        heap_caps_free(burst);
+        
+        if (ret != ESP_OK) {
+            // Restore the acquisition rate and trigger of the unchanged settings
+            osc_adc_set_sample_rate(ctx->adc_ctx, get_sample_rate_for_time_scale(old_time_scale));
+            osc_adc_set_trigger(ctx->adc_ctx, &ctx->trigger);
         }
+    } else {
+        xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+        osc_waveform_t *waveform = ctx->has_frozen_data ? &ctx->frozen_waveform : &ctx->captured_waveform;
+        if (waveform->num_points > 0 && waveform->time_per_sample > 0.0f) {
+            ret = osc_autoset_analyze(waveform->voltage_data, waveform->num_points,
+                                      1.0f / waveform->time_per_sample, &analysis);
+        }
+        xSemaphoreGive(ctx->mutex);
     }
     
-    // Auto-adjust Y offset to center signal on screen
-    // The signal center should be at 0V (screen center)
-    // Y_offset shifts the waveform: positive offset moves waveform up
-    // To center signal at vcenter, we need: y_offset = -vcenter
-    ctx->y_offset = -vcenter;
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "No waveform data for auto-adjust");
+        return ret;
+    }
     
-    // Reset X offset to center on trigger
+    // Vertical: DC stays at true level, anything else is centered and fills ~7 of 9 divisions
+    float volts_per_div;
+    float y_offset;
+    float trigger_level;
+    if (analysis.signal == OSC_AUTOSET_SIGNAL_DC) {
+        volts_per_div = fabsf(analysis.mean) / (OSC_GRID_ROWS / 2 - 0.5f);
+        y_offset = 0.0f;
+        trigger_level = analysis.mean;
+    } else {
+        volts_per_div = (analysis.vmax - analysis.vmin) / (OSC_GRID_ROWS - 2);
+        y_offset = -(analysis.vmax + analysis.vmin) / 2.0f;
+        trigger_level = (analysis.top + analysis.base) / 2.0f;
+    }
+    osc_volt_scale_t volt_scale = (osc_volt_scale_t)osc_autoset_pick_scale(volt_scale_table, OSC_VOLT_MAX, volts_per_div);
+    
+    // Horizontal: three periods across the screen; no ROLL scales
+    float time_per_div = time_scale_table[old_time_scale];
+    osc_time_scale_t time_scale = old_time_scale;
+    if (analysis.signal == OSC_AUTOSET_SIGNAL_PERIODIC) {
+        time_per_div = 3.0f / (analysis.frequency_hz * OSC_GRID_COLS);
+        time_scale = (osc_time_scale_t)osc_autoset_pick_scale(time_scale_table, OSC_TIME_200MS, time_per_div);
+    }
+    
+    // Apply everything in one step
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->time_scale = time_scale;
+    ctx->mode = (time_scale >= OSC_TIME_200MS) ? OSC_MODE_ROLL : OSC_MODE_NORMAL;
+    ctx->volt_scale = volt_scale;
+    ctx->y_offset = y_offset;
     ctx->x_offset = 0.0f;
+    ctx->trigger.level_voltage = trigger_level;
+    osc_adc_set_trigger(ctx->adc_ctx, &ctx->trigger);
+    if (ctx->state == OSC_STATE_RUNNING) {
+        osc_adc_set_sample_rate(ctx->adc_ctx, get_sample_rate_for_time_scale(time_scale));
+    }
+    ctx->measurements_valid = false;
+    xSemaphoreGive(ctx->mutex);
     
-    ESP_LOGI(TAG, "Auto-adjust complete: V/div=%s, Vpp=%.2fV, Vcenter=%.2fV, Y-offset=%.2fV", 
-             volt_scale_strings[ctx->volt_scale], vpp, vcenter, ctx->y_offset);
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - t_start);
+    
+    ESP_LOGI(TAG, "Auto-adjust: %s, f=%.1fHz, top=%.3fV, base=%.3fV -> T/div=%s, V/div=%s, trig=%.3fV (%lu us)",
+             osc_autoset_get_signal_str(analysis.signal), analysis.frequency_hz, analysis.top, analysis.base,
+             time_scale_strings[time_scale], volt_scale_strings[volt_scale], trigger_level, elapsed_us);
+    
+    if (result != NULL) {
+        result->analysis = analysis;
+        result->time_scale = time_scale;
+        result->volt_scale = volt_scale;
+        result->time_per_div = time_per_div;
+        result->volts_per_div = volts_per_div;
+        result->y_offset = y_offset;
+        result->trigger_level = trigger_level;
+        result->elapsed_us = elapsed_us;
+    }
     
-    xSemaphoreGive(ctx->mutex);
     return ESP_OK;
 }
 
@@ -873,8 +1804,18 @@ esp_err_t osc_core_get_measurements(osc_core_ctx_t *ctx, float *freq_hz, float *
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
     
-    // Recalculate measurements if not valid
-    if (!ctx->measurements_valid) {
+    if (ctx->deep_shown) {
+        // Deep record: measure the visible window, again whenever it moves
+        uint32_t start_idx;
+        float sample_step;
+        get_deep_window(ctx, &start_idx, &sample_step);
+        uint32_t count = (uint32_t)(sample_step * OSC_DISPLAY_WIDTH + 0.5f);
+        if (count == 0) count = 1;
+        if (!ctx->measurements_valid || start_idx != ctx->deep_meas_start || count != ctx->deep_meas_count) {
+            calculate_deep_measurements(ctx, start_idx, count);
+        }
+    } else if (!ctx->measurements_valid) {
+        // Recalculate measurements if not valid
         osc_waveform_t *waveform = (ctx->state == OSC_STATE_STOPPED && ctx->has_frozen_data) ?
                                     &ctx->frozen_waveform : &ctx->captured_waveform;
         calculate_measurements(ctx, waveform);
@@ -893,6 +1834,120 @@ esp_err_t osc_core_get_measurements(osc_core_ctx_t *ctx, float *freq_hz, float *
     return ctx->measurements_valid ? ESP_OK : ESP_ERR_NOT_FOUND;
 }
 
+/* Wavefile source: the shown deep record, valid while its generation holds */
+typedef struct {
+    osc_deepmem_t *deep;
+    uint32_t generation;
+} deep_source_t;
+
+/**
+ * @brief Wavefile source: deep record
+ */
+static esp_err_t read_deep_samples(void *user, uint32_t start, uint32_t count, float *volts)
+{
+    deep_source_t *src = (deep_source_t *)user;
+    esp_err_t ret = osc_deepmem_read(src->deep, start, count, volts);
+    // Reads are atomic under the record lock; a new capture since then bumps the generation
+    if (ret == ESP_OK && osc_deepmem_get_generation(src->deep) != src->generation) {
+        ESP_LOGW(TAG, "Deep record replaced while saving");
+        ret = ESP_ERR_INVALID_STATE;
+    }
+    return ret;
+}
+
+/**
+ * @brief Wavefile source: snapshot of a capture
+ */
+static esp_err_t read_snapshot_samples(void *user, uint32_t start, uint32_t count, float *volts)
+{
+    memcpy(volts, (const float *)user + start, count * sizeof(float));
+    return ESP_OK;
+}
+
+/**
+ * @brief Release a wavefile source (deep source or snapshot)
+ */
+static void release_wavefile_source(void *user)
+{
+    heap_caps_free(user);
+}
+
+/**
+ * @brief Queue the whole record as a binary waveform file
+ */
+esp_err_t osc_core_save_wavefile(osc_core_ctx_t *ctx, const char *path, const char *timestamp,
+                                 storage_writer_progress_cb on_progress, storage_writer_done_cb on_done,
+                                 void *cb_user)
+{
+    if (ctx == NULL || path == NULL) return ESP_ERR_INVALID_ARG;
+    
+    float freq = 0.0f, vmax = 0.0f, vmin = 0.0f, vpp = 0.0f, vrms = 0.0f;
+    osc_core_get_measurements(ctx, &freq, &vmax, &vmin, &vpp, &vrms);
+    
+    float volts_offset = osc_adc_raw_to_voltage(0);
+    osc_wavefile_header_t header;
+    osc_wavefile_init_header(&header, (osc_adc_raw_to_voltage(4095) - volts_offset) / 4095.0f);
+    header.volts_offset = volts_offset;
+    header.frequency = freq;
+    header.vmax = vmax;
+    header.vmin = vmin;
+    header.vpp = vpp;
+    header.vrms = vrms;
+    if (timestamp != NULL) {
+        strncpy(header.timestamp, timestamp, sizeof(header.timestamp) - 1);
+    }
+    
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    
+    header.time_per_div = time_scale_table[ctx->time_scale];
+    header.volts_per_div = volt_scale_table[ctx->volt_scale];
+    
+    // Deep record is immutable once shown and guarded by its own lock
+    if (ctx->deep_shown) {
+        deep_source_t *src = heap_caps_malloc(sizeof(deep_source_t), MALLOC_CAP_DEFAULT);
+        if (src == NULL) {
+            xSemaphoreGive(ctx->mutex);
+            return ESP_ERR_NO_MEM;
+        }
+        src->deep = ctx->deep;
+        src->generation = osc_deepmem_get_generation(ctx->deep);
+        header.num_samples = osc_deepmem_get_length(ctx->deep);
+        header.sample_rate = 1.0 / osc_deepmem_get_time_per_sample(ctx->deep);
+        header.flags = OSC_WAVEFILE_FLAG_DEEP;
+        xSemaphoreGive(ctx->mutex);
+        
+        esp_err_t ret = osc_wavefile_write_async(path, &header, read_deep_samples, release_wavefile_source,
+                                                 src, on_progress, on_done, cb_user);
+        if (ret != ESP_OK) heap_caps_free(src);
+        return ret;
+    }
+    
+    osc_waveform_t *waveform = get_active_waveform(ctx);
+    if (waveform->num_points == 0 || waveform->time_per_sample <= 0.0f) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    
+    float *snapshot = heap_caps_malloc(waveform->num_points * sizeof(float), MALLOC_CAP_SPIRAM);
+    if (snapshot == NULL) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(snapshot, waveform->voltage_data, waveform->num_points * sizeof(float));
+    header.num_samples = waveform->num_points;
+    header.sample_rate = 1.0 / waveform->time_per_sample;
+    header.trigger_index = waveform->trigger_position;
+    if (ctx->trigger.enabled) header.flags |= OSC_WAVEFILE_FLAG_TRIGGERED;
+    if (ctx->coupling == OSC_COUPLING_AC || ctx->num_user_filters > 0) header.flags |= OSC_WAVEFILE_FLAG_FILTERED;
+    
+    xSemaphoreGive(ctx->mutex);
+    
+    esp_err_t ret = osc_wavefile_write_async(path, &header, read_snapshot_samples, release_wavefile_source,
+                                             snapshot, on_progress, on_done, cb_user);
+    if (ret != ESP_OK) heap_caps_free(snapshot);
+    return ret;
+}
+
 /**
  * @brief Update oscilloscope (call periodically)
  */
@@ -915,6 +1970,12 @@ esp_err_t osc_core_update(osc_core_ctx_t *ctx)
         return ESP_OK;
     }
     
+    // Deep record full (the ADC detached it): stop on it
+    if (ctx->deep_recording && !osc_adc_is_deep_recording(ctx->adc_ctx)) {
+        ESP_LOGI(TAG, "Deep capture complete, stopping");
+        return osc_core_stop(ctx);
+    }
+    
     // Check for new ADC data
     bool has_data = osc_adc_has_new_data(ctx->adc_ctx);
     if (update_call_count <= 5 || update_call_count % 100 == 0) {
@@ -929,7 +1990,14 @@ esp_err_t osc_core_update(osc_core_ctx_t *ctx)
     
     xSemaphoreTake(ctx->mutex, portMAX_DELAY);
     
+    // A remote transfer reads the capture in place: keep it until released
+    if (ctx->captured_pins > 0) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_OK;
+    }
+    
     // Get new data from ADC
+    bool stop_on_fail = false;
     uint32_t actual_count = 0;
     esp_err_t ret = osc_adc_get_data(ctx->adc_ctx, ctx->captured_waveform.voltage_data,
                                       ctx->captured_waveform.storage_depth, &actual_count);
@@ -937,13 +2005,40 @@ esp_err_t osc_core_update(osc_core_ctx_t *ctx)
     if (ret == ESP_OK && actual_count > 0) {
         ctx->captured_waveform.num_points = actual_count;
         ctx->captured_waveform.time_per_sample = 1.0f / osc_adc_get_sample_rate_hz(ctx->adc_ctx);
-        ctx->captured_waveform.trigger_position = actual_count / 2;  // Assume trigger at center
+        ctx->captured_waveform.trigger_position = osc_adc_get_trigger_position(ctx->adc_ctx);
         ctx->captured_waveform.time_scale = ctx->time_scale;
         ctx->captured_waveform.volt_scale = ctx->volt_scale;
+        ctx->captured_waveform.generation++;
         
         // Invalidate measurements (will be recalculated on next request)
         ctx->measurements_valid = false;
         
+        // Mask test over the visible window of the new capture
+        if (osc_mask_is_enabled(ctx->mask)) {
+            uint32_t start_idx;
+            float sample_step;
+            osc_mask_result_t result;
+            get_display_window(ctx, &ctx->captured_waveform, &start_idx, &sample_step);
+            if (osc_mask_check(ctx->mask, ctx->captured_waveform.voltage_data, actual_count,
+                               start_idx, sample_step, &result) == ESP_OK &&
+                !result.pass && ctx->mask_stop_on_fail) {
+                stop_on_fail = true;
+            }
+        }
+        
+        // Histogram of the visible window, eye diagram over the whole capture
+        if (osc_hist_is_enabled(ctx->hist)) {
+            uint32_t start_idx;
+            float sample_step;
+            get_display_window(ctx, &ctx->captured_waveform, &start_idx, &sample_step);
+            osc_hist_accumulate(ctx->hist, &ctx->captured_waveform.voltage_data[start_idx],
+                                get_visible_count(&ctx->captured_waveform, start_idx, sample_step));
+        }
+        if (osc_eye_is_enabled(ctx->eye)) {
+            osc_eye_accumulate(ctx->eye, ctx->captured_waveform.voltage_data, actual_count,
+                               ctx->captured_waveform.time_per_sample);
+        }
+        
         ESP_LOGI("OscCore", "Captured %lu samples, time_per_sample=%.6f us", 
                  actual_count, ctx->captured_waveform.time_per_sample * 1e6f);
     } else {
@@ -951,5 +2046,11 @@ esp_err_t osc_core_update(osc_core_ctx_t *ctx)
     }
     
     xSemaphoreGive(ctx->mutex);
+    
+    // Freeze the failing capture so it stays on screen
+    if (stop_on_fail) {
+        ESP_LOGW(TAG, "Mask test failed, stopping");
+        osc_core_stop(ctx);
+    }
     return ret;
 }
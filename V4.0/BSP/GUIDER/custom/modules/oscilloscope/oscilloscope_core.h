@@ -14,6 +14,17 @@
 
 #include "esp_err.h"
 #include "oscilloscope_adc.h"
+#include "oscilloscope_math.h"
+#include "oscilloscope_decode.h"
+#include "oscilloscope_mask.h"
+#include "oscilloscope_autoset.h"
+#include "oscilloscope_search.h"
+#include "oscilloscope_ref.h"
+#include "oscilloscope_hist.h"
+#include "oscilloscope_eye.h"
+#include "oscilloscope_deepmem.h"
+#include "oscilloscope_recorder.h"
+#include "storage_writer.h"
 #include <stdint.h>
 #include <stdbool.h>
 
@@ -90,6 +101,21 @@ typedef enum {
     OSC_STATE_WAITING,      // Waiting for trigger
 } osc_state_t;
 
+/* Pinned capture (see osc_core_pin_waveform) */
+typedef struct {
+    const float *volts;             // Samples in volts (before the Y offset)
+    uint32_t num_points;
+    float time_per_sample;          // Seconds
+    uint32_t trigger_index;         // Sample at the trigger point
+    uint32_t generation;            // Capture generation
+} osc_waveform_view_t;
+
+/* Input coupling */
+typedef enum {
+    OSC_COUPLING_DC = 0,    // DC coupling (unfiltered)
+    OSC_COUPLING_AC,        // AC coupling (DC-block filter in the acquisition path)
+} osc_coupling_t;
+
 /* Waveform data structure */
 typedef struct {
     float *voltage_data;            // Voltage samples
@@ -99,8 +125,30 @@ typedef struct {
     uint32_t trigger_position;      // Trigger position in buffer
     osc_time_scale_t time_scale;    // Time scale when captured
     osc_volt_scale_t volt_scale;    // Voltage scale when captured
+    uint32_t generation;            // Capture generation (bumped on every new capture)
 } osc_waveform_t;
 
+/* Deep capture status */
+typedef struct {
+    bool recording;                 // Raw stream is being recorded
+    bool shown;                     // Stopped on a deep record (display, measurements and search use it)
+    uint32_t depth;                 // Requested record length (points)
+    uint32_t length;                // Points recorded so far
+    float time_per_sample;          // Sample interval of the record (seconds)
+} osc_deep_status_t;
+
+/* AUTO set-up result */
+typedef struct {
+    osc_autoset_analysis_t analysis;    // Signal analysis of the burst capture
+    osc_time_scale_t time_scale;        // Applied time scale
+    osc_volt_scale_t volt_scale;        // Applied voltage scale
+    float time_per_div;                 // Exact wanted seconds/div (before rounding to the table)
+    float volts_per_div;                // Exact wanted volts/div (before rounding to the table)
+    float y_offset;                     // Applied vertical offset (volts)
+    float trigger_level;                // Applied trigger level (volts)
+    uint32_t elapsed_us;                // Capture + analysis time
+} osc_auto_result_t;
+
 /* Oscilloscope core context */
 typedef struct osc_core_ctx_t osc_core_ctx_t;
 
@@ -129,6 +177,9 @@ esp_err_t osc_core_start(osc_core_ctx_t *ctx);
 /**
  * @brief Stop oscilloscope (STOP mode - freeze current waveform)
  * 
+ * While recording, the ADC keeps running and the recording goes on; only
+ * the display freezes. The ADC stops when the recording ends.
+ * 
  * @param ctx Core context
  * @return ESP_OK on success
  */
@@ -181,6 +232,36 @@ esp_err_t osc_core_set_y_offset(osc_core_ctx_t *ctx, float offset_volts);
  */
 esp_err_t osc_core_set_trigger(osc_core_ctx_t *ctx, const osc_trigger_config_t *trigger);
 
+/**
+ * @brief Set input coupling
+ * 
+ * AC coupling inserts a DC-block stage (OSC_FILTER_AC_CUTOFF_HZ) in front of
+ * the user filter chain.
+ * 
+ * @param ctx Core context
+ * @param coupling DC or AC
+ * @return ESP_OK on success
+ */
+esp_err_t osc_core_set_coupling(osc_core_ctx_t *ctx, osc_coupling_t coupling);
+
+/**
+ * @brief Get input coupling
+ * 
+ * @param ctx Core context
+ * @return Current coupling
+ */
+osc_coupling_t osc_core_get_coupling(osc_core_ctx_t *ctx);
+
+/**
+ * @brief Set user filter chain (LPF/HPF/notch/FIR) applied during acquisition
+ * 
+ * @param ctx Core context
+ * @param stages Filter stages (NULL / 0 = no filtering)
+ * @param num_stages Number of stages (max OSC_FILTER_MAX_STAGES - 1, one slot is kept for AC coupling)
+ * @return ESP_OK on success
+ */
+esp_err_t osc_core_set_filter(osc_core_ctx_t *ctx, const osc_filter_stage_config_t *stages, uint8_t num_stages);
+
 /**
  * @brief Get current waveform for display
  * 
@@ -194,6 +275,289 @@ esp_err_t osc_core_set_trigger(osc_core_ctx_t *ctx, const osc_trigger_config_t *
  */
 esp_err_t osc_core_get_display_waveform(osc_core_ctx_t *ctx, float *display_buffer, uint32_t *actual_count);
 
+/**
+ * @brief Get MATH trace for display
+ *
+ * Evaluates the compiled MATH expression over the same visible window as
+ * osc_core_get_display_waveform(). Results are cached by the MATH engine per
+ * capture generation, so redraws and panning in STOP mode only evaluate the
+ * samples on screen.
+ *
+ * @param ctx Core context
+ * @param math MATH engine context
+ * @param display_buffer Output buffer for display points (OSC_DISPLAY_WIDTH points)
+ * @param actual_count Actual number of points returned
+ * @param info Output: evaluation details (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no MATH expression is set
+ */
+esp_err_t osc_core_get_math_waveform(osc_core_ctx_t *ctx, osc_math_ctx_t *math, float *display_buffer,
+                                     uint32_t *actual_count, osc_math_info_t *info);
+
+/**
+ * @brief Get capture generation of the waveform currently displayed
+ *
+ * @param ctx Core context
+ * @return Generation counter (changes whenever new data is captured)
+ */
+uint32_t osc_core_get_capture_generation(osc_core_ctx_t *ctx);
+
+/**
+ * @brief Attach a mask tester (checked on every new capture)
+ *
+ * @param ctx Core context
+ * @param mask Mask context (NULL detaches)
+ * @param stop_on_fail Stop acquisition on the first failing capture
+ * @return ESP_OK on success
+ */
+esp_err_t osc_core_set_mask(osc_core_ctx_t *ctx, osc_mask_ctx_t *mask, bool stop_on_fail);
+
+/**
+ * @brief Build a mask from the displayed waveform
+ *
+ * The mask covers the visible window, one column per display pixel.
+ *
+ * @param ctx Core context
+ * @param mask Mask context
+ * @param tol_x_div Horizontal tolerance in divisions
+ * @param tol_y_v Vertical tolerance in volts
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no waveform is captured
+ */
+esp_err_t osc_core_create_mask(osc_core_ctx_t *ctx, osc_mask_ctx_t *mask, float tol_x_div, float tol_y_v);
+
+/**
+ * @brief Attach the histogram and eye accumulators (fed on every new capture)
+ *
+ * The histogram bins the visible window, the eye folds the whole capture.
+ * Each is only fed while enabled.
+ *
+ * @param ctx Core context
+ * @param hist Histogram context (NULL detaches)
+ * @param eye Eye context (NULL detaches)
+ * @return ESP_OK on success
+ */
+esp_err_t osc_core_set_analysis(osc_core_ctx_t *ctx, osc_hist_ctx_t *hist, osc_eye_ctx_t *eye);
+
+/**
+ * @brief Re-bin the histogram from the visible window of the displayed waveform
+ *
+ * For STOP mode, where no captures arrive: clears the counts and bins the
+ * current window once.
+ *
+ * @param ctx Core context
+ * @param hist Histogram context
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no waveform is captured
+ */
+esp_err_t osc_core_update_histogram(osc_core_ctx_t *ctx, osc_hist_ctx_t *hist);
+
+/**
+ * @brief Store the visible window of the displayed waveform in a reference slot
+ *
+ * The slot keeps the current time and volt scales so it can be re-projected later.
+ *
+ * @param ctx Core context
+ * @param ref Reference context
+ * @param slot Slot (0 = REF A)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no waveform is captured
+ */
+esp_err_t osc_core_store_ref(osc_core_ctx_t *ctx, osc_ref_ctx_t *ref, uint8_t slot);
+
+/**
+ * @brief Attach deep memory (NULL detaches)
+ *
+ * @param ctx Core context
+ * @param deep Deep memory context
+ * @return ESP_OK on success
+ */
+esp_err_t osc_core_set_deep_memory(osc_core_ctx_t *ctx, osc_deepmem_t *deep);
+
+/**
+ * @brief Start a deep capture
+ *
+ * The raw sample stream is recorded next to normal acquisition at the current
+ * sample rate. When depth points are stored the core stops on the record;
+ * stopping earlier keeps what was recorded so far. While stopped on a deep
+ * record, the display waveform (min/max envelope), measurements, preview and
+ * search use it, with time zero at the middle of the record. Changing the
+ * time scale or AUTO while recording cancels the capture.
+ *
+ * @param ctx Core context
+ * @param depth Record length in points
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running or no deep
+ *         memory is attached, ESP_ERR_INVALID_SIZE if depth exceeds the pool
+ */
+esp_err_t osc_core_start_deep_capture(osc_core_ctx_t *ctx, uint32_t depth);
+
+/**
+ * @brief Cancel a deep capture in progress (the record is discarded)
+ *
+ * @param ctx Core context
+ */
+void osc_core_cancel_deep_capture(osc_core_ctx_t *ctx);
+
+/**
+ * @brief Get deep capture status
+ *
+ * @param ctx Core context
+ * @param status Output: status
+ * @return ESP_OK on success
+ */
+esp_err_t osc_core_get_deep_status(osc_core_ctx_t *ctx, osc_deep_status_t *status);
+
+/**
+ * @brief Pin the displayed capture for reading in place (remote transfer)
+ *
+ * While a capture is pinned its buffer is not rewritten: the running scope
+ * holds the last capture on screen. STOP while the frozen record is pinned
+ * shows the new capture at once and copies it into the frozen record when
+ * the last pin is released, so nothing shows or serves the old one as new.
+ * Each successful pin must be undone with osc_core_unpin_waveform().
+ *
+ * @param ctx Core context
+ * @param view Output: samples and timing of the capture
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if nothing was captured,
+ *         ESP_ERR_NOT_SUPPORTED while a deep record is shown
+ */
+esp_err_t osc_core_pin_waveform(osc_core_ctx_t *ctx, osc_waveform_view_t *view);
+
+/**
+ * @brief Release a capture pinned by osc_core_pin_waveform()
+ *
+ * @param ctx Core context
+ * @param view View returned by the pin
+ */
+void osc_core_unpin_waveform(osc_core_ctx_t *ctx, const osc_waveform_view_t *view);
+
+/**
+ * @brief Start streaming the raw acquisition to SD card
+ *
+ * Every acquired block is copied into the recorder's pool next to normal
+ * acquisition; the display is unaffected and a slow card drops blocks
+ * instead of stalling the ADC. A time scale change starts a new segment at
+ * the new rate. STOP freezes the display only; the recording runs until
+ * osc_core_stop_recording() or a write error.
+ *
+ * @param ctx Core context
+ * @param recorder Recorder (idle)
+ * @param base_path Segment path without extension
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running or already recording
+ */
+esp_err_t osc_core_start_recording(osc_core_ctx_t *ctx, osc_recorder_ctx_t *recorder, const char *base_path);
+
+/**
+ * @brief Stop streaming to SD card (the recorder writes out its backlog in the background)
+ *
+ * @param ctx Core context
+ */
+void osc_core_stop_recording(osc_core_ctx_t *ctx);
+
+/**
+ * @brief Check if the raw acquisition is being recorded
+ *
+ * @param ctx Core context
+ * @return true between osc_core_start_recording() and its stop
+ */
+bool osc_core_is_recording(osc_core_ctx_t *ctx);
+
+/**
+ * @brief Select the acquisition rate for external captures (Bode sweep)
+ * 
+ * Picks the fastest sampling tier in [min_rate, max_rate], else the slowest
+ * one above min_rate, else the fastest tier. Acquisition runs free (trigger
+ * off) and a deep capture in progress is cancelled; the display keeps
+ * showing the live signal. osc_core_end_acquire() restores the settings.
+ * Must not be called from the LVGL task (a rate change restarts the ADC).
+ * 
+ * @param ctx Core context
+ * @param min_rate Lowest acceptable rate (Hz)
+ * @param max_rate Highest wanted rate (Hz)
+ * @return Selected rate in Hz, 0 if the scope is not running
+ */
+float osc_core_set_acquire_rate(osc_core_ctx_t *ctx, float min_rate, float max_rate);
+
+/**
+ * @brief Get the longest capture osc_core_acquire() accepts
+ * 
+ * @param ctx Core context
+ * @return Storage depth in samples, 0 on error
+ */
+uint32_t osc_core_get_acquire_depth(osc_core_ctx_t *ctx);
+
+/**
+ * @brief Capture the next samples at the acquisition rate
+ * 
+ * Blocks until count samples acquired after the call are available.
+ * 
+ * @param ctx Core context
+ * @param buffer Output: count voltages
+ * @param count Number of samples (<= storage depth)
+ * @param timeout_ms Extra time allowed beyond the capture duration
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not running,
+ *         ESP_ERR_INVALID_SIZE if count exceeds the storage depth,
+ *         ESP_ERR_TIMEOUT if the samples did not arrive in time
+ */
+esp_err_t osc_core_acquire(osc_core_ctx_t *ctx, float *buffer, uint32_t count, uint32_t timeout_ms);
+
+/**
+ * @brief Restore trigger and sample rate after external captures
+ * 
+ * @param ctx Core context
+ */
+void osc_core_end_acquire(osc_core_ctx_t *ctx);
+
+/**
+ * @brief Get the visible window of the displayed waveform
+ *
+ * Display point i shows record sample start_idx + i * sample_step.
+ *
+ * @param ctx Core context
+ * @param start_idx Output: first visible sample
+ * @param sample_step Output: samples per display point
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no waveform is captured
+ */
+esp_err_t osc_core_get_display_window(osc_core_ctx_t *ctx, uint32_t *start_idx, float *sample_step);
+
+/**
+ * @brief Run the protocol decoder over the next slice of the displayed waveform
+ *
+ * A new capture restarts decoding: in STOP mode from the first sample (the
+ * whole record is decoded over successive calls), while running from two
+ * divisions before the visible window, since the record is replaced on the next capture.
+ *
+ * @param ctx Core context
+ * @param decoder Decoder context
+ * @param max_samples Sample budget for this call
+ * @param complete Output: displayed waveform fully decoded (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no waveform is captured
+ */
+esp_err_t osc_core_decode_step(osc_core_ctx_t *ctx, osc_decode_ctx_t *decoder,
+                               uint32_t max_samples, bool *complete);
+
+/**
+ * @brief Search the stopped record for events and rebuild the search index
+ *
+ * Uses the same criteria as the trigger. The min/max pyramid of the record
+ * is built on the first search of a capture and reused until the next one.
+ *
+ * @param ctx Core context
+ * @param search Search context
+ * @param criteria Event criteria
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if not stopped,
+ *         ESP_ERR_NOT_FOUND if no waveform is captured
+ */
+esp_err_t osc_core_search(osc_core_ctx_t *ctx, osc_search_ctx_t *search, const osc_trigger_config_t *criteria);
+
+/**
+ * @brief Get time of a record sample relative to the trigger point
+ *
+ * Passing the result to osc_core_set_x_offset() centers the sample on screen.
+ *
+ * @param ctx Core context
+ * @param sample Sample index in the displayed record
+ * @param time_seconds Output: time in seconds (negative before the trigger)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no waveform is captured
+ */
+esp_err_t osc_core_get_sample_time(osc_core_ctx_t *ctx, uint32_t sample, float *time_seconds);
+
 /**
  * @brief Get preview waveform (complete captured data overview)
  * 
@@ -272,13 +636,17 @@ const char *osc_core_get_volt_scale_str(osc_volt_scale_t volt_scale);
 /**
  * @brief Perform auto-adjust (AUTO button)
  * 
- * Automatically adjusts time scale, voltage scale, and offsets
- * to optimally display the current signal.
+ * Takes one short full-rate burst capture (plus a slower one if no period
+ * is found), derives top/base levels from its amplitude histogram and the
+ * fundamental period from its autocorrelation, then sets time scale,
+ * voltage scale, offsets and trigger level in a single step.
+ * When stopped, the frozen waveform is analyzed instead.
  * 
  * @param ctx Core context
- * @return ESP_OK on success
+ * @param result Output: what was found and applied (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no data could be captured
  */
-esp_err_t osc_core_auto_adjust(osc_core_ctx_t *ctx);
+esp_err_t osc_core_auto_adjust(osc_core_ctx_t *ctx, osc_auto_result_t *result);
 
 /**
  * @brief Get waveform measurements
@@ -293,6 +661,28 @@ esp_err_t osc_core_auto_adjust(osc_core_ctx_t *ctx);
  */
 esp_err_t osc_core_get_measurements(osc_core_ctx_t *ctx, float *freq_hz, float *vmax, float *vmin, float *vpp, float *vrms);
 
+/**
+ * @brief Save the whole record (not just the screen) as a binary waveform file
+ * 
+ * Saves the shown deep record, else the frozen record in STOP or the latest
+ * capture in RUN. The live record is snapshotted first, so acquisition is
+ * not held up by the SD card; the file itself is written by the storage
+ * writer. A deep save fails with ESP_ERR_INVALID_STATE if a new deep capture
+ * replaces the record before it is written. The core must outlive the job
+ * (see storage_writer_flush()).
+ * 
+ * @param ctx Core context
+ * @param path File path (.osw; a .json sidecar is written next to it)
+ * @param timestamp Capture time text stored in the header (may be NULL)
+ * @param on_progress Progress callback on the LVGL thread (may be NULL)
+ * @param on_done Completion callback on the LVGL thread (may be NULL)
+ * @param cb_user Callback context
+ * @return ESP_OK if queued, ESP_ERR_NOT_FOUND if nothing was captured
+ */
+esp_err_t osc_core_save_wavefile(osc_core_ctx_t *ctx, const char *path, const char *timestamp,
+                                 storage_writer_progress_cb on_progress, storage_writer_done_cb on_done,
+                                 void *cb_user);
+
 /**
  * @brief Update oscilloscope (call periodically from timer)
  * 
@@ -0,0 +1,569 @@
+/**
+ * @file oscilloscope_decode.c
+ * @brief Serial protocol decoder implementation
+ */
+
+#include "oscilloscope_decode.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "OscDecode";
+
+/* UART frame phases */
+typedef enum {
+    UART_PHASE_IDLE = 0,        // Waiting for a mark -> space edge
+    UART_PHASE_START,           // Start bit (verified at its centre)
+    UART_PHASE_DATA,
+    UART_PHASE_PARITY,
+    UART_PHASE_STOP,
+} uart_phase_t;
+
+/* UART state machine */
+typedef struct {
+    uart_phase_t phase;
+    uint8_t prev_level;             // Logical level of the previous sample (1 = mark)
+    uint32_t frame_start;           // Sample index of the start edge
+    float next_offset;              // Next bit centre, in samples after frame_start
+    float samples_per_bit;
+    uint8_t bit_index;
+    uint16_t value;
+    uint8_t ones;                   // Data + parity ones (for the parity check)
+    uint8_t flags;
+    bool all_low;                   // Every sampled bit was space (break detection)
+} uart_state_t;
+
+/* Decoder context */
+struct osc_decode_ctx_t {
+    osc_decode_config_t config;
+    const struct osc_decode_protocol_ops_t *ops;
+    float sample_rate_hz;
+    bool rate_ok;                   // Sampling rate is usable for the protocol
+
+    /* Stream position and comparator state */
+    uint32_t sample_index;          // Index of the next fed sample
+    uint8_t levels;                 // Current comparator output (one bit per channel)
+    bool levels_valid;
+
+    /* Protocol state */
+    union {
+        uart_state_t uart;
+    } state;
+
+    /* Annotation ring (PSRAM) */
+    osc_decode_annotation_t *annotations;
+    uint32_t ann_head;              // Index of the oldest annotation
+    uint32_t ann_count;
+    uint32_t ann_dropped;
+
+    /* Incremental record progress */
+    uint32_t record_generation;
+    uint32_t record_pos;
+    bool record_valid;
+
+    /* Synchronization */
+    SemaphoreHandle_t mutex;
+};
+
+/* Protocol plug-in */
+typedef struct osc_decode_protocol_ops_t {
+    const char *name;
+    uint8_t num_channels;
+    esp_err_t (*validate)(const osc_decode_config_t *config);
+    esp_err_t (*reset)(osc_decode_ctx_t *ctx);
+    void (*feed)(osc_decode_ctx_t *ctx, const uint8_t *levels, uint32_t count);
+} osc_decode_protocol_ops_t;
+
+/**
+ * @brief Append an annotation (drops the oldest when the ring is full)
+ */
+static void emit_annotation(osc_decode_ctx_t *ctx, uint32_t start, uint32_t end,
+                            uint16_t value, uint8_t flags, uint8_t kind)
+{
+    uint32_t slot;
+    if (ctx->ann_count < OSC_DECODE_MAX_ANNOTATIONS) {
+        slot = (ctx->ann_head + ctx->ann_count) % OSC_DECODE_MAX_ANNOTATIONS;
+        ctx->ann_count++;
+    } else {
+        slot = ctx->ann_head;
+        ctx->ann_head = (ctx->ann_head + 1) % OSC_DECODE_MAX_ANNOTATIONS;
+        ctx->ann_dropped++;
+    }
+
+    osc_decode_annotation_t *ann = &ctx->annotations[slot];
+    ann->start_sample = start;
+    ann->end_sample = end;
+    ann->value = value;
+    ann->flags = flags;
+    ann->kind = kind;
+}
+
+/* ==================== UART ==================== */
+
+static esp_err_t uart_validate(const osc_decode_config_t *config)
+{
+    const osc_decode_uart_config_t *uart = &config->uart;
+    if (uart->baud_rate == 0) return ESP_ERR_INVALID_ARG;
+    if (uart->data_bits < 5 || uart->data_bits > 9) return ESP_ERR_INVALID_ARG;
+    if (uart->stop_bits < 1 || uart->stop_bits > 2) return ESP_ERR_INVALID_ARG;
+    if (uart->parity > OSC_DECODE_PARITY_ODD) return ESP_ERR_INVALID_ARG;
+    return ESP_OK;
+}
+
+static esp_err_t uart_reset(osc_decode_ctx_t *ctx)
+{
+    uart_state_t *st = &ctx->state.uart;
+    memset(st, 0, sizeof(uart_state_t));
+    st->phase = UART_PHASE_IDLE;
+    st->prev_level = 0;             // A line that starts low must go idle before the first frame
+    st->samples_per_bit = ctx->sample_rate_hz / (float)ctx->config.uart.baud_rate;
+
+    if (st->samples_per_bit < OSC_DECODE_MIN_SAMPLES_PER_BIT) {
+        ESP_LOGW(TAG, "UART %lu baud needs > %.0f Sa/s (have %.0f)",
+                 ctx->config.uart.baud_rate,
+                 ctx->config.uart.baud_rate * OSC_DECODE_MIN_SAMPLES_PER_BIT, ctx->sample_rate_hz);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Handle one bit sampled at its centre
+ */
+static void uart_sample_bit(osc_decode_ctx_t *ctx, uart_state_t *st, uint8_t bit)
+{
+    const osc_decode_uart_config_t *cfg = &ctx->config.uart;
+
+    if (bit) {
+        st->all_low = false;
+    }
+
+    switch (st->phase) {
+    case UART_PHASE_START:
+        if (bit) {
+            // Glitch, not a start bit
+            st->phase = UART_PHASE_IDLE;
+            return;
+        }
+        st->phase = UART_PHASE_DATA;
+        break;
+
+    case UART_PHASE_DATA:
+        st->value |= (uint16_t)bit << st->bit_index;    // LSB first
+        st->ones += bit;
+        if (++st->bit_index >= cfg->data_bits) {
+            st->bit_index = 0;
+            st->phase = (cfg->parity != OSC_DECODE_PARITY_NONE) ? UART_PHASE_PARITY : UART_PHASE_STOP;
+        }
+        break;
+
+    case UART_PHASE_PARITY:
+        st->ones += bit;
+        if ((cfg->parity == OSC_DECODE_PARITY_EVEN && (st->ones & 1) != 0) ||
+            (cfg->parity == OSC_DECODE_PARITY_ODD && (st->ones & 1) == 0)) {
+            st->flags |= OSC_DECODE_ERR_PARITY;
+        }
+        st->phase = UART_PHASE_STOP;
+        break;
+
+    case UART_PHASE_STOP:
+        if (!bit) {
+            st->flags |= OSC_DECODE_ERR_FRAMING;
+        }
+        if (++st->bit_index >= cfg->stop_bits) {
+            uint32_t frame_bits = 1 + cfg->data_bits + cfg->stop_bits +
+                                  ((cfg->parity != OSC_DECODE_PARITY_NONE) ? 1 : 0);
+            uint32_t end = st->frame_start + (uint32_t)(frame_bits * st->samples_per_bit + 0.5f);
+            if (st->all_low) {
+                st->flags |= OSC_DECODE_ERR_BREAK;
+            }
+            emit_annotation(ctx, st->frame_start, end, st->value, st->flags, OSC_DECODE_ANN_DATA);
+            st->phase = UART_PHASE_IDLE;
+            return;
+        }
+        break;
+
+    default:
+        return;
+    }
+
+    st->next_offset += st->samples_per_bit;
+}
+
+static void uart_feed(osc_decode_ctx_t *ctx, const uint8_t *levels, uint32_t count)
+{
+    uart_state_t *st = &ctx->state.uart;
+    uint8_t invert = ctx->config.uart.inverted ? 1 : 0;
+    uint32_t base = ctx->sample_index;
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint8_t bit = (levels[i] & 1) ^ invert;
+
+        if (st->phase == UART_PHASE_IDLE) {
+            if (st->prev_level && !bit) {
+                // Mark -> space: start bit; sample every bit at its centre from here
+                st->phase = UART_PHASE_START;
+                st->frame_start = base + i;
+                st->next_offset = st->samples_per_bit * 0.5f;
+                st->bit_index = 0;
+                st->value = 0;
+                st->ones = 0;
+                st->flags = 0;
+                st->all_low = true;
+            }
+        } else if ((float)(base + i - st->frame_start) >= st->next_offset) {
+            uart_sample_bit(ctx, st, bit);
+        }
+
+        st->prev_level = bit;
+    }
+}
+
+/* Protocol table (index = osc_decode_protocol_t) */
+static const osc_decode_protocol_ops_t protocol_ops[OSC_DECODE_PROTOCOL_MAX] = {
+    [OSC_DECODE_NONE] = { "OFF",  0, NULL, NULL, NULL },
+    [OSC_DECODE_UART] = { "UART", 1, uart_validate, uart_reset, uart_feed },
+};
+
+/* ==================== Common ==================== */
+
+/**
+ * @brief Clear annotations and protocol state (mutex held)
+ */
+static esp_err_t reset_locked(osc_decode_ctx_t *ctx, float sample_rate_hz, uint32_t first_sample)
+{
+    ctx->sample_rate_hz = sample_rate_hz;
+    ctx->sample_index = first_sample;
+    ctx->levels = 0;
+    ctx->levels_valid = false;
+    ctx->ann_head = 0;
+    ctx->ann_count = 0;
+    ctx->ann_dropped = 0;
+    ctx->rate_ok = false;
+
+    if (ctx->ops == NULL || ctx->ops->reset == NULL) return ESP_OK;
+    if (sample_rate_hz <= 0.0f) return ESP_ERR_INVALID_ARG;
+
+    esp_err_t ret = ctx->ops->reset(ctx);
+    ctx->rate_ok = (ret == ESP_OK);
+    return ret;
+}
+
+/**
+ * @brief Threshold a block with hysteresis and run the protocol over it (mutex held)
+ */
+static void feed_locked(osc_decode_ctx_t *ctx, const float *samples, uint32_t count)
+{
+    uint8_t levels[OSC_DECODE_BLOCK_SIZE];
+    float half_band = ctx->config.hysteresis_v * 0.5f;
+    float high = ctx->config.threshold_v + half_band;
+    float low = ctx->config.threshold_v - half_band;
+
+    if (!ctx->levels_valid && count > 0) {
+        ctx->levels = (samples[0] >= ctx->config.threshold_v) ? 1 : 0;
+        ctx->levels_valid = true;
+    }
+
+    while (count > 0) {
+        uint32_t n = (count < OSC_DECODE_BLOCK_SIZE) ? count : OSC_DECODE_BLOCK_SIZE;
+        uint8_t level = ctx->levels;
+
+        // Schmitt trigger: only switch once the signal leaves the band
+        for (uint32_t i = 0; i < n; i++) {
+            if (samples[i] > high) {
+                level = 1;
+            } else if (samples[i] < low) {
+                level = 0;
+            }
+            levels[i] = level;
+        }
+
+        ctx->levels = level;
+        ctx->ops->feed(ctx, levels, n);
+        ctx->sample_index += n;
+
+        samples += n;
+        count -= n;
+    }
+}
+
+/**
+ * @brief Initialize decoder
+ */
+osc_decode_ctx_t *osc_decode_init(void)
+{
+    osc_decode_ctx_t *ctx = heap_caps_malloc(sizeof(osc_decode_ctx_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(osc_decode_ctx_t));
+
+    ctx->mutex = xSemaphoreCreateMutex();
+    ctx->annotations = heap_caps_malloc(OSC_DECODE_MAX_ANNOTATIONS * sizeof(osc_decode_annotation_t),
+                                        MALLOC_CAP_SPIRAM);
+
+    if (ctx->mutex == NULL || ctx->annotations == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate decoder buffers");
+        osc_decode_deinit(ctx);
+        return NULL;
+    }
+
+    ctx->config.protocol = OSC_DECODE_NONE;
+    ctx->ops = &protocol_ops[OSC_DECODE_NONE];
+
+    ESP_LOGI(TAG, "Protocol decoder initialized");
+    return ctx;
+}
+
+/**
+ * @brief Deinitialize decoder
+ */
+void osc_decode_deinit(osc_decode_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    if (ctx->annotations) heap_caps_free(ctx->annotations);
+    if (ctx->mutex) vSemaphoreDelete(ctx->mutex);
+    heap_caps_free(ctx);
+}
+
+/**
+ * @brief Set protocol and comparator settings
+ */
+esp_err_t osc_decode_configure(osc_decode_ctx_t *ctx, const osc_decode_config_t *config)
+{
+    if (ctx == NULL || config == NULL) return ESP_ERR_INVALID_ARG;
+    if (config->protocol >= OSC_DECODE_PROTOCOL_MAX) return ESP_ERR_INVALID_ARG;
+    if (config->hysteresis_v < 0.0f) return ESP_ERR_INVALID_ARG;
+
+    const osc_decode_protocol_ops_t *ops = &protocol_ops[config->protocol];
+    if (ops->validate != NULL) {
+        esp_err_t ret = ops->validate(config);
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "Invalid %s settings", ops->name);
+            return ret;
+        }
+    }
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    ctx->config = *config;
+    ctx->ops = ops;
+    ctx->record_valid = false;
+    reset_locked(ctx, ctx->sample_rate_hz, 0);
+
+    xSemaphoreGive(ctx->mutex);
+
+    ESP_LOGI(TAG, "Decoder: %s, threshold %.2fV +/- %.2fV", ops->name,
+             config->threshold_v, config->hysteresis_v * 0.5f);
+    return ESP_OK;
+}
+
+/**
+ * @brief Get current configuration
+ */
+esp_err_t osc_decode_get_config(osc_decode_ctx_t *ctx, osc_decode_config_t *config)
+{
+    if (ctx == NULL || config == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    *config = ctx->config;
+    xSemaphoreGive(ctx->mutex);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Check if a protocol is selected
+ */
+bool osc_decode_is_enabled(osc_decode_ctx_t *ctx)
+{
+    if (ctx == NULL) return false;
+    return ctx->config.protocol != OSC_DECODE_NONE;
+}
+
+/**
+ * @brief Restart decoding of a new stream
+ */
+esp_err_t osc_decode_reset(osc_decode_ctx_t *ctx, float sample_rate_hz, uint32_t first_sample)
+{
+    if (ctx == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->record_valid = false;
+    esp_err_t ret = reset_locked(ctx, sample_rate_hz, first_sample);
+    xSemaphoreGive(ctx->mutex);
+
+    return ret;
+}
+
+/**
+ * @brief Feed the next block of a stream
+ */
+esp_err_t osc_decode_feed(osc_decode_ctx_t *ctx, const float *samples, uint32_t count)
+{
+    if (ctx == NULL || (samples == NULL && count > 0)) return ESP_ERR_INVALID_ARG;
+    if (!osc_decode_is_enabled(ctx)) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    esp_err_t ret = ESP_OK;
+    if (ctx->rate_ok) {
+        feed_locked(ctx, samples, count);
+    } else {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Decode the next slice of a record
+ */
+esp_err_t osc_decode_feed_record(osc_decode_ctx_t *ctx, const osc_decode_record_t *record,
+                                 uint32_t max_samples, bool *complete)
+{
+    if (ctx == NULL || record == NULL || record->data == NULL) return ESP_ERR_INVALID_ARG;
+    if (complete) *complete = false;
+    if (!osc_decode_is_enabled(ctx)) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    esp_err_t ret = ESP_OK;
+
+    // New capture (or sample rate change): start over
+    if (!ctx->record_valid || ctx->record_generation != record->generation ||
+        ctx->sample_rate_hz != record->sample_rate_hz) {
+        uint32_t first = (record->first_sample < record->num_points) ? record->first_sample : 0;
+        ret = reset_locked(ctx, record->sample_rate_hz, first);
+        ctx->record_generation = record->generation;
+        ctx->record_pos = first;
+        ctx->record_valid = true;
+    }
+
+    if (ctx->rate_ok) {
+        uint32_t remaining = (ctx->record_pos < record->num_points) ? record->num_points - ctx->record_pos : 0;
+        uint32_t n = (remaining < max_samples) ? remaining : max_samples;
+        if (n > 0) {
+            feed_locked(ctx, &record->data[ctx->record_pos], n);
+            ctx->record_pos += n;
+        }
+        if (complete) *complete = (ctx->record_pos >= record->num_points);
+    } else if (ret == ESP_OK) {
+        ret = ESP_ERR_INVALID_SIZE;
+    }
+
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Get sampling rate of the stream being decoded
+ */
+float osc_decode_get_sample_rate(osc_decode_ctx_t *ctx)
+{
+    if (ctx == NULL) return 0.0f;
+    return ctx->sample_rate_hz;
+}
+
+/**
+ * @brief Get number of stored annotations
+ */
+uint32_t osc_decode_get_count(osc_decode_ctx_t *ctx)
+{
+    if (ctx == NULL) return 0;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    uint32_t count = ctx->ann_count;
+    xSemaphoreGive(ctx->mutex);
+
+    return count;
+}
+
+/**
+ * @brief Get annotation by index
+ */
+esp_err_t osc_decode_get_annotation(osc_decode_ctx_t *ctx, uint32_t index, osc_decode_annotation_t *ann)
+{
+    if (ctx == NULL || ann == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    if (index < ctx->ann_count) {
+        *ann = ctx->annotations[(ctx->ann_head + index) % OSC_DECODE_MAX_ANNOTATIONS];
+        ret = ESP_OK;
+    }
+
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Get annotations overlapping a sample range
+ */
+esp_err_t osc_decode_get_annotations(osc_decode_ctx_t *ctx, uint32_t first_sample, uint32_t last_sample,
+                                     osc_decode_annotation_t *out, uint32_t max_count, uint32_t *actual_count)
+{
+    if (ctx == NULL || out == NULL || actual_count == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    // Annotations are stored in start order: binary search the first one that ends in range
+    uint32_t lo = 0, hi = ctx->ann_count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        const osc_decode_annotation_t *ann = &ctx->annotations[(ctx->ann_head + mid) % OSC_DECODE_MAX_ANNOTATIONS];
+        if (ann->end_sample <= first_sample) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    uint32_t count = 0;
+    for (uint32_t i = lo; i < ctx->ann_count && count < max_count; i++) {
+        const osc_decode_annotation_t *ann = &ctx->annotations[(ctx->ann_head + i) % OSC_DECODE_MAX_ANNOTATIONS];
+        if (ann->start_sample > last_sample) break;
+        out[count++] = *ann;
+    }
+
+    *actual_count = count;
+    xSemaphoreGive(ctx->mutex);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Format an annotation for a box or table cell
+ */
+void osc_decode_format_annotation(const osc_decode_annotation_t *ann, char *buf, size_t len)
+{
+    if (ann == NULL || buf == NULL || len == 0) return;
+
+    if (ann->flags & OSC_DECODE_ERR_BREAK) {
+        snprintf(buf, len, "BRK");
+    } else if (ann->flags & OSC_DECODE_ERR_FRAMING) {
+        snprintf(buf, len, "%02X FE", ann->value);
+    } else if (ann->flags & OSC_DECODE_ERR_PARITY) {
+        snprintf(buf, len, "%02X PE", ann->value);
+    } else if (ann->value >= 0x20 && ann->value < 0x7F) {
+        snprintf(buf, len, "%02X '%c'", ann->value, (char)ann->value);
+    } else {
+        snprintf(buf, len, "%02X", ann->value);
+    }
+}
+
+/**
+ * @brief Get protocol name
+ */
+const char *osc_decode_get_protocol_str(osc_decode_protocol_t protocol)
+{
+    if (protocol >= OSC_DECODE_PROTOCOL_MAX) return "?";
+    return protocol_ops[protocol].name;
+}
@@ -0,0 +1,238 @@
+/**
+ * @file oscilloscope_decode.h
+ * @brief Serial protocol decoder on the analog trace
+ *
+ * The capture is turned into logic levels with a hysteresis comparator and
+ * fed, block by block, to a protocol state machine that emits annotations
+ * (value, start/end sample, error flags). Decoder state persists between
+ * blocks, so a long record (or a ROLL-mode stream) is decoded a slice at a
+ * time without stalling the UI.
+ *
+ * Protocols plug in through a small ops table (reset/feed over per-sample
+ * channel bitmasks). UART is implemented; I2C/SPI only need a new ops entry,
+ * a config member and a state member.
+ */
+
+#ifndef OSCILLOSCOPE_DECODE_H
+#define OSCILLOSCOPE_DECODE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Decoder limits */
+#define OSC_DECODE_MAX_ANNOTATIONS  2048    // Annotation ring size (oldest dropped when full)
+#define OSC_DECODE_BLOCK_SIZE       256     // Samples digitized per protocol feed
+#define OSC_DECODE_MIN_SAMPLES_PER_BIT 3.0f // Below this a UART bit cannot be sampled reliably
+
+/* Supported protocols */
+typedef enum {
+    OSC_DECODE_NONE = 0,
+    OSC_DECODE_UART,
+    OSC_DECODE_PROTOCOL_MAX
+} osc_decode_protocol_t;
+
+/* UART parity */
+typedef enum {
+    OSC_DECODE_PARITY_NONE = 0,
+    OSC_DECODE_PARITY_EVEN,
+    OSC_DECODE_PARITY_ODD,
+} osc_decode_parity_t;
+
+/* Annotation error flags */
+#define OSC_DECODE_ERR_FRAMING      (1 << 0)    // Stop bit sampled low
+#define OSC_DECODE_ERR_PARITY       (1 << 1)    // Parity bit mismatch
+#define OSC_DECODE_ERR_BREAK        (1 << 2)    // Whole frame low (line break)
+
+/* Annotation kinds (more are added with new protocols, e.g. I2C START/ADDR/ACK) */
+typedef enum {
+    OSC_DECODE_ANN_DATA = 0,    // Data word
+} osc_decode_ann_kind_t;
+
+/* UART settings */
+typedef struct {
+    uint32_t baud_rate;             // Bits per second
+    uint8_t data_bits;              // 5..9
+    osc_decode_parity_t parity;
+    uint8_t stop_bits;              // 1 or 2
+    bool inverted;                  // Idle low (e.g. RS-232 levels before the transceiver)
+} osc_decode_uart_config_t;
+
+/* Decoder configuration */
+typedef struct {
+    osc_decode_protocol_t protocol;
+    float threshold_v;              // Logic threshold (volts)
+    float hysteresis_v;             // Total hysteresis band around the threshold (volts)
+    osc_decode_uart_config_t uart;  // Used when protocol == OSC_DECODE_UART
+} osc_decode_config_t;
+
+/* One decoded item */
+typedef struct {
+    uint32_t start_sample;          // First sample of the item (record index)
+    uint32_t end_sample;            // Sample after the item
+    uint16_t value;                 // Decoded value
+    uint8_t flags;                  // OSC_DECODE_ERR_* bits
+    uint8_t kind;                   // osc_decode_ann_kind_t
+} osc_decode_annotation_t;
+
+/* Record the decoder runs over incrementally */
+typedef struct {
+    const float *data;              // Voltage samples
+    uint32_t num_points;            // Number of valid samples
+    float sample_rate_hz;           // Sampling rate of the record
+    uint32_t generation;            // Capture generation (a new one restarts decoding)
+    uint32_t first_sample;          // Where to start decoding a new generation
+} osc_decode_record_t;
+
+/* Decoder context */
+typedef struct osc_decode_ctx_t osc_decode_ctx_t;
+
+/**
+ * @brief Initialize decoder (disabled until configured)
+ *
+ * @return Decoder context or NULL on error
+ */
+osc_decode_ctx_t *osc_decode_init(void);
+
+/**
+ * @brief Deinitialize decoder
+ *
+ * @param ctx Decoder context
+ */
+void osc_decode_deinit(osc_decode_ctx_t *ctx);
+
+/**
+ * @brief Set protocol and comparator settings
+ *
+ * Clears annotations and decoder state.
+ *
+ * @param ctx Decoder context
+ * @param config Decoder configuration (protocol NONE disables decoding)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on an invalid setting
+ */
+esp_err_t osc_decode_configure(osc_decode_ctx_t *ctx, const osc_decode_config_t *config);
+
+/**
+ * @brief Get current configuration
+ *
+ * @param ctx Decoder context
+ * @param config Output: configuration
+ * @return ESP_OK on success
+ */
+esp_err_t osc_decode_get_config(osc_decode_ctx_t *ctx, osc_decode_config_t *config);
+
+/**
+ * @brief Check if a protocol is selected
+ *
+ * @param ctx Decoder context
+ * @return true if decoding is enabled
+ */
+bool osc_decode_is_enabled(osc_decode_ctx_t *ctx);
+
+/**
+ * @brief Restart decoding of a new stream
+ *
+ * Clears annotations and state. The next fed sample gets index first_sample.
+ *
+ * @param ctx Decoder context
+ * @param sample_rate_hz Sampling rate of the stream
+ * @param first_sample Index of the next sample
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the rate is too low for the protocol
+ */
+esp_err_t osc_decode_reset(osc_decode_ctx_t *ctx, float sample_rate_hz, uint32_t first_sample);
+
+/**
+ * @brief Feed the next block of a stream
+ *
+ * State carries over to the next call, so a stream may be split anywhere.
+ *
+ * @param ctx Decoder context
+ * @param samples Voltage samples
+ * @param count Number of samples
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if decoding is disabled
+ */
+esp_err_t osc_decode_feed(osc_decode_ctx_t *ctx, const float *samples, uint32_t count);
+
+/**
+ * @brief Decode the next slice of a record
+ *
+ * Restarts at record->first_sample when the generation changes, then
+ * continues from where the previous call stopped. Call once per UI frame
+ * with a bounded budget.
+ *
+ * @param ctx Decoder context
+ * @param record Record to decode
+ * @param max_samples Sample budget for this call
+ * @param complete Output: whole record decoded (may be NULL)
+ * @return ESP_OK on success
+ */
+esp_err_t osc_decode_feed_record(osc_decode_ctx_t *ctx, const osc_decode_record_t *record,
+                                 uint32_t max_samples, bool *complete);
+
+/**
+ * @brief Get sampling rate of the stream being decoded
+ *
+ * @param ctx Decoder context
+ * @return Samples per second (0 before the first reset)
+ */
+float osc_decode_get_sample_rate(osc_decode_ctx_t *ctx);
+
+/**
+ * @brief Get number of stored annotations
+ *
+ * @param ctx Decoder context
+ * @return Annotation count
+ */
+uint32_t osc_decode_get_count(osc_decode_ctx_t *ctx);
+
+/**
+ * @brief Get annotation by index (0 = oldest stored)
+ *
+ * @param ctx Decoder context
+ * @param index Annotation index
+ * @param ann Output: annotation
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if out of range
+ */
+esp_err_t osc_decode_get_annotation(osc_decode_ctx_t *ctx, uint32_t index, osc_decode_annotation_t *ann);
+
+/**
+ * @brief Get annotations overlapping a sample range
+ *
+ * @param ctx Decoder context
+ * @param first_sample First sample of the range
+ * @param last_sample Last sample of the range (inclusive)
+ * @param out Output buffer
+ * @param max_count Capacity of out
+ * @param actual_count Output: number of annotations written
+ * @return ESP_OK on success
+ */
+esp_err_t osc_decode_get_annotations(osc_decode_ctx_t *ctx, uint32_t first_sample, uint32_t last_sample,
+                                     osc_decode_annotation_t *out, uint32_t max_count, uint32_t *actual_count);
+
+/**
+ * @brief Format an annotation for a box or table cell
+ *
+ * @param ann Annotation
+ * @param buf Output buffer
+ * @param len Buffer size
+ */
+void osc_decode_format_annotation(const osc_decode_annotation_t *ann, char *buf, size_t len);
+
+/**
+ * @brief Get protocol name for on-screen labels
+ *
+ * @param protocol Protocol
+ * @return Short name (e.g. "UART")
+ */
+const char *osc_decode_get_protocol_str(osc_decode_protocol_t protocol);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_DECODE_H
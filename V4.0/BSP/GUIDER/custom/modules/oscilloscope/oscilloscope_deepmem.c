@@ -0,0 +1,690 @@
+/**
+ * @file oscilloscope_deepmem.c
+ * @brief Deep memory implementation
+ */
+
+#include "oscilloscope_deepmem.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+static const char *TAG = "OscDeepMem";
+
+#define OSC_DEEPMEM_CHUNK_MASK      (OSC_DEEPMEM_CHUNK_POINTS - 1)
+#define OSC_DEEPMEM_FANOUT_SHIFT    4
+#define OSC_DEEPMEM_FANOUT_MASK     (OSC_DEEPMEM_FANOUT - 1)
+
+/* Summary node: code range of one block */
+typedef struct {
+    uint16_t min;
+    uint16_t max;
+} osc_deepmem_node_t;
+
+/* Deep memory context */
+struct osc_deepmem_t {
+    /* Chunk pool: one PSRAM allocation carved into fixed-size chunks */
+    uint16_t *pool;
+    uint32_t capacity;
+    uint32_t num_chunks;
+    uint16_t free_list[OSC_DEEPMEM_MAX_CHUNKS];
+    uint32_t free_count;
+
+    /* Current record: chain of chunks in sample order */
+    uint16_t *chain[OSC_DEEPMEM_MAX_CHUNKS];
+    uint16_t chain_index[OSC_DEEPMEM_MAX_CHUNKS];
+    uint32_t chain_length;
+    uint32_t depth;
+    uint32_t length;
+    bool finished;
+    float time_per_sample;
+    float volts_per_code;
+    float volts_offset;
+    uint32_t generation;
+
+    /* Summary pyramid, level l block = FANOUT^(l+1) samples */
+    osc_deepmem_node_t *levels[OSC_DEEPMEM_MAX_LEVELS];
+    uint32_t level_blocks[OSC_DEEPMEM_MAX_LEVELS];      // Blocks written (complete, plus partial after finish)
+    uint8_t num_levels;
+    uint16_t leaf_min;
+    uint16_t leaf_max;
+
+    /* Per-block sums for mean / RMS */
+    uint32_t *sums;
+    uint64_t *sums_sq;
+    uint32_t sum_blocks;
+    uint32_t open_sum;
+    uint64_t open_sum_sq;
+
+    uint32_t summary_bytes;
+    SemaphoreHandle_t mutex;
+};
+
+/**
+ * @brief Sample code at a record position
+ */
+static inline uint16_t code_at(const osc_deepmem_t *mem, uint32_t pos)
+{
+    return mem->chain[pos >> OSC_DEEPMEM_CHUNK_SHIFT][pos & OSC_DEEPMEM_CHUNK_MASK];
+}
+
+/**
+ * @brief Number of levels a record of the given length has summaries for
+ */
+static uint8_t levels_for_length(uint32_t length)
+{
+    uint8_t n = 0;
+    uint64_t block = OSC_DEEPMEM_FANOUT;
+    while (n < OSC_DEEPMEM_MAX_LEVELS && length >= block) {
+        n++;
+        block <<= OSC_DEEPMEM_FANOUT_SHIFT;
+    }
+    return n;
+}
+
+/**
+ * @brief Write the parent of children [first, first + count) of a level
+ */
+static void summarize_parent(osc_deepmem_t *mem, uint8_t level, uint32_t first, uint32_t count)
+{
+    const osc_deepmem_node_t *child = mem->levels[level] + first;
+    osc_deepmem_node_t node = child[0];
+    for (uint32_t i = 1; i < count; i++) {
+        if (child[i].min < node.min) node.min = child[i].min;
+        if (child[i].max > node.max) node.max = child[i].max;
+    }
+    uint32_t index = first >> OSC_DEEPMEM_FANOUT_SHIFT;
+    mem->levels[level + 1][index] = node;
+    mem->level_blocks[level + 1] = index + 1;
+}
+
+/**
+ * @brief Summarize samples [from, to) that were just stored (mutex held)
+ */
+static void summarize(osc_deepmem_t *mem, uint32_t from, uint32_t to)
+{
+    for (uint32_t pos = from; pos < to; pos++) {
+        uint16_t c = code_at(mem, pos);
+
+        if ((pos & OSC_DEEPMEM_FANOUT_MASK) == 0) {
+            mem->leaf_min = c;
+            mem->leaf_max = c;
+        } else {
+            if (c < mem->leaf_min) mem->leaf_min = c;
+            if (c > mem->leaf_max) mem->leaf_max = c;
+        }
+
+        mem->open_sum += c;
+        mem->open_sum_sq += (uint32_t)c * c;
+        if (((pos + 1) & (OSC_DEEPMEM_SUM_BLOCK - 1)) == 0) {
+            mem->sums[mem->sum_blocks] = mem->open_sum;
+            mem->sums_sq[mem->sum_blocks] = mem->open_sum_sq;
+            mem->sum_blocks++;
+            mem->open_sum = 0;
+            mem->open_sum_sq = 0;
+        }
+
+        if (((pos + 1) & OSC_DEEPMEM_FANOUT_MASK) != 0) continue;
+
+        // Leaf complete: store it and carry completed groups upwards
+        uint32_t index = pos >> OSC_DEEPMEM_FANOUT_SHIFT;
+        mem->levels[0][index].min = mem->leaf_min;
+        mem->levels[0][index].max = mem->leaf_max;
+        mem->level_blocks[0] = index + 1;
+
+        for (uint8_t l = 0; l + 1 < OSC_DEEPMEM_MAX_LEVELS; l++) {
+            if (((index + 1) & OSC_DEEPMEM_FANOUT_MASK) != 0) break;
+            summarize_parent(mem, l, index - OSC_DEEPMEM_FANOUT_MASK, OSC_DEEPMEM_FANOUT);
+            index >>= OSC_DEEPMEM_FANOUT_SHIFT;
+        }
+    }
+}
+
+/**
+ * @brief Seal the trailing partial blocks and mark the record finished (mutex held)
+ */
+static void finish_locked(osc_deepmem_t *mem)
+{
+    if (mem->finished) return;
+
+    if (mem->length > 0) {
+        if ((mem->length & OSC_DEEPMEM_FANOUT_MASK) != 0) {
+            uint32_t index = mem->length >> OSC_DEEPMEM_FANOUT_SHIFT;
+            mem->levels[0][index].min = mem->leaf_min;
+            mem->levels[0][index].max = mem->leaf_max;
+            mem->level_blocks[0] = index + 1;
+        }
+        for (uint8_t l = 0; l + 1 < OSC_DEEPMEM_MAX_LEVELS; l++) {
+            uint32_t blocks = mem->level_blocks[l];
+            uint32_t tail = blocks & OSC_DEEPMEM_FANOUT_MASK;
+            if (tail != 0) summarize_parent(mem, l, blocks - tail, tail);
+        }
+        if ((mem->length & (OSC_DEEPMEM_SUM_BLOCK - 1)) != 0) {
+            mem->sums[mem->sum_blocks] = mem->open_sum;
+            mem->sums_sq[mem->sum_blocks] = mem->open_sum_sq;
+            mem->sum_blocks++;
+        }
+    }
+
+    mem->num_levels = levels_for_length(mem->length);
+    mem->depth = mem->length;
+    mem->finished = true;
+    ESP_LOGI(TAG, "Record finished: %lu points in %lu chunks, %d levels",
+             mem->length, mem->chain_length, mem->num_levels);
+}
+
+/**
+ * @brief Code range of samples [start, end), end > start (record finished)
+ *
+ * Whole blocks come from the highest level that fits; at most FANOUT - 1
+ * entries per level and side are read, raw samples only at the edges.
+ */
+static void range_minmax(const osc_deepmem_t *mem, uint32_t start, uint32_t end,
+                         uint16_t *min_out, uint16_t *max_out)
+{
+    uint16_t lo = 0xFFFF, hi = 0;
+
+    if (end - start < 2 * OSC_DEEPMEM_FANOUT) {
+        for (uint32_t i = start; i < end; i++) {
+            uint16_t c = code_at(mem, i);
+            if (c < lo) lo = c;
+            if (c > hi) hi = c;
+        }
+        *min_out = lo;
+        *max_out = hi;
+        return;
+    }
+
+    while (start & OSC_DEEPMEM_FANOUT_MASK) {
+        uint16_t c = code_at(mem, start++);
+        if (c < lo) lo = c;
+        if (c > hi) hi = c;
+    }
+    while (end & OSC_DEEPMEM_FANOUT_MASK) {
+        uint16_t c = code_at(mem, --end);
+        if (c < lo) lo = c;
+        if (c > hi) hi = c;
+    }
+
+    // [a, b) in blocks of the current level
+    uint32_t a = start >> OSC_DEEPMEM_FANOUT_SHIFT;
+    uint32_t b = end >> OSC_DEEPMEM_FANOUT_SHIFT;
+    for (uint8_t l = 0; a < b; l++) {
+        const osc_deepmem_node_t *nodes = mem->levels[l];
+        if (l + 1 >= mem->num_levels || b - a < 2 * OSC_DEEPMEM_FANOUT) {
+            for (uint32_t i = a; i < b; i++) {
+                if (nodes[i].min < lo) lo = nodes[i].min;
+                if (nodes[i].max > hi) hi = nodes[i].max;
+            }
+            break;
+        }
+        while (a & OSC_DEEPMEM_FANOUT_MASK) {
+            if (nodes[a].min < lo) lo = nodes[a].min;
+            if (nodes[a].max > hi) hi = nodes[a].max;
+            a++;
+        }
+        while (b & OSC_DEEPMEM_FANOUT_MASK) {
+            b--;
+            if (nodes[b].min < lo) lo = nodes[b].min;
+            if (nodes[b].max > hi) hi = nodes[b].max;
+        }
+        a >>= OSC_DEEPMEM_FANOUT_SHIFT;
+        b >>= OSC_DEEPMEM_FANOUT_SHIFT;
+    }
+
+    *min_out = lo;
+    *max_out = hi;
+}
+
+/**
+ * @brief Initialize deep memory and allocate its pool
+ */
+osc_deepmem_t *osc_deepmem_init(uint32_t capacity)
+{
+    if (capacity < OSC_DEEPMEM_MIN_POINTS || capacity > OSC_DEEPMEM_MAX_POINTS) {
+        ESP_LOGE(TAG, "Invalid capacity: %lu", capacity);
+        return NULL;
+    }
+    capacity = (capacity + OSC_DEEPMEM_CHUNK_MASK) & ~OSC_DEEPMEM_CHUNK_MASK;
+
+    osc_deepmem_t *mem = heap_caps_malloc(sizeof(osc_deepmem_t), MALLOC_CAP_8BIT);
+    if (mem == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(mem, 0, sizeof(osc_deepmem_t));
+
+    mem->mutex = xSemaphoreCreateMutex();
+    if (mem->mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        free(mem);
+        return NULL;
+    }
+
+    // One pool for all chunks keeps PSRAM from fragmenting between records
+    mem->capacity = capacity;
+    mem->num_chunks = capacity >> OSC_DEEPMEM_CHUNK_SHIFT;
+    mem->pool = heap_caps_malloc((size_t)capacity * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+
+    uint32_t blocks = capacity;
+    for (uint8_t l = 0; l < OSC_DEEPMEM_MAX_LEVELS; l++) {
+        blocks = (blocks + OSC_DEEPMEM_FANOUT_MASK) >> OSC_DEEPMEM_FANOUT_SHIFT;
+        mem->levels[l] = heap_caps_malloc(blocks * sizeof(osc_deepmem_node_t), MALLOC_CAP_SPIRAM);
+        mem->summary_bytes += blocks * sizeof(osc_deepmem_node_t);
+    }
+    uint32_t sum_blocks = (capacity + OSC_DEEPMEM_SUM_BLOCK - 1) / OSC_DEEPMEM_SUM_BLOCK;
+    mem->sums = heap_caps_malloc(sum_blocks * sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+    mem->sums_sq = heap_caps_malloc(sum_blocks * sizeof(uint64_t), MALLOC_CAP_SPIRAM);
+    mem->summary_bytes += sum_blocks * (sizeof(uint32_t) + sizeof(uint64_t));
+
+    bool ok = mem->pool != NULL && mem->sums != NULL && mem->sums_sq != NULL;
+    for (uint8_t l = 0; l < OSC_DEEPMEM_MAX_LEVELS; l++) {
+        if (mem->levels[l] == NULL) ok = false;
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to allocate %lu-point pool", capacity);
+        osc_deepmem_deinit(mem);
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < mem->num_chunks; i++) {
+        mem->free_list[i] = (uint16_t)(mem->num_chunks - 1 - i);
+    }
+    mem->free_count = mem->num_chunks;
+    mem->finished = true;
+
+    ESP_LOGI(TAG, "Deep memory initialized: %lu points, %lu chunks, %lu KB pool + %lu KB summaries",
+             capacity, mem->num_chunks, (capacity * sizeof(uint16_t)) / 1024, mem->summary_bytes / 1024);
+    return mem;
+}
+
+/**
+ * @brief Deinitialize deep memory and free its pool
+ */
+void osc_deepmem_deinit(osc_deepmem_t *mem)
+{
+    if (mem == NULL) return;
+
+    for (uint8_t l = 0; l < OSC_DEEPMEM_MAX_LEVELS; l++) {
+        if (mem->levels[l]) heap_caps_free(mem->levels[l]);
+    }
+    if (mem->sums) heap_caps_free(mem->sums);
+    if (mem->sums_sq) heap_caps_free(mem->sums_sq);
+    if (mem->pool) heap_caps_free(mem->pool);
+    vSemaphoreDelete(mem->mutex);
+    free(mem);
+}
+
+/**
+ * @brief Start a new record
+ */
+esp_err_t osc_deepmem_begin(osc_deepmem_t *mem, uint32_t depth, float time_per_sample,
+                            float volts_per_code, float volts_offset)
+{
+    if (mem == NULL || depth == 0 || !(time_per_sample > 0.0f) || !(volts_per_code > 0.0f)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (depth > mem->capacity) return ESP_ERR_INVALID_SIZE;
+
+    xSemaphoreTake(mem->mutex, portMAX_DELAY);
+
+    // Return the previous chain to the pool
+    while (mem->chain_length > 0) {
+        mem->chain_length--;
+        mem->free_list[mem->free_count++] = mem->chain_index[mem->chain_length];
+    }
+
+    mem->depth = depth;
+    mem->length = 0;
+    mem->finished = false;
+    mem->time_per_sample = time_per_sample;
+    mem->volts_per_code = volts_per_code;
+    mem->volts_offset = volts_offset;
+    memset(mem->level_blocks, 0, sizeof(mem->level_blocks));
+    mem->num_levels = 0;
+    mem->sum_blocks = 0;
+    mem->open_sum = 0;
+    mem->open_sum_sq = 0;
+    mem->generation++;
+
+    xSemaphoreGive(mem->mutex);
+
+    ESP_LOGI(TAG, "Record started: %lu points", depth);
+    return ESP_OK;
+}
+
+/**
+ * @brief Append raw samples to the record
+ */
+uint32_t osc_deepmem_append(osc_deepmem_t *mem, const uint16_t *codes, uint32_t count)
+{
+    if (mem == NULL || codes == NULL) return 0;
+
+    xSemaphoreTake(mem->mutex, portMAX_DELAY);
+
+    uint32_t stored = 0;
+    while (stored < count && !mem->finished) {
+        if (mem->length >= mem->depth) {
+            finish_locked(mem);
+            break;
+        }
+
+        // Link the next chunk when the current one is full
+        uint32_t chunk = mem->length >> OSC_DEEPMEM_CHUNK_SHIFT;
+        if (chunk == mem->chain_length) {
+            uint16_t index = mem->free_list[--mem->free_count];
+            mem->chain_index[chunk] = index;
+            mem->chain[chunk] = mem->pool + ((uint32_t)index << OSC_DEEPMEM_CHUNK_SHIFT);
+            mem->chain_length++;
+        }
+
+        uint32_t offset = mem->length & OSC_DEEPMEM_CHUNK_MASK;
+        uint32_t n = count - stored;
+        if (n > OSC_DEEPMEM_CHUNK_POINTS - offset) n = OSC_DEEPMEM_CHUNK_POINTS - offset;
+        if (n > mem->depth - mem->length) n = mem->depth - mem->length;
+
+        memcpy(mem->chain[chunk] + offset, codes + stored, n * sizeof(uint16_t));
+        summarize(mem, mem->length, mem->length + n);
+        mem->length += n;
+        stored += n;
+    }
+    if (!mem->finished && mem->length >= mem->depth) finish_locked(mem);
+
+    xSemaphoreGive(mem->mutex);
+    return stored;
+}
+
+/**
+ * @brief Finish the record early
+ */
+void osc_deepmem_finish(osc_deepmem_t *mem)
+{
+    if (mem == NULL) return;
+
+    xSemaphoreTake(mem->mutex, portMAX_DELAY);
+    finish_locked(mem);
+    xSemaphoreGive(mem->mutex);
+}
+
+/**
+ * @brief Check if the record is complete
+ */
+bool osc_deepmem_is_finished(osc_deepmem_t *mem)
+{
+    if (mem == NULL) return false;
+    return mem->finished;
+}
+
+/**
+ * @brief Get number of stored points
+ */
+uint32_t osc_deepmem_get_length(osc_deepmem_t *mem)
+{
+    if (mem == NULL) return 0;
+    return mem->length;
+}
+
+/**
+ * @brief Get requested record length
+ */
+uint32_t osc_deepmem_get_depth(osc_deepmem_t *mem)
+{
+    if (mem == NULL) return 0;
+    return mem->depth;
+}
+
+/**
+ * @brief Get sample interval of the record
+ */
+float osc_deepmem_get_time_per_sample(osc_deepmem_t *mem)
+{
+    if (mem == NULL) return 0.0f;
+    return mem->time_per_sample;
+}
+
+/**
+ * @brief Get record generation
+ */
+uint32_t osc_deepmem_get_generation(osc_deepmem_t *mem)
+{
+    if (mem == NULL) return 0;
+    return mem->generation;
+}
+
+/**
+ * @brief Read samples as volts
+ */
+esp_err_t osc_deepmem_read(osc_deepmem_t *mem, uint32_t start, uint32_t count, float *out)
+{
+    if (mem == NULL || out == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(mem->mutex, portMAX_DELAY);
+
+    if (start > mem->length || count > mem->length - start) {
+        xSemaphoreGive(mem->mutex);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    const float gain = mem->volts_per_code;
+    const float offset = mem->volts_offset;
+    while (count > 0) {
+        const uint16_t *src = mem->chain[start >> OSC_DEEPMEM_CHUNK_SHIFT] + (start & OSC_DEEPMEM_CHUNK_MASK);
+        uint32_t n = OSC_DEEPMEM_CHUNK_POINTS - (start & OSC_DEEPMEM_CHUNK_MASK);
+        if (n > count) n = count;
+        for (uint32_t i = 0; i < n; i++) {
+            out[i] = src[i] * gain + offset;
+        }
+        out += n;
+        start += n;
+        count -= n;
+    }
+
+    xSemaphoreGive(mem->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Min/max envelope of display columns
+ */
+esp_err_t osc_deepmem_get_envelope(osc_deepmem_t *mem, uint32_t start, float samples_per_column,
+                                   uint16_t columns, float *min, float *max, uint16_t *filled)
+{
+    if (mem == NULL || min == NULL || max == NULL || filled == NULL || !(samples_per_column > 0.0f)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    xSemaphoreTake(mem->mutex, portMAX_DELAY);
+
+    if (!mem->finished) {
+        xSemaphoreGive(mem->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    const float gain = mem->volts_per_code;
+    const float offset = mem->volts_offset;
+    uint16_t c = 0;
+    for (; c < columns; c++) {
+        // Column edges in double: float loses whole samples past 16M
+        uint32_t s0 = start + (uint32_t)((double)c * samples_per_column);
+        uint32_t s1 = start + (uint32_t)((double)(c + 1) * samples_per_column);
+        if (s0 >= mem->length) break;
+        if (s1 <= s0) s1 = s0 + 1;
+        if (s1 > mem->length) s1 = mem->length;
+
+        uint16_t lo, hi;
+        range_minmax(mem, s0, s1, &lo, &hi);
+        min[c] = lo * gain + offset;
+        max[c] = hi * gain + offset;
+    }
+    *filled = c;
+
+    xSemaphoreGive(mem->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Statistics of a sample range
+ */
+esp_err_t osc_deepmem_get_stats(osc_deepmem_t *mem, uint32_t start, uint32_t count,
+                                osc_deepmem_stats_t *stats)
+{
+    if (mem == NULL || stats == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(mem->mutex, portMAX_DELAY);
+
+    if (!mem->finished) {
+        xSemaphoreGive(mem->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (start >= mem->length || count == 0) {
+        xSemaphoreGive(mem->mutex);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (count > mem->length - start) count = mem->length - start;
+    uint32_t end = start + count;
+
+    uint16_t lo, hi;
+    range_minmax(mem, start, end, &lo, &hi);
+
+    // Whole sum blocks from the table, raw samples for the partial ones at the edges
+    uint64_t sum = 0, sum_sq = 0;
+    uint32_t b0 = (start + OSC_DEEPMEM_SUM_BLOCK - 1) / OSC_DEEPMEM_SUM_BLOCK;
+    uint32_t b1 = end / OSC_DEEPMEM_SUM_BLOCK;
+    uint32_t raw_end = end;
+    if (b0 < b1) {
+        for (uint32_t b = b0; b < b1; b++) {
+            sum += mem->sums[b];
+            sum_sq += mem->sums_sq[b];
+        }
+        for (uint32_t i = b1 * OSC_DEEPMEM_SUM_BLOCK; i < end; i++) {
+            uint32_t c = code_at(mem, i);
+            sum += c;
+            sum_sq += c * c;
+        }
+        raw_end = b0 * OSC_DEEPMEM_SUM_BLOCK;
+    }
+    for (uint32_t i = start; i < raw_end; i++) {
+        uint32_t c = code_at(mem, i);
+        sum += c;
+        sum_sq += c * c;
+    }
+
+    // v = g*c + o  ->  E[v] = g*E[c] + o,  E[v^2] = g^2*E[c^2] + 2*g*o*E[c] + o^2
+    const double g = mem->volts_per_code;
+    const double o = mem->volts_offset;
+    double mean_code = (double)sum / count;
+    double mean_sq_code = (double)sum_sq / count;
+    double mean_sq = g * g * mean_sq_code + 2.0 * g * o * mean_code + o * o;
+
+    stats->count = count;
+    stats->min = lo * mem->volts_per_code + mem->volts_offset;
+    stats->max = hi * mem->volts_per_code + mem->volts_offset;
+    stats->mean = (float)(g * mean_code + o);
+    stats->rms = (float)sqrt(mean_sq > 0.0 ? mean_sq : 0.0);
+
+    xSemaphoreGive(mem->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Find rising crossings of a level
+ */
+esp_err_t osc_deepmem_find_edges(osc_deepmem_t *mem, uint32_t start, uint32_t count, float level,
+                                 float hysteresis, uint32_t *edges, uint32_t *first, uint32_t *last)
+{
+    if (mem == NULL || edges == NULL || first == NULL || last == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(mem->mutex, portMAX_DELAY);
+
+    if (!mem->finished) {
+        xSemaphoreGive(mem->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (start > mem->length) start = mem->length;
+    if (count > mem->length - start) count = mem->length - start;
+
+    // Thresholds in codes so the scan never converts samples
+    float high = (level + hysteresis - mem->volts_offset) / mem->volts_per_code;
+    float low = (level - hysteresis - mem->volts_offset) / mem->volts_per_code;
+    int32_t high_code = (int32_t)ceilf(high);
+    int32_t low_code = (int32_t)floorf(low);
+
+    uint32_t n = 0, first_pos = 0, last_pos = 0;
+    bool armed = false;
+    uint32_t pos = start, end = start + count;
+    while (pos < end) {
+        const uint16_t *src = mem->chain[pos >> OSC_DEEPMEM_CHUNK_SHIFT];
+        uint32_t chunk_end = (pos | OSC_DEEPMEM_CHUNK_MASK) + 1;
+        if (chunk_end > end) chunk_end = end;
+        for (; pos < chunk_end; pos++) {
+            int32_t c = src[pos & OSC_DEEPMEM_CHUNK_MASK];
+            if (c <= low_code) {
+                armed = true;
+            } else if (armed && c >= high_code) {
+                armed = false;
+                if (n == 0) first_pos = pos;
+                last_pos = pos;
+                n++;
+            }
+        }
+    }
+
+    *edges = n;
+    *first = first_pos;
+    *last = last_pos;
+
+    xSemaphoreGive(mem->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Get number of summary levels
+ */
+uint8_t osc_deepmem_get_num_levels(osc_deepmem_t *mem)
+{
+    if (mem == NULL || !mem->finished) return 0;
+    return mem->num_levels;
+}
+
+/**
+ * @brief Get number of blocks of a level
+ */
+uint32_t osc_deepmem_get_num_blocks(osc_deepmem_t *mem, uint8_t level)
+{
+    if (mem == NULL || !mem->finished || level >= mem->num_levels) return 0;
+    return mem->level_blocks[level];
+}
+
+/**
+ * @brief Get minimum and maximum of one summary block
+ */
+void osc_deepmem_get_block(osc_deepmem_t *mem, uint8_t level, uint32_t block, float *min, float *max)
+{
+    if (mem == NULL || min == NULL || max == NULL) return;
+    if (level >= mem->num_levels || block >= mem->level_blocks[level]) {
+        *min = 0.0f;
+        *max = 0.0f;
+        return;
+    }
+
+    const osc_deepmem_node_t *node = &mem->levels[level][block];
+    *min = node->min * mem->volts_per_code + mem->volts_offset;
+    *max = node->max * mem->volts_per_code + mem->volts_offset;
+}
+
+/**
+ * @brief Get memory use
+ */
+void osc_deepmem_get_usage(osc_deepmem_t *mem, osc_deepmem_usage_t *usage)
+{
+    if (mem == NULL || usage == NULL) return;
+
+    usage->capacity = mem->capacity;
+    usage->pool_bytes = mem->capacity * sizeof(uint16_t);
+    usage->summary_bytes = mem->summary_bytes;
+    usage->chunks_total = mem->num_chunks;
+    usage->chunks_used = mem->chain_length;
+}
@@ -0,0 +1,249 @@
+/**
+ * @file oscilloscope_deepmem.h
+ * @brief Deep memory: multi-megasample records in chunked PSRAM storage
+ *
+ * A record is a chain of fixed-size chunks of raw 12-bit ADC codes taken
+ * from one dedicated PSRAM pool (2 bytes per point, 16 MB for 8M points).
+ * While samples are appended, a min/max summary pyramid with the geometry of
+ * oscilloscope_pyramid (blocks of 16^(level+1) samples) and per-4096-sample
+ * sums are built on the fly, so zoom/pan envelopes, measurements and search
+ * over the record read O(log n) summaries plus a few raw samples at the edges.
+ */
+
+#ifndef OSCILLOSCOPE_DEEPMEM_H
+#define OSCILLOSCOPE_DEEPMEM_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Storage geometry */
+#define OSC_DEEPMEM_CHUNK_SHIFT     16
+#define OSC_DEEPMEM_CHUNK_POINTS    (1u << OSC_DEEPMEM_CHUNK_SHIFT)     // 64K points (128 KB) per chunk
+#define OSC_DEEPMEM_MIN_POINTS      (1024u * 1024u)                     // 1M
+#define OSC_DEEPMEM_MAX_POINTS      (8u * 1024u * 1024u)                // 8M
+#define OSC_DEEPMEM_MAX_CHUNKS      (OSC_DEEPMEM_MAX_POINTS / OSC_DEEPMEM_CHUNK_POINTS)
+#define OSC_DEEPMEM_FANOUT          16      // Same block geometry as oscilloscope_pyramid
+#define OSC_DEEPMEM_MAX_LEVELS      6       // Up to 16^6 = 16M samples per top-level block
+#define OSC_DEEPMEM_SUM_BLOCK       4096    // Samples per sum / sum-of-squares entry
+
+/* Statistics of a sample range */
+typedef struct {
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float rms;
+} osc_deepmem_stats_t;
+
+/* Memory use */
+typedef struct {
+    uint32_t capacity;              // Largest record the pool holds (points)
+    uint32_t pool_bytes;            // Raw sample pool
+    uint32_t summary_bytes;         // Pyramid and sum tables
+    uint32_t chunks_total;
+    uint32_t chunks_used;           // Chunks chained into the current record
+} osc_deepmem_usage_t;
+
+/* Deep memory context */
+typedef struct osc_deepmem_t osc_deepmem_t;
+
+/**
+ * @brief Initialize deep memory and allocate its pool
+ *
+ * @param capacity Largest record in points (rounded up to whole chunks,
+ *                 OSC_DEEPMEM_MIN_POINTS .. OSC_DEEPMEM_MAX_POINTS)
+ * @return Deep memory context or NULL if the pool cannot be allocated
+ */
+osc_deepmem_t *osc_deepmem_init(uint32_t capacity);
+
+/**
+ * @brief Deinitialize deep memory and free its pool
+ *
+ * @param mem Deep memory context
+ */
+void osc_deepmem_deinit(osc_deepmem_t *mem);
+
+/**
+ * @brief Start a new record (the previous record is discarded)
+ *
+ * Sample volts = code * volts_per_code + volts_offset.
+ *
+ * @param mem Deep memory context
+ * @param depth Record length in points (<= capacity)
+ * @param time_per_sample Sample interval (seconds)
+ * @param volts_per_code ADC code to volts gain (> 0)
+ * @param volts_offset Volts of code 0
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if depth exceeds the capacity
+ */
+esp_err_t osc_deepmem_begin(osc_deepmem_t *mem, uint32_t depth, float time_per_sample,
+                            float volts_per_code, float volts_offset);
+
+/**
+ * @brief Append raw samples to the record
+ *
+ * Summaries are updated as blocks complete. Once the record reaches its
+ * depth it is finished and further samples are dropped.
+ *
+ * @param mem Deep memory context
+ * @param codes Raw ADC codes
+ * @param count Number of codes
+ * @return Number of codes stored
+ */
+uint32_t osc_deepmem_append(osc_deepmem_t *mem, const uint16_t *codes, uint32_t count);
+
+/**
+ * @brief Finish the record early (summarizes the trailing partial blocks)
+ *
+ * @param mem Deep memory context
+ */
+void osc_deepmem_finish(osc_deepmem_t *mem);
+
+/**
+ * @brief Check if the record is complete and can be queried
+ *
+ * @param mem Deep memory context
+ * @return true once the record is finished
+ */
+bool osc_deepmem_is_finished(osc_deepmem_t *mem);
+
+/**
+ * @brief Get number of stored points
+ *
+ * @param mem Deep memory context
+ * @return Points stored so far
+ */
+uint32_t osc_deepmem_get_length(osc_deepmem_t *mem);
+
+/**
+ * @brief Get requested record length
+ *
+ * @param mem Deep memory context
+ * @return Depth passed to osc_deepmem_begin() (0 if no record)
+ */
+uint32_t osc_deepmem_get_depth(osc_deepmem_t *mem);
+
+/**
+ * @brief Get sample interval of the record
+ *
+ * @param mem Deep memory context
+ * @return Seconds per sample
+ */
+float osc_deepmem_get_time_per_sample(osc_deepmem_t *mem);
+
+/**
+ * @brief Get record generation (changes with every osc_deepmem_begin())
+ *
+ * @param mem Deep memory context
+ * @return Generation
+ */
+uint32_t osc_deepmem_get_generation(osc_deepmem_t *mem);
+
+/**
+ * @brief Read samples as volts
+ *
+ * @param mem Deep memory context
+ * @param start First sample
+ * @param count Number of samples
+ * @param out Output: count voltages
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the span exceeds the record
+ */
+esp_err_t osc_deepmem_read(osc_deepmem_t *mem, uint32_t start, uint32_t count, float *out);
+
+/**
+ * @brief Min/max envelope of display columns
+ *
+ * Column c covers samples [start + c * samples_per_column, start + (c + 1) * samples_per_column),
+ * at least one sample. Columns past the end of the record are not filled.
+ *
+ * @param mem Deep memory context
+ * @param start First sample of column 0
+ * @param samples_per_column Samples per column (may be below 1 when zoomed in)
+ * @param columns Number of columns
+ * @param min Output: minimum per column (volts)
+ * @param max Output: maximum per column (volts)
+ * @param filled Output: number of columns filled
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the record is not finished
+ */
+esp_err_t osc_deepmem_get_envelope(osc_deepmem_t *mem, uint32_t start, float samples_per_column,
+                                   uint16_t columns, float *min, float *max, uint16_t *filled);
+
+/**
+ * @brief Statistics of samples [start, start + count)
+ *
+ * @param mem Deep memory context
+ * @param start First sample
+ * @param count Number of samples (clamped to the record)
+ * @param stats Output: statistics
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the record is not finished,
+ *         ESP_ERR_INVALID_ARG on an empty span
+ */
+esp_err_t osc_deepmem_get_stats(osc_deepmem_t *mem, uint32_t start, uint32_t count,
+                                osc_deepmem_stats_t *stats);
+
+/**
+ * @brief Find rising crossings of a level in samples [start, start + count)
+ *
+ * A crossing counts when a sample reaches level + hysteresis after the signal
+ * was below level - hysteresis.
+ *
+ * @param mem Deep memory context
+ * @param start First sample
+ * @param count Number of samples (clamped to the record)
+ * @param level Crossing level (volts)
+ * @param hysteresis Half-width of the hysteresis band (volts)
+ * @param edges Output: number of crossings
+ * @param first Output: sample of the first crossing
+ * @param last Output: sample of the last crossing
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the record is not finished
+ */
+esp_err_t osc_deepmem_find_edges(osc_deepmem_t *mem, uint32_t start, uint32_t count, float level,
+                                 float hysteresis, uint32_t *edges, uint32_t *first, uint32_t *last);
+
+/**
+ * @brief Get number of summary levels (0 if the record is shorter than one block)
+ *
+ * @param mem Deep memory context
+ * @return Number of levels
+ */
+uint8_t osc_deepmem_get_num_levels(osc_deepmem_t *mem);
+
+/**
+ * @brief Get number of blocks of a level (the last one may be partial)
+ *
+ * @param mem Deep memory context
+ * @param level Level
+ * @return Number of blocks
+ */
+uint32_t osc_deepmem_get_num_blocks(osc_deepmem_t *mem, uint8_t level);
+
+/**
+ * @brief Get minimum and maximum of one summary block
+ *
+ * Blocks of level l span OSC_DEEPMEM_FANOUT^(l+1) samples (osc_pyramid_get_block_size()).
+ *
+ * @param mem Deep memory context
+ * @param level Level
+ * @param block Block index
+ * @param min Output: minimum (volts)
+ * @param max Output: maximum (volts)
+ */
+void osc_deepmem_get_block(osc_deepmem_t *mem, uint8_t level, uint32_t block, float *min, float *max);
+
+/**
+ * @brief Get memory use
+ *
+ * @param mem Deep memory context
+ * @param usage Output: memory use
+ */
+void osc_deepmem_get_usage(osc_deepmem_t *mem, osc_deepmem_usage_t *usage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_DEEPMEM_H
@@ -2,8 +2,10 @@
  * @file oscilloscope_export.c
  * @brief Oscilloscope Data Export - SD Card
  * 
- * Exports oscilloscope waveform data to SD card as CSV files.
+ * Exports oscilloscope waveform data to SD card as CSV files, written by the
+ * storage writer task from a copy of the stored data.
  * Naming convention: Oscilloscope_001.csv, Oscilloscope_002.csv, etc.
+ * Binary exports share the numbering (Oscilloscope_003.osw).
  */
 
 #include "oscilloscope_export.h"
@@ -24,6 +26,7 @@ static const char *TAG = "OSC_EXPORT";
 #define OSCILLOSCOPE_DIR    "/sdcard/Oscilloscope"
 #define OSC_PREFIX          "Oscilloscope_"
 #define OSC_EXT             ".csv"
+#define OSC_EXPORT_ROW_MAX  48          // "index,x,y\n" upper bound
 
 /* State variables */
 static bool g_initialized = false;
@@ -197,10 +200,175 @@ esp_err_t osc_export_store_fft(const osc_waveform_data_t *fft_data)
     return ESP_OK;
 }
 
+/* One CSV file of a save batch */
+typedef struct {
+    osc_waveform_data_t data;           // Copy: the stored data may change while queued
+    char timestamp[32];
+    bool is_fft;
+    bool header_done;
+    int next;                           // Next row
+} csv_export_job_t;
+
+/* Save batch: reports once, after its last file */
+typedef struct {
+    int remaining;
+    esp_err_t result;
+    storage_writer_done_cb on_done;
+    void *cb_user;
+    char path[STORAGE_WRITER_PATH_MAX]; // Last file written
+} export_batch_t;
+
+/**
+ * @brief Format the CSV comment header
+ */
+static size_t format_csv_header(const csv_export_job_t *job, char *text, size_t size)
+{
+    const osc_waveform_data_t *d = &job->data;
+
+    if (job->is_fft) {
+        return snprintf(text, size,
+                        "# Oscilloscope FFT Spectrum Data\n"
+                        "# Timestamp: %s\n"
+                        "# Fundamental Frequency: %.2f Hz\n"
+                        "# H1 (Fundamental): %.3f V\n"
+                        "# H3 (3rd Harmonic): %.3f V\n"
+                        "# THD (Total Harmonic Distortion): %.2f %%\n"
+                        "# FFT Size: %.0f points\n"
+                        "# Max Frequency: %.0f Hz\n"
+                        "# Amplitude Range: %.0f dB\n"
+                        "# Spectrum Points: %d\n"
+                        "#\n"
+                        "Index,Frequency(Hz),Magnitude(dB)\n",
+                        job->timestamp, d->frequency, d->vmax, d->vmin, d->vpp, d->vrms,
+                        d->time_scale, d->volt_scale, d->num_points);
+    }
+
+    return snprintf(text, size,
+                    "# Oscilloscope Waveform Data\n"
+                    "# Timestamp: %s\n"
+                    "# Frequency: %.2f Hz\n"
+                    "# Vmax: %.3f V\n"
+                    "# Vmin: %.3f V\n"
+                    "# Vpp: %.3f V\n"
+                    "# Vrms: %.3f V\n"
+                    "# Time Scale: %.6f s/div\n"
+                    "# Volt Scale: %.3f V/div\n"
+                    "# Points: %d\n"
+                    "#\n"
+                    "Index,Time(s),Voltage(V)\n",
+                    job->timestamp, d->frequency, d->vmax, d->vmin, d->vpp, d->vrms,
+                    d->time_scale, d->volt_scale, d->num_points);
+}
+
+/**
+ * @brief Writer fill: header, then rows until the buffer is full
+ */
+static esp_err_t csv_export_fill(void *user, uint8_t *buf, size_t size, size_t *len)
+{
+    csv_export_job_t *job = (csv_export_job_t *)user;
+    const osc_waveform_data_t *d = &job->data;
+    char *text = (char *)buf;
+    size_t used = 0;
+
+    if (!job->header_done) {
+        used = format_csv_header(job, text, size);
+        job->header_done = true;
+    }
+
+    if (job->is_fft) {
+        float freq_per_point = d->time_scale / (float)d->num_points;   // time_scale holds the max frequency
+        while (job->next < d->num_points && size - used > OSC_EXPORT_ROW_MAX) {
+            int i = job->next++;
+            used += snprintf(text + used, OSC_EXPORT_ROW_MAX, "%d,%.2f,%.3f\n", i, i * freq_per_point, d->data[i]);
+        }
+    } else {
+        float time_per_point = d->time_scale * 10.0f / d->num_points;
+        while (job->next < d->num_points && size - used > OSC_EXPORT_ROW_MAX) {
+            int i = job->next++;
+            used += snprintf(text + used, OSC_EXPORT_ROW_MAX, "%d,%.9f,%.6f\n", i, i * time_per_point, d->data[i]);
+        }
+    }
+
+    *len = used;
+    return ESP_OK;
+}
+
+/**
+ * @brief Writer finish: free the job
+ */
+static void csv_export_finish(void *user, esp_err_t result, const char *path)
+{
+    csv_export_job_t *job = (csv_export_job_t *)user;
+    if (result == ESP_OK) {
+        ESP_LOGI(TAG, "%s saved: %s (%d points)", job->is_fft ? "FFT spectrum" : "Waveform", path,
+                 job->data.num_points);
+    }
+    heap_caps_free(job);
+}
+
+/**
+ * @brief Completion of one batch file (LVGL thread; path NULL releases the submit hold)
+ */
+static void csv_export_done(void *user, esp_err_t result, const char *path)
+{
+    export_batch_t *batch = (export_batch_t *)user;
+
+    if (result != ESP_OK && batch->result == ESP_OK) {
+        batch->result = result;
+    }
+    if (path != NULL) {
+        snprintf(batch->path, sizeof(batch->path), "%s", path);
+    }
+
+    if (--batch->remaining == 0) {
+        if (batch->on_done != NULL) {
+            batch->on_done(batch->cb_user, batch->result, batch->path);
+        }
+        heap_caps_free(batch);
+    }
+}
+
+/**
+ * @brief Queue one CSV file of a batch
+ */
+static esp_err_t submit_csv(export_batch_t *batch, const osc_waveform_data_t *data, bool is_fft,
+                            const char *timestamp)
+{
+    csv_export_job_t *job = heap_caps_calloc(1, sizeof(csv_export_job_t), MALLOC_CAP_SPIRAM);
+    if (job == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(&job->data, data, sizeof(osc_waveform_data_t));
+    snprintf(job->timestamp, sizeof(job->timestamp), "%s", timestamp);
+    job->is_fft = is_fft;
+
+    storage_writer_job_t wj = {
+        .fill = csv_export_fill,
+        .finish = csv_export_finish,
+        .user = job,
+        .on_done = csv_export_done,
+        .cb_user = batch,
+    };
+    snprintf(wj.path, sizeof(wj.path), "%s/%s%03d%s%s", OSCILLOSCOPE_DIR, OSC_PREFIX, g_next_number,
+             is_fft ? "_FFT" : "", OSC_EXT);
+
+    batch->remaining++;
+    esp_err_t ret = storage_writer_submit(&wj);
+    if (ret != ESP_OK) {
+        batch->remaining--;
+        heap_caps_free(job);
+        return ret;
+    }
+
+    g_next_number++;
+    g_export_counter++;
+    return ESP_OK;
+}
+
 /**
  * @brief Save waveform data to SD card
  */
-esp_err_t osc_export_save_to_sd(void)
+esp_err_t osc_export_save_to_sd(storage_writer_done_cb on_done, void *cb_user)
 {
     if (!g_sd_available) {
         ESP_LOGE(TAG, "SD card not available");
@@ -217,97 +385,40 @@ esp_err_t osc_export_save_to_sd(void)
     char timestamp[32];
     get_current_timestamp(timestamp, sizeof(timestamp));
 
-    esp_err_t ret = ESP_OK;
+    export_batch_t *batch = heap_caps_calloc(1, sizeof(export_batch_t), MALLOC_CAP_DEFAULT);
+    if (batch == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    batch->on_done = on_done;
+    batch->cb_user = cb_user;
+    // Held until both files are queued, so an early completion cannot end the batch
+    batch->remaining = 1;
 
-    /* Save waveform data */
+    esp_err_t ret = ESP_OK;
     if (g_has_waveform) {
-        char filename[256];
-        snprintf(filename, sizeof(filename), "%s/%s%03d%s", 
-                 OSCILLOSCOPE_DIR, OSC_PREFIX, g_next_number, OSC_EXT);
-
-        FILE *f = fopen(filename, "w");
-        if (f == NULL) {
-            ESP_LOGE(TAG, "Failed to create file: %s", strerror(errno));
-        return ESP_FAIL;
-    }
-
-        /* Write CSV header */
-        fprintf(f, "# Oscilloscope Waveform Data\n");
-        fprintf(f, "# Timestamp: %s\n", timestamp);
-        fprintf(f, "# Frequency: %.2f Hz\n", g_waveform_data->frequency);
-        fprintf(f, "# Vmax: %.3f V\n", g_waveform_data->vmax);
-        fprintf(f, "# Vmin: %.3f V\n", g_waveform_data->vmin);
-        fprintf(f, "# Vpp: %.3f V\n", g_waveform_data->vpp);
-        fprintf(f, "# Vrms: %.3f V\n", g_waveform_data->vrms);
-        fprintf(f, "# Time Scale: %.6f s/div\n", g_waveform_data->time_scale);
-        fprintf(f, "# Volt Scale: %.3f V/div\n", g_waveform_data->volt_scale);
-        fprintf(f, "# Points: %d\n", g_waveform_data->num_points);
-        fprintf(f, "#\n");
-        fprintf(f, "Index,Time(s),Voltage(V)\n");
-
-        /* Write data points */
-        float time_per_point = g_waveform_data->time_scale * 10.0f / g_waveform_data->num_points;
-        for (int i = 0; i < g_waveform_data->num_points; i++) {
-            fprintf(f, "%d,%.9f,%.6f\n", i, i * time_per_point, g_waveform_data->data[i]);
-        }
-
-        fclose(f);
-        ESP_LOGI(TAG, "Waveform saved: %s", filename);
-        g_next_number++;
-    g_export_counter++;
+        ret = submit_csv(batch, g_waveform_data, false, timestamp);
     }
-
-    /* Save FFT data */
-    if (g_has_fft) {
-        char filename[256];
-        snprintf(filename, sizeof(filename), "%s/%s%03d_FFT%s", 
-                 OSCILLOSCOPE_DIR, OSC_PREFIX, g_next_number, OSC_EXT);
-
-        FILE *f = fopen(filename, "w");
-        if (f == NULL) {
-            ESP_LOGE(TAG, "Failed to create FFT file: %s", strerror(errno));
-            return ESP_FAIL;
-        }
-
-        /* Write CSV header with FFT-specific information */
-        fprintf(f, "# Oscilloscope FFT Spectrum Data\n");
-        fprintf(f, "# Timestamp: %s\n", timestamp);
-        fprintf(f, "# Fundamental Frequency: %.2f Hz\n", g_fft_data->frequency);
-        fprintf(f, "# H1 (Fundamental): %.3f V\n", g_fft_data->vmax);
-        fprintf(f, "# H3 (3rd Harmonic): %.3f V\n", g_fft_data->vmin);
-        fprintf(f, "# THD (Total Harmonic Distortion): %.2f %%\n", g_fft_data->vpp);
-        fprintf(f, "# FFT Size: %.0f points\n", g_fft_data->vrms);
-        fprintf(f, "# Max Frequency: %.0f Hz\n", g_fft_data->time_scale);
-        fprintf(f, "# Amplitude Range: %.0f dB\n", g_fft_data->volt_scale);
-        fprintf(f, "# Spectrum Points: %d\n", g_fft_data->num_points);
-        fprintf(f, "#\n");
-        fprintf(f, "Index,Frequency(Hz),Magnitude(dB)\n");
-
-        /* Write FFT spectrum data points */
-        float max_freq = g_fft_data->time_scale;  // Maximum frequency to display
-        float freq_per_point = max_freq / (float)g_fft_data->num_points;
-        
-        for (int i = 0; i < g_fft_data->num_points; i++) {
-            float frequency = i * freq_per_point;
-            float magnitude_db = g_fft_data->data[i];
-            fprintf(f, "%d,%.2f,%.3f\n", i, frequency, magnitude_db);
-        }
-
-        fclose(f);
-        ESP_LOGI(TAG, "FFT spectrum saved: %s (%d points, %.0f Hz max)", 
-                 filename, g_fft_data->num_points, max_freq);
-        g_next_number++;
-        g_export_counter++;
+    if (ret == ESP_OK && g_has_fft) {
+        ret = submit_csv(batch, g_fft_data, true, timestamp);
     }
 
-    return ret;
+    if (batch->remaining == 1) {
+        // Nothing queued: no callback will come
+        heap_caps_free(batch);
+        return ret;
+    }
+    if (ret != ESP_OK) {
+        batch->result = ret;
+    }
+    csv_export_done(batch, batch->result, NULL);
+    return ESP_OK;
 }
 
 /* Legacy functions for compatibility */
 esp_err_t osc_export_start_usb(void)
 {
     ESP_LOGI(TAG, "USB export deprecated - use osc_export_save_to_sd()");
-    return osc_export_save_to_sd();
+    return osc_export_save_to_sd(NULL, NULL);
 }
 
 esp_err_t osc_export_stop_usb(void)
@@ -369,6 +480,22 @@ esp_err_t osc_export_get_timestamp(char *buffer, size_t buffer_size)
     return ESP_OK;
 }
 
+esp_err_t osc_export_reserve_path(const char *ext, char *path, size_t size)
+{
+    if (ext == NULL || path == NULL || size == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!g_sd_available) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ensure_osc_dir();
+    snprintf(path, size, "%s/%s%03d%s", OSCILLOSCOPE_DIR, OSC_PREFIX, g_next_number, ext);
+    g_next_number++;
+    g_export_counter++;
+    return ESP_OK;
+}
+
 bool osc_export_is_sd_available(void)
 {
     return g_sd_available;
@@ -2,8 +2,9 @@
  * @file oscilloscope_export.h
  * @brief Oscilloscope Data Export - SD Card
  * 
- * Exports oscilloscope waveform data to SD card as CSV files.
- * Naming: Oscilloscope_001.csv, Oscilloscope_002.csv, etc.
+ * Exports oscilloscope waveform data to SD card as CSV files, or the whole
+ * record as a binary .osw file with JSON sidecar (see oscilloscope_wavefile.h).
+ * Naming: Oscilloscope_001.csv, Oscilloscope_002.osw, etc.
  */
 
 #ifndef OSCILLOSCOPE_EXPORT_H
@@ -14,6 +15,7 @@ extern "C" {
 #endif
 
 #include "esp_err.h"
+#include "storage_writer.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -28,7 +30,11 @@ extern "C" {
 typedef enum {
     OSC_EXPORT_FORMAT_TXT = 0,  // Plain text format
     OSC_EXPORT_FORMAT_CSV = 1,  // CSV format (Excel compatible)
-    OSC_EXPORT_FORMAT_BOTH = 2  // Both TXT and CSV
+    OSC_EXPORT_FORMAT_BOTH = 2, // Both TXT and CSV
+    OSC_EXPORT_FORMAT_BIN = 3,  // Full-depth binary + JSON sidecar
+    OSC_EXPORT_FORMAT_BIN_CSV = 4,  // Binary, plus CSV converted in the background
+    OSC_EXPORT_FORMAT_REC = 5,  // Continuous recording to rotating binary segments
+    OSC_EXPORT_FORMAT_COUNT
 } osc_export_format_t;
 
 /**
@@ -149,9 +155,26 @@ esp_err_t osc_export_get_timestamp(char *buffer, size_t buffer_size);
 /**
  * @brief Save waveform/FFT data to SD card
  * 
- * @return ESP_OK on success
+ * The stored data is copied and queued on the storage writer; the call
+ * returns before anything is written.
+ * 
+ * @param on_done Called once on the LVGL thread after the last file, with the
+ *                first error and the last path (may be NULL)
+ * @param cb_user Callback context
+ * @return ESP_OK if queued, ESP_ERR_NOT_FOUND without SD card,
+ *         ESP_ERR_INVALID_STATE without data, or the submit error
+ */
+esp_err_t osc_export_save_to_sd(storage_writer_done_cb on_done, void *cb_user);
+
+/**
+ * @brief Take the next export file name
+ *
+ * @param ext Extension including the dot (e.g. ".osw")
+ * @param path Output: full path
+ * @param size Size of path
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the SD card is not available
  */
-esp_err_t osc_export_save_to_sd(void);
+esp_err_t osc_export_reserve_path(const char *ext, char *path, size_t size);
 
 /**
  * @brief Check if SD card is available for exports
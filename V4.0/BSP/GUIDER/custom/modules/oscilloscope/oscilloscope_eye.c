@@ -0,0 +1,385 @@
+/**
+ * @file oscilloscope_eye.c
+ * @brief Eye diagram accumulation implementation
+ */
+
+#include "oscilloscope_eye.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+static const char *TAG = "OscEye";
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* Column = top 8 bits of the 32-bit phase accumulator (two UI per wrap) */
+#define OSC_EYE_COLUMN_SHIFT    24
+#define OSC_EYE_HYSTERESIS      0.1f    // Fraction of the swing around mid-level
+#define OSC_EYE_SEED_TRIES      4       // Shortest intervals tried as the period seed
+
+/* Eye context */
+struct osc_eye_ctx_t {
+    uint16_t *counts;               // PSRAM, OSC_EYE_WIDTH * OSC_EYE_HEIGHT, saturating
+    float *edges;                   // PSRAM, crossing positions of one capture (samples)
+
+    float v_min;
+    float v_max;
+    bool has_range;
+    float bit_period;               // 0 = recover
+    bool enabled;
+
+    osc_eye_stats_t stats;
+    uint32_t generation;
+
+    SemaphoreHandle_t mutex;
+};
+
+/**
+ * @brief Clear the image (mutex held)
+ */
+static void clear_image(osc_eye_ctx_t *ctx)
+{
+    memset(ctx->counts, 0, OSC_EYE_WIDTH * OSC_EYE_HEIGHT * sizeof(uint16_t));
+    ctx->stats.captures = 0;
+    ctx->stats.skipped = 0;
+    ctx->stats.hits = 0;
+    ctx->stats.max_count = 0;
+    ctx->generation++;
+}
+
+/**
+ * @brief Find mid-level crossings (with hysteresis) of one capture
+ *
+ * @return Number of crossings stored in ctx->edges (fractional sample positions)
+ */
+static uint32_t find_edges(osc_eye_ctx_t *ctx, const float *data, uint32_t num_points)
+{
+    float vmin = data[0], vmax = data[0];
+    for (uint32_t i = 1; i < num_points; i++) {
+        if (data[i] < vmin) vmin = data[i];
+        if (data[i] > vmax) vmax = data[i];
+    }
+    float swing = vmax - vmin;
+    if (!(swing > 0.0f)) return 0;
+
+    float mid = (vmax + vmin) * 0.5f;
+    float hi = mid + swing * OSC_EYE_HYSTERESIS;
+    float lo = mid - swing * OSC_EYE_HYSTERESIS;
+
+    // An edge is placed at the last mid-level crossing before the signal clears the hysteresis band
+    bool high = data[0] > mid;
+    float crossing = -1.0f;
+    uint32_t count = 0;
+    for (uint32_t i = 1; i < num_points && count < OSC_EYE_MAX_EDGES; i++) {
+        float prev = data[i - 1];
+        float cur = data[i];
+        if ((prev < mid) != (cur < mid)) {
+            crossing = (float)(i - 1) + (mid - prev) / (cur - prev);
+        }
+        if (!high && cur > hi) {
+            high = true;
+            if (crossing >= 0.0f) ctx->edges[count++] = crossing;
+        } else if (high && cur < lo) {
+            high = false;
+            if (crossing >= 0.0f) ctx->edges[count++] = crossing;
+        }
+    }
+    return count;
+}
+
+/**
+ * @brief Check if an interval is close to a whole number of periods
+ */
+static bool fits_period(float interval, float period)
+{
+    float bits = interval / period;
+    float err = bits - floorf(bits + 0.5f);
+    return bits >= 0.75f && err > -0.25f && err < 0.25f;
+}
+
+/**
+ * @brief Estimate the bit period from crossing intervals
+ *
+ * Every interval is a whole number of bits. The shortest interval that most
+ * other intervals are a multiple of seeds the estimate (a partial first bit
+ * or a glitch is passed over), then the period is refined as total time over
+ * total bit count of the intervals that fit.
+ *
+ * @return Period in samples
+ */
+static float recover_period(const float *edges, uint32_t count)
+{
+    float period = 0.0f;
+    float floor_iv = 0.0f;
+    for (int seed = 0; seed < OSC_EYE_SEED_TRIES; seed++) {
+        float shortest = 0.0f;
+        for (uint32_t i = 1; i < count; i++) {
+            float iv = edges[i] - edges[i - 1];
+            if (iv > floor_iv && (shortest == 0.0f || iv < shortest)) shortest = iv;
+        }
+        if (shortest == 0.0f) break;
+        if (period == 0.0f) period = shortest;
+
+        uint32_t fit = 0;
+        for (uint32_t i = 1; i < count; i++) {
+            if (fits_period(edges[i] - edges[i - 1], shortest)) fit++;
+        }
+        if (fit * 4 >= (count - 1) * 3) {
+            period = shortest;
+            break;
+        }
+        floor_iv = shortest * 1.05f;
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        float sum_iv = 0.0f;
+        uint32_t sum_bits = 0;
+        for (uint32_t i = 1; i < count; i++) {
+            float iv = edges[i] - edges[i - 1];
+            if (!fits_period(iv, period)) continue;
+            sum_iv += iv;
+            sum_bits += (uint32_t)(iv / period + 0.5f);
+        }
+        if (sum_bits == 0) break;
+        period = sum_iv / (float)sum_bits;
+    }
+    return period;
+}
+
+/**
+ * @brief Position of the crossings within a unit interval (0..1), by circular mean
+ */
+static float crossing_phase(const float *edges, uint32_t count, float period)
+{
+    float sum_cos = 0.0f, sum_sin = 0.0f;
+    for (uint32_t i = 0; i < count; i++) {
+        float u = edges[i] / period;
+        float angle = 2.0f * (float)M_PI * (u - floorf(u));
+        sum_cos += cosf(angle);
+        sum_sin += sinf(angle);
+    }
+    float phase = atan2f(sum_sin, sum_cos) / (2.0f * (float)M_PI);
+    return (phase < 0.0f) ? phase + 1.0f : phase;
+}
+
+/**
+ * @brief Initialize eye diagram
+ */
+osc_eye_ctx_t *osc_eye_init(void)
+{
+    osc_eye_ctx_t *ctx = heap_caps_malloc(sizeof(osc_eye_ctx_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(osc_eye_ctx_t));
+
+    ctx->mutex = xSemaphoreCreateMutex();
+    ctx->counts = heap_caps_malloc(OSC_EYE_WIDTH * OSC_EYE_HEIGHT * sizeof(uint16_t), MALLOC_CAP_SPIRAM);
+    ctx->edges = heap_caps_malloc(OSC_EYE_MAX_EDGES * sizeof(float), MALLOC_CAP_SPIRAM);
+    if (ctx->mutex == NULL || ctx->counts == NULL || ctx->edges == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate eye buffers");
+        osc_eye_deinit(ctx);
+        return NULL;
+    }
+    clear_image(ctx);
+
+    ESP_LOGI(TAG, "Eye diagram initialized (%dx%d)", OSC_EYE_WIDTH, OSC_EYE_HEIGHT);
+    return ctx;
+}
+
+/**
+ * @brief Deinitialize eye diagram
+ */
+void osc_eye_deinit(osc_eye_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    if (ctx->mutex) vSemaphoreDelete(ctx->mutex);
+    heap_caps_free(ctx->counts);
+    heap_caps_free(ctx->edges);
+    free(ctx);
+}
+
+/**
+ * @brief Enable or disable accumulation
+ */
+void osc_eye_set_enabled(osc_eye_ctx_t *ctx, bool enabled)
+{
+    if (ctx == NULL) return;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    if (enabled && !ctx->enabled) clear_image(ctx);
+    ctx->enabled = enabled;
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Check if the eye accumulates captures
+ */
+bool osc_eye_is_enabled(osc_eye_ctx_t *ctx)
+{
+    if (ctx == NULL) return false;
+    return ctx->enabled;
+}
+
+/**
+ * @brief Set the voltage range of the image
+ */
+esp_err_t osc_eye_set_range(osc_eye_ctx_t *ctx, float v_min, float v_max)
+{
+    if (ctx == NULL || !(v_max > v_min)) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    if (!ctx->has_range || ctx->v_min != v_min || ctx->v_max != v_max) {
+        ctx->v_min = v_min;
+        ctx->v_max = v_max;
+        ctx->has_range = true;
+        clear_image(ctx);
+    }
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Set the bit period
+ */
+esp_err_t osc_eye_set_bit_period(osc_eye_ctx_t *ctx, float bit_period)
+{
+    if (ctx == NULL || bit_period < 0.0f) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    if (ctx->bit_period != bit_period) {
+        ctx->bit_period = bit_period;
+        clear_image(ctx);
+    }
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Clear the image
+ */
+void osc_eye_reset(osc_eye_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    clear_image(ctx);
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Fold one capture into the image
+ */
+esp_err_t osc_eye_accumulate(osc_eye_ctx_t *ctx, const float *data, uint32_t num_points,
+                             float time_per_sample)
+{
+    if (ctx == NULL || data == NULL || !(time_per_sample > 0.0f)) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    if (!ctx->has_range) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Timing: period given or recovered, phase always from the crossings
+    bool recover = (ctx->bit_period == 0.0f);
+    uint32_t min_edges = recover ? 3 : 2;
+    uint32_t edges = (num_points >= 2) ? find_edges(ctx, data, num_points) : 0;
+    float period = ctx->bit_period / time_per_sample;
+    if (recover && edges >= min_edges) {
+        period = recover_period(ctx->edges, edges);
+    }
+    if (edges < min_edges || period < 2.0f) {
+        ctx->stats.skipped++;
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+    float phase = crossing_phase(ctx->edges, edges, period);
+
+    // Sample i sits at (i / period - phase + 0.5) UI, crossings land on 0.5 and 1.5 UI
+    float start_ui = 0.5f - phase;
+    if (start_ui < 0.0f) start_ui += 2.0f;
+    uint32_t acc = (uint32_t)(uint64_t)((double)start_ui * 2147483648.0);   // Wraps at 2 UI
+    uint32_t step = (uint32_t)(2147483648.0 / period + 0.5);
+
+    const float v_max = ctx->v_max;
+    const float rows_per_volt = (float)OSC_EYE_HEIGHT / (ctx->v_max - ctx->v_min);
+    uint16_t *counts = ctx->counts;
+    uint32_t hits = 0;
+
+    for (uint32_t i = 0; i < num_points; i++) {
+        float y = (v_max - data[i]) * rows_per_volt;
+        if (y >= 0.0f && y < (float)OSC_EYE_HEIGHT) {
+            uint16_t *c = &counts[(uint32_t)y * OSC_EYE_WIDTH + (acc >> OSC_EYE_COLUMN_SHIFT)];
+            if (*c != UINT16_MAX) (*c)++;
+            hits++;
+        }
+        acc += step;
+    }
+
+    ctx->stats.captures++;
+    ctx->stats.hits = (ctx->stats.hits > UINT32_MAX - hits) ? UINT32_MAX : ctx->stats.hits + hits;
+    ctx->stats.bit_period = period * time_per_sample;
+    ctx->stats.recovered = recover;
+    ctx->generation++;
+
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Get statistics
+ */
+esp_err_t osc_eye_get_stats(osc_eye_ctx_t *ctx, osc_eye_stats_t *stats)
+{
+    if (ctx == NULL || stats == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    *stats = ctx->stats;
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Get the update counter
+ */
+uint32_t osc_eye_get_generation(osc_eye_ctx_t *ctx)
+{
+    if (ctx == NULL) return 0;
+    return ctx->generation;
+}
+
+/**
+ * @brief Render the image as density levels
+ */
+esp_err_t osc_eye_render(osc_eye_ctx_t *ctx, uint8_t *levels)
+{
+    if (ctx == NULL || levels == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    const uint32_t size = OSC_EYE_WIDTH * OSC_EYE_HEIGHT;
+    uint32_t max_count = 0;
+    for (uint32_t i = 0; i < size; i++) {
+        if (ctx->counts[i] > max_count) max_count = ctx->counts[i];
+    }
+    ctx->stats.max_count = max_count;
+
+    float scale = (max_count > 0) ? 1.0f / (float)max_count : 0.0f;
+    for (uint32_t i = 0; i < size; i++) {
+        uint16_t c = ctx->counts[i];
+        levels[i] = (c == 0) ? 0 : (uint8_t)(1.0f + 254.0f * sqrtf((float)c * scale));
+    }
+
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
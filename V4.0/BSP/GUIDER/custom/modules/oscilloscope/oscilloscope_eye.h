@@ -0,0 +1,151 @@
+/**
+ * @file oscilloscope_eye.h
+ * @brief Eye diagram accumulation
+ *
+ * Every capture is folded at the bit period into a two-unit-interval wide
+ * hit-count image; counts accumulate across captures. The period is either
+ * given or recovered from the mid-level crossings of each capture, and the
+ * fold phase is always taken from the crossings so successive captures line
+ * up (crossings at 0.5 and 1.5 UI, the eye opening in the middle).
+ *
+ * Folding runs a 32-bit fixed-point phase accumulator, one add and one
+ * counter increment per sample; no allocation after init.
+ */
+
+#ifndef OSCILLOSCOPE_EYE_H
+#define OSCILLOSCOPE_EYE_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Image geometry */
+#define OSC_EYE_WIDTH               256     // Columns across two unit intervals
+#define OSC_EYE_HEIGHT              128     // Rows across the voltage range
+#define OSC_EYE_MAX_EDGES           1024    // Crossings used for timing recovery per capture
+
+/* Eye statistics */
+typedef struct {
+    uint32_t captures;              // Captures folded into the image
+    uint32_t skipped;               // Captures without enough crossings to align
+    uint32_t hits;                  // Samples inside the image
+    uint32_t max_count;             // Highest pixel count
+    float bit_period;               // Period used for the last capture (seconds)
+    bool recovered;                 // Period was recovered (not given)
+} osc_eye_stats_t;
+
+/* Eye context */
+typedef struct osc_eye_ctx_t osc_eye_ctx_t;
+
+/**
+ * @brief Initialize eye diagram (empty, disabled, period recovered)
+ *
+ * @return Eye context or NULL on error
+ */
+osc_eye_ctx_t *osc_eye_init(void);
+
+/**
+ * @brief Deinitialize eye diagram
+ *
+ * @param ctx Eye context
+ */
+void osc_eye_deinit(osc_eye_ctx_t *ctx);
+
+/**
+ * @brief Enable or disable accumulation
+ *
+ * @param ctx Eye context
+ * @param enabled true to fold every capture
+ */
+void osc_eye_set_enabled(osc_eye_ctx_t *ctx, bool enabled);
+
+/**
+ * @brief Check if the eye accumulates captures
+ *
+ * @param ctx Eye context
+ * @return true if enabled
+ */
+bool osc_eye_is_enabled(osc_eye_ctx_t *ctx);
+
+/**
+ * @brief Set the voltage range of the image
+ *
+ * Clears the image if the range differs from the current one.
+ *
+ * @param ctx Eye context
+ * @param v_min Bottom row (volts)
+ * @param v_max Top row (volts)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if v_max <= v_min
+ */
+esp_err_t osc_eye_set_range(osc_eye_ctx_t *ctx, float v_min, float v_max);
+
+/**
+ * @brief Set the bit period
+ *
+ * Clears the image if the setting changes.
+ *
+ * @param ctx Eye context
+ * @param bit_period Seconds per bit, or 0 to recover it from each capture
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if negative
+ */
+esp_err_t osc_eye_set_bit_period(osc_eye_ctx_t *ctx, float bit_period);
+
+/**
+ * @brief Clear the image
+ *
+ * @param ctx Eye context
+ */
+void osc_eye_reset(osc_eye_ctx_t *ctx);
+
+/**
+ * @brief Fold one capture into the image
+ *
+ * @param ctx Eye context
+ * @param data Samples (volts)
+ * @param num_points Number of samples
+ * @param time_per_sample Sample interval (seconds)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no range is set,
+ *         ESP_ERR_NOT_FOUND if the capture has too few crossings (or the
+ *         period is under two samples) and was skipped
+ */
+esp_err_t osc_eye_accumulate(osc_eye_ctx_t *ctx, const float *data, uint32_t num_points,
+                             float time_per_sample);
+
+/**
+ * @brief Get statistics
+ *
+ * @param ctx Eye context
+ * @param stats Output: statistics
+ * @return ESP_OK on success
+ */
+esp_err_t osc_eye_get_stats(osc_eye_ctx_t *ctx, osc_eye_stats_t *stats);
+
+/**
+ * @brief Get the update counter (changes with every folded capture or reset)
+ *
+ * @param ctx Eye context
+ * @return Generation
+ */
+uint32_t osc_eye_get_generation(osc_eye_ctx_t *ctx);
+
+/**
+ * @brief Render the image as density levels
+ *
+ * Empty pixels are 0, hit pixels 1..255 (square-root scaled against the
+ * highest count). Row 0 is the top of the range.
+ *
+ * @param ctx Eye context
+ * @param levels Output: OSC_EYE_WIDTH * OSC_EYE_HEIGHT levels, row-major
+ * @return ESP_OK on success
+ */
+esp_err_t osc_eye_render(osc_eye_ctx_t *ctx, uint8_t *levels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_EYE_H
@@ -0,0 +1,486 @@
+/**
+ * @file oscilloscope_filter.c
+ * @brief Streaming filter stage implementation
+ */
+
+#include "oscilloscope_filter.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_dsp.h"
+#endif
+
+static const char *TAG = "OscFilter";
+
+#define OSC_FILTER_DEFAULT_ORDER    2
+#define OSC_FILTER_DEFAULT_TAPS     31
+#define OSC_FILTER_DEFAULT_Q        10.0f
+#define OSC_FILTER_MAX_CUTOFF_RATIO 0.45f
+#define OSC_FILTER_DF2_MIN_RATIO    0.01f   // Lowest fc / fs run in direct form II
+
+/* Filter type names */
+static const char *type_strings[] = {
+    [OSC_FILTER_NONE]       = "OFF",
+    [OSC_FILTER_LPF]        = "LPF",
+    [OSC_FILTER_HPF]        = "HPF",
+    [OSC_FILTER_NOTCH]      = "NOTCH",
+    [OSC_FILTER_DC_BLOCK]   = "AC",
+    [OSC_FILTER_FIR_LPF]    = "FIR",
+};
+
+/*
+ * IIR section kinds. Direct form II (the esp-dsp biquad) loses a corner far
+ * below the sample rate in single precision: its states grow as (fs/fc)^2,
+ * and a 50 Hz notch at 1 MSa/s is off by volts. Below
+ * OSC_FILTER_DF2_MIN_RATIO the same response runs as a trapezoidal
+ * state-variable filter, whose states track the band-pass and low-pass
+ * outputs and stay exact.
+ */
+typedef enum {
+    OSC_SECTION_BIQUAD = 0,     // coef = {b0, b1, b2, a1, a2}, state[] = w
+    OSC_SECTION_SVF,            // coef = {a1, a2, a3, m0, m1}, plus m2; state[] = ic1, ic2
+    OSC_SECTION_ONE_POLE,       // coef[0] = g / (1 + g), state[0] = integrator
+} osc_section_kind_t;
+
+/* out = m0 * in + m1 * band + m2 * low for an SVF section */
+typedef struct {
+    osc_section_kind_t kind;
+    float coef[5];
+    float m2;
+    float state[2];
+} osc_section_t;
+
+/* Filter chain context */
+struct osc_filter_ctx_t {
+    /* Configuration */
+    osc_filter_stage_config_t stages[OSC_FILTER_MAX_STAGES];
+    uint8_t num_stages;
+    float sample_rate_hz;
+
+    /* Designed sections (applied in order) */
+    osc_section_t sections[OSC_FILTER_MAX_BIQUADS];
+    uint8_t num_sections;
+
+    /* FIR (applied after the sections) */
+    float fir_coeffs[OSC_FILTER_MAX_FIR_TAPS];
+    float fir_delay[OSC_FILTER_MAX_FIR_TAPS];
+    uint8_t fir_taps;
+#ifdef ESP_PLATFORM
+    fir_f32_t fir;
+#else
+    uint8_t fir_pos;
+#endif
+};
+
+/**
+ * @brief Append a section, NULL if the chain is full
+ */
+static osc_section_t *add_section(osc_filter_ctx_t *ctx)
+{
+    if (ctx->num_sections >= OSC_FILTER_MAX_BIQUADS) {
+        ESP_LOGW(TAG, "Too many filter sections");
+        return NULL;
+    }
+
+    osc_section_t *sec = &ctx->sections[ctx->num_sections++];
+    memset(sec, 0, sizeof(*sec));
+    return sec;
+}
+
+/**
+ * @brief Add a second-order section
+ *
+ * The analog prototype is (m0 * s^2 + (m0 * k + m1) * s + m0 + m2) /
+ * (s^2 + k * s + 1), k = 1/Q, mapped to fc by the prewarped bilinear
+ * transform (the RBJ cookbook designs).
+ */
+static esp_err_t add_second_order(osc_filter_ctx_t *ctx, float fc, float k, float m0, float m1, float m2)
+{
+    osc_section_t *sec = add_section(ctx);
+    if (sec == NULL) return ESP_ERR_INVALID_ARG;
+
+    float g = tanf((float)M_PI * fc / ctx->sample_rate_hz);
+
+    if (fc >= OSC_FILTER_DF2_MIN_RATIO * ctx->sample_rate_hz) {
+        // Terms of A (1 - z^-1)^2 + B (1 - z^-2) + C (1 + z^-1)^2
+        float na = m0, nb = (m0 * k + m1) * g, nc = (m0 + m2) * g * g;
+        float da = 1.0f, db = k * g, dc = g * g;
+        float a0 = da + db + dc;
+        sec->kind = OSC_SECTION_BIQUAD;
+        sec->coef[0] = (na + nb + nc) / a0;
+        sec->coef[1] = 2.0f * (nc - na) / a0;
+        sec->coef[2] = (na - nb + nc) / a0;
+        sec->coef[3] = 2.0f * (dc - da) / a0;
+        sec->coef[4] = (da - db + dc) / a0;
+    } else {
+        float a1 = 1.0f / (1.0f + g * (g + k));
+        sec->kind = OSC_SECTION_SVF;
+        sec->coef[0] = a1;
+        sec->coef[1] = g * a1;
+        sec->coef[2] = g * g * a1;
+        sec->coef[3] = m0;
+        sec->coef[4] = m1;
+        sec->m2 = m2;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Butterworth LPF/HPF as a cascade of order/2 sections
+ */
+static esp_err_t design_butterworth(osc_filter_ctx_t *ctx, bool highpass, float fc, uint8_t order)
+{
+    for (uint8_t k = 0; k < order / 2; k++) {
+        // Pole pair k of an order-N Butterworth prototype: 1/Q = 2 cos(...)
+        float damping = 2.0f * cosf((float)M_PI * (2 * k + 1) / (2.0f * order));
+        esp_err_t ret;
+
+        if (highpass) {
+            ret = add_second_order(ctx, fc, damping, 1.0f, -damping, -1.0f);
+        } else {
+            ret = add_second_order(ctx, fc, damping, 0.0f, 0.0f, 1.0f);
+        }
+        if (ret != ESP_OK) return ret;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Windowed-sinc (Hamming) linear-phase FIR low-pass
+ */
+static void design_fir_lpf(osc_filter_ctx_t *ctx, float fc, uint8_t taps)
+{
+    float fn = fc / ctx->sample_rate_hz;
+    int mid = taps / 2;
+    float sum = 0.0f;
+
+    for (int i = 0; i < taps; i++) {
+        int n = i - mid;
+        float h = (n == 0) ? 2.0f * fn : sinf(2.0f * (float)M_PI * fn * n) / ((float)M_PI * n);
+        h *= 0.54f - 0.46f * cosf(2.0f * (float)M_PI * i / (taps - 1));
+        ctx->fir_coeffs[i] = h;
+        sum += h;
+    }
+
+    // Unity DC gain
+    for (int i = 0; i < taps; i++) {
+        ctx->fir_coeffs[i] /= sum;
+    }
+
+    ctx->fir_taps = taps;
+    memset(ctx->fir_delay, 0, sizeof(ctx->fir_delay));
+#ifdef ESP_PLATFORM
+    dsps_fir_init_f32(&ctx->fir, ctx->fir_coeffs, ctx->fir_delay, taps);
+#else
+    ctx->fir_pos = 0;
+#endif
+}
+
+/**
+ * @brief Design all stages for the current sampling rate
+ */
+static esp_err_t design(osc_filter_ctx_t *ctx)
+{
+    ctx->num_sections = 0;
+    ctx->fir_taps = 0;
+
+    float nyquist_limit = OSC_FILTER_MAX_CUTOFF_RATIO * ctx->sample_rate_hz;
+
+    for (uint8_t s = 0; s < ctx->num_stages; s++) {
+        const osc_filter_stage_config_t *stage = &ctx->stages[s];
+        float fc = stage->cutoff_hz;
+        if (fc > nyquist_limit) fc = nyquist_limit;
+        esp_err_t ret = ESP_OK;
+
+        switch (stage->type) {
+        case OSC_FILTER_LPF:
+        case OSC_FILTER_HPF: {
+            uint8_t order = stage->order ? stage->order : OSC_FILTER_DEFAULT_ORDER;
+            ret = design_butterworth(ctx, stage->type == OSC_FILTER_HPF, fc, order);
+            break;
+        }
+
+        case OSC_FILTER_NOTCH: {
+            float q = (stage->q > 0.0f) ? stage->q : OSC_FILTER_DEFAULT_Q;
+            ret = add_second_order(ctx, fc, 1.0f / q, 1.0f, -1.0f / q, 0.0f);
+            break;
+        }
+
+        case OSC_FILTER_DC_BLOCK: {
+            // First-order high-pass: input minus a one-pole low-pass
+            osc_section_t *sec = add_section(ctx);
+            if (sec == NULL) {
+                ret = ESP_ERR_INVALID_ARG;
+                break;
+            }
+            float g = tanf((float)M_PI * fc / ctx->sample_rate_hz);
+            sec->kind = OSC_SECTION_ONE_POLE;
+            sec->coef[0] = g / (1.0f + g);
+            break;
+        }
+
+        case OSC_FILTER_FIR_LPF:
+            design_fir_lpf(ctx, fc, stage->order ? stage->order : OSC_FILTER_DEFAULT_TAPS);
+            break;
+
+        default:
+            break;
+        }
+
+        if (ret != ESP_OK) return ret;
+    }
+
+    ESP_LOGI(TAG, "Designed %u section(s), FIR %u taps @ %.0f Hz",
+             ctx->num_sections, ctx->fir_taps, ctx->sample_rate_hz);
+    return ESP_OK;
+}
+
+/**
+ * @brief Trapezoidal state-variable section
+ */
+static void svf_process(osc_section_t *sec, const float *in, float *out, uint32_t len)
+{
+    const float a1 = sec->coef[0], a2 = sec->coef[1], a3 = sec->coef[2];
+    const float m0 = sec->coef[3], m1 = sec->coef[4], m2 = sec->m2;
+    float ic1 = sec->state[0];
+    float ic2 = sec->state[1];
+
+    for (uint32_t i = 0; i < len; i++) {
+        float x = in[i];
+        float v3 = x - ic2;
+        float band = a1 * ic1 + a2 * v3;
+        float low = ic2 + a2 * ic1 + a3 * v3;
+        ic1 = 2.0f * band - ic1;
+        ic2 = 2.0f * low - ic2;
+        out[i] = m0 * x + m1 * band + m2 * low;
+    }
+
+    sec->state[0] = ic1;
+    sec->state[1] = ic2;
+}
+
+/**
+ * @brief First-order high-pass: input minus a trapezoidal one-pole low-pass
+ */
+static void one_pole_process(osc_section_t *sec, const float *in, float *out, uint32_t len)
+{
+    const float g = sec->coef[0];
+    float ic = sec->state[0];
+
+    for (uint32_t i = 0; i < len; i++) {
+        float x = in[i];
+        float v = (x - ic) * g;
+        float low = v + ic;
+        ic = low + v;
+        out[i] = x - low;
+    }
+
+    sec->state[0] = ic;
+}
+
+#ifndef ESP_PLATFORM
+/**
+ * @brief Direct form II biquad (same arithmetic as dsps_biquad_f32)
+ */
+static void biquad_process(osc_section_t *sec, const float *in, float *out, uint32_t len)
+{
+    const float *c = sec->coef;
+    float w0 = sec->state[0];
+    float w1 = sec->state[1];
+
+    for (uint32_t i = 0; i < len; i++) {
+        float d0 = in[i] - c[3] * w0 - c[4] * w1;
+        out[i] = c[0] * d0 + c[1] * w0 + c[2] * w1;
+        w1 = w0;
+        w0 = d0;
+    }
+
+    sec->state[0] = w0;
+    sec->state[1] = w1;
+}
+
+/**
+ * @brief FIR with a circular delay line
+ */
+static void fir_process(osc_filter_ctx_t *ctx, const float *in, float *out, uint32_t len)
+{
+    uint8_t taps = ctx->fir_taps;
+
+    for (uint32_t i = 0; i < len; i++) {
+        ctx->fir_delay[ctx->fir_pos] = in[i];
+
+        float acc = 0.0f;
+        uint8_t idx = ctx->fir_pos;
+        for (uint8_t k = 0; k < taps; k++) {
+            acc += ctx->fir_coeffs[k] * ctx->fir_delay[idx];
+            idx = (idx == 0) ? taps - 1 : idx - 1;
+        }
+        out[i] = acc;
+
+        ctx->fir_pos = (ctx->fir_pos + 1 == taps) ? 0 : ctx->fir_pos + 1;
+    }
+}
+#endif
+
+/**
+ * @brief Initialize filter chain
+ */
+osc_filter_ctx_t *osc_filter_init(void)
+{
+    osc_filter_ctx_t *ctx = heap_caps_malloc(sizeof(osc_filter_ctx_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(osc_filter_ctx_t));
+    return ctx;
+}
+
+/**
+ * @brief Deinitialize filter chain
+ */
+void osc_filter_deinit(osc_filter_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+    free(ctx);
+}
+
+/**
+ * @brief Configure filter chain
+ */
+esp_err_t osc_filter_configure(osc_filter_ctx_t *ctx, const osc_filter_stage_config_t *stages,
+                               uint8_t num_stages, float sample_rate_hz)
+{
+    if (ctx == NULL || num_stages > OSC_FILTER_MAX_STAGES || sample_rate_hz <= 0.0f) return ESP_ERR_INVALID_ARG;
+    if (num_stages > 0 && stages == NULL) return ESP_ERR_INVALID_ARG;
+
+    bool has_fir = false;
+    for (uint8_t s = 0; s < num_stages; s++) {
+        const osc_filter_stage_config_t *stage = &stages[s];
+
+        if (stage->type <= OSC_FILTER_NONE || stage->type >= OSC_FILTER_TYPE_MAX || stage->cutoff_hz <= 0.0f) {
+            ESP_LOGW(TAG, "Stage %u: invalid filter", s);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if ((stage->type == OSC_FILTER_LPF || stage->type == OSC_FILTER_HPF) &&
+            (stage->order % 2 != 0 || stage->order > OSC_FILTER_MAX_ORDER)) {
+            ESP_LOGW(TAG, "Stage %u: Butterworth order must be 2, 4, 6 or 8", s);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (stage->type == OSC_FILTER_FIR_LPF) {
+            if (has_fir || (stage->order != 0 && (stage->order % 2 == 0 || stage->order < 3 ||
+                                                   stage->order > OSC_FILTER_MAX_FIR_TAPS))) {
+                ESP_LOGW(TAG, "Stage %u: one FIR per chain, odd length 3..%d", s, OSC_FILTER_MAX_FIR_TAPS);
+                return ESP_ERR_INVALID_ARG;
+            }
+            has_fir = true;
+        }
+    }
+
+    if (num_stages > 0) {
+        memcpy(ctx->stages, stages, num_stages * sizeof(osc_filter_stage_config_t));
+    }
+    ctx->num_stages = num_stages;
+    ctx->sample_rate_hz = sample_rate_hz;
+
+    return design(ctx);
+}
+
+/**
+ * @brief Redesign coefficients for a new sampling rate
+ */
+esp_err_t osc_filter_set_sample_rate(osc_filter_ctx_t *ctx, float sample_rate_hz)
+{
+    if (ctx == NULL || sample_rate_hz <= 0.0f) return ESP_ERR_INVALID_ARG;
+    if (ctx->sample_rate_hz == sample_rate_hz) return ESP_OK;
+
+    ctx->sample_rate_hz = sample_rate_hz;
+    return design(ctx);
+}
+
+/**
+ * @brief Clear filter state
+ */
+void osc_filter_reset(osc_filter_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    for (uint8_t i = 0; i < ctx->num_sections; i++) {
+        ctx->sections[i].state[0] = 0.0f;
+        ctx->sections[i].state[1] = 0.0f;
+    }
+    memset(ctx->fir_delay, 0, sizeof(ctx->fir_delay));
+#ifdef ESP_PLATFORM
+    if (ctx->fir_taps > 0) {
+        dsps_fir_init_f32(&ctx->fir, ctx->fir_coeffs, ctx->fir_delay, ctx->fir_taps);
+    }
+#else
+    ctx->fir_pos = 0;
+#endif
+}
+
+/**
+ * @brief Filter a block of samples
+ */
+esp_err_t osc_filter_process(osc_filter_ctx_t *ctx, const float *in, float *out, uint32_t len)
+{
+    if (ctx == NULL || in == NULL || out == NULL) return ESP_ERR_INVALID_ARG;
+
+    if (ctx->num_sections == 0 && ctx->fir_taps == 0) {
+        if (in != out) memcpy(out, in, len * sizeof(float));
+        return ESP_OK;
+    }
+
+    const float *src = in;
+    for (uint8_t i = 0; i < ctx->num_sections; i++) {
+        osc_section_t *sec = &ctx->sections[i];
+        switch (sec->kind) {
+        case OSC_SECTION_BIQUAD:
+#ifdef ESP_PLATFORM
+            dsps_biquad_f32(src, out, len, sec->coef, sec->state);
+#else
+            biquad_process(sec, src, out, len);
+#endif
+            break;
+        case OSC_SECTION_SVF:
+            svf_process(sec, src, out, len);
+            break;
+        case OSC_SECTION_ONE_POLE:
+            one_pole_process(sec, src, out, len);
+            break;
+        }
+        src = out;
+    }
+
+    if (ctx->fir_taps > 0) {
+#ifdef ESP_PLATFORM
+        dsps_fir_f32(&ctx->fir, src, out, len);
+#else
+        fir_process(ctx, src, out, len);
+#endif
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Check if the chain does anything
+ */
+bool osc_filter_is_active(osc_filter_ctx_t *ctx)
+{
+    if (ctx == NULL) return false;
+    return ctx->num_stages > 0;
+}
+
+/**
+ * @brief Get filter type name
+ */
+const char *osc_filter_get_type_str(osc_filter_type_t type)
+{
+    if (type >= OSC_FILTER_TYPE_MAX) return "?";
+    return type_strings[type];
+}
@@ -0,0 +1,137 @@
+/**
+ * @file oscilloscope_filter.h
+ * @brief Streaming filter stage for the oscilloscope acquisition path
+ *
+ * Filters run on blocks of samples between the ADC and the capture buffer:
+ * - Butterworth low-pass / high-pass (biquad cascade, designed on device)
+ * - Notch (e.g. 50/60 Hz hum)
+ * - DC-block (AC coupling)
+ * - Windowed-sinc FIR low-pass
+ *
+ * Filter state persists across blocks, so RUN mode output is seamless.
+ * On target the biquad and FIR kernels use esp-dsp; builds without
+ * ESP_PLATFORM use the portable C path with identical results. Sections
+ * with a corner below fs/100 run as state-variable filters on both, which
+ * stay accurate in single precision where the biquad does not.
+ */
+
+#ifndef OSCILLOSCOPE_FILTER_H
+#define OSCILLOSCOPE_FILTER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Filter limits */
+#define OSC_FILTER_MAX_STAGES       4       // Configured stages per chain
+#define OSC_FILTER_MAX_BIQUADS      8       // Second-order sections per chain
+#define OSC_FILTER_MAX_ORDER        8       // Highest Butterworth order
+#define OSC_FILTER_MAX_FIR_TAPS     63      // Longest FIR (odd, linear phase)
+
+/* AC coupling corner frequency (DC-block) */
+#define OSC_FILTER_AC_CUTOFF_HZ     10.0f
+
+/* Filter types */
+typedef enum {
+    OSC_FILTER_NONE = 0,
+    OSC_FILTER_LPF,             // Butterworth low-pass (order 2..8)
+    OSC_FILTER_HPF,             // Butterworth high-pass (order 2..8)
+    OSC_FILTER_NOTCH,           // Notch at cutoff_hz with quality factor q
+    OSC_FILTER_DC_BLOCK,        // First-order DC blocker (AC coupling)
+    OSC_FILTER_FIR_LPF,         // Windowed-sinc FIR low-pass (order = taps)
+    OSC_FILTER_TYPE_MAX
+} osc_filter_type_t;
+
+/* One filter stage */
+typedef struct {
+    osc_filter_type_t type;
+    float cutoff_hz;                // Corner / notch frequency
+    uint8_t order;                  // Butterworth order or FIR taps (0 = default)
+    float q;                        // Notch quality factor (0 = default)
+} osc_filter_stage_config_t;
+
+/* Filter chain context */
+typedef struct osc_filter_ctx_t osc_filter_ctx_t;
+
+/**
+ * @brief Initialize an empty (pass-through) filter chain
+ *
+ * @return Filter context or NULL on error
+ */
+osc_filter_ctx_t *osc_filter_init(void);
+
+/**
+ * @brief Deinitialize filter chain
+ *
+ * @param ctx Filter context
+ */
+void osc_filter_deinit(osc_filter_ctx_t *ctx);
+
+/**
+ * @brief Configure filter chain and design coefficients
+ *
+ * Clears filter state. Cutoffs above 0.45 * fs are clamped.
+ *
+ * @param ctx Filter context
+ * @param stages Stage list (may be NULL if num_stages is 0)
+ * @param num_stages Number of stages (0 = pass-through)
+ * @param sample_rate_hz Sampling rate the coefficients are designed for
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on an invalid stage
+ */
+esp_err_t osc_filter_configure(osc_filter_ctx_t *ctx, const osc_filter_stage_config_t *stages,
+                               uint8_t num_stages, float sample_rate_hz);
+
+/**
+ * @brief Redesign coefficients for a new sampling rate (keeps stage list)
+ *
+ * @param ctx Filter context
+ * @param sample_rate_hz New sampling rate
+ * @return ESP_OK on success
+ */
+esp_err_t osc_filter_set_sample_rate(osc_filter_ctx_t *ctx, float sample_rate_hz);
+
+/**
+ * @brief Clear filter state (delay lines)
+ *
+ * @param ctx Filter context
+ */
+void osc_filter_reset(osc_filter_ctx_t *ctx);
+
+/**
+ * @brief Filter a block of samples
+ *
+ * State carries over to the next call. in and out may be the same buffer.
+ *
+ * @param ctx Filter context
+ * @param in Input samples (volts)
+ * @param out Output samples (volts)
+ * @param len Number of samples
+ * @return ESP_OK on success
+ */
+esp_err_t osc_filter_process(osc_filter_ctx_t *ctx, const float *in, float *out, uint32_t len);
+
+/**
+ * @brief Check if the chain does anything
+ *
+ * @param ctx Filter context
+ * @return true if at least one stage is configured
+ */
+bool osc_filter_is_active(osc_filter_ctx_t *ctx);
+
+/**
+ * @brief Get filter type name for on-screen labels
+ *
+ * @param type Filter type
+ * @return Short name (e.g. "LPF")
+ */
+const char *osc_filter_get_type_str(osc_filter_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_FILTER_H
@@ -0,0 +1,276 @@
+/**
+ * @file oscilloscope_hist.c
+ * @brief Vertical histogram implementation
+ */
+
+#include "oscilloscope_hist.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+static const char *TAG = "OscHist";
+
+/* Halve all counts before the total would exceed this */
+#define OSC_HIST_TOTAL_LIMIT    0x7FFFFFFFu
+
+/* Histogram context */
+struct osc_hist_ctx_t {
+    uint32_t bins[OSC_HIST_BINS];
+    uint32_t total;
+    uint32_t clipped;
+    uint32_t captures;
+    uint32_t generation;
+
+    float v_min;
+    float v_max;
+    bool has_range;
+    bool enabled;
+
+    SemaphoreHandle_t mutex;
+};
+
+/**
+ * @brief Clear counts (mutex held)
+ */
+static void clear_counts(osc_hist_ctx_t *ctx)
+{
+    memset(ctx->bins, 0, sizeof(ctx->bins));
+    ctx->total = 0;
+    ctx->clipped = 0;
+    ctx->captures = 0;
+    ctx->generation++;
+}
+
+/**
+ * @brief Initialize histogram
+ */
+osc_hist_ctx_t *osc_hist_init(void)
+{
+    osc_hist_ctx_t *ctx = heap_caps_malloc(sizeof(osc_hist_ctx_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(osc_hist_ctx_t));
+
+    ctx->mutex = xSemaphoreCreateMutex();
+    if (ctx->mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        free(ctx);
+        return NULL;
+    }
+
+    ESP_LOGI(TAG, "Histogram initialized (%d bins)", OSC_HIST_BINS);
+    return ctx;
+}
+
+/**
+ * @brief Deinitialize histogram
+ */
+void osc_hist_deinit(osc_hist_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    vSemaphoreDelete(ctx->mutex);
+    free(ctx);
+}
+
+/**
+ * @brief Enable or disable accumulation
+ */
+void osc_hist_set_enabled(osc_hist_ctx_t *ctx, bool enabled)
+{
+    if (ctx == NULL) return;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    if (enabled && !ctx->enabled) clear_counts(ctx);
+    ctx->enabled = enabled;
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Check if the histogram accumulates captures
+ */
+bool osc_hist_is_enabled(osc_hist_ctx_t *ctx)
+{
+    if (ctx == NULL) return false;
+    return ctx->enabled;
+}
+
+/**
+ * @brief Set the binned voltage range
+ */
+esp_err_t osc_hist_set_range(osc_hist_ctx_t *ctx, float v_min, float v_max)
+{
+    if (ctx == NULL || !(v_max > v_min)) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    if (!ctx->has_range || ctx->v_min != v_min || ctx->v_max != v_max) {
+        ctx->v_min = v_min;
+        ctx->v_max = v_max;
+        ctx->has_range = true;
+        clear_counts(ctx);
+    }
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Clear the counts
+ */
+void osc_hist_reset(osc_hist_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    clear_counts(ctx);
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Add one capture window to the counts
+ */
+esp_err_t osc_hist_accumulate(osc_hist_ctx_t *ctx, const float *data, uint32_t num_points)
+{
+    if (ctx == NULL || (data == NULL && num_points > 0)) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    if (!ctx->has_range) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Long accumulations keep their shape: halve instead of overflowing
+    if (num_points > OSC_HIST_TOTAL_LIMIT - ctx->total) {
+        ctx->total = 0;
+        for (int b = 0; b < OSC_HIST_BINS; b++) {
+            ctx->bins[b] >>= 1;
+            ctx->total += ctx->bins[b];
+        }
+    }
+
+    const float v_min = ctx->v_min;
+    const float scale = (float)OSC_HIST_BINS / (ctx->v_max - ctx->v_min);
+    uint32_t *bins = ctx->bins;
+    uint32_t clipped = 0;
+
+    for (uint32_t i = 0; i < num_points; i++) {
+        float x = (data[i] - v_min) * scale;
+        if (x >= 0.0f && x < (float)OSC_HIST_BINS) {
+            bins[(uint32_t)x]++;
+        } else {
+            clipped++;
+        }
+    }
+
+    ctx->total += num_points - clipped;
+    ctx->clipped += clipped;
+    ctx->captures++;
+    ctx->generation++;
+
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Get statistics of the accumulated counts
+ */
+esp_err_t osc_hist_get_stats(osc_hist_ctx_t *ctx, osc_hist_stats_t *stats)
+{
+    if (ctx == NULL || stats == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    memset(stats, 0, sizeof(*stats));
+    stats->captures = ctx->captures;
+    stats->total = ctx->total;
+    stats->clipped = ctx->clipped;
+    if (ctx->total == 0) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Moments in bin units, summed exactly in integers
+    uint64_t sum = 0, sum_sq = 0;
+    int first = -1, last = 0, peak = 0;
+    for (int b = 0; b < OSC_HIST_BINS; b++) {
+        uint32_t c = ctx->bins[b];
+        if (c == 0) continue;
+        if (first < 0) first = b;
+        last = b;
+        if (c > ctx->bins[peak]) peak = b;
+        sum += (uint64_t)c * b;
+        sum_sq += (uint64_t)c * b * b;
+    }
+
+    float width = (ctx->v_max - ctx->v_min) / OSC_HIST_BINS;
+    float mean = (float)sum / ctx->total;
+    // Sheppard's correction removes the variance added by the bin width
+    float var = (float)sum_sq / ctx->total - mean * mean - 1.0f / 12.0f;
+
+    stats->mean = ctx->v_min + (mean + 0.5f) * width;
+    stats->sigma = (var > 0.0f) ? sqrtf(var) * width : 0.0f;
+    stats->peak = ctx->v_min + (peak + 0.5f) * width;
+    stats->peak_count = ctx->bins[peak];
+    stats->min = ctx->v_min + (first + 0.5f) * width;
+    stats->max = ctx->v_min + (last + 0.5f) * width;
+
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Get the update counter
+ */
+uint32_t osc_hist_get_generation(osc_hist_ctx_t *ctx)
+{
+    if (ctx == NULL) return 0;
+    return ctx->generation;
+}
+
+/**
+ * @brief Render the histogram as horizontal bars
+ */
+esp_err_t osc_hist_render(osc_hist_ctx_t *ctx, uint8_t *levels, uint16_t width, uint16_t height)
+{
+    if (ctx == NULL || levels == NULL || width == 0 || height == 0) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    uint32_t max_count = 0;
+    for (int b = 0; b < OSC_HIST_BINS; b++) {
+        if (ctx->bins[b] > max_count) max_count = ctx->bins[b];
+    }
+
+    for (uint16_t r = 0; r < height; r++) {
+        uint8_t *row = levels + (uint32_t)r * width;
+
+        // Bins covered by this row (row 0 = top of the range), the fullest one sets the bar
+        uint32_t b1 = (uint32_t)(height - r) * OSC_HIST_BINS / height;
+        uint32_t b0 = (uint32_t)(height - 1 - r) * OSC_HIST_BINS / height;
+        if (b1 <= b0) b1 = b0 + 1;
+        uint32_t c = 0;
+        for (uint32_t b = b0; b < b1; b++) {
+            if (ctx->bins[b] > c) c = ctx->bins[b];
+        }
+
+        uint16_t len = 0;
+        uint8_t level = 0;
+        if (c > 0) {
+            float norm = (float)c / max_count;
+            len = (uint16_t)(norm * width + 0.5f);
+            if (len == 0) len = 1;
+            level = (uint8_t)(1.0f + 254.0f * sqrtf(norm));
+        }
+        memset(row, level, len);
+        memset(row + len, 0, width - len);
+    }
+
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file oscilloscope_hist.h
+ * @brief Vertical (voltage) histogram of the visible window
+ *
+ * Samples are binned into integer counters over a fixed voltage range,
+ * normally the screen range. Counts accumulate across captures until the
+ * range changes or the histogram is reset, one multiply and one increment
+ * per sample. Mean, sigma and peak (most frequent level) are derived from
+ * the bins on request.
+ */
+
+#ifndef OSCILLOSCOPE_HIST_H
+#define OSCILLOSCOPE_HIST_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Histogram limits */
+#define OSC_HIST_BINS               256
+
+/* Histogram statistics */
+typedef struct {
+    uint32_t captures;              // Captures accumulated
+    uint32_t total;                 // Samples inside the range
+    uint32_t clipped;               // Samples outside the range (not binned)
+    float mean;                     // Volts
+    float sigma;                    // Standard deviation (volts, bin-width corrected)
+    float peak;                     // Center of the most populated bin (volts)
+    uint32_t peak_count;
+    float min;                      // Lowest / highest populated bin (volts)
+    float max;
+} osc_hist_stats_t;
+
+/* Histogram context */
+typedef struct osc_hist_ctx_t osc_hist_ctx_t;
+
+/**
+ * @brief Initialize histogram (empty, disabled)
+ *
+ * @return Histogram context or NULL on error
+ */
+osc_hist_ctx_t *osc_hist_init(void);
+
+/**
+ * @brief Deinitialize histogram
+ *
+ * @param ctx Histogram context
+ */
+void osc_hist_deinit(osc_hist_ctx_t *ctx);
+
+/**
+ * @brief Enable or disable accumulation
+ *
+ * @param ctx Histogram context
+ * @param enabled true to accumulate every capture
+ */
+void osc_hist_set_enabled(osc_hist_ctx_t *ctx, bool enabled);
+
+/**
+ * @brief Check if the histogram accumulates captures
+ *
+ * @param ctx Histogram context
+ * @return true if enabled
+ */
+bool osc_hist_is_enabled(osc_hist_ctx_t *ctx);
+
+/**
+ * @brief Set the binned voltage range
+ *
+ * Clears the counts if the range differs from the current one.
+ *
+ * @param ctx Histogram context
+ * @param v_min Bottom of the lowest bin (volts)
+ * @param v_max Top of the highest bin (volts)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if v_max <= v_min
+ */
+esp_err_t osc_hist_set_range(osc_hist_ctx_t *ctx, float v_min, float v_max);
+
+/**
+ * @brief Clear the counts
+ *
+ * @param ctx Histogram context
+ */
+void osc_hist_reset(osc_hist_ctx_t *ctx);
+
+/**
+ * @brief Add one capture window to the counts
+ *
+ * @param ctx Histogram context
+ * @param data Samples (volts)
+ * @param num_points Number of samples
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no range is set
+ */
+esp_err_t osc_hist_accumulate(osc_hist_ctx_t *ctx, const float *data, uint32_t num_points);
+
+/**
+ * @brief Get statistics of the accumulated counts
+ *
+ * @param ctx Histogram context
+ * @param stats Output: statistics
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if nothing was binned
+ */
+esp_err_t osc_hist_get_stats(osc_hist_ctx_t *ctx, osc_hist_stats_t *stats);
+
+/**
+ * @brief Get the update counter (changes with every accumulated capture or reset)
+ *
+ * @param ctx Histogram context
+ * @return Generation
+ */
+uint32_t osc_hist_get_generation(osc_hist_ctx_t *ctx);
+
+/**
+ * @brief Render the histogram as horizontal bars
+ *
+ * Row 0 is the top of the range. Each row gets a bar from column 0 whose
+ * length follows its count; bar pixels hold a density level 1..255
+ * (square-root scaled against the highest count), background pixels 0.
+ *
+ * @param ctx Histogram context
+ * @param levels Output: width * height levels, row-major
+ * @param width Image width
+ * @param height Image height
+ * @return ESP_OK on success
+ */
+esp_err_t osc_hist_render(osc_hist_ctx_t *ctx, uint8_t *levels, uint16_t width, uint16_t height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_HIST_H
@@ -6,12 +6,30 @@
 #include "oscilloscope_integration.h"
 #include "oscilloscope_core.h"
 #include "oscilloscope_adc.h"
+#include "oscilloscope_scpi.h"
 #include "esp_log.h"
+#include <math.h>
 
 static const char *TAG = "OscIntegration";
 
+#define OSC_BODE_ACQUIRE_TIMEOUT_MS     200
+
 /* Global oscilloscope context - exported for use by event handlers */
 osc_core_ctx_t *g_osc_core = NULL;
+osc_math_ctx_t *g_osc_math = NULL;
+osc_decode_ctx_t *g_osc_decode = NULL;
+osc_mask_ctx_t *g_osc_mask = NULL;
+osc_search_ctx_t *g_osc_search = NULL;
+osc_ref_ctx_t *g_osc_ref = NULL;
+osc_hist_ctx_t *g_osc_hist = NULL;
+osc_eye_ctx_t *g_osc_eye = NULL;
+osc_deepmem_t *g_osc_deep = NULL;
+osc_bode_ctx_t *g_osc_bode = NULL;
+osc_recorder_ctx_t *g_osc_recorder = NULL;
+
+/* Bode stimulus (registered by the signal generator) */
+static osc_bode_generator_t s_bode_generator;
+static bool s_bode_generator_set = false;
 
 /**
  * @brief Initialize oscilloscope integration
@@ -34,15 +52,91 @@ esp_err_t osc_integration_init(void)
     osc_core_set_time_scale(g_osc_core, OSC_TIME_2MS);
     osc_core_set_volt_scale(g_osc_core, OSC_VOLT_1V);
     
-    // Configure trigger
+    // Configure trigger (free-running until an advanced trigger is selected)
     osc_trigger_config_t trigger = {
-        .enabled = true,
+        .enabled = false,
         .level_voltage = 1.65f,  // Mid-range for 3.3V ADC
         .rising_edge = true,
         .pre_trigger_ratio = 0.5f,
     };
     osc_core_set_trigger(g_osc_core, &trigger);
     
+    // MATH engine is optional - the scope still works without it
+    g_osc_math = osc_math_init();
+    if (g_osc_math == NULL) {
+        ESP_LOGW(TAG, "MATH engine unavailable");
+    }
+    
+    // Protocol decoder is optional as well
+    g_osc_decode = osc_decode_init();
+    if (g_osc_decode == NULL) {
+        ESP_LOGW(TAG, "Protocol decoder unavailable");
+    }
+    
+    // Mask tester is attached disabled; the UI enables it once a mask exists
+    g_osc_mask = osc_mask_init();
+    if (g_osc_mask != NULL) {
+        osc_core_set_mask(g_osc_core, g_osc_mask, false);
+    } else {
+        ESP_LOGW(TAG, "Mask tester unavailable");
+    }
+    
+    // Search-and-mark over stopped captures
+    g_osc_search = osc_search_init();
+    if (g_osc_search == NULL) {
+        ESP_LOGW(TAG, "Capture search unavailable");
+    }
+    
+    // Reference slots, restored from SD card when saved there before
+    g_osc_ref = osc_ref_init();
+    if (g_osc_ref != NULL) {
+        char path[48];
+        for (uint8_t slot = 0; slot < OSC_REF_SLOT_COUNT; slot++) {
+            osc_ref_get_default_path(slot, path, sizeof(path));
+            osc_ref_load(g_osc_ref, slot, path);
+        }
+    } else {
+        ESP_LOGW(TAG, "Reference slots unavailable");
+    }
+    
+    // Histogram and eye diagram are attached disabled; the UI enables the selected one
+    g_osc_hist = osc_hist_init();
+    g_osc_eye = osc_eye_init();
+    if (g_osc_hist == NULL || g_osc_eye == NULL) {
+        ESP_LOGW(TAG, "Histogram / eye diagram unavailable");
+    }
+    osc_core_set_analysis(g_osc_core, g_osc_hist, g_osc_eye);
+    
+    // Deep memory pool: the largest that fits in PSRAM, halving down to 1M points
+    for (uint32_t capacity = OSC_DEEPMEM_MAX_POINTS; g_osc_deep == NULL && capacity >= OSC_DEEPMEM_MIN_POINTS;
+         capacity /= 2) {
+        g_osc_deep = osc_deepmem_init(capacity);
+    }
+    if (g_osc_deep != NULL) {
+        osc_core_set_deep_memory(g_osc_core, g_osc_deep);
+    } else {
+        ESP_LOGW(TAG, "Deep memory unavailable");
+    }
+    
+    // Bode analyzer captures are bounded by the ADC storage depth
+    osc_bode_config_t bode_config;
+    osc_bode_get_default_config(&bode_config);
+    g_osc_bode = osc_bode_init(bode_config.max_samples);
+    if (g_osc_bode == NULL) {
+        ESP_LOGW(TAG, "Bode analyzer unavailable");
+    }
+    
+    // Streaming recorder: block pool in PSRAM, idle until a recording starts
+    g_osc_recorder = osc_recorder_init(NULL);
+    if (g_osc_recorder == NULL) {
+        ESP_LOGW(TAG, "Streaming recorder unavailable");
+    }
+    
+    // Remote control on the SCPI port; settings wait for osc_scpi_set_ui()
+    if (osc_scpi_start(g_osc_core, 0) != ESP_OK) {
+        ESP_LOGW(TAG, "SCPI server unavailable");
+    }
+    
     ESP_LOGI(TAG, "Oscilloscope integration initialized");
     return ESP_OK;
 }
@@ -52,6 +146,58 @@ esp_err_t osc_integration_init(void)
  */
 void osc_integration_deinit(void)
 {
+    // Closing the connections releases the captures they pinned
+    osc_scpi_stop();
+    // The sweep task uses the core until it has ended
+    if (g_osc_bode != NULL) {
+        osc_bode_deinit(g_osc_bode);
+        g_osc_bode = NULL;
+    }
+    // The backlog of a recording is written out before the pool goes
+    if (g_osc_recorder != NULL) {
+        osc_core_stop_recording(g_osc_core);
+        osc_recorder_deinit(g_osc_recorder);
+        g_osc_recorder = NULL;
+    }
+    if (g_osc_core != NULL) {
+        osc_core_set_deep_memory(g_osc_core, NULL);
+        osc_core_set_analysis(g_osc_core, NULL, NULL);
+    }
+    if (g_osc_deep != NULL) {
+        osc_deepmem_deinit(g_osc_deep);
+        g_osc_deep = NULL;
+    }
+    if (g_osc_eye != NULL) {
+        osc_eye_deinit(g_osc_eye);
+        g_osc_eye = NULL;
+    }
+    if (g_osc_hist != NULL) {
+        osc_hist_deinit(g_osc_hist);
+        g_osc_hist = NULL;
+    }
+    if (g_osc_ref != NULL) {
+        osc_ref_deinit(g_osc_ref);
+        g_osc_ref = NULL;
+    }
+    if (g_osc_search != NULL) {
+        osc_search_deinit(g_osc_search);
+        g_osc_search = NULL;
+    }
+    if (g_osc_mask != NULL) {
+        if (g_osc_core != NULL) {
+            osc_core_set_mask(g_osc_core, NULL, false);
+        }
+        osc_mask_deinit(g_osc_mask);
+        g_osc_mask = NULL;
+    }
+    if (g_osc_decode != NULL) {
+        osc_decode_deinit(g_osc_decode);
+        g_osc_decode = NULL;
+    }
+    if (g_osc_math != NULL) {
+        osc_math_deinit(g_osc_math);
+        g_osc_math = NULL;
+    }
     if (g_osc_core != NULL) {
         osc_core_deinit(g_osc_core);
         g_osc_core = NULL;
@@ -85,3 +231,78 @@ bool osc_integration_is_running(void)
     if (g_osc_core == NULL) return false;
     return (osc_core_get_state(g_osc_core) == OSC_STATE_RUNNING);
 }
+
+/**
+ * @brief Bode io: program the generator
+ */
+static esp_err_t bode_set_stimulus(void *user, float frequency_hz)
+{
+    return s_bode_generator.set_frequency(s_bode_generator.user, frequency_hz);
+}
+
+/**
+ * @brief Bode io: select the ADC rate
+ */
+static float bode_set_sample_rate(void *user, float min_rate, float max_rate)
+{
+    return osc_core_set_acquire_rate(g_osc_core, min_rate, max_rate);
+}
+
+/**
+ * @brief Bode io: capture from the scope input (no stimulus phase reference)
+ */
+static esp_err_t bode_capture(void *user, float *buffer, uint32_t count, float *stimulus_phase)
+{
+    *stimulus_phase = NAN;
+    return osc_core_acquire(g_osc_core, buffer, count, OSC_BODE_ACQUIRE_TIMEOUT_MS);
+}
+
+/**
+ * @brief Bode io: restore the acquisition settings
+ */
+static void bode_finish(void *user)
+{
+    osc_core_end_acquire(g_osc_core);
+}
+
+/**
+ * @brief Register the signal generator used as Bode stimulus
+ */
+void osc_integration_set_bode_generator(const osc_bode_generator_t *generator)
+{
+    if (generator != NULL && generator->set_frequency != NULL) {
+        s_bode_generator = *generator;
+        s_bode_generator_set = true;
+    } else {
+        s_bode_generator_set = false;
+    }
+    ESP_LOGI(TAG, "Bode generator %s", s_bode_generator_set ? "registered" : "removed");
+}
+
+/**
+ * @brief Start a Bode sweep of the registered generator against the scope input
+ */
+esp_err_t osc_integration_bode_start(void)
+{
+    if (g_osc_bode == NULL || !s_bode_generator_set) return ESP_ERR_NOT_SUPPORTED;
+    if (!osc_integration_is_running()) return ESP_ERR_INVALID_STATE;
+
+    osc_bode_config_t config;
+    osc_bode_get_default_config(&config);
+    if (s_bode_generator.amplitude > 0.0f) {
+        config.amplitude = s_bode_generator.amplitude;
+    }
+    uint32_t depth = osc_core_get_acquire_depth(g_osc_core);
+    if (depth > 0 && config.max_samples > depth) {
+        config.max_samples = depth;
+    }
+
+    const osc_bode_io_t io = {
+        .set_stimulus = bode_set_stimulus,
+        .set_sample_rate = bode_set_sample_rate,
+        .capture = bode_capture,
+        .finish = bode_finish,
+        .user = NULL,
+    };
+    return osc_bode_start(g_osc_bode, &config, &io);
+}
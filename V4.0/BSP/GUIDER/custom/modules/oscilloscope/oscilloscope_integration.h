@@ -7,6 +7,7 @@
 #define OSCILLOSCOPE_INTEGRATION_H
 
 #include "oscilloscope_core.h"
+#include "oscilloscope_bode.h"
 #include "esp_err.h"
 
 #ifdef __cplusplus
@@ -16,6 +17,41 @@ extern "C" {
 /* Global oscilloscope core context - accessible by event handlers */
 extern osc_core_ctx_t *g_osc_core;
 
+/* Global MATH engine context - NULL if MATH is unavailable */
+extern osc_math_ctx_t *g_osc_math;
+
+/* Global protocol decoder context - NULL if decoding is unavailable */
+extern osc_decode_ctx_t *g_osc_decode;
+
+/* Global mask tester context - NULL if mask testing is unavailable */
+extern osc_mask_ctx_t *g_osc_mask;
+
+/* Global capture search context - NULL if search is unavailable */
+extern osc_search_ctx_t *g_osc_search;
+
+/* Global reference slots (REF A-D) - NULL if references are unavailable */
+extern osc_ref_ctx_t *g_osc_ref;
+
+/* Global histogram / eye diagram accumulators - NULL if unavailable */
+extern osc_hist_ctx_t *g_osc_hist;
+extern osc_eye_ctx_t *g_osc_eye;
+
+/* Global deep memory (1M-8M point records) - NULL if the PSRAM pool could not be allocated */
+extern osc_deepmem_t *g_osc_deep;
+
+/* Global Bode analyzer - NULL if unavailable */
+extern osc_bode_ctx_t *g_osc_bode;
+
+/* Global streaming recorder - NULL if its block pool could not be allocated */
+extern osc_recorder_ctx_t *g_osc_recorder;
+
+/* Signal generator driving the Bode stimulus */
+typedef struct {
+    esp_err_t (*set_frequency)(void *user, float frequency_hz);
+    float amplitude;                // Output peak amplitude (volts)
+    void *user;
+} osc_bode_generator_t;
+
 /**
  * @brief Initialize oscilloscope integration
  */
@@ -41,6 +77,23 @@ esp_err_t osc_integration_stop(void);
  */
 bool osc_integration_is_running(void);
 
+/**
+ * @brief Register the signal generator used as Bode stimulus (NULL unregisters)
+ */
+void osc_integration_set_bode_generator(const osc_bode_generator_t *generator);
+
+/**
+ * @brief Start a Bode sweep of the registered generator against the scope input
+ *
+ * The scope must be running; the sweep runs in the background and restores
+ * the acquisition settings when it ends. The ADC path has no stimulus phase
+ * reference, so points carry gain only (phase NAN).
+ *
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED without a generator or
+ *         analyzer, ESP_ERR_INVALID_STATE if stopped or already sweeping
+ */
+esp_err_t osc_integration_bode_start(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,416 @@
+/**
+ * @file oscilloscope_mask.c
+ * @brief Pass/fail mask testing implementation
+ */
+
+#include "oscilloscope_mask.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+static const char *TAG = "OscMask";
+
+#define OSC_MASK_FILE_MAGIC     "OSCM"
+#define OSC_MASK_FILE_VERSION   1
+
+/* Mask file header (followed by upper[columns] and lower[columns]) */
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint16_t version;
+    uint16_t columns;
+    float time_per_column;
+    float tol_y_v;
+    uint16_t tol_x_columns;
+    uint16_t reserved;
+} osc_mask_file_header_t;
+
+/* Mask context */
+struct osc_mask_ctx_t {
+    /* Compiled mask (PSRAM) */
+    float *upper;
+    float *lower;
+    uint16_t columns;
+    float time_per_column;
+    float tol_y_v;
+    uint16_t tol_x_columns;
+    bool valid;
+    bool enabled;
+
+    /* Scratch envelope of the capture under test */
+    float *env_max;
+    float *env_min;
+
+    osc_mask_stats_t stats;
+
+    /* Synchronization */
+    SemaphoreHandle_t mutex;
+};
+
+/**
+ * @brief Min/max of every column of the window
+ *
+ * @return Number of columns that lie inside the record
+ */
+static uint16_t decimate_envelope(const float *data, uint32_t num_points, uint32_t start_idx,
+                                  float sample_step, uint16_t columns, float *env_max, float *env_min)
+{
+    uint16_t c;
+    for (c = 0; c < columns; c++) {
+        uint32_t s0 = start_idx + (uint32_t)(c * sample_step);
+        uint32_t s1 = start_idx + (uint32_t)((c + 1) * sample_step);
+        if (s0 >= num_points) break;
+        if (s1 <= s0) s1 = s0 + 1;
+        if (s1 > num_points) s1 = num_points;
+
+        float vmax = data[s0];
+        float vmin = data[s0];
+        for (uint32_t i = s0 + 1; i < s1; i++) {
+            float v = data[i];
+            if (v > vmax) vmax = v;
+            if (v < vmin) vmin = v;
+        }
+        env_max[c] = vmax;
+        env_min[c] = vmin;
+    }
+    return c;
+}
+
+/**
+ * @brief Initialize mask tester
+ */
+osc_mask_ctx_t *osc_mask_init(void)
+{
+    osc_mask_ctx_t *ctx = heap_caps_malloc(sizeof(osc_mask_ctx_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(osc_mask_ctx_t));
+
+    ctx->mutex = xSemaphoreCreateMutex();
+    ctx->upper = heap_caps_malloc(OSC_MASK_MAX_COLUMNS * sizeof(float), MALLOC_CAP_SPIRAM);
+    ctx->lower = heap_caps_malloc(OSC_MASK_MAX_COLUMNS * sizeof(float), MALLOC_CAP_SPIRAM);
+    ctx->env_max = heap_caps_malloc(OSC_MASK_MAX_COLUMNS * sizeof(float), MALLOC_CAP_SPIRAM);
+    ctx->env_min = heap_caps_malloc(OSC_MASK_MAX_COLUMNS * sizeof(float), MALLOC_CAP_SPIRAM);
+
+    if (ctx->mutex == NULL || ctx->upper == NULL || ctx->lower == NULL ||
+        ctx->env_max == NULL || ctx->env_min == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate mask buffers");
+        osc_mask_deinit(ctx);
+        return NULL;
+    }
+
+    ESP_LOGI(TAG, "Mask tester initialized");
+    return ctx;
+}
+
+/**
+ * @brief Deinitialize mask tester
+ */
+void osc_mask_deinit(osc_mask_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    if (ctx->upper) heap_caps_free(ctx->upper);
+    if (ctx->lower) heap_caps_free(ctx->lower);
+    if (ctx->env_max) heap_caps_free(ctx->env_max);
+    if (ctx->env_min) heap_caps_free(ctx->env_min);
+    if (ctx->mutex) vSemaphoreDelete(ctx->mutex);
+    heap_caps_free(ctx);
+}
+
+/**
+ * @brief Compile a mask from a reference record
+ */
+esp_err_t osc_mask_create(osc_mask_ctx_t *ctx, const float *data, uint32_t num_points,
+                          uint32_t start_idx, float sample_step, uint16_t columns,
+                          uint16_t tol_x_columns, float tol_y_v, float time_per_column)
+{
+    if (ctx == NULL || data == NULL || num_points == 0) return ESP_ERR_INVALID_ARG;
+    if (columns == 0 || columns > OSC_MASK_MAX_COLUMNS || sample_step <= 0.0f) return ESP_ERR_INVALID_ARG;
+    if (tol_y_v < 0.0f) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    uint16_t valid = decimate_envelope(data, num_points, start_idx, sample_step, columns,
+                                       ctx->env_max, ctx->env_min);
+    if (valid == 0) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Columns past the end of the reference repeat the last one
+    for (uint16_t c = valid; c < columns; c++) {
+        ctx->env_max[c] = ctx->env_max[valid - 1];
+        ctx->env_min[c] = ctx->env_min[valid - 1];
+    }
+
+    // Widen horizontally (sliding max/min over +/-X columns), then vertically
+    for (uint16_t c = 0; c < columns; c++) {
+        int lo = (int)c - tol_x_columns;
+        int hi = (int)c + tol_x_columns;
+        if (lo < 0) lo = 0;
+        if (hi > columns - 1) hi = columns - 1;
+
+        float vmax = ctx->env_max[lo];
+        float vmin = ctx->env_min[lo];
+        for (int k = lo + 1; k <= hi; k++) {
+            if (ctx->env_max[k] > vmax) vmax = ctx->env_max[k];
+            if (ctx->env_min[k] < vmin) vmin = ctx->env_min[k];
+        }
+        ctx->upper[c] = vmax + tol_y_v;
+        ctx->lower[c] = vmin - tol_y_v;
+    }
+
+    ctx->columns = columns;
+    ctx->time_per_column = time_per_column;
+    ctx->tol_x_columns = tol_x_columns;
+    ctx->tol_y_v = tol_y_v;
+    ctx->valid = true;
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+
+    xSemaphoreGive(ctx->mutex);
+
+    ESP_LOGI(TAG, "Mask created: %u columns, +/-%u col, +/-%.3fV", columns, tol_x_columns, tol_y_v);
+    return ESP_OK;
+}
+
+/**
+ * @brief Save compiled mask to a file
+ */
+esp_err_t osc_mask_save(osc_mask_ctx_t *ctx, const char *path)
+{
+    if (ctx == NULL || path == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    if (!ctx->valid) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        xSemaphoreGive(ctx->mutex);
+        ESP_LOGE(TAG, "Failed to create %s: %s", path, strerror(errno));
+        return ESP_FAIL;
+    }
+
+    osc_mask_file_header_t header = {
+        .version = OSC_MASK_FILE_VERSION,
+        .columns = ctx->columns,
+        .time_per_column = ctx->time_per_column,
+        .tol_y_v = ctx->tol_y_v,
+        .tol_x_columns = ctx->tol_x_columns,
+    };
+    memcpy(header.magic, OSC_MASK_FILE_MAGIC, sizeof(header.magic));
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(ctx->upper, sizeof(float), ctx->columns, f) == ctx->columns &&
+              fwrite(ctx->lower, sizeof(float), ctx->columns, f) == ctx->columns;
+    fclose(f);
+
+    xSemaphoreGive(ctx->mutex);
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to write %s", path);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Mask saved: %s", path);
+    return ESP_OK;
+}
+
+/**
+ * @brief Load a compiled mask from a file
+ */
+esp_err_t osc_mask_load(osc_mask_ctx_t *ctx, const char *path)
+{
+    if (ctx == NULL || path == NULL) return ESP_ERR_INVALID_ARG;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        ESP_LOGW(TAG, "Mask file not found: %s", path);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    osc_mask_file_header_t header;
+    if (fread(&header, sizeof(header), 1, f) != 1 ||
+        memcmp(header.magic, OSC_MASK_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != OSC_MASK_FILE_VERSION ||
+        header.columns == 0 || header.columns > OSC_MASK_MAX_COLUMNS) {
+        fclose(f);
+        ESP_LOGE(TAG, "Invalid mask file: %s", path);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    bool ok = fread(ctx->upper, sizeof(float), header.columns, f) == header.columns &&
+              fread(ctx->lower, sizeof(float), header.columns, f) == header.columns;
+    fclose(f);
+
+    if (ok) {
+        ctx->columns = header.columns;
+        ctx->time_per_column = header.time_per_column;
+        ctx->tol_x_columns = header.tol_x_columns;
+        ctx->tol_y_v = header.tol_y_v;
+        memset(&ctx->stats, 0, sizeof(ctx->stats));
+    }
+    // A truncated file leaves the buffers half-written: drop the mask
+    ctx->valid = ok;
+    if (!ok) ctx->enabled = false;
+
+    xSemaphoreGive(ctx->mutex);
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Truncated mask file: %s", path);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    ESP_LOGI(TAG, "Mask loaded: %s (%u columns)", path, header.columns);
+    return ESP_OK;
+}
+
+/**
+ * @brief Enable or disable checking
+ */
+esp_err_t osc_mask_set_enabled(osc_mask_ctx_t *ctx, bool enabled)
+{
+    if (ctx == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    esp_err_t ret = ESP_OK;
+    if (enabled && !ctx->valid) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        ctx->enabled = enabled;
+    }
+
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Check if a mask is loaded and enabled
+ */
+bool osc_mask_is_enabled(osc_mask_ctx_t *ctx)
+{
+    if (ctx == NULL) return false;
+    return ctx->valid && ctx->enabled;
+}
+
+/**
+ * @brief Check a capture against the mask
+ */
+esp_err_t osc_mask_check(osc_mask_ctx_t *ctx, const float *data, uint32_t num_points,
+                         uint32_t start_idx, float sample_step, osc_mask_result_t *result)
+{
+    if (ctx == NULL || data == NULL || sample_step <= 0.0f) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    if (!ctx->valid || !ctx->enabled) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint16_t columns = decimate_envelope(data, num_points, start_idx, sample_step, ctx->columns,
+                                         ctx->env_max, ctx->env_min);
+
+    // One branch-free compare pass; the first violation is located only on failure
+    const float *upper = ctx->upper;
+    const float *lower = ctx->lower;
+    const float *env_max = ctx->env_max;
+    const float *env_min = ctx->env_min;
+    uint32_t violations = 0;
+    for (uint16_t c = 0; c < columns; c++) {
+        violations += (uint32_t)((env_max[c] > upper[c]) | (env_min[c] < lower[c]));
+    }
+
+    uint16_t first_column = 0;
+    if (violations > 0) {
+        while (first_column < columns &&
+               env_max[first_column] <= upper[first_column] && env_min[first_column] >= lower[first_column]) {
+            first_column++;
+        }
+    }
+
+    osc_mask_stats_t *stats = &ctx->stats;
+    stats->tested++;
+    if (violations == 0) {
+        stats->passed++;
+    } else {
+        stats->failed++;
+        stats->violations += violations;
+        if (!stats->has_failure) {
+            stats->has_failure = true;
+            stats->first_fail_capture = stats->tested;
+            stats->first_fail_column = first_column;
+            stats->first_fail_time = first_column * ctx->time_per_column;
+        }
+    }
+
+    xSemaphoreGive(ctx->mutex);
+
+    if (result) {
+        result->pass = (violations == 0);
+        result->violations = (uint16_t)violations;
+        result->first_column = first_column;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Get running statistics
+ */
+esp_err_t osc_mask_get_stats(osc_mask_ctx_t *ctx, osc_mask_stats_t *stats)
+{
+    if (ctx == NULL || stats == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    *stats = ctx->stats;
+    xSemaphoreGive(ctx->mutex);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Clear running statistics
+ */
+void osc_mask_reset_stats(osc_mask_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Copy the compiled bounds
+ */
+esp_err_t osc_mask_get_bounds(osc_mask_ctx_t *ctx, float *upper, float *lower,
+                              uint16_t max_columns, uint16_t *columns)
+{
+    if (ctx == NULL || upper == NULL || lower == NULL || columns == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    if (!ctx->valid) {
+        xSemaphoreGive(ctx->mutex);
+        *columns = 0;
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uint16_t count = (ctx->columns < max_columns) ? ctx->columns : max_columns;
+    memcpy(upper, ctx->upper, count * sizeof(float));
+    memcpy(lower, ctx->lower, count * sizeof(float));
+    *columns = count;
+
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file oscilloscope_mask.h
+ * @brief Pass/fail mask testing
+ *
+ * A mask is compiled to one upper and one lower bound per display column.
+ * Checking a capture is a single min/max decimation of the visible window
+ * followed by one branch-free compare pass over the columns, cheap enough to
+ * run on every acquisition.
+ *
+ * Masks are built from a reference capture with +/-X (columns) and +/-Y
+ * (volts) tolerance, or loaded from SD card.
+ */
+
+#ifndef OSCILLOSCOPE_MASK_H
+#define OSCILLOSCOPE_MASK_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Mask limits */
+#define OSC_MASK_MAX_COLUMNS        1024
+#define OSC_MASK_DEFAULT_PATH       "/sdcard/Oscilloscope/mask.osm"
+
+/* Result of one check */
+typedef struct {
+    bool pass;
+    uint16_t violations;            // Columns outside the mask
+    uint16_t first_column;          // First violating column (valid if !pass)
+} osc_mask_result_t;
+
+/* Running statistics */
+typedef struct {
+    uint32_t tested;                // Captures checked
+    uint32_t passed;
+    uint32_t failed;
+    uint32_t violations;            // Violating columns summed over all failures
+    bool has_failure;
+    uint32_t first_fail_capture;    // Capture number (1-based) of the first failure
+    uint16_t first_fail_column;     // Column of the first failure
+    float first_fail_time;          // Seconds from the left edge of the window
+} osc_mask_stats_t;
+
+/* Mask context */
+typedef struct osc_mask_ctx_t osc_mask_ctx_t;
+
+/**
+ * @brief Initialize mask tester (no mask loaded, disabled)
+ *
+ * @return Mask context or NULL on error
+ */
+osc_mask_ctx_t *osc_mask_init(void);
+
+/**
+ * @brief Deinitialize mask tester
+ *
+ * @param ctx Mask context
+ */
+void osc_mask_deinit(osc_mask_ctx_t *ctx);
+
+/**
+ * @brief Compile a mask from a reference record
+ *
+ * Column c covers source samples [start_idx + c * sample_step, start_idx + (c + 1) * sample_step).
+ * The reference min/max envelope is widened by tol_x_columns on each side
+ * and by tol_y_v up and down. Resets statistics.
+ *
+ * @param ctx Mask context
+ * @param data Reference samples (volts)
+ * @param num_points Number of valid samples
+ * @param start_idx First visible sample
+ * @param sample_step Source samples per column
+ * @param columns Number of columns (display width)
+ * @param tol_x_columns Horizontal tolerance in columns
+ * @param tol_y_v Vertical tolerance in volts
+ * @param time_per_column Seconds per column (for reporting)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad geometry
+ */
+esp_err_t osc_mask_create(osc_mask_ctx_t *ctx, const float *data, uint32_t num_points,
+                          uint32_t start_idx, float sample_step, uint16_t columns,
+                          uint16_t tol_x_columns, float tol_y_v, float time_per_column);
+
+/**
+ * @brief Save compiled mask to a file
+ *
+ * @param ctx Mask context
+ * @param path File path (e.g. OSC_MASK_DEFAULT_PATH)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no mask, ESP_FAIL on I/O error
+ */
+esp_err_t osc_mask_save(osc_mask_ctx_t *ctx, const char *path);
+
+/**
+ * @brief Load a compiled mask from a file
+ *
+ * Resets statistics.
+ *
+ * @param ctx Mask context
+ * @param path File path
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if missing, ESP_ERR_INVALID_RESPONSE if malformed
+ */
+esp_err_t osc_mask_load(osc_mask_ctx_t *ctx, const char *path);
+
+/**
+ * @brief Enable or disable checking
+ *
+ * @param ctx Mask context
+ * @param enabled true to check every capture
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if enabling without a mask
+ */
+esp_err_t osc_mask_set_enabled(osc_mask_ctx_t *ctx, bool enabled);
+
+/**
+ * @brief Check if a mask is loaded and enabled
+ *
+ * @param ctx Mask context
+ * @return true if captures are checked
+ */
+bool osc_mask_is_enabled(osc_mask_ctx_t *ctx);
+
+/**
+ * @brief Check a capture against the mask and update statistics
+ *
+ * Uses the same column geometry as osc_mask_create(). Columns beyond the
+ * end of the record are not tested.
+ *
+ * @param ctx Mask context
+ * @param data Capture samples (volts)
+ * @param num_points Number of valid samples
+ * @param start_idx First visible sample
+ * @param sample_step Source samples per column
+ * @param result Output: result of this check (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no mask is enabled
+ */
+esp_err_t osc_mask_check(osc_mask_ctx_t *ctx, const float *data, uint32_t num_points,
+                         uint32_t start_idx, float sample_step, osc_mask_result_t *result);
+
+/**
+ * @brief Get running statistics
+ *
+ * @param ctx Mask context
+ * @param stats Output: statistics
+ * @return ESP_OK on success
+ */
+esp_err_t osc_mask_get_stats(osc_mask_ctx_t *ctx, osc_mask_stats_t *stats);
+
+/**
+ * @brief Clear running statistics
+ *
+ * @param ctx Mask context
+ */
+void osc_mask_reset_stats(osc_mask_ctx_t *ctx);
+
+/**
+ * @brief Copy the compiled bounds (for drawing the mask)
+ *
+ * @param ctx Mask context
+ * @param upper Output: upper bound per column (volts)
+ * @param lower Output: lower bound per column (volts)
+ * @param max_columns Capacity of upper/lower
+ * @param columns Output: number of columns copied
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no mask
+ */
+esp_err_t osc_mask_get_bounds(osc_mask_ctx_t *ctx, float *upper, float *lower,
+                              uint16_t max_columns, uint16_t *columns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_MASK_H
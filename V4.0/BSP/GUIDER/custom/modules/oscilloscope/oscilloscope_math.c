@@ -0,0 +1,625 @@
+/**
+ * @file oscilloscope_math.c
+ * @brief Oscilloscope MATH channel engine implementation
+ */
+
+#include "oscilloscope_math.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_dsp.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <math.h>
+
+static const char *TAG = "OscMath";
+
+#define OSC_MATH_SCRATCH_LEN    (OSC_MATH_MAX_EVAL_POINTS * 2)  // Complex FFT needs 2 floats per point
+#define OSC_MATH_NO_STAGE       0xFF
+#define OSC_MATH_MIN_FFT_SIZE   64
+#define OSC_MATH_EXPR_MAX_LEN   128
+
+/* Operation names (also the keywords accepted by osc_math_compile_expr) */
+static const char *op_strings[] = {
+    [OSC_MATH_OP_NONE]          = "OFF",
+    [OSC_MATH_OP_SCALE_OFFSET]  = "SCALE",
+    [OSC_MATH_OP_INVERT]        = "INV",
+    [OSC_MATH_OP_DERIVATIVE]    = "DIFF",
+    [OSC_MATH_OP_INTEGRAL]      = "INTG",
+    [OSC_MATH_OP_MOVING_AVG]    = "AVG",
+    [OSC_MATH_OP_ABS]           = "ABS",
+    [OSC_MATH_OP_SQUARE]        = "SQR",
+    [OSC_MATH_OP_FFT_MAG]       = "FFT",
+};
+
+/* MATH engine context */
+struct osc_math_ctx_t {
+    /* Compiled chain */
+    osc_math_stage_t stages[OSC_MATH_MAX_STAGES];
+    uint8_t num_stages;
+    uint8_t integral_stage;         // Index of the integral stage or OSC_MATH_NO_STAGE
+    uint32_t history;               // Warm-up samples needed by the whole chain
+    uint32_t pre_integral_history;  // Warm-up samples needed by stages before the integral
+    uint32_t chain_version;         // Bumped on every compile
+
+    /* Scratch buffers (PSRAM) */
+    float *buf_a;
+    float *buf_b;
+
+    /* Integral checkpoints: sum of the integral input up to every block boundary */
+    double *prefix;
+    uint32_t prefix_cap;
+    uint32_t prefix_generation;
+    uint32_t prefix_version;
+    uint32_t prefix_num_points;
+    bool prefix_valid;
+
+    /* Last evaluated window */
+    float *cache;
+    uint32_t cache_count;
+    uint32_t cache_generation;
+    uint32_t cache_version;
+    uint32_t cache_num_points;
+    uint32_t cache_start_idx;
+    float cache_step;
+    uint32_t cache_out_count;
+    osc_math_info_t cache_info;
+    bool cache_valid;
+
+    /* Synchronization */
+    SemaphoreHandle_t mutex;
+};
+
+/**
+ * @brief Samples of history a stage needs before its first valid output
+ */
+static uint32_t stage_history(const osc_math_stage_t *stage)
+{
+    switch (stage->op) {
+    case OSC_MATH_OP_DERIVATIVE:
+        return 1;
+    case OSC_MATH_OP_MOVING_AVG:
+        return (uint32_t)stage->a - 1;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Copy source samples into a scratch buffer, box-averaging by level
+ */
+static void gather(const osc_math_source_t *src, uint32_t first, uint32_t level, uint32_t count, float *dst)
+{
+    if (level == 1) {
+        memcpy(dst, &src->data[first], count * sizeof(float));
+        return;
+    }
+
+    for (uint32_t j = 0; j < count; j++) {
+        uint32_t idx = first + j * level;
+        uint32_t len = level;
+        if (idx + len > src->num_points) len = src->num_points - idx;
+
+        float sum = 0.0f;
+        for (uint32_t k = 0; k < len; k++) {
+            sum += src->data[idx + k];
+        }
+        dst[j] = sum / (float)len;
+    }
+}
+
+/**
+ * @brief Run stages [first, last) over n samples
+ *
+ * Point-wise kernels work in place, history kernels ping-pong between the two
+ * scratch buffers. The integral holds integral_base up to integral_start and
+ * accumulates from there.
+ *
+ * @return Buffer holding the result (in or tmp)
+ */
+static float *run_chain(osc_math_ctx_t *ctx, uint8_t first, uint8_t last, float *in, float *tmp,
+                        uint32_t n, float dt, uint32_t integral_start, float integral_base)
+{
+    float *cur = in;
+    float *alt = tmp;
+
+    for (uint8_t s = first; s < last; s++) {
+        const osc_math_stage_t *stage = &ctx->stages[s];
+        float *swap;
+
+        switch (stage->op) {
+        case OSC_MATH_OP_SCALE_OFFSET:
+            dsps_mulc_f32(cur, cur, n, stage->a, 1, 1);
+            dsps_addc_f32(cur, cur, n, stage->b, 1, 1);
+            break;
+
+        case OSC_MATH_OP_INVERT:
+            dsps_mulc_f32(cur, cur, n, -1.0f, 1, 1);
+            break;
+
+        case OSC_MATH_OP_SQUARE:
+            dsps_mul_f32(cur, cur, cur, n, 1, 1, 1);
+            break;
+
+        case OSC_MATH_OP_ABS:
+            for (uint32_t i = 0; i < n; i++) {
+                cur[i] = fabsf(cur[i]);
+            }
+            break;
+
+        case OSC_MATH_OP_DERIVATIVE: {
+            float inv_dt = 1.0f / dt;
+            alt[0] = 0.0f;
+            for (uint32_t i = 1; i < n; i++) {
+                alt[i] = (cur[i] - cur[i - 1]) * inv_dt;
+            }
+            swap = cur; cur = alt; alt = swap;
+            break;
+        }
+
+        case OSC_MATH_OP_INTEGRAL: {
+            float acc = integral_base;
+            for (uint32_t i = 0; i < n; i++) {
+                alt[i] = acc;
+                if (i >= integral_start) acc += cur[i] * dt;
+            }
+            swap = cur; cur = alt; alt = swap;
+            break;
+        }
+
+        case OSC_MATH_OP_MOVING_AVG: {
+            uint32_t window = (uint32_t)stage->a;
+            float sum = 0.0f;
+            for (uint32_t i = 0; i < n; i++) {
+                sum += cur[i];
+                if (i >= window) sum -= cur[i - window];
+                alt[i] = sum / (float)((i < window) ? (i + 1) : window);
+            }
+            swap = cur; cur = alt; alt = swap;
+            break;
+        }
+
+        default:
+            break;
+        }
+    }
+
+    return cur;
+}
+
+/**
+ * @brief Sum of the integral input over source samples [from, to) at full resolution
+ */
+static double integral_input_sum(osc_math_ctx_t *ctx, const osc_math_source_t *src, uint32_t from, uint32_t to)
+{
+    double sum = 0.0;
+
+    while (from < to) {
+        uint32_t len = to - from;
+        if (len > OSC_MATH_MAX_EVAL_POINTS) len = OSC_MATH_MAX_EVAL_POINTS;
+
+        uint32_t warm = (from > ctx->pre_integral_history) ? ctx->pre_integral_history : from;
+        uint32_t n = warm + len;
+
+        gather(src, from - warm, 1, n, ctx->buf_a);
+        float *u = run_chain(ctx, 0, ctx->integral_stage, ctx->buf_a, ctx->buf_b,
+                             n, src->time_per_sample, 0, 0.0f);
+        for (uint32_t i = warm; i < n; i++) {
+            sum += u[i];
+        }
+
+        from += len;
+    }
+
+    return sum;
+}
+
+/**
+ * @brief Build integral checkpoints for a capture generation (one pass per generation)
+ */
+static esp_err_t build_prefix(osc_math_ctx_t *ctx, const osc_math_source_t *src)
+{
+    uint32_t blocks = (src->num_points + OSC_MATH_PREFIX_BLOCK - 1) / OSC_MATH_PREFIX_BLOCK;
+
+    if (blocks + 1 > ctx->prefix_cap) {
+        double *prefix = heap_caps_realloc(ctx->prefix, (blocks + 1) * sizeof(double), MALLOC_CAP_SPIRAM);
+        if (prefix == NULL) {
+            ESP_LOGE(TAG, "Failed to allocate integral checkpoints (%lu blocks)", blocks);
+            return ESP_ERR_NO_MEM;
+        }
+        ctx->prefix = prefix;
+        ctx->prefix_cap = blocks + 1;
+    }
+
+    ctx->prefix[0] = 0.0;
+    for (uint32_t c = 0; c < blocks; c++) {
+        uint32_t from = c * OSC_MATH_PREFIX_BLOCK;
+        uint32_t to = from + OSC_MATH_PREFIX_BLOCK;
+        if (to > src->num_points) to = src->num_points;
+        ctx->prefix[c + 1] = ctx->prefix[c] + integral_input_sum(ctx, src, from, to);
+    }
+
+    ctx->prefix_generation = src->generation;
+    ctx->prefix_version = ctx->chain_version;
+    ctx->prefix_num_points = src->num_points;
+    ctx->prefix_valid = true;
+    return ESP_OK;
+}
+
+/**
+ * @brief Integral of the integral input from record start up to source sample pos
+ */
+static float prefix_at(osc_math_ctx_t *ctx, const osc_math_source_t *src, uint32_t pos)
+{
+    uint32_t block = pos / OSC_MATH_PREFIX_BLOCK;
+    double sum = ctx->prefix[block] + integral_input_sum(ctx, src, block * OSC_MATH_PREFIX_BLOCK, pos);
+    return (float)(sum * src->time_per_sample);
+}
+
+/**
+ * @brief Single-sided magnitude spectrum of len samples, peak-held onto out_count points
+ *
+ * @return Number of points written (0 if the window is too short)
+ */
+static uint32_t fft_magnitude(const float *in, uint32_t len, float *work, float dt,
+                              float *out, uint32_t out_count, float *hz_per_point)
+{
+    uint32_t fft_size = CONFIG_DSP_MAX_FFT_SIZE;
+    if (fft_size > OSC_MATH_MAX_EVAL_POINTS) fft_size = OSC_MATH_MAX_EVAL_POINTS;
+    while (fft_size > len) fft_size >>= 1;
+    if (fft_size < OSC_MATH_MIN_FFT_SIZE) return 0;
+
+    // Hann window, interleaved complex input
+    for (uint32_t i = 0; i < fft_size; i++) {
+        float w = 0.5f * (1.0f - cosf(2.0f * (float)M_PI * i / (fft_size - 1)));
+        work[i * 2] = in[i] * w;
+        work[i * 2 + 1] = 0.0f;
+    }
+
+    dsps_fft2r_fc32(work, fft_size);
+    dsps_bit_rev_fc32(work, fft_size);
+
+    // Magnitude in place: bin b reads work[2b], work[2b+1] before work[b] is written
+    uint32_t bins = fft_size / 2;
+    float norm = 4.0f / (float)fft_size;  // Single-sided, Hann coherent gain 0.5
+    for (uint32_t b = 0; b < bins; b++) {
+        float re = work[b * 2];
+        float im = work[b * 2 + 1];
+        work[b] = sqrtf(re * re + im * im) * norm;
+    }
+    work[0] *= 0.5f;  // DC is not doubled
+
+    for (uint32_t i = 0; i < out_count; i++) {
+        uint32_t b0 = (uint32_t)(((uint64_t)i * bins) / out_count);
+        uint32_t b1 = (uint32_t)(((uint64_t)(i + 1) * bins) / out_count);
+        if (b1 <= b0) b1 = b0 + 1;
+        if (b1 > bins) b1 = bins;
+
+        float peak = 0.0f;
+        for (uint32_t b = b0; b < b1; b++) {
+            if (work[b] > peak) peak = work[b];
+        }
+        out[i] = peak;
+    }
+
+    *hz_per_point = (0.5f / dt) / (float)out_count;
+    return out_count;
+}
+
+/**
+ * @brief Initialize MATH engine
+ */
+osc_math_ctx_t *osc_math_init(void)
+{
+    osc_math_ctx_t *ctx = heap_caps_malloc(sizeof(osc_math_ctx_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(osc_math_ctx_t));
+    ctx->integral_stage = OSC_MATH_NO_STAGE;
+
+    ctx->mutex = xSemaphoreCreateMutex();
+    ctx->buf_a = heap_caps_malloc(OSC_MATH_SCRATCH_LEN * sizeof(float), MALLOC_CAP_SPIRAM);
+    ctx->buf_b = heap_caps_malloc(OSC_MATH_SCRATCH_LEN * sizeof(float), MALLOC_CAP_SPIRAM);
+    ctx->cache = heap_caps_malloc(OSC_MATH_MAX_OUTPUT * sizeof(float), MALLOC_CAP_SPIRAM);
+
+    if (ctx->mutex == NULL || ctx->buf_a == NULL || ctx->buf_b == NULL || ctx->cache == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate MATH buffers");
+        osc_math_deinit(ctx);
+        return NULL;
+    }
+
+    // Twiddle table is shared with the FFT view; init is a no-op if already done
+    esp_err_t ret = dsps_fft2r_init_fc32(NULL, CONFIG_DSP_MAX_FFT_SIZE);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "FFT init failed (%s), FFT magnitude unavailable", esp_err_to_name(ret));
+    }
+
+    ESP_LOGI(TAG, "MATH engine initialized");
+    return ctx;
+}
+
+/**
+ * @brief Deinitialize MATH engine
+ */
+void osc_math_deinit(osc_math_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    if (ctx->buf_a) heap_caps_free(ctx->buf_a);
+    if (ctx->buf_b) heap_caps_free(ctx->buf_b);
+    if (ctx->cache) heap_caps_free(ctx->cache);
+    if (ctx->prefix) heap_caps_free(ctx->prefix);
+    if (ctx->mutex) vSemaphoreDelete(ctx->mutex);
+
+    free(ctx);
+}
+
+/**
+ * @brief Compile a kernel chain
+ */
+esp_err_t osc_math_compile(osc_math_ctx_t *ctx, const osc_math_stage_t *stages, uint8_t num_stages)
+{
+    if (ctx == NULL || num_stages > OSC_MATH_MAX_STAGES) return ESP_ERR_INVALID_ARG;
+    if (num_stages > 0 && stages == NULL) return ESP_ERR_INVALID_ARG;
+
+    uint8_t integral_stage = OSC_MATH_NO_STAGE;
+    uint32_t history = 0;
+    uint32_t pre_integral_history = 0;
+
+    for (uint8_t s = 0; s < num_stages; s++) {
+        const osc_math_stage_t *stage = &stages[s];
+
+        if (stage->op <= OSC_MATH_OP_NONE || stage->op >= OSC_MATH_OP_MAX) {
+            ESP_LOGW(TAG, "Stage %u: invalid operation %d", s, stage->op);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (stage->op == OSC_MATH_OP_FFT_MAG && s != num_stages - 1) {
+            ESP_LOGW(TAG, "Stage %u: FFT must be the last stage", s);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (stage->op == OSC_MATH_OP_MOVING_AVG &&
+            (stage->a < 1.0f || stage->a > OSC_MATH_MAX_AVG_WINDOW || stage->a != floorf(stage->a))) {
+            ESP_LOGW(TAG, "Stage %u: moving average length %.1f out of range", s, stage->a);
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (stage->op == OSC_MATH_OP_INTEGRAL) {
+            if (integral_stage != OSC_MATH_NO_STAGE) {
+                ESP_LOGW(TAG, "Stage %u: only one integral per expression", s);
+                return ESP_ERR_INVALID_ARG;
+            }
+            integral_stage = s;
+            pre_integral_history = history;
+        }
+
+        history += stage_history(stage);
+    }
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    if (num_stages > 0) {
+        memcpy(ctx->stages, stages, num_stages * sizeof(osc_math_stage_t));
+    }
+    ctx->num_stages = num_stages;
+    ctx->integral_stage = integral_stage;
+    ctx->history = history;
+    ctx->pre_integral_history = pre_integral_history;
+    ctx->chain_version++;
+    ctx->prefix_valid = false;
+    ctx->cache_valid = false;
+
+    xSemaphoreGive(ctx->mutex);
+
+    ESP_LOGI(TAG, "Compiled %u stage(s), history=%lu samples", num_stages, history);
+    return ESP_OK;
+}
+
+/**
+ * @brief Compile a text expression
+ */
+esp_err_t osc_math_compile_expr(osc_math_ctx_t *ctx, const char *expr)
+{
+    if (ctx == NULL || expr == NULL) return ESP_ERR_INVALID_ARG;
+
+    char buf[OSC_MATH_EXPR_MAX_LEN];
+    strncpy(buf, expr, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+
+    osc_math_stage_t stages[OSC_MATH_MAX_STAGES];
+    uint8_t num_stages = 0;
+
+    char *seg_save = NULL;
+    for (char *seg = strtok_r(buf, "|", &seg_save); seg != NULL; seg = strtok_r(NULL, "|", &seg_save)) {
+        char *tok_save = NULL;
+        char *name = strtok_r(seg, " \t", &tok_save);
+        if (name == NULL) continue;
+
+        if (num_stages >= OSC_MATH_MAX_STAGES) {
+            ESP_LOGW(TAG, "Expression too long: %s", expr);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        osc_math_stage_t *stage = &stages[num_stages];
+        stage->op = OSC_MATH_OP_NONE;
+        for (int op = OSC_MATH_OP_NONE + 1; op < OSC_MATH_OP_MAX; op++) {
+            if (strcasecmp(name, op_strings[op]) == 0) {
+                stage->op = (osc_math_op_t)op;
+                break;
+            }
+        }
+        if (stage->op == OSC_MATH_OP_NONE) {
+            ESP_LOGW(TAG, "Unknown MATH operation: %s", name);
+            return ESP_ERR_INVALID_ARG;
+        }
+
+        char *arg_a = strtok_r(NULL, " \t", &tok_save);
+        char *arg_b = strtok_r(NULL, " \t", &tok_save);
+        stage->a = (arg_a != NULL) ? strtof(arg_a, NULL) : 1.0f;
+        stage->b = (arg_b != NULL) ? strtof(arg_b, NULL) : 0.0f;
+
+        if (stage->op == OSC_MATH_OP_MOVING_AVG && arg_a == NULL) {
+            stage->a = 8.0f;
+        }
+
+        num_stages++;
+    }
+
+    return osc_math_compile(ctx, stages, num_stages);
+}
+
+/**
+ * @brief Check if a non-empty chain is compiled
+ */
+bool osc_math_is_enabled(osc_math_ctx_t *ctx)
+{
+    if (ctx == NULL) return false;
+    return ctx->num_stages > 0;
+}
+
+/**
+ * @brief Evaluate the chain over a display window
+ */
+esp_err_t osc_math_evaluate(osc_math_ctx_t *ctx, const osc_math_source_t *src,
+                            uint32_t start_idx, float sample_step,
+                            float *out, uint32_t out_count, uint32_t *actual_count,
+                            osc_math_info_t *info)
+{
+    if (ctx == NULL || src == NULL || out == NULL || actual_count == NULL) return ESP_ERR_INVALID_ARG;
+    if (out_count == 0 || out_count > OSC_MATH_MAX_OUTPUT || sample_step <= 0.0f) return ESP_ERR_INVALID_ARG;
+
+    *actual_count = 0;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    if (ctx->num_stages == 0) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (src->data == NULL || src->num_points == 0 || start_idx >= src->num_points) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Same record, same chain, same window: nothing to recompute
+    if (ctx->cache_valid &&
+        ctx->cache_generation == src->generation &&
+        ctx->cache_version == ctx->chain_version &&
+        ctx->cache_num_points == src->num_points &&
+        ctx->cache_start_idx == start_idx &&
+        ctx->cache_step == sample_step &&
+        ctx->cache_out_count == out_count) {
+        memcpy(out, ctx->cache, ctx->cache_count * sizeof(float));
+        *actual_count = ctx->cache_count;
+        if (info) {
+            *info = ctx->cache_info;
+            info->from_cache = true;
+        }
+        xSemaphoreGive(ctx->mutex);
+        return ESP_OK;
+    }
+
+    // Pick the decimation level so the visible span fits the scratch buffers
+    uint32_t span = (uint32_t)ceilf(out_count * sample_step);
+    if (span == 0) span = 1;
+    if (span > src->num_points - start_idx) span = src->num_points - start_idx;
+
+    uint32_t level = (span + OSC_MATH_MAX_EVAL_POINTS - 1) / OSC_MATH_MAX_EVAL_POINTS;
+    if (level == 0) level = 1;
+    uint32_t visible = (span + level - 1) / level;
+
+    // Warm-up samples in front of the window for history kernels
+    uint32_t warm = ctx->history;
+    if (warm * level > start_idx) warm = start_idx / level;
+    uint32_t first = start_idx - warm * level;
+    uint32_t n = warm + visible;
+    float dt = src->time_per_sample * (float)level;
+
+    // Integral constant comes from the per-generation checkpoints, not the whole record
+    uint32_t integral_start = 0;
+    float integral_base = 0.0f;
+    if (ctx->integral_stage != OSC_MATH_NO_STAGE) {
+        if (!ctx->prefix_valid ||
+            ctx->prefix_generation != src->generation ||
+            ctx->prefix_version != ctx->chain_version ||
+            ctx->prefix_num_points != src->num_points) {
+            esp_err_t ret = build_prefix(ctx, src);
+            if (ret != ESP_OK) {
+                xSemaphoreGive(ctx->mutex);
+                return ret;
+            }
+        }
+        integral_start = (warm < ctx->pre_integral_history) ? warm : ctx->pre_integral_history;
+        integral_base = prefix_at(ctx, src, first + integral_start * level);
+    }
+
+    gather(src, first, level, n, ctx->buf_a);
+
+    bool spectrum = (ctx->stages[ctx->num_stages - 1].op == OSC_MATH_OP_FFT_MAG);
+    uint8_t last = spectrum ? ctx->num_stages - 1 : ctx->num_stages;
+    float *res = run_chain(ctx, 0, last, ctx->buf_a, ctx->buf_b, n, dt, integral_start, integral_base);
+
+    uint32_t count = 0;
+    float x_per_point = 0.0f;
+
+    if (spectrum) {
+        float *work = (res == ctx->buf_a) ? ctx->buf_b : ctx->buf_a;
+        count = fft_magnitude(&res[warm], visible, work, dt, out, out_count, &x_per_point);
+    } else {
+        for (uint32_t i = 0; i < out_count; i++) {
+            float pos = i * sample_step;
+            if (start_idx + (uint32_t)pos >= src->num_points) break;
+
+            uint32_t j = warm + (uint32_t)(pos / level);
+            if (j >= n) j = n - 1;
+            out[count++] = res[j];
+        }
+        x_per_point = sample_step * src->time_per_sample;
+    }
+
+    // Remember this window
+    memcpy(ctx->cache, out, count * sizeof(float));
+    ctx->cache_count = count;
+    ctx->cache_generation = src->generation;
+    ctx->cache_version = ctx->chain_version;
+    ctx->cache_num_points = src->num_points;
+    ctx->cache_start_idx = start_idx;
+    ctx->cache_step = sample_step;
+    ctx->cache_out_count = out_count;
+    ctx->cache_info.spectrum = spectrum;
+    ctx->cache_info.x_per_point = x_per_point;
+    ctx->cache_info.level = level;
+    ctx->cache_info.from_cache = false;
+    ctx->cache_valid = true;
+
+    if (info) *info = ctx->cache_info;
+    *actual_count = count;
+
+    xSemaphoreGive(ctx->mutex);
+    return (count > 0) ? ESP_OK : ESP_ERR_INVALID_SIZE;
+}
+
+/**
+ * @brief Drop cached results
+ */
+void osc_math_invalidate(osc_math_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->cache_valid = false;
+    ctx->prefix_valid = false;
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Get operation name for on-screen labels
+ */
+const char *osc_math_get_op_str(osc_math_op_t op)
+{
+    if (op >= OSC_MATH_OP_MAX) return "?";
+    return op_strings[op];
+}
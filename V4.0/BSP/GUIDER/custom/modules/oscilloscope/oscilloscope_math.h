@@ -0,0 +1,160 @@
+/**
+ * @file oscilloscope_math.h
+ * @brief Oscilloscope MATH channel engine
+ *
+ * A MATH expression is compiled into a short chain of vectorized kernels
+ * (scale/offset, invert, derivative, integral, moving average, abs, square,
+ * FFT magnitude). The chain is evaluated lazily, only over the samples that
+ * are visible on screen (decimated to a coarser level when the visible span
+ * is wider than OSC_MATH_MAX_EVAL_POINTS), and the result is cached per
+ * capture generation. Panning a stopped 100K record therefore never re-runs
+ * the chain over the whole record.
+ */
+
+#ifndef OSCILLOSCOPE_MATH_H
+#define OSCILLOSCOPE_MATH_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Engine limits */
+#define OSC_MATH_MAX_STAGES         6       // Kernels per expression
+#define OSC_MATH_MAX_EVAL_POINTS    4096    // Samples evaluated per window (after decimation)
+#define OSC_MATH_MAX_AVG_WINDOW     256     // Longest moving average window
+#define OSC_MATH_MAX_OUTPUT         1024    // Largest output (display) width
+#define OSC_MATH_PREFIX_BLOCK       1024    // Integral checkpoint spacing in samples
+
+/* MATH operations */
+typedef enum {
+    OSC_MATH_OP_NONE = 0,
+    OSC_MATH_OP_SCALE_OFFSET,   // y = x * a + b
+    OSC_MATH_OP_INVERT,         // y = -x
+    OSC_MATH_OP_DERIVATIVE,     // y = dx/dt
+    OSC_MATH_OP_INTEGRAL,       // y = integral of x dt from record start
+    OSC_MATH_OP_MOVING_AVG,     // y = mean of last a samples
+    OSC_MATH_OP_ABS,            // y = |x|
+    OSC_MATH_OP_SQUARE,         // y = x * x (instantaneous power into 1 ohm)
+    OSC_MATH_OP_FFT_MAG,        // Magnitude spectrum of the window (last stage only)
+    OSC_MATH_OP_MAX
+} osc_math_op_t;
+
+/* One kernel of a MATH expression */
+typedef struct {
+    osc_math_op_t op;
+    float a;                        // Scale factor / moving average length
+    float b;                        // Offset
+} osc_math_stage_t;
+
+/* Source record the expression is evaluated against */
+typedef struct {
+    const float *data;              // Voltage samples
+    uint32_t num_points;            // Number of valid samples
+    float time_per_sample;          // Seconds between samples
+    uint32_t generation;            // Capture generation of this record
+} osc_math_source_t;
+
+/* Extra information about an evaluated window */
+typedef struct {
+    bool spectrum;                  // Output is a magnitude spectrum (x axis = frequency)
+    float x_per_point;              // Seconds (or Hz for spectrum) per output point
+    uint32_t level;                 // Decimation factor used for evaluation
+    bool from_cache;                // Result was served from the cache
+} osc_math_info_t;
+
+/* MATH engine context */
+typedef struct osc_math_ctx_t osc_math_ctx_t;
+
+/**
+ * @brief Initialize MATH engine
+ *
+ * @return Engine context or NULL on error
+ */
+osc_math_ctx_t *osc_math_init(void);
+
+/**
+ * @brief Deinitialize MATH engine
+ *
+ * @param ctx Engine context
+ */
+void osc_math_deinit(osc_math_ctx_t *ctx);
+
+/**
+ * @brief Compile a kernel chain
+ *
+ * At most one integral stage is allowed, and FFT magnitude must be the
+ * last stage. Compiling invalidates all cached results.
+ *
+ * @param ctx Engine context
+ * @param stages Kernel chain
+ * @param num_stages Number of stages (0 disables the MATH trace)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on an invalid chain
+ */
+esp_err_t osc_math_compile(osc_math_ctx_t *ctx, const osc_math_stage_t *stages, uint8_t num_stages);
+
+/**
+ * @brief Compile a text expression
+ *
+ * Stages are separated by '|', e.g. "SCALE 2 -1 | DIFF | AVG 16".
+ * Keywords: SCALE a [b], INV, DIFF, INTG, AVG n, ABS, SQR, FFT.
+ *
+ * @param ctx Engine context
+ * @param expr Expression string
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on a parse error
+ */
+esp_err_t osc_math_compile_expr(osc_math_ctx_t *ctx, const char *expr);
+
+/**
+ * @brief Check if a non-empty chain is compiled
+ *
+ * @param ctx Engine context
+ * @return true if the MATH trace is active
+ */
+bool osc_math_is_enabled(osc_math_ctx_t *ctx);
+
+/**
+ * @brief Evaluate the chain over a display window
+ *
+ * Output point i corresponds to source sample start_idx + i * sample_step.
+ * Repeated calls with the same window and generation are served from the
+ * cache without touching the source record.
+ *
+ * @param ctx Engine context
+ * @param src Source record
+ * @param start_idx First visible source sample
+ * @param sample_step Source samples per output point
+ * @param out Output buffer (out_count points)
+ * @param out_count Requested number of output points
+ * @param actual_count Output: number of points written
+ * @param info Output: evaluation details (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no chain is compiled
+ */
+esp_err_t osc_math_evaluate(osc_math_ctx_t *ctx, const osc_math_source_t *src,
+                            uint32_t start_idx, float sample_step,
+                            float *out, uint32_t out_count, uint32_t *actual_count,
+                            osc_math_info_t *info);
+
+/**
+ * @brief Drop cached results (e.g. when the source buffer is reallocated)
+ *
+ * @param ctx Engine context
+ */
+void osc_math_invalidate(osc_math_ctx_t *ctx);
+
+/**
+ * @brief Get operation name for on-screen labels
+ *
+ * @param op Operation
+ * @return Short name (e.g. "DIFF")
+ */
+const char *osc_math_get_op_str(osc_math_op_t op);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_MATH_H
@@ -0,0 +1,228 @@
+/**
+ * @file oscilloscope_pyramid.c
+ * @brief Min/max decimation pyramid implementation
+ */
+
+#include "oscilloscope_pyramid.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "OscPyramid";
+
+/* Pyramid context */
+struct osc_pyramid_t {
+    float *min[OSC_PYRAMID_MAX_LEVELS];
+    float *max[OSC_PYRAMID_MAX_LEVELS];
+    uint32_t capacity[OSC_PYRAMID_MAX_LEVELS];  // Blocks allocated per level
+    uint32_t blocks[OSC_PYRAMID_MAX_LEVELS];    // Blocks built per level
+    uint8_t num_levels;
+
+    /* Record the pyramid describes */
+    bool valid;
+    uint32_t num_points;
+    uint32_t generation;
+};
+
+/**
+ * @brief Make sure a level can hold count blocks
+ */
+static esp_err_t reserve_level(osc_pyramid_t *ctx, uint8_t level, uint32_t count)
+{
+    if (ctx->capacity[level] >= count) return ESP_OK;
+
+    heap_caps_free(ctx->min[level]);
+    heap_caps_free(ctx->max[level]);
+    ctx->min[level] = heap_caps_malloc(count * sizeof(float), MALLOC_CAP_SPIRAM);
+    ctx->max[level] = heap_caps_malloc(count * sizeof(float), MALLOC_CAP_SPIRAM);
+    if (ctx->min[level] == NULL || ctx->max[level] == NULL) {
+        heap_caps_free(ctx->min[level]);
+        heap_caps_free(ctx->max[level]);
+        ctx->min[level] = NULL;
+        ctx->max[level] = NULL;
+        ctx->capacity[level] = 0;
+        return ESP_ERR_NO_MEM;
+    }
+    ctx->capacity[level] = count;
+    return ESP_OK;
+}
+
+/**
+ * @brief Initialize an empty pyramid
+ */
+osc_pyramid_t *osc_pyramid_init(void)
+{
+    osc_pyramid_t *ctx = heap_caps_malloc(sizeof(osc_pyramid_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(osc_pyramid_t));
+    return ctx;
+}
+
+/**
+ * @brief Deinitialize pyramid
+ */
+void osc_pyramid_deinit(osc_pyramid_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    for (int l = 0; l < OSC_PYRAMID_MAX_LEVELS; l++) {
+        heap_caps_free(ctx->min[l]);
+        heap_caps_free(ctx->max[l]);
+    }
+    free(ctx);
+}
+
+/**
+ * @brief Build the pyramid over a record
+ */
+esp_err_t osc_pyramid_build(osc_pyramid_t *ctx, const float *data, uint32_t num_points, uint32_t generation)
+{
+    if (ctx == NULL || (data == NULL && num_points > 0)) return ESP_ERR_INVALID_ARG;
+
+    if (ctx->valid && ctx->generation == generation && ctx->num_points == num_points) return ESP_OK;
+
+    ctx->valid = false;
+    ctx->num_levels = 0;
+
+    // Level 0 straight from the samples
+    uint32_t count = (num_points + OSC_PYRAMID_FANOUT - 1) / OSC_PYRAMID_FANOUT;
+    if (num_points >= OSC_PYRAMID_FANOUT) {
+        if (reserve_level(ctx, 0, count) != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to allocate level 0 (%lu blocks)", count);
+            return ESP_ERR_NO_MEM;
+        }
+        for (uint32_t b = 0; b < count; b++) {
+            uint32_t start = b * OSC_PYRAMID_FANOUT;
+            uint32_t end = start + OSC_PYRAMID_FANOUT;
+            if (end > num_points) end = num_points;
+            float mn = data[start], mx = data[start];
+            for (uint32_t i = start + 1; i < end; i++) {
+                float v = data[i];
+                mn = (v < mn) ? v : mn;
+                mx = (v > mx) ? v : mx;
+            }
+            ctx->min[0][b] = mn;
+            ctx->max[0][b] = mx;
+        }
+        ctx->blocks[0] = count;
+        ctx->num_levels = 1;
+    }
+
+    // Higher levels from the level below, while a level still has more than one block
+    while (ctx->num_levels < OSC_PYRAMID_MAX_LEVELS && ctx->blocks[ctx->num_levels - 1] > 1) {
+        uint8_t level = ctx->num_levels;
+        uint32_t below = ctx->blocks[level - 1];
+        count = (below + OSC_PYRAMID_FANOUT - 1) / OSC_PYRAMID_FANOUT;
+        if (reserve_level(ctx, level, count) != ESP_OK) break;  // Coarser levels are optional
+
+        for (uint32_t b = 0; b < count; b++) {
+            uint32_t start = b * OSC_PYRAMID_FANOUT;
+            uint32_t end = start + OSC_PYRAMID_FANOUT;
+            if (end > below) end = below;
+            float mn = ctx->min[level - 1][start], mx = ctx->max[level - 1][start];
+            for (uint32_t i = start + 1; i < end; i++) {
+                mn = (ctx->min[level - 1][i] < mn) ? ctx->min[level - 1][i] : mn;
+                mx = (ctx->max[level - 1][i] > mx) ? ctx->max[level - 1][i] : mx;
+            }
+            ctx->min[level][b] = mn;
+            ctx->max[level][b] = mx;
+        }
+        ctx->blocks[level] = count;
+        ctx->num_levels++;
+    }
+
+    ctx->num_points = num_points;
+    ctx->generation = generation;
+    ctx->valid = true;
+    return ESP_OK;
+}
+
+/**
+ * @brief Forget the built record
+ */
+void osc_pyramid_invalidate(osc_pyramid_t *ctx)
+{
+    if (ctx == NULL) return;
+    ctx->valid = false;
+}
+
+/**
+ * @brief Get number of levels built
+ */
+uint8_t osc_pyramid_get_num_levels(osc_pyramid_t *ctx)
+{
+    if (ctx == NULL || !ctx->valid) return 0;
+    return ctx->num_levels;
+}
+
+/**
+ * @brief Get samples per block of a level
+ */
+uint32_t osc_pyramid_get_block_size(uint8_t level)
+{
+    uint32_t size = OSC_PYRAMID_FANOUT;
+    for (uint8_t l = 0; l < level; l++) {
+        size *= OSC_PYRAMID_FANOUT;
+    }
+    return size;
+}
+
+/**
+ * @brief Get number of blocks of a level
+ */
+uint32_t osc_pyramid_get_num_blocks(osc_pyramid_t *ctx, uint8_t level)
+{
+    if (ctx == NULL || !ctx->valid || level >= ctx->num_levels) return 0;
+    return ctx->blocks[level];
+}
+
+/**
+ * @brief Get minimum and maximum of one block
+ */
+void osc_pyramid_get_block(osc_pyramid_t *ctx, uint8_t level, uint32_t block, float *min, float *max)
+{
+    *min = ctx->min[level][block];
+    *max = ctx->max[level][block];
+}
+
+/**
+ * @brief Minimum and maximum of samples [start, end)
+ */
+esp_err_t osc_pyramid_query(osc_pyramid_t *ctx, const float *data, uint32_t start, uint32_t end,
+                            float *min, float *max)
+{
+    if (ctx == NULL || data == NULL || min == NULL || max == NULL) return ESP_ERR_INVALID_ARG;
+    if (!ctx->valid || start >= end || end > ctx->num_points) return ESP_ERR_INVALID_ARG;
+
+    float mn = data[start], mx = data[start];
+    uint32_t pos = start;
+    while (pos < end) {
+        // Coarsest aligned block inside the span (the partial last block counts at the record end)
+        int level = ctx->num_levels - 1;
+        uint32_t size = 0;
+        for (; level >= 0; level--) {
+            size = osc_pyramid_get_block_size(level);
+            if (pos % size == 0 && (pos + size <= end || end == ctx->num_points)) break;
+        }
+
+        if (level < 0) {
+            float v = data[pos];
+            mn = (v < mn) ? v : mn;
+            mx = (v > mx) ? v : mx;
+            pos++;
+        } else {
+            uint32_t block = pos / size;
+            mn = (ctx->min[level][block] < mn) ? ctx->min[level][block] : mn;
+            mx = (ctx->max[level][block] > mx) ? ctx->max[level][block] : mx;
+            pos += size;
+        }
+    }
+
+    *min = mn;
+    *max = mx;
+    return ESP_OK;
+}
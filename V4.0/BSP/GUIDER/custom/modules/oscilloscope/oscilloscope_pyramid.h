@@ -0,0 +1,119 @@
+/**
+ * @file oscilloscope_pyramid.h
+ * @brief Min/max decimation pyramid over a capture record
+ *
+ * Level l summarizes blocks of OSC_PYRAMID_FANOUT^(l+1) samples with their
+ * minimum and maximum, so range queries and scans over deep records touch
+ * O(log n) summaries instead of every sample. The pyramid is rebuilt only
+ * when the record generation changes.
+ */
+
+#ifndef OSCILLOSCOPE_PYRAMID_H
+#define OSCILLOSCOPE_PYRAMID_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Pyramid geometry */
+#define OSC_PYRAMID_FANOUT          16      // Blocks of level l-1 per block of level l
+#define OSC_PYRAMID_MAX_LEVELS      5       // Up to 16^5 = 1M samples per top-level block
+
+/* Pyramid context */
+typedef struct osc_pyramid_t osc_pyramid_t;
+
+/**
+ * @brief Initialize an empty pyramid
+ *
+ * @return Pyramid context or NULL on error
+ */
+osc_pyramid_t *osc_pyramid_init(void);
+
+/**
+ * @brief Deinitialize pyramid
+ *
+ * @param ctx Pyramid context
+ */
+void osc_pyramid_deinit(osc_pyramid_t *ctx);
+
+/**
+ * @brief Build the pyramid over a record
+ *
+ * Does nothing if the same generation and length were already built.
+ *
+ * @param ctx Pyramid context
+ * @param data Samples (volts)
+ * @param num_points Number of samples
+ * @param generation Capture generation of data
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the levels cannot be allocated
+ */
+esp_err_t osc_pyramid_build(osc_pyramid_t *ctx, const float *data, uint32_t num_points, uint32_t generation);
+
+/**
+ * @brief Forget the built record (next build always rebuilds)
+ *
+ * @param ctx Pyramid context
+ */
+void osc_pyramid_invalidate(osc_pyramid_t *ctx);
+
+/**
+ * @brief Get number of levels built (0 if the record is shorter than one block)
+ *
+ * @param ctx Pyramid context
+ * @return Number of levels
+ */
+uint8_t osc_pyramid_get_num_levels(osc_pyramid_t *ctx);
+
+/**
+ * @brief Get samples per block of a level
+ *
+ * @param level Level (0 = finest)
+ * @return OSC_PYRAMID_FANOUT^(level+1)
+ */
+uint32_t osc_pyramid_get_block_size(uint8_t level);
+
+/**
+ * @brief Get number of blocks of a level (the last one may be partial)
+ *
+ * @param ctx Pyramid context
+ * @param level Level
+ * @return Number of blocks (0 if the level is not built)
+ */
+uint32_t osc_pyramid_get_num_blocks(osc_pyramid_t *ctx, uint8_t level);
+
+/**
+ * @brief Get minimum and maximum of one block
+ *
+ * @param ctx Pyramid context
+ * @param level Level
+ * @param block Block index
+ * @param min Output: minimum
+ * @param max Output: maximum
+ */
+void osc_pyramid_get_block(osc_pyramid_t *ctx, uint8_t level, uint32_t block, float *min, float *max);
+
+/**
+ * @brief Minimum and maximum of samples [start, end)
+ *
+ * Uses the coarsest blocks that fit and reads raw samples only at the edges.
+ *
+ * @param ctx Pyramid context
+ * @param data The record the pyramid was built over
+ * @param start First sample
+ * @param end One past the last sample
+ * @param min Output: minimum
+ * @param max Output: maximum
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on an empty or out-of-range span
+ */
+esp_err_t osc_pyramid_query(osc_pyramid_t *ctx, const float *data, uint32_t start, uint32_t end,
+                            float *min, float *max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_PYRAMID_H
@@ -0,0 +1,590 @@
+/**
+ * @file oscilloscope_recorder.c
+ * @brief Continuous streaming recorder implementation
+ */
+
+#include "oscilloscope_recorder.h"
+#include "oscilloscope_wavefile.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_vfs_fat.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *TAG = "OscRecorder";
+
+#define OSC_RECORDER_MOUNT_POINT    "/sdcard"
+#define OSC_RECORDER_TASK_STACK     4096
+#define OSC_RECORDER_TASK_PRIORITY  3
+#define OSC_RECORDER_RATE_WINDOW_US 1000000     // Window of the recent card rate
+#define OSC_RECORDER_MAX_SEGMENT    (1024ull * 1024ull * 1024ull)
+
+#define REC_MSG_STOP                0xFFFE      // Close the segment, recording ended
+#define REC_MSG_QUIT                0xFFFF      // Writer task exits
+
+_Static_assert(sizeof(osc_wavefile_header_t) <= OSC_RECORD_INDEX_OFFSET, "header overlaps the index");
+_Static_assert(OSC_RECORD_INDEX_OFFSET + sizeof(osc_record_index_t) <= OSC_RECORD_DATA_OFFSET,
+               "index exceeds the header block");
+
+/* Pool block descriptor (samples live in the PSRAM pool) */
+typedef struct {
+    uint32_t count;
+    uint32_t rate_hz;
+    uint32_t lost_before;           // Samples dropped just before the first sample
+    uint64_t first_sample;          // Recording sample number (drops included)
+    double t_start;                 // Recording time of the first sample
+} rec_block_t;
+
+/* Recorder context */
+struct osc_recorder_ctx_t {
+    osc_recorder_config_t config;
+    rec_block_t *blocks;
+    int16_t *pool;                  // pool_blocks * OSC_RECORDER_BLOCK_SAMPLES
+    uint8_t *head;                  // Header block scratch (OSC_RECORD_DATA_OFFSET)
+    QueueHandle_t free_q;           // Block indices ready to fill
+    QueueHandle_t full_q;           // Block indices ready to write, or REC_MSG_*
+    SemaphoreHandle_t exited;
+    portMUX_TYPE lock;
+
+    /* Recording parameters (set before producing starts) */
+    char base_path[OSC_RECORDER_PATH_MAX];
+    float volts_per_code;
+    float volts_offset;
+
+    /* Producer (ADC task only while producing) */
+    volatile bool producing;
+    int32_t fill;                   // Block being filled, -1 if none
+    uint32_t rate_hz;
+    double rate_base_s;             // Recording time when the current rate started
+    uint64_t rate_samples;          // Samples offered at the current rate
+    uint64_t sample_number;         // Samples offered since the start
+    uint32_t lost_pending;
+
+    /* Writer task only */
+    FILE *file;
+    bool preallocated;
+    osc_wavefile_header_t header;
+    osc_record_index_t index;
+    uint64_t seg_bytes;
+    uint32_t since_sync;
+    uint64_t total_lost;
+    int64_t window_start_us;
+    uint64_t window_bytes;
+
+    /* Shared status (lock) */
+    osc_recorder_status_t status;
+    int64_t start_us;
+};
+
+/**
+ * @brief Get the default configuration
+ */
+void osc_recorder_get_default_config(osc_recorder_config_t *config)
+{
+    if (config == NULL) return;
+    config->pool_blocks = OSC_RECORDER_DEFAULT_BLOCKS;
+    config->segment_bytes = OSC_RECORDER_DEFAULT_SEGMENT;
+    config->sync_bytes = OSC_RECORDER_DEFAULT_SYNC;
+    config->preallocate = true;
+}
+
+/**
+ * @brief Set the state, keeping an error until the recording is stopped
+ */
+static void set_error(osc_recorder_ctx_t *ctx, esp_err_t err)
+{
+    ctx->producing = false;
+    portENTER_CRITICAL(&ctx->lock);
+    ctx->status.state = OSC_RECORDER_ERROR;
+    ctx->status.last_error = err;
+    portEXIT_CRITICAL(&ctx->lock);
+}
+
+/* ========================================================================
+ * Writer task
+ * ======================================================================== */
+
+/**
+ * @brief Rewrite the header block, return to the end of the data and fsync
+ */
+static esp_err_t write_head(osc_recorder_ctx_t *ctx, bool sync)
+{
+    ctx->header.num_samples = (uint32_t)(ctx->seg_bytes / sizeof(int16_t));
+    memset(ctx->head, 0, OSC_RECORD_DATA_OFFSET);
+    memcpy(ctx->head, &ctx->header, sizeof(ctx->header));
+    memcpy(ctx->head + OSC_RECORD_INDEX_OFFSET, &ctx->index, sizeof(ctx->index));
+
+    if (fseek(ctx->file, 0, SEEK_SET) != 0 ||
+        fwrite(ctx->head, 1, OSC_RECORD_DATA_OFFSET, ctx->file) != OSC_RECORD_DATA_OFFSET ||
+        fseek(ctx->file, OSC_RECORD_DATA_OFFSET + (long)ctx->seg_bytes, SEEK_SET) != 0) {
+        return ESP_FAIL;
+    }
+    if (sync && (fflush(ctx->file) != 0 || fsync(fileno(ctx->file)) != 0)) {
+        return ESP_FAIL;
+    }
+    ctx->since_sync = 0;
+    return ESP_OK;
+}
+
+/**
+ * @brief Finish the open segment: final header, trim the preallocation, close
+ */
+static void close_segment(osc_recorder_ctx_t *ctx)
+{
+    if (ctx->file == NULL) return;
+
+    esp_err_t ret = write_head(ctx, true);
+    if (ret == ESP_OK && ctx->preallocated &&
+        ftruncate(fileno(ctx->file), OSC_RECORD_DATA_OFFSET + (off_t)ctx->seg_bytes) != 0) {
+        ESP_LOGW(TAG, "Failed to trim %s: %s", ctx->status.path, strerror(errno));
+    }
+    if (fclose(ctx->file) != 0 && ret == ESP_OK) {
+        ret = ESP_FAIL;
+    }
+    ctx->file = NULL;
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to close %s", ctx->status.path);
+        set_error(ctx, ret);
+    } else {
+        ESP_LOGI(TAG, "Segment %lu closed: %lu samples, %lu gaps", (unsigned long)ctx->index.segment,
+                 (unsigned long)ctx->header.num_samples, (unsigned long)ctx->index.gap_count);
+    }
+}
+
+/**
+ * @brief Open the next segment for a block
+ */
+static esp_err_t open_segment(osc_recorder_ctx_t *ctx, const rec_block_t *block)
+{
+    uint32_t segment = ctx->status.segment;
+    if (ctx->index.version != 0) {
+        segment++;  // Not the first segment of this recording
+    }
+
+    char path[OSC_RECORDER_PATH_MAX];
+    snprintf(path, sizeof(path), "%s_%04lu%s", ctx->base_path, (unsigned long)segment, OSC_WAVEFILE_EXT);
+
+    // One contiguous extent: no FAT chain updates while streaming, no fragmentation
+    ctx->preallocated = false;
+    if (ctx->config.preallocate) {
+        esp_err_t ret = esp_vfs_fat_create_contiguous_file(OSC_RECORDER_MOUNT_POINT, path,
+                                                           OSC_RECORD_DATA_OFFSET + ctx->config.segment_bytes, true);
+        if (ret == ESP_OK) {
+            ctx->preallocated = true;
+        } else {
+            ESP_LOGW(TAG, "Preallocation of %s failed (%s), writing unreserved", path, esp_err_to_name(ret));
+        }
+    }
+
+    ctx->file = fopen(path, ctx->preallocated ? "r+b" : "wb");
+    if (ctx->file == NULL) {
+        ESP_LOGE(TAG, "Failed to open %s: %s", path, strerror(errno));
+        return ESP_FAIL;
+    }
+    // Blocks are large and sector aligned; stdio buffering would only add a copy
+    setvbuf(ctx->file, NULL, _IONBF, 0);
+
+    osc_wavefile_init_header(&ctx->header, ctx->volts_per_code);
+    ctx->header.data_offset = OSC_RECORD_DATA_OFFSET;
+    ctx->header.volts_offset = ctx->volts_offset;
+    ctx->header.sample_rate = block->rate_hz;
+    ctx->header.flags = OSC_WAVEFILE_FLAG_RECORD;
+    time_t now = time(NULL);
+    struct tm *t = localtime(&now);
+    if (t != NULL) {
+        strftime(ctx->header.timestamp, sizeof(ctx->header.timestamp), "%Y-%m-%d %H:%M:%S", t);
+    }
+
+    memset(&ctx->index, 0, sizeof(ctx->index));
+    memcpy(ctx->index.magic, OSC_RECORD_INDEX_MAGIC, sizeof(ctx->index.magic));
+    ctx->index.version = OSC_RECORD_INDEX_VERSION;
+    ctx->index.segment = segment;
+    ctx->index.first_sample = block->first_sample;
+    ctx->index.start_seconds = block->t_start;
+    ctx->index.total_lost_samples = ctx->total_lost;
+    ctx->seg_bytes = 0;
+
+    portENTER_CRITICAL(&ctx->lock);
+    ctx->status.segment = segment;
+    memcpy(ctx->status.path, path, sizeof(path));
+    portEXIT_CRITICAL(&ctx->lock);
+
+    return write_head(ctx, false);
+}
+
+/**
+ * @brief Write one block, rotating first if needed
+ */
+static esp_err_t write_block(osc_recorder_ctx_t *ctx, const rec_block_t *block, const int16_t *samples)
+{
+    uint32_t bytes = block->count * sizeof(int16_t);
+
+    if (ctx->file == NULL || block->rate_hz != (uint32_t)ctx->header.sample_rate ||
+        ctx->seg_bytes + bytes > ctx->config.segment_bytes) {
+        close_segment(ctx);
+        esp_err_t ret = open_segment(ctx, block);
+        if (ret != ESP_OK) return ret;
+    }
+
+    if (block->lost_before > 0) {
+        if (ctx->index.num_gaps < OSC_RECORD_MAX_GAPS) {
+            osc_record_gap_t *gap = &ctx->index.gaps[ctx->index.num_gaps++];
+            gap->position = (uint32_t)(ctx->seg_bytes / sizeof(int16_t));
+            gap->lost = block->lost_before;
+        }
+        ctx->index.gap_count++;
+        ctx->index.lost_samples += block->lost_before;
+        ctx->index.total_lost_samples += block->lost_before;
+        ctx->total_lost += block->lost_before;
+    }
+
+    if (fwrite(samples, 1, bytes, ctx->file) != bytes) {
+        ESP_LOGE(TAG, "Write failed in %s: %s", ctx->status.path, strerror(errno));
+        return ESP_FAIL;
+    }
+    ctx->seg_bytes += bytes;
+    ctx->since_sync += bytes;
+
+    // Recent card rate over a sliding window
+    int64_t now = esp_timer_get_time();
+    ctx->window_bytes += bytes;
+    uint32_t recent = 0;
+    bool update_recent = false;
+    if (now - ctx->window_start_us >= OSC_RECORDER_RATE_WINDOW_US) {
+        recent = (uint32_t)(ctx->window_bytes * 1000000ULL / 1024 / (uint64_t)(now - ctx->window_start_us));
+        ctx->window_start_us = now;
+        ctx->window_bytes = 0;
+        update_recent = true;
+    }
+
+    portENTER_CRITICAL(&ctx->lock);
+    ctx->status.samples_written += block->count;
+    ctx->status.bytes_written += bytes;
+    if (update_recent) ctx->status.recent_kbps = recent;
+    portEXIT_CRITICAL(&ctx->lock);
+
+    if (ctx->since_sync >= ctx->config.sync_bytes) {
+        return write_head(ctx, true);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Writer task: drain full blocks to the card
+ */
+static void writer_task(void *arg)
+{
+    osc_recorder_ctx_t *ctx = (osc_recorder_ctx_t *)arg;
+
+    for (;;) {
+        uint16_t msg;
+        xQueueReceive(ctx->full_q, &msg, portMAX_DELAY);
+        if (msg == REC_MSG_QUIT) {
+            break;
+        }
+        if (msg == REC_MSG_STOP) {
+            close_segment(ctx);
+            portENTER_CRITICAL(&ctx->lock);
+            ctx->status.state = OSC_RECORDER_IDLE;
+            portEXIT_CRITICAL(&ctx->lock);
+            ESP_LOGI(TAG, "Recording finished: %llu samples, %llu dropped", ctx->status.samples_written,
+                     ctx->status.dropped_samples);
+            continue;
+        }
+
+        // After a write error the backlog is discarded until the recording is stopped
+        if (ctx->status.state != OSC_RECORDER_ERROR) {
+            esp_err_t ret = write_block(ctx, &ctx->blocks[msg], ctx->pool + (size_t)msg * OSC_RECORDER_BLOCK_SAMPLES);
+            if (ret != ESP_OK) {
+                if (ctx->file != NULL) {
+                    fclose(ctx->file);
+                    ctx->file = NULL;
+                }
+                set_error(ctx, ret);
+            }
+        }
+
+        portENTER_CRITICAL(&ctx->lock);
+        ctx->status.backlog--;
+        portEXIT_CRITICAL(&ctx->lock);
+        xQueueSend(ctx->free_q, &msg, portMAX_DELAY);
+    }
+
+    close_segment(ctx);
+    xSemaphoreGive(ctx->exited);
+    vTaskDelete(NULL);
+}
+
+/* ========================================================================
+ * Producer (ADC task)
+ * ======================================================================== */
+
+/**
+ * @brief Hand the block being filled to the writer
+ */
+static void post_fill(osc_recorder_ctx_t *ctx)
+{
+    if (ctx->fill < 0 || ctx->blocks[ctx->fill].count == 0) return;
+
+    uint16_t index = (uint16_t)ctx->fill;
+    ctx->fill = -1;
+
+    portENTER_CRITICAL(&ctx->lock);
+    ctx->status.backlog++;
+    if (ctx->status.backlog > ctx->status.backlog_peak) {
+        ctx->status.backlog_peak = ctx->status.backlog;
+    }
+    portEXIT_CRITICAL(&ctx->lock);
+
+    // Cannot fail: the queue holds every pool block plus the control messages
+    xQueueSend(ctx->full_q, &index, 0);
+}
+
+/**
+ * @brief ADC block hook: queue raw codes (never blocks)
+ */
+void osc_recorder_push(void *user, const uint16_t *raw, uint32_t len, uint32_t sample_rate_hz)
+{
+    osc_recorder_ctx_t *ctx = (osc_recorder_ctx_t *)user;
+    if (ctx == NULL || !ctx->producing || raw == NULL || sample_rate_hz == 0) return;
+
+    // A new rate starts a new segment; time keeps running across the change
+    if (sample_rate_hz != ctx->rate_hz) {
+        post_fill(ctx);
+        if (ctx->rate_hz > 0) {
+            ctx->rate_base_s += (double)ctx->rate_samples / ctx->rate_hz;
+        }
+        ctx->rate_hz = sample_rate_hz;
+        ctx->rate_samples = 0;
+    }
+
+    uint32_t dropped = 0;
+    while (len > 0) {
+        if (ctx->fill < 0) {
+            uint16_t index;
+            if (xQueueReceive(ctx->free_q, &index, 0) != pdTRUE) {
+                // Backlog full: drop the rest of this ADC block
+                dropped = len;
+                break;
+            }
+            rec_block_t *block = &ctx->blocks[index];
+            block->count = 0;
+            block->rate_hz = sample_rate_hz;
+            block->lost_before = ctx->lost_pending;
+            block->first_sample = ctx->sample_number;
+            block->t_start = ctx->rate_base_s + (double)ctx->rate_samples / sample_rate_hz;
+            ctx->lost_pending = 0;
+            ctx->fill = index;
+        }
+
+        rec_block_t *block = &ctx->blocks[ctx->fill];
+        int16_t *out = ctx->pool + (size_t)ctx->fill * OSC_RECORDER_BLOCK_SAMPLES + block->count;
+        uint32_t n = OSC_RECORDER_BLOCK_SAMPLES - block->count;
+        if (n > len) n = len;
+        for (uint32_t i = 0; i < n; i++) {
+            out[i] = (int16_t)(raw[i] * OSC_WAVEFILE_SUBCODES);
+        }
+        block->count += n;
+        raw += n;
+        len -= n;
+        ctx->sample_number += n;
+        ctx->rate_samples += n;
+
+        if (block->count == OSC_RECORDER_BLOCK_SAMPLES) {
+            post_fill(ctx);
+        }
+    }
+
+    if (dropped > 0) {
+        ctx->lost_pending += dropped;
+        ctx->sample_number += dropped;
+        ctx->rate_samples += dropped;
+        portENTER_CRITICAL(&ctx->lock);
+        ctx->status.dropped_blocks++;
+        ctx->status.dropped_samples += dropped;
+        portEXIT_CRITICAL(&ctx->lock);
+    }
+}
+
+/* ========================================================================
+ * Control
+ * ======================================================================== */
+
+/**
+ * @brief Release pool, queues and semaphore
+ */
+static void free_resources(osc_recorder_ctx_t *ctx)
+{
+    if (ctx->free_q) vQueueDelete(ctx->free_q);
+    if (ctx->full_q) vQueueDelete(ctx->full_q);
+    if (ctx->exited) vSemaphoreDelete(ctx->exited);
+    if (ctx->pool) heap_caps_free(ctx->pool);
+    if (ctx->blocks) heap_caps_free(ctx->blocks);
+    if (ctx->head) heap_caps_free(ctx->head);
+    heap_caps_free(ctx);
+}
+
+/**
+ * @brief Create a recorder
+ */
+osc_recorder_ctx_t *osc_recorder_init(const osc_recorder_config_t *config)
+{
+    osc_recorder_ctx_t *ctx = heap_caps_calloc(1, sizeof(osc_recorder_ctx_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) return NULL;
+
+    if (config != NULL) {
+        ctx->config = *config;
+    } else {
+        osc_recorder_get_default_config(&ctx->config);
+    }
+    if (ctx->config.pool_blocks < 2) ctx->config.pool_blocks = 2;
+    if (ctx->config.pool_blocks >= REC_MSG_STOP) ctx->config.pool_blocks = REC_MSG_STOP - 1;
+    if (ctx->config.segment_bytes < OSC_RECORDER_BLOCK_SAMPLES * sizeof(int16_t)) {
+        ctx->config.segment_bytes = OSC_RECORDER_BLOCK_SAMPLES * sizeof(int16_t);
+    }
+    // fseek() takes a long offset
+    if (ctx->config.segment_bytes > OSC_RECORDER_MAX_SEGMENT) ctx->config.segment_bytes = OSC_RECORDER_MAX_SEGMENT;
+
+    uint32_t n = ctx->config.pool_blocks;
+    portMUX_INITIALIZE(&ctx->lock);
+    ctx->fill = -1;
+    ctx->pool = heap_caps_aligned_alloc(64, (size_t)n * OSC_RECORDER_BLOCK_SAMPLES * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    ctx->blocks = heap_caps_calloc(n, sizeof(rec_block_t), MALLOC_CAP_8BIT);
+    ctx->head = heap_caps_aligned_alloc(64, OSC_RECORD_DATA_OFFSET, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    ctx->free_q = xQueueCreate(n, sizeof(uint16_t));
+    ctx->full_q = xQueueCreate(n + 2, sizeof(uint16_t));
+    ctx->exited = xSemaphoreCreateBinary();
+    if (ctx->pool == NULL || ctx->blocks == NULL || ctx->head == NULL || ctx->free_q == NULL ||
+        ctx->full_q == NULL || ctx->exited == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %lu block pool", (unsigned long)n);
+        free_resources(ctx);
+        return NULL;
+    }
+    for (uint16_t i = 0; i < n; i++) {
+        xQueueSend(ctx->free_q, &i, 0);
+    }
+    ctx->status.pool_blocks = n;
+
+    if (xTaskCreate(writer_task, "osc_rec", OSC_RECORDER_TASK_STACK, ctx, OSC_RECORDER_TASK_PRIORITY, NULL) != pdPASS) {
+        free_resources(ctx);
+        return NULL;
+    }
+
+    ESP_LOGI(TAG, "Recorder ready: %lu x %u sample blocks, %llu MB segments", (unsigned long)n,
+             OSC_RECORDER_BLOCK_SAMPLES, ctx->config.segment_bytes >> 20);
+    return ctx;
+}
+
+/**
+ * @brief Destroy a recorder
+ */
+void osc_recorder_deinit(osc_recorder_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    osc_recorder_stop(ctx);
+    uint16_t msg = REC_MSG_QUIT;
+    xQueueSend(ctx->full_q, &msg, portMAX_DELAY);
+    xSemaphoreTake(ctx->exited, portMAX_DELAY);
+    vTaskDelay(pdMS_TO_TICKS(10));  // Let the writer task exit
+
+    free_resources(ctx);
+}
+
+/**
+ * @brief Start a recording
+ */
+esp_err_t osc_recorder_start(osc_recorder_ctx_t *ctx, const char *base_path, float volts_per_code,
+                             float volts_offset)
+{
+    if (ctx == NULL || base_path == NULL || !(volts_per_code > 0.0f)) return ESP_ERR_INVALID_ARG;
+
+    portENTER_CRITICAL(&ctx->lock);
+    bool idle = (ctx->status.state == OSC_RECORDER_IDLE);
+    portEXIT_CRITICAL(&ctx->lock);
+    if (!idle) return ESP_ERR_INVALID_STATE;
+
+    snprintf(ctx->base_path, sizeof(ctx->base_path), "%s", base_path);
+    ctx->volts_per_code = volts_per_code;
+    ctx->volts_offset = volts_offset;
+
+    // A block left by a recording that ended in an error goes back to the pool
+    if (ctx->fill >= 0) {
+        uint16_t index = (uint16_t)ctx->fill;
+        xQueueSend(ctx->free_q, &index, 0);
+        ctx->fill = -1;
+    }
+    ctx->rate_hz = 0;
+    ctx->rate_base_s = 0.0;
+    ctx->rate_samples = 0;
+    ctx->sample_number = 0;
+    ctx->lost_pending = 0;
+    ctx->total_lost = 0;
+    memset(&ctx->index, 0, sizeof(ctx->index));     // version 0: no segment written yet
+    ctx->window_start_us = esp_timer_get_time();
+    ctx->window_bytes = 0;
+
+    portENTER_CRITICAL(&ctx->lock);
+    uint32_t pool_blocks = ctx->status.pool_blocks;
+    memset(&ctx->status, 0, sizeof(ctx->status));
+    ctx->status.pool_blocks = pool_blocks;
+    ctx->status.state = OSC_RECORDER_RECORDING;
+    ctx->status.last_error = ESP_OK;
+    ctx->start_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&ctx->lock);
+
+    ctx->producing = true;
+    ESP_LOGI(TAG, "Recording to %s_NNNN%s", base_path, OSC_WAVEFILE_EXT);
+    return ESP_OK;
+}
+
+/**
+ * @brief Stop a recording
+ */
+void osc_recorder_stop(osc_recorder_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    portENTER_CRITICAL(&ctx->lock);
+    osc_recorder_state_t state = ctx->status.state;
+    if (state == OSC_RECORDER_RECORDING) {
+        ctx->status.state = OSC_RECORDER_FINISHING;
+    }
+    portEXIT_CRITICAL(&ctx->lock);
+    if (state != OSC_RECORDER_RECORDING && state != OSC_RECORDER_ERROR) return;
+
+    // The hook is detached, so the producer state is ours
+    ctx->producing = false;
+    if (state == OSC_RECORDER_RECORDING) {
+        post_fill(ctx);
+    }
+    uint16_t msg = REC_MSG_STOP;
+    xQueueSend(ctx->full_q, &msg, portMAX_DELAY);
+}
+
+/**
+ * @brief Get recorder status
+ */
+void osc_recorder_get_status(osc_recorder_ctx_t *ctx, osc_recorder_status_t *status)
+{
+    if (ctx == NULL || status == NULL) return;
+
+    portENTER_CRITICAL(&ctx->lock);
+    *status = ctx->status;
+    int64_t elapsed_us = esp_timer_get_time() - ctx->start_us;
+    portEXIT_CRITICAL(&ctx->lock);
+
+    uint32_t rate = ctx->rate_hz;
+    status->input_kbps = rate * sizeof(int16_t) / 1024;
+    status->write_kbps = (elapsed_us > 0) ? (uint32_t)(status->bytes_written * 1000000ULL / 1024 / (uint64_t)elapsed_us) : 0;
+    status->seconds = (rate > 0) ? ctx->rate_base_s + (double)ctx->rate_samples / rate : 0.0;
+}
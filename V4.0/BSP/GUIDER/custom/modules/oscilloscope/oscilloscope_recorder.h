@@ -0,0 +1,158 @@
+/**
+ * @file oscilloscope_recorder.h
+ * @brief Continuous streaming recorder (raw acquisition to rotating SD files)
+ *
+ * The ADC task hands every acquired block to osc_recorder_push(), which
+ * copies it into a fixed pool of PSRAM blocks and never waits: when the pool
+ * is exhausted the samples are dropped and counted, so a slow card can never
+ * stall acquisition or the display. A writer task drains full blocks to
+ * .osw segments (see oscilloscope_wavefile.h) named <base>_0000.osw,
+ * <base>_0001.osw, ... Each segment is preallocated as one contiguous file,
+ * starts with its index header and is rotated at a size limit or when the
+ * sample rate changes. The header is rewritten at every sync point, so a
+ * power loss leaves the file readable up to the last sync.
+ *
+ * Segment layout:
+ *   0     osc_wavefile_header_t (num_samples = samples in this segment)
+ *   512   osc_record_index_t
+ *   4096  int16 samples (ADC code x OSC_WAVEFILE_SUBCODES), sector aligned
+ */
+
+#ifndef OSCILLOSCOPE_RECORDER_H
+#define OSCILLOSCOPE_RECORDER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OSC_RECORD_INDEX_OFFSET     512
+#define OSC_RECORD_DATA_OFFSET      4096            // Keeps every block write sector aligned
+#define OSC_RECORD_INDEX_MAGIC      "OSRI"
+#define OSC_RECORD_INDEX_VERSION    1
+#define OSC_RECORD_MAX_GAPS         256             // Gaps listed per segment (all are counted)
+
+#define OSC_RECORDER_BLOCK_SAMPLES  8192            // Samples per pool block (16 KB)
+#define OSC_RECORDER_DEFAULT_BLOCKS 48              // Pool blocks (768 KB, ~390 ms at 1 MSa/s)
+#define OSC_RECORDER_DEFAULT_SEGMENT (256u * 1024u * 1024u)    // Bytes per segment
+#define OSC_RECORDER_DEFAULT_SYNC   (4u * 1024u * 1024u)       // Bytes between header rewrites + fsync
+#define OSC_RECORDER_PATH_MAX       96
+
+/* Samples lost before a position of the segment */
+typedef struct __attribute__((packed)) {
+    uint32_t position;              // Segment sample index after the gap
+    uint32_t lost;                  // Samples dropped
+} osc_record_gap_t;
+
+/* Per-segment index header */
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint16_t version;
+    uint16_t num_gaps;              // Entries used in gaps[]
+    uint32_t segment;               // Segment number, from 0
+    uint32_t gap_count;             // Gaps in this segment (may exceed num_gaps)
+    uint64_t first_sample;          // Recording sample number of the first sample (drops included)
+    double start_seconds;           // Recording time of the first sample
+    uint64_t lost_samples;          // Samples dropped in this segment
+    uint64_t total_lost_samples;    // Samples dropped since the recording started
+    osc_record_gap_t gaps[OSC_RECORD_MAX_GAPS];
+} osc_record_index_t;
+
+/* Recorder configuration */
+typedef struct {
+    uint32_t pool_blocks;           // Backlog bound in blocks of OSC_RECORDER_BLOCK_SAMPLES
+    uint64_t segment_bytes;         // Rotate after this many bytes of samples
+    uint32_t sync_bytes;            // Rewrite the header and fsync after this many bytes
+    bool preallocate;               // Reserve each segment contiguously before writing
+} osc_recorder_config_t;
+
+/* Recorder state */
+typedef enum {
+    OSC_RECORDER_IDLE = 0,
+    OSC_RECORDER_RECORDING,
+    OSC_RECORDER_FINISHING,         // Stopped, backlog still being written
+    OSC_RECORDER_ERROR,             // Write failed; recording ended
+} osc_recorder_state_t;
+
+/* Recorder status */
+typedef struct {
+    osc_recorder_state_t state;
+    uint32_t segment;               // Segment being written
+    uint64_t samples_written;
+    uint64_t bytes_written;
+    uint64_t dropped_samples;
+    uint32_t dropped_blocks;        // ADC blocks lost whole or in part
+    uint32_t backlog;               // Full blocks waiting for the card
+    uint32_t backlog_peak;
+    uint32_t pool_blocks;
+    uint32_t input_kbps;            // Acquisition data rate
+    uint32_t write_kbps;            // Sustained card rate since the start
+    uint32_t recent_kbps;           // Card rate over the last second or so
+    double seconds;                 // Recording time covered (drops included)
+    esp_err_t last_error;
+    char path[OSC_RECORDER_PATH_MAX];   // Current / last segment
+} osc_recorder_status_t;
+
+/* Recorder context (opaque) */
+typedef struct osc_recorder_ctx_t osc_recorder_ctx_t;
+
+/**
+ * @brief Get the default configuration
+ */
+void osc_recorder_get_default_config(osc_recorder_config_t *config);
+
+/**
+ * @brief Create a recorder (allocates the block pool and starts the writer task)
+ *
+ * @param config Configuration (NULL = defaults)
+ * @return Recorder context, NULL on failure
+ */
+osc_recorder_ctx_t *osc_recorder_init(const osc_recorder_config_t *config);
+
+/**
+ * @brief Destroy a recorder (a recording is stopped and written out first)
+ */
+void osc_recorder_deinit(osc_recorder_ctx_t *ctx);
+
+/**
+ * @brief Start a recording
+ *
+ * Segments are named base_path + "_%04u" + OSC_WAVEFILE_EXT.
+ *
+ * @param ctx Recorder context
+ * @param base_path Path without extension (copied)
+ * @param volts_per_code Volts per ADC code
+ * @param volts_offset Volts at code 0
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if busy
+ */
+esp_err_t osc_recorder_start(osc_recorder_ctx_t *ctx, const char *base_path, float volts_per_code,
+                             float volts_offset);
+
+/**
+ * @brief Stop a recording
+ *
+ * Returns at once; the backlog is written and the last segment closed by the
+ * writer task (state FINISHING, then IDLE). Detach the ADC hook first.
+ */
+void osc_recorder_stop(osc_recorder_ctx_t *ctx);
+
+/**
+ * @brief ADC block hook: queue raw codes (never blocks)
+ *
+ * Signature matches osc_adc_block_hook_t; user is the recorder context.
+ */
+void osc_recorder_push(void *user, const uint16_t *raw, uint32_t len, uint32_t sample_rate_hz);
+
+/**
+ * @brief Get recorder status
+ */
+void osc_recorder_get_status(osc_recorder_ctx_t *ctx, osc_recorder_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_RECORDER_H
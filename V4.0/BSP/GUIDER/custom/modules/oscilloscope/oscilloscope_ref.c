@@ -0,0 +1,347 @@
+/**
+ * @file oscilloscope_ref.c
+ * @brief Reference waveform slots implementation
+ */
+
+#include "oscilloscope_ref.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+static const char *TAG = "OscRef";
+
+#define OSC_REF_FILE_MAGIC      "OSCR"
+#define OSC_REF_FILE_VERSION    1
+
+/* Reference file header (followed by num_points floats) */
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t num_points;
+    float time_per_point;
+    float start_time;
+    float time_per_div;
+    float volts_per_div;
+} osc_ref_file_header_t;
+
+/* One slot */
+typedef struct {
+    float *data;                    // PSRAM, OSC_REF_MAX_POINTS
+    osc_ref_info_t info;
+    bool valid;
+
+    /* Projection cache */
+    int16_t columns[OSC_REF_MAX_COLUMNS];
+    osc_ref_view_t view;
+    bool cache_valid;
+} osc_ref_slot_t;
+
+/* Reference context */
+struct osc_ref_ctx_t {
+    osc_ref_slot_t slots[OSC_REF_SLOT_COUNT];
+    SemaphoreHandle_t mutex;
+};
+
+/**
+ * @brief Compare two views
+ */
+static bool view_equal(const osc_ref_view_t *a, const osc_ref_view_t *b)
+{
+    return a->width == b->width && a->time_per_div == b->time_per_div && a->grid_cols == b->grid_cols &&
+           a->center_time == b->center_time && a->units_per_volt == b->units_per_volt &&
+           a->zero_units == b->zero_units && a->min_units == b->min_units && a->max_units == b->max_units;
+}
+
+/**
+ * @brief Project a slot onto the display columns
+ */
+static void project_slot(osc_ref_slot_t *s, const osc_ref_view_t *view)
+{
+    const osc_ref_info_t *info = &s->info;
+    float display_time = view->time_per_div * view->grid_cols;
+    float time_per_column = display_time / view->width;
+    float first_time = view->center_time - display_time / 2.0f;
+
+    // Column i shows stored point (pos0 + i * step), same sampling as the live trace
+    float pos0 = (first_time - info->start_time) / info->time_per_point;
+    float step = time_per_column / info->time_per_point;
+    float last = (float)(info->num_points - 1);
+
+    for (uint16_t i = 0; i < view->width; i++) {
+        float pos = pos0 + i * step;
+        if (pos < 0.0f || pos > last) {
+            s->columns[i] = OSC_REF_POINT_NONE;
+            continue;
+        }
+
+        uint32_t idx = (uint32_t)pos;
+        float v = s->data[idx];
+        if (idx + 1 < info->num_points) {
+            float frac = pos - (float)idx;
+            v += (s->data[idx + 1] - v) * frac;
+        }
+
+        float y = view->zero_units + v * view->units_per_volt;
+        if (y < view->min_units) y = view->min_units;
+        if (y > view->max_units) y = view->max_units;
+        s->columns[i] = (int16_t)(y + 0.5f);
+    }
+
+    s->view = *view;
+    s->cache_valid = true;
+}
+
+/**
+ * @brief Initialize reference slots
+ */
+osc_ref_ctx_t *osc_ref_init(void)
+{
+    osc_ref_ctx_t *ctx = heap_caps_malloc(sizeof(osc_ref_ctx_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(osc_ref_ctx_t));
+
+    ctx->mutex = xSemaphoreCreateMutex();
+    bool ok = (ctx->mutex != NULL);
+    for (int i = 0; i < OSC_REF_SLOT_COUNT && ok; i++) {
+        ctx->slots[i].data = heap_caps_malloc(OSC_REF_MAX_POINTS * sizeof(float), MALLOC_CAP_SPIRAM);
+        ok = (ctx->slots[i].data != NULL);
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to allocate reference buffers");
+        osc_ref_deinit(ctx);
+        return NULL;
+    }
+
+    ESP_LOGI(TAG, "Reference slots initialized (%d x %d points)", OSC_REF_SLOT_COUNT, OSC_REF_MAX_POINTS);
+    return ctx;
+}
+
+/**
+ * @brief Deinitialize reference slots
+ */
+void osc_ref_deinit(osc_ref_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    for (int i = 0; i < OSC_REF_SLOT_COUNT; i++) {
+        heap_caps_free(ctx->slots[i].data);
+    }
+    if (ctx->mutex) vSemaphoreDelete(ctx->mutex);
+    free(ctx);
+}
+
+/**
+ * @brief Store a waveform in a slot
+ */
+esp_err_t osc_ref_store(osc_ref_ctx_t *ctx, uint8_t slot, const float *data, uint32_t num_points,
+                        uint32_t stride, const osc_ref_info_t *info)
+{
+    if (ctx == NULL || slot >= OSC_REF_SLOT_COUNT || data == NULL || info == NULL) return ESP_ERR_INVALID_ARG;
+    if (stride == 0 || num_points < 2 || info->time_per_point <= 0.0f) return ESP_ERR_INVALID_ARG;
+
+    uint32_t count = (num_points + stride - 1) / stride;
+    if (count > OSC_REF_MAX_POINTS) count = OSC_REF_MAX_POINTS;
+    if (count < 2) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    osc_ref_slot_t *s = &ctx->slots[slot];
+    for (uint32_t i = 0; i < count; i++) {
+        s->data[i] = data[i * stride];
+    }
+    s->info = *info;
+    s->info.num_points = count;
+    s->valid = true;
+    s->cache_valid = false;
+
+    xSemaphoreGive(ctx->mutex);
+
+    ESP_LOGI(TAG, "REF %c: %lu points, %.3gs/pt", 'A' + slot, count, info->time_per_point);
+    return ESP_OK;
+}
+
+/**
+ * @brief Empty a slot
+ */
+void osc_ref_clear(osc_ref_ctx_t *ctx, uint8_t slot)
+{
+    if (ctx == NULL || slot >= OSC_REF_SLOT_COUNT) return;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->slots[slot].valid = false;
+    ctx->slots[slot].cache_valid = false;
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Check if a slot holds a waveform
+ */
+bool osc_ref_is_valid(osc_ref_ctx_t *ctx, uint8_t slot)
+{
+    if (ctx == NULL || slot >= OSC_REF_SLOT_COUNT) return false;
+    return ctx->slots[slot].valid;
+}
+
+/**
+ * @brief Get description of a stored waveform
+ */
+esp_err_t osc_ref_get_info(osc_ref_ctx_t *ctx, uint8_t slot, osc_ref_info_t *info)
+{
+    if (ctx == NULL || slot >= OSC_REF_SLOT_COUNT || info == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    if (ctx->slots[slot].valid) {
+        *info = ctx->slots[slot].info;
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Get a slot projected onto the display
+ */
+esp_err_t osc_ref_render(osc_ref_ctx_t *ctx, uint8_t slot, const osc_ref_view_t *view,
+                         int16_t *columns, bool *changed)
+{
+    if (ctx == NULL || slot >= OSC_REF_SLOT_COUNT || view == NULL || columns == NULL) return ESP_ERR_INVALID_ARG;
+    if (view->width == 0 || view->width > OSC_REF_MAX_COLUMNS || view->grid_cols == 0) return ESP_ERR_INVALID_ARG;
+    if (changed) *changed = false;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    osc_ref_slot_t *s = &ctx->slots[slot];
+    if (!s->valid) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (!s->cache_valid || !view_equal(&s->view, view)) {
+        project_slot(s, view);
+        if (changed) *changed = true;
+    }
+    memcpy(columns, s->columns, view->width * sizeof(int16_t));
+
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Get default file path of a slot
+ */
+void osc_ref_get_default_path(uint8_t slot, char *path, size_t size)
+{
+    snprintf(path, size, OSC_REF_DEFAULT_DIR "/ref%c.osr", 'A' + (slot % OSC_REF_SLOT_COUNT));
+}
+
+/**
+ * @brief Save a slot to a file
+ */
+esp_err_t osc_ref_save(osc_ref_ctx_t *ctx, uint8_t slot, const char *path)
+{
+    if (ctx == NULL || slot >= OSC_REF_SLOT_COUNT || path == NULL) return ESP_ERR_INVALID_ARG;
+
+    struct stat st;
+    if (stat(OSC_REF_DEFAULT_DIR, &st) != 0) {
+        mkdir(OSC_REF_DEFAULT_DIR, 0755);
+    }
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    osc_ref_slot_t *s = &ctx->slots[slot];
+    if (!s->valid) {
+        xSemaphoreGive(ctx->mutex);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        xSemaphoreGive(ctx->mutex);
+        ESP_LOGE(TAG, "Failed to create %s: %s", path, strerror(errno));
+        return ESP_FAIL;
+    }
+
+    osc_ref_file_header_t header = {
+        .version = OSC_REF_FILE_VERSION,
+        .num_points = s->info.num_points,
+        .time_per_point = s->info.time_per_point,
+        .start_time = s->info.start_time,
+        .time_per_div = s->info.time_per_div,
+        .volts_per_div = s->info.volts_per_div,
+    };
+    memcpy(header.magic, OSC_REF_FILE_MAGIC, sizeof(header.magic));
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(s->data, sizeof(float), s->info.num_points, f) == s->info.num_points;
+    fclose(f);
+
+    xSemaphoreGive(ctx->mutex);
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to write %s", path);
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "REF %c saved: %s", 'A' + slot, path);
+    return ESP_OK;
+}
+
+/**
+ * @brief Load a slot from a file
+ */
+esp_err_t osc_ref_load(osc_ref_ctx_t *ctx, uint8_t slot, const char *path)
+{
+    if (ctx == NULL || slot >= OSC_REF_SLOT_COUNT || path == NULL) return ESP_ERR_INVALID_ARG;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    osc_ref_file_header_t header;
+    if (fread(&header, sizeof(header), 1, f) != 1 ||
+        memcmp(header.magic, OSC_REF_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != OSC_REF_FILE_VERSION ||
+        header.num_points < 2 || header.num_points > OSC_REF_MAX_POINTS ||
+        !(header.time_per_point > 0.0f)) {
+        fclose(f);
+        ESP_LOGE(TAG, "Invalid reference file: %s", path);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    osc_ref_slot_t *s = &ctx->slots[slot];
+    bool ok = fread(s->data, sizeof(float), header.num_points, f) == header.num_points;
+    fclose(f);
+
+    if (ok) {
+        s->info.num_points = header.num_points;
+        s->info.time_per_point = header.time_per_point;
+        s->info.start_time = header.start_time;
+        s->info.time_per_div = header.time_per_div;
+        s->info.volts_per_div = header.volts_per_div;
+    }
+    // A truncated file leaves the buffer half-written: drop the slot
+    s->valid = ok;
+    s->cache_valid = false;
+
+    xSemaphoreGive(ctx->mutex);
+
+    if (!ok) {
+        ESP_LOGE(TAG, "Truncated reference file: %s", path);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    ESP_LOGI(TAG, "REF %c loaded: %s (%lu points)", 'A' + slot, path, header.num_points);
+    return ESP_OK;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file oscilloscope_ref.h
+ * @brief Reference waveform slots (REF A-D)
+ *
+ * Each slot holds a copy of the visible window (PSRAM) together with the
+ * timing and scales it was captured at, so it can be re-projected onto the
+ * current time/div, volts/div and offsets. The projection to display columns
+ * is cached per slot and recomputed only when the view changes, leaving a
+ * plain copy per frame for the overlay.
+ *
+ * Slots can be persisted to SD card (/sdcard/Oscilloscope/refA.osr ...).
+ */
+
+#ifndef OSCILLOSCOPE_REF_H
+#define OSCILLOSCOPE_REF_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Slot limits */
+#define OSC_REF_SLOT_COUNT          4
+#define OSC_REF_MAX_POINTS          4096    // Stored points per slot
+#define OSC_REF_MAX_COLUMNS         1024    // Projected display columns
+#define OSC_REF_DEFAULT_DIR         "/sdcard/Oscilloscope"
+#define OSC_REF_POINT_NONE          INT16_MAX   // Column without data (LV_CHART_POINT_NONE with 16-bit coordinates)
+
+/* Stored waveform description */
+typedef struct {
+    uint32_t num_points;
+    float time_per_point;           // Seconds between stored points
+    float start_time;               // Time of the first point relative to the trigger (seconds)
+    float time_per_div;             // Horizontal scale when stored
+    float volts_per_div;            // Vertical scale when stored
+} osc_ref_info_t;
+
+/* Display the slots are projected onto */
+typedef struct {
+    uint16_t width;                 // Display columns
+    float time_per_div;             // Current horizontal scale
+    uint8_t grid_cols;              // Horizontal divisions across width
+    float center_time;              // Time at the screen center relative to the trigger (seconds)
+    float units_per_volt;           // Display units per volt
+    float zero_units;               // Display value of 0 V (includes the vertical offset)
+    int16_t min_units;              // Display range (values are clamped to it)
+    int16_t max_units;
+} osc_ref_view_t;
+
+/* Reference context */
+typedef struct osc_ref_ctx_t osc_ref_ctx_t;
+
+/**
+ * @brief Initialize reference slots (all empty)
+ *
+ * @return Reference context or NULL on error
+ */
+osc_ref_ctx_t *osc_ref_init(void);
+
+/**
+ * @brief Deinitialize reference slots
+ *
+ * @param ctx Reference context
+ */
+void osc_ref_deinit(osc_ref_ctx_t *ctx);
+
+/**
+ * @brief Store a waveform in a slot
+ *
+ * Takes every stride-th sample of data, up to OSC_REF_MAX_POINTS points.
+ *
+ * @param ctx Reference context
+ * @param slot Slot (0 = REF A)
+ * @param data Samples (volts)
+ * @param num_points Number of samples in data
+ * @param stride Sample step (>= 1)
+ * @param info Timing and scales of the stored points (num_points is filled in)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on a bad slot or empty data
+ */
+esp_err_t osc_ref_store(osc_ref_ctx_t *ctx, uint8_t slot, const float *data, uint32_t num_points,
+                        uint32_t stride, const osc_ref_info_t *info);
+
+/**
+ * @brief Empty a slot
+ *
+ * @param ctx Reference context
+ * @param slot Slot
+ */
+void osc_ref_clear(osc_ref_ctx_t *ctx, uint8_t slot);
+
+/**
+ * @brief Check if a slot holds a waveform
+ *
+ * @param ctx Reference context
+ * @param slot Slot
+ * @return true if the slot is in use
+ */
+bool osc_ref_is_valid(osc_ref_ctx_t *ctx, uint8_t slot);
+
+/**
+ * @brief Get description of a stored waveform
+ *
+ * @param ctx Reference context
+ * @param slot Slot
+ * @param info Output: description
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the slot is empty
+ */
+esp_err_t osc_ref_get_info(osc_ref_ctx_t *ctx, uint8_t slot, osc_ref_info_t *info);
+
+/**
+ * @brief Get a slot projected onto the display
+ *
+ * The projection is cached and recomputed only if the view or the slot
+ * changed since the last call.
+ *
+ * @param ctx Reference context
+ * @param slot Slot
+ * @param view Display parameters
+ * @param columns Output: view->width display values (OSC_REF_POINT_NONE outside the stored window)
+ * @param changed Output: values differ from the previous call (may be NULL)
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the slot is empty
+ */
+esp_err_t osc_ref_render(osc_ref_ctx_t *ctx, uint8_t slot, const osc_ref_view_t *view,
+                         int16_t *columns, bool *changed);
+
+/**
+ * @brief Get default file path of a slot
+ *
+ * @param slot Slot
+ * @param path Output buffer
+ * @param size Size of path
+ */
+void osc_ref_get_default_path(uint8_t slot, char *path, size_t size);
+
+/**
+ * @brief Save a slot to a file
+ *
+ * @param ctx Reference context
+ * @param slot Slot
+ * @param path File path
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the slot is empty, ESP_FAIL on I/O error
+ */
+esp_err_t osc_ref_save(osc_ref_ctx_t *ctx, uint8_t slot, const char *path);
+
+/**
+ * @brief Load a slot from a file
+ *
+ * @param ctx Reference context
+ * @param slot Slot
+ * @param path File path
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if the file does not exist,
+ *         ESP_ERR_INVALID_RESPONSE on a bad or truncated file (slot is emptied)
+ */
+esp_err_t osc_ref_load(osc_ref_ctx_t *ctx, uint8_t slot, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_REF_H
@@ -0,0 +1,506 @@
+/**
+ * @file oscilloscope_scpi.c
+ * @brief Remote control of the oscilloscope over SCPI
+ */
+
+#include "oscilloscope_scpi.h"
+#include "lvgl.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <math.h>
+#include <string.h>
+
+static const char *TAG = "OscScpi";
+
+#define UI_DRAIN_PERIOD_MS  20
+#define SCPI_NAN            9.9e37f     // SCPI "not a number"
+
+/* UI operations, by index into osc_scpi_ui_t */
+typedef enum {
+    UI_OP_TIME_SCALE = 0,
+    UI_OP_VOLT_SCALE,
+    UI_OP_TRIGGER_LEVEL,
+    UI_OP_TRIGGER_SLOPE,
+    UI_OP_RUN,
+} ui_op_t;
+
+/* UI call posted by the server task */
+typedef struct {
+    ui_op_t op;
+    float value;
+    uint32_t seq;
+} ui_call_t;
+
+/* Block being sent from a pinned capture */
+typedef struct {
+    bool in_use;
+    osc_waveform_view_t view;
+} pinned_block_t;
+
+static osc_core_ctx_t *g_core = NULL;
+static TaskHandle_t g_task = NULL;
+static SemaphoreHandle_t g_exited = NULL;
+static volatile bool g_running = false;
+static uint16_t g_port = 0;
+
+/* UI marshalling: the server task posts one call and waits for its sequence number */
+static osc_scpi_ui_t g_ui;                  // LVGL thread only
+static bool g_ui_set = false;
+static QueueHandle_t g_ui_queue = NULL;
+static SemaphoreHandle_t g_ui_done = NULL;
+static lv_timer_t *g_ui_timer = NULL;
+static uint32_t g_ui_seq = 0;               // Server task only
+static uint32_t g_ui_done_seq = 0;          // Written before g_ui_done is given
+static float g_ui_result = 0.0f;
+static esp_err_t g_ui_ret = ESP_OK;
+
+static pinned_block_t g_blocks[SCPI_SERVER_MAX_CLIENTS];   // Server task only
+
+/* ========================================================================
+ * UI operations
+ * ======================================================================== */
+
+/**
+ * @brief Run posted UI calls (LVGL thread)
+ */
+static void ui_drain_timer_cb(lv_timer_t *timer)
+{
+    ui_call_t call;
+    while (xQueueReceive(g_ui_queue, &call, 0) == pdTRUE) {
+        osc_scpi_ui_fn fn = NULL;
+        if (g_ui_set) {
+            const osc_scpi_ui_fn table[] = {
+                [UI_OP_TIME_SCALE] = g_ui.time_scale,
+                [UI_OP_VOLT_SCALE] = g_ui.volt_scale,
+                [UI_OP_TRIGGER_LEVEL] = g_ui.trigger_level,
+                [UI_OP_TRIGGER_SLOPE] = g_ui.trigger_slope,
+                [UI_OP_RUN] = g_ui.run,
+            };
+            fn = table[call.op];
+        }
+        float result = 0.0f;
+        g_ui_ret = (fn != NULL) ? fn(call.value, &result) : ESP_ERR_INVALID_STATE;
+        g_ui_result = result;
+        g_ui_done_seq = call.seq;
+        xSemaphoreGive(g_ui_done);
+    }
+}
+
+/**
+ * @brief Run a UI operation on the LVGL thread and wait for it (server task)
+ */
+static esp_err_t ui_call(ui_op_t op, float value, float *result)
+{
+    ui_call_t call = { .op = op, .value = value, .seq = ++g_ui_seq };
+
+    // A completion left by a call that timed out is stale
+    xSemaphoreTake(g_ui_done, 0);
+    if (xQueueSend(g_ui_queue, &call, pdMS_TO_TICKS(OSC_SCPI_UI_TIMEOUT_MS)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    // Short waits so a stop from the LVGL thread is not held up by this call
+    for (uint32_t waited = 0; waited < OSC_SCPI_UI_TIMEOUT_MS && g_running; waited += 50) {
+        if (xSemaphoreTake(g_ui_done, pdMS_TO_TICKS(50)) == pdTRUE && g_ui_done_seq == call.seq) {
+            if (result) *result = g_ui_result;
+            return g_ui_ret;
+        }
+    }
+    return ESP_ERR_TIMEOUT;
+}
+
+/**
+ * @brief Set (with a parameter) or query (with '?') a numeric UI setting
+ */
+static esp_err_t ui_setting(scpi_client_t *client, ui_op_t op, const char *args, bool query)
+{
+    float value = NAN;
+    if (!query) {
+        if (args[0] == '\0') {
+            scpi_push_error(client, SCPI_ERROR_MISSING_PARAMETER, "Missing parameter");
+            return ESP_ERR_INVALID_ARG;
+        }
+        if (!scpi_parse_number(args, &value)) {
+            scpi_push_error(client, SCPI_ERROR_DATA_OUT_OF_RANGE, "Data out of range");
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    float result;
+    esp_err_t ret = ui_call(op, value, &result);
+    if (ret == ESP_ERR_INVALID_ARG) {
+        scpi_push_error(client, SCPI_ERROR_DATA_OUT_OF_RANGE, "Data out of range");
+    } else if (ret != ESP_OK) {
+        scpi_push_error(client, SCPI_ERROR_SETTINGS_CONFLICT, "Settings conflict");
+    } else if (query) {
+        scpi_reply(client, "%.6e", result);
+    }
+    return ret;
+}
+
+/* ========================================================================
+ * Command handlers
+ * ======================================================================== */
+
+static esp_err_t cmd_idn(scpi_client_t *client, const char *args, void *user)
+{
+    return scpi_reply(client, "ESP32-P4,Oscilloscope,0,V4.0");
+}
+
+static esp_err_t cmd_opc(scpi_client_t *client, const char *args, void *user)
+{
+    // Commands run in order, so everything before this has completed
+    return scpi_reply(client, "1");
+}
+
+static esp_err_t cmd_cls(scpi_client_t *client, const char *args, void *user)
+{
+    scpi_clear_errors(client);
+    return ESP_OK;
+}
+
+static esp_err_t cmd_syst_err(scpi_client_t *client, const char *args, void *user)
+{
+    const char *message;
+    int code = scpi_pop_error(client, &message);
+    return scpi_reply(client, "%d,\"%s\"", code, message);
+}
+
+static esp_err_t run_state(scpi_client_t *client, int state)
+{
+    esp_err_t ret = ui_call(UI_OP_RUN, (float)state, NULL);
+    if (ret != ESP_OK) {
+        scpi_push_error(client, SCPI_ERROR_SETTINGS_CONFLICT, "Settings conflict");
+    }
+    return ret;
+}
+
+static esp_err_t cmd_run(scpi_client_t *client, const char *args, void *user)
+{
+    return run_state(client, OSC_SCPI_RUN);
+}
+
+static esp_err_t cmd_stop(scpi_client_t *client, const char *args, void *user)
+{
+    return run_state(client, OSC_SCPI_STOP);
+}
+
+static esp_err_t cmd_single(scpi_client_t *client, const char *args, void *user)
+{
+    return run_state(client, OSC_SCPI_SINGLE);
+}
+
+static esp_err_t cmd_trig_status(scpi_client_t *client, const char *args, void *user)
+{
+    static const char *const names[] = { "RUN", "STOP", "WAIT" };
+    osc_state_t state = osc_core_get_state(g_core);
+    return scpi_reply(client, "%s", (state <= OSC_STATE_WAITING) ? names[state] : "STOP");
+}
+
+static esp_err_t cmd_tim_scale(scpi_client_t *client, const char *args, void *user)
+{
+    return ui_setting(client, UI_OP_TIME_SCALE, args, false);
+}
+
+static esp_err_t cmd_tim_scale_q(scpi_client_t *client, const char *args, void *user)
+{
+    return ui_setting(client, UI_OP_TIME_SCALE, args, true);
+}
+
+static esp_err_t cmd_chan_scale(scpi_client_t *client, const char *args, void *user)
+{
+    return ui_setting(client, UI_OP_VOLT_SCALE, args, false);
+}
+
+static esp_err_t cmd_chan_scale_q(scpi_client_t *client, const char *args, void *user)
+{
+    return ui_setting(client, UI_OP_VOLT_SCALE, args, true);
+}
+
+static esp_err_t cmd_trig_level(scpi_client_t *client, const char *args, void *user)
+{
+    return ui_setting(client, UI_OP_TRIGGER_LEVEL, args, false);
+}
+
+static esp_err_t cmd_trig_level_q(scpi_client_t *client, const char *args, void *user)
+{
+    return ui_setting(client, UI_OP_TRIGGER_LEVEL, args, true);
+}
+
+static esp_err_t cmd_trig_slope(scpi_client_t *client, const char *args, void *user)
+{
+    int slope;
+    if (scpi_match_keyword(args, "POSitive")) {
+        slope = OSC_SCPI_SLOPE_POSITIVE;
+    } else if (scpi_match_keyword(args, "NEGative")) {
+        slope = OSC_SCPI_SLOPE_NEGATIVE;
+    } else if (scpi_match_keyword(args, "EITHer")) {
+        slope = OSC_SCPI_SLOPE_EITHER;
+    } else {
+        scpi_push_error(client, SCPI_ERROR_DATA_OUT_OF_RANGE, "Data out of range");
+        return ESP_ERR_INVALID_ARG;
+    }
+    esp_err_t ret = ui_call(UI_OP_TRIGGER_SLOPE, (float)slope, NULL);
+    if (ret != ESP_OK) {
+        scpi_push_error(client, SCPI_ERROR_SETTINGS_CONFLICT, "Settings conflict");
+    }
+    return ret;
+}
+
+static esp_err_t cmd_trig_slope_q(scpi_client_t *client, const char *args, void *user)
+{
+    static const char *const names[] = { "POS", "NEG", "EITH" };
+    float slope;
+    esp_err_t ret = ui_call(UI_OP_TRIGGER_SLOPE, NAN, &slope);
+    if (ret != ESP_OK) {
+        scpi_push_error(client, SCPI_ERROR_SETTINGS_CONFLICT, "Settings conflict");
+        return ret;
+    }
+    int index = (int)slope;
+    return scpi_reply(client, "%s", (index >= 0 && index <= OSC_SCPI_SLOPE_EITHER) ? names[index] : "POS");
+}
+
+/* Measurement queries: one handler per item of osc_core_get_measurements() */
+typedef enum { MEAS_FREQ = 0, MEAS_VMAX, MEAS_VMIN, MEAS_VPP, MEAS_VRMS } meas_item_t;
+
+static esp_err_t measure(scpi_client_t *client, meas_item_t item)
+{
+    float values[5];
+    esp_err_t ret = osc_core_get_measurements(g_core, &values[MEAS_FREQ], &values[MEAS_VMAX], &values[MEAS_VMIN],
+                                              &values[MEAS_VPP], &values[MEAS_VRMS]);
+    if (ret != ESP_OK) {
+        scpi_push_error(client, SCPI_ERROR_DATA_STALE, "Data corrupt or stale");
+        return scpi_reply(client, "%.1e", SCPI_NAN);
+    }
+    return scpi_reply(client, "%.6e", values[item]);
+}
+
+static esp_err_t cmd_meas_freq(scpi_client_t *client, const char *args, void *user) { return measure(client, MEAS_FREQ); }
+static esp_err_t cmd_meas_vmax(scpi_client_t *client, const char *args, void *user) { return measure(client, MEAS_VMAX); }
+static esp_err_t cmd_meas_vmin(scpi_client_t *client, const char *args, void *user) { return measure(client, MEAS_VMIN); }
+static esp_err_t cmd_meas_vpp(scpi_client_t *client, const char *args, void *user) { return measure(client, MEAS_VPP); }
+static esp_err_t cmd_meas_vrms(scpi_client_t *client, const char *args, void *user) { return measure(client, MEAS_VRMS); }
+
+static esp_err_t cmd_wav_format(scpi_client_t *client, const char *args, void *user)
+{
+    // The capture is float32: REAL is the only format sent without conversion
+    if (!scpi_match_keyword(args, "REAL")) {
+        scpi_push_error(client, SCPI_ERROR_DATA_OUT_OF_RANGE, "Data out of range");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t cmd_wav_format_q(scpi_client_t *client, const char *args, void *user)
+{
+    return scpi_reply(client, "REAL");
+}
+
+/**
+ * @brief Read the capture metadata (pin and release at once)
+ */
+static esp_err_t peek_waveform(scpi_client_t *client, osc_waveform_view_t *view)
+{
+    esp_err_t ret = osc_core_pin_waveform(g_core, view);
+    if (ret != ESP_OK) {
+        scpi_push_error(client, (ret == ESP_ERR_NOT_SUPPORTED) ? SCPI_ERROR_SETTINGS_CONFLICT : SCPI_ERROR_DATA_STALE,
+                        (ret == ESP_ERR_NOT_SUPPORTED) ? "Settings conflict" : "Data corrupt or stale");
+        return ret;
+    }
+    osc_core_unpin_waveform(g_core, view);
+    return ESP_OK;
+}
+
+static esp_err_t cmd_wav_points(scpi_client_t *client, const char *args, void *user)
+{
+    osc_waveform_view_t view;
+    esp_err_t ret = peek_waveform(client, &view);
+    if (ret != ESP_OK) return ret;
+    return scpi_reply(client, "%lu", (unsigned long)view.num_points);
+}
+
+static esp_err_t cmd_wav_xinc(scpi_client_t *client, const char *args, void *user)
+{
+    osc_waveform_view_t view;
+    esp_err_t ret = peek_waveform(client, &view);
+    if (ret != ESP_OK) return ret;
+    return scpi_reply(client, "%.6e", view.time_per_sample);
+}
+
+static esp_err_t cmd_wav_preamble(scpi_client_t *client, const char *args, void *user)
+{
+    osc_waveform_view_t view;
+    esp_err_t ret = peek_waveform(client, &view);
+    if (ret != ESP_OK) return ret;
+    // Time of sample i: xorigin + i * xincrement (0 at the trigger)
+    return scpi_reply(client, "REAL,%lu,%.6e,%.6e,%lu,%lu", (unsigned long)view.num_points, view.time_per_sample,
+                      -(double)view.trigger_index * view.time_per_sample, (unsigned long)view.trigger_index,
+                      (unsigned long)view.generation);
+}
+
+static void release_block(void *user)
+{
+    pinned_block_t *block = (pinned_block_t *)user;
+    osc_core_unpin_waveform(g_core, &block->view);
+    block->in_use = false;
+}
+
+static esp_err_t cmd_wav_data(scpi_client_t *client, const char *args, void *user)
+{
+    // One block per client at most, so a slot is always free
+    pinned_block_t *block = NULL;
+    for (int i = 0; i < SCPI_SERVER_MAX_CLIENTS; i++) {
+        if (!g_blocks[i].in_use) {
+            block = &g_blocks[i];
+            break;
+        }
+    }
+    if (block == NULL) return ESP_ERR_NO_MEM;
+
+    esp_err_t ret = osc_core_pin_waveform(g_core, &block->view);
+    if (ret != ESP_OK) {
+        scpi_push_error(client, (ret == ESP_ERR_NOT_SUPPORTED) ? SCPI_ERROR_SETTINGS_CONFLICT : SCPI_ERROR_DATA_STALE,
+                        (ret == ESP_ERR_NOT_SUPPORTED) ? "Settings conflict" : "Data corrupt or stale");
+        return ret;
+    }
+    block->in_use = true;
+
+    // Sent from the capture buffer as the socket drains; released when done
+    return scpi_reply_block(client, block->view.volts, block->view.num_points * sizeof(float),
+                            release_block, block);
+}
+
+static const scpi_command_t s_commands[] = {
+    { "*IDN?",                  cmd_idn },
+    { "*OPC?",                  cmd_opc },
+    { "*CLS",                   cmd_cls },
+    { ":SYSTem:ERRor?",         cmd_syst_err },
+    { ":SYSTem:ERRor:NEXT?",    cmd_syst_err },
+    { ":RUN",                   cmd_run },
+    { ":STOP",                  cmd_stop },
+    { ":SINGle",                cmd_single },
+    { ":TRIGger:STATus?",       cmd_trig_status },
+    { ":TIMebase:SCALe",        cmd_tim_scale },
+    { ":TIMebase:SCALe?",       cmd_tim_scale_q },
+    { ":CHANnel1:SCALe",        cmd_chan_scale },
+    { ":CHANnel1:SCALe?",       cmd_chan_scale_q },
+    { ":TRIGger:LEVel",         cmd_trig_level },
+    { ":TRIGger:LEVel?",        cmd_trig_level_q },
+    { ":TRIGger:SLOPe",         cmd_trig_slope },
+    { ":TRIGger:SLOPe?",        cmd_trig_slope_q },
+    { ":MEASure:FREQuency?",    cmd_meas_freq },
+    { ":MEASure:VMAX?",         cmd_meas_vmax },
+    { ":MEASure:VMIN?",         cmd_meas_vmin },
+    { ":MEASure:VPP?",          cmd_meas_vpp },
+    { ":MEASure:VRMS?",         cmd_meas_vrms },
+    { ":WAVeform:FORMat",       cmd_wav_format },
+    { ":WAVeform:FORMat?",      cmd_wav_format_q },
+    { ":WAVeform:POINts?",      cmd_wav_points },
+    { ":WAVeform:XINCrement?",  cmd_wav_xinc },
+    { ":WAVeform:PREamble?",    cmd_wav_preamble },
+    { ":WAVeform:DATA?",        cmd_wav_data },
+};
+
+/* ========================================================================
+ * Server task
+ * ======================================================================== */
+
+static void scpi_task(void *arg)
+{
+    scpi_server_config_t config = {
+        .port = g_port,
+        .commands = s_commands,
+        .num_commands = sizeof(s_commands) / sizeof(s_commands[0]),
+        .user = NULL,
+    };
+    scpi_server_t *server = scpi_server_create(&config);
+
+    while (g_running && server != NULL) {
+        if (scpi_server_poll(server, OSC_SCPI_POLL_MS) != ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(OSC_SCPI_POLL_MS));
+        }
+    }
+
+    // Closing the connections releases their pinned captures
+    scpi_server_destroy(server);
+    xSemaphoreGive(g_exited);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Start the server task
+ */
+esp_err_t osc_scpi_start(osc_core_ctx_t *core, uint16_t port)
+{
+    if (core == NULL) return ESP_ERR_INVALID_ARG;
+    if (g_task != NULL) return ESP_OK;
+
+    g_ui_queue = xQueueCreate(1, sizeof(ui_call_t));
+    g_ui_done = xSemaphoreCreateBinary();
+    g_exited = xSemaphoreCreateBinary();
+    if (g_ui_queue == NULL || g_ui_done == NULL || g_exited == NULL) {
+        osc_scpi_stop();
+        return ESP_ERR_NO_MEM;
+    }
+
+    g_core = core;
+    g_port = port;
+    memset(g_blocks, 0, sizeof(g_blocks));
+    g_ui_timer = lv_timer_create(ui_drain_timer_cb, UI_DRAIN_PERIOD_MS, NULL);
+
+    g_running = true;
+    if (xTaskCreate(scpi_task, "osc_scpi", OSC_SCPI_TASK_STACK, NULL, OSC_SCPI_TASK_PRIORITY, &g_task) != pdPASS) {
+        g_running = false;
+        osc_scpi_stop();
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Stop the server task
+ */
+void osc_scpi_stop(void)
+{
+    if (g_task != NULL) {
+        g_running = false;
+        xSemaphoreTake(g_exited, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(10));  // Let the task exit
+        g_task = NULL;
+        ESP_LOGI(TAG, "SCPI server stopped");
+    }
+    if (g_ui_timer != NULL) {
+        lv_timer_del(g_ui_timer);
+        g_ui_timer = NULL;
+    }
+    if (g_ui_queue != NULL) {
+        vQueueDelete(g_ui_queue);
+        g_ui_queue = NULL;
+    }
+    if (g_ui_done != NULL) {
+        vSemaphoreDelete(g_ui_done);
+        g_ui_done = NULL;
+    }
+    if (g_exited != NULL) {
+        vSemaphoreDelete(g_exited);
+        g_exited = NULL;
+    }
+    g_core = NULL;
+}
+
+/**
+ * @brief Register the UI operations
+ */
+void osc_scpi_set_ui(const osc_scpi_ui_t *ui)
+{
+    if (ui != NULL) {
+        g_ui = *ui;
+        g_ui_set = true;
+    } else {
+        memset(&g_ui, 0, sizeof(g_ui));
+        g_ui_set = false;
+    }
+}
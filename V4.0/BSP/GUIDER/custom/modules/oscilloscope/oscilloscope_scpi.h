@@ -0,0 +1,97 @@
+/**
+ * @file oscilloscope_scpi.h
+ * @brief Remote control of the oscilloscope over SCPI (TCP port 5025)
+ *
+ * Command set (short forms in capitals, see scpi_server.h):
+ *
+ *   *IDN?  *OPC?  *CLS  :SYSTem:ERRor?
+ *   :RUN  :STOP  :SINGle  :TRIGger:STATus?          RUN | STOP | WAIT
+ *   :TIMebase:SCALe <s/div>[?]                      nearest scale of the UI
+ *   :CHANnel1:SCALe <V/div>[?]
+ *   :TRIGger:LEVel <V>[?]  :TRIGger:SLOPe POSitive|NEGative|EITHer[?]
+ *   :MEASure:FREQuency? :VMAX? :VMIN? :VPP? :VRMS?  9.9E37 if not measurable
+ *   :WAVeform:FORMat REAL[?]  :WAVeform:POINts?  :WAVeform:XINCrement?
+ *   :WAVeform:PREamble?     REAL,<points>,<xincrement>,<xorigin>,<trigger index>,<generation>
+ *   :WAVeform:DATA?         #<n><length><little-endian float32 volts>
+ *
+ * :WAVeform:DATA? sends the displayed capture from the core's buffer in
+ * place (osc_core_pin_waveform): no copy is made, and the capture on screen
+ * is held until the transfer is complete.
+ *
+ * Settings belong to the UI: they run on the LVGL thread through the
+ * operations registered with osc_scpi_set_ui(), so the screen always shows
+ * what a remote client set.
+ */
+
+#ifndef OSCILLOSCOPE_SCPI_H
+#define OSCILLOSCOPE_SCPI_H
+
+#include "esp_err.h"
+#include "oscilloscope_core.h"
+#include "scpi_server.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OSC_SCPI_TASK_STACK     4096
+#define OSC_SCPI_TASK_PRIORITY  4
+#define OSC_SCPI_POLL_MS        100             // Longest poll() wait (stop latency)
+#define OSC_SCPI_UI_TIMEOUT_MS  1000            // Longest wait for a UI operation
+
+/* Run states of the run operation */
+#define OSC_SCPI_STOP           0
+#define OSC_SCPI_RUN            1
+#define OSC_SCPI_SINGLE         2               // Run, stop after the next capture
+
+/* Trigger slopes of the slope operation */
+#define OSC_SCPI_SLOPE_POSITIVE 0
+#define OSC_SCPI_SLOPE_NEGATIVE 1
+#define OSC_SCPI_SLOPE_EITHER   2
+
+/**
+ * @brief UI operation (LVGL thread)
+ *
+ * @param value New setting, NAN to only query
+ * @param result Output: setting in effect afterwards
+ * @return ESP_OK, ESP_ERR_INVALID_ARG if value is out of range
+ */
+typedef esp_err_t (*osc_scpi_ui_fn)(float value, float *result);
+
+/* UI operations (any may be NULL: the command then fails) */
+typedef struct {
+    osc_scpi_ui_fn time_scale;      // Seconds per division
+    osc_scpi_ui_fn volt_scale;      // Volts per division
+    osc_scpi_ui_fn trigger_level;   // Volts
+    osc_scpi_ui_fn trigger_slope;   // OSC_SCPI_SLOPE_*
+    osc_scpi_ui_fn run;             // OSC_SCPI_STOP / RUN / SINGLE
+} osc_scpi_ui_t;
+
+/**
+ * @brief Start the server task (call from the LVGL thread)
+ *
+ * @param core Core context served (must outlive osc_scpi_stop())
+ * @param port TCP port (0 = SCPI_SERVER_DEFAULT_PORT)
+ * @return ESP_OK on success (also when already started)
+ */
+esp_err_t osc_scpi_start(osc_core_ctx_t *core, uint16_t port);
+
+/**
+ * @brief Stop the server task, closing all connections (call from the LVGL thread)
+ */
+void osc_scpi_stop(void);
+
+/**
+ * @brief Register the UI operations (LVGL thread; NULL detaches)
+ *
+ * @param ui Operations (copied)
+ */
+void osc_scpi_set_ui(const osc_scpi_ui_t *ui);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_SCPI_H
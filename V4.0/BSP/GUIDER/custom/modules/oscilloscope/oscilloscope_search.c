@@ -0,0 +1,359 @@
+/**
+ * @file oscilloscope_search.c
+ * @brief Search-and-mark implementation
+ */
+
+#include "oscilloscope_search.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "OscSearch";
+
+/* Samples of a deep record converted per read */
+#define OSC_SEARCH_READ_SIZE    256
+
+/* Deep records are walked with the pyramid block geometry */
+#if OSC_DEEPMEM_FANOUT != OSC_PYRAMID_FANOUT
+#error "Deep memory and pyramid summaries must share one fanout"
+#endif
+
+/* Search context */
+struct osc_search_ctx_t {
+    osc_trigger_ctx_t *detector;
+
+    /* Sorted event positions (PSRAM) */
+    uint32_t *hits;
+    uint32_t count;
+    bool truncated;
+
+    osc_search_stats_t stats;
+    SemaphoreHandle_t mutex;
+};
+
+/* Record being searched: contiguous samples with an optional pyramid, or deep memory */
+typedef struct {
+    const float *data;
+    osc_pyramid_t *pyramid;
+    osc_deepmem_t *deep;
+    uint32_t num_points;
+} search_source_t;
+
+/**
+ * @brief Append one event position
+ *
+ * @return false once the index is full
+ */
+static bool add_hit(osc_search_ctx_t *ctx, uint32_t position)
+{
+    if (ctx->count >= OSC_SEARCH_MAX_HITS) {
+        ctx->truncated = true;
+        return false;
+    }
+    ctx->hits[ctx->count++] = position;
+    return true;
+}
+
+/**
+ * @brief Run the detector over raw samples [start, end)
+ */
+static bool scan_raw(osc_search_ctx_t *ctx, const search_source_t *src, uint32_t start, uint32_t end)
+{
+    ctx->stats.samples_read += end - start;
+
+    // Deep records are read through a small buffer, one piece at a time
+    float buffer[OSC_SEARCH_READ_SIZE];
+    const float *data = src->data;
+    uint32_t base = 0;
+
+    uint32_t pos = start;
+    while (pos < end) {
+        uint32_t limit = end;
+        if (src->deep != NULL) {
+            limit = (end - pos > OSC_SEARCH_READ_SIZE) ? pos + OSC_SEARCH_READ_SIZE : end;
+            if (osc_deepmem_read(src->deep, pos, limit - pos, buffer) != ESP_OK) return true;
+            data = buffer;
+            base = pos;
+        }
+        while (pos < limit) {
+            int32_t offset = osc_trigger_process(ctx->detector, data + (pos - base), limit - pos);
+            if (offset < 0) {
+                pos = limit;
+                break;
+            }
+            if (!add_hit(ctx, pos + (uint32_t)offset)) return false;
+            pos += (uint32_t)offset + 1;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Summary levels of the searched record
+ */
+static uint8_t source_num_levels(const search_source_t *src)
+{
+    return src->deep ? osc_deepmem_get_num_levels(src->deep) : osc_pyramid_get_num_levels(src->pyramid);
+}
+
+/**
+ * @brief Blocks of one summary level of the searched record
+ */
+static uint32_t source_num_blocks(const search_source_t *src, uint8_t level)
+{
+    return src->deep ? osc_deepmem_get_num_blocks(src->deep, level) :
+                       osc_pyramid_get_num_blocks(src->pyramid, level);
+}
+
+/**
+ * @brief Scan one summary block, skipping it whole if it cannot hold an event
+ */
+static bool scan_block(osc_search_ctx_t *ctx, const search_source_t *src, uint8_t level, uint32_t block)
+{
+    uint32_t size = osc_pyramid_get_block_size(level);
+    uint32_t start = block * size;
+    uint32_t end = (src->num_points - start > size) ? start + size : src->num_points;
+
+    float mn, mx;
+    if (src->deep != NULL) {
+        osc_deepmem_get_block(src->deep, level, block, &mn, &mx);
+    } else {
+        osc_pyramid_get_block(src->pyramid, level, block, &mn, &mx);
+    }
+    if (osc_trigger_is_quiet(ctx->detector, mn, mx)) {
+        ctx->stats.samples_skipped += end - start;
+        int32_t offset = osc_trigger_advance(ctx->detector, end - start);
+        return (offset < 0) || add_hit(ctx, start + (uint32_t)offset);
+    }
+
+    if (level == 0) return scan_raw(ctx, src, start, end);
+
+    uint32_t first = block * OSC_PYRAMID_FANOUT;
+    uint32_t last = first + OSC_PYRAMID_FANOUT;
+    uint32_t below = source_num_blocks(src, level - 1);
+    if (last > below) last = below;
+    for (uint32_t b = first; b < last; b++) {
+        if (!scan_block(ctx, src, level - 1, b)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Rebuild the event index from a record
+ */
+static esp_err_t run_search(osc_search_ctx_t *ctx, const search_source_t *src,
+                            const osc_trigger_config_t *criteria, float sample_rate_hz)
+{
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+
+    esp_err_t ret = osc_trigger_configure(ctx->detector, criteria, sample_rate_hz);
+    if (ret != ESP_OK) {
+        xSemaphoreGive(ctx->mutex);
+        return ret;
+    }
+
+    ctx->count = 0;
+    ctx->truncated = false;
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+    ctx->stats.num_points = src->num_points;
+
+    uint8_t levels = source_num_levels(src);
+    if (levels == 0) {
+        scan_raw(ctx, src, 0, src->num_points);
+    } else {
+        uint8_t top = levels - 1;
+        uint32_t blocks = source_num_blocks(src, top);
+        for (uint32_t b = 0; b < blocks; b++) {
+            if (!scan_block(ctx, src, top, b)) break;
+        }
+    }
+
+    ESP_LOGI(TAG, "%s search: %lu events%s, read %lu of %lu samples",
+             osc_trigger_get_type_str(criteria->type), ctx->count, ctx->truncated ? " (truncated)" : "",
+             ctx->stats.samples_read, src->num_points);
+
+    xSemaphoreGive(ctx->mutex);
+    return ESP_OK;
+}
+
+/**
+ * @brief Initialize search context
+ */
+osc_search_ctx_t *osc_search_init(void)
+{
+    osc_search_ctx_t *ctx = heap_caps_malloc(sizeof(osc_search_ctx_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(osc_search_ctx_t));
+
+    ctx->mutex = xSemaphoreCreateMutex();
+    ctx->detector = osc_trigger_init();
+    ctx->hits = heap_caps_malloc(OSC_SEARCH_MAX_HITS * sizeof(uint32_t), MALLOC_CAP_SPIRAM);
+    if (ctx->mutex == NULL || ctx->detector == NULL || ctx->hits == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate search resources");
+        osc_search_deinit(ctx);
+        return NULL;
+    }
+
+    ESP_LOGI(TAG, "Search initialized (%d events)", OSC_SEARCH_MAX_HITS);
+    return ctx;
+}
+
+/**
+ * @brief Deinitialize search context
+ */
+void osc_search_deinit(osc_search_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    if (ctx->mutex) vSemaphoreDelete(ctx->mutex);
+    osc_trigger_deinit(ctx->detector);
+    heap_caps_free(ctx->hits);
+    free(ctx);
+}
+
+/**
+ * @brief Scan a record and rebuild the event index
+ */
+esp_err_t osc_search_run(osc_search_ctx_t *ctx, const float *data, uint32_t num_points,
+                         osc_pyramid_t *pyramid, const osc_trigger_config_t *criteria,
+                         float sample_rate_hz)
+{
+    if (ctx == NULL || criteria == NULL || (data == NULL && num_points > 0)) return ESP_ERR_INVALID_ARG;
+
+    search_source_t src = {
+        .data = data,
+        .pyramid = pyramid,
+        .num_points = num_points,
+    };
+    return run_search(ctx, &src, criteria, sample_rate_hz);
+}
+
+/**
+ * @brief Scan a deep-memory record and rebuild the event index
+ */
+esp_err_t osc_search_run_deep(osc_search_ctx_t *ctx, osc_deepmem_t *deep,
+                              const osc_trigger_config_t *criteria)
+{
+    if (ctx == NULL || deep == NULL || criteria == NULL) return ESP_ERR_INVALID_ARG;
+    if (!osc_deepmem_is_finished(deep)) return ESP_ERR_INVALID_STATE;
+
+    search_source_t src = {
+        .deep = deep,
+        .num_points = osc_deepmem_get_length(deep),
+    };
+    return run_search(ctx, &src, criteria, 1.0f / osc_deepmem_get_time_per_sample(deep));
+}
+
+/**
+ * @brief Drop the event index
+ */
+void osc_search_clear(osc_search_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    ctx->count = 0;
+    ctx->truncated = false;
+    xSemaphoreGive(ctx->mutex);
+}
+
+/**
+ * @brief Get number of indexed events
+ */
+uint32_t osc_search_get_count(osc_search_ctx_t *ctx)
+{
+    if (ctx == NULL) return 0;
+    return ctx->count;
+}
+
+/**
+ * @brief Check if events were dropped
+ */
+bool osc_search_is_truncated(osc_search_ctx_t *ctx)
+{
+    if (ctx == NULL) return false;
+    return ctx->truncated;
+}
+
+/**
+ * @brief Get position of one event
+ */
+esp_err_t osc_search_get_hit(osc_search_ctx_t *ctx, uint32_t index, uint32_t *position)
+{
+    if (ctx == NULL || position == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+    if (index < ctx->count) {
+        *position = ctx->hits[index];
+        ret = ESP_OK;
+    }
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Index of the first event after position (count if none)
+ */
+static uint32_t upper_bound(osc_search_ctx_t *ctx, uint32_t position)
+{
+    uint32_t lo = 0, hi = ctx->count;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (ctx->hits[mid] <= position) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief Find the first event after a position
+ */
+esp_err_t osc_search_find_next(osc_search_ctx_t *ctx, uint32_t position, uint32_t *index)
+{
+    if (ctx == NULL || index == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    uint32_t i = upper_bound(ctx, position);
+    esp_err_t ret = (i < ctx->count) ? ESP_OK : ESP_ERR_NOT_FOUND;
+    if (ret == ESP_OK) *index = i;
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Find the last event before a position
+ */
+esp_err_t osc_search_find_prev(osc_search_ctx_t *ctx, uint32_t position, uint32_t *index)
+{
+    if (ctx == NULL || index == NULL) return ESP_ERR_INVALID_ARG;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    // First event at or after position, the one before it is the answer
+    uint32_t i = (position > 0) ? upper_bound(ctx, position - 1) : 0;
+    esp_err_t ret = (i > 0) ? ESP_OK : ESP_ERR_NOT_FOUND;
+    if (ret == ESP_OK) *index = i - 1;
+    xSemaphoreGive(ctx->mutex);
+    return ret;
+}
+
+/**
+ * @brief Get statistics of the last run
+ */
+void osc_search_get_stats(osc_search_ctx_t *ctx, osc_search_stats_t *stats)
+{
+    if (ctx == NULL || stats == NULL) return;
+
+    xSemaphoreTake(ctx->mutex, portMAX_DELAY);
+    *stats = ctx->stats;
+    xSemaphoreGive(ctx->mutex);
+}
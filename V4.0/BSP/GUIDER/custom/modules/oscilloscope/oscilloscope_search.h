@@ -0,0 +1,149 @@
+/**
+ * @file oscilloscope_search.h
+ * @brief Search-and-mark over a frozen capture
+ *
+ * Scans a stopped record with the same criteria as the hardware-path trigger
+ * (osc_trigger_config_t) and keeps a sorted index of every event position.
+ * Regions whose min/max pyramid summary cannot cross a threshold are skipped
+ * without reading the samples, so sparse events in deep records are cheap
+ * to find; deep-memory records are walked through their own summaries the
+ * same way. The index answers next/previous queries by binary search.
+ */
+
+#ifndef OSCILLOSCOPE_SEARCH_H
+#define OSCILLOSCOPE_SEARCH_H
+
+#include "esp_err.h"
+#include "oscilloscope_trigger.h"
+#include "oscilloscope_pyramid.h"
+#include "oscilloscope_deepmem.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Index capacity (positions beyond it are dropped and the result flagged truncated) */
+#define OSC_SEARCH_MAX_HITS     4096
+
+/* Search context */
+typedef struct osc_search_ctx_t osc_search_ctx_t;
+
+/* Search statistics of the last run */
+typedef struct {
+    uint32_t num_points;        // Record length
+    uint32_t samples_read;      // Samples fed to the detector
+    uint32_t samples_skipped;   // Samples skipped through the pyramid
+} osc_search_stats_t;
+
+/**
+ * @brief Initialize search context
+ *
+ * @return Search context or NULL on error
+ */
+osc_search_ctx_t *osc_search_init(void);
+
+/**
+ * @brief Deinitialize search context
+ *
+ * @param ctx Search context
+ */
+void osc_search_deinit(osc_search_ctx_t *ctx);
+
+/**
+ * @brief Scan a record and rebuild the event index
+ *
+ * @param ctx Search context
+ * @param data Record (volts)
+ * @param num_points Number of samples
+ * @param pyramid Pyramid built over data, or NULL to read every sample
+ * @param criteria Event criteria (the enabled flag is ignored)
+ * @param sample_rate_hz Sampling rate of data
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad criteria
+ */
+esp_err_t osc_search_run(osc_search_ctx_t *ctx, const float *data, uint32_t num_points,
+                         osc_pyramid_t *pyramid, const osc_trigger_config_t *criteria,
+                         float sample_rate_hz);
+
+/**
+ * @brief Scan a deep-memory record and rebuild the event index
+ *
+ * Quiet regions are skipped through the record's summaries; only blocks
+ * that may hold an event are read back.
+ *
+ * @param ctx Search context
+ * @param deep Deep memory with a finished record
+ * @param criteria Event criteria (the enabled flag is ignored)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad criteria,
+ *         ESP_ERR_INVALID_STATE if the record is still being filled
+ */
+esp_err_t osc_search_run_deep(osc_search_ctx_t *ctx, osc_deepmem_t *deep,
+                              const osc_trigger_config_t *criteria);
+
+/**
+ * @brief Drop the event index
+ *
+ * @param ctx Search context
+ */
+void osc_search_clear(osc_search_ctx_t *ctx);
+
+/**
+ * @brief Get number of indexed events
+ *
+ * @param ctx Search context
+ * @return Number of events (0 if no search ran)
+ */
+uint32_t osc_search_get_count(osc_search_ctx_t *ctx);
+
+/**
+ * @brief Check if the last run found more events than the index holds
+ *
+ * @param ctx Search context
+ * @return true if events were dropped
+ */
+bool osc_search_is_truncated(osc_search_ctx_t *ctx);
+
+/**
+ * @brief Get position of one event
+ *
+ * @param ctx Search context
+ * @param index Event index (0 = earliest)
+ * @param position Output: sample index in the record
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if index is out of range
+ */
+esp_err_t osc_search_get_hit(osc_search_ctx_t *ctx, uint32_t index, uint32_t *position);
+
+/**
+ * @brief Find the first event after a position
+ *
+ * @param ctx Search context
+ * @param position Sample index
+ * @param index Output: event index
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no event follows
+ */
+esp_err_t osc_search_find_next(osc_search_ctx_t *ctx, uint32_t position, uint32_t *index);
+
+/**
+ * @brief Find the last event before a position
+ *
+ * @param ctx Search context
+ * @param position Sample index
+ * @param index Output: event index
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no event precedes
+ */
+esp_err_t osc_search_find_prev(osc_search_ctx_t *ctx, uint32_t position, uint32_t *index);
+
+/**
+ * @brief Get statistics of the last run
+ *
+ * @param ctx Search context
+ * @param stats Output: statistics
+ */
+void osc_search_get_stats(osc_search_ctx_t *ctx, osc_search_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_SEARCH_H
@@ -0,0 +1,348 @@
+/**
+ * @file oscilloscope_trigger.c
+ * @brief Streaming trigger detector implementation
+ */
+
+#include "oscilloscope_trigger.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+static const char *TAG = "OscTrigger";
+
+/* Signal zones relative to the thresholds */
+#define ZONE_LOW    0
+#define ZONE_MID    1
+#define ZONE_HIGH   2
+
+/* Trigger type names */
+static const char *type_strings[] = {
+    [OSC_TRIGGER_EDGE]        = "EDGE",
+    [OSC_TRIGGER_PULSE_WIDTH] = "PULSE",
+    [OSC_TRIGGER_RUNT]        = "RUNT",
+    [OSC_TRIGGER_SLOPE]       = "SLOPE",
+    [OSC_TRIGGER_WINDOW]      = "WINDOW",
+    [OSC_TRIGGER_TIMEOUT]     = "TIMEOUT",
+};
+
+/* Trigger detector context */
+struct osc_trigger_ctx_t {
+    osc_trigger_type_t type;
+    osc_trigger_when_t when;
+
+    /* Thresholds in the mirrored domain (rising polarity) */
+    float sign;                     // -1 mirrors falling polarity onto rising
+    float low_up, low_down;         // Low threshold +/- half hysteresis
+    float high_up, high_down;       // High threshold +/- half hysteresis
+
+    /* Times in samples */
+    uint32_t min_samples;
+    uint32_t max_samples;
+
+    /* State */
+    bool primed;                    // Zone initialized from the first sample
+    uint8_t zone;
+    uint8_t phase;                  // Type-specific: 0 = idle, 1 = event in progress, 2 = disqualified/fired
+    uint32_t elapsed;               // Samples since the event started
+};
+
+/**
+ * @brief Check a duration against the time qualifier
+ */
+static inline bool qualifies(const osc_trigger_ctx_t *ctx, uint32_t samples)
+{
+    switch (ctx->when) {
+    case OSC_TRIGGER_WHEN_LESS:
+        return samples < ctx->max_samples;
+    case OSC_TRIGGER_WHEN_GREATER:
+        return samples > ctx->min_samples;
+    default:
+        return samples >= ctx->min_samples && samples <= ctx->max_samples;
+    }
+}
+
+/**
+ * @brief Zone of a sample, with hysteresis around both thresholds
+ */
+static inline uint8_t next_zone(const osc_trigger_ctx_t *ctx, uint8_t zone, float v)
+{
+    if (v > ctx->high_up) return ZONE_HIGH;
+    if (v < ctx->low_down) return ZONE_LOW;
+    if (zone == ZONE_HIGH && v < ctx->high_down) return ZONE_MID;
+    if (zone == ZONE_LOW && v > ctx->low_up) return ZONE_MID;
+    return zone;
+}
+
+/**
+ * @brief Handle a zone change
+ *
+ * @return true if the sample that caused it triggers
+ */
+static bool on_transition(osc_trigger_ctx_t *ctx, uint8_t from, uint8_t to)
+{
+    switch (ctx->type) {
+    case OSC_TRIGGER_EDGE:
+        return from == ZONE_LOW && to == ZONE_HIGH;
+
+    case OSC_TRIGGER_PULSE_WIDTH:
+        if (to == ZONE_HIGH) {
+            ctx->phase = 1;
+            ctx->elapsed = 0;
+        } else if (to == ZONE_LOW && ctx->phase == 1) {
+            ctx->phase = 0;
+            return qualifies(ctx, ctx->elapsed);
+        }
+        return false;
+
+    case OSC_TRIGGER_RUNT:
+        if (from == ZONE_LOW) {
+            ctx->phase = (to == ZONE_HIGH) ? 2 : 1;
+        } else if (to == ZONE_HIGH) {
+            ctx->phase = 2;     // Reached the high level: a full pulse
+        } else if (to == ZONE_LOW) {
+            bool runt = (ctx->phase == 1);
+            ctx->phase = 0;
+            return runt;
+        }
+        return false;
+
+    case OSC_TRIGGER_SLOPE:
+        if (from == ZONE_LOW && to == ZONE_MID) {
+            ctx->phase = 1;
+            ctx->elapsed = 0;
+        } else if (to == ZONE_HIGH) {
+            // Only a LOW -> MID -> HIGH edge has a time; a return from a dip below
+            // the high level, or a jump between two samples, is not a timed edge
+            bool timed = (from == ZONE_MID && ctx->phase == 1);
+            ctx->phase = 0;
+            return timed && qualifies(ctx, ctx->elapsed);
+        } else {
+            ctx->phase = 0;     // Fell back below the low threshold
+        }
+        return false;
+
+    case OSC_TRIGGER_WINDOW:
+        return from == ZONE_MID;
+
+    case OSC_TRIGGER_TIMEOUT:
+        // Any crossing restarts the timer and re-arms
+        ctx->phase = 0;
+        ctx->elapsed = 0;
+        return false;
+
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Initialize trigger detector
+ */
+osc_trigger_ctx_t *osc_trigger_init(void)
+{
+    osc_trigger_ctx_t *ctx = heap_caps_malloc(sizeof(osc_trigger_ctx_t), MALLOC_CAP_8BIT);
+    if (ctx == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate context");
+        return NULL;
+    }
+    memset(ctx, 0, sizeof(osc_trigger_ctx_t));
+    ctx->sign = 1.0f;
+    return ctx;
+}
+
+/**
+ * @brief Deinitialize trigger detector
+ */
+void osc_trigger_deinit(osc_trigger_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+    free(ctx);
+}
+
+/**
+ * @brief Validate a trigger configuration
+ */
+esp_err_t osc_trigger_validate(const osc_trigger_config_t *config)
+{
+    if (config == NULL || config->type >= OSC_TRIGGER_TYPE_MAX) return ESP_ERR_INVALID_ARG;
+    if (config->pre_trigger_ratio < 0.0f || config->pre_trigger_ratio > 1.0f) return ESP_ERR_INVALID_ARG;
+    if (config->hysteresis_voltage < 0.0f) return ESP_ERR_INVALID_ARG;
+
+    switch (config->type) {
+    case OSC_TRIGGER_RUNT:
+    case OSC_TRIGGER_WINDOW:
+        if (config->level_low_voltage >= config->level_voltage) return ESP_ERR_INVALID_ARG;
+        break;
+    case OSC_TRIGGER_SLOPE:
+        if (config->level_low_voltage >= config->level_voltage) return ESP_ERR_INVALID_ARG;
+        // fall through - slope takes a time qualifier too
+    case OSC_TRIGGER_PULSE_WIDTH:
+        if (config->when == OSC_TRIGGER_WHEN_LESS && config->time_max <= 0.0f) return ESP_ERR_INVALID_ARG;
+        if (config->when == OSC_TRIGGER_WHEN_GREATER && config->time_min <= 0.0f) return ESP_ERR_INVALID_ARG;
+        if (config->when == OSC_TRIGGER_WHEN_WITHIN &&
+            (config->time_min < 0.0f || config->time_max <= config->time_min)) return ESP_ERR_INVALID_ARG;
+        if (config->when > OSC_TRIGGER_WHEN_WITHIN) return ESP_ERR_INVALID_ARG;
+        break;
+    case OSC_TRIGGER_TIMEOUT:
+        if (config->time_min <= 0.0f) return ESP_ERR_INVALID_ARG;
+        break;
+    default:
+        break;
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Configure detector
+ */
+esp_err_t osc_trigger_configure(osc_trigger_ctx_t *ctx, const osc_trigger_config_t *config, float sample_rate_hz)
+{
+    if (ctx == NULL || sample_rate_hz <= 0.0f) return ESP_ERR_INVALID_ARG;
+    esp_err_t ret = osc_trigger_validate(config);
+    if (ret != ESP_OK) return ret;
+
+    ctx->type = config->type;
+    ctx->when = config->when;
+
+    // Single-threshold types use level_voltage for both thresholds
+    float low = config->level_voltage;
+    float high = config->level_voltage;
+    if (config->type == OSC_TRIGGER_RUNT || config->type == OSC_TRIGGER_SLOPE ||
+        config->type == OSC_TRIGGER_WINDOW) {
+        low = config->level_low_voltage;
+    }
+
+    // Falling polarity: mirror samples and thresholds (a window is symmetric)
+    ctx->sign = 1.0f;
+    if (!config->rising_edge && config->type != OSC_TRIGGER_WINDOW) {
+        float mirrored_low = -high;
+        high = -low;
+        low = mirrored_low;
+        ctx->sign = -1.0f;
+    }
+
+    float half_hyst = 0.5f * ((config->hysteresis_voltage > 0.0f) ?
+                              config->hysteresis_voltage : OSC_TRIGGER_DEFAULT_HYSTERESIS);
+    ctx->low_up = low + half_hyst;
+    ctx->low_down = low - half_hyst;
+    ctx->high_up = high + half_hyst;
+    ctx->high_down = high - half_hyst;
+
+    ctx->min_samples = (uint32_t)(config->time_min * sample_rate_hz + 0.5f);
+    ctx->max_samples = (uint32_t)(config->time_max * sample_rate_hz + 0.5f);
+
+    osc_trigger_reset(ctx);
+
+    ESP_LOGI(TAG, "Trigger: %s %s, %.3f/%.3fV, %lu..%lu samples", type_strings[ctx->type],
+             config->rising_edge ? "+" : "-", config->level_low_voltage, config->level_voltage,
+             ctx->min_samples, ctx->max_samples);
+    return ESP_OK;
+}
+
+/**
+ * @brief Forget the signal history
+ */
+void osc_trigger_reset(osc_trigger_ctx_t *ctx)
+{
+    if (ctx == NULL) return;
+    ctx->primed = false;
+    ctx->zone = ZONE_LOW;
+    ctx->phase = 0;
+    ctx->elapsed = 0;
+}
+
+/**
+ * @brief Run the detector over one block
+ */
+int32_t osc_trigger_process(osc_trigger_ctx_t *ctx, const float *data, uint32_t len)
+{
+    if (ctx == NULL || data == NULL || len == 0) return -1;
+
+    uint32_t i = 0;
+    if (!ctx->primed) {
+        // Start from the zone the signal is in, so the first sample never triggers
+        float v = ctx->sign * data[0];
+        ctx->zone = (v > ctx->high_down) ? ZONE_HIGH : (v < ctx->low_up) ? ZONE_LOW : ZONE_MID;
+        ctx->primed = true;
+        i = 1;
+    }
+
+    const float sign = ctx->sign;
+    const bool timeout = (ctx->type == OSC_TRIGGER_TIMEOUT);
+    uint8_t zone = ctx->zone;
+
+    for (; i < len; i++) {
+        ctx->elapsed += (ctx->elapsed != UINT32_MAX);
+
+        uint8_t z = next_zone(ctx, zone, sign * data[i]);
+        if (z != zone) {
+            uint8_t from = zone;
+            zone = z;
+            if (on_transition(ctx, from, z)) {
+                ctx->zone = zone;
+                return (int32_t)i;
+            }
+        } else if (timeout && ctx->phase == 0 && ctx->elapsed >= ctx->min_samples) {
+            // Fire once per quiet period
+            ctx->phase = 2;
+            ctx->zone = zone;
+            return (int32_t)i;
+        }
+    }
+
+    ctx->zone = zone;
+    return -1;
+}
+
+/**
+ * @brief Check if a span cannot change the zone
+ */
+bool osc_trigger_is_quiet(osc_trigger_ctx_t *ctx, float min, float max)
+{
+    if (ctx == NULL || !ctx->primed) return false;
+
+    // Mirror the span like the samples
+    float lo = (ctx->sign > 0.0f) ? min : -max;
+    float hi = (ctx->sign > 0.0f) ? max : -min;
+
+    switch (ctx->zone) {
+    case ZONE_LOW:
+        return hi <= ctx->low_up && hi <= ctx->high_up;
+    case ZONE_MID:
+        return lo >= ctx->low_down && hi <= ctx->high_up;
+    default:
+        return lo >= ctx->low_down && lo >= ctx->high_down;
+    }
+}
+
+/**
+ * @brief Skip a quiet span
+ */
+int32_t osc_trigger_advance(osc_trigger_ctx_t *ctx, uint32_t len)
+{
+    if (ctx == NULL || len == 0) return -1;
+
+    uint32_t before = ctx->elapsed;
+    ctx->elapsed = (UINT32_MAX - before < len) ? UINT32_MAX : before + len;
+
+    // Same rule as the per-sample path: fire on the sample where elapsed reaches the timeout
+    if (ctx->type == OSC_TRIGGER_TIMEOUT && ctx->phase == 0 && ctx->elapsed >= ctx->min_samples) {
+        uint32_t offset = (ctx->min_samples > before) ? ctx->min_samples - before - 1 : 0;
+        ctx->phase = 2;
+        return (int32_t)offset;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Get trigger type name
+ */
+const char *osc_trigger_get_type_str(osc_trigger_type_t type)
+{
+    if (type >= OSC_TRIGGER_TYPE_MAX) return "???";
+    return type_strings[type];
+}
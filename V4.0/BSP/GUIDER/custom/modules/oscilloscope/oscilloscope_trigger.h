@@ -0,0 +1,159 @@
+/**
+ * @file oscilloscope_trigger.h
+ * @brief Streaming trigger detector for the oscilloscope acquisition path
+ *
+ * Trigger types:
+ * - Edge: level crossing in the selected direction
+ * - Pulse width: pulse shorter than, longer than or within a time range
+ * - Runt: pulse crosses the low threshold but not the high one
+ * - Slope: transition time between the low and high thresholds
+ * - Window: signal leaves the band between the low and high thresholds
+ * - Timeout: no edge for a given time
+ *
+ * Every type runs on the same three-zone (below low / between / above high)
+ * state machine with hysteresis, updated once per sample, so one pass over
+ * each acquisition block is enough at the maximum sample rate. Falling
+ * polarity is handled by mirroring the samples, not by separate code paths.
+ */
+
+#ifndef OSCILLOSCOPE_TRIGGER_H
+#define OSCILLOSCOPE_TRIGGER_H
+
+#include "esp_err.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default hysteresis when none is configured */
+#define OSC_TRIGGER_DEFAULT_HYSTERESIS  0.02f   // Volts
+
+/* Trigger types */
+typedef enum {
+    OSC_TRIGGER_EDGE = 0,       // level_voltage crossing
+    OSC_TRIGGER_PULSE_WIDTH,    // Pulse width (level_voltage) compared with time_min/time_max
+    OSC_TRIGGER_RUNT,           // Crosses level_low_voltage but not level_voltage
+    OSC_TRIGGER_SLOPE,          // Time from level_low_voltage to level_voltage compared with time_min/time_max
+    OSC_TRIGGER_WINDOW,         // Leaves [level_low_voltage, level_voltage]
+    OSC_TRIGGER_TIMEOUT,        // No level_voltage crossing for time_min
+    OSC_TRIGGER_TYPE_MAX
+} osc_trigger_type_t;
+
+/* Time qualifier for pulse width and slope */
+typedef enum {
+    OSC_TRIGGER_WHEN_LESS = 0,  // Shorter than time_max
+    OSC_TRIGGER_WHEN_GREATER,   // Longer than time_min
+    OSC_TRIGGER_WHEN_WITHIN,    // Between time_min and time_max
+} osc_trigger_when_t;
+
+/* Trigger configuration */
+typedef struct {
+    bool enabled;                 // Trigger enabled
+    float level_voltage;          // Trigger level in volts (high threshold for runt/slope/window)
+    bool rising_edge;             // true = rising edge, false = falling edge (positive/negative pulse, runt, slope)
+    float pre_trigger_ratio;      // Pre-trigger ratio (0.0-1.0, typically 0.5)
+    osc_trigger_type_t type;      // Trigger type (zero = edge)
+    float level_low_voltage;      // Low threshold for runt/slope/window
+    float hysteresis_voltage;     // Noise rejection band (0 = OSC_TRIGGER_DEFAULT_HYSTERESIS)
+    osc_trigger_when_t when;      // Time qualifier for pulse width and slope
+    float time_min;               // Seconds (pulse width/slope lower bound, timeout)
+    float time_max;               // Seconds (pulse width/slope upper bound)
+} osc_trigger_config_t;
+
+/* Trigger detector context */
+typedef struct osc_trigger_ctx_t osc_trigger_ctx_t;
+
+/**
+ * @brief Initialize trigger detector (edge trigger, disarmed)
+ *
+ * @return Trigger context or NULL on error
+ */
+osc_trigger_ctx_t *osc_trigger_init(void);
+
+/**
+ * @brief Deinitialize trigger detector
+ *
+ * @param ctx Trigger context
+ */
+void osc_trigger_deinit(osc_trigger_ctx_t *ctx);
+
+/**
+ * @brief Configure detector and convert times to sample counts
+ *
+ * Resets detector state.
+ *
+ * @param ctx Trigger context
+ * @param config Trigger configuration
+ * @param sample_rate_hz Sampling rate of the samples fed to osc_trigger_process()
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad thresholds or times
+ */
+esp_err_t osc_trigger_configure(osc_trigger_ctx_t *ctx, const osc_trigger_config_t *config, float sample_rate_hz);
+
+/**
+ * @brief Forget the signal history (e.g. after acquisition restarts)
+ *
+ * @param ctx Trigger context
+ */
+void osc_trigger_reset(osc_trigger_ctx_t *ctx);
+
+/**
+ * @brief Run the detector over one block of samples
+ *
+ * Detector state carries over between blocks. Processing stops at the
+ * first trigger; feed the rest of the block again to look for the next one.
+ *
+ * @param ctx Trigger context
+ * @param data Samples (volts)
+ * @param len Number of samples
+ * @return Index of the triggering sample in data, or -1 if none
+ */
+int32_t osc_trigger_process(osc_trigger_ctx_t *ctx, const float *data, uint32_t len);
+
+/**
+ * @brief Check if a span of samples can be skipped without changing the detector state
+ *
+ * True if every value in [min, max] keeps the detector in its current zone,
+ * i.e. the span cannot contain an edge. Use osc_trigger_advance() to skip it.
+ *
+ * @param ctx Trigger context
+ * @param min Minimum of the span
+ * @param max Maximum of the span
+ * @return true if the span holds no zone change
+ */
+bool osc_trigger_is_quiet(osc_trigger_ctx_t *ctx, float min, float max);
+
+/**
+ * @brief Skip a span that osc_trigger_is_quiet() accepted
+ *
+ * Equivalent to osc_trigger_process() over the span, without reading it.
+ * Only a timeout can fire inside such a span.
+ *
+ * @param ctx Trigger context
+ * @param len Number of samples in the span
+ * @return Offset of the triggering sample in the span, or -1 if none
+ */
+int32_t osc_trigger_advance(osc_trigger_ctx_t *ctx, uint32_t len);
+
+/**
+ * @brief Validate a trigger configuration
+ *
+ * @param config Trigger configuration
+ * @return ESP_OK if usable, ESP_ERR_INVALID_ARG otherwise
+ */
+esp_err_t osc_trigger_validate(const osc_trigger_config_t *config);
+
+/**
+ * @brief Get trigger type name for logs and labels
+ *
+ * @param type Trigger type
+ * @return Short name (e.g. "RUNT")
+ */
+const char *osc_trigger_get_type_str(osc_trigger_type_t type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_TRIGGER_H
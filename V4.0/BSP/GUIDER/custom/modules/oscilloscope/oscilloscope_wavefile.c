@@ -0,0 +1,341 @@
+/**
+ * @file oscilloscope_wavefile.c
+ * @brief Full-depth binary waveform files implementation
+ */
+
+#include "oscilloscope_wavefile.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+static const char *TAG = "OscWavefile";
+
+#define OSC_WAVEFILE_CSV_ROWS       1024    // Samples read from the binary at a time
+#define OSC_WAVEFILE_CSV_ROW_MAX    48      // "index,time,voltage\n" upper bound
+
+_Static_assert(sizeof(osc_wavefile_header_t) <= OSC_WAVEFILE_DATA_OFFSET, "header exceeds the header block");
+
+/**
+ * @brief Replace the extension of path (after the last '/') with ext
+ */
+static void replace_extension(const char *path, const char *ext, char *out, size_t size)
+{
+    snprintf(out, size, "%s", path);
+    char *dot = strrchr(out, '.');
+    char *slash = strrchr(out, '/');
+    if (dot != NULL && (slash == NULL || dot > slash)) *dot = '\0';
+    size_t len = strlen(out);
+    snprintf(out + len, size - len, "%s", ext);
+}
+
+/**
+ * @brief Write the JSON sidecar
+ */
+static esp_err_t write_sidecar(const char *bin_path, const osc_wavefile_header_t *h)
+{
+    char path[256];
+    replace_extension(bin_path, ".json", path, sizeof(path));
+
+    const char *name = strrchr(bin_path, '/');
+    name = (name != NULL) ? name + 1 : bin_path;
+
+    FILE *f = fopen(path, "w");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Failed to create %s: %s", path, strerror(errno));
+        return ESP_FAIL;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"format\": \"osw\",\n");
+    fprintf(f, "  \"version\": %u,\n", h->version);
+    fprintf(f, "  \"data_file\": \"%s\",\n", name);
+    fprintf(f, "  \"data_offset\": %u,\n", h->data_offset);
+    fprintf(f, "  \"dtype\": \"<i2\",\n");
+    fprintf(f, "  \"num_samples\": %lu,\n", (unsigned long)h->num_samples);
+    fprintf(f, "  \"sample_rate\": %.9g,\n", h->sample_rate);
+    fprintf(f, "  \"volts_per_lsb\": %.9g,\n", h->volts_per_lsb);
+    fprintf(f, "  \"volts_offset\": %.9g,\n", h->volts_offset);
+    fprintf(f, "  \"adc_bits\": %u,\n", h->adc_bits);
+    fprintf(f, "  \"trigger_index\": %lu,\n", (unsigned long)h->trigger_index);
+    fprintf(f, "  \"deep\": %s,\n", (h->flags & OSC_WAVEFILE_FLAG_DEEP) ? "true" : "false");
+    fprintf(f, "  \"filtered\": %s,\n", (h->flags & OSC_WAVEFILE_FLAG_FILTERED) ? "true" : "false");
+    fprintf(f, "  \"triggered\": %s,\n", (h->flags & OSC_WAVEFILE_FLAG_TRIGGERED) ? "true" : "false");
+    fprintf(f, "  \"time_per_div\": %.9g,\n", h->time_per_div);
+    fprintf(f, "  \"volts_per_div\": %.9g,\n", h->volts_per_div);
+    fprintf(f, "  \"measurements\": {\"frequency\": %.9g, \"vmax\": %.6g, \"vmin\": %.6g, \"vpp\": %.6g, \"vrms\": %.6g},\n",
+            h->frequency, h->vmax, h->vmin, h->vpp, h->vrms);
+    fprintf(f, "  \"timestamp\": \"%.*s\"\n", (int)strnlen(h->timestamp, sizeof(h->timestamp)), h->timestamp);
+    fprintf(f, "}\n");
+
+    bool ok = !ferror(f);
+    fclose(f);
+    return ok ? ESP_OK : ESP_FAIL;
+}
+
+/**
+ * @brief Fill a header with the defaults for 12-bit ADC samples
+ */
+void osc_wavefile_init_header(osc_wavefile_header_t *header, float volts_per_code)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, OSC_WAVEFILE_MAGIC, sizeof(header->magic));
+    header->version = OSC_WAVEFILE_VERSION;
+    header->data_offset = OSC_WAVEFILE_DATA_OFFSET;
+    header->sample_format = OSC_WAVEFILE_FORMAT_INT16;
+    header->adc_bits = 12;
+    header->volts_per_lsb = volts_per_code / OSC_WAVEFILE_SUBCODES;
+}
+
+/* Binary write job */
+typedef struct {
+    osc_wavefile_header_t header;
+    osc_wavefile_read_fn read;
+    osc_wavefile_release_fn release;
+    void *user;
+    float *volts;               // OSC_WAVEFILE_CHUNK_SAMPLES scratch
+    uint32_t next;              // Next sample to quantize
+    bool header_done;
+    uint32_t clamped;
+} write_job_t;
+
+/**
+ * @brief Writer fill: header block, then quantized samples
+ */
+static esp_err_t write_job_fill(void *user, uint8_t *buf, size_t size, size_t *len)
+{
+    write_job_t *job = (write_job_t *)user;
+    const osc_wavefile_header_t *h = &job->header;
+    size_t used = 0;
+
+    if (!job->header_done) {
+        if (size < OSC_WAVEFILE_DATA_OFFSET) return ESP_ERR_INVALID_SIZE;
+        memset(buf, 0, OSC_WAVEFILE_DATA_OFFSET);
+        memcpy(buf, h, sizeof(*h));
+        used = OSC_WAVEFILE_DATA_OFFSET;
+        job->header_done = true;
+    }
+
+    const float inv_lsb = 1.0f / h->volts_per_lsb;
+    while (job->next < h->num_samples && size - used >= sizeof(int16_t)) {
+        uint32_t n = h->num_samples - job->next;
+        if (n > OSC_WAVEFILE_CHUNK_SAMPLES) n = OSC_WAVEFILE_CHUNK_SAMPLES;
+        if (n > (size - used) / sizeof(int16_t)) n = (size - used) / sizeof(int16_t);
+
+        esp_err_t ret = job->read(job->user, job->next, n, job->volts);
+        if (ret != ESP_OK) return ret;
+
+        int16_t *out = (int16_t *)(buf + used);
+        for (uint32_t i = 0; i < n; i++) {
+            float q = rintf((job->volts[i] - h->volts_offset) * inv_lsb);
+            if (q > 32767.0f) { q = 32767.0f; job->clamped++; }
+            else if (q < -32768.0f) { q = -32768.0f; job->clamped++; }
+            else if (isnan(q)) q = 0.0f;
+            out[i] = (int16_t)q;
+        }
+        used += n * sizeof(int16_t);
+        job->next += n;
+    }
+
+    *len = used;
+    return ESP_OK;
+}
+
+/**
+ * @brief Writer finish: sidecar, release the source
+ */
+static void write_job_finish(void *user, esp_err_t result, const char *path)
+{
+    write_job_t *job = (write_job_t *)user;
+
+    if (result == ESP_OK) {
+        if (job->clamped > 0) {
+            ESP_LOGW(TAG, "%s: %lu samples clamped", path, (unsigned long)job->clamped);
+        }
+        write_sidecar(path, &job->header);
+    }
+
+    if (job->release != NULL) job->release(job->user);
+    heap_caps_free(job->volts);
+    free(job);
+}
+
+/**
+ * @brief Queue a binary waveform file and its JSON sidecar on the storage writer
+ */
+esp_err_t osc_wavefile_write_async(const char *path, const osc_wavefile_header_t *header,
+                                   osc_wavefile_read_fn read, osc_wavefile_release_fn release, void *user,
+                                   storage_writer_progress_cb on_progress, storage_writer_done_cb on_done,
+                                   void *cb_user)
+{
+    if (path == NULL || header == NULL || read == NULL) return ESP_ERR_INVALID_ARG;
+    if (header->num_samples == 0 || !(header->volts_per_lsb > 0.0f)) return ESP_ERR_INVALID_ARG;
+
+    write_job_t *job = calloc(1, sizeof(write_job_t));
+    float *volts = heap_caps_malloc(OSC_WAVEFILE_CHUNK_SAMPLES * sizeof(float), MALLOC_CAP_SPIRAM);
+    if (job == NULL || volts == NULL) {
+        free(job);
+        if (volts) heap_caps_free(volts);
+        ESP_LOGE(TAG, "Failed to allocate write job");
+        return ESP_ERR_NO_MEM;
+    }
+    job->header = *header;
+    job->read = read;
+    job->release = release;
+    job->user = user;
+    job->volts = volts;
+
+    storage_writer_job_t wj = {
+        .total_bytes = OSC_WAVEFILE_DATA_OFFSET + (uint64_t)header->num_samples * sizeof(int16_t),
+        .fill = write_job_fill,
+        .finish = write_job_finish,
+        .user = job,
+        .on_progress = on_progress,
+        .on_done = on_done,
+        .cb_user = cb_user,
+    };
+    snprintf(wj.path, sizeof(wj.path), "%s", path);
+
+    esp_err_t ret = storage_writer_submit(&wj);
+    if (ret != ESP_OK) {
+        // Ownership of the source stays with the caller
+        heap_caps_free(volts);
+        free(job);
+    }
+    return ret;
+}
+
+/**
+ * @brief Read and validate the header of a binary waveform file
+ */
+esp_err_t osc_wavefile_read_header(const char *path, osc_wavefile_header_t *header)
+{
+    if (path == NULL || header == NULL) return ESP_ERR_INVALID_ARG;
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return ESP_ERR_NOT_FOUND;
+
+    bool ok = fread(header, sizeof(*header), 1, f) == 1;
+    fclose(f);
+
+    if (!ok || memcmp(header->magic, OSC_WAVEFILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != OSC_WAVEFILE_VERSION || header->sample_format != OSC_WAVEFILE_FORMAT_INT16 ||
+        header->data_offset < sizeof(*header) || !(header->sample_rate > 0.0)) {
+        ESP_LOGE(TAG, "Invalid waveform file: %s", path);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return ESP_OK;
+}
+
+/* CSV conversion job */
+typedef struct {
+    char bin_path[STORAGE_WRITER_PATH_MAX];
+    osc_wavefile_header_t header;
+    FILE *in;                   // Opened on the first fill (the binary may still be queued)
+    int16_t *samples;           // OSC_WAVEFILE_CSV_ROWS read from the binary
+    uint32_t avail;             // Samples in the buffer
+    uint32_t pos;               // Next buffered sample
+    uint32_t next;              // Next row index
+    double dt;
+} csv_job_t;
+
+/**
+ * @brief Writer fill: comment header, then rows until the buffer is full
+ */
+static esp_err_t csv_job_fill(void *user, uint8_t *buf, size_t size, size_t *len)
+{
+    csv_job_t *job = (csv_job_t *)user;
+    const osc_wavefile_header_t *h = &job->header;
+    char *text = (char *)buf;
+    size_t used = 0;
+
+    if (job->in == NULL) {
+        esp_err_t ret = osc_wavefile_read_header(job->bin_path, &job->header);
+        if (ret != ESP_OK) return ret;
+        job->in = fopen(job->bin_path, "rb");
+        if (job->in == NULL || fseek(job->in, h->data_offset, SEEK_SET) != 0) return ESP_FAIL;
+        job->dt = 1.0 / h->sample_rate;
+
+        used = snprintf(text, size,
+                        "# Oscilloscope Waveform Data\n"
+                        "# Timestamp: %.*s\n"
+                        "# Sample Rate: %.0f Hz\n"
+                        "# Trigger Index: %lu\n"
+                        "# Points: %lu\n"
+                        "#\n"
+                        "Index,Time(s),Voltage(V)\n",
+                        (int)strnlen(h->timestamp, sizeof(h->timestamp)), h->timestamp, h->sample_rate,
+                        (unsigned long)h->trigger_index, (unsigned long)h->num_samples);
+    }
+
+    while (job->next < h->num_samples && size - used > OSC_WAVEFILE_CSV_ROW_MAX) {
+        if (job->pos == job->avail) {
+            uint32_t n = h->num_samples - job->next;
+            if (n > OSC_WAVEFILE_CSV_ROWS) n = OSC_WAVEFILE_CSV_ROWS;
+            if (fread(job->samples, sizeof(int16_t), n, job->in) != n) {
+                ESP_LOGE(TAG, "%s truncated at sample %lu", job->bin_path, (unsigned long)job->next);
+                return ESP_ERR_INVALID_SIZE;
+            }
+            job->avail = n;
+            job->pos = 0;
+        }
+        uint32_t index = job->next++;
+        used += snprintf(text + used, OSC_WAVEFILE_CSV_ROW_MAX, "%lu,%.9f,%.6f\n", (unsigned long)index,
+                         index * job->dt, job->samples[job->pos++] * h->volts_per_lsb + h->volts_offset);
+    }
+
+    *len = used;
+    return ESP_OK;
+}
+
+/**
+ * @brief Writer finish: close the binary, free the job
+ */
+static void csv_job_finish(void *user, esp_err_t result, const char *path)
+{
+    csv_job_t *job = (csv_job_t *)user;
+
+    if (result != ESP_OK) {
+        ESP_LOGE(TAG, "CSV conversion of %s failed: %s", job->bin_path, esp_err_to_name(result));
+    }
+    if (job->in) fclose(job->in);
+    heap_caps_free(job->samples);
+    free(job);
+}
+
+/**
+ * @brief Queue the CSV conversion of a binary waveform file on the storage writer
+ */
+esp_err_t osc_wavefile_to_csv_async(const char *bin_path, storage_writer_done_cb on_done, void *cb_user)
+{
+    if (bin_path == NULL) return ESP_ERR_INVALID_ARG;
+
+    csv_job_t *job = calloc(1, sizeof(csv_job_t));
+    int16_t *samples = heap_caps_malloc(OSC_WAVEFILE_CSV_ROWS * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+    if (job == NULL || samples == NULL) {
+        free(job);
+        if (samples) heap_caps_free(samples);
+        return ESP_ERR_NO_MEM;
+    }
+    snprintf(job->bin_path, sizeof(job->bin_path), "%s", bin_path);
+    job->samples = samples;
+
+    storage_writer_job_t wj = {
+        .fill = csv_job_fill,
+        .finish = csv_job_finish,
+        .user = job,
+        .on_done = on_done,
+        .cb_user = cb_user,
+    };
+    replace_extension(bin_path, ".csv", wj.path, sizeof(wj.path));
+
+    esp_err_t ret = storage_writer_submit(&wj);
+    if (ret != ESP_OK) {
+        heap_caps_free(samples);
+        free(job);
+    }
+    return ret;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file oscilloscope_wavefile.h
+ * @brief Full-depth binary waveform files (.osw) with JSON sidecar
+ *
+ * Layout (little endian):
+ *   0    osc_wavefile_header_t, zero padded to OSC_WAVEFILE_DATA_OFFSET
+ *   512  num_samples int16 values, volts = value * volts_per_lsb + volts_offset
+ *
+ * Samples start on a sector boundary. Files are written by the storage writer
+ * task, which fills one large buffer while the other is on its way to the SD
+ * card, so the UI never waits for the card. A small JSON
+ * file with the same base name carries the header fields for tools that do not
+ * parse the binary header; V4.0/tools/osc_wave.py reads both and converts to
+ * CSV, WAV or NumPy.
+ */
+
+#ifndef OSCILLOSCOPE_WAVEFILE_H
+#define OSCILLOSCOPE_WAVEFILE_H
+
+#include "esp_err.h"
+#include "storage_writer.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OSC_WAVEFILE_MAGIC          "OSCW"
+#define OSC_WAVEFILE_VERSION        1
+#define OSC_WAVEFILE_DATA_OFFSET    512     // Header block, samples start sector-aligned
+#define OSC_WAVEFILE_CHUNK_SAMPLES  16384   // Samples quantized per source read
+#define OSC_WAVEFILE_FORMAT_INT16   1       // Sample format: signed 16-bit
+#define OSC_WAVEFILE_SUBCODES       8       // Stored steps per ADC code (filtered samples keep 3 fraction bits)
+#define OSC_WAVEFILE_EXT            ".osw"
+
+/* Flags */
+#define OSC_WAVEFILE_FLAG_DEEP      (1u << 0)   // Deep memory record
+#define OSC_WAVEFILE_FLAG_FILTERED  (1u << 1)   // Filter chain / AC coupling was active
+#define OSC_WAVEFILE_FLAG_TRIGGERED (1u << 2)   // trigger_index marks a trigger event
+#define OSC_WAVEFILE_FLAG_RECORD    (1u << 3)   // Streaming recorder segment (index header at 512)
+
+/* On-disk header */
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint16_t version;
+    uint16_t data_offset;           // Offset of the first sample
+    uint16_t sample_format;         // OSC_WAVEFILE_FORMAT_INT16
+    uint16_t adc_bits;              // Resolution of the source converter
+    uint32_t num_samples;
+    uint32_t trigger_index;         // Sample index of the trigger
+    uint32_t flags;
+    double sample_rate;             // Hz
+    float volts_per_lsb;            // Scale of the stored values
+    float volts_offset;
+    float time_per_div;             // Display settings at capture time
+    float volts_per_div;
+    float frequency;                // Measurements at capture time
+    float vmax;
+    float vmin;
+    float vpp;
+    float vrms;
+    char timestamp[32];
+} osc_wavefile_header_t;
+
+/* Sample source: volts of samples [start, start + count) (runs in the writer task) */
+typedef esp_err_t (*osc_wavefile_read_fn)(void *user, uint32_t start, uint32_t count, float *volts);
+
+/* Source no longer needed (runs in the writer task) */
+typedef void (*osc_wavefile_release_fn)(void *user);
+
+/**
+ * @brief Fill a header with the defaults for 12-bit ADC samples
+ *
+ * @param header Output: header (magic, version, format, scale set; the rest zeroed)
+ * @param volts_per_code Volts per ADC code
+ */
+void osc_wavefile_init_header(osc_wavefile_header_t *header, float volts_per_code);
+
+/**
+ * @brief Queue a binary waveform file and its JSON sidecar on the storage writer
+ *
+ * Samples are quantized to the header scale (clamped to int16) as the writer
+ * fills its buffers. The sidecar is written once the binary is closed.
+ *
+ * @param path Binary file path (the sidecar replaces the extension with .json)
+ * @param header Header (num_samples > 0, copied)
+ * @param read Sample source
+ * @param release Called with user when the job ends, whatever the result (may be NULL)
+ * @param user Source context
+ * @param on_progress Progress callback on the LVGL thread (may be NULL)
+ * @param on_done Completion callback on the LVGL thread (may be NULL)
+ * @param cb_user Callback context
+ * @return ESP_OK if queued (the source is then released by the job), or the
+ *         storage_writer_submit() error (the source still belongs to the caller)
+ */
+esp_err_t osc_wavefile_write_async(const char *path, const osc_wavefile_header_t *header,
+                                   osc_wavefile_read_fn read, osc_wavefile_release_fn release, void *user,
+                                   storage_writer_progress_cb on_progress, storage_writer_done_cb on_done,
+                                   void *cb_user);
+
+/**
+ * @brief Read and validate the header of a binary waveform file
+ *
+ * @param path File path
+ * @param header Output: header
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND, ESP_ERR_INVALID_RESPONSE if not a waveform file
+ */
+esp_err_t osc_wavefile_read_header(const char *path, osc_wavefile_header_t *header);
+
+/**
+ * @brief Queue the conversion of a binary waveform file to CSV (Index,Time(s),Voltage(V))
+ *
+ * The CSV gets the binary file's base name. The binary is opened when the job
+ * starts, so it may be queued right behind the job that writes it.
+ *
+ * @param bin_path Binary file path (copied)
+ * @param on_done Completion callback on the LVGL thread (may be NULL)
+ * @param cb_user Callback context
+ * @return ESP_OK if queued
+ */
+esp_err_t osc_wavefile_to_csv_async(const char *bin_path, storage_writer_done_cb on_done, void *cb_user);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OSCILLOSCOPE_WAVEFILE_H
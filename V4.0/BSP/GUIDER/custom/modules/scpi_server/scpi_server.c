@@ -0,0 +1,690 @@
+/**
+ * @file scpi_server.c
+ * @brief SCPI-style command server implementation
+ */
+
+#include "scpi_server.h"
+#include "esp_log.h"
+#include <sys/socket.h>
+#include <sys/poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *TAG = "ScpiServer";
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* One connection */
+struct scpi_client_t {
+    int fd;                                 // -1 if the slot is free
+    scpi_server_t *server;
+
+    /* Input: one line at a time; cmd_pos resumes a line after a block */
+    char in[SCPI_SERVER_LINE_MAX];
+    size_t in_len;
+    size_t line_len;                        // Line being run, with its '\n' (0 = none)
+    size_t cmd_pos;
+    bool in_discard;                        // Overlong line: drop until '\n'
+
+    /* Output: text, then the block payload from the caller's memory */
+    char out[SCPI_SERVER_REPLY_MAX];
+    size_t out_len;
+    size_t out_pos;
+    const uint8_t *block;
+    size_t block_len;
+    size_t block_pos;
+    scpi_release_fn release;
+    void *release_user;
+
+    /* Error queue (messages are string literals) */
+    int err_code[SCPI_SERVER_ERROR_QUEUE];
+    const char *err_msg[SCPI_SERVER_ERROR_QUEUE];
+    uint8_t err_head;
+    uint8_t err_count;
+};
+
+/* Server context */
+struct scpi_server_t {
+    int listen_fd;
+    scpi_server_config_t config;
+    scpi_client_t clients[SCPI_SERVER_MAX_CLIENTS];
+    scpi_server_stats_t stats;
+};
+
+static void set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/* ========================================================================
+ * Error queue
+ * ======================================================================== */
+
+/**
+ * @brief Add an entry to the client's error queue
+ */
+void scpi_push_error(scpi_client_t *client, int code, const char *message)
+{
+    if (client == NULL) return;
+
+    client->server->stats.errors++;
+    if (client->err_count == SCPI_SERVER_ERROR_QUEUE) {
+        // Full: the newest entry becomes "Queue overflow"
+        uint8_t last = (client->err_head + SCPI_SERVER_ERROR_QUEUE - 1) % SCPI_SERVER_ERROR_QUEUE;
+        client->err_code[last] = SCPI_ERROR_QUEUE_OVERFLOW;
+        client->err_msg[last] = "Queue overflow";
+        return;
+    }
+    uint8_t slot = (client->err_head + client->err_count) % SCPI_SERVER_ERROR_QUEUE;
+    client->err_code[slot] = code;
+    client->err_msg[slot] = message;
+    client->err_count++;
+}
+
+/**
+ * @brief Take the oldest error of the client's queue
+ */
+int scpi_pop_error(scpi_client_t *client, const char **message)
+{
+    if (client == NULL || client->err_count == 0) {
+        if (message) *message = "No error";
+        return SCPI_ERROR_NONE;
+    }
+    int code = client->err_code[client->err_head];
+    if (message) *message = client->err_msg[client->err_head];
+    client->err_head = (client->err_head + 1) % SCPI_SERVER_ERROR_QUEUE;
+    client->err_count--;
+    return code;
+}
+
+/**
+ * @brief Clear the client's error queue
+ */
+void scpi_clear_errors(scpi_client_t *client)
+{
+    if (client == NULL) return;
+    client->err_head = 0;
+    client->err_count = 0;
+}
+
+/* ========================================================================
+ * Replies
+ * ======================================================================== */
+
+/**
+ * @brief Make room at the end of the text buffer
+ */
+static size_t out_space(scpi_client_t *client)
+{
+    if (client->out_pos > 0) {
+        memmove(client->out, client->out + client->out_pos, client->out_len - client->out_pos);
+        client->out_len -= client->out_pos;
+        client->out_pos = 0;
+    }
+    return sizeof(client->out) - client->out_len;
+}
+
+/**
+ * @brief Queue a text reply; a newline is appended
+ */
+esp_err_t scpi_reply(scpi_client_t *client, const char *fmt, ...)
+{
+    if (client == NULL || fmt == NULL) return ESP_ERR_INVALID_ARG;
+
+    size_t space = out_space(client);
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(client->out + client->out_len, space, fmt, ap);
+    va_end(ap);
+    if (n < 0 || (size_t)n + 1 >= space) {
+        scpi_push_error(client, SCPI_ERROR_QUEUE_OVERFLOW, "Queue overflow");
+        return ESP_ERR_NO_MEM;
+    }
+    client->out_len += n;
+    client->out[client->out_len++] = '\n';
+    return ESP_OK;
+}
+
+/**
+ * @brief Queue an IEEE 488.2 definite-length block sent from data in place
+ */
+esp_err_t scpi_reply_block(scpi_client_t *client, const void *data, size_t len,
+                           scpi_release_fn release, void *release_user)
+{
+    esp_err_t ret = ESP_OK;
+    if (client == NULL || (data == NULL && len > 0)) {
+        ret = ESP_ERR_INVALID_ARG;
+    } else if (client->block != NULL) {
+        ret = ESP_ERR_INVALID_STATE;
+    } else {
+        // "#<digits of length><length>", payload, then the terminator as text
+        char length[24];
+        int digits = snprintf(length, sizeof(length), "%lu", (unsigned long)len);
+        if ((size_t)digits + 3 > out_space(client)) {
+            scpi_push_error(client, SCPI_ERROR_QUEUE_OVERFLOW, "Queue overflow");
+            ret = ESP_ERR_NO_MEM;
+        } else {
+            client->out_len += sprintf(client->out + client->out_len, "#%d%s", digits, length);
+            client->block = data;
+            client->block_len = len;
+            client->block_pos = 0;
+            client->release = release;
+            client->release_user = release_user;
+            if (len == 0) {
+                client->block = (const uint8_t *)"";
+            }
+        }
+    }
+    if (ret != ESP_OK && release != NULL) {
+        release(release_user);
+    }
+    return ret;
+}
+
+/**
+ * @brief Finish the block: release the payload, then send the terminator
+ */
+static void end_block(scpi_client_t *client)
+{
+    scpi_release_fn release = client->release;
+    void *release_user = client->release_user;
+    client->block = NULL;
+    client->release = NULL;
+    client->release_user = NULL;
+    if (release != NULL) release(release_user);
+}
+
+/**
+ * @brief Send what the socket takes without blocking
+ *
+ * @return false if the connection failed
+ */
+static bool flush_output(scpi_client_t *client)
+{
+    scpi_server_stats_t *stats = &client->server->stats;
+
+    for (;;) {
+        const uint8_t *p;
+        size_t n;
+        bool from_block = false;
+        if (client->out_pos < client->out_len) {
+            p = (const uint8_t *)client->out + client->out_pos;
+            n = client->out_len - client->out_pos;
+        } else if (client->block != NULL && client->block_pos < client->block_len) {
+            p = client->block + client->block_pos;
+            n = client->block_len - client->block_pos;
+            from_block = true;
+        } else if (client->block != NULL) {
+            // Payload out: release it and send the terminator
+            end_block(client);
+            client->out_len = client->out_pos = 0;
+            client->out[client->out_len++] = '\n';
+            continue;
+        } else {
+            client->out_len = client->out_pos = 0;
+            return true;
+        }
+
+        ssize_t sent = send(client->fd, p, n, MSG_NOSIGNAL);
+        if (sent < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+        }
+        stats->bytes_sent += sent;
+        if (from_block) {
+            client->block_pos += sent;
+            stats->block_bytes_sent += sent;
+        } else {
+            client->out_pos += sent;
+        }
+        if ((size_t)sent < n) {
+            return true;    // Socket buffer full; continue on POLLOUT
+        }
+    }
+}
+
+static bool has_output(const scpi_client_t *client)
+{
+    return client->out_pos < client->out_len || client->block != NULL;
+}
+
+/* ========================================================================
+ * Command matching
+ * ======================================================================== */
+
+/**
+ * @brief Match one header node against a pattern node ("CHANnel1" vs "chan1")
+ */
+static bool match_node(const char *pat, size_t pat_len, const char *in, size_t in_len)
+{
+    // Split both into letters and a numeric suffix
+    size_t pat_letters = pat_len;
+    while (pat_letters > 0 && isdigit((unsigned char)pat[pat_letters - 1])) pat_letters--;
+    size_t in_letters = in_len;
+    while (in_letters > 0 && isdigit((unsigned char)in[in_letters - 1])) in_letters--;
+
+    size_t short_len = 0;
+    while (short_len < pat_letters && !islower((unsigned char)pat[short_len])) short_len++;
+
+    if (in_letters != pat_letters && in_letters != short_len) return false;
+    for (size_t i = 0; i < in_letters; i++) {
+        if (toupper((unsigned char)in[i]) != toupper((unsigned char)pat[i])) return false;
+    }
+
+    // Suffix: equal, or omitted when it is 1
+    size_t pat_digits = pat_len - pat_letters;
+    size_t in_digits = in_len - in_letters;
+    if (in_digits == 0) {
+        return pat_digits == 0 || (pat_digits == 1 && pat[pat_letters] == '1');
+    }
+    return pat_digits == in_digits && strncmp(pat + pat_letters, in + in_letters, in_digits) == 0;
+}
+
+/**
+ * @brief Match a whole header against a pattern
+ */
+static bool match_header(const char *pattern, const char *header, size_t header_len)
+{
+    if (pattern[0] == '*' || header[0] == '*') {
+        return strlen(pattern) == header_len && strncasecmp(pattern, header, header_len) == 0;
+    }
+
+    if (*pattern == ':') pattern++;
+    if (header_len > 0 && *header == ':') {
+        header++;
+        header_len--;
+    }
+
+    size_t pat_len = strlen(pattern);
+    bool pat_query = pat_len > 0 && pattern[pat_len - 1] == '?';
+    bool in_query = header_len > 0 && header[header_len - 1] == '?';
+    if (pat_query != in_query) return false;
+    if (pat_query) pat_len--;
+    if (in_query) header_len--;
+
+    while (pat_len > 0 && header_len > 0) {
+        const char *pat_end = memchr(pattern, ':', pat_len);
+        const char *in_end = memchr(header, ':', header_len);
+        size_t pn = pat_end ? (size_t)(pat_end - pattern) : pat_len;
+        size_t hn = in_end ? (size_t)(in_end - header) : header_len;
+        if (!match_node(pattern, pn, header, hn)) return false;
+        if ((pat_end == NULL) != (in_end == NULL)) return false;
+        if (pat_end == NULL) return true;
+        pattern += pn + 1;
+        pat_len -= pn + 1;
+        header += hn + 1;
+        header_len -= hn + 1;
+    }
+    return false;
+}
+
+/**
+ * @brief Run one command ("HEADER args")
+ */
+static void run_command(scpi_client_t *client, char *cmd)
+{
+    scpi_server_t *server = client->server;
+
+    while (isspace((unsigned char)*cmd)) cmd++;
+    size_t len = strlen(cmd);
+    while (len > 0 && isspace((unsigned char)cmd[len - 1])) cmd[--len] = '\0';
+    if (len == 0) return;
+
+    size_t header_len = 0;
+    while (header_len < len && !isspace((unsigned char)cmd[header_len])) header_len++;
+    const char *args = cmd + header_len;
+    while (isspace((unsigned char)*args)) args++;
+
+    server->stats.commands++;
+    for (size_t i = 0; i < server->config.num_commands; i++) {
+        const scpi_command_t *command = &server->config.commands[i];
+        if (match_header(command->pattern, cmd, header_len)) {
+            int before = client->err_count;
+            esp_err_t ret = command->handler(client, args, server->config.user);
+            if (ret != ESP_OK && client->err_count == before) {
+                scpi_push_error(client, SCPI_ERROR_EXECUTION, "Execution error");
+            }
+            return;
+        }
+    }
+    ESP_LOGD(TAG, "Undefined header: %.*s", (int)header_len, cmd);
+    scpi_push_error(client, SCPI_ERROR_UNDEFINED_HEADER, "Undefined header");
+}
+
+/**
+ * @brief Run the complete lines received, stopping while a block is queued
+ */
+static void process_input(scpi_client_t *client)
+{
+    while (client->block == NULL) {
+        if (client->line_len == 0) {
+            char *nl = memchr(client->in, '\n', client->in_len);
+            if (nl == NULL) return;
+            *nl = '\0';
+            client->line_len = nl - client->in + 1;
+        }
+        size_t line_len = client->line_len;
+
+        // Commands of a line are separated by ';'
+        while (client->cmd_pos < line_len - 1 && client->block == NULL) {
+            char *cmd = client->in + client->cmd_pos;
+            char *sep = strchr(cmd, ';');
+            if (sep != NULL) {
+                *sep = '\0';
+                client->cmd_pos = sep - client->in + 1;
+            } else {
+                client->cmd_pos = line_len - 1;
+            }
+            char *cr = strchr(cmd, '\r');
+            if (cr != NULL) *cr = '\0';
+            run_command(client, cmd);
+        }
+        if (client->cmd_pos < line_len - 1) {
+            return;     // Resume after the block
+        }
+
+        memmove(client->in, client->in + line_len, client->in_len - line_len);
+        client->in_len -= line_len;
+        client->line_len = 0;
+        client->cmd_pos = 0;
+    }
+}
+
+/**
+ * @brief Read what is available
+ *
+ * @return false if the peer closed or the connection failed
+ */
+static bool read_input(scpi_client_t *client)
+{
+    for (;;) {
+        size_t space = sizeof(client->in) - client->in_len;
+        if (space == 0) {
+            // No newline in a full buffer: drop the line
+            scpi_push_error(client, SCPI_ERROR_INPUT_OVERFLOW, "Input buffer overrun");
+            client->in_len = 0;
+            client->line_len = 0;
+            client->cmd_pos = 0;
+            client->in_discard = true;
+            space = sizeof(client->in);
+        }
+
+        ssize_t n = recv(client->fd, client->in + client->in_len, space, 0);
+        if (n == 0) return false;
+        if (n < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+        }
+
+        if (client->in_discard) {
+            char *nl = memchr(client->in, '\n', n);
+            if (nl == NULL) continue;
+            size_t keep = n - (nl - client->in + 1);
+            memmove(client->in, nl + 1, keep);
+            client->in_len = keep;
+            client->in_discard = false;
+        } else {
+            client->in_len += n;
+        }
+        if ((size_t)n < space) return true;
+    }
+}
+
+/* ========================================================================
+ * Connections
+ * ======================================================================== */
+
+static void close_client(scpi_client_t *client)
+{
+    if (client->fd < 0) return;
+
+    if (client->block != NULL) {
+        end_block(client);
+    }
+    close(client->fd);
+    client->fd = -1;
+    client->server->stats.clients--;
+    ESP_LOGI(TAG, "Client disconnected (%lu connected)", (unsigned long)client->server->stats.clients);
+}
+
+static void accept_clients(scpi_server_t *server)
+{
+    for (;;) {
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        int fd = accept(server->listen_fd, (struct sockaddr *)&addr, &addr_len);
+        if (fd < 0) return;
+
+        scpi_client_t *client = NULL;
+        for (int i = 0; i < SCPI_SERVER_MAX_CLIENTS; i++) {
+            if (server->clients[i].fd < 0) {
+                client = &server->clients[i];
+                break;
+            }
+        }
+        if (client == NULL) {
+            ESP_LOGW(TAG, "Connection refused: %d clients connected", SCPI_SERVER_MAX_CLIENTS);
+            close(fd);
+            continue;
+        }
+
+        set_nonblocking(fd);
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));   // Short replies go out at once
+
+        memset(client, 0, sizeof(*client));
+        client->fd = fd;
+        client->server = server;
+        server->stats.clients++;
+        server->stats.connections++;
+        ESP_LOGI(TAG, "Client connected (%lu connected)", (unsigned long)server->stats.clients);
+    }
+}
+
+/**
+ * @brief Create a server listening on the configured port
+ */
+scpi_server_t *scpi_server_create(const scpi_server_config_t *config)
+{
+    if (config == NULL || (config->commands == NULL && config->num_commands > 0)) return NULL;
+
+    scpi_server_t *server = calloc(1, sizeof(scpi_server_t));
+    if (server == NULL) return NULL;
+    server->config = *config;
+    if (server->config.port == 0) server->config.port = SCPI_SERVER_DEFAULT_PORT;
+    for (int i = 0; i < SCPI_SERVER_MAX_CLIENTS; i++) {
+        server->clients[i].fd = -1;
+    }
+
+    server->listen_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (server->listen_fd < 0) {
+        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+        free(server);
+        return NULL;
+    }
+
+    int opt = 1;
+    setsockopt(server->listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+        .sin_port = htons(server->config.port),
+    };
+    if (bind(server->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(server->listen_fd, SCPI_SERVER_MAX_CLIENTS) < 0) {
+        ESP_LOGE(TAG, "Failed to listen on port %u: errno %d", server->config.port, errno);
+        close(server->listen_fd);
+        free(server);
+        return NULL;
+    }
+    set_nonblocking(server->listen_fd);
+
+    ESP_LOGI(TAG, "Listening on port %u (%u commands)", server->config.port,
+             (unsigned)server->config.num_commands);
+    return server;
+}
+
+/**
+ * @brief Close all connections and the listener
+ */
+void scpi_server_destroy(scpi_server_t *server)
+{
+    if (server == NULL) return;
+
+    for (int i = 0; i < SCPI_SERVER_MAX_CLIENTS; i++) {
+        close_client(&server->clients[i]);
+    }
+    close(server->listen_fd);
+    free(server);
+}
+
+/**
+ * @brief Wait for socket events up to timeout_ms and serve them
+ */
+esp_err_t scpi_server_poll(scpi_server_t *server, int timeout_ms)
+{
+    if (server == NULL) return ESP_ERR_INVALID_ARG;
+
+    struct pollfd fds[SCPI_SERVER_MAX_CLIENTS + 1];
+    scpi_client_t *owners[SCPI_SERVER_MAX_CLIENTS + 1];
+    int nfds = 0;
+
+    fds[nfds].fd = server->listen_fd;
+    fds[nfds].events = POLLIN;
+    fds[nfds].revents = 0;
+    owners[nfds++] = NULL;
+    for (int i = 0; i < SCPI_SERVER_MAX_CLIENTS; i++) {
+        scpi_client_t *client = &server->clients[i];
+        if (client->fd < 0) continue;
+        // While a block is queued the client's next commands wait in the socket
+        fds[nfds].fd = client->fd;
+        fds[nfds].events = (client->block == NULL ? POLLIN : 0) | (has_output(client) ? POLLOUT : 0);
+        fds[nfds].revents = 0;
+        owners[nfds++] = client;
+    }
+
+    int ready = poll(fds, nfds, timeout_ms);
+    if (ready < 0) {
+        if (errno == EINTR) return ESP_OK;
+        ESP_LOGE(TAG, "poll failed: errno %d", errno);
+        return ESP_FAIL;
+    }
+    if (ready == 0) return ESP_OK;
+
+    for (int i = 1; i < nfds; i++) {
+        scpi_client_t *client = owners[i];
+        short revents = fds[i].revents;
+        if (revents == 0) continue;
+
+        bool ok = true;
+        if (revents & (POLLERR | POLLNVAL)) {
+            ok = false;
+        }
+        if (ok && (revents & (POLLIN | POLLHUP)) && client->block == NULL) {
+            ok = read_input(client);
+        }
+        if (ok && (revents & POLLOUT)) {
+            ok = flush_output(client);
+        }
+        // A block sent in full lets the rest of its line run at once
+        while (ok) {
+            process_input(client);
+            ok = flush_output(client);
+            if (client->block != NULL || client->line_len == 0) break;
+        }
+        if (!ok) {
+            close_client(client);
+        }
+    }
+
+    if (fds[0].revents & POLLIN) {
+        accept_clients(server);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Get server statistics
+ */
+void scpi_server_get_stats(scpi_server_t *server, scpi_server_stats_t *stats)
+{
+    if (server == NULL || stats == NULL) return;
+    *stats = server->stats;
+}
+
+/* ========================================================================
+ * Parameters
+ * ======================================================================== */
+
+/**
+ * @brief Parse a numeric parameter with an optional SI suffix or unit
+ */
+bool scpi_parse_number(const char *args, float *value)
+{
+    if (args == NULL || value == NULL) return false;
+
+    char *end;
+    float v = strtof(args, &end);
+    if (end == args) return false;
+    while (isspace((unsigned char)*end)) end++;
+
+    // Suffix: [multiplier][unit]; SCPI reads "M" as milli, "MA"/"MHZ" as mega
+    char suffix[8];
+    size_t n = 0;
+    while (end[n] != '\0' && !isspace((unsigned char)end[n]) && end[n] != ',' && n < sizeof(suffix) - 1) {
+        suffix[n] = (char)toupper((unsigned char)end[n]);
+        n++;
+    }
+    suffix[n] = '\0';
+
+    static const char *const units[] = { "", "S", "V", "HZ", "A", "PCT" };
+    const size_t num_units = sizeof(units) / sizeof(units[0]);
+    for (size_t i = 0; i < num_units; i++) {
+        if (strcmp(suffix, units[i]) == 0) {
+            *value = v;
+            return true;
+        }
+    }
+
+    float scale;
+    const char *unit = suffix + 1;
+    switch (suffix[0]) {
+    case 'P': scale = 1e-12f; break;
+    case 'N': scale = 1e-9f; break;
+    case 'U': scale = 1e-6f; break;
+    case 'M': scale = (strcmp(suffix, "MHZ") == 0 || strcmp(suffix, "MA") == 0) ? 1e6f : 1e-3f; break;
+    case 'K': scale = 1e3f; break;
+    case 'G': scale = 1e9f; break;
+    default: return false;
+    }
+    if (strcmp(suffix, "MA") == 0) unit = "";
+    for (size_t i = 0; i < num_units; i++) {
+        if (strcmp(unit, units[i]) == 0) {
+            *value = v * scale;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Match a parameter against a keyword in short/long form
+ */
+bool scpi_match_keyword(const char *args, const char *keyword)
+{
+    if (args == NULL || keyword == NULL) return false;
+
+    size_t len = 0;
+    while (args[len] != '\0' && !isspace((unsigned char)args[len]) && args[len] != ',') len++;
+    return len > 0 && match_node(keyword, strlen(keyword), args, len);
+}
@@ -0,0 +1,194 @@
+/**
+ * @file scpi_server.h
+ * @brief SCPI-style command server over TCP (raw socket, port 5025)
+ *
+ * One poll() loop serves the listening socket and up to
+ * SCPI_SERVER_MAX_CLIENTS connections; nothing blocks on a single client.
+ * Lines ending in '\n' are split at ';' and each command is matched against
+ * the caller's command table:
+ *
+ *   - Headers use the SCPI short/long forms: ":TIMebase:SCALe?" matches
+ *     ":TIM:SCAL?", ":timebase:scale?" and "TIM:SCALE?" (leading ':' optional)
+ *   - A node ending in digits ("CHANnel1") takes that suffix, which may be
+ *     left out when it is 1
+ *   - Common commands ("*IDN?") match literally, ignoring case
+ *
+ * Handlers answer with scpi_reply() or with scpi_reply_block(), which sends
+ * an IEEE 488.2 definite-length block ("#<n><length><bytes>\n") straight
+ * from the caller's memory: the bytes are handed to send() as the socket
+ * drains, and the release callback runs once they are out (or the client is
+ * gone). Further commands of that client wait until the block is sent.
+ *
+ * The module only uses BSD sockets and poll(), so it builds unchanged on the
+ * host (see tools/scpi_host). It does not create a task: call
+ * scpi_server_poll() from one.
+ */
+
+#ifndef SCPI_SERVER_H
+#define SCPI_SERVER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SCPI_SERVER_DEFAULT_PORT    5025            // IANA "scpi-raw"
+#define SCPI_SERVER_MAX_CLIENTS     4
+#define SCPI_SERVER_LINE_MAX        256             // Longest command line
+#define SCPI_SERVER_REPLY_MAX       512             // Text replies pending per client
+#define SCPI_SERVER_ERROR_QUEUE     8               // :SYST:ERR? entries per client
+
+/* Standard SCPI error codes used by the server and handlers */
+#define SCPI_ERROR_NONE                 0
+#define SCPI_ERROR_COMMAND              -100    // "Command error"
+#define SCPI_ERROR_UNDEFINED_HEADER     -113    // "Undefined header"
+#define SCPI_ERROR_EXECUTION            -200    // "Execution error"
+#define SCPI_ERROR_SETTINGS_CONFLICT    -221    // "Settings conflict"
+#define SCPI_ERROR_DATA_OUT_OF_RANGE    -222    // "Data out of range"
+#define SCPI_ERROR_MISSING_PARAMETER    -109    // "Missing parameter"
+#define SCPI_ERROR_DATA_STALE           -230    // "Data corrupt or stale"
+#define SCPI_ERROR_QUEUE_OVERFLOW       -350    // "Queue overflow"
+#define SCPI_ERROR_INPUT_OVERFLOW       -363    // "Input buffer overrun"
+
+/* Server context (opaque) */
+typedef struct scpi_server_t scpi_server_t;
+
+/* Connection a command came from (opaque) */
+typedef struct scpi_client_t scpi_client_t;
+
+/**
+ * @brief Command handler
+ *
+ * Runs in the task calling scpi_server_poll().
+ *
+ * @param client Connection to reply to
+ * @param args Parameters after the header, leading blanks removed ("" if none)
+ * @param user Server user pointer
+ * @return ESP_OK, or an error that is queued as SCPI_ERROR_EXECUTION (use
+ *         scpi_push_error() first for a more specific code)
+ */
+typedef esp_err_t (*scpi_handler_fn)(scpi_client_t *client, const char *args, void *user);
+
+/**
+ * @brief Block sent: release the memory given to scpi_reply_block()
+ */
+typedef void (*scpi_release_fn)(void *release_user);
+
+/* Command table entry */
+typedef struct {
+    const char *pattern;            // e.g. ":MEASure:VPP?" or "*IDN?"
+    scpi_handler_fn handler;
+} scpi_command_t;
+
+/* Server configuration */
+typedef struct {
+    uint16_t port;                  // 0 = SCPI_SERVER_DEFAULT_PORT
+    const scpi_command_t *commands; // Table, kept by reference
+    size_t num_commands;
+    void *user;                     // Passed to handlers
+} scpi_server_config_t;
+
+/* Server statistics */
+typedef struct {
+    uint32_t clients;               // Connected now
+    uint32_t connections;           // Accepted since start
+    uint32_t commands;
+    uint32_t errors;                // Errors queued
+    uint64_t bytes_sent;
+    uint64_t block_bytes_sent;      // Of those, block payload (zero-copy)
+} scpi_server_stats_t;
+
+/**
+ * @brief Create a server listening on the configured port
+ *
+ * @param config Configuration (copied; the command table is not)
+ * @return Server context, NULL on failure
+ */
+scpi_server_t *scpi_server_create(const scpi_server_config_t *config);
+
+/**
+ * @brief Close all connections (releasing pending blocks) and the listener
+ */
+void scpi_server_destroy(scpi_server_t *server);
+
+/**
+ * @brief Wait for socket events up to timeout_ms and serve them
+ *
+ * @param server Server context
+ * @param timeout_ms Longest wait (0 = just serve what is ready)
+ * @return ESP_OK, or ESP_FAIL if poll() failed
+ */
+esp_err_t scpi_server_poll(scpi_server_t *server, int timeout_ms);
+
+/**
+ * @brief Get server statistics
+ */
+void scpi_server_get_stats(scpi_server_t *server, scpi_server_stats_t *stats);
+
+/**
+ * @brief Queue a text reply; a newline is appended
+ *
+ * @return ESP_OK, or ESP_ERR_NO_MEM if SCPI_SERVER_REPLY_MAX would be exceeded
+ */
+esp_err_t scpi_reply(scpi_client_t *client, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/**
+ * @brief Queue an IEEE 488.2 definite-length block sent from data in place
+ *
+ * data must stay valid and unchanged until release is called. release is
+ * called exactly once, also when this returns an error.
+ *
+ * @param client Connection
+ * @param data Payload
+ * @param len Payload bytes
+ * @param release Called when the payload is no longer needed (may be NULL)
+ * @param release_user Passed to release
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE if a block is already queued
+ */
+esp_err_t scpi_reply_block(scpi_client_t *client, const void *data, size_t len,
+                           scpi_release_fn release, void *release_user);
+
+/**
+ * @brief Add an entry to the client's error queue (read by :SYSTem:ERRor?)
+ */
+void scpi_push_error(scpi_client_t *client, int code, const char *message);
+
+/**
+ * @brief Take the oldest error of the client's queue
+ *
+ * @param client Connection
+ * @param message Output: message ("No error" if the queue is empty)
+ * @return Error code, SCPI_ERROR_NONE if the queue is empty
+ */
+int scpi_pop_error(scpi_client_t *client, const char **message);
+
+/**
+ * @brief Clear the client's error queue (*CLS)
+ */
+void scpi_clear_errors(scpi_client_t *client);
+
+/**
+ * @brief Parse a numeric parameter with an optional SI suffix or unit
+ *
+ * Accepts e.g. "0.001", "1e-3", "1ms", "500 mV", "2.5V", "1MHz".
+ *
+ * @param args Parameter text
+ * @param value Output
+ * @return true if a number was found
+ */
+bool scpi_parse_number(const char *args, float *value);
+
+/**
+ * @brief Match a parameter against a keyword in short/long form ("POSitive")
+ */
+bool scpi_match_keyword(const char *args, const char *keyword);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCPI_SERVER_H */
@@ -4,6 +4,10 @@
  * 
  * Takes screenshots and saves them directly to SD card.
  * Triggered by three-finger swipe gesture.
+ *
+ * The LVGL thread only snapshots the screen (and the top layer) into PSRAM;
+ * the storage writer task composites each row, encodes it (PNG, QOI or BMP)
+ * and writes the file.
  */
 
 #include "screenshot.h"
@@ -12,6 +16,7 @@
 #include "esp_err.h"
 #include "esp_heap_caps.h"
 #include "esp_lcd_touch.h"
+#include "esp_timer.h"
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -51,10 +56,31 @@ static lv_indev_t *g_touch_indev = NULL;
 static esp_lcd_touch_handle_t g_touch_handle = NULL;
 static lv_timer_t *g_touch_poll_timer = NULL;
 
+/* Screenshot being encoded and written by the storage writer */
+typedef struct {
+    uint16_t *screen;                   // RGB565 snapshot of the screen (PSRAM)
+    uint16_t *top;                      // RGB565 snapshot of the top layer, NULL if none
+    int width;
+    int height;
+    int top_width;
+    int top_height;
+    uint16_t *row;                      // Composited row (only with a top layer)
+    image_encoder_t enc;
+    char filename[64];
+    int64_t start_us;
+    int64_t capture_us;                 // Time spent on the LVGL thread
+    int64_t elapsed_us;                 // Capture to file closed
+    esp_err_t result;
+    storage_writer_done_cb on_done;
+    void *cb_user;
+} screenshot_job_t;
+
+static screenshot_job_t *g_job = NULL;  // In flight (LVGL thread only)
+
 /* Forward declarations */
 static void touch_poll_timer_cb(lv_timer_t *timer);
 static uint8_t get_touch_point_count(uint16_t *x_arr, uint16_t *y_arr, uint8_t max_points);
-static void show_screenshot_toast(bool success, const char *filename);
+static void show_screenshot_toast(bool success, const char *text);
 
 /**
  * @brief Initialize screenshot module
@@ -231,7 +257,7 @@ static void touch_poll_timer_cb(lv_timer_t *timer)
 /**
  * @brief Show toast notification
  */
-static void show_screenshot_toast(bool success, const char *filename)
+static void show_screenshot_toast(bool success, const char *text)
 {
     lv_obj_t *screen = lv_scr_act();
     
@@ -257,157 +283,251 @@ static void show_screenshot_toast(bool success, const char *filename)
     lv_obj_set_style_text_color(label, lv_color_hex(0xFFFFFF), 0);
     lv_obj_set_style_text_font(label, &lv_font_montserrat_16, 0);
     lv_obj_center(label);
-
-    if (success) {
-        char msg[128];
-        int count = screenshot_storage_get_count();
-        snprintf(msg, sizeof(msg), LV_SYMBOL_OK " Saved: %s (%d total)", filename, count);
-            lv_label_set_text(label, msg);
-    } else {
-        lv_label_set_text(label, LV_SYMBOL_CLOSE " Screenshot Failed - No SD Card");
-        }
+    lv_label_set_text(label, text);
 
     /* Auto-delete toast */
     lv_obj_del_delayed(toast, 2000);
 }
 
+/**
+ * @brief Snapshot an object into a PSRAM buffer (RGB565, LVGL thread)
+ *
+ * @return Pixel buffer to heap_caps_free(), NULL on failure
+ */
+static uint16_t *snapshot_to_psram(lv_obj_t *obj, int *width, int *height)
+{
+    uint32_t size = lv_snapshot_buf_size_needed(obj, LV_IMG_CF_TRUE_COLOR);
+    if (size == 0) {
+        return NULL;
+    }
+
+    uint16_t *buf = heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    lv_img_dsc_t dsc;
+    if (lv_snapshot_take_to_buf(obj, LV_IMG_CF_TRUE_COLOR, &dsc, buf, size) != LV_RES_OK) {
+        heap_caps_free(buf);
+        return NULL;
+    }
+
+    *width = dsc.header.w;
+    *height = dsc.header.h;
+    return buf;
+}
+
+/**
+ * @brief Encoder row source: the screen row, with top layer pixels composited over it
+ */
+static const uint16_t *screenshot_row(void *user, int y)
+{
+    screenshot_job_t *job = (screenshot_job_t *)user;
+    const uint16_t *src = job->screen + (size_t)y * job->width;
+
+    if (job->top == NULL || y >= job->top_height) {
+        return src;
+    }
+
+    const uint16_t *top = job->top + (size_t)y * job->top_width;
+    int top_cols = job->top_width < job->width ? job->top_width : job->width;
+    uint16_t *row = NULL;
+
+    for (int x = 0; x < top_cols; x++) {
+        /* Top layer pixels cover the screen unless transparent (0x0000 in an RGB565 snapshot) */
+        if (top[x] != 0x0000) {
+            if (row == NULL) {
+                row = job->row;
+                memcpy(row, src, (size_t)job->width * sizeof(uint16_t));
+            }
+            row[x] = top[x];
+        }
+    }
+
+    /* Rows the top layer leaves clear go to the encoder straight from the snapshot */
+    return row != NULL ? row : src;
+}
+
+/**
+ * @brief Writer fill: as much of the file as fits
+ */
+static esp_err_t screenshot_fill(void *user, uint8_t *buf, size_t size, size_t *len)
+{
+    screenshot_job_t *job = (screenshot_job_t *)user;
+    return image_encoder_fill(&job->enc, buf, size, len);
+}
+
+/**
+ * @brief Writer finish: record the file and release the pixels
+ */
+static void screenshot_finish(void *user, esp_err_t result, const char *path)
+{
+    screenshot_job_t *job = (screenshot_job_t *)user;
+
+    if (result == ESP_OK) {
+        screenshot_storage_add(job->filename, (uint32_t)image_encoder_bytes(&job->enc));
+    }
+
+    image_encoder_deinit(&job->enc);
+    heap_caps_free(job->screen);
+    heap_caps_free(job->top);
+    heap_caps_free(job->row);
+    job->screen = NULL;
+    job->top = NULL;
+    job->row = NULL;
+    job->result = result;
+    job->elapsed_us = esp_timer_get_time() - job->start_us;
+    (void)path;
+}
+
+/**
+ * @brief Writer completion (LVGL thread): toast, report, free the job
+ */
+static void screenshot_done(void *user, esp_err_t result, const char *path)
+{
+    screenshot_job_t *job = (screenshot_job_t *)user;
+    char msg[128];
+
+    if (result == ESP_OK) {
+        ESP_LOGI(TAG, "Screenshot saved: %s, %llu bytes (capture %lld ms, total %lld ms)", job->filename,
+                 (unsigned long long)image_encoder_bytes(&job->enc), job->capture_us / 1000,
+                 job->elapsed_us / 1000);
+        snprintf(msg, sizeof(msg), LV_SYMBOL_OK " Saved: %s (%d total)", job->filename,
+                 screenshot_storage_get_count());
+        show_screenshot_toast(true, msg);
+    } else {
+        ESP_LOGE(TAG, "Failed to save screenshot: %s", esp_err_to_name(result));
+        show_screenshot_toast(false, LV_SYMBOL_CLOSE " Screenshot Failed - Write Error");
+    }
+
+    if (job->on_done != NULL) {
+        job->on_done(job->cb_user, result, path);
+    }
+
+    g_job = NULL;
+    heap_caps_free(job);
+}
+
 /**
  * @brief Take a screenshot
- * @note This captures the entire display including all layers (active screen + top layer + sys layer)
+ * @note This captures the entire display including all layers (active screen + top layer)
  */
 esp_err_t screenshot_take(lv_obj_t *screen)
+{
+    return screenshot_take_async(screen, NULL, NULL);
+}
+
+/**
+ * @brief Capture now, encode and write in the background
+ */
+esp_err_t screenshot_take_async(lv_obj_t *screen, storage_writer_done_cb on_done, void *cb_user)
 {
     /* Check if storage is available */
     if (!screenshot_storage_is_available()) {
         ESP_LOGE(TAG, "SD card not available");
-        show_screenshot_toast(false, NULL);
+        show_screenshot_toast(false, LV_SYMBOL_CLOSE " Screenshot Failed - No SD Card");
         return ESP_ERR_NOT_FOUND;
     }
 
-    ESP_LOGI(TAG, "Taking screenshot...");
-
-    /* Generate filename */
-    char filename[64];
-    esp_err_t ret = screenshot_storage_generate_filename(filename, sizeof(filename));
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to generate filename");
-        show_screenshot_toast(false, NULL);
-        return ret;
+    /* One capture in flight: each holds a full-screen snapshot in PSRAM */
+    if (g_job != NULL) {
+        ESP_LOGW(TAG, "Previous screenshot still being saved");
+        show_screenshot_toast(false, LV_SYMBOL_WARNING " Screenshot Busy - Still Saving");
+        return ESP_ERR_INVALID_STATE;
     }
 
     /* Get display */
     lv_disp_t *disp = lv_disp_get_default();
     if (disp == NULL) {
         ESP_LOGE(TAG, "No display found");
-        show_screenshot_toast(false, NULL);
+        show_screenshot_toast(false, LV_SYMBOL_CLOSE " Screenshot Failed");
         return ESP_ERR_NOT_FOUND;
     }
 
-    /* 
-     * To capture popups and overlays, we need to snapshot the entire display.
-     * LVGL has multiple layers:
-     * 1. Active screen (lv_scr_act) - main content
-     * 2. Top layer (lv_layer_top) - popups, dialogs
-     * 3. Sys layer (lv_layer_sys) - system overlays
-     * 
-     * lv_snapshot_take() only captures a single object and its children.
-     * To capture everything, we use lv_snapshot_take on the active screen,
-     * but we need to ensure popups created on lv_scr_act() are included.
-     * 
-     * For popups on lv_layer_top(), we need a different approach:
-     * Use lv_disp_get_layer_top() and composite the layers.
-     * 
-     * Simpler approach: Use lv_snapshot_take_to_buf with the display's draw buffer
-     * or capture the framebuffer directly.
-     * 
-     * Best approach for LVGL v8: Snapshot the active screen which includes
-     * all children (including popups created as children of lv_scr_act()).
-     * For lv_layer_top() popups, we composite them manually.
-     */
-    
-    lv_obj_t *act_scr = lv_scr_act();
-    lv_obj_t *top_layer = lv_disp_get_layer_top(disp);
-    
-    /* Get display dimensions */
-    lv_coord_t disp_w = lv_disp_get_hor_res(disp);
-    lv_coord_t disp_h = lv_disp_get_ver_res(disp);
-    
-    ESP_LOGI(TAG, "Display size: %dx%d", disp_w, disp_h);
+    ESP_LOGI(TAG, "Taking screenshot...");
+    int64_t start_us = esp_timer_get_time();
 
-    /* First, take snapshot of active screen (includes children like SD card manager UI) */
-    lv_img_dsc_t *scr_snapshot = lv_snapshot_take(act_scr, LV_IMG_CF_TRUE_COLOR);
-    if (scr_snapshot == NULL) {
-        ESP_LOGE(TAG, "Failed to take screen snapshot");
-        show_screenshot_toast(false, NULL);
+    screenshot_job_t *job = heap_caps_calloc(1, sizeof(screenshot_job_t), MALLOC_CAP_SPIRAM);
+    if (job == NULL) {
+        show_screenshot_toast(false, LV_SYMBOL_CLOSE " Screenshot Failed - No Memory");
         return ESP_ERR_NO_MEM;
     }
-
-    int width = scr_snapshot->header.w;
-    int height = scr_snapshot->header.h;
-    size_t rgb_size = width * height * 3;
-    
-    uint8_t *rgb_data = heap_caps_malloc(rgb_size, MALLOC_CAP_SPIRAM);
-    if (rgb_data == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate RGB buffer");
-        lv_snapshot_free(scr_snapshot);
-        show_screenshot_toast(false, NULL);
+    job->start_us = start_us;
+    job->on_done = on_done;
+    job->cb_user = cb_user;
+
+    /*
+     * lv_snapshot_take() only captures a single object and its children, so
+     * popups on lv_layer_top() are snapshotted separately and composited while
+     * the rows are encoded. Only the snapshots (raw RGB565) are taken here;
+     * compositing, encoding and the SD write run in the storage writer task.
+     */
+    lv_obj_t *target = (screen != NULL) ? screen : lv_scr_act();
+    job->screen = snapshot_to_psram(target, &job->width, &job->height);
+    if (job->screen == NULL) {
+        ESP_LOGE(TAG, "Failed to take screen snapshot");
+        heap_caps_free(job);
+        show_screenshot_toast(false, LV_SYMBOL_CLOSE " Screenshot Failed - No Memory");
         return ESP_ERR_NO_MEM;
     }
 
-    /* Convert RGB565 to RGB888 */
-    const uint16_t *src = (const uint16_t *)scr_snapshot->data;
-    for (int i = 0; i < width * height; i++) {
-        uint16_t pixel = src[i];
-        uint8_t r = ((pixel >> 11) & 0x1F) << 3;
-        uint8_t g = ((pixel >> 5) & 0x3F) << 2;
-        uint8_t b = (pixel & 0x1F) << 3;
-        rgb_data[i * 3 + 0] = r;
-        rgb_data[i * 3 + 1] = g;
-        rgb_data[i * 3 + 2] = b;
-    }
-
-    lv_snapshot_free(scr_snapshot);
-
     /* Check if top layer has visible children (popups on lv_layer_top) */
+    lv_obj_t *top_layer = lv_disp_get_layer_top(disp);
     uint32_t top_child_cnt = lv_obj_get_child_cnt(top_layer);
-    if (top_child_cnt > 0) {
+    if (screen == NULL && top_child_cnt > 0) {
         ESP_LOGI(TAG, "Top layer has %lu children, compositing...", (unsigned long)top_child_cnt);
-        
-        /* Take snapshot of top layer */
-        lv_img_dsc_t *top_snapshot = lv_snapshot_take(top_layer, LV_IMG_CF_TRUE_COLOR);
-        if (top_snapshot != NULL) {
-            /* Composite top layer onto screen snapshot */
-            const uint16_t *top_src = (const uint16_t *)top_snapshot->data;
-            int top_w = top_snapshot->header.w;
-            int top_h = top_snapshot->header.h;
-            
-            /* Simple alpha blending - top layer pixels that are not transparent */
-            for (int y = 0; y < top_h && y < height; y++) {
-                for (int x = 0; x < top_w && x < width; x++) {
-                    int idx = y * top_w + x;
-                    uint16_t pixel = top_src[idx];
-                    
-                    /* Skip fully transparent pixels (black with 0 alpha in RGB565 is 0x0000) */
-                    /* For simplicity, we check if pixel is not the default background */
-                    /* A more accurate approach would use ARGB8888 format */
-                    if (pixel != 0x0000) {
-                        uint8_t r = ((pixel >> 11) & 0x1F) << 3;
-                        uint8_t g = ((pixel >> 5) & 0x3F) << 2;
-                        uint8_t b = (pixel & 0x1F) << 3;
-                        
-                        int dst_idx = (y * width + x) * 3;
-                        rgb_data[dst_idx + 0] = r;
-                        rgb_data[dst_idx + 1] = g;
-                        rgb_data[dst_idx + 2] = b;
-                    }
-                }
-            }
-            
-            lv_snapshot_free(top_snapshot);
-            ESP_LOGI(TAG, "Top layer composited");
+        job->top = snapshot_to_psram(top_layer, &job->top_width, &job->top_height);
+        if (job->top == NULL) {
+            ESP_LOGW(TAG, "Top layer snapshot failed, saving without it");
+        }
+    }
+
+    /* Encoder in the current format (its PNG state is allocated here, used by the writer) */
+    int level;
+    image_format_t format = screenshot_storage_get_format(&level);
+    esp_err_t ret = image_encoder_init(&job->enc, format, level, job->width, job->height,
+                                       screenshot_row, job);
+    if (ret == ESP_OK && job->top != NULL) {
+        job->row = heap_caps_malloc((size_t)job->width * sizeof(uint16_t),
+                                    MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        if (job->row == NULL) {
+            ret = ESP_ERR_NO_MEM;
         }
     }
 
+    /* Generate filename */
+    if (ret == ESP_OK) {
+        ret = screenshot_storage_generate_filename(job->filename, sizeof(job->filename));
+    }
+
+    storage_writer_job_t wj = {
+        .total_bytes = 0,                   /* Compressed size is not known up front */
+        .fill = screenshot_fill,
+        .finish = screenshot_finish,
+        .user = job,
+        .on_done = screenshot_done,
+        .cb_user = job,
+    };
+    if (ret == ESP_OK) {
+        screenshot_storage_get_path(job->filename, wj.path, sizeof(wj.path));
+        ret = storage_writer_submit(&wj);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to queue screenshot: %s", esp_err_to_name(ret));
+        image_encoder_deinit(&job->enc);
+        heap_caps_free(job->screen);
+        heap_caps_free(job->top);
+        heap_caps_free(job->row);
+        heap_caps_free(job);
+        show_screenshot_toast(false, LV_SYMBOL_CLOSE " Screenshot Failed");
+        return ret;
+    }
+
+    g_job = job;
+    job->capture_us = esp_timer_get_time() - start_us;
+    ESP_LOGI(TAG, "Screenshot captured in %lld ms (%dx%d), saving %s in background",
+             job->capture_us / 1000, job->width, job->height, job->filename);
+
     /* Show flash effect */
     lv_obj_t *flash = lv_obj_create(lv_scr_act());
     if (flash != NULL) {
@@ -421,20 +541,16 @@ esp_err_t screenshot_take(lv_obj_t *screen)
         lv_obj_del_delayed(flash, 100);
     }
 
-    /* Save to SD card */
-    ret = screenshot_storage_save(rgb_data, width, height, filename);
-    heap_caps_free(rgb_data);
-
-    if (ret == ESP_OK) {
-        ESP_LOGI(TAG, "Screenshot saved: %s", filename);
-        show_screenshot_toast(true, filename);
-    } else {
-        ESP_LOGE(TAG, "Failed to save screenshot");
-        show_screenshot_toast(false, NULL);
-        }
+    return ESP_OK;
+}
 
-        return ret;
-    }
+/**
+ * @brief Check whether a screenshot is still being written
+ */
+bool screenshot_is_busy(void)
+{
+    return g_job != NULL;
+}
 
 /**
  * @brief Get last screenshot path
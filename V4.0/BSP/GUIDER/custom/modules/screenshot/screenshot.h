@@ -4,7 +4,12 @@
  * 
  * Takes screenshots and saves them directly to SD card.
  * Triggered by three-finger swipe gesture.
- * Naming: Screenshot_001.bmp, Screenshot_002.bmp, etc.
+ * Naming: Screenshot_001.png, Screenshot_002.png, etc.
+ *
+ * Taking a screenshot only snapshots the display on the LVGL thread; the
+ * file (PNG, QOI or BMP, see screenshot_storage_set_format()) is encoded
+ * and written by the storage writer, and the result toast appears when the
+ * file is complete.
  */
 
 #ifndef __SCREENSHOT_H_
@@ -16,6 +21,7 @@ extern "C" {
 
 #include "lvgl.h"
 #include "esp_err.h"
+#include "storage_writer.h"
 #include <stdbool.h>
 
 /**
@@ -38,6 +44,26 @@ esp_err_t screenshot_deinit(void);
  */
 esp_err_t screenshot_take(lv_obj_t *screen);
 
+/**
+ * @brief Take a screenshot, reporting when the file has been written
+ *
+ * Call from the LVGL thread. Returns once the display has been captured;
+ * the BMP is encoded and written in the background. One screenshot can be
+ * in flight at a time.
+ *
+ * @param screen Screen to capture (NULL for active screen with the top layer)
+ * @param on_done Called on the LVGL thread when the file is written or failed (may be NULL)
+ * @param cb_user Passed to on_done
+ * @return ESP_OK if captured and queued, ESP_ERR_INVALID_STATE while the
+ *         previous one is still being saved, ESP_ERR_NOT_FOUND without SD card
+ */
+esp_err_t screenshot_take_async(lv_obj_t *screen, storage_writer_done_cb on_done, void *cb_user);
+
+/**
+ * @brief Check whether a screenshot is still being written
+ */
+bool screenshot_is_busy(void);
+
 /**
  * @brief Get the path of the last saved screenshot
  */
@@ -3,11 +3,12 @@
  * @brief Screenshot Storage - SD Card Only
  * 
  * Simplified storage that saves screenshots directly to SD card.
- * Naming convention: Screenshot_001.bmp, Screenshot_002.bmp, etc.
+ * Naming convention: Screenshot_001.png, Screenshot_002.png, etc.
  */
 
 #include "screenshot_storage.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 #include "esp_vfs_fat.h"
 #include "bsp/esp-bsp.h"
 #include "freertos/FreeRTOS.h"
@@ -26,16 +27,17 @@ static const char *TAG = "SCR_STORAGE";
 #define SD_MOUNT_POINT      "/sdcard"
 #define SCREENSHOT_DIR      "/sdcard/Screenshots"
 #define SCREENSHOT_PREFIX   "Screenshot_"
-#define SCREENSHOT_EXT      ".bmp"
 
-/* Screenshot parameters */
-#define SCREENSHOT_BPP      3   /* 24-bit RGB */
+/* screenshot_storage_save() output buffer (grown to the encoder's minimum for wide images) */
+#define SAVE_BUFFER_SIZE    (16 * 1024)
 
 /* State variables */
 static bool g_initialized = false;
 static bool g_sd_available = false;
 static int g_screenshot_count = 0;
 static int g_next_number = 1;  /* Next screenshot number */
+static image_format_t g_format = IMAGE_FORMAT_PNG;
+static int g_png_level = IMAGE_CODEC_PNG_LEVEL;
 
 /* Screenshot list cache */
 #define MAX_CACHED_SCREENSHOTS 100
@@ -49,6 +51,7 @@ static SemaphoreHandle_t g_mutex = NULL;
 static esp_err_t ensure_screenshot_dir(void);
 static esp_err_t scan_screenshots(void);
 static int get_next_screenshot_number(void);
+static void add_to_cache(const char *filename, uint32_t size);
 
 esp_err_t screenshot_storage_init(void)
 {
@@ -140,9 +143,10 @@ static esp_err_t scan_screenshots(void)
 
     struct dirent *entry;
     while ((entry = readdir(dir)) != NULL && g_cache_count < MAX_CACHED_SCREENSHOTS) {
-        /* Check if it's a screenshot file */
+        /* Check if it's a screenshot file (any format) */
+        image_format_t format;
         if (strncmp(entry->d_name, SCREENSHOT_PREFIX, strlen(SCREENSHOT_PREFIX)) == 0 &&
-            strstr(entry->d_name, SCREENSHOT_EXT) != NULL) {
+            image_format_from_path(entry->d_name, &format)) {
             
             /* Extract number from filename */
             int num = 0;
@@ -199,7 +203,7 @@ esp_err_t screenshot_storage_generate_filename(char *filename, size_t size)
     }
     
     int num = get_next_screenshot_number();
-    snprintf(filename, size, "%s%03d%s", SCREENSHOT_PREFIX, num, SCREENSHOT_EXT);
+    snprintf(filename, size, "%s%03d%s", SCREENSHOT_PREFIX, num, image_format_ext(g_format));
     return ESP_OK;
 }
 
@@ -212,10 +216,83 @@ esp_err_t screenshot_storage_get_path(const char *filename, char *path, size_t s
     return ESP_OK;
 }
 
+/**
+ * @brief Record a new file in the cache (mutex held)
+ */
+static void add_to_cache(const char *filename, uint32_t size)
+{
+    if (g_cache_count < MAX_CACHED_SCREENSHOTS) {
+        snprintf(g_screenshot_cache[g_cache_count].filename,
+                 sizeof(g_screenshot_cache[g_cache_count].filename), "%s", filename);
+        g_screenshot_cache[g_cache_count].size = size;
+        g_screenshot_cache[g_cache_count].timestamp = time(NULL);
+        g_screenshot_cache[g_cache_count].location = STORAGE_SD;
+        g_cache_count++;
+    }
+    
+    g_screenshot_count++;
+}
+
+/**
+ * @brief Choose the format of new screenshots
+ */
+esp_err_t screenshot_storage_set_format(image_format_t format, int level)
+{
+    if ((unsigned)format >= IMAGE_FORMAT_COUNT || level < 0 || level > IMAGE_DEFLATE_MAX_LEVEL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    g_format = format;
+    g_png_level = level;
+    ESP_LOGI(TAG, "Screenshot format: %s (level %d)", image_format_name(format), level);
+    return ESP_OK;
+}
+
+/**
+ * @brief Get the format of new screenshots
+ */
+image_format_t screenshot_storage_get_format(int *level)
+{
+    if (level != NULL) {
+        *level = g_png_level;
+    }
+    return g_format;
+}
+
+/**
+ * @brief Add a screenshot written elsewhere to the list
+ */
+esp_err_t screenshot_storage_add(const char *filename, uint32_t size)
+{
+    if (filename == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (g_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(g_mutex, portMAX_DELAY);
+    add_to_cache(filename, size);
+    xSemaphoreGive(g_mutex);
+    return ESP_OK;
+}
+
+/* Row source for screenshot_storage_save() */
+typedef struct {
+    const uint16_t *data;
+    int width;
+} save_source_t;
+
+static const uint16_t *save_row(void *user, int y)
+{
+    const save_source_t *src = (const save_source_t *)user;
+    return src->data + (size_t)y * src->width;
+}
+
 /**
  * @brief Save screenshot data to SD card
  */
-esp_err_t screenshot_storage_save(const uint8_t *data, int width, int height, const char *filename)
+esp_err_t screenshot_storage_save(const uint16_t *data, int width, int height, const char *filename)
 {
     if (!g_sd_available) {
         ESP_LOGE(TAG, "SD card not available");
@@ -226,108 +303,76 @@ esp_err_t screenshot_storage_save(const uint8_t *data, int width, int height, co
         return ESP_ERR_INVALID_ARG;
     }
 
+    image_format_t format;
+    if (!image_format_from_path(filename, &format)) {
+        format = g_format;
+    }
+
+    save_source_t src = { .data = data, .width = width };
+    image_encoder_t enc;
+    esp_err_t ret = image_encoder_init(&enc, format, g_png_level, width, height, save_row, &src);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    size_t buf_size = image_encoder_min_buffer(&enc);
+    if (buf_size < SAVE_BUFFER_SIZE) {
+        buf_size = SAVE_BUFFER_SIZE;
+    }
+    uint8_t *buf = heap_caps_malloc(buf_size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (buf == NULL) {
+        image_encoder_deinit(&enc);
+        return ESP_ERR_NO_MEM;
+    }
+
     xSemaphoreTake(g_mutex, portMAX_DELAY);
     
     /* Construct full path */
     char filepath[256];
     snprintf(filepath, sizeof(filepath), "%s/%s", SCREENSHOT_DIR, filename);
 
-    ESP_LOGI(TAG, "Saving screenshot: %s (%dx%d)", filepath, width, height);
+    ESP_LOGI(TAG, "Saving screenshot: %s (%dx%d %s)", filepath, width, height, image_format_name(format));
 
     /* Open file */
     FILE *f = fopen(filepath, "wb");
     if (f == NULL) {
         ESP_LOGE(TAG, "Failed to open file: %s", strerror(errno));
-        xSemaphoreGive(g_mutex);
-        return ESP_FAIL;
-    }
-
-    /* Calculate sizes */
-    int row_size = ((width * 3 + 3) / 4) * 4;  /* Row size must be multiple of 4 */
-    int image_size = row_size * height;
-    int file_size = 54 + image_size;  /* BMP header + image data */
-
-    /* Write BMP header */
-    uint8_t bmp_header[54] = {
-        /* BMP file header (14 bytes) */
-        'B', 'M',                           /* Signature */
-        file_size & 0xFF,                   /* File size */
-        (file_size >> 8) & 0xFF,
-        (file_size >> 16) & 0xFF,
-        (file_size >> 24) & 0xFF,
-        0, 0, 0, 0,                         /* Reserved */
-        54, 0, 0, 0,                        /* Data offset */
-        
-        /* DIB header (40 bytes) */
-        40, 0, 0, 0,                        /* Header size */
-        width & 0xFF,                       /* Width */
-        (width >> 8) & 0xFF,
-        (width >> 16) & 0xFF,
-        (width >> 24) & 0xFF,
-        height & 0xFF,                      /* Height (positive = bottom-up) */
-        (height >> 8) & 0xFF,
-        (height >> 16) & 0xFF,
-        (height >> 24) & 0xFF,
-        1, 0,                               /* Planes */
-        24, 0,                              /* Bits per pixel */
-        0, 0, 0, 0,                         /* Compression (none) */
-        image_size & 0xFF,                  /* Image size */
-        (image_size >> 8) & 0xFF,
-        (image_size >> 16) & 0xFF,
-        (image_size >> 24) & 0xFF,
-        0x13, 0x0B, 0, 0,                   /* X pixels per meter */
-        0x13, 0x0B, 0, 0,                   /* Y pixels per meter */
-        0, 0, 0, 0,                         /* Colors in color table */
-        0, 0, 0, 0,                         /* Important colors */
-    };
-
-    fwrite(bmp_header, 1, 54, f);
-
-    /* Write image data (bottom-up, BGR format) */
-    uint8_t *row_buffer = malloc(row_size);
-    if (row_buffer == NULL) {
-        fclose(f);
-        xSemaphoreGive(g_mutex);
-        return ESP_ERR_NO_MEM;
+        ret = ESP_FAIL;
     }
 
-    for (int y = height - 1; y >= 0; y--) {
-        const uint8_t *src_row = data + y * width * 3;
-        
-        /* Convert RGB to BGR */
-        for (int x = 0; x < width; x++) {
-            row_buffer[x * 3 + 0] = src_row[x * 3 + 2];  /* B */
-            row_buffer[x * 3 + 1] = src_row[x * 3 + 1];  /* G */
-            row_buffer[x * 3 + 2] = src_row[x * 3 + 0];  /* R */
+    /* Encode and write a buffer at a time */
+    while (ret == ESP_OK) {
+        size_t len = 0;
+        ret = image_encoder_fill(&enc, buf, buf_size, &len);
+        if (ret != ESP_OK || len == 0) {
+            break;
         }
-        
-        /* Pad row to multiple of 4 bytes */
-        for (int i = width * 3; i < row_size; i++) {
-            row_buffer[i] = 0;
+        if (fwrite(buf, 1, len, f) != len) {
+            ESP_LOGE(TAG, "Write failed: %s", strerror(errno));
+            ret = ESP_FAIL;
         }
-        
-        fwrite(row_buffer, 1, row_size, f);
     }
 
-    free(row_buffer);
-    fclose(f);
+    if (f != NULL && fclose(f) != 0 && ret == ESP_OK) {
+        ret = ESP_FAIL;
+    }
 
-    /* Update cache */
-    if (g_cache_count < MAX_CACHED_SCREENSHOTS) {
-        strncpy(g_screenshot_cache[g_cache_count].filename, filename,
-                sizeof(g_screenshot_cache[g_cache_count].filename) - 1);
-        g_screenshot_cache[g_cache_count].size = file_size;
-        g_screenshot_cache[g_cache_count].timestamp = time(NULL);
-        g_screenshot_cache[g_cache_count].location = STORAGE_SD;
-        g_cache_count++;
+    uint32_t file_size = (uint32_t)image_encoder_bytes(&enc);
+    if (ret == ESP_OK) {
+        add_to_cache(filename, file_size);
+    } else if (f != NULL) {
+        remove(filepath);
     }
-    
-    g_screenshot_count++;
-    
+
     xSemaphoreGive(g_mutex);
-    
-    ESP_LOGI(TAG, "Screenshot saved: %s (%d bytes)", filename, file_size);
-    return ESP_OK;
+
+    heap_caps_free(buf);
+    image_encoder_deinit(&enc);
+
+    if (ret == ESP_OK) {
+        ESP_LOGI(TAG, "Screenshot saved: %s (%lu bytes)", filename, (unsigned long)file_size);
+    }
+    return ret;
 }
 
 /**
@@ -3,7 +3,9 @@
  * @brief Screenshot Storage - SD Card Only
  * 
  * Simplified storage that saves screenshots directly to SD card.
- * Naming convention: Screenshot_001.bmp, Screenshot_002.bmp, etc.
+ * Naming convention: Screenshot_001.png, Screenshot_002.png, etc.; the
+ * extension follows the format set with screenshot_storage_set_format()
+ * (PNG by default, QOI or BMP) and files of all three are listed.
  */
 
 #ifndef SCREENSHOT_STORAGE_H
@@ -14,6 +16,7 @@ extern "C" {
 #endif
 
 #include "esp_err.h"
+#include "image_codec.h"
 #include <stdbool.h>
 #include <stdint.h>
 #include <time.h>
@@ -56,7 +59,8 @@ esp_err_t screenshot_storage_deinit(void);
 /**
  * @brief Generate a new screenshot filename
  * 
- * Generates filename with format: Screenshot_001.bmp
+ * Generates filename with format: Screenshot_001.png (extension of the
+ * current format)
  * 
  * @param filename Buffer to store the filename
  * @param size Buffer size
@@ -76,14 +80,46 @@ esp_err_t screenshot_storage_get_path(const char *filename, char *path, size_t s
 
 /**
  * @brief Save screenshot data to SD card
+ *
+ * Encodes in the format named by the filename's extension (the current
+ * format if it has none of .bmp/.qoi/.png) through a small row buffer.
  * 
- * @param data RGB888 image data
+ * @param data RGB565 image data, top row first
  * @param width Image width
  * @param height Image height
  * @param filename Filename to save as
  * @return ESP_OK on success
  */
-esp_err_t screenshot_storage_save(const uint8_t *data, int width, int height, const char *filename);
+esp_err_t screenshot_storage_save(const uint16_t *data, int width, int height, const char *filename);
+
+/**
+ * @brief Choose the format of new screenshots
+ *
+ * @param format IMAGE_FORMAT_PNG (default), IMAGE_FORMAT_QOI or IMAGE_FORMAT_BMP
+ * @param level PNG compression level 0..IMAGE_DEFLATE_MAX_LEVEL (default IMAGE_CODEC_PNG_LEVEL)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG
+ */
+esp_err_t screenshot_storage_set_format(image_format_t format, int level);
+
+/**
+ * @brief Get the format of new screenshots
+ *
+ * @param level PNG compression level (may be NULL)
+ * @return Format
+ */
+image_format_t screenshot_storage_get_format(int *level);
+
+/**
+ * @brief Add a screenshot written by someone else to the list
+ *
+ * Used when the file is encoded and written in the background
+ * (storage_writer) instead of by screenshot_storage_save().
+ *
+ * @param filename Screenshot filename (in the screenshot directory)
+ * @param size File size in bytes
+ * @return ESP_OK on success
+ */
+esp_err_t screenshot_storage_add(const char *filename, uint32_t size);
 
 /**
  * @brief Delete a screenshot
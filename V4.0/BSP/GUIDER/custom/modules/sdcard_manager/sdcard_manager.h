@@ -37,7 +37,7 @@ extern "C" {
  */
 typedef enum {
     SDCARD_FILE_TYPE_UNKNOWN = 0,
-    SDCARD_FILE_TYPE_SCREENSHOT,    /* .bmp files in Screenshots folder */
+    SDCARD_FILE_TYPE_SCREENSHOT,    /* Images in Screenshots folder */
     SDCARD_FILE_TYPE_OSCILLOSCOPE,  /* .csv files in Oscilloscope folder */
     SDCARD_FILE_TYPE_CONFIG,        /* Configuration files */
     SDCARD_FILE_TYPE_MEDIA,         /* Media files (video/audio) in Media folder */
@@ -824,6 +824,7 @@ static bool is_media_file(const char *filename)
     if (strcasecmp(ext, ".avi") == 0 ||
         strcasecmp(ext, ".png") == 0 ||
         strcasecmp(ext, ".bmp") == 0 ||
+        strcasecmp(ext, ".qoi") == 0 ||
         strcasecmp(ext, ".jpg") == 0 ||
         strcasecmp(ext, ".jpeg") == 0) {
         return true;
@@ -1132,6 +1133,7 @@ static void refresh_file_list(void)
             const char *ext = strrchr(g_files[i].name, '.');
             if (ext) {
                 if (strcasecmp(ext, ".png") == 0 || strcasecmp(ext, ".bmp") == 0 || 
+                    strcasecmp(ext, ".qoi") == 0 ||
                     strcasecmp(ext, ".jpg") == 0 || strcasecmp(ext, ".jpeg") == 0) {
                     file_icon = LV_SYMBOL_IMAGE;
                     file_ic = COLOR_SCREENSHOT;
@@ -1570,15 +1572,14 @@ static void file_item_clicked(lv_event_t *e)
         filepath[sizeof(filepath) - 1] = '\0';
         
         /* Check if format is supported before playing */
-        media_type_t mtype = media_player_get_type(filepath);
-        if (mtype != MEDIA_TYPE_BMP && mtype != MEDIA_TYPE_AVI) {
+        if (!media_player_is_supported(filepath)) {
             /* Show unsupported format message */
             ESP_LOGW(TAG, "Unsupported format: %s", filepath);
             
             /* Create a simple message box */
             static const char *btns[] = {"OK", ""};
             lv_obj_t *msgbox = lv_msgbox_create(NULL, "Unsupported", 
-                                       "Only BMP and AVI supported", 
+                                       "Only BMP, PNG, QOI and AVI supported", 
                                        btns, true);
             lv_obj_center(msgbox);
             return;
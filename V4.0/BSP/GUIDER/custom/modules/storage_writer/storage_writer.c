@@ -0,0 +1,400 @@
+/**
+ * @file storage_writer.c
+ * @brief Background SD card writer implementation
+ */
+
+#include "storage_writer.h"
+#include "lvgl.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+static const char *TAG = "STORAGE_WRITER";
+
+#define WRITER_TASK_STACK       6144    // Fill functions format text (snprintf)
+#define WRITER_TASK_PRIORITY    3
+#define IO_TASK_STACK           4096
+#define IO_TASK_PRIORITY        4       // Above the writer: keep the card busy
+#define DRAIN_PERIOD_MS         50
+#define JOB_STOP                0xFF    // Job queue sentinel
+
+/* Job slot */
+typedef enum {
+    SLOT_FREE = 0,
+    SLOT_QUEUED,
+    SLOT_RUNNING,
+    SLOT_DONE,                  // Waiting for the LVGL thread to report it
+} slot_state_t;
+
+typedef struct {
+    storage_writer_job_t job;
+    slot_state_t state;
+    uint64_t bytes_done;
+    uint64_t bytes_reported;
+    esp_err_t result;
+} writer_slot_t;
+
+/* Block handed to the I/O task (buf < 0: sync and close the file) */
+typedef struct {
+    FILE *f;                    // NULL: stop the I/O task
+    int8_t buf;
+    uint8_t slot;
+    uint32_t len;
+} io_block_t;
+
+/* State */
+static bool g_running = false;
+static writer_slot_t g_slots[STORAGE_WRITER_MAX_JOBS];
+static portMUX_TYPE g_lock = portMUX_INITIALIZER_UNLOCKED;
+static storage_writer_stats_t g_stats;
+
+static uint8_t *g_buf[2];
+static size_t g_buf_size = 0;
+
+static QueueHandle_t g_job_queue = NULL;       // Slot indices
+static QueueHandle_t g_free_bufs = NULL;       // Buffer indices ready to fill
+static QueueHandle_t g_full_bufs = NULL;       // io_block_t ready to write
+static SemaphoreHandle_t g_io_done = NULL;     // File closed by the I/O task
+static SemaphoreHandle_t g_stopped = NULL;     // Writer task has exited
+static volatile esp_err_t g_io_result = ESP_OK;
+static lv_timer_t *g_drain_timer = NULL;
+
+/**
+ * @brief Allocate one transfer buffer (DMA-capable internal RAM first, PSRAM otherwise)
+ */
+static uint8_t *alloc_buffer(size_t size)
+{
+    uint8_t *buf = heap_caps_aligned_alloc(64, size, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (buf == NULL) {
+        buf = heap_caps_aligned_alloc(64, size, MALLOC_CAP_SPIRAM);
+    }
+    return buf;
+}
+
+/**
+ * @brief I/O task: write filled buffers, sync and close at the end of each file
+ */
+static void io_task(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        io_block_t block;
+        xQueueReceive(g_full_bufs, &block, portMAX_DELAY);
+        if (block.f == NULL) {
+            break;
+        }
+
+        if (block.buf >= 0) {
+            if (g_io_result == ESP_OK && fwrite(g_buf[block.buf], 1, block.len, block.f) != block.len) {
+                ESP_LOGE(TAG, "Write failed: %s", strerror(errno));
+                g_io_result = ESP_FAIL;
+            }
+            portENTER_CRITICAL(&g_lock);
+            g_slots[block.slot].bytes_done += block.len;
+            portEXIT_CRITICAL(&g_lock);
+            uint8_t index = (uint8_t)block.buf;
+            xQueueSend(g_free_bufs, &index, portMAX_DELAY);
+        } else {
+            // One sync per file, after its last block
+            if (fflush(block.f) != 0 || fsync(fileno(block.f)) != 0) {
+                g_io_result = ESP_FAIL;
+            }
+            if (fclose(block.f) != 0) {
+                g_io_result = ESP_FAIL;
+            }
+            xSemaphoreGive(g_io_done);
+        }
+    }
+
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Run one job: fill one buffer while the I/O task writes the other
+ */
+static esp_err_t run_job(uint8_t slot_index)
+{
+    storage_writer_job_t *job = &g_slots[slot_index].job;
+
+    FILE *f = fopen(job->path, "wb");
+    if (f == NULL) {
+        ESP_LOGE(TAG, "Failed to create %s: %s", job->path, strerror(errno));
+        return ESP_FAIL;
+    }
+    // Blocks are already large; stdio buffering would only add a copy
+    setvbuf(f, NULL, _IONBF, 0);
+
+    g_io_result = ESP_OK;
+    esp_err_t ret = ESP_OK;
+    while (g_io_result == ESP_OK) {
+        uint8_t index;
+        xQueueReceive(g_free_bufs, &index, portMAX_DELAY);
+
+        size_t len = 0;
+        ret = job->fill(job->user, g_buf[index], g_buf_size, &len);
+        if (ret != ESP_OK || len == 0) {
+            xQueueSend(g_free_bufs, &index, portMAX_DELAY);
+            break;
+        }
+
+        io_block_t block = { .f = f, .buf = (int8_t)index, .slot = slot_index, .len = (uint32_t)len };
+        xQueueSend(g_full_bufs, &block, portMAX_DELAY);
+    }
+
+    io_block_t close_block = { .f = f, .buf = -1, .slot = slot_index };
+    xQueueSend(g_full_bufs, &close_block, portMAX_DELAY);
+    xSemaphoreTake(g_io_done, portMAX_DELAY);
+
+    if (ret == ESP_OK) {
+        ret = g_io_result;
+    }
+    if (ret != ESP_OK) {
+        remove(job->path);
+    }
+    return ret;
+}
+
+/**
+ * @brief Writer task: take jobs in order
+ */
+static void writer_task(void *arg)
+{
+    (void)arg;
+
+    for (;;) {
+        uint8_t slot_index;
+        xQueueReceive(g_job_queue, &slot_index, portMAX_DELAY);
+        if (slot_index == JOB_STOP) {
+            break;
+        }
+
+        writer_slot_t *slot = &g_slots[slot_index];
+        portENTER_CRITICAL(&g_lock);
+        slot->state = SLOT_RUNNING;
+        portEXIT_CRITICAL(&g_lock);
+
+        int64_t t_start = esp_timer_get_time();
+        esp_err_t ret = run_job(slot_index);
+        int64_t elapsed_us = esp_timer_get_time() - t_start;
+
+        if (slot->job.finish != NULL) {
+            slot->job.finish(slot->job.user, ret, slot->job.path);
+        }
+
+        portENTER_CRITICAL(&g_lock);
+        if (ret == ESP_OK) {
+            g_stats.jobs_done++;
+        } else {
+            g_stats.jobs_failed++;
+        }
+        g_stats.bytes_written += slot->bytes_done;
+        g_stats.last_kbps = (elapsed_us > 0) ? (uint32_t)(slot->bytes_done * 1000000ULL / 1024 / elapsed_us) : 0;
+        slot->result = ret;
+        slot->state = SLOT_DONE;
+        portEXIT_CRITICAL(&g_lock);
+
+        ESP_LOGI(TAG, "%s: %llu bytes in %lld ms (%s)", slot->job.path, slot->bytes_done,
+                 elapsed_us / 1000, esp_err_to_name(ret));
+    }
+
+    io_block_t stop = { .f = NULL };
+    xQueueSend(g_full_bufs, &stop, portMAX_DELAY);
+    xSemaphoreGive(g_stopped);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief LVGL timer: report progress and completions on the LVGL thread
+ */
+static void drain_timer_cb(lv_timer_t *timer)
+{
+    (void)timer;
+
+    for (int i = 0; i < STORAGE_WRITER_MAX_JOBS; i++) {
+        writer_slot_t *slot = &g_slots[i];
+
+        portENTER_CRITICAL(&g_lock);
+        slot_state_t state = slot->state;
+        uint64_t bytes_done = slot->bytes_done;
+        portEXIT_CRITICAL(&g_lock);
+
+        if (state != SLOT_RUNNING && state != SLOT_DONE) continue;
+
+        if (slot->job.on_progress != NULL && bytes_done != slot->bytes_reported) {
+            slot->bytes_reported = bytes_done;
+            slot->job.on_progress(slot->job.cb_user, bytes_done, slot->job.total_bytes);
+        }
+
+        if (state == SLOT_DONE) {
+            if (slot->job.on_done != NULL) {
+                slot->job.on_done(slot->job.cb_user, slot->result, slot->job.path);
+            }
+            portENTER_CRITICAL(&g_lock);
+            slot->state = SLOT_FREE;
+            portEXIT_CRITICAL(&g_lock);
+        }
+    }
+}
+
+/**
+ * @brief Release queues, semaphores and buffers
+ */
+static void free_resources(void)
+{
+    if (g_job_queue) { vQueueDelete(g_job_queue); g_job_queue = NULL; }
+    if (g_free_bufs) { vQueueDelete(g_free_bufs); g_free_bufs = NULL; }
+    if (g_full_bufs) { vQueueDelete(g_full_bufs); g_full_bufs = NULL; }
+    if (g_io_done) { vSemaphoreDelete(g_io_done); g_io_done = NULL; }
+    if (g_stopped) { vSemaphoreDelete(g_stopped); g_stopped = NULL; }
+    for (int i = 0; i < 2; i++) {
+        if (g_buf[i]) { heap_caps_free(g_buf[i]); g_buf[i] = NULL; }
+    }
+}
+
+esp_err_t storage_writer_init(size_t buffer_size)
+{
+    if (g_running) {
+        return ESP_OK;
+    }
+
+    g_buf_size = (buffer_size > 0) ? buffer_size : STORAGE_WRITER_DEFAULT_BUFFER;
+    memset(g_slots, 0, sizeof(g_slots));
+    memset(&g_stats, 0, sizeof(g_stats));
+
+    g_buf[0] = alloc_buffer(g_buf_size);
+    g_buf[1] = alloc_buffer(g_buf_size);
+    g_job_queue = xQueueCreate(STORAGE_WRITER_MAX_JOBS + 1, sizeof(uint8_t));
+    g_free_bufs = xQueueCreate(2, sizeof(uint8_t));
+    g_full_bufs = xQueueCreate(3, sizeof(io_block_t));
+    g_io_done = xSemaphoreCreateBinary();
+    g_stopped = xSemaphoreCreateBinary();
+    if (g_buf[0] == NULL || g_buf[1] == NULL || g_job_queue == NULL || g_free_bufs == NULL ||
+        g_full_bufs == NULL || g_io_done == NULL || g_stopped == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate writer resources (%u byte buffers)", (unsigned)g_buf_size);
+        free_resources();
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (uint8_t i = 0; i < 2; i++) {
+        xQueueSend(g_free_bufs, &i, 0);
+    }
+
+    if (xTaskCreate(io_task, "storage_io", IO_TASK_STACK, NULL, IO_TASK_PRIORITY, NULL) != pdPASS) {
+        free_resources();
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(writer_task, "storage_writer", WRITER_TASK_STACK, NULL, WRITER_TASK_PRIORITY, NULL) != pdPASS) {
+        io_block_t stop = { .f = NULL };
+        xQueueSend(g_full_bufs, &stop, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(10));
+        free_resources();
+        return ESP_ERR_NO_MEM;
+    }
+
+    g_drain_timer = lv_timer_create(drain_timer_cb, DRAIN_PERIOD_MS, NULL);
+    g_running = true;
+
+    ESP_LOGI(TAG, "Storage writer started (2 x %u byte buffers)", (unsigned)g_buf_size);
+    return ESP_OK;
+}
+
+void storage_writer_deinit(void)
+{
+    if (!g_running) {
+        return;
+    }
+    g_running = false;
+
+    // Queued jobs complete first
+    uint8_t stop = JOB_STOP;
+    xQueueSend(g_job_queue, &stop, portMAX_DELAY);
+    xSemaphoreTake(g_stopped, portMAX_DELAY);
+    vTaskDelay(pdMS_TO_TICKS(10));  // Let the I/O task exit
+
+    drain_timer_cb(NULL);
+    if (g_drain_timer != NULL) {
+        lv_timer_del(g_drain_timer);
+        g_drain_timer = NULL;
+    }
+    free_resources();
+
+    ESP_LOGI(TAG, "Storage writer stopped");
+}
+
+esp_err_t storage_writer_submit(const storage_writer_job_t *job)
+{
+    if (job == NULL || job->fill == NULL || job->path[0] == '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!g_running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int index = -1;
+    portENTER_CRITICAL(&g_lock);
+    for (int i = 0; i < STORAGE_WRITER_MAX_JOBS; i++) {
+        if (g_slots[i].state == SLOT_FREE) {
+            g_slots[i].job = *job;
+            g_slots[i].bytes_done = 0;
+            g_slots[i].bytes_reported = 0;
+            g_slots[i].result = ESP_OK;
+            g_slots[i].state = SLOT_QUEUED;
+            index = i;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&g_lock);
+
+    if (index < 0) {
+        ESP_LOGW(TAG, "Writer queue full, %s rejected", job->path);
+        return ESP_ERR_NO_MEM;
+    }
+
+    uint8_t slot_index = (uint8_t)index;
+    xQueueSend(g_job_queue, &slot_index, portMAX_DELAY);
+    return ESP_OK;
+}
+
+uint32_t storage_writer_pending(void)
+{
+    uint32_t pending = 0;
+    portENTER_CRITICAL(&g_lock);
+    for (int i = 0; i < STORAGE_WRITER_MAX_JOBS; i++) {
+        if (g_slots[i].state == SLOT_QUEUED || g_slots[i].state == SLOT_RUNNING) {
+            pending++;
+        }
+    }
+    portEXIT_CRITICAL(&g_lock);
+    return pending;
+}
+
+esp_err_t storage_writer_flush(uint32_t timeout_ms)
+{
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (storage_writer_pending() > 0) {
+        if (esp_timer_get_time() > deadline) {
+            return ESP_ERR_TIMEOUT;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    return ESP_OK;
+}
+
+void storage_writer_get_stats(storage_writer_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+    portENTER_CRITICAL(&g_lock);
+    *stats = g_stats;
+    portEXIT_CRITICAL(&g_lock);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file storage_writer.h
+ * @brief Background SD card writer for file exports
+ *
+ * Jobs are queued from the UI and run one after the other. For each job the
+ * writer task calls the job's fill function to format the next block of the
+ * file into one of two large DMA-capable buffers while an I/O task writes
+ * the other one, so formatting and SD latency overlap. The file is synced
+ * once, after its last block. Progress and completion callbacks run on the
+ * LVGL thread (drained by an lv_timer), so they may touch widgets directly.
+ */
+
+#ifndef STORAGE_WRITER_H
+#define STORAGE_WRITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define STORAGE_WRITER_DEFAULT_BUFFER   (32 * 1024)     // Bytes per buffer (two are allocated)
+#define STORAGE_WRITER_MAX_JOBS         8               // Queued + running jobs
+#define STORAGE_WRITER_PATH_MAX         128
+
+/**
+ * @brief Format the next part of the file
+ *
+ * Runs in the writer task.
+ *
+ * @param user Job context
+ * @param buf Output buffer
+ * @param size Capacity of buf
+ * @param len Output: bytes produced, 0 once the file is complete
+ * @return ESP_OK, or an error that aborts the job (the partial file is removed)
+ */
+typedef esp_err_t (*storage_writer_fill_fn)(void *user, uint8_t *buf, size_t size, size_t *len);
+
+/**
+ * @brief Job finished (writer task, after the file is closed): release the job context
+ */
+typedef void (*storage_writer_finish_fn)(void *user, esp_err_t result, const char *path);
+
+/**
+ * @brief Progress report (LVGL thread)
+ */
+typedef void (*storage_writer_progress_cb)(void *user, uint64_t bytes_done, uint64_t bytes_total);
+
+/**
+ * @brief Completion report (LVGL thread), after finish
+ */
+typedef void (*storage_writer_done_cb)(void *user, esp_err_t result, const char *path);
+
+/* Job description (copied on submit) */
+typedef struct {
+    char path[STORAGE_WRITER_PATH_MAX];
+    uint64_t total_bytes;                   // Expected size for progress (0 if unknown)
+    storage_writer_fill_fn fill;            // Required
+    storage_writer_finish_fn finish;        // Optional
+    void *user;                             // Passed to fill and finish
+    storage_writer_progress_cb on_progress; // Optional
+    storage_writer_done_cb on_done;         // Optional
+    void *cb_user;                          // Passed to on_progress and on_done
+} storage_writer_job_t;
+
+/* Writer statistics */
+typedef struct {
+    uint32_t jobs_done;
+    uint32_t jobs_failed;
+    uint64_t bytes_written;
+    uint32_t last_kbps;                     // Throughput of the last job (KB/s, open to close)
+} storage_writer_stats_t;
+
+/**
+ * @brief Start the writer (call from the LVGL thread)
+ *
+ * @param buffer_size Bytes per buffer (0 = STORAGE_WRITER_DEFAULT_BUFFER)
+ * @return ESP_OK on success (also when already started)
+ */
+esp_err_t storage_writer_init(size_t buffer_size);
+
+/**
+ * @brief Stop the writer after the queued jobs (call from the LVGL thread)
+ */
+void storage_writer_deinit(void);
+
+/**
+ * @brief Queue a job
+ *
+ * @param job Job description
+ * @return ESP_OK if queued, ESP_ERR_INVALID_STATE if the writer is not running,
+ *         ESP_ERR_NO_MEM if STORAGE_WRITER_MAX_JOBS are pending
+ */
+esp_err_t storage_writer_submit(const storage_writer_job_t *job);
+
+/**
+ * @brief Number of jobs queued or running
+ */
+uint32_t storage_writer_pending(void);
+
+/**
+ * @brief Block until all queued jobs have finished (not from the LVGL thread)
+ *
+ * @param timeout_ms Longest wait
+ * @return ESP_OK when idle, ESP_ERR_TIMEOUT otherwise
+ */
+esp_err_t storage_writer_flush(uint32_t timeout_ms);
+
+/**
+ * @brief Get writer statistics
+ */
+void storage_writer_get_stats(storage_writer_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STORAGE_WRITER_H */
@@ -0,0 +1,739 @@
+/**
+ * @file lv_terminal.c
+ * @brief Virtualized terminal widget with a fixed-capacity scrollback
+ */
+
+#include "lv_terminal.h"
+#include <ctype.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+#define MY_CLASS &lv_terminal_class
+
+#define TERM_MIN_BYTES      4096
+#define TERM_MIN_ROWS       64
+#define TERM_MAX_COLS       256
+#define TERM_ROW_BYTES_MAX  (TERM_MAX_COLS * 4)     /* Bytes per row, '\r' floods included */
+#define TERM_THROW_GAIN     12                      /* Momentum: pixels per pixel of last drag step */
+#define TERM_THROW_TIME     400
+#define TERM_GLYPH_FIRST    0x20
+#define TERM_GLYPH_LAST     0x7e
+#define TERM_HEX_BYTES_MAX  16
+#define TERM_HEX_WIDTH(n)   (9 + 4 * (n))               /* Cells of "oooooooo hh hh .. ascii" */
+#define TERM_HEX_COL(i)     (9 + 3 * (i))
+#define TERM_ASCII_COL(n, i) (9 + 3 * (n) + (i))
+
+static void lv_terminal_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
+static void lv_terminal_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj);
+static void lv_terminal_event(const lv_obj_class_t * class_p, lv_event_t * e);
+
+const lv_obj_class_t lv_terminal_class = {
+    .constructor_cb = lv_terminal_constructor,
+    .destructor_cb = lv_terminal_destructor,
+    .event_cb = lv_terminal_event,
+    .width_def = LV_DPI_DEF * 3,
+    .height_def = LV_DPI_DEF * 2,
+    .instance_size = sizeof(lv_terminal_t),
+    .base_class = &lv_obj_class
+};
+
+/* Byte -> two hex digits; lowercase digits sit better in a proportional font */
+#define HEX_PAIRS(h) \
+    {h, '0'}, {h, '1'}, {h, '2'}, {h, '3'}, {h, '4'}, {h, '5'}, {h, '6'}, {h, '7'}, \
+    {h, '8'}, {h, '9'}, {h, 'a'}, {h, 'b'}, {h, 'c'}, {h, 'd'}, {h, 'e'}, {h, 'f'}
+
+static const char hex_pair[256][2] = {
+    HEX_PAIRS('0'), HEX_PAIRS('1'), HEX_PAIRS('2'), HEX_PAIRS('3'),
+    HEX_PAIRS('4'), HEX_PAIRS('5'), HEX_PAIRS('6'), HEX_PAIRS('7'),
+    HEX_PAIRS('8'), HEX_PAIRS('9'), HEX_PAIRS('a'), HEX_PAIRS('b'),
+    HEX_PAIRS('c'), HEX_PAIRS('d'), HEX_PAIRS('e'), HEX_PAIRS('f')
+};
+
+static void * term_alloc(size_t size)
+{
+#ifdef ESP_PLATFORM
+    void * p = heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if(p == NULL) p = heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    return p;
+#else
+    return lv_mem_alloc(size);
+#endif
+}
+
+static void term_free(void * p)
+{
+    if(p == NULL) return;
+#ifdef ESP_PLATFORM
+    heap_caps_free(p);
+#else
+    lv_mem_free(p);
+#endif
+}
+
+static uint32_t round_pow2(uint32_t v, uint32_t min)
+{
+    uint32_t n = min;
+    while(n < v) n <<= 1;
+    return n;
+}
+
+static inline uint32_t row_count(const lv_terminal_t * t)
+{
+    return t->buf != NULL ? t->row_last - t->row_first + 1 : 0;
+}
+
+static inline uint32_t row_start(const lv_terminal_t * t, uint32_t serial)
+{
+    return t->rows[serial & (t->row_cap - 1)];
+}
+
+static inline uint32_t row_end(const lv_terminal_t * t, uint32_t serial)
+{
+    return serial == t->row_last ? t->end : row_start(t, serial + 1);
+}
+
+/* Oldest byte in the hex view: the ring may still hold text older than the first row */
+static inline uint32_t hex_first(const lv_terminal_t * t)
+{
+    return t->end - t->hex_origin > t->buf_size ? t->end - t->buf_size : t->hex_origin;
+}
+
+/* Hex rows are hex_bytes slices counted from hex_origin; [begin, end) are kept */
+static inline uint32_t hex_row_begin(const lv_terminal_t * t)
+{
+    return (hex_first(t) - t->hex_origin) / t->hex_bytes;
+}
+
+static inline uint32_t hex_row_end(const lv_terminal_t * t)
+{
+    return (t->end - t->hex_origin + t->hex_bytes - 1) / t->hex_bytes;
+}
+
+/* Rows of the current view and their height */
+static inline uint32_t view_rows(const lv_terminal_t * t)
+{
+    if(t->buf == NULL) return 0;
+    return t->hex ? hex_row_end(t) - hex_row_begin(t) : row_count(t);
+}
+
+static inline int32_t view_cell_h(const lv_terminal_t * t)
+{
+    return t->hex ? t->hex_cell_h : t->cell_h;
+}
+
+static int32_t max_offset(const lv_terminal_t * t)
+{
+    int32_t view_h = lv_obj_get_content_height((lv_obj_t *)t);
+    int32_t content_h = (int32_t)view_rows(t) * view_cell_h(t);
+    return content_h > view_h ? content_h - view_h : 0;
+}
+
+/* Serial of the text row holding the byte at pos */
+static uint32_t row_of(const lv_terminal_t * t, uint32_t pos)
+{
+    uint32_t lo = t->row_first;
+    uint32_t hi = t->row_last;
+    while(lo != hi) {
+        uint32_t mid = lo + (hi - lo + 1) / 2;
+        if((int32_t)(row_start(t, mid) - pos) <= 0) lo = mid;
+        else hi = mid - 1;
+    }
+    return lo;
+}
+
+/* First byte of the bottom row in view */
+static uint32_t view_bottom_pos(const lv_terminal_t * t)
+{
+    uint32_t count = view_rows(t);
+    uint32_t back = (uint32_t)(t->offset / view_cell_h(t));
+    uint32_t idx = back < count ? count - 1 - back : 0;
+    if(!t->hex) return row_start(t, t->row_first + idx);
+
+    uint32_t pos = t->hex_origin + (hex_row_begin(t) + idx) * t->hex_bytes;
+    uint32_t first = hex_first(t);
+    return (int32_t)(pos - first) < 0 ? first : pos;
+}
+
+/* Index in the current view of the row holding the byte at pos */
+static uint32_t view_row_of(const lv_terminal_t * t, uint32_t pos)
+{
+    if(!t->hex) return row_of(t, pos) - t->row_first;
+    return (pos - t->hex_origin) / t->hex_bytes - hex_row_begin(t);
+}
+
+/* Start a row at the current end; a held view moves with its text */
+static inline void new_row(lv_terminal_t * t, bool hold)
+{
+    t->row_last++;
+    t->rows[t->row_last & (t->row_cap - 1)] = t->end;
+    if(t->row_last - t->row_first >= t->row_cap) t->row_first++;
+    t->col = 0;
+    if(hold) t->offset += t->cell_h;
+}
+
+/* Account for the byte at t->end (stored there if store) */
+static inline void put_byte(lv_terminal_t * t, uint8_t c, bool store, bool hold)
+{
+    if(c == '\n') {
+        if(store) t->buf[t->end & (t->buf_size - 1)] = c;
+        t->end++;
+        new_row(t, hold);
+        return;
+    }
+    if(t->end - row_start(t, t->row_last) >= TERM_ROW_BYTES_MAX) {
+        new_row(t, hold);
+    }
+    if(c != '\r') {
+        if(t->col >= t->cols) new_row(t, hold);
+        t->col++;
+    }
+    if(store) t->buf[t->end & (t->buf_size - 1)] = c;
+    t->end++;
+}
+
+/* Drop rows whose text has been overwritten */
+static void evict_rows(lv_terminal_t * t)
+{
+    while(t->row_first != t->row_last && t->end - row_start(t, t->row_first) > t->buf_size) {
+        t->row_first++;
+    }
+    if(t->match_valid && (int32_t)(t->match_row - t->row_first) < 0) t->match_valid = false;
+}
+
+/* Re-wrap the kept text to the current width (size or font change) */
+static void reflow(lv_terminal_t * t)
+{
+    if(t->buf == NULL) return;
+
+    uint32_t pos = row_start(t, t->row_first);
+    uint32_t stop = t->end;
+    t->end = pos;
+    t->row_first = 0;
+    t->row_last = 0;
+    t->rows[0] = pos;
+    t->col = 0;
+    while(t->end != stop) {
+        put_byte(t, t->buf[t->end & (t->buf_size - 1)], false, false);
+    }
+    evict_rows(t);
+    t->offset = 0;
+    t->match_valid = false;
+}
+
+/* Glyph advances and cell size of a part's font; the cell is as wide as the widest of pitch */
+static void measure(lv_obj_t * obj, lv_part_t part, const char * pitch, uint8_t * glyph_w,
+                    lv_coord_t * cell_w, lv_coord_t * cell_h)
+{
+    const lv_font_t * font = lv_obj_get_style_text_font(obj, part);
+
+    for(uint32_t c = TERM_GLYPH_FIRST; c <= TERM_GLYPH_LAST; c++) {
+        uint16_t w = lv_font_get_glyph_width(font, c, 0);
+        glyph_w[c - TERM_GLYPH_FIRST] = (uint8_t)LV_MIN(w, 255);
+    }
+
+    lv_coord_t w = 0;
+    for(; *pitch != '\0'; pitch++) w = LV_MAX(w, glyph_w[*pitch - TERM_GLYPH_FIRST]);
+    *cell_w = w + lv_obj_get_style_text_letter_space(obj, part);
+    *cell_h = lv_font_get_line_height(font) + lv_obj_get_style_text_line_space(obj, part);
+    if(*cell_w < 1) *cell_w = 1;
+    if(*cell_h < 1) *cell_h = 1;
+}
+
+static void update_metrics(lv_obj_t * obj)
+{
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+
+    /* Digits are tabular in most fonts: their advance is the pitch */
+    measure(obj, LV_PART_MAIN, "0", t->glyph_w, &t->cell_w, &t->cell_h);
+    measure(obj, LV_PART_ITEMS, "0123456789abcdef", t->hex_glyph_w, &t->hex_cell_w, &t->hex_cell_h);
+
+    lv_coord_t width = lv_obj_get_content_width(obj);
+    lv_coord_t cols = width / t->cell_w;
+    if(cols < 1) cols = 1;
+    if(cols > TERM_MAX_COLS) cols = TERM_MAX_COLS;
+    if(cols != t->cols) {
+        t->cols = (uint16_t)cols;
+        reflow(t);
+    }
+
+    /* Hex rows: 16 bytes where they fit, else halve down to 4 */
+    uint8_t bytes = TERM_HEX_BYTES_MAX;
+    while(bytes > 4 && TERM_HEX_WIDTH(bytes) * t->hex_cell_w > width) bytes /= 2;
+    if(bytes != t->hex_bytes) {
+        t->hex_bytes = bytes;
+        if(t->hex) t->offset = 0;
+    }
+
+    if(t->offset > max_offset(t)) t->offset = max_offset(t);
+}
+
+/* Row text as drawn, one char per cell; returns the cell count */
+static uint32_t row_text(const lv_terminal_t * t, uint32_t serial, char * out)
+{
+    uint32_t n = 0;
+    uint32_t stop = row_end(t, serial);
+    for(uint32_t p = row_start(t, serial); p != stop; p++) {
+        uint8_t c = t->buf[p & (t->buf_size - 1)];
+        if(c == '\r' || c == '\n') continue;
+        if(c == '\t') c = ' ';
+        else if(c < 0x20 || c >= 0x7f) c = '.';
+        out[n++] = (char)c;
+    }
+    out[n] = '\0';
+    return n;
+}
+
+/* Hex row as drawn, one char per cell: offset, hex pairs, ASCII; returns the cell count */
+static uint32_t hex_line(const lv_terminal_t * t, uint32_t row, char * out)
+{
+    uint32_t n = t->hex_bytes;
+    uint32_t rel = row * n;
+    uint32_t pos = t->hex_origin + rel;
+    uint32_t first = hex_first(t);
+
+    for(uint32_t i = 0; i < 4; i++) {
+        memcpy(out + i * 2, hex_pair[(rel >> (24 - i * 8)) & 0xff], 2);
+    }
+    memset(out + 8, ' ', TERM_HEX_WIDTH(n) - 8);
+
+    /* Bytes already overwritten at the start or not yet received stay blank */
+    for(uint32_t i = 0; i < n; i++, pos++) {
+        if((int32_t)(pos - first) < 0) continue;
+        if(pos == t->end) return TERM_ASCII_COL(n, i);
+        uint8_t c = t->buf[pos & (t->buf_size - 1)];
+        memcpy(out + TERM_HEX_COL(i), hex_pair[c], 2);
+        out[TERM_ASCII_COL(n, i)] = (c < TERM_GLYPH_FIRST || c > TERM_GLYPH_LAST) ? '.' : (char)c;
+    }
+    return TERM_HEX_WIDTH(n);
+}
+
+/* Keep the byte at pos on the bottom row of the view */
+static void show_pos(lv_terminal_t * t, uint32_t pos)
+{
+    uint32_t count = view_rows(t);
+    uint32_t idx = view_row_of(t, pos);
+    int32_t offset = idx < count ? (int32_t)(count - 1 - idx) * view_cell_h(t) : 0;
+    int32_t max = max_offset(t);
+    t->offset = LV_MIN(offset, max);
+}
+
+static void scroll_to(lv_terminal_t * t, int32_t offset)
+{
+    int32_t max = max_offset(t);
+    if(offset > max) offset = max;
+    if(offset < 0) offset = 0;
+    if(offset != t->offset) {
+        t->offset = offset;
+        lv_obj_invalidate((lv_obj_t *)t);
+    }
+}
+
+static void throw_anim_cb(void * var, int32_t v)
+{
+    scroll_to((lv_terminal_t *)var, v);
+}
+
+static void lv_terminal_constructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
+{
+    LV_UNUSED(class_p);
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+
+    /* The scrollback is taller than lv_coord_t allows: the widget scrolls itself */
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_clear_flag(obj, LV_OBJ_FLAG_SCROLL_CHAIN);
+
+    t->buf = NULL;
+    t->rows = NULL;
+    t->cols = 0;
+    t->hex = false;
+    t->hex_bytes = TERM_HEX_BYTES_MAX;
+    t->hex_cell_h = 1;
+    lv_terminal_set_scrollback(obj, LV_TERMINAL_DEFAULT_BYTES, LV_TERMINAL_DEFAULT_ROWS);
+    update_metrics(obj);
+}
+
+static void lv_terminal_destructor(const lv_obj_class_t * class_p, lv_obj_t * obj)
+{
+    LV_UNUSED(class_p);
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+
+    lv_anim_del(t, throw_anim_cb);
+    term_free(t->buf);
+    term_free(t->rows);
+    t->buf = NULL;
+    t->rows = NULL;
+}
+
+static void draw_main(lv_event_t * e)
+{
+    lv_obj_t * obj = lv_event_get_target(e);
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+    lv_draw_ctx_t * draw_ctx = lv_event_get_draw_ctx(e);
+    uint32_t count = view_rows(t);
+    if(count == 0) return;
+
+    lv_area_t content;
+    lv_area_t clip;
+    lv_obj_get_content_coords(obj, &content);
+    if(!_lv_area_intersect(&clip, &content, draw_ctx->clip_area)) return;
+    const lv_area_t * clip_ori = draw_ctx->clip_area;
+    draw_ctx->clip_area = &clip;
+
+    lv_draw_label_dsc_t label_dsc;
+    lv_draw_label_dsc_init(&label_dsc);
+    lv_obj_init_draw_label_dsc(obj, t->hex ? LV_PART_ITEMS : LV_PART_MAIN, &label_dsc);
+
+    /* Rows in view: the newest row sits at the bottom when offset is 0 */
+    int32_t cell_h = view_cell_h(t);
+    int32_t view_h = lv_area_get_height(&content);
+    int32_t content_h = (int32_t)count * cell_h;
+    int32_t top_px = content_h > view_h ? content_h - view_h - t->offset : 0;
+    if(top_px < 0) top_px = 0;
+    uint32_t r = (uint32_t)(top_px / cell_h);
+    lv_coord_t y = content.y1 - (lv_coord_t)(top_px % cell_h);
+
+    for(; t->hex && r < count && y <= clip.y2; r++, y += cell_h) {
+        if(y + cell_h <= clip.y1) continue;
+        uint32_t row = hex_row_begin(t) + r;
+        char line[TERM_HEX_WIDTH(TERM_HEX_BYTES_MAX)];
+        uint32_t cells = hex_line(t, row, line);
+
+        /* Search hit: its bytes in the ASCII column of this row */
+        uint32_t from = t->hex_origin + row * t->hex_bytes;
+        uint32_t hit_end = t->match_pos + t->match_len;
+        if(t->match_valid && (int32_t)(hit_end - from) > 0 && (int32_t)(t->match_pos - (from + t->hex_bytes)) < 0) {
+            uint32_t a = (int32_t)(t->match_pos - from) > 0 ? t->match_pos - from : 0;
+            uint32_t b = LV_MIN(hit_end - from, (uint32_t)t->hex_bytes);
+            lv_draw_rect_dsc_t hit_dsc;
+            lv_draw_rect_dsc_init(&hit_dsc);
+            hit_dsc.bg_color = lv_palette_main(LV_PALETTE_AMBER);
+            lv_area_t hit = {
+                .x1 = content.x1 + TERM_ASCII_COL(t->hex_bytes, a) * t->hex_cell_w, .y1 = y,
+                .x2 = content.x1 + TERM_ASCII_COL(t->hex_bytes, b) * t->hex_cell_w - 1, .y2 = y + cell_h - 1
+            };
+            lv_draw_rect(draw_ctx, &hit_dsc, &hit);
+        }
+
+        lv_coord_t x = content.x1;
+        for(uint32_t i = 0; i < cells && x <= clip.x2; i++, x += t->hex_cell_w) {
+            uint8_t c = (uint8_t)line[i];
+            if(c == ' ' || x + t->hex_cell_w <= clip.x1) continue;
+            lv_point_t pos = { x + (t->hex_cell_w - t->hex_glyph_w[c - TERM_GLYPH_FIRST]) / 2, y };
+            lv_draw_letter(draw_ctx, &label_dsc, &pos, c);
+        }
+    }
+
+    for(; !t->hex && r < count && y <= clip.y2; r++, y += cell_h) {
+        if(y + cell_h <= clip.y1) continue;
+        uint32_t serial = t->row_first + r;
+
+        if(t->match_valid && serial == t->match_row) {
+            lv_draw_rect_dsc_t hit_dsc;
+            lv_draw_rect_dsc_init(&hit_dsc);
+            hit_dsc.bg_color = lv_palette_main(LV_PALETTE_AMBER);
+            lv_area_t hit = {
+                .x1 = content.x1 + t->match_col * t->cell_w, .y1 = y,
+                .x2 = content.x1 + LV_MIN(t->match_col + t->match_len, t->cols) * t->cell_w - 1, .y2 = y + t->cell_h - 1
+            };
+            lv_draw_rect(draw_ctx, &hit_dsc, &hit);
+        }
+
+        /* Fixed pitch: each glyph goes straight to its cell, no text layout */
+        lv_coord_t x = content.x1;
+        uint32_t stop = row_end(t, serial);
+        for(uint32_t p = row_start(t, serial); p != stop && x <= clip.x2; p++) {
+            uint8_t c = t->buf[p & (t->buf_size - 1)];
+            if(c == '\r' || c == '\n') continue;
+            if(c != ' ' && c != '\t' && x + t->cell_w > clip.x1) {
+                if(c < TERM_GLYPH_FIRST || c > TERM_GLYPH_LAST) c = '.';
+                lv_point_t pos = { x + (t->cell_w - t->glyph_w[c - TERM_GLYPH_FIRST]) / 2, y };
+                lv_draw_letter(draw_ctx, &label_dsc, &pos, c);
+            }
+            x += t->cell_w;
+        }
+    }
+
+    /* Position bar while scrolled back */
+    if(t->offset > 0 && content_h > view_h) {
+        lv_draw_rect_dsc_t bar_dsc;
+        lv_draw_rect_dsc_init(&bar_dsc);
+        bar_dsc.bg_color = label_dsc.color;
+        bar_dsc.bg_opa = LV_OPA_40;
+        bar_dsc.radius = 2;
+        int32_t bar_h = LV_MAX(view_h * view_h / content_h, 12);
+        int32_t bar_y = (int32_t)((int64_t)top_px * (view_h - bar_h) / (content_h - view_h));
+        lv_area_t bar = { content.x2 - 3, content.y1 + bar_y, content.x2, content.y1 + bar_y + bar_h - 1 };
+        lv_draw_rect(draw_ctx, &bar_dsc, &bar);
+    }
+
+    if(t->paused) {
+        lv_draw_rect_dsc_t badge_dsc;
+        lv_draw_rect_dsc_init(&badge_dsc);
+        badge_dsc.bg_color = lv_palette_main(LV_PALETTE_AMBER);
+        badge_dsc.radius = 3;
+        const char * text = "PAUSED";
+        lv_point_t size;
+        lv_txt_get_size(&size, text, label_dsc.font, label_dsc.letter_space, 0, LV_COORD_MAX, LV_TEXT_FLAG_NONE);
+        lv_area_t badge = { content.x2 - size.x - 14, content.y1, content.x2 - 6, content.y1 + size.y + 3 };
+        lv_draw_rect(draw_ctx, &badge_dsc, &badge);
+        lv_area_t text_area = { badge.x1 + 4, badge.y1 + 2, badge.x2 - 4, badge.y2 };
+        lv_draw_label(draw_ctx, &label_dsc, &text_area, text, NULL);
+    }
+
+    draw_ctx->clip_area = clip_ori;
+}
+
+static void lv_terminal_event(const lv_obj_class_t * class_p, lv_event_t * e)
+{
+    LV_UNUSED(class_p);
+
+    lv_res_t res = lv_obj_event_base(MY_CLASS, e);
+    if(res != LV_RES_OK) return;
+
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t * obj = lv_event_get_target(e);
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+
+    /* A drag is a scroll, not a click or long press for the user's handlers */
+    if(code == LV_EVENT_LONG_PRESSED || code == LV_EVENT_LONG_PRESSED_REPEAT ||
+       code == LV_EVENT_SHORT_CLICKED || code == LV_EVENT_CLICKED) {
+        lv_indev_t * indev = lv_indev_get_act();
+        if(indev != NULL && t->drag > indev->driver->scroll_limit) lv_event_stop_processing(e);
+        return;
+    }
+
+    if(code == LV_EVENT_DRAW_MAIN) {
+        draw_main(e);
+    }
+    else if(code == LV_EVENT_SIZE_CHANGED || code == LV_EVENT_STYLE_CHANGED) {
+        update_metrics(obj);
+        lv_obj_invalidate(obj);
+    }
+    else if(code == LV_EVENT_PRESSED) {
+        lv_anim_del(t, throw_anim_cb);
+        t->velocity = 0;
+        t->drag = 0;
+    }
+    else if(code == LV_EVENT_PRESSING) {
+        /* Dragging down shows older rows */
+        lv_point_t vect;
+        lv_indev_get_vect(lv_indev_get_act(), &vect);
+        t->velocity = vect.y;
+        t->drag += LV_ABS(vect.y);
+        scroll_to(t, t->offset + vect.y);
+    }
+    else if(code == LV_EVENT_RELEASED) {
+        if(LV_ABS(t->velocity) > 2) {
+            lv_anim_t a;
+            lv_anim_init(&a);
+            lv_anim_set_var(&a, t);
+            lv_anim_set_exec_cb(&a, throw_anim_cb);
+            lv_anim_set_values(&a, t->offset, t->offset + t->velocity * TERM_THROW_GAIN);
+            lv_anim_set_time(&a, TERM_THROW_TIME);
+            lv_anim_set_path_cb(&a, lv_anim_path_ease_out);
+            lv_anim_start(&a);
+        }
+    }
+}
+
+lv_obj_t * lv_terminal_create(lv_obj_t * parent)
+{
+    LV_LOG_INFO("begin");
+    lv_obj_t * obj = lv_obj_class_create_obj(&lv_terminal_class, parent);
+    lv_obj_class_init_obj(obj);
+    return obj;
+}
+
+bool lv_terminal_set_scrollback(lv_obj_t * obj, uint32_t bytes, uint32_t rows)
+{
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+    if(t == NULL) return false;
+
+    term_free(t->buf);
+    term_free(t->rows);
+    t->buf_size = round_pow2(bytes, TERM_MIN_BYTES);
+    t->row_cap = round_pow2(rows, TERM_MIN_ROWS);
+    t->buf = term_alloc(t->buf_size);
+    t->rows = term_alloc(t->row_cap * sizeof(uint32_t));
+    if(t->buf == NULL || t->rows == NULL) {
+        LV_LOG_WARN("no memory for %u bytes of scrollback", (unsigned)t->buf_size);
+        term_free(t->buf);
+        term_free(t->rows);
+        t->buf = NULL;
+        t->rows = NULL;
+        return false;
+    }
+
+    t->end = 0;
+    t->row_first = 0;
+    t->row_last = 0;
+    t->rows[0] = 0;
+    t->col = 0;
+    t->hex_origin = 0;
+    t->offset = 0;
+    t->match_valid = false;
+    lv_obj_invalidate(obj);
+    return true;
+}
+
+void lv_terminal_append(lv_obj_t * obj, const void * data, uint32_t len)
+{
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+    if(t == NULL || t->buf == NULL || len == 0) return;
+
+    /* A view scrolled back or paused stays on its text */
+    bool hold = t->paused || t->offset > 0;
+    uint32_t hex_rows = hex_row_end(t);
+    const uint8_t * src = data;
+    for(uint32_t i = 0; i < len; i++) {
+        put_byte(t, src[i], true, hold && !t->hex);
+    }
+    evict_rows(t);
+    if(hold && t->hex) t->offset += (int32_t)(hex_row_end(t) - hex_rows) * t->hex_cell_h;
+
+    if(hold) {
+        int32_t max = max_offset(t);
+        if(t->offset > max) {
+            t->offset = max;
+            lv_obj_invalidate(obj);
+        }
+    }
+    else {
+        lv_obj_invalidate(obj);
+    }
+}
+
+void lv_terminal_clear(lv_obj_t * obj)
+{
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+    if(t == NULL || t->buf == NULL) return;
+
+    t->row_first = t->row_last;
+    t->rows[t->row_last & (t->row_cap - 1)] = t->end;
+    t->hex_origin = t->end;
+    t->col = 0;
+    t->offset = 0;
+    t->match_valid = false;
+    lv_obj_invalidate(obj);
+}
+
+void lv_terminal_set_paused(lv_obj_t * obj, bool paused)
+{
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+    if(t == NULL) return;
+
+    t->paused = paused;
+    if(!paused) {
+        lv_anim_del(t, throw_anim_cb);
+        t->offset = 0;
+    }
+    lv_obj_invalidate(obj);
+}
+
+bool lv_terminal_get_paused(lv_obj_t * obj)
+{
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+    return t != NULL && t->paused;
+}
+
+void lv_terminal_scroll_to_end(lv_obj_t * obj)
+{
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+    if(t == NULL) return;
+
+    lv_anim_del(t, throw_anim_cb);
+    scroll_to(t, 0);
+}
+
+void lv_terminal_set_hex(lv_obj_t * obj, bool hex)
+{
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+    if(t == NULL || t->hex == hex) return;
+
+    /* Only the page changes: a view following new text keeps following */
+    lv_anim_del(t, throw_anim_cb);
+    uint32_t pos = t->buf != NULL && t->offset > 0 ? view_bottom_pos(t) : 0;
+    t->hex = hex;
+    if(t->buf != NULL && t->offset > 0) show_pos(t, pos);
+    else t->offset = 0;
+    lv_obj_invalidate(obj);
+}
+
+bool lv_terminal_get_hex(lv_obj_t * obj)
+{
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+    return t != NULL && t->hex;
+}
+
+bool lv_terminal_search(lv_obj_t * obj, const char * text, bool older)
+{
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+    static char row[TERM_ROW_BYTES_MAX * 2 + 1];
+    static char needle[TERM_MAX_COLS + 1];
+
+    uint32_t count = row_count(t);
+    size_t n = text != NULL ? strlen(text) : 0;
+    if(count == 0 || n == 0 || n > t->cols) return false;
+    for(size_t i = 0; i <= n; i++) needle[i] = (char)tolower((unsigned char)text[i]);
+
+    /* Start next to the previous hit, else at the bottom row in view */
+    uint32_t start;
+    if(t->match_valid) {
+        start = t->match_row - t->row_first;
+    }
+    else {
+        start = row_of(t, view_bottom_pos(t)) - t->row_first;
+        start = older ? (start + 1) % count : (start + count - 1) % count;
+    }
+
+    for(uint32_t i = 1; i <= count; i++) {
+        uint32_t idx = older ? (start + count - i) % count : (start + i) % count;
+        uint32_t serial = t->row_first + idx;
+        uint32_t len = row_text(t, serial, row);
+        uint32_t total = len;
+
+        /* A hit may run on into the row this one wraps into */
+        uint32_t stop = row_end(t, serial);
+        if(serial != t->row_last && stop != row_start(t, serial) &&
+           t->buf[(stop - 1) & (t->buf_size - 1)] != '\n') {
+            total += row_text(t, serial + 1, row + len);
+        }
+        for(uint32_t k = 0; k < total; k++) row[k] = (char)tolower((unsigned char)row[k]);
+        const char * hit = strstr(row, needle);
+        if(hit == NULL || (uint32_t)(hit - row) >= len) continue;
+
+        t->match_valid = true;
+        t->match_row = serial;
+        t->match_col = (uint16_t)(hit - row);
+        t->match_len = (uint16_t)n;
+
+        /* The hit's first byte, for the hex view */
+        uint32_t pos = row_start(t, serial);
+        for(uint32_t cell = 0;; pos++) {
+            uint8_t c = t->buf[pos & (t->buf_size - 1)];
+            if(c != '\r' && c != '\n' && cell++ == t->match_col) break;
+        }
+        t->match_pos = pos;
+
+        /* Centre the row in the view */
+        lv_anim_del(t, throw_anim_cb);
+        int32_t cell_h = view_cell_h(t);
+        int32_t from_end = (int32_t)(view_rows(t) - 1 - view_row_of(t, pos)) * cell_h;
+        t->offset = -1;     /* Force the redraw in scroll_to() */
+        scroll_to(t, from_end - lv_obj_get_content_height(obj) / 2 + cell_h / 2);
+        return true;
+    }
+
+    t->match_valid = false;
+    lv_obj_invalidate(obj);
+    return false;
+}
+
+uint32_t lv_terminal_get_row_count(lv_obj_t * obj)
+{
+    lv_terminal_t * t = (lv_terminal_t *)obj;
+    return t != NULL ? row_count(t) : 0;
+}
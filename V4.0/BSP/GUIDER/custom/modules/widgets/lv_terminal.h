@@ -0,0 +1,123 @@
+/**
+ * @file lv_terminal.h
+ * @brief Virtualized terminal widget with a fixed-capacity scrollback
+ *
+ * Text is kept in a byte ring (PSRAM on the ESP32) with a ring of row start
+ * offsets beside it. Rows are wrapped to the widget width as they arrive, so
+ * appending costs O(bytes appended) no matter how much scrollback is kept;
+ * the oldest rows fall off when either ring is full. Only the rows in view
+ * are drawn, one glyph per fixed-pitch cell: the cell is as wide as '0' and
+ * glyphs of a proportional font are centred in it from a cached advance
+ * table, so no text layout runs while drawing.
+ *
+ * The view follows new text until it is dragged back or paused; it then
+ * stays on the same text while rows keep arriving.
+ *
+ * The same bytes can be shown as a hex dump instead (lv_terminal_set_hex()):
+ * offset, hex and ASCII columns, 16 bytes per row where the width allows
+ * (else 8 or 4), in the LV_PART_ITEMS font. Hex rows are fixed slices of the
+ * scrollback, so nothing is stored for them: each row in view is formatted
+ * through a byte-to-digits table as it is drawn, and switching views only
+ * redraws the page.
+ */
+
+#ifndef LV_TERMINAL_H
+#define LV_TERMINAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "lvgl.h"
+
+#define LV_TERMINAL_DEFAULT_BYTES   (256 * 1024)    /* Scrollback text */
+#define LV_TERMINAL_DEFAULT_ROWS    8192            /* Scrollback rows */
+
+typedef struct {
+    lv_obj_t obj;
+    uint8_t * buf;              /* Scrollback ring */
+    uint32_t buf_size;          /* Power of two */
+    uint32_t end;               /* Bytes appended (free-running) */
+    uint32_t * rows;            /* Row start offsets (free-running), ring of row_cap */
+    uint32_t row_cap;           /* Power of two */
+    uint32_t row_first;         /* Serial of the oldest row kept */
+    uint32_t row_last;          /* Serial of the row being filled */
+    uint16_t col;               /* Cells used in the last row */
+    uint16_t cols;              /* Cells per row */
+    lv_coord_t cell_w;
+    lv_coord_t cell_h;
+    uint8_t glyph_w[95];        /* Advance of ' '..'~' in the current font */
+    int32_t offset;             /* Pixels scrolled back from the newest row */
+    int32_t velocity;           /* Last drag step (momentum) */
+    int32_t drag;               /* Distance dragged since pressed */
+    uint32_t match_row;         /* Search hit */
+    uint16_t match_col;
+    uint16_t match_len;
+    bool match_valid;
+    bool paused;
+    bool hex;                   /* Hex dump view */
+    uint8_t hex_bytes;          /* Bytes per hex row: 16, 8 or 4 to fit the width */
+    lv_coord_t hex_cell_w;      /* Hex view pitch (LV_PART_ITEMS font) */
+    lv_coord_t hex_cell_h;
+    uint8_t hex_glyph_w[95];
+    uint32_t hex_origin;        /* Byte shown at offset 0 (the last clear) */
+    uint32_t match_pos;         /* Search hit as a byte offset (free-running) */
+} lv_terminal_t;
+
+extern const lv_obj_class_t lv_terminal_class;
+
+lv_obj_t * lv_terminal_create(lv_obj_t * parent);
+
+/**
+ * Replace the scrollback (clears it)
+ * @param bytes text capacity, rounded up to a power of two
+ * @param rows row capacity, rounded up to a power of two
+ * @return false if the memory could not be allocated (the terminal is then empty)
+ */
+bool lv_terminal_set_scrollback(lv_obj_t * obj, uint32_t bytes, uint32_t rows);
+
+/**
+ * Append text; '\n' ends a row, '\r' is ignored, other control bytes show as '.'
+ */
+void lv_terminal_append(lv_obj_t * obj, const void * data, uint32_t len);
+
+void lv_terminal_clear(lv_obj_t * obj);
+
+/**
+ * Freeze the view on the text shown (new text still goes into the scrollback).
+ * Resuming jumps to the newest row.
+ */
+void lv_terminal_set_paused(lv_obj_t * obj, bool paused);
+
+bool lv_terminal_get_paused(lv_obj_t * obj);
+
+/**
+ * Follow new text again
+ */
+void lv_terminal_scroll_to_end(lv_obj_t * obj);
+
+/**
+ * Show the scrollback as a hex dump or as text. The byte at the bottom of
+ * the view stays there; nothing is reprocessed.
+ */
+void lv_terminal_set_hex(lv_obj_t * obj, bool hex);
+
+bool lv_terminal_get_hex(lv_obj_t * obj);
+
+/**
+ * Find text and bring it into view, highlighted (case-insensitive; a hit
+ * may run on into the next row where a line wraps)
+ * @param text text to find, at most one row long
+ * @param older search towards older rows (else newer), starting next to the
+ *              previous hit or from the view; wraps around once
+ * @return true if found (in the hex view its ASCII column is highlighted)
+ */
+bool lv_terminal_search(lv_obj_t * obj, const char * text, bool older);
+
+uint32_t lv_terminal_get_row_count(lv_obj_t * obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LV_TERMINAL_H */
@@ -0,0 +1,186 @@
+/**
+ * @file byte_ring.c
+ * @brief Lock-free single-producer / single-consumer byte ring
+ */
+
+#include "byte_ring.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+/**
+ * @brief Allocate the ring storage
+ */
+esp_err_t byte_ring_init(byte_ring_t *ring, size_t size)
+{
+    if (ring == NULL || size == 0) return ESP_ERR_INVALID_ARG;
+
+    size_t capacity = 1;
+    while (capacity < size) capacity <<= 1;
+
+    memset(ring, 0, sizeof(*ring));
+    ring->buf = heap_caps_malloc(capacity, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (ring->buf == NULL) {
+        ring->buf = heap_caps_malloc(capacity, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (ring->buf == NULL) return ESP_ERR_NO_MEM;
+
+    ring->size = capacity;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->written, 0);
+    atomic_init(&ring->dropped, 0);
+    return ESP_OK;
+}
+
+/**
+ * @brief Free the ring storage
+ */
+void byte_ring_deinit(byte_ring_t *ring)
+{
+    if (ring == NULL) return;
+    heap_caps_free(ring->buf);
+    ring->buf = NULL;
+    ring->size = 0;
+}
+
+/**
+ * @brief Copy bytes in at a free-running position, in at most two pieces around the end
+ */
+static void copy_in(byte_ring_t *ring, size_t pos, const void *data, size_t n)
+{
+    size_t offset = pos & (ring->size - 1);
+    size_t first = ring->size - offset;
+    if (first > n) first = n;
+    memcpy(ring->buf + offset, data, first);
+    memcpy(ring->buf, (const uint8_t *)data + first, n - first);
+}
+
+/**
+ * @brief Append bytes (producer)
+ */
+size_t byte_ring_write(byte_ring_t *ring, const void *data, size_t len)
+{
+    if (ring == NULL || ring->buf == NULL || len == 0) return 0;
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t space = ring->size - (head - tail);
+    size_t n = (len < space) ? len : space;
+    copy_in(ring, head, data, n);
+
+    // Publish the bytes before the new head
+    atomic_store_explicit(&ring->head, head + n, memory_order_release);
+    atomic_fetch_add_explicit(&ring->written, len, memory_order_relaxed);
+    if (n < len) {
+        atomic_fetch_add_explicit(&ring->dropped, len - n, memory_order_relaxed);
+    }
+    return n;
+}
+
+/**
+ * @brief Append a header and its payload as one unit (producer)
+ */
+bool byte_ring_write_record(byte_ring_t *ring, const void *header, size_t header_len,
+                            const void *data, size_t len)
+{
+    if (ring == NULL || ring->buf == NULL) return false;
+
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t space = ring->size - (head - tail);
+    atomic_fetch_add_explicit(&ring->written, header_len + len, memory_order_relaxed);
+    if (header_len + len > space) {
+        atomic_fetch_add_explicit(&ring->dropped, header_len + len, memory_order_relaxed);
+        return false;
+    }
+
+    copy_in(ring, head, header, header_len);
+    copy_in(ring, head + header_len, data, len);
+
+    // One head update: the reader never sees a header without its payload
+    atomic_store_explicit(&ring->head, head + header_len + len, memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Take up to max bytes (consumer)
+ */
+size_t byte_ring_read(byte_ring_t *ring, void *out, size_t max)
+{
+    if (ring == NULL || ring->buf == NULL || max == 0) return 0;
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t used = head - tail;
+    size_t n = (max < used) ? max : used;
+
+    size_t offset = tail & (ring->size - 1);
+    size_t first = ring->size - offset;
+    if (first > n) first = n;
+    memcpy(out, ring->buf + offset, first);
+    memcpy((uint8_t *)out + first, ring->buf, n - first);
+
+    // Hand the space back only after the bytes are copied out
+    atomic_store_explicit(&ring->tail, tail + n, memory_order_release);
+    return n;
+}
+
+/**
+ * @brief Contiguous bytes ready to read, in place (consumer)
+ */
+size_t byte_ring_peek(byte_ring_t *ring, const uint8_t **data)
+{
+    if (ring == NULL || ring->buf == NULL || data == NULL) return 0;
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t offset = tail & (ring->size - 1);
+    size_t n = head - tail;
+    if (n > ring->size - offset) n = ring->size - offset;
+    *data = ring->buf + offset;
+    return n;
+}
+
+/**
+ * @brief Release bytes returned by byte_ring_peek() (consumer)
+ */
+void byte_ring_consume(byte_ring_t *ring, size_t len)
+{
+    if (ring == NULL || len == 0) return;
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    atomic_store_explicit(&ring->tail, tail + len, memory_order_release);
+}
+
+/**
+ * @brief Throw away everything stored (consumer)
+ */
+size_t byte_ring_discard(byte_ring_t *ring)
+{
+    if (ring == NULL) return 0;
+
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    atomic_store_explicit(&ring->tail, head, memory_order_release);
+    return head - tail;
+}
+
+/**
+ * @brief Bytes waiting to be read
+ */
+size_t byte_ring_used(const byte_ring_t *ring)
+{
+    if (ring == NULL) return 0;
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    return head - tail;
+}
+
+/**
+ * @brief Bytes offered and bytes dropped
+ */
+void byte_ring_get_counts(const byte_ring_t *ring, uint32_t *written, uint32_t *dropped)
+{
+    if (written) *written = ring ? (uint32_t)atomic_load_explicit(&ring->written, memory_order_relaxed) : 0;
+    if (dropped) *dropped = ring ? (uint32_t)atomic_load_explicit(&ring->dropped, memory_order_relaxed) : 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file byte_ring.h
+ * @brief Lock-free single-producer / single-consumer byte ring
+ *
+ * One task writes, one task (e.g. the LVGL thread) reads; neither blocks
+ * nor takes a lock. Head and tail are free-running byte counts published
+ * with release/acquire ordering, so the ring is safe across both cores.
+ * When the ring is full the producer drops what does not fit and counts it:
+ * a slow reader never stalls the socket or UART that feeds it.
+ */
+
+#ifndef BYTE_RING_H
+#define BYTE_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Ring state (fields are private; use the functions below) */
+typedef struct {
+    uint8_t *buf;
+    size_t size;                    // Power of two
+    atomic_size_t head;             // Bytes written (producer)
+    atomic_size_t tail;             // Bytes read (consumer)
+    atomic_uint_fast32_t written;   // Producer counters
+    atomic_uint_fast32_t dropped;
+} byte_ring_t;
+
+/**
+ * @brief Allocate the ring storage (PSRAM first, internal RAM otherwise)
+ *
+ * @param ring Ring to set up
+ * @param size Capacity in bytes (rounded up to a power of two)
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t byte_ring_init(byte_ring_t *ring, size_t size);
+
+/**
+ * @brief Free the ring storage (neither side may be using it)
+ */
+void byte_ring_deinit(byte_ring_t *ring);
+
+/**
+ * @brief Append bytes (producer)
+ *
+ * @return Bytes stored; the rest is dropped and counted
+ */
+size_t byte_ring_write(byte_ring_t *ring, const void *data, size_t len);
+
+/**
+ * @brief Append a header and its payload as one unit (producer)
+ *
+ * The reader sees both or neither: if they do not fit together nothing is
+ * stored and all of it is counted as dropped.
+ *
+ * @return true if stored
+ */
+bool byte_ring_write_record(byte_ring_t *ring, const void *header, size_t header_len,
+                            const void *data, size_t len);
+
+/**
+ * @brief Take up to max bytes (consumer)
+ *
+ * @return Bytes copied to out
+ */
+size_t byte_ring_read(byte_ring_t *ring, void *out, size_t max);
+
+/**
+ * @brief Contiguous bytes ready to read, in place (consumer)
+ *
+ * For handing ring memory straight to send()/write(); follow with
+ * byte_ring_consume() for the bytes actually taken.
+ *
+ * @param data Set to the first unread byte
+ * @return Bytes available at *data (0 if empty; more may follow from the start of the ring)
+ */
+size_t byte_ring_peek(byte_ring_t *ring, const uint8_t **data);
+
+/**
+ * @brief Release bytes returned by byte_ring_peek() (consumer)
+ */
+void byte_ring_consume(byte_ring_t *ring, size_t len);
+
+/**
+ * @brief Throw away everything stored (consumer)
+ *
+ * @return Bytes discarded
+ */
+size_t byte_ring_discard(byte_ring_t *ring);
+
+/**
+ * @brief Bytes waiting to be read (either side)
+ */
+size_t byte_ring_used(const byte_ring_t *ring);
+
+/**
+ * @brief Bytes offered to byte_ring_write() and bytes dropped (either side)
+ */
+void byte_ring_get_counts(const byte_ring_t *ring, uint32_t *written, uint32_t *dropped);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BYTE_RING_H */
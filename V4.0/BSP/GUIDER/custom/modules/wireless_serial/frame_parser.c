@@ -0,0 +1,558 @@
+/**
+ * @file frame_parser.c
+ * @brief Streaming frame decoders for the serial receive path
+ */
+
+#include "frame_parser.h"
+#include <stdio.h>
+#include <string.h>
+
+/* SLIP (RFC 1055) */
+#define SLIP_END            0xC0
+#define SLIP_ESC            0xDB
+#define SLIP_ESC_END        0xDC
+#define SLIP_ESC_ESC        0xDD
+#define SLIP_ESCAPED        0x01    // flags: the last byte was ESC
+
+/* COBS: state is the data bytes left in the block */
+#define COBS_ZERO           0x01    // flags: a zero is owed before the next block
+
+/* Payload bytes shown by the hex summaries */
+#define DESCRIBE_HEX_MAX    24
+
+/* ==================== Parser core ==================== */
+
+static size_t frame_len(const frame_parser_t *p)
+{
+    return p->len + p->pend_len;
+}
+
+/**
+ * @brief Move the in-place part of the frame into the buffer
+ */
+static void materialize(frame_parser_t *p)
+{
+    if (p->pend_len > 0) {
+        memcpy(p->buf + p->len, p->pend, p->pend_len);
+        p->len += p->pend_len;
+    }
+    p->pend = NULL;
+    p->pend_len = 0;
+}
+
+/**
+ * @brief Hand the frame to the callback and start an empty one
+ */
+static void report(frame_parser_t *p, frame_error_t error)
+{
+    frame_t frame = {
+        .error = error,
+        .in_place = p->pend_len > 0,
+    };
+    if (frame.in_place) {
+        frame.data = p->pend;
+        frame.len = p->pend_len;
+    } else {
+        frame.data = p->buf;
+        frame.len = p->len;
+    }
+
+    p->stats.frames++;
+    if (error != FRAME_OK) p->stats.errors++;
+    if (frame.in_place) p->stats.in_place++;
+    if (p->cb) p->cb(&frame, p->user);
+
+    p->len = 0;
+    p->pend = NULL;
+    p->pend_len = 0;
+}
+
+void frame_parser_init(frame_parser_t *p, const frame_decoder_t *decoder, uint8_t *buf, size_t cap,
+                       frame_cb_t cb, void *user)
+{
+    memset(p, 0, sizeof(*p));
+    p->decoder = decoder;
+    p->buf = buf;
+    p->cap = cap;
+    p->cb = cb;
+    p->user = user;
+}
+
+void frame_parser_reset(frame_parser_t *p)
+{
+    p->len = 0;
+    p->pend = NULL;
+    p->pend_len = 0;
+    p->skip = false;
+    p->state = 0;
+    p->flags = 0;
+    memset(&p->stats, 0, sizeof(p->stats));
+}
+
+void frame_parser_feed(frame_parser_t *p, const uint8_t *data, size_t len)
+{
+    // The previous bytes may be gone after this call
+    materialize(p);
+    if (len == 0) return;
+    p->stats.bytes += len;
+    p->decoder->feed(p, data, len);
+}
+
+void frame_parser_gap(frame_parser_t *p)
+{
+    if (p->decoder->gap) {
+        p->decoder->gap(p);
+    }
+}
+
+void frame_parser_sync(frame_parser_t *p)
+{
+    materialize(p);
+}
+
+void frame_parser_add(frame_parser_t *p, const uint8_t *data, size_t len)
+{
+    if (p->skip || len == 0) return;
+
+    size_t room = p->cap - frame_len(p);
+    if (len > room) {
+        // Report what fits and drop the rest of the frame
+        materialize(p);
+        memcpy(p->buf + p->len, data, room);
+        p->len += room;
+        frame_parser_abort(p, FRAME_ERR_TOO_LONG);
+        return;
+    }
+
+    // Still one run of the caller's bytes: leave it where it is
+    if (p->len == 0 && (p->pend == NULL || p->pend + p->pend_len == data)) {
+        if (p->pend == NULL) p->pend = data;
+        p->pend_len += len;
+        return;
+    }
+    materialize(p);
+    memcpy(p->buf + p->len, data, len);
+    p->len += len;
+}
+
+void frame_parser_put(frame_parser_t *p, const uint8_t *data, size_t len)
+{
+    if (p->skip || len == 0) return;
+
+    materialize(p);
+    size_t room = p->cap - p->len;
+    size_t n = (len < room) ? len : room;
+    memcpy(p->buf + p->len, data, n);
+    p->len += n;
+    if (n < len) {
+        frame_parser_abort(p, FRAME_ERR_TOO_LONG);
+    }
+}
+
+void frame_parser_end(frame_parser_t *p, frame_error_t error)
+{
+    if (p->skip) {
+        p->skip = false;
+        return;
+    }
+    if (frame_len(p) == 0 && error == FRAME_OK) {
+        p->pend = NULL;
+        return;
+    }
+    report(p, error);
+}
+
+void frame_parser_abort(frame_parser_t *p, frame_error_t error)
+{
+    if (p->skip) return;
+    report(p, error);
+    p->skip = true;
+}
+
+/* ==================== Display ==================== */
+
+const char *frame_error_name(frame_error_t error)
+{
+    switch (error) {
+    case FRAME_OK:              return "ok";
+    case FRAME_ERR_TOO_LONG:    return "too long";
+    case FRAME_ERR_ESCAPE:      return "bad escape";
+    case FRAME_ERR_COBS:        return "bad COBS";
+    case FRAME_ERR_CRC:         return "CRC error";
+    case FRAME_ERR_SHORT:       return "short";
+    default:                    return "?";
+    }
+}
+
+/**
+ * @brief Append up to DESCRIBE_HEX_MAX bytes as hex, ".." if there are more
+ */
+static int append_hex(char *out, size_t size, int pos, const uint8_t *data, size_t len)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    size_t shown = (len < DESCRIBE_HEX_MAX) ? len : DESCRIBE_HEX_MAX;
+
+    for (size_t i = 0; i < shown; i++) {
+        if ((size_t)pos + 4 > size) break;
+        out[pos++] = ' ';
+        out[pos++] = digits[data[i] >> 4];
+        out[pos++] = digits[data[i] & 0x0F];
+    }
+    if (shown < len && (size_t)pos + 3 < size) {
+        out[pos++] = '.';
+        out[pos++] = '.';
+    }
+    out[pos] = '\0';
+    return pos;
+}
+
+/**
+ * @brief Append a length prefix with snprintf semantics clamped to the buffer
+ */
+static int append_len(char *out, size_t size, int pos, size_t len)
+{
+    int n = snprintf(out + pos, size - pos, "%u B:", (unsigned)len);
+    if (n < 0) return pos;
+    return ((size_t)(pos + n) < size) ? pos + n : (int)size - 1;
+}
+
+/**
+ * @brief Hex summary: "<len> B: xx xx .."
+ */
+static int describe_hex(const frame_t *frame, char *out, size_t size)
+{
+    int pos = append_len(out, size, 0, frame->len);
+    return append_hex(out, size, pos, frame->data, frame->len);
+}
+
+/**
+ * @brief Text with control bytes escaped, cut to fit
+ */
+static int describe_text(const frame_t *frame, char *out, size_t size)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    size_t pos = 0;
+
+    for (size_t i = 0; i < frame->len; i++) {
+        uint8_t c = frame->data[i];
+        size_t need = (c >= 0x20 && c < 0x7F && c != '\\') ? 1 : (c == '\\' || c == '\t' || c == '\r') ? 2 : 4;
+        if (pos + need + 1 > size) {
+            if (size >= 3) {
+                pos = (pos + 3 > size) ? size - 3 : pos;
+                out[pos++] = '.';
+                out[pos++] = '.';
+            }
+            break;
+        }
+        if (need == 1) {
+            out[pos++] = (char)c;
+        } else if (need == 2) {
+            out[pos++] = '\\';
+            out[pos++] = (c == '\t') ? 't' : (c == '\r') ? 'r' : '\\';
+        } else {
+            out[pos++] = '\\';
+            out[pos++] = 'x';
+            out[pos++] = digits[c >> 4];
+            out[pos++] = digits[c & 0x0F];
+        }
+    }
+    out[pos] = '\0';
+    return (int)pos;
+}
+
+int frame_parser_describe(const frame_parser_t *p, const frame_t *frame, char *out, size_t size)
+{
+    if (size == 0) return 0;
+
+    // The error goes last but must not be cut off
+    char suffix[24] = "";
+    if (frame->error != FRAME_OK) {
+        snprintf(suffix, sizeof(suffix), " [%s]", frame_error_name(frame->error));
+    }
+    size_t suffix_len = strlen(suffix);
+    if (suffix_len + 1 >= size) {
+        out[0] = '\0';
+        return 0;
+    }
+
+    int (*describe)(const frame_t *, char *, size_t) = p->decoder->describe ? p->decoder->describe : describe_hex;
+    int pos = describe(frame, out, size - suffix_len);
+    memcpy(out + pos, suffix, suffix_len + 1);
+    return pos + (int)suffix_len;
+}
+
+/* ==================== Line ==================== */
+
+/**
+ * @brief Close a line, without its '\r' if it ended in "\r\n"
+ */
+static void line_end(frame_parser_t *p)
+{
+    if (p->pend_len > 0) {
+        if (p->pend[p->pend_len - 1] == '\r') p->pend_len--;
+    } else if (p->len > 0 && p->buf[p->len - 1] == '\r') {
+        p->len--;
+    }
+    frame_parser_end(p, FRAME_OK);
+}
+
+static void line_feed(frame_parser_t *p, const uint8_t *data, size_t len)
+{
+    const uint8_t *end = data + len;
+
+    while (data < end) {
+        const uint8_t *nl = memchr(data, '\n', end - data);
+        if (nl == NULL) {
+            frame_parser_add(p, data, end - data);
+            return;
+        }
+        frame_parser_add(p, data, nl - data);
+        line_end(p);
+        data = nl + 1;
+    }
+}
+
+const frame_decoder_t frame_decoder_line = {
+    .name = "Line",
+    .feed = line_feed,
+    .gap = NULL,
+    .describe = describe_text,
+};
+
+/* ==================== SLIP ==================== */
+
+static void slip_feed(frame_parser_t *p, const uint8_t *data, size_t len)
+{
+    static const uint8_t end_byte = SLIP_END;
+    static const uint8_t esc_byte = SLIP_ESC;
+    const uint8_t *end = data + len;
+
+    while (data < end) {
+        if (p->flags & SLIP_ESCAPED) {
+            uint8_t c = *data++;
+            p->flags &= ~SLIP_ESCAPED;
+            if (c == SLIP_ESC_END) {
+                frame_parser_put(p, &end_byte, 1);
+            } else if (c == SLIP_ESC_ESC) {
+                frame_parser_put(p, &esc_byte, 1);
+            } else if (c == SLIP_END) {
+                frame_parser_end(p, FRAME_ERR_ESCAPE);
+            } else {
+                frame_parser_abort(p, FRAME_ERR_ESCAPE);
+            }
+            continue;
+        }
+
+        // A run of plain bytes stays in place
+        const uint8_t *s = data;
+        while (s < end && *s != SLIP_END && *s != SLIP_ESC) s++;
+        frame_parser_add(p, data, s - data);
+        if (s == end) return;
+
+        if (*s == SLIP_END) {
+            frame_parser_end(p, FRAME_OK);
+        } else {
+            p->flags |= SLIP_ESCAPED;
+        }
+        data = s + 1;
+    }
+}
+
+const frame_decoder_t frame_decoder_slip = {
+    .name = "SLIP",
+    .feed = slip_feed,
+    .gap = NULL,
+    .describe = describe_hex,
+};
+
+/* ==================== COBS ==================== */
+
+static void cobs_feed(frame_parser_t *p, const uint8_t *data, size_t len)
+{
+    static const uint8_t zero = 0;
+    const uint8_t *end = data + len;
+
+    while (data < end) {
+        if (p->state > 0) {
+            // Data bytes of the block; a zero here ends the frame early
+            size_t n = (size_t)(end - data);
+            if (n > p->state) n = p->state;
+            const uint8_t *delim = memchr(data, 0, n);
+            if (delim != NULL) n = delim - data;
+            frame_parser_put(p, data, n);
+            p->state -= n;
+            data += n;
+            if (delim != NULL) {
+                p->state = 0;
+                p->flags = 0;
+                frame_parser_end(p, FRAME_ERR_COBS);
+                data++;
+            }
+            continue;
+        }
+
+        uint8_t code = *data++;
+        if (code == 0) {
+            // The zero owed by the last block is not part of the frame
+            p->flags = 0;
+            frame_parser_end(p, FRAME_OK);
+            continue;
+        }
+        if (p->flags & COBS_ZERO) {
+            frame_parser_put(p, &zero, 1);
+        }
+        p->state = code - 1;
+        p->flags = (code < 0xFF) ? COBS_ZERO : 0;
+    }
+}
+
+const frame_decoder_t frame_decoder_cobs = {
+    .name = "COBS",
+    .feed = cobs_feed,
+    .gap = NULL,
+    .describe = describe_hex,
+};
+
+/* ==================== Modbus-RTU ==================== */
+
+static const uint16_t s_crc16_table[256] = {
+    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
+    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
+    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
+    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
+    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
+    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
+    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
+    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
+    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
+    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
+    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
+    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
+    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
+    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
+    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
+    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
+    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
+    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
+    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
+    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
+    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
+    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
+    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
+    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
+    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
+    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
+    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
+    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
+    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
+    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
+    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
+    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040,
+};
+
+uint16_t frame_modbus_crc16(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 8) ^ s_crc16_table[(crc ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+static void modbus_feed(frame_parser_t *p, const uint8_t *data, size_t len)
+{
+    size_t have = frame_len(p);
+    if (!p->skip && have + len > FRAME_MODBUS_MAX) {
+        frame_parser_add(p, data, FRAME_MODBUS_MAX - have);
+        frame_parser_abort(p, FRAME_ERR_TOO_LONG);
+        return;
+    }
+    frame_parser_add(p, data, len);
+}
+
+/**
+ * @brief A gap ends the ADU: check its length and CRC (sent low byte first)
+ */
+static void modbus_gap(frame_parser_t *p)
+{
+    size_t len = frame_len(p);
+    if (p->skip || len == 0) {
+        frame_parser_end(p, FRAME_OK);
+        return;
+    }
+    if (len < 4) {
+        frame_parser_end(p, FRAME_ERR_SHORT);
+        return;
+    }
+
+    const uint8_t *adu = (p->pend_len > 0) ? p->pend : p->buf;
+    uint16_t crc = (uint16_t)(adu[len - 2] | (adu[len - 1] << 8));
+    frame_parser_end(p, frame_modbus_crc16(adu, len - 2) == crc ? FRAME_OK : FRAME_ERR_CRC);
+}
+
+static const char *modbus_function_name(uint8_t function)
+{
+    switch (function) {
+    case 0x01: return "Read Coils";
+    case 0x02: return "Read Inputs";
+    case 0x03: return "Read Holding";
+    case 0x04: return "Read Input Regs";
+    case 0x05: return "Write Coil";
+    case 0x06: return "Write Register";
+    case 0x07: return "Read Status";
+    case 0x08: return "Diagnostics";
+    case 0x0F: return "Write Coils";
+    case 0x10: return "Write Registers";
+    case 0x11: return "Report ID";
+    case 0x16: return "Mask Write";
+    case 0x17: return "R/W Registers";
+    case 0x2B: return "Device ID";
+    default:   return "";
+    }
+}
+
+static const char *modbus_exception_name(uint8_t code)
+{
+    switch (code) {
+    case 0x01: return "Illegal function";
+    case 0x02: return "Illegal address";
+    case 0x03: return "Illegal value";
+    case 0x04: return "Device failure";
+    case 0x05: return "Acknowledge";
+    case 0x06: return "Device busy";
+    case 0x08: return "Parity error";
+    case 0x0A: return "No gateway path";
+    case 0x0B: return "No gateway response";
+    default:   return "";
+    }
+}
+
+/**
+ * @brief "@<address> fc<function> <name>: <data>", or the exception
+ */
+static int modbus_describe(const frame_t *frame, char *out, size_t size)
+{
+    if (frame->len < 4) {
+        return describe_hex(frame, out, size);
+    }
+
+    const uint8_t *adu = frame->data;
+    uint8_t function = adu[1];
+    int n;
+    if ((function & 0x80) && frame->len == 5) {
+        n = snprintf(out, size, "@%u fc%02X exc %02X %s", adu[0], function, adu[2], modbus_exception_name(adu[2]));
+        return ((size_t)n < size) ? n : (int)size - 1;
+    }
+
+    n = snprintf(out, size, "@%u fc%02X %s:", adu[0], function, modbus_function_name(function));
+    if (n < 0) return 0;
+    if ((size_t)n >= size) return (int)size - 1;
+    return append_hex(out, size, n, adu + 2, frame->len - 4);
+}
+
+const frame_decoder_t frame_decoder_modbus_rtu = {
+    .name = "Modbus",
+    .feed = modbus_feed,
+    .gap = modbus_gap,
+    .describe = modbus_describe,
+};
@@ -0,0 +1,190 @@
+/**
+ * @file frame_parser.h
+ * @brief Streaming frame decoders for the serial receive path
+ *
+ * A frame_parser_t turns a byte stream into frames with a pluggable decoder
+ * (frame_decoder_t): newline text, SLIP (RFC 1055), COBS and Modbus-RTU are
+ * built in, and another protocol only needs its own decoder table. Bytes are
+ * fed in whatever pieces they arrive (e.g. straight from byte_ring_peek());
+ * every completed frame is handed to a callback.
+ *
+ * Nothing is allocated: the caller supplies the frame buffer, whose size is
+ * also the longest frame. A frame that lies whole in the bytes of one feed
+ * and needs no decoding (a line, a SLIP frame without escapes, a Modbus ADU)
+ * is passed to the callback in place, without being copied; only frames
+ * split across feeds, or that must be unescaped, go through the buffer.
+ *
+ * Bytes given to frame_parser_feed() are read until the next call on the
+ * parser (feed, gap, sync or reset) returns, so a frame can stay in place
+ * until its end is known; call frame_parser_sync() before releasing them.
+ *
+ * Pure C with no RTOS calls; one parser is used from one thread.
+ */
+
+#ifndef FRAME_PARSER_H
+#define FRAME_PARSER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Longest Modbus-RTU ADU: address, PDU of up to 253 bytes, CRC */
+#define FRAME_MODBUS_MAX    256
+
+/* Frame status */
+typedef enum {
+    FRAME_OK = 0,
+    FRAME_ERR_TOO_LONG,     // Longer than the frame buffer; what fitted is reported
+    FRAME_ERR_ESCAPE,       // SLIP: ESC not followed by ESC_END / ESC_ESC
+    FRAME_ERR_COBS,         // COBS: frame ended inside a block
+    FRAME_ERR_CRC,          // Modbus: CRC mismatch
+    FRAME_ERR_SHORT,        // Modbus: fewer than 4 bytes between gaps
+} frame_error_t;
+
+/* A decoded frame, valid during the callback only */
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    frame_error_t error;
+    bool in_place;          // data points into the fed bytes (not copied)
+} frame_t;
+
+/* Counters since frame_parser_init() / frame_parser_reset() */
+typedef struct {
+    uint32_t frames;        // Frames reported, errors included
+    uint32_t errors;
+    uint32_t in_place;      // Frames reported without a copy
+    uint32_t bytes;         // Bytes fed
+} frame_parser_stats_t;
+
+typedef struct frame_parser frame_parser_t;
+
+typedef void (*frame_cb_t)(const frame_t *frame, void *user);
+
+/**
+ * @brief Decoder plug-in
+ *
+ * feed() scans the bytes and builds frames with frame_parser_add() (raw
+ * bytes, kept in place when possible), frame_parser_put() (decoded bytes)
+ * and frame_parser_end(); gap() is called when the line has been idle for
+ * an inter-frame gap. The decoder's own state lives in the parser's
+ * state / flags fields.
+ */
+typedef struct {
+    const char *name;
+    void (*feed)(frame_parser_t *p, const uint8_t *data, size_t len);
+    void (*gap)(frame_parser_t *p);         // NULL: gaps mean nothing
+    /** One-line summary of a frame's fields; returns the length written */
+    int (*describe)(const frame_t *frame, char *out, size_t size);
+} frame_decoder_t;
+
+/* Parser state (fields are private except to decoders) */
+struct frame_parser {
+    const frame_decoder_t *decoder;
+    uint8_t *buf;                   // Frame being assembled (copied bytes)
+    size_t cap;
+    size_t len;
+    const uint8_t *pend;            // Frame bytes still in the caller's memory
+    size_t pend_len;
+    bool skip;                      // Discarding up to the next frame end
+    uint32_t state;                 // Decoder private
+    uint32_t flags;
+    frame_cb_t cb;
+    void *user;
+    frame_parser_stats_t stats;
+};
+
+/* Built-in decoders */
+extern const frame_decoder_t frame_decoder_line;        // '\n' terminated, "\r\n" accepted, empty lines skipped
+extern const frame_decoder_t frame_decoder_slip;        // END 0xC0 delimited, RFC 1055 escapes
+extern const frame_decoder_t frame_decoder_cobs;        // 0x00 delimited, COBS encoded
+extern const frame_decoder_t frame_decoder_modbus_rtu;  // Gap delimited, CRC-16 checked
+
+/**
+ * @brief Set up a parser
+ *
+ * @param p       Parser to set up
+ * @param decoder Frame format
+ * @param buf     Frame buffer (cap bytes, owned by the caller)
+ * @param cap     Longest frame
+ * @param cb      Called for every frame, from inside feed / gap
+ * @param user    Passed to cb
+ */
+void frame_parser_init(frame_parser_t *p, const frame_decoder_t *decoder, uint8_t *buf, size_t cap,
+                       frame_cb_t cb, void *user);
+
+/**
+ * @brief Drop any partial frame and clear the counters
+ */
+void frame_parser_reset(frame_parser_t *p);
+
+/**
+ * @brief Decode bytes; completed frames go to the callback
+ */
+void frame_parser_feed(frame_parser_t *p, const uint8_t *data, size_t len);
+
+/**
+ * @brief The line was idle for an inter-frame gap (ends a Modbus-RTU frame)
+ */
+void frame_parser_gap(frame_parser_t *p);
+
+/**
+ * @brief Copy a partial frame still held in place into the frame buffer
+ *
+ * Call before the bytes last fed are overwritten or released.
+ */
+void frame_parser_sync(frame_parser_t *p);
+
+/**
+ * @brief One-line summary of a frame for display
+ *
+ * Fields as the decoder shows them, then the error if there is one.
+ *
+ * @return Length written to out (always terminated)
+ */
+int frame_parser_describe(const frame_parser_t *p, const frame_t *frame, char *out, size_t size);
+
+/**
+ * @brief Short name of a frame status
+ */
+const char *frame_error_name(frame_error_t error);
+
+/* ----- For decoders ----- */
+
+/**
+ * @brief Append raw bytes to the frame (kept in place while the frame lies in one feed)
+ */
+void frame_parser_add(frame_parser_t *p, const uint8_t *data, size_t len);
+
+/**
+ * @brief Append decoded bytes to the frame (always copied)
+ */
+void frame_parser_put(frame_parser_t *p, const uint8_t *data, size_t len);
+
+/**
+ * @brief Report the frame and start the next one
+ *
+ * An empty frame is not reported unless it carries an error. After an
+ * abort the frame was reported already and is only closed.
+ */
+void frame_parser_end(frame_parser_t *p, frame_error_t error);
+
+/**
+ * @brief Report the frame so far with an error and discard up to its end
+ */
+void frame_parser_abort(frame_parser_t *p, frame_error_t error);
+
+/**
+ * @brief Modbus CRC-16 (polynomial 0xA001, initial 0xFFFF)
+ */
+uint16_t frame_modbus_crc16(const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FRAME_PARSER_H */
@@ -0,0 +1,107 @@
+/**
+ * @file latency_hist.c
+ * @brief Lock-free latency histogram with power-of-two buckets
+ */
+
+#include "latency_hist.h"
+#include <stdio.h>
+
+/**
+ * @brief Clear all buckets
+ */
+void latency_hist_init(latency_hist_t *hist)
+{
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        atomic_init(&hist->counts[i], 0);
+    }
+    atomic_init(&hist->max_us, 0);
+}
+
+static int bucket_of(uint32_t us)
+{
+    uint32_t scaled = us / LATENCY_HIST_BASE_US;
+    if (scaled == 0) return 0;
+    int bucket = 32 - __builtin_clz(scaled);
+    return bucket < LATENCY_HIST_BUCKETS ? bucket : LATENCY_HIST_BUCKETS - 1;
+}
+
+/**
+ * @brief Record one sample
+ */
+void latency_hist_add(latency_hist_t *hist, uint32_t us)
+{
+    atomic_fetch_add_explicit(&hist->counts[bucket_of(us)], 1, memory_order_relaxed);
+    uint_fast32_t max = atomic_load_explicit(&hist->max_us, memory_order_relaxed);
+    while (us > max && !atomic_compare_exchange_weak(&hist->max_us, &max, us)) {
+    }
+}
+
+/**
+ * @brief Copy the buckets, optionally starting them over
+ */
+void latency_hist_snapshot(latency_hist_t *hist, latency_hist_snapshot_t *out, bool reset)
+{
+    out->count = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        out->counts[i] = reset ? atomic_exchange(&hist->counts[i], 0) : atomic_load(&hist->counts[i]);
+        out->count += out->counts[i];
+    }
+    out->max_us = reset ? atomic_exchange(&hist->max_us, 0) : atomic_load(&hist->max_us);
+}
+
+/**
+ * @brief Upper bound of a bucket in microseconds
+ */
+uint32_t latency_hist_bucket_us(int bucket)
+{
+    if (bucket >= LATENCY_HIST_BUCKETS - 1) return UINT32_MAX;
+    return (uint32_t)LATENCY_HIST_BASE_US << bucket;
+}
+
+/**
+ * @brief Bound below which pct percent of the samples lie
+ */
+uint32_t latency_hist_percentile(const latency_hist_snapshot_t *snap, unsigned pct)
+{
+    if (snap->count == 0) return 0;
+
+    uint64_t target = ((uint64_t)snap->count * pct + 99) / 100;
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += snap->counts[i];
+        if (seen >= target) {
+            uint32_t bound = latency_hist_bucket_us(i);
+            return bound < snap->max_us ? bound : snap->max_us;
+        }
+    }
+    return snap->max_us;
+}
+
+/* "850us", "1.2ms", "3.4s" */
+static int format_us(char *out, size_t size, uint32_t us)
+{
+    if (us < 1000) {
+        return snprintf(out, size, "%luus", (unsigned long)us);
+    }
+    if (us < 1000000) {
+        return snprintf(out, size, "%lu.%lums", (unsigned long)(us / 1000), (unsigned long)(us % 1000 / 100));
+    }
+    return snprintf(out, size, "%lu.%lus", (unsigned long)(us / 1000000), (unsigned long)(us % 1000000 / 100000));
+}
+
+/**
+ * @brief One-line summary of a snapshot
+ */
+int latency_hist_format(const latency_hist_snapshot_t *snap, char *out, size_t size)
+{
+    char p50[12], p90[12], p99[12], max[12];
+    format_us(p50, sizeof(p50), latency_hist_percentile(snap, 50));
+    format_us(p90, sizeof(p90), latency_hist_percentile(snap, 90));
+    format_us(p99, sizeof(p99), latency_hist_percentile(snap, 99));
+    format_us(max, sizeof(max), snap->max_us);
+
+    int n = snprintf(out, size, "n %lu p50 <%s p90 <%s p99 <%s max %s", (unsigned long)snap->count,
+                     p50, p90, p99, max);
+    if (n < 0) return 0;
+    return ((size_t)n < size) ? n : (int)size - 1;
+}
@@ -0,0 +1,80 @@
+/**
+ * @file latency_hist.h
+ * @brief Lock-free latency histogram with power-of-two buckets
+ *
+ * One task records samples; any other task may take snapshots. Bucket 0
+ * holds samples below LATENCY_HIST_BASE_US, bucket i those below
+ * LATENCY_HIST_BASE_US << i, and the last bucket everything above, so
+ * percentiles are known to within a factor of two at a fixed 16 counters.
+ */
+
+#ifndef LATENCY_HIST_H
+#define LATENCY_HIST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define LATENCY_HIST_BUCKETS    16
+#define LATENCY_HIST_BASE_US    32      // Upper bound of bucket 0
+
+/* Histogram (fields are private; use the functions below) */
+typedef struct {
+    atomic_uint_fast32_t counts[LATENCY_HIST_BUCKETS];
+    atomic_uint_fast32_t max_us;
+} latency_hist_t;
+
+/* Copy of a histogram */
+typedef struct {
+    uint32_t counts[LATENCY_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t max_us;
+} latency_hist_snapshot_t;
+
+/**
+ * @brief Clear all buckets (no recorder may be running)
+ */
+void latency_hist_init(latency_hist_t *hist);
+
+/**
+ * @brief Record one sample (recording task)
+ */
+void latency_hist_add(latency_hist_t *hist, uint32_t us);
+
+/**
+ * @brief Copy the buckets, optionally starting them over (any task)
+ *
+ * With reset, a sample recorded during the call lands in either the copy
+ * or the next one, never both.
+ */
+void latency_hist_snapshot(latency_hist_t *hist, latency_hist_snapshot_t *out, bool reset);
+
+/**
+ * @brief Upper bound of bucket i in microseconds (UINT32_MAX for the last)
+ */
+uint32_t latency_hist_bucket_us(int bucket);
+
+/**
+ * @brief Bound below which pct percent of the samples lie (bucket resolution)
+ *
+ * @return Microseconds, the maximum for the last bucket, 0 without samples
+ */
+uint32_t latency_hist_percentile(const latency_hist_snapshot_t *snap, unsigned pct);
+
+/**
+ * @brief One-line summary: "n 1234 p50 <256us p90 <1ms p99 <4ms max 3.2ms"
+ *
+ * @return Length written to out (always terminated)
+ */
+int latency_hist_format(const latency_hist_snapshot_t *snap, char *out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LATENCY_HIST_H */
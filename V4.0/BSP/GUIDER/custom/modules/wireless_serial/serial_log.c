@@ -0,0 +1,698 @@
+/**
+ * @file serial_log.c
+ * @brief Timestamped capture of wireless serial traffic to SD card
+ */
+
+#include "serial_log.h"
+#include "byte_ring.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+static const char *TAG = "SerialLog";
+
+#define PACK_TASK_STACK         4096
+#define PACK_TASK_PRIORITY      3
+#define IO_TASK_STACK           4096
+#define IO_TASK_PRIORITY        4       // Above the packer: keep the card busy
+#define PACK_POLL_MS            10      // Ring drain period
+#define BLOCK_COUNT             2
+
+/* Packer control */
+#define CTL_START               1
+#define CTL_STOP                2
+#define CTL_QUIT                3
+
+/* I/O task messages */
+#define IO_BLOCK                0
+#define IO_STOP                 1       // Sync and close the segment, capture ended
+#define IO_QUIT                 2
+
+#define TIME_RECORD_SIZE        (sizeof(serial_log_record_t) + sizeof(uint64_t))
+
+_Static_assert(sizeof(serial_log_header_t) == 64, "header layout");
+_Static_assert(sizeof(serial_log_record_t) == 8, "record layout");
+_Static_assert(SERIAL_LOG_MAX_RECORD <= UINT16_MAX, "record length is 16-bit");
+
+/* Chunk header in a capture ring, followed by len bytes */
+typedef struct {
+    int64_t time_us;                // esp_timer time
+    uint32_t len;
+    uint32_t reserved;
+} ring_rec_t;
+
+/* Block handed to the I/O task */
+typedef struct {
+    uint8_t kind;
+    uint8_t block;
+    uint32_t len;
+    uint32_t records;               // Data records in the block
+    uint32_t payload;               // ... and their bytes
+    uint64_t time_us;               // Log time of the block's TIME record
+} io_msg_t;
+
+/* Log context */
+struct serial_log_t {
+    serial_log_config_t config;
+    byte_ring_t rings[SERIAL_LOG_SOURCES];
+    uint8_t *blocks[BLOCK_COUNT];
+    QueueHandle_t ctl_q;            // CTL_* to the packer
+    QueueHandle_t free_q;           // Block indices ready to fill
+    QueueHandle_t io_q;             // io_msg_t to the I/O task
+    SemaphoreHandle_t exited;       // Given by each task on exit
+    portMUX_TYPE lock;
+
+    /* Producers (one task per source) */
+    atomic_bool producing;
+    atomic_uint_fast32_t lost[SERIAL_LOG_SOURCES];
+
+    /* Capture parameters (set before CTL_START) */
+    char base_path[SERIAL_LOG_PATH_MAX - 16];    // Room for "_NNNN.wsl"
+    uint32_t baud_rate;
+    int64_t start_us;               // esp_timer time at log time 0
+    int64_t start_unix_us;
+
+    /* Packer task only */
+    bool active;
+    ring_rec_t pending[SERIAL_LOG_SOURCES];
+    bool has_pending[SERIAL_LOG_SOURCES];
+    uint32_t lost_seen[SERIAL_LOG_SOURCES];
+    int fill;                       // Block being filled, -1 if none
+    size_t fill_len;
+    uint64_t fill_time_us;
+    uint32_t fill_records;
+    uint32_t fill_payload;
+    bool fill_data;                 // Holds more than its TIME record
+    int64_t fill_started_us;
+    uint64_t last_us;               // Log time of the last record packed
+
+    /* I/O task only */
+    FILE *file;
+    FILE *index;
+    uint32_t segment;
+    bool opened;                    // A segment of this capture was opened
+    uint64_t seg_bytes;
+    uint64_t unsynced;
+    int64_t synced_us;
+
+    /* Shared status (lock) */
+    serial_log_status_t status;
+};
+
+/**
+ * @brief Set the state, keeping an error until the capture is stopped
+ */
+static void set_error(serial_log_t *log, esp_err_t err)
+{
+    atomic_store(&log->producing, false);
+    portENTER_CRITICAL(&log->lock);
+    log->status.state = SERIAL_LOG_ERROR;
+    log->status.last_error = err;
+    portEXIT_CRITICAL(&log->lock);
+}
+
+/* ========================================================================
+ * I/O task
+ * ======================================================================== */
+
+/**
+ * @brief Flush both files to the card
+ */
+static esp_err_t sync_segment(serial_log_t *log)
+{
+    if (fflush(log->file) != 0 || fsync(fileno(log->file)) != 0 ||
+        fflush(log->index) != 0 || fsync(fileno(log->index)) != 0) {
+        ESP_LOGE(TAG, "Sync failed in %s: %s", log->status.path, strerror(errno));
+        return ESP_FAIL;
+    }
+    log->unsynced = 0;
+    log->synced_us = esp_timer_get_time();
+    return ESP_OK;
+}
+
+/**
+ * @brief Close the open segment (synced first unless the card already failed)
+ */
+static void close_segment(serial_log_t *log, bool sync)
+{
+    if (log->file == NULL) return;
+
+    esp_err_t ret = sync ? sync_segment(log) : ESP_OK;
+    if (fclose(log->file) != 0 && ret == ESP_OK) ret = ESP_FAIL;
+    if (fclose(log->index) != 0 && ret == ESP_OK) ret = ESP_FAIL;
+    log->file = NULL;
+    log->index = NULL;
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to close %s", log->status.path);
+        if (sync) set_error(log, ret);
+    } else if (sync) {
+        ESP_LOGI(TAG, "Segment %lu closed: %llu bytes", (unsigned long)log->segment, log->seg_bytes);
+    }
+}
+
+/**
+ * @brief Open the next segment and its index, starting with a block at time_us
+ */
+static esp_err_t open_segment(serial_log_t *log, uint64_t time_us)
+{
+    if (log->opened) log->segment++;
+    log->opened = true;
+
+    char path[SERIAL_LOG_PATH_MAX];
+    char index_path[SERIAL_LOG_PATH_MAX];
+    snprintf(path, sizeof(path), "%s_%04lu%s", log->base_path, (unsigned long)log->segment, SERIAL_LOG_EXT);
+    snprintf(index_path, sizeof(index_path), "%s_%04lu%s", log->base_path, (unsigned long)log->segment,
+             SERIAL_LOG_INDEX_EXT);
+
+    portENTER_CRITICAL(&log->lock);
+    log->status.segment = log->segment;
+    memcpy(log->status.path, path, sizeof(path));
+    portEXIT_CRITICAL(&log->lock);
+
+    log->file = fopen(path, "wb");
+    log->index = (log->file != NULL) ? fopen(index_path, "wb") : NULL;
+    if (log->index == NULL) {
+        ESP_LOGE(TAG, "Failed to open %s: %s", (log->file == NULL) ? path : index_path, strerror(errno));
+        if (log->file != NULL) {
+            fclose(log->file);
+            log->file = NULL;
+        }
+        return ESP_FAIL;
+    }
+    // Blocks are large and aligned; stdio buffering would only add a copy.
+    // Index entries are 16 bytes and keep the default buffer.
+    setvbuf(log->file, NULL, _IONBF, 0);
+
+    serial_log_header_t header = {
+        .version = SERIAL_LOG_VERSION,
+        .header_size = sizeof(serial_log_header_t),
+        .segment = log->segment,
+        .baud_rate = log->baud_rate,
+        .start_unix_us = log->start_unix_us,
+        .first_time_us = time_us,
+    };
+    memcpy(header.magic, SERIAL_LOG_MAGIC, sizeof(header.magic));
+    bool ok = fwrite(&header, sizeof(header), 1, log->file) == 1;
+    memcpy(header.magic, SERIAL_LOG_INDEX_MAGIC, sizeof(header.magic));
+    ok = ok && fwrite(&header, sizeof(header), 1, log->index) == 1;
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to write the header of %s: %s", path, strerror(errno));
+        return ESP_FAIL;
+    }
+    log->seg_bytes = sizeof(header);
+    log->unsynced = sizeof(header);
+    log->synced_us = esp_timer_get_time();
+
+    portENTER_CRITICAL(&log->lock);
+    log->status.bytes_written += sizeof(header);
+    portEXIT_CRITICAL(&log->lock);
+    return ESP_OK;
+}
+
+/**
+ * @brief Write one block and its index entry, rotating first if needed
+ */
+static esp_err_t write_block(serial_log_t *log, const io_msg_t *msg)
+{
+    if (log->file == NULL ||
+        (log->seg_bytes > sizeof(serial_log_header_t) && log->seg_bytes + msg->len > log->config.segment_bytes)) {
+        close_segment(log, true);
+        esp_err_t ret = open_segment(log, msg->time_us);
+        if (ret != ESP_OK) return ret;
+    }
+
+    serial_log_index_t entry = { .time_us = msg->time_us, .offset = log->seg_bytes };
+    if (fwrite(log->blocks[msg->block], 1, msg->len, log->file) != msg->len ||
+        fwrite(&entry, sizeof(entry), 1, log->index) != 1) {
+        ESP_LOGE(TAG, "Write failed in %s: %s", log->status.path, strerror(errno));
+        return ESP_FAIL;
+    }
+    log->seg_bytes += msg->len;
+    log->unsynced += msg->len;
+
+    portENTER_CRITICAL(&log->lock);
+    log->status.records += msg->records;
+    log->status.bytes_logged += msg->payload;
+    log->status.bytes_written += msg->len;
+    portEXIT_CRITICAL(&log->lock);
+
+    if (esp_timer_get_time() - log->synced_us >= (int64_t)log->config.sync_ms * 1000) {
+        return sync_segment(log);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief I/O task: write packed blocks to the card, sync on a timer
+ */
+static void io_task(void *arg)
+{
+    serial_log_t *log = (serial_log_t *)arg;
+
+    for (;;) {
+        io_msg_t msg;
+        if (xQueueReceive(log->io_q, &msg, pdMS_TO_TICKS(log->config.sync_ms)) != pdTRUE) {
+            // Traffic stopped: put what was written on the card
+            if (log->file != NULL && log->unsynced > 0 && sync_segment(log) != ESP_OK) {
+                close_segment(log, false);
+                set_error(log, ESP_FAIL);
+            }
+            continue;
+        }
+        if (msg.kind == IO_QUIT) {
+            break;
+        }
+        if (msg.kind == IO_STOP) {
+            close_segment(log, true);
+            portENTER_CRITICAL(&log->lock);
+            log->status.state = SERIAL_LOG_IDLE;
+            portEXIT_CRITICAL(&log->lock);
+            ESP_LOGI(TAG, "Capture finished: %lu records, %llu bytes, %llu lost", (unsigned long)log->status.records,
+                     log->status.bytes_logged, log->status.lost_bytes);
+            continue;
+        }
+
+        // After a write error the backlog is discarded until the capture is stopped
+        if (log->status.state != SERIAL_LOG_ERROR) {
+            esp_err_t ret = write_block(log, &msg);
+            if (ret != ESP_OK) {
+                close_segment(log, false);
+                set_error(log, ret);
+            }
+        }
+        xQueueSend(log->free_q, &msg.block, portMAX_DELAY);
+    }
+
+    close_segment(log, true);
+    xSemaphoreGive(log->exited);
+    vTaskDelete(NULL);
+}
+
+/* ========================================================================
+ * Packer task
+ * ======================================================================== */
+
+/**
+ * @brief Hand the block being filled to the I/O task
+ */
+static void post_fill(serial_log_t *log)
+{
+    if (log->fill < 0) return;
+
+    uint8_t block = (uint8_t)log->fill;
+    log->fill = -1;
+    if (!log->fill_data) {
+        xQueueSend(log->free_q, &block, 0);
+        return;
+    }
+    io_msg_t msg = {
+        .kind = IO_BLOCK,
+        .block = block,
+        .len = (uint32_t)log->fill_len,
+        .records = log->fill_records,
+        .payload = log->fill_payload,
+        .time_us = log->fill_time_us,
+    };
+    xQueueSend(log->io_q, &msg, portMAX_DELAY);
+}
+
+/**
+ * @brief Append a record header, return its payload area
+ */
+static uint8_t *append(serial_log_t *log, uint8_t type, uint32_t delta_us, size_t len)
+{
+    uint8_t *p = log->blocks[log->fill] + log->fill_len;
+    serial_log_record_t rec = { .delta_us = delta_us, .len = (uint16_t)len, .type = type };
+    memcpy(p, &rec, sizeof(rec));
+    log->fill_len += sizeof(rec) + len;
+    return p + sizeof(rec);
+}
+
+/**
+ * @brief Append a TIME record: absolute log time for what follows
+ */
+static void put_time(serial_log_t *log, uint64_t time_us)
+{
+    memcpy(append(log, SERIAL_LOG_REC_TIME, 0, sizeof(time_us)), &time_us, sizeof(time_us));
+    log->last_us = time_us;
+}
+
+/**
+ * @brief Make room for a record in the block being filled and write its header
+ *
+ * Waits for a free block when the current one is full: the capture rings take
+ * up the time, the producers never wait.
+ *
+ * @return Where the len payload bytes go
+ */
+static uint8_t *put_record(serial_log_t *log, uint8_t type, uint64_t time_us, size_t len)
+{
+    // Chunks from different cores may be stamped slightly out of order
+    if (time_us < log->last_us) time_us = log->last_us;
+
+    if (log->fill >= 0 && log->fill_len + TIME_RECORD_SIZE + sizeof(serial_log_record_t) + len > SERIAL_LOG_BLOCK_SIZE) {
+        post_fill(log);
+    }
+    if (log->fill < 0) {
+        uint8_t block;
+        xQueueReceive(log->free_q, &block, portMAX_DELAY);
+        log->fill = block;
+        log->fill_len = 0;
+        log->fill_time_us = time_us;
+        log->fill_records = 0;
+        log->fill_payload = 0;
+        log->fill_data = false;
+        log->fill_started_us = esp_timer_get_time();
+        put_time(log, time_us);
+    } else if (time_us - log->last_us > UINT32_MAX) {
+        put_time(log, time_us);
+    }
+
+    uint32_t delta = (uint32_t)(time_us - log->last_us);
+    log->last_us = time_us;
+    log->fill_data = true;
+    return append(log, type, delta, len);
+}
+
+/**
+ * @brief Log time of a ring chunk
+ */
+static uint64_t log_time(const serial_log_t *log, int64_t time_us)
+{
+    return (time_us > log->start_us) ? (uint64_t)(time_us - log->start_us) : 0;
+}
+
+/**
+ * @brief Record bytes the producers dropped since the last LOST record
+ */
+static void put_lost(serial_log_t *log)
+{
+    for (int s = 0; s < SERIAL_LOG_SOURCES; s++) {
+        uint32_t lost = (uint32_t)atomic_load(&log->lost[s]);
+        uint32_t bytes = lost - log->lost_seen[s];
+        if (bytes == 0) continue;
+        log->lost_seen[s] = lost;
+
+        serial_log_lost_t rec = { .bytes = bytes, .source = (uint8_t)s };
+        memcpy(put_record(log, SERIAL_LOG_REC_LOST, log->last_us, sizeof(rec)), &rec, sizeof(rec));
+
+        portENTER_CRITICAL(&log->lock);
+        log->status.lost_bytes += bytes;
+        portEXIT_CRITICAL(&log->lock);
+    }
+}
+
+/**
+ * @brief Move everything in the rings into blocks, oldest chunk first
+ */
+static void pack(serial_log_t *log)
+{
+    for (;;) {
+        int next = -1;
+        for (int s = 0; s < SERIAL_LOG_SOURCES; s++) {
+            if (!log->has_pending[s] && byte_ring_used(&log->rings[s]) >= sizeof(ring_rec_t)) {
+                byte_ring_read(&log->rings[s], &log->pending[s], sizeof(ring_rec_t));
+                log->has_pending[s] = true;
+            }
+            if (log->has_pending[s] && (next < 0 || log->pending[s].time_us < log->pending[next].time_us)) {
+                next = s;
+            }
+        }
+        if (next < 0) break;
+
+        // The ring holds a chunk's header and bytes together
+        const ring_rec_t *rec = &log->pending[next];
+        uint8_t *payload = put_record(log, (uint8_t)next, log_time(log, rec->time_us), rec->len);
+        byte_ring_read(&log->rings[next], payload, rec->len);
+        log->fill_records++;
+        log->fill_payload += rec->len;
+        log->has_pending[next] = false;
+    }
+    put_lost(log);
+}
+
+/**
+ * @brief Packer task: merge the capture rings into blocks
+ */
+static void pack_task(void *arg)
+{
+    serial_log_t *log = (serial_log_t *)arg;
+
+    for (;;) {
+        uint8_t ctl = 0;
+        xQueueReceive(log->ctl_q, &ctl, pdMS_TO_TICKS(PACK_POLL_MS));
+
+        if (ctl == CTL_START) {
+            for (int s = 0; s < SERIAL_LOG_SOURCES; s++) {
+                byte_ring_discard(&log->rings[s]);
+                log->has_pending[s] = false;
+                log->lost_seen[s] = (uint32_t)atomic_load(&log->lost[s]);
+            }
+            log->last_us = 0;
+            log->active = true;
+
+            struct timeval tv;
+            gettimeofday(&tv, NULL);
+            portENTER_CRITICAL(&log->lock);
+            log->start_us = esp_timer_get_time();
+            portEXIT_CRITICAL(&log->lock);
+            log->start_unix_us = (tv.tv_sec > 1600000000) ? (int64_t)tv.tv_sec * 1000000 + tv.tv_usec : 0;
+            atomic_store(&log->producing, true);
+            continue;
+        }
+        if (ctl == CTL_QUIT) {
+            break;
+        }
+        if (!log->active) continue;
+
+        pack(log);
+        if (ctl == CTL_STOP) {
+            // Producers were stopped before CTL_STOP was sent
+            log->active = false;
+            post_fill(log);
+            io_msg_t msg = { .kind = IO_STOP };
+            xQueueSend(log->io_q, &msg, portMAX_DELAY);
+        } else if (log->fill >= 0 && log->fill_data &&
+                   esp_timer_get_time() - log->fill_started_us >= (int64_t)log->config.flush_ms * 1000) {
+            post_fill(log);
+        }
+    }
+
+    io_msg_t msg = { .kind = IO_QUIT };
+    xQueueSend(log->io_q, &msg, portMAX_DELAY);
+    xSemaphoreGive(log->exited);
+    vTaskDelete(NULL);
+}
+
+/* ========================================================================
+ * API
+ * ======================================================================== */
+
+/**
+ * @brief Release rings, blocks, queues and semaphore
+ */
+static void free_resources(serial_log_t *log)
+{
+    for (int s = 0; s < SERIAL_LOG_SOURCES; s++) {
+        byte_ring_deinit(&log->rings[s]);
+    }
+    for (int i = 0; i < BLOCK_COUNT; i++) {
+        if (log->blocks[i]) heap_caps_free(log->blocks[i]);
+    }
+    if (log->ctl_q) vQueueDelete(log->ctl_q);
+    if (log->free_q) vQueueDelete(log->free_q);
+    if (log->io_q) vQueueDelete(log->io_q);
+    if (log->exited) vSemaphoreDelete(log->exited);
+    heap_caps_free(log);
+}
+
+/**
+ * @brief Allocate the rings and block buffers and start the tasks
+ */
+esp_err_t serial_log_create(const serial_log_config_t *config, serial_log_t **out)
+{
+    if (out == NULL) return ESP_ERR_INVALID_ARG;
+
+    serial_log_t *log = heap_caps_calloc(1, sizeof(serial_log_t), MALLOC_CAP_8BIT);
+    if (log == NULL) return ESP_ERR_NO_MEM;
+
+    if (config != NULL) {
+        log->config = *config;
+    } else {
+        log->config = (serial_log_config_t)SERIAL_LOG_CONFIG_DEFAULT();
+    }
+    if (log->config.segment_bytes < 4 * SERIAL_LOG_BLOCK_SIZE) log->config.segment_bytes = 4 * SERIAL_LOG_BLOCK_SIZE;
+    if (log->config.flush_ms < PACK_POLL_MS) log->config.flush_ms = PACK_POLL_MS;
+    if (log->config.sync_ms < log->config.flush_ms) log->config.sync_ms = log->config.flush_ms;
+
+    portMUX_INITIALIZE(&log->lock);
+    log->fill = -1;
+
+    bool ok = true;
+    for (int s = 0; s < SERIAL_LOG_SOURCES; s++) {
+        // A ring must hold at least one full record
+        size_t size = log->config.ring_size[s];
+        if (size < 2 * (sizeof(ring_rec_t) + SERIAL_LOG_MAX_RECORD)) size = 2 * (sizeof(ring_rec_t) + SERIAL_LOG_MAX_RECORD);
+        ok = ok && byte_ring_init(&log->rings[s], size) == ESP_OK;
+    }
+    for (int i = 0; i < BLOCK_COUNT && ok; i++) {
+        // Internal DMA memory lets the SD driver write without a bounce copy
+        log->blocks[i] = heap_caps_aligned_alloc(64, SERIAL_LOG_BLOCK_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+        if (log->blocks[i] == NULL) {
+            log->blocks[i] = heap_caps_aligned_alloc(64, SERIAL_LOG_BLOCK_SIZE, MALLOC_CAP_SPIRAM);
+        }
+        ok = log->blocks[i] != NULL;
+    }
+    log->ctl_q = xQueueCreate(4, sizeof(uint8_t));
+    log->free_q = xQueueCreate(BLOCK_COUNT, sizeof(uint8_t));
+    log->io_q = xQueueCreate(BLOCK_COUNT + 2, sizeof(io_msg_t));
+    log->exited = xSemaphoreCreateCounting(2, 0);
+    if (!ok || log->ctl_q == NULL || log->free_q == NULL || log->io_q == NULL || log->exited == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate capture buffers");
+        free_resources(log);
+        return ESP_ERR_NO_MEM;
+    }
+    for (uint8_t i = 0; i < BLOCK_COUNT; i++) {
+        xQueueSend(log->free_q, &i, 0);
+    }
+
+    if (xTaskCreate(io_task, "serial_log_io", IO_TASK_STACK, log, IO_TASK_PRIORITY, NULL) != pdPASS) {
+        free_resources(log);
+        return ESP_ERR_NO_MEM;
+    }
+    if (xTaskCreate(pack_task, "serial_log", PACK_TASK_STACK, log, PACK_TASK_PRIORITY, NULL) != pdPASS) {
+        io_msg_t msg = { .kind = IO_QUIT };
+        xQueueSend(log->io_q, &msg, portMAX_DELAY);
+        xSemaphoreTake(log->exited, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(10));  // Let the I/O task exit
+        free_resources(log);
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Capture ready: %u/%u/%u KB rings, 2 x %u KB blocks",
+             (unsigned)(log->rings[0].size / 1024), (unsigned)(log->rings[1].size / 1024),
+             (unsigned)(log->rings[2].size / 1024), SERIAL_LOG_BLOCK_SIZE / 1024);
+    *out = log;
+    return ESP_OK;
+}
+
+/**
+ * @brief Stop a capture, write it out and free the log
+ */
+void serial_log_destroy(serial_log_t *log)
+{
+    if (log == NULL) return;
+
+    serial_log_stop(log);
+    uint8_t ctl = CTL_QUIT;
+    xQueueSend(log->ctl_q, &ctl, portMAX_DELAY);
+    xSemaphoreTake(log->exited, portMAX_DELAY);
+    xSemaphoreTake(log->exited, portMAX_DELAY);
+    vTaskDelay(pdMS_TO_TICKS(10));  // Let the tasks exit
+
+    free_resources(log);
+}
+
+/**
+ * @brief Start a capture
+ */
+esp_err_t serial_log_start(serial_log_t *log, const char *base_path, uint32_t baud_rate)
+{
+    if (log == NULL || base_path == NULL) return ESP_ERR_INVALID_ARG;
+
+    portENTER_CRITICAL(&log->lock);
+    bool idle = (log->status.state == SERIAL_LOG_IDLE);
+    portEXIT_CRITICAL(&log->lock);
+    if (!idle) return ESP_ERR_INVALID_STATE;
+
+    // The tasks are between captures: the I/O side is ours until CTL_START
+    snprintf(log->base_path, sizeof(log->base_path), "%s", base_path);
+    log->baud_rate = baud_rate;
+    log->segment = 0;
+    log->opened = false;
+
+    portENTER_CRITICAL(&log->lock);
+    memset(&log->status, 0, sizeof(log->status));
+    log->status.state = SERIAL_LOG_LOGGING;
+    log->status.last_error = ESP_OK;
+    portEXIT_CRITICAL(&log->lock);
+
+    uint8_t ctl = CTL_START;
+    xQueueSend(log->ctl_q, &ctl, portMAX_DELAY);
+    ESP_LOGI(TAG, "Logging to %s_NNNN%s", base_path, SERIAL_LOG_EXT);
+    return ESP_OK;
+}
+
+/**
+ * @brief Stop the capture
+ */
+void serial_log_stop(serial_log_t *log)
+{
+    if (log == NULL) return;
+
+    portENTER_CRITICAL(&log->lock);
+    serial_log_state_t state = log->status.state;
+    if (state == SERIAL_LOG_LOGGING) {
+        log->status.state = SERIAL_LOG_FINISHING;
+    }
+    portEXIT_CRITICAL(&log->lock);
+    if (state != SERIAL_LOG_LOGGING && state != SERIAL_LOG_ERROR) return;
+
+    atomic_store(&log->producing, false);
+    uint8_t ctl = CTL_STOP;
+    xQueueSend(log->ctl_q, &ctl, portMAX_DELAY);
+}
+
+/**
+ * @brief Capture a chunk (never blocks; one task per source)
+ */
+void serial_log_write(serial_log_t *log, serial_log_source_t source, const void *data, size_t len)
+{
+    if (log == NULL || (unsigned)source >= SERIAL_LOG_SOURCES || len == 0 ||
+        !atomic_load_explicit(&log->producing, memory_order_acquire)) {
+        return;
+    }
+
+    ring_rec_t rec = { .time_us = esp_timer_get_time() };
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0) {
+        rec.len = (len > SERIAL_LOG_MAX_RECORD) ? SERIAL_LOG_MAX_RECORD : (uint32_t)len;
+        if (!byte_ring_write_record(&log->rings[source], &rec, sizeof(rec), p, rec.len)) {
+            atomic_fetch_add(&log->lost[source], rec.len);
+        }
+        p += rec.len;
+        len -= rec.len;
+    }
+}
+
+/**
+ * @brief Get log status
+ */
+void serial_log_get_status(serial_log_t *log, serial_log_status_t *status)
+{
+    if (log == NULL || status == NULL) return;
+
+    portENTER_CRITICAL(&log->lock);
+    *status = log->status;
+    int64_t elapsed_us = esp_timer_get_time() - log->start_us;
+    portEXIT_CRITICAL(&log->lock);
+
+    size_t backlog = 0;
+    for (int s = 0; s < SERIAL_LOG_SOURCES; s++) {
+        backlog += byte_ring_used(&log->rings[s]);
+    }
+    status->backlog = (uint32_t)backlog;
+    status->write_kbps = (status->state == SERIAL_LOG_LOGGING && elapsed_us > 0) ?
+                         (uint32_t)(status->bytes_written * 1000000ULL / 1024 / (uint64_t)elapsed_us) : 0;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file serial_log.h
+ * @brief Timestamped capture of wireless serial traffic to SD card
+ *
+ * Every chunk read from the UART, received from the network or sent from the
+ * screen is handed to serial_log_write() by the task that has it. The call
+ * stamps it (esp_timer, microseconds) and copies it into a lock-free ring of
+ * its own source; it never waits, and a chunk that does not fit is dropped
+ * and counted. A pack task merges the rings in time order into one of two
+ * block buffers while an I/O task writes the other to the card, so SD
+ * latency is taken up by the rings, never by the RX path.
+ *
+ * A log is a series of segments <base>_0000.wsl, <base>_0001.wsl, ... rotated
+ * at a size limit, each with an index <base>_NNNN.wsx beside it:
+ *
+ *   .wsl  serial_log_header_t, then records: serial_log_record_t + payload
+ *   .wsx  serial_log_header_t (magic SERIAL_LOG_INDEX_MAGIC), then one
+ *         serial_log_index_t per block
+ *
+ * Record times are deltas from the previous record. Every block starts with
+ * a SERIAL_LOG_REC_TIME record carrying the absolute log time, so decoding
+ * can begin at any offset listed in the index. A block is written once full
+ * or flush_ms after its first record, and the files are synced every
+ * sync_ms, so a power loss costs at most the last few seconds.
+ * tools/serial_log.py turns logs into timestamped text.
+ */
+
+#ifndef SERIAL_LOG_H
+#define SERIAL_LOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SERIAL_LOG_MAGIC            "WSLG"
+#define SERIAL_LOG_INDEX_MAGIC      "WSLX"
+#define SERIAL_LOG_VERSION          1
+#define SERIAL_LOG_EXT              ".wsl"
+#define SERIAL_LOG_INDEX_EXT        ".wsx"
+#define SERIAL_LOG_PATH_MAX         96
+
+#define SERIAL_LOG_BLOCK_SIZE       (32 * 1024)     // Bytes per block buffer (two are allocated)
+#define SERIAL_LOG_MAX_RECORD       2048            // Payload bytes per record; longer chunks are split
+
+/* Sources; each one is written by a single task */
+typedef enum {
+    SERIAL_LOG_UART_RX = 0,         // From the device (UART bridge receive task)
+    SERIAL_LOG_NET_RX,              // From the network (network task); to the device with passthrough on
+    SERIAL_LOG_LOCAL_TX,            // Sent from the screen (LVGL thread)
+    SERIAL_LOG_SOURCES,
+} serial_log_source_t;
+
+/* Record types besides the sources */
+#define SERIAL_LOG_REC_TIME         0x80    // Payload: uint64_t log time (us); delta_us is 0
+#define SERIAL_LOG_REC_LOST         0x81    // Payload: serial_log_lost_t
+
+/* Segment and index file header */
+typedef struct __attribute__((packed)) {
+    char magic[4];
+    uint16_t version;
+    uint16_t header_size;           // Records / index entries start here
+    uint32_t segment;               // Segment number, from 0
+    uint32_t baud_rate;             // UART rate when the log started (0 = UART not in use)
+    int64_t start_unix_us;          // Wall clock at log time 0 (0 = clock not set)
+    uint64_t first_time_us;         // Log time of the segment's first record
+    uint8_t reserved[32];
+} serial_log_header_t;
+
+/* Record header, followed by len payload bytes */
+typedef struct __attribute__((packed)) {
+    uint32_t delta_us;              // Log time since the previous record
+    uint16_t len;
+    uint8_t type;                   // serial_log_source_t or SERIAL_LOG_REC_*
+    uint8_t flags;                  // 0
+} serial_log_record_t;
+
+/* Bytes of a source dropped since its previous LOST record (capture ring full) */
+typedef struct __attribute__((packed)) {
+    uint32_t bytes;
+    uint8_t source;
+    uint8_t reserved[3];
+} serial_log_lost_t;
+
+/* Index entry: a block, which starts with a SERIAL_LOG_REC_TIME record */
+typedef struct __attribute__((packed)) {
+    uint64_t time_us;
+    uint64_t offset;                // Segment file offset
+} serial_log_index_t;
+
+/* Log configuration */
+typedef struct {
+    size_t ring_size[SERIAL_LOG_SOURCES];   // Capture ring per source (PSRAM first)
+    uint64_t segment_bytes;         // Rotate after this many bytes
+    uint32_t flush_ms;              // Longest a record waits in RAM
+    uint32_t sync_ms;               // fsync period
+} serial_log_config_t;
+
+/* Defaults: ~0.5 s of 4 Mbit/s UART data in flight, 1 GB segments */
+#define SERIAL_LOG_CONFIG_DEFAULT() {                               \
+    .ring_size = { 256 * 1024, 64 * 1024, 8 * 1024 },               \
+    .segment_bytes = 1024ull * 1024ull * 1024ull,                   \
+    .flush_ms = 1000,                                               \
+    .sync_ms = 5000,                                                \
+}
+
+/* Log state */
+typedef enum {
+    SERIAL_LOG_IDLE = 0,
+    SERIAL_LOG_LOGGING,
+    SERIAL_LOG_FINISHING,           // Stopped, backlog still being written
+    SERIAL_LOG_ERROR,               // Write failed; capture ended
+} serial_log_state_t;
+
+/* Log status */
+typedef struct {
+    serial_log_state_t state;
+    uint32_t segment;               // Segment being written
+    uint32_t records;               // Data records written
+    uint64_t bytes_logged;          // Payload bytes written
+    uint64_t bytes_written;         // File bytes written (all segments)
+    uint64_t lost_bytes;            // Payload bytes dropped
+    uint32_t backlog;               // Bytes waiting in the rings
+    uint32_t write_kbps;            // Since the start
+    esp_err_t last_error;
+    char path[SERIAL_LOG_PATH_MAX]; // Current / last segment
+} serial_log_status_t;
+
+/* Log context (opaque) */
+typedef struct serial_log_t serial_log_t;
+
+/**
+ * @brief Allocate the rings and block buffers and start the tasks
+ *
+ * @param config Configuration (copied, NULL for defaults)
+ * @param out Log handle
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t serial_log_create(const serial_log_config_t *config, serial_log_t **out);
+
+/**
+ * @brief Stop a capture, write it out and free the log
+ */
+void serial_log_destroy(serial_log_t *log);
+
+/**
+ * @brief Start a capture
+ *
+ * Segments are named base_path + "_%04u" + SERIAL_LOG_EXT.
+ *
+ * @param base_path Path without extension (copied, up to SERIAL_LOG_PATH_MAX - 17 characters)
+ * @param baud_rate UART rate for the header (0 if unknown)
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if a capture is still running or finishing
+ */
+esp_err_t serial_log_start(serial_log_t *log, const char *base_path, uint32_t baud_rate);
+
+/**
+ * @brief Stop the capture
+ *
+ * Returns at once; the backlog is written and the segment closed by the
+ * tasks (state FINISHING, then IDLE).
+ */
+void serial_log_stop(serial_log_t *log);
+
+/**
+ * @brief Capture a chunk (never blocks; one task per source)
+ */
+void serial_log_write(serial_log_t *log, serial_log_source_t source, const void *data, size_t len);
+
+/**
+ * @brief Get log status
+ */
+void serial_log_get_status(serial_log_t *log, serial_log_status_t *status);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SERIAL_LOG_H */
@@ -0,0 +1,249 @@
+/**
+ * @file tcp_out.c
+ * @brief Per-connection TCP output buffer with send coalescing
+ */
+
+#include "tcp_out.h"
+#include "esp_timer.h"
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <errno.h>
+#include <fcntl.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#ifndef MSG_MORE
+#define MSG_MORE 0
+#endif
+
+/* Per mode: bytes that make a size-triggered send, longest hold */
+static const struct {
+    size_t batch;
+    int64_t hold_us;
+} s_modes[] = {
+    [TCP_OUT_IMMEDIATE] = { 1, 0 },
+    [TCP_OUT_COALESCED] = { TCP_OUT_SEGMENT, TCP_OUT_COALESCE_MS * 1000 },
+    [TCP_OUT_BULK] = { TCP_OUT_BULK_SEGMENTS * TCP_OUT_SEGMENT, TCP_OUT_BULK_MS * 1000 },
+};
+
+/* Of `pending` bytes first held at held_us, how many go out now */
+static size_t due_bytes(const tcp_out_t *out, size_t pending, int64_t held_us, int64_t now)
+{
+    if (pending == 0 || out->mode == TCP_OUT_IMMEDIATE) return pending;
+    if (held_us != 0 && now - held_us >= s_modes[out->mode].hold_us) return pending;
+    if (pending >= s_modes[out->mode].batch) return pending - pending % TCP_OUT_SEGMENT;
+    return 0;
+}
+
+/**
+ * @brief One non-blocking send()
+ *
+ * @param more More bytes follow at once (lets the stack fill the segment)
+ * @return Bytes sent; 0 if the socket is full or failed (then out->failed is set)
+ */
+static size_t send_some(tcp_out_t *out, const uint8_t *data, size_t len, bool more)
+{
+    ssize_t sent = send(out->fd, data, len, MSG_DONTWAIT | MSG_NOSIGNAL | (more ? MSG_MORE : 0));
+    if (sent < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            out->failed = true;
+        }
+        return 0;
+    }
+    out->sent += (size_t)sent;
+    out->stats.sends++;
+    out->stats.bytes += (uint32_t)sent;
+    return (size_t)sent;
+}
+
+/* Record the latency of every stamped write now sent in full */
+static void record_latency(tcp_out_t *out)
+{
+    if (out->stamp_tail == out->stamp_head) return;
+
+    int64_t now = esp_timer_get_time();
+    while (out->stamp_tail != out->stamp_head) {
+        const tcp_out_stamp_t *stamp = &out->stamps[out->stamp_tail % TCP_OUT_STAMPS];
+        if ((ptrdiff_t)(out->sent - stamp->end) < 0) break;
+        if (out->latency != NULL) {
+            int64_t us = now - stamp->us;
+            latency_hist_add(out->latency, us > 0 ? (uint32_t)(us < UINT32_MAX ? us : UINT32_MAX) : 0);
+        }
+        out->stamp_tail++;
+    }
+}
+
+/**
+ * @brief Allocate the queue
+ */
+esp_err_t tcp_out_init(tcp_out_t *out, size_t size)
+{
+    *out = (tcp_out_t){ .fd = -1 };
+    return byte_ring_init(&out->queue, size);
+}
+
+/**
+ * @brief Free the queue
+ */
+void tcp_out_deinit(tcp_out_t *out)
+{
+    byte_ring_deinit(&out->queue);
+    out->fd = -1;
+}
+
+/**
+ * @brief Start serving a connected socket
+ */
+void tcp_out_attach(tcp_out_t *out, int fd, tcp_out_mode_t mode, latency_hist_t *latency)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    int opt = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+
+    tcp_out_detach(out);
+    out->fd = fd;
+    out->mode = mode;
+    out->latency = latency;
+    out->stats = (tcp_out_stats_t){ 0 };
+}
+
+/**
+ * @brief Let go of the socket and throw away what is queued
+ */
+void tcp_out_detach(tcp_out_t *out)
+{
+    out->fd = -1;
+    out->failed = false;
+    byte_ring_discard(&out->queue);
+    out->queued = 0;
+    out->sent = 0;
+    out->held_us = 0;
+    out->stamp_head = 0;
+    out->stamp_tail = 0;
+}
+
+/**
+ * @brief Change the mode
+ */
+void tcp_out_set_mode(tcp_out_t *out, tcp_out_mode_t mode)
+{
+    out->mode = mode;
+}
+
+/**
+ * @brief Queue bytes, sending what is due at once
+ */
+size_t tcp_out_write(tcp_out_t *out, const void *data, size_t len, int64_t stamp_us)
+{
+    if (out->fd < 0 || len == 0) return 0;
+    if (out->failed) return len;   /* Closed on the next flush */
+
+    const uint8_t *bytes = data;
+    size_t taken = 0;
+    int64_t now = esp_timer_get_time();
+
+    /* Nothing queued ahead: what is due goes out from the caller's memory */
+    if (byte_ring_used(&out->queue) == 0) {
+        size_t due = due_bytes(out, len, 0, now);
+        if (due > 0) {
+            taken = send_some(out, bytes, due, false);
+        }
+        if (out->failed) return len;
+    }
+
+    if (taken < len) {
+        if (byte_ring_used(&out->queue) == 0) out->held_us = now;
+        size_t stored = byte_ring_write(&out->queue, bytes + taken, len - taken);
+        out->stats.dropped += (uint32_t)(len - taken - stored);
+        taken += stored;
+    }
+    out->queued += taken;
+
+    /* Stamps that run out leave the write unmeasured */
+    if (stamp_us != 0 && taken > 0 && out->stamp_head - out->stamp_tail < TCP_OUT_STAMPS) {
+        out->stamps[out->stamp_head % TCP_OUT_STAMPS] = (tcp_out_stamp_t){ .end = out->queued, .us = stamp_us };
+        out->stamp_head++;
+    }
+    record_latency(out);
+    return taken;
+}
+
+/**
+ * @brief Send what is due until the socket is full
+ */
+bool tcp_out_flush(tcp_out_t *out, bool all)
+{
+    if (out->fd < 0) return true;
+    if (out->failed) return false;
+
+    size_t pending = byte_ring_used(&out->queue);
+    size_t due = all ? pending : due_bytes(out, pending, out->held_us, esp_timer_get_time());
+    const uint8_t *data;
+    size_t n;
+    while (due > 0 && (n = byte_ring_peek(&out->queue, &data)) > 0) {
+        if (n > due) n = due;
+        size_t sent = send_some(out, data, n, n < due);
+        byte_ring_consume(&out->queue, sent);
+        due -= sent;
+        if (sent < n) break;
+    }
+
+    if (byte_ring_used(&out->queue) == 0) out->held_us = 0;
+    record_latency(out);
+    return !out->failed;
+}
+
+/**
+ * @brief Milliseconds until queued bytes are due
+ */
+int tcp_out_due_ms(const tcp_out_t *out)
+{
+    size_t pending = byte_ring_used(&out->queue);
+    if (pending == 0) return -1;
+
+    int64_t now = esp_timer_get_time();
+    if (due_bytes(out, pending, out->held_us, now) > 0) return 0;
+
+    int64_t left_us = s_modes[out->mode].hold_us - (now - out->held_us);
+    return left_us > 0 ? (int)((left_us + 999) / 1000) : 0;
+}
+
+/**
+ * @brief Room in the queue
+ */
+size_t tcp_out_space(const tcp_out_t *out)
+{
+    return out->queue.size - byte_ring_used(&out->queue);
+}
+
+/**
+ * @brief Bytes waiting to be sent
+ */
+size_t tcp_out_pending(const tcp_out_t *out)
+{
+    return byte_ring_used(&out->queue);
+}
+
+/**
+ * @brief Get counters
+ */
+void tcp_out_get_stats(const tcp_out_t *out, tcp_out_stats_t *stats)
+{
+    *stats = out->stats;
+}
+
+/**
+ * @brief Short name of a mode
+ */
+const char *tcp_out_mode_name(tcp_out_mode_t mode)
+{
+    switch (mode) {
+    case TCP_OUT_IMMEDIATE: return "immediate";
+    case TCP_OUT_COALESCED: return "coalesced";
+    case TCP_OUT_BULK:      return "bulk";
+    default:                return "?";
+    }
+}
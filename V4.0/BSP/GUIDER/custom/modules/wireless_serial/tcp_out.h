@@ -0,0 +1,171 @@
+/**
+ * @file tcp_out.h
+ * @brief Per-connection TCP output buffer with send coalescing
+ *
+ * Everything bound for one socket goes through a tcp_out_t: a byte queue in
+ * front of a non-blocking socket that decides when the bytes go out.
+ *
+ *   TCP_OUT_IMMEDIATE  every write is sent at once (one segment per write)
+ *   TCP_OUT_COALESCED  held until a full segment is waiting or the oldest
+ *                      byte is TCP_OUT_COALESCE_MS old
+ *   TCP_OUT_BULK       held until TCP_OUT_BULK_SEGMENTS segments are waiting
+ *                      or the oldest byte is TCP_OUT_BULK_MS old
+ *
+ * Size-triggered sends take whole segments only and leave the tail for its
+ * timer. Nagle is off in every mode: the buffer does the coalescing, so the
+ * stack never holds a short tail segment back for a delayed ACK. A write that
+ * finds the queue empty and is due at once goes to send() in place, without
+ * being copied.
+ *
+ * Writes may carry the time their first byte was read from the UART; when
+ * the last of those bytes has been handed to send() the time since then is
+ * recorded in a latency_hist_t (UART byte in -> TCP segment out).
+ *
+ * One task owns a tcp_out_t; only the histogram is read from elsewhere.
+ */
+
+#ifndef TCP_OUT_H
+#define TCP_OUT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include "byte_ring.h"
+#include "latency_hist.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Payload of a full segment (Ethernet MTU less IP and TCP headers) */
+#define TCP_OUT_SEGMENT         1460
+
+/** Coalesced mode: longest hold */
+#define TCP_OUT_COALESCE_MS     2
+
+/** Bulk mode: segments per send and longest hold */
+#define TCP_OUT_BULK_SEGMENTS   4
+#define TCP_OUT_BULK_MS         20
+
+/** Writes in flight that can carry a latency stamp */
+#define TCP_OUT_STAMPS          32
+
+/* When queued bytes are sent */
+typedef enum {
+    TCP_OUT_IMMEDIATE = 0,
+    TCP_OUT_COALESCED,
+    TCP_OUT_BULK,
+} tcp_out_mode_t;
+
+/* Counters since tcp_out_attach() */
+typedef struct {
+    uint32_t sends;                 // send() calls that moved data
+    uint32_t bytes;                 // Bytes sent
+    uint32_t dropped;               // Bytes the full queue could not take
+} tcp_out_stats_t;
+
+/* Stamped write: UART read time of the bytes up to queue offset `end` */
+typedef struct {
+    size_t end;
+    int64_t us;
+} tcp_out_stamp_t;
+
+/* Output buffer (fields are private; use the functions below) */
+typedef struct {
+    int fd;                         // -1 while detached
+    tcp_out_mode_t mode;
+    bool failed;                    // send() failed; reported by tcp_out_flush()
+    byte_ring_t queue;
+    size_t queued;                  // Bytes written (free-running)
+    size_t sent;                    // Bytes sent (free-running)
+    int64_t held_us;                // Oldest queued byte was written at, 0 if empty
+    tcp_out_stamp_t stamps[TCP_OUT_STAMPS];
+    size_t stamp_head;
+    size_t stamp_tail;
+    latency_hist_t *latency;        // May be NULL
+    tcp_out_stats_t stats;
+} tcp_out_t;
+
+/**
+ * @brief Allocate the queue (PSRAM first, internal RAM otherwise)
+ *
+ * @param out Buffer to set up, detached
+ * @param size Queue capacity in bytes (rounded up to a power of two)
+ * @return ESP_OK, ESP_ERR_NO_MEM
+ */
+esp_err_t tcp_out_init(tcp_out_t *out, size_t size);
+
+/**
+ * @brief Free the queue
+ */
+void tcp_out_deinit(tcp_out_t *out);
+
+/**
+ * @brief Start serving a connected socket
+ *
+ * Makes fd non-blocking, turns Nagle off and clears the queue and counters.
+ * The socket stays the caller's to close.
+ *
+ * @param latency Histogram for stamped writes, NULL for none
+ */
+void tcp_out_attach(tcp_out_t *out, int fd, tcp_out_mode_t mode, latency_hist_t *latency);
+
+/**
+ * @brief Let go of the socket and throw away what is queued
+ */
+void tcp_out_detach(tcp_out_t *out);
+
+/**
+ * @brief Change the mode; bytes held under the old one follow the new one
+ */
+void tcp_out_set_mode(tcp_out_t *out, tcp_out_mode_t mode);
+
+/**
+ * @brief Queue bytes, sending what is due at once
+ *
+ * @param stamp_us esp_timer time the first byte was read from the UART, 0 if not measured
+ * @return Bytes taken; the rest did not fit and is counted as dropped
+ */
+size_t tcp_out_write(tcp_out_t *out, const void *data, size_t len, int64_t stamp_us);
+
+/**
+ * @brief Send what is due until the socket is full
+ *
+ * @param all Send everything queued, due or not
+ * @return false if the connection failed (here or in an earlier write)
+ */
+bool tcp_out_flush(tcp_out_t *out, bool all);
+
+/**
+ * @brief Milliseconds until queued bytes are due
+ *
+ * @return 0 to send now (poll for POLLOUT), the poll timeout to honour, -1 if empty
+ */
+int tcp_out_due_ms(const tcp_out_t *out);
+
+/**
+ * @brief Room in the queue
+ */
+size_t tcp_out_space(const tcp_out_t *out);
+
+/**
+ * @brief Bytes waiting to be sent
+ */
+size_t tcp_out_pending(const tcp_out_t *out);
+
+/**
+ * @brief Get counters
+ */
+void tcp_out_get_stats(const tcp_out_t *out, tcp_out_stats_t *stats);
+
+/**
+ * @brief Short name of a mode
+ */
+const char *tcp_out_mode_name(tcp_out_mode_t mode);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TCP_OUT_H */
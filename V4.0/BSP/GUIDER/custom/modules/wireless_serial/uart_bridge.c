@@ -0,0 +1,532 @@
+/**
+ * @file uart_bridge.c
+ * @brief UART <-> network bridge engine driven by the UART driver event queue
+ */
+
+#include "uart_bridge.h"
+#include "byte_ring.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_vfs_eventfd.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "driver/uart.h"
+#include <sys/poll.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *TAG = "UartBridge";
+
+#define EVENT_QUEUE_LEN     32
+#define STAMP_COUNT         256         /* Power of two */
+#define BACKLOG_RETRY_MS    2           /* Ring full under flow control: read again after */
+#define STOP_TIMEOUT_MS     500
+
+/* Arrival time of the UART bytes up to rx offset `end` */
+typedef struct {
+    size_t end;
+    int64_t us;
+} rx_stamp_t;
+
+/* Bridge context */
+struct uart_bridge_t {
+    uart_bridge_config_t config;
+    QueueHandle_t events;
+    TaskHandle_t rx_task;
+    TaskHandle_t tx_task;
+    atomic_bool running;
+    atomic_int tasks;                   // Bridge tasks still running
+    int wake_fd;
+    atomic_bool wake_pending;           // wake_fd signalled and not cleared yet
+
+    byte_ring_t rx;                     // UART -> network
+    byte_ring_t tx;                     // Network -> UART
+    uint8_t chunk[UART_BRIDGE_CHUNK_SIZE];  // Receive task only
+    bool rx_backlog;                    // Receive task: data left in the driver
+
+    /* Receive task -> network task, SPSC like the rings */
+    rx_stamp_t stamps[STAMP_COUNT];
+    atomic_size_t stamp_head;
+    atomic_size_t stamp_tail;
+    atomic_size_t rx_in;                // Bytes stored in rx (free-running)
+    atomic_size_t flush_end;            // rx offset up to which flush_char was seen
+    size_t rx_out;                      // Network task: bytes consumed
+
+    /* Counters */
+    atomic_uint_fast32_t uart_rx;
+    atomic_uint_fast32_t uart_tx;
+    atomic_uint_fast32_t net_tx;
+    atomic_uint_fast32_t net_rx;
+    atomic_uint_fast32_t overflows;
+    atomic_uint_fast32_t line_errors;
+    atomic_uint_fast32_t batches;
+    atomic_uint_fast32_t latency_sum_us;
+    atomic_uint_fast32_t latency_count;
+    atomic_uint_fast32_t latency_max_us;
+
+    /* uart_bridge_get_stats() caller only */
+    int64_t rate_since_us;
+    uint32_t rate_rx;
+    uint32_t rate_tx;
+};
+
+/* ========================================================================
+ * Wake-up
+ * ======================================================================== */
+
+static void signal_wake(uart_bridge_t *bridge, bool force)
+{
+    if (atomic_exchange(&bridge->wake_pending, true) && !force) return;
+
+    uint64_t one = 1;
+    write(bridge->wake_fd, &one, sizeof(one));
+}
+
+/* Clear wake_fd without blocking (the eventfd read would wait if it is not set) */
+static void clear_wake(uart_bridge_t *bridge)
+{
+    atomic_store(&bridge->wake_pending, false);
+
+    struct pollfd pfd = { .fd = bridge->wake_fd, .events = POLLIN };
+    if (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) {
+        uint64_t value;
+        read(bridge->wake_fd, &value, sizeof(value));
+    }
+}
+
+/* ========================================================================
+ * Receive task
+ * ======================================================================== */
+
+/* Store one chunk read from the driver and tell the network task */
+static void publish(uart_bridge_t *bridge, const uint8_t *data, size_t len)
+{
+    if (bridge->config.on_uart_data) {
+        bridge->config.on_uart_data(data, len, bridge->config.user);
+    }
+    atomic_fetch_add(&bridge->uart_rx, len);
+
+    size_t waiting = byte_ring_used(&bridge->rx);
+    size_t stored = byte_ring_write(&bridge->rx, data, len);
+    if (stored == 0) return;
+
+    size_t end = atomic_load(&bridge->rx_in) + stored;
+    atomic_store(&bridge->rx_in, end);
+
+    // Stamp the chunk; if the stamps run out the next one covers these bytes
+    size_t head = atomic_load_explicit(&bridge->stamp_head, memory_order_relaxed);
+    if (head - atomic_load_explicit(&bridge->stamp_tail, memory_order_acquire) < STAMP_COUNT) {
+        bridge->stamps[head & (STAMP_COUNT - 1)] = (rx_stamp_t){ .end = end, .us = esp_timer_get_time() };
+        atomic_store_explicit(&bridge->stamp_head, head + 1, memory_order_release);
+    }
+
+    // In throughput mode, wake the network task again once a batch is due
+    bool due = false;
+    if (bridge->config.mode == UART_BRIDGE_THROUGHPUT) {
+        if (bridge->config.flush_char >= 0 && memchr(data, bridge->config.flush_char, stored) != NULL) {
+            atomic_store(&bridge->flush_end, end);
+            due = true;
+        }
+        due |= waiting < bridge->config.batch_bytes && waiting + stored >= bridge->config.batch_bytes;
+    }
+    signal_wake(bridge, due);
+}
+
+/* Move what the driver holds into the ring */
+static void drain_driver(uart_bridge_t *bridge)
+{
+    const uart_port_t port = bridge->config.uart_num;
+    const bool flow = bridge->config.flow != UART_BRIDGE_FLOW_NONE;
+
+    bridge->rx_backlog = false;
+    for (;;) {
+        size_t avail = 0;
+        uart_get_buffered_data_len(port, &avail);
+        if (avail == 0) return;
+
+        size_t n = avail < sizeof(bridge->chunk) ? avail : sizeof(bridge->chunk);
+        if (flow) {
+            // Leave it in the driver: the buffer fills and the UART holds the sender off
+            size_t space = bridge->rx.size - byte_ring_used(&bridge->rx);
+            if (space == 0) {
+                bridge->rx_backlog = true;
+                return;
+            }
+            if (space < n) n = space;
+        }
+
+        int got = uart_read_bytes(port, bridge->chunk, n, 0);
+        if (got <= 0) return;
+        publish(bridge, bridge->chunk, (size_t)got);
+    }
+}
+
+/**
+ * @brief Receive task - sleeps on the UART event queue
+ *
+ * UART_DATA covers both the RX FIFO full and RX timeout interrupts, so data
+ * is picked up as soon as a burst ends or the FIFO threshold is reached.
+ */
+static void rx_task(void *arg)
+{
+    uart_bridge_t *bridge = arg;
+    const uart_port_t port = bridge->config.uart_num;
+
+    while (atomic_load(&bridge->running)) {
+        uart_event_t event;
+        TickType_t wait = bridge->rx_backlog ? pdMS_TO_TICKS(BACKLOG_RETRY_MS) : portMAX_DELAY;
+        if (xQueueReceive(bridge->events, &event, wait) != pdTRUE) {
+            drain_driver(bridge);
+            continue;
+        }
+
+        switch (event.type) {
+        case UART_DATA:
+        case UART_BUFFER_FULL:
+            // A full driver buffer still holds its bytes (the FIFO and flow control take over)
+            drain_driver(bridge);
+            break;
+        case UART_FIFO_OVF: {
+            // Bytes are already lost; start clean rather than forward a torn stream
+            uint32_t overflows = atomic_fetch_add(&bridge->overflows, 1) + 1;
+            if ((overflows & (overflows - 1)) == 0) {
+                ESP_LOGW(TAG, "UART %d FIFO overflow (%lu so far)", port, (unsigned long)overflows);
+            }
+            uart_flush_input(port);
+            xQueueReset(bridge->events);
+            break;
+        }
+        case UART_BREAK:
+        case UART_PARITY_ERR:
+        case UART_FRAME_ERR:
+            atomic_fetch_add(&bridge->line_errors, 1);
+            break;
+        default:
+            break;
+        }
+    }
+
+    atomic_fetch_sub(&bridge->tasks, 1);
+    vTaskDelete(NULL);
+}
+
+/* ========================================================================
+ * Transmit task
+ * ======================================================================== */
+
+/**
+ * @brief Transmit task - drains the network -> UART ring
+ *
+ * uart_write_bytes() blocks while the driver's TX buffer is full, which is
+ * also where CTS / XOFF hold-offs end up; only this task waits for them.
+ */
+static void tx_task(void *arg)
+{
+    uart_bridge_t *bridge = arg;
+    const uart_port_t port = bridge->config.uart_num;
+
+    while (atomic_load(&bridge->running)) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+
+        const uint8_t *data;
+        size_t n;
+        while (atomic_load(&bridge->running) && (n = byte_ring_peek(&bridge->tx, &data)) > 0) {
+            int written = uart_write_bytes(port, data, n);
+            if (written <= 0) break;
+            byte_ring_consume(&bridge->tx, (size_t)written);
+            atomic_fetch_add(&bridge->uart_tx, (uint32_t)written);
+        }
+    }
+
+    atomic_fetch_sub(&bridge->tasks, 1);
+    vTaskDelete(NULL);
+}
+
+/* ========================================================================
+ * Setup
+ * ======================================================================== */
+
+static esp_err_t install_uart(uart_bridge_t *bridge)
+{
+    const uart_bridge_config_t *config = &bridge->config;
+    const uart_port_t port = config->uart_num;
+
+    uart_config_t uart_config = {
+        .baud_rate = config->baud_rate,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = config->flow == UART_BRIDGE_FLOW_RTS_CTS ? UART_HW_FLOWCTRL_CTS_RTS : UART_HW_FLOWCTRL_DISABLE,
+        .rx_flow_ctrl_thresh = 100,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    esp_err_t ret = uart_driver_install(port, config->driver_rx_size, config->driver_tx_size,
+                                        EVENT_QUEUE_LEN, &bridge->events, 0);
+    if (ret != ESP_OK) return ret;
+
+    ret = uart_param_config(port, &uart_config);
+    if (ret == ESP_OK) {
+        ret = uart_set_pin(port, config->tx_pin, config->rx_pin,
+                           config->flow == UART_BRIDGE_FLOW_RTS_CTS ? config->rts_pin : UART_PIN_NO_CHANGE,
+                           config->flow == UART_BRIDGE_FLOW_RTS_CTS ? config->cts_pin : UART_PIN_NO_CHANGE);
+    }
+    if (ret == ESP_OK && config->flow == UART_BRIDGE_FLOW_XON_XOFF) {
+        // XOFF with 32 bytes of FIFO to spare, XON once it is down to 16
+        ret = uart_set_sw_flow_ctrl(port, true, 16, UART_HW_FIFO_LEN(port) - 32);
+    }
+
+    // Low latency: interrupt after 2 idle symbols or a few bytes; throughput: let the FIFO fill
+    if (ret == ESP_OK) {
+        bool low_latency = config->mode == UART_BRIDGE_LOW_LATENCY;
+        uart_set_rx_timeout(port, low_latency ? 2 : 10);
+        uart_set_rx_full_threshold(port, low_latency ? 16 : UART_HW_FIFO_LEN(port) - 32);
+    }
+
+    if (ret != ESP_OK) {
+        uart_driver_delete(port);
+        bridge->events = NULL;
+    }
+    return ret;
+}
+
+/**
+ * @brief Install the UART driver and start the bridge tasks
+ */
+esp_err_t uart_bridge_start(const uart_bridge_config_t *config, uart_bridge_t **out)
+{
+    if (config == NULL || out == NULL || config->rx_ring_size == 0 || config->tx_ring_size == 0 ||
+        (config->flow == UART_BRIDGE_FLOW_RTS_CTS && (config->rts_pin < 0 || config->cts_pin < 0))) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    uart_bridge_t *bridge = calloc(1, sizeof(uart_bridge_t));
+    if (bridge == NULL) return ESP_ERR_NO_MEM;
+    bridge->config = *config;
+    bridge->wake_fd = -1;
+
+    if (byte_ring_init(&bridge->rx, config->rx_ring_size) != ESP_OK ||
+        byte_ring_init(&bridge->tx, config->tx_ring_size) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate bridge rings");
+        byte_ring_deinit(&bridge->rx);
+        byte_ring_deinit(&bridge->tx);
+        free(bridge);
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Registering twice only reports ESP_ERR_INVALID_STATE
+    esp_vfs_eventfd_config_t eventfd_config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+    esp_vfs_eventfd_register(&eventfd_config);
+    bridge->wake_fd = eventfd(0, 0);
+
+    esp_err_t ret = bridge->wake_fd >= 0 ? install_uart(bridge) : ESP_FAIL;
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to set up UART %d: %s", config->uart_num, esp_err_to_name(ret));
+        if (bridge->wake_fd >= 0) close(bridge->wake_fd);
+        byte_ring_deinit(&bridge->rx);
+        byte_ring_deinit(&bridge->tx);
+        free(bridge);
+        return ret;
+    }
+
+    atomic_store(&bridge->running, true);
+    atomic_store(&bridge->tasks, 2);
+    bridge->rate_since_us = esp_timer_get_time();
+    xTaskCreate(rx_task, "uart_bridge_rx", 3072, bridge, 6, &bridge->rx_task);
+    xTaskCreate(tx_task, "uart_bridge_tx", 3072, bridge, 5, &bridge->tx_task);
+
+    ESP_LOGI(TAG, "UART %d at %d baud, flow %d, %s, rings %u / %u bytes", config->uart_num,
+             config->baud_rate, config->flow,
+             config->mode == UART_BRIDGE_LOW_LATENCY ? "low latency" : "throughput",
+             (unsigned)bridge->rx.size, (unsigned)bridge->tx.size);
+    *out = bridge;
+    return ESP_OK;
+}
+
+/**
+ * @brief Stop the tasks, remove the UART driver and free the bridge
+ */
+esp_err_t uart_bridge_stop(uart_bridge_t *bridge)
+{
+    if (bridge == NULL) return ESP_ERR_INVALID_ARG;
+
+    // Wake both tasks: a dummy event for the receive task, a notification for the other
+    atomic_store(&bridge->running, false);
+    uart_event_t wake = { .type = UART_EVENT_MAX };
+    xQueueSend(bridge->events, &wake, 0);
+    xTaskNotifyGive(bridge->tx_task);
+    for (int i = 0; i < STOP_TIMEOUT_MS / 10 && atomic_load(&bridge->tasks) > 0; i++) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    if (atomic_load(&bridge->tasks) > 0) {
+        // A write held off by flow control for good: keep the bridge rather than free it under the task
+        ESP_LOGE(TAG, "UART %d transmit still blocked, bridge not freed", bridge->config.uart_num);
+        return ESP_ERR_TIMEOUT;
+    }
+
+    uart_driver_delete(bridge->config.uart_num);
+    close(bridge->wake_fd);
+    byte_ring_deinit(&bridge->rx);
+    byte_ring_deinit(&bridge->tx);
+    free(bridge);
+    return ESP_OK;
+}
+
+/* ========================================================================
+ * Network side
+ * ======================================================================== */
+
+int uart_bridge_wake_fd(uart_bridge_t *bridge)
+{
+    return bridge != NULL ? bridge->wake_fd : -1;
+}
+
+/* Arrival time of the oldest byte not yet consumed, 0 if none */
+static int64_t oldest_us(uart_bridge_t *bridge)
+{
+    size_t tail = atomic_load_explicit(&bridge->stamp_tail, memory_order_relaxed);
+    if (tail == atomic_load_explicit(&bridge->stamp_head, memory_order_acquire)) return 0;
+    return bridge->stamps[tail & (STAMP_COUNT - 1)].us;
+}
+
+/* Throughput mode: is the data waiting due? */
+static bool batch_due(uart_bridge_t *bridge, size_t waiting)
+{
+    if (waiting >= bridge->config.batch_bytes) return true;
+    if ((ptrdiff_t)(atomic_load(&bridge->flush_end) - bridge->rx_out) > 0) return true;
+
+    int64_t since = oldest_us(bridge);
+    return since == 0 || esp_timer_get_time() - since >= (int64_t)bridge->config.max_delay_ms * 1000;
+}
+
+/**
+ * @brief UART bytes due for the network, in place
+ */
+size_t uart_bridge_rx_peek(uart_bridge_t *bridge, const uint8_t **data)
+{
+    if (bridge == NULL) return 0;
+
+    size_t n = byte_ring_peek(&bridge->rx, data);
+    if (n == 0) {
+        // Clear first, then look again: bytes stored after this raise the fd anew
+        clear_wake(bridge);
+        n = byte_ring_peek(&bridge->rx, data);
+        if (n == 0) return 0;
+    }
+
+    if (bridge->config.mode == UART_BRIDGE_THROUGHPUT && !batch_due(bridge, byte_ring_used(&bridge->rx))) {
+        // Held: clear the fd so the caller sleeps until rx_due_ms() or a due chunk raises it again
+        clear_wake(bridge);
+        if (!batch_due(bridge, byte_ring_used(&bridge->rx))) return 0;
+    }
+    return n;
+}
+
+/**
+ * @brief Release bytes returned by uart_bridge_rx_peek()
+ */
+void uart_bridge_rx_consume(uart_bridge_t *bridge, size_t len)
+{
+    if (bridge == NULL || len == 0) return;
+
+    byte_ring_consume(&bridge->rx, len);
+    bridge->rx_out += len;
+    atomic_fetch_add(&bridge->net_tx, len);
+    atomic_fetch_add(&bridge->batches, 1);
+
+    // Latency of every chunk now fully handed over
+    int64_t now = esp_timer_get_time();
+    size_t tail = atomic_load_explicit(&bridge->stamp_tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&bridge->stamp_head, memory_order_acquire);
+    while (tail != head && (ptrdiff_t)(bridge->rx_out - bridge->stamps[tail & (STAMP_COUNT - 1)].end) >= 0) {
+        uint32_t latency = (uint32_t)(now - bridge->stamps[tail & (STAMP_COUNT - 1)].us);
+        atomic_fetch_add(&bridge->latency_sum_us, latency);
+        atomic_fetch_add(&bridge->latency_count, 1);
+        uint_fast32_t max = atomic_load(&bridge->latency_max_us);
+        while (latency > max && !atomic_compare_exchange_weak(&bridge->latency_max_us, &max, latency)) {
+        }
+        tail++;
+    }
+    atomic_store_explicit(&bridge->stamp_tail, tail, memory_order_release);
+}
+
+/**
+ * @brief Milliseconds until held bytes are due
+ */
+int uart_bridge_rx_due_ms(uart_bridge_t *bridge)
+{
+    if (bridge == NULL || bridge->config.mode != UART_BRIDGE_THROUGHPUT) return -1;
+
+    int64_t since = oldest_us(bridge);
+    if (since == 0) return -1;
+
+    int64_t left_us = (int64_t)bridge->config.max_delay_ms * 1000 - (esp_timer_get_time() - since);
+    return left_us > 0 ? (int)((left_us + 999) / 1000) : 0;
+}
+
+/**
+ * @brief When the oldest byte not yet consumed was read from the UART
+ */
+int64_t uart_bridge_rx_oldest_us(uart_bridge_t *bridge)
+{
+    return bridge != NULL ? oldest_us(bridge) : 0;
+}
+
+size_t uart_bridge_tx_space(uart_bridge_t *bridge)
+{
+    return bridge != NULL ? bridge->tx.size - byte_ring_used(&bridge->tx) : 0;
+}
+
+/**
+ * @brief Queue network bytes for the UART
+ */
+size_t uart_bridge_tx_write(uart_bridge_t *bridge, const uint8_t *data, size_t len)
+{
+    if (bridge == NULL || data == NULL || len == 0) return 0;
+
+    size_t stored = byte_ring_write(&bridge->tx, data, len);
+    atomic_fetch_add(&bridge->net_rx, stored);
+    xTaskNotifyGive(bridge->tx_task);
+    return stored;
+}
+
+/**
+ * @brief Get counters
+ */
+void uart_bridge_get_stats(uart_bridge_t *bridge, uart_bridge_stats_t *stats)
+{
+    if (bridge == NULL || stats == NULL) return;
+
+    uint32_t written, dropped;
+    byte_ring_get_counts(&bridge->rx, &written, &dropped);
+
+    stats->uart_rx = atomic_load(&bridge->uart_rx);
+    stats->uart_tx = atomic_load(&bridge->uart_tx);
+    stats->net_tx = atomic_load(&bridge->net_tx);
+    stats->net_rx = atomic_load(&bridge->net_rx);
+    stats->rx_dropped = dropped;
+    stats->overflows = atomic_load(&bridge->overflows);
+    stats->line_errors = atomic_load(&bridge->line_errors);
+    stats->batches = atomic_load(&bridge->batches);
+
+    uint32_t count = atomic_exchange(&bridge->latency_count, 0);
+    uint32_t sum = atomic_exchange(&bridge->latency_sum_us, 0);
+    stats->latency_avg_us = count > 0 ? sum / count : 0;
+    stats->latency_max_us = atomic_exchange(&bridge->latency_max_us, 0);
+
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = now - bridge->rate_since_us;
+    if (elapsed > 0) {
+        stats->rx_rate = (uint32_t)((uint64_t)(stats->net_tx - bridge->rate_rx) * 1000000 / elapsed);
+        stats->tx_rate = (uint32_t)((uint64_t)(stats->uart_tx - bridge->rate_tx) * 1000000 / elapsed);
+    } else {
+        stats->rx_rate = 0;
+        stats->tx_rate = 0;
+    }
+    bridge->rate_since_us = now;
+    bridge->rate_rx = stats->net_tx;
+    bridge->rate_tx = stats->uart_tx;
+}
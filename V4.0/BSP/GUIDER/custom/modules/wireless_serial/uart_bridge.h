@@ -0,0 +1,203 @@
+/**
+ * @file uart_bridge.h
+ * @brief UART <-> network bridge engine driven by the UART driver event queue
+ *
+ * A receive task sleeps on the UART driver's event queue and wakes on RX FIFO
+ * full / RX timeout (UART_DATA), overflow and line error events; it moves
+ * whatever the driver holds into a large SPSC ring and signals an eventfd
+ * that the network task polls beside its sockets. A transmit task drains a
+ * second ring into uart_write_bytes(), so a slow UART (or a device holding
+ * CTS / sending XOFF) blocks that task only, never the network loop.
+ *
+ * The network side takes UART data in place with uart_bridge_rx_peek() /
+ * uart_bridge_rx_consume(). In UART_BRIDGE_LOW_LATENCY mode every byte is
+ * handed over as soon as it arrives; in UART_BRIDGE_THROUGHPUT mode bytes are
+ * held until batch_bytes are waiting, the oldest is max_delay_ms old or
+ * flush_char arrives, so the link carries full segments. flush_char is
+ * matched in the receive task: the UART's pattern detector only reports
+ * characters framed by idle gaps, which a continuous stream does not have.
+ *
+ * With flow control on, the receive task stops reading while the ring is
+ * full: the driver buffer and FIFO fill and RTS drops (or XOFF goes out), so
+ * nothing is lost. Without it, bytes the ring cannot take are dropped and
+ * counted.
+ *
+ * The uart_bridge_rx_* and uart_bridge_tx_* functions are for one network
+ * task; uart_bridge_get_stats() may be called from one other task.
+ */
+
+#ifndef UART_BRIDGE_H
+#define UART_BRIDGE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Bytes the receive task moves per uart_read_bytes() */
+#define UART_BRIDGE_CHUNK_SIZE      1024
+
+/* Bridge context (opaque) */
+typedef struct uart_bridge_t uart_bridge_t;
+
+/* Flow control */
+typedef enum {
+    UART_BRIDGE_FLOW_NONE = 0,
+    UART_BRIDGE_FLOW_RTS_CTS,       // Hardware, needs rts_pin / cts_pin
+    UART_BRIDGE_FLOW_XON_XOFF,      // Software, in the UART hardware
+} uart_bridge_flow_t;
+
+/* Coalescing towards the network */
+typedef enum {
+    UART_BRIDGE_LOW_LATENCY = 0,    // Hand over every byte at once
+    UART_BRIDGE_THROUGHPUT,         // Hold bytes until a batch is due
+} uart_bridge_mode_t;
+
+/**
+ * @brief Monitor handler, called in the receive task for every chunk read
+ *
+ * @param data Bytes read from the UART (valid during the call only)
+ * @param len Length in bytes
+ * @param user config.user
+ */
+typedef void (*uart_bridge_data_cb_t)(const uint8_t *data, size_t len, void *user);
+
+/* Bridge configuration */
+typedef struct {
+    int uart_num;
+    int baud_rate;
+    int tx_pin;
+    int rx_pin;
+    int rts_pin;                    // -1 unless flow is UART_BRIDGE_FLOW_RTS_CTS
+    int cts_pin;
+    uart_bridge_flow_t flow;
+    uart_bridge_mode_t mode;
+    size_t batch_bytes;             // THROUGHPUT: hand over once this many are waiting
+    uint32_t max_delay_ms;          // THROUGHPUT: ... or the oldest is this old
+    int flush_char;                 // THROUGHPUT: ... or this byte arrived (-1 = none)
+    size_t driver_rx_size;          // UART driver ring buffers (internal RAM)
+    size_t driver_tx_size;
+    size_t rx_ring_size;            // UART -> network ring (PSRAM first)
+    size_t tx_ring_size;            // Network -> UART ring
+    uart_bridge_data_cb_t on_uart_data; // May be NULL
+    void *user;
+} uart_bridge_config_t;
+
+/* Defaults: 921600 baud, no flow control, low latency, 32 KB / 8 KB rings */
+#define UART_BRIDGE_CONFIG_DEFAULT() {  \
+    .uart_num = 1,                      \
+    .baud_rate = 921600,                \
+    .tx_pin = -1,                       \
+    .rx_pin = -1,                       \
+    .rts_pin = -1,                      \
+    .cts_pin = -1,                      \
+    .flow = UART_BRIDGE_FLOW_NONE,      \
+    .mode = UART_BRIDGE_LOW_LATENCY,    \
+    .batch_bytes = 1460,                \
+    .max_delay_ms = 5,                  \
+    .flush_char = -1,                   \
+    .driver_rx_size = 8 * 1024,         \
+    .driver_tx_size = 4 * 1024,         \
+    .rx_ring_size = 32 * 1024,          \
+    .tx_ring_size = 8 * 1024,           \
+    .on_uart_data = NULL,               \
+    .user = NULL,                       \
+}
+
+/* Bridge counters */
+typedef struct {
+    uint32_t uart_rx;               // Bytes read from the UART
+    uint32_t uart_tx;               // Bytes written to the UART
+    uint32_t net_tx;                // Bytes handed to the network (consumed)
+    uint32_t net_rx;                // Bytes taken from the network (tx_write)
+    uint32_t rx_dropped;            // UART bytes the ring could not take (no flow control)
+    uint32_t overflows;             // UART FIFO overflows (data lost)
+    uint32_t line_errors;           // Break, parity and framing errors
+    uint32_t batches;               // rx_consume() calls that released data
+    uint32_t latency_avg_us;        // UART read -> handed to the network, mean since last call
+    uint32_t latency_max_us;        // ... worst since last call
+    uint32_t rx_rate;               // UART -> network bytes/s since last call
+    uint32_t tx_rate;               // Network -> UART bytes/s since last call
+} uart_bridge_stats_t;
+
+/**
+ * @brief Install the UART driver with an event queue and start the bridge tasks
+ *
+ * @param config Configuration (copied)
+ * @param out Bridge handle
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM, or the UART driver's error
+ */
+esp_err_t uart_bridge_start(const uart_bridge_config_t *config, uart_bridge_t **out);
+
+/**
+ * @brief Stop the tasks, remove the UART driver and free the bridge
+ *
+ * The network task must have stopped using the bridge.
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, or ESP_ERR_TIMEOUT if a task has not
+ *         exited (transmit held off by flow control); the bridge is then
+ *         kept and the UART driver stays installed, so call it again later
+ */
+esp_err_t uart_bridge_stop(uart_bridge_t *bridge);
+
+/**
+ * @brief File descriptor that turns readable when UART data may be due
+ *
+ * Poll it for POLLIN; uart_bridge_rx_peek() clears it once the ring is empty
+ * or a batch is held, so poll with the uart_bridge_rx_due_ms() timeout.
+ */
+int uart_bridge_wake_fd(uart_bridge_t *bridge);
+
+/**
+ * @brief UART bytes due for the network, in place (network task)
+ *
+ * @param data Set to the first byte
+ * @return Contiguous bytes at *data; 0 if none or while a batch is held
+ */
+size_t uart_bridge_rx_peek(uart_bridge_t *bridge, const uint8_t **data);
+
+/**
+ * @brief Release bytes returned by uart_bridge_rx_peek() (network task)
+ */
+void uart_bridge_rx_consume(uart_bridge_t *bridge, size_t len);
+
+/**
+ * @brief Milliseconds until held bytes are due (network task)
+ *
+ * @return Poll timeout to honour, -1 if nothing is held
+ */
+int uart_bridge_rx_due_ms(uart_bridge_t *bridge);
+
+/**
+ * @brief When the oldest byte not yet consumed was read from the UART (network task)
+ *
+ * @return esp_timer_get_time() microseconds, 0 if the ring is empty
+ */
+int64_t uart_bridge_rx_oldest_us(uart_bridge_t *bridge);
+
+/**
+ * @brief Room in the network -> UART ring (network task)
+ */
+size_t uart_bridge_tx_space(uart_bridge_t *bridge);
+
+/**
+ * @brief Queue network bytes for the UART (network task)
+ *
+ * @return Bytes queued; check uart_bridge_tx_space() first to queue all
+ */
+size_t uart_bridge_tx_write(uart_bridge_t *bridge, const uint8_t *data, size_t len);
+
+/**
+ * @brief Get counters; the latency and rate fields cover the time since the previous call
+ */
+void uart_bridge_get_stats(uart_bridge_t *bridge, uart_bridge_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UART_BRIDGE_H */
@@ -6,16 +6,22 @@
  * Supports UART passthrough for external devices (e.g., STM32).
  * 
  * Features:
- * - TCP Server mode (ESP32-P4 listens on port 8888)
+ * - TCP Server mode (ESP32-P4 listens on port 8888, several clients)
  * - TCP Client mode (connect to remote server)
- * - UART passthrough (bridge UART to WiFi)
+ * - UART passthrough (bridge UART to WiFi, see uart_bridge.h)
  * - Bidirectional data transfer
- * - UI integration with LVGL textarea
+ * - UI integration with LVGL textarea (fed through SPSC rings, see header)
+ * - Timestamped capture of the traffic to SD card (see serial_log.h)
+ * - Received data shown as decoded frames (see frame_parser.h)
+ * - Coalesced sends with a UART -> TCP latency histogram (see tcp_out.h)
  * 
  * @note This module is tightly coupled with the scrWirelessSerial UI page.
  */
 
 #include "wireless_serial.h"
+#include "byte_ring.h"
+#include "ws_hub.h"
+#include "uart_bridge.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
 #include "esp_netif.h"
@@ -24,13 +30,20 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/event_groups.h"
+#include "esp_timer.h"
 #include "driver/uart.h"
 #include "driver/gpio.h"
+#include <sys/poll.h>
+#include <sys/stat.h>
+#include <errno.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 
 /* LVGL includes for UI updates */
 #include "lvgl.h"
 #include "gui_guider.h"
+#include "lv_terminal.h"
 
 static const char *TAG = "WirelessSerial";
 
@@ -38,26 +51,86 @@ static const char *TAG = "WirelessSerial";
 #define UART_PORT_NUM      UART_NUM_1
 #define UART_TX_PIN        GPIO_NUM_51
 #define UART_RX_PIN        GPIO_NUM_52
-#define UART_BUF_SIZE      (1024)
+#define UART_BAUD_RATE     115200
+
+/* Receive view flush: once per display frame */
+#define UI_FLUSH_PERIOD_MS LV_DISP_DEF_REFR_PERIOD
+
+/* Network loop wake-up: bounds the delay of text sent from the screen */
+#define HUB_POLL_MS        10
+
+/* Log SD button and frame counter refresh */
+#define UI_STATUS_PERIOD_MS 1000
+
+/* Modbus-RTU inter-frame gap: 3.5 characters (8N1), fixed at 1750 us above 19200 baud */
+#define UART_CHAR_US       (10 * 1000000 / UART_BAUD_RATE)
+#define FRAME_GAP_US       (UART_BAUD_RATE > 19200 ? 1750 : 35 * 1000000 / UART_BAUD_RATE)
+
+/* One decoded frame in the receive view */
+#define FRAME_ROW_MAX      96
 
 /* ==================== State Variables ==================== */
 static wireless_serial_status_t s_status = WS_STATUS_DISCONNECTED;
 static wireless_serial_data_cb_t s_data_callback = NULL;
 static wireless_serial_status_cb_t s_status_callback = NULL;
 static bool s_uart_passthrough_enabled = false;
+static uart_bridge_mode_t s_bridge_mode = UART_BRIDGE_LOW_LATENCY;
+static uart_bridge_flow_t s_bridge_flow = UART_BRIDGE_FLOW_NONE;
 
 /* ==================== Socket Variables ==================== */
-static int s_server_socket = -1;
 static int s_client_socket = -1;
 static TaskHandle_t s_server_task = NULL;
 static TaskHandle_t s_client_task = NULL;
-static TaskHandle_t s_uart_rx_task = NULL;
 static bool s_running = false;
+static ws_hub_t *s_hub = NULL;              /* Server task only */
+static ws_hub_stats_t s_hub_stats;          /* Copied by the server task */
+static uart_bridge_t *s_bridge = NULL;      /* UART passthrough engine */
+static volatile bool s_bridge_attached = false; /* A network loop is using s_bridge */
+static byte_ring_t s_tx_ring;               /* Screen -> clients */
+static tcp_out_t s_client_out;              /* Client task only */
+static tcp_out_stats_t s_client_out_stats;  /* Copied by the client task */
+
+/* ==================== Send Path ==================== */
+static volatile tcp_out_mode_t s_send_mode = TCP_OUT_IMMEDIATE; /* Set on the LVGL thread */
+static latency_hist_t s_latency;            /* UART read -> send(), recorded by the network task */
+static uint32_t s_latency_logged = 0;       /* Samples at the last log line, LVGL thread */
+
+/* ==================== Receive Path ==================== */
+/* One ring per producer: socket tasks (one at a time) and the UART bridge */
+static byte_ring_t s_net_ring;
+static byte_ring_t s_uart_ring;
+static lv_timer_t *s_ui_flush_timer = NULL;
+static uint32_t s_rx_rendered = 0;          /* LVGL thread only */
+static lv_obj_t *s_terminal = NULL;         /* Receive view, LVGL thread only */
+static bool s_receive_hex = false;          /* Hex view, LVGL thread only */
+static serial_log_t *s_log = NULL;          /* SD capture, created on first use */
+
+/* ==================== Frame View ==================== */
+/* A receive ring decoded into frames on the LVGL thread */
+typedef struct {
+    byte_ring_t *ring;
+    frame_parser_t parser;
+    uint8_t buf[WIRELESS_SERIAL_FRAME_MAX];
+    size_t shown;                           /* Bytes taken from the ring */
+    char tag;                               /* Row prefix */
+} frame_view_t;
+
+static const frame_decoder_t *s_frame_decoder = NULL;  /* NULL: raw stream, LVGL thread only */
+static frame_view_t s_net_frames = { .ring = &s_net_ring, .tag = 'N' };
+static frame_view_t s_uart_frames = { .ring = &s_uart_ring, .tag = 'U' };
+static uint32_t s_frames_counted = 0;       /* Frame counter, LVGL thread only */
+static uint32_t s_frame_rate = 0;
+
+/* UART idle gaps: stored-byte positions that followed a gap (bridge receive task -> LVGL thread) */
+static byte_ring_t s_gap_ring;
+static size_t s_uart_stored = 0;            /* Bridge receive task */
+static int64_t s_uart_last_us = 0;          /* Bridge receive task */
+static size_t s_next_gap = 0;               /* LVGL thread */
+static bool s_have_gap = false;
 
 /* ==================== Forward Declarations ==================== */
 static void server_task(void *pvParameters);
 static void client_task(void *pvParameters);
-static void uart_rx_task(void *pvParameters);
 static void update_status(wireless_serial_status_t new_status);
 
 /* ==================== Internal Functions ==================== */
@@ -81,144 +154,165 @@ static void update_status(wireless_serial_status_t new_status)
 }
 
 /**
- * @brief UART RX task - receives data from external device and forwards to WiFi
+ * @brief Bridge monitor - UART data as it is read (bridge receive task)
  */
-static void uart_rx_task(void *pvParameters)
+static void bridge_uart_data(const uint8_t *data, size_t len, void *user)
 {
-    uint8_t *data = (uint8_t *) malloc(UART_BUF_SIZE);
-    
-    ESP_LOGI(TAG, "UART RX task started");
-    
-    while (s_uart_passthrough_enabled) {
-        int len = uart_read_bytes(UART_PORT_NUM, data, UART_BUF_SIZE, 20 / portTICK_PERIOD_MS);
-        if (len > 0) {
-            ESP_LOGI(TAG, "UART received %d bytes", len);
-            
-            /* Forward to WiFi if connected */
-            if (s_client_socket >= 0) {
-                wireless_serial_send(data, len);
-            }
-            
-            /* Also update UI */
-            wireless_serial_update_ui_receive(data, len);
-        }
+    /*
+     * Mark an inter-frame gap before this chunk for the frame view: its first
+     * byte arrived len characters before it was read, so the line was idle
+     * from the previous read until then. Positions are whole records in a
+     * ring of a power-of-two size, so one is stored whole or not at all.
+     */
+    int64_t now = esp_timer_get_time();
+    if (now - (int64_t)len * UART_CHAR_US - s_uart_last_us >= FRAME_GAP_US) {
+        byte_ring_write(&s_gap_ring, &s_uart_stored, sizeof(s_uart_stored));
     }
-    
-    free(data);
-    ESP_LOGI(TAG, "UART RX task stopped");
-    vTaskDelete(NULL);
+    s_uart_last_us = now;
+
+    /* Show it (drained on the LVGL thread) */
+    s_uart_stored += byte_ring_write(&s_uart_ring, data, len);
+    serial_log_write(s_log, SERIAL_LOG_UART_RX, data, len);
+}
+
+/* The bridge as the hub's serial side */
+static size_t bridge_rx_peek(void *ctx, const uint8_t **data)
+{
+    return uart_bridge_rx_peek(ctx, data);
+}
+
+static void bridge_rx_consume(void *ctx, size_t len)
+{
+    uart_bridge_rx_consume(ctx, len);
+}
+
+static int bridge_rx_due_ms(void *ctx)
+{
+    return uart_bridge_rx_due_ms(ctx);
+}
+
+static int64_t bridge_rx_stamp_us(void *ctx)
+{
+    return uart_bridge_rx_oldest_us(ctx);
+}
+
+static size_t bridge_tx_space(void *ctx)
+{
+    return uart_bridge_tx_space(ctx);
+}
+
+static size_t bridge_tx_write(void *ctx, const uint8_t *data, size_t len)
+{
+    return uart_bridge_tx_write(ctx, data, len);
+}
+
+/**
+ * @brief Follow the passthrough switch from a network loop
+ * 
+ * @return The bridge to serve, NULL while passthrough is off
+ */
+static uart_bridge_t *attach_bridge(void)
+{
+    s_bridge_attached = s_uart_passthrough_enabled && s_bridge != NULL;
+    return s_bridge_attached ? s_bridge : NULL;
 }
 
 /**
- * @brief Server task - accepts connections and receives data
+ * @brief Hub callback - data from any client
+ */
+static void hub_client_data(const uint8_t *data, size_t len, void *user)
+{
+    /* Call user data callback if registered */
+    if (s_data_callback) {
+        s_data_callback(data, len);
+    }
+
+    /* Queue for the UI (drained on the LVGL thread) */
+    byte_ring_write(&s_net_ring, data, len);
+    serial_log_write(s_log, SERIAL_LOG_NET_RX, data, len);
+}
+
+/**
+ * @brief Server task - one poll() loop for the listener, the clients and the UART
  * 
- * This task runs as a TCP server, listening on WIRELESS_SERIAL_PORT (8888).
- * When a client connects, it enters a receive loop to handle incoming data.
+ * This task runs as a TCP server, listening on WIRELESS_SERIAL_PORT (8888)
+ * for up to WIRELESS_SERIAL_MAX_CLIENTS clients. While UART passthrough is
+ * enabled the UART is part of the same loop (see ws_hub.h).
  */
 static void server_task(void *pvParameters)
 {
-    struct sockaddr_in server_addr;
-    struct sockaddr_in client_addr;
-    socklen_t client_addr_len = sizeof(client_addr);
-    
     ESP_LOGI(TAG, "Server task started");
-    
-    /* Create socket */
-    s_server_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if (s_server_socket < 0) {
-        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
-        update_status(WS_STATUS_ERROR);
-        vTaskDelete(NULL);
-        return;
-    }
-    
-    /* Set socket options - allow address reuse */
-    int opt = 1;
-    setsockopt(s_server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-    
-    /* Bind socket to any address on specified port */
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(WIRELESS_SERIAL_PORT);
-    
-    if (bind(s_server_socket, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        ESP_LOGE(TAG, "Failed to bind socket: errno %d", errno);
-        close(s_server_socket);
-        s_server_socket = -1;
-        update_status(WS_STATUS_ERROR);
-        vTaskDelete(NULL);
-        return;
-    }
-    
-    /* Start listening for connections */
-    if (listen(s_server_socket, WIRELESS_SERIAL_MAX_CLIENTS) < 0) {
-        ESP_LOGE(TAG, "Failed to listen: errno %d", errno);
-        close(s_server_socket);
-        s_server_socket = -1;
+
+    ws_hub_config_t config = {
+        .port = WIRELESS_SERIAL_PORT,
+        .max_clients = WIRELESS_SERIAL_MAX_CLIENTS,
+        .client_queue_size = WIRELESS_SERIAL_CLIENT_QUEUE_SIZE,
+        .stall_timeout_ms = WIRELESS_SERIAL_STALL_TIMEOUT_MS,
+        .serial = NULL,
+        .send_mode = s_send_mode,
+        .latency = &s_latency,
+        .on_client_data = hub_client_data,
+        .on_serial_data = NULL,
+        .user = NULL,
+    };
+    s_hub = ws_hub_create(&config);
+    if (s_hub == NULL) {
         update_status(WS_STATUS_ERROR);
+        s_server_task = NULL;
         vTaskDelete(NULL);
         return;
     }
-    
+
     ESP_LOGI(TAG, "Server listening on port %d", WIRELESS_SERIAL_PORT);
     update_status(WS_STATUS_CONNECTING);
-    
+
     /* Main server loop */
+    uart_bridge_t *serving = NULL;
+    tcp_out_mode_t send_mode = s_send_mode;
     while (s_running) {
-        /* Accept incoming connection */
-        s_client_socket = accept(s_server_socket, (struct sockaddr *)&client_addr, &client_addr_len);
-        if (s_client_socket < 0) {
-            if (s_running) {
-                ESP_LOGE(TAG, "Failed to accept connection: errno %d", errno);
-            }
-            continue;
+        if (send_mode != s_send_mode) {
+            send_mode = s_send_mode;
+            ws_hub_set_send_mode(s_hub, send_mode);
         }
-        
-        ESP_LOGI(TAG, "Client connected from %s:%d", 
-                 inet_ntoa(client_addr.sin_addr), ntohs(client_addr.sin_port));
-        update_status(WS_STATUS_CONNECTED);
-        
-        /* Receive data loop */
-        uint8_t rx_buffer[WIRELESS_SERIAL_BUFFER_SIZE];
-        while (s_running) {
-            int len = recv(s_client_socket, rx_buffer, sizeof(rx_buffer) - 1, 0);
-            if (len < 0) {
-                ESP_LOGE(TAG, "Receive failed: errno %d", errno);
-                break;
-            } else if (len == 0) {
-                ESP_LOGI(TAG, "Client disconnected");
-                break;
-            } else {
-                rx_buffer[len] = 0; /* Null terminate for string operations */
-                ESP_LOGI(TAG, "Received %d bytes", len);
-                
-                /* Forward to UART if passthrough enabled */
-                if (s_uart_passthrough_enabled) {
-                    uart_write_bytes(UART_PORT_NUM, (const char *)rx_buffer, len);
-                }
-                
-                /* Call user data callback if registered */
-                if (s_data_callback) {
-                    s_data_callback(rx_buffer, len);
-                }
-                
-                /* Update UI with received data */
-                wireless_serial_update_ui_receive(rx_buffer, len);
-            }
+
+        /* The UART bridge joins the loop while passthrough is on */
+        uart_bridge_t *bridge = attach_bridge();
+        if (bridge != serving) {
+            ws_hub_serial_t serial = {
+                .wake_fd = uart_bridge_wake_fd(bridge),
+                .rx_peek = bridge_rx_peek,
+                .rx_consume = bridge_rx_consume,
+                .rx_due_ms = bridge_rx_due_ms,
+                .rx_stamp_us = bridge_rx_stamp_us,
+                .tx_space = bridge_tx_space,
+                .tx_write = bridge_tx_write,
+                .ctx = bridge,
+            };
+            ws_hub_set_serial(s_hub, bridge != NULL ? &serial : NULL);
+            serving = bridge;
         }
-        
-        /* Close client socket and wait for next connection */
-        close(s_client_socket);
-        s_client_socket = -1;
-        update_status(WS_STATUS_CONNECTING);
+
+        if (ws_hub_poll(s_hub, HUB_POLL_MS) != ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(HUB_POLL_MS));
+        }
+
+        /* Text sent from the screen goes to every client */
+        const uint8_t *data;
+        size_t n;
+        while ((n = byte_ring_peek(&s_tx_ring, &data)) > 0) {
+            ws_hub_broadcast(s_hub, data, n);
+            byte_ring_consume(&s_tx_ring, n);
+        }
+
+        ws_hub_get_stats(s_hub, &s_hub_stats);
+        update_status(s_hub_stats.clients > 0 ? WS_STATUS_CONNECTED : WS_STATUS_CONNECTING);
     }
-    
+
     /* Cleanup */
-    if (s_server_socket >= 0) {
-        close(s_server_socket);
-        s_server_socket = -1;
-    }
-    
+    s_bridge_attached = false;
+    ws_hub_destroy(s_hub);
+    s_hub = NULL;
+
     ESP_LOGI(TAG, "Server task stopped");
     vTaskDelete(NULL);
 }
@@ -269,36 +363,101 @@ static void client_task(void *pvParameters)
 
     ESP_LOGI(TAG, "Connected to server");
     update_status(WS_STATUS_CONNECTED);
+
     free(params);
 
-    /* Receive data loop */
+    /* Everything sent goes through the output buffer, which also turns Nagle off */
+    int sock = s_client_socket;
+    tcp_out_mode_t send_mode = s_send_mode;
+    tcp_out_attach(&s_client_out, sock, send_mode, &s_latency);
+
+    /* One poll() over the socket and, with passthrough on, the UART bridge */
     uint8_t rx_buffer[WIRELESS_SERIAL_BUFFER_SIZE];
     while (s_running) {
-        int len = recv(s_client_socket, rx_buffer, sizeof(rx_buffer) - 1, 0);
-        if (len < 0) {
-            ESP_LOGE(TAG, "Receive failed: errno %d", errno);
-            break;
-        } else if (len == 0) {
-            ESP_LOGI(TAG, "Server disconnected");
+        if (send_mode != s_send_mode) {
+            send_mode = s_send_mode;
+            tcp_out_set_mode(&s_client_out, send_mode);
+        }
+
+        uart_bridge_t *bridge = attach_bridge();
+        int send_due_ms = tcp_out_due_ms(&s_client_out);
+        struct pollfd fds[2] = {
+            { .fd = sock, .events = POLLIN | (send_due_ms == 0 ? POLLOUT : 0) },
+            { .fd = uart_bridge_wake_fd(bridge), .events = POLLIN },
+        };
+        int timeout = HUB_POLL_MS;
+        if (send_due_ms > 0 && send_due_ms < timeout) timeout = send_due_ms;
+        size_t room = sizeof(rx_buffer);
+        if (bridge != NULL) {
+            /* Leave server data in the socket while the UART is behind */
+            room = uart_bridge_tx_space(bridge);
+            if (room > sizeof(rx_buffer)) room = sizeof(rx_buffer);
+            if (room == 0) fds[0].events &= ~POLLIN;
+            int due_ms = uart_bridge_rx_due_ms(bridge);
+            if (due_ms >= 0 && due_ms < timeout) timeout = due_ms;
+        }
+
+        if (poll(fds, bridge != NULL ? 2 : 1, timeout) < 0 && errno != EINTR) {
+            ESP_LOGE(TAG, "poll failed: errno %d", errno);
             break;
-        } else {
-            rx_buffer[len] = 0; /* Null terminate */
-            ESP_LOGI(TAG, "Received %d bytes", len);
+        }
 
-            /* Forward to UART if passthrough enabled */
-            if (s_uart_passthrough_enabled) {
-                uart_write_bytes(UART_PORT_NUM, (const char *)rx_buffer, len);
-            }
+        if ((fds[0].events & POLLIN) && (fds[0].revents & (POLLIN | POLLHUP | POLLERR))) {
+            int len = recv(sock, rx_buffer, room, MSG_DONTWAIT);
+            if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                ESP_LOGE(TAG, "Receive failed: errno %d", errno);
+                break;
+            } else if (len == 0) {
+                ESP_LOGI(TAG, "Server disconnected");
+                break;
+            } else if (len > 0) {
+                ESP_LOGD(TAG, "Received %d bytes", len);
+
+                /* Forward to UART if passthrough enabled (the bridge's TX task writes it) */
+                if (bridge != NULL) {
+                    uart_bridge_tx_write(bridge, rx_buffer, len);
+                }
 
-            /* Call user data callback if registered */
-            if (s_data_callback) {
-                s_data_callback(rx_buffer, len);
+                /* Call user data callback if registered */
+                if (s_data_callback) {
+                    s_data_callback(rx_buffer, len);
+                }
+
+                /* Queue for the UI (drained on the LVGL thread) */
+                byte_ring_write(&s_net_ring, rx_buffer, len);
+                serial_log_write(s_log, SERIAL_LOG_NET_RX, rx_buffer, len);
             }
+        }
 
-            /* Update UI with received data */
-            wireless_serial_update_ui_receive(rx_buffer, len);
+        /*
+         * UART data the bridge has due, then text from the screen, as far as
+         * the output buffer has room: what it cannot take stays in the
+         * bridge, whose flow control then holds the device off.
+         */
+        const uint8_t *data;
+        size_t n;
+        while (bridge != NULL && (n = uart_bridge_rx_peek(bridge, &data)) > 0) {
+            size_t space = tcp_out_space(&s_client_out);
+            if (n > space) n = space;
+            if (n == 0) break;
+            int64_t stamp_us = uart_bridge_rx_oldest_us(bridge);
+            uart_bridge_rx_consume(bridge, tcp_out_write(&s_client_out, data, n, stamp_us));
         }
+        while ((n = byte_ring_peek(&s_tx_ring, &data)) > 0) {
+            size_t space = tcp_out_space(&s_client_out);
+            if (n > space) n = space;
+            if (n == 0) break;
+            byte_ring_consume(&s_tx_ring, tcp_out_write(&s_client_out, data, n, 0));
+        }
+
+        if (!tcp_out_flush(&s_client_out, false)) {
+            ESP_LOGE(TAG, "Send failed, closing");
+            break;
+        }
+        tcp_out_get_stats(&s_client_out, &s_client_out_stats);
     }
+    s_bridge_attached = false;
+    tcp_out_detach(&s_client_out);
 
     /* Cleanup */
     close(s_client_socket);
@@ -309,6 +468,222 @@ static void client_task(void *pvParameters)
     vTaskDelete(NULL);
 }
 
+/**
+ * @brief Show the capture progress on the Log SD button (LVGL thread)
+ * 
+ * A write error ends the capture: the button is released and a note printed.
+ */
+static void update_log_button(void)
+{
+    extern lv_ui guider_ui;
+
+    lv_obj_t *btn = guider_ui.scrWirelessSerial_btnLogSD;
+    if (s_log == NULL || btn == NULL || !lv_obj_is_valid(btn)) {
+        return;
+    }
+
+    serial_log_status_t status;
+    serial_log_get_status(s_log, &status);
+
+    char text[24];
+    if (status.state == SERIAL_LOG_ERROR) {
+        if (lv_obj_has_state(btn, LV_STATE_CHECKED)) {
+            lv_obj_clear_state(btn, LV_STATE_CHECKED);
+            wireless_serial_print_receive("\n[Log] SD card write failed\n");
+            wireless_serial_stop_log();
+        }
+        snprintf(text, sizeof(text), "Log SD");
+    } else if (status.state == SERIAL_LOG_LOGGING) {
+        lv_obj_add_state(btn, LV_STATE_CHECKED);    /* The screen may have been rebuilt */
+        uint32_t kb = (uint32_t)(status.bytes_written / 1024);
+        if (kb < 100 * 1024) {
+            snprintf(text, sizeof(text), "%lu.%lu MB", (unsigned long)(kb / 1024), (unsigned long)(kb % 1024 * 10 / 1024));
+        } else {
+            snprintf(text, sizeof(text), "%lu MB", (unsigned long)(kb / 1024));
+        }
+    } else if (status.state == SERIAL_LOG_FINISHING) {
+        snprintf(text, sizeof(text), "Saving");
+    } else {
+        snprintf(text, sizeof(text), "Log SD");
+    }
+
+    lv_obj_t *label = guider_ui.scrWirelessSerial_btnLogSD_label;
+    if (strcmp(lv_label_get_text(label), text) != 0) {
+        lv_label_set_text(label, text);
+    }
+}
+
+/**
+ * @brief Show the frames decoded per second on the frame selector (LVGL thread)
+ */
+static void update_frame_counter(uint32_t elapsed_ms)
+{
+    extern lv_ui guider_ui;
+    static char text[32];       /* Shown by the dropdown in place */
+
+    uint32_t frames = s_net_frames.parser.stats.frames + s_uart_frames.parser.stats.frames;
+    uint32_t rate = (uint32_t)((uint64_t)(frames - s_frames_counted) * 1000 / (elapsed_ms ? elapsed_ms : 1));
+    s_frames_counted = frames;
+
+    lv_obj_t *dd = guider_ui.scrWirelessSerial_dropdownFrames;
+    if (dd == NULL || !lv_obj_is_valid(dd)) {
+        return;
+    }
+    if (s_frame_decoder == NULL) {
+        lv_dropdown_set_text(dd, NULL);     /* The selected option */
+        return;
+    }
+
+    char next[sizeof(text)];
+    snprintf(next, sizeof(next), "%s %lu f/s", s_frame_decoder->name, (unsigned long)rate);
+    if (lv_dropdown_get_text(dd) != text || strcmp(text, next) != 0) {
+        memcpy(text, next, sizeof(text));
+        lv_dropdown_set_text(dd, text);
+        lv_obj_invalidate(dd);
+    }
+}
+
+/**
+ * @brief Log the latency summary while samples come in (LVGL thread)
+ */
+static void log_latency(void)
+{
+    latency_hist_snapshot_t snap;
+    latency_hist_snapshot(&s_latency, &snap, false);
+    if (snap.count == s_latency_logged) {
+        return;
+    }
+    s_latency_logged = snap.count;
+
+    char line[96];
+    latency_hist_format(&snap, line, sizeof(line));
+    ESP_LOGI(TAG, "UART -> TCP (%s): %s", tcp_out_mode_name(s_send_mode), line);
+}
+
+/**
+ * @brief A decoded frame becomes one row of the receive view (parser callback)
+ * 
+ * "<source><number> <fields>", e.g. "U12 @1 fc03 Read Holding: 04 00 2A 01 00".
+ */
+static void frame_row_cb(const frame_t *frame, void *user)
+{
+    frame_view_t *view = user;
+    char row[FRAME_ROW_MAX];
+
+    int n = snprintf(row, sizeof(row), "%c%lu ", view->tag, (unsigned long)view->parser.stats.frames);
+    n += frame_parser_describe(&view->parser, frame, row + n, sizeof(row) - n - 1);
+    row[n++] = '\n';
+    lv_terminal_append(s_terminal, row, n);
+    s_rx_rendered += frame->len;
+}
+
+/**
+ * @brief Next UART gap position recorded by the bridge task (LVGL thread)
+ */
+static bool next_gap(size_t *pos)
+{
+    if (!s_have_gap) {
+        s_have_gap = byte_ring_read(&s_gap_ring, &s_next_gap, sizeof(s_next_gap)) == sizeof(s_next_gap);
+    }
+    *pos = s_next_gap;
+    return s_have_gap;
+}
+
+/**
+ * @brief Decode a receive ring into frame rows (LVGL thread)
+ * 
+ * The parser reads the ring memory in place; a span is released only after
+ * frame_parser_sync(), so frames that lie whole in it are never copied.
+ * UART data is cut at the gaps the bridge task recorded, so Modbus-RTU
+ * frames end where they did on the line. A flush that finds the ring empty
+ * counts as a gap too (nothing arrived for a whole display frame), which
+ * ends the last frame of a burst and is the only gap network data has.
+ */
+static void flush_frames(frame_view_t *view, bool uart_gaps)
+{
+    size_t budget = WIRELESS_SERIAL_UI_FLUSH_MAX;
+    const uint8_t *data;
+    size_t n;
+    size_t gap;
+
+    if (byte_ring_used(view->ring) == 0) {
+        frame_parser_gap(&view->parser);
+        return;
+    }
+
+    while (budget > 0 && (n = byte_ring_peek(view->ring, &data)) > 0) {
+        if (n > budget) n = budget;
+
+        /* Positions are read after the bytes: a gap is recorded before its data */
+        bool gap_after = false;
+        while (uart_gaps && next_gap(&gap)) {
+            size_t ahead = gap - view->shown;
+            if (ahead == 0 || ahead > SIZE_MAX / 2) {
+                frame_parser_gap(&view->parser);    /* At or behind this span */
+                s_have_gap = false;
+                continue;
+            }
+            if (ahead <= n) {
+                n = ahead;
+                gap_after = true;
+            }
+            break;
+        }
+
+        frame_parser_feed(&view->parser, data, n);
+        if (gap_after) {
+            frame_parser_gap(&view->parser);
+            s_have_gap = false;
+        }
+        frame_parser_sync(&view->parser);
+        byte_ring_consume(view->ring, n);
+        view->shown += n;
+        budget -= n;
+    }
+}
+
+/**
+ * @brief Receive flush timer (LVGL thread) - moves a bounded batch to the view
+ * 
+ * While the screen is not shown the data waits in the rings.
+ */
+static void ui_flush_timer_cb(lv_timer_t *timer)
+{
+    static uint8_t chunk[WIRELESS_SERIAL_UI_FLUSH_MAX];
+    static uint32_t status_ms = 0;
+    static uint32_t latency_ms = 0;
+
+    uint32_t elapsed = lv_tick_elaps(status_ms);
+    if (elapsed >= UI_STATUS_PERIOD_MS) {
+        status_ms = lv_tick_get();
+        update_log_button();
+        update_frame_counter(elapsed);
+    }
+    if (lv_tick_elaps(latency_ms) >= WIRELESS_SERIAL_LATENCY_LOG_MS) {
+        latency_ms = lv_tick_get();
+        log_latency();
+    }
+    if (s_terminal == NULL) {
+        return;
+    }
+
+    if (s_frame_decoder != NULL) {
+        flush_frames(&s_net_frames, false);
+        flush_frames(&s_uart_frames, true);
+        return;
+    }
+
+    size_t n_net = byte_ring_read(&s_net_ring, chunk, sizeof(chunk));
+    size_t n_uart = byte_ring_read(&s_uart_ring, chunk + n_net, sizeof(chunk) - n_net);
+    s_net_frames.shown += n_net;
+    s_uart_frames.shown += n_uart;
+    byte_ring_discard(&s_gap_ring);
+    s_have_gap = false;
+    if (n_net + n_uart > 0) {
+        wireless_serial_update_ui_receive(chunk, n_net + n_uart);
+    }
+}
+
 /* ==================== Public API Functions ==================== */
 
 esp_err_t wireless_serial_init(wireless_serial_data_cb_t data_callback,
@@ -320,22 +695,31 @@ esp_err_t wireless_serial_init(wireless_serial_data_cb_t data_callback,
     s_status_callback = status_callback;
     s_status = WS_STATUS_DISCONNECTED;
 
-    /* Initialize UART for passthrough */
-    uart_config_t uart_config = {
-        .baud_rate = 115200,
-        .data_bits = UART_DATA_8_BITS,
-        .parity = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_DEFAULT,
-    };
-    
-    ESP_ERROR_CHECK(uart_driver_install(UART_PORT_NUM, UART_BUF_SIZE * 2, 0, 0, NULL, 0));
-    ESP_ERROR_CHECK(uart_param_config(UART_PORT_NUM, &uart_config));
-    ESP_ERROR_CHECK(uart_set_pin(UART_PORT_NUM, UART_TX_PIN, UART_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
-
-    ESP_LOGI(TAG, "UART initialized on TX:%d RX:%d", UART_TX_PIN, UART_RX_PIN);
-
+    /* Receive rings and their LVGL-side flush */
+    if (byte_ring_init(&s_net_ring, WIRELESS_SERIAL_NET_RING_SIZE) != ESP_OK ||
+        byte_ring_init(&s_uart_ring, WIRELESS_SERIAL_UART_RING_SIZE) != ESP_OK ||
+        byte_ring_init(&s_tx_ring, WIRELESS_SERIAL_TX_RING_SIZE) != ESP_OK ||
+        byte_ring_init(&s_gap_ring, WIRELESS_SERIAL_GAP_RING_SIZE) != ESP_OK ||
+        tcp_out_init(&s_client_out, WIRELESS_SERIAL_CLIENT_QUEUE_SIZE) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to allocate rings");
+        byte_ring_deinit(&s_net_ring);
+        byte_ring_deinit(&s_uart_ring);
+        byte_ring_deinit(&s_tx_ring);
+        byte_ring_deinit(&s_gap_ring);
+        tcp_out_deinit(&s_client_out);
+        return ESP_ERR_NO_MEM;
+    }
+    latency_hist_init(&s_latency);
+    s_latency_logged = 0;
+    s_rx_rendered = 0;
+    s_uart_stored = 0;
+    s_uart_last_us = 0;
+    s_have_gap = false;
+    s_net_frames.shown = 0;
+    s_uart_frames.shown = 0;
+    s_ui_flush_timer = lv_timer_create(ui_flush_timer_cb, UI_FLUSH_PERIOD_MS, NULL);
+
+    /* The UART driver is installed by the bridge when passthrough is enabled */
     return ESP_OK;
 }
 
@@ -347,10 +731,22 @@ esp_err_t wireless_serial_deinit(void)
     wireless_serial_disconnect();
     wireless_serial_disable_uart_passthrough();
 
+    /* The tasks that feed the log are gone: write out what it holds */
+    serial_log_destroy(s_log);
+    s_log = NULL;
+
     s_data_callback = NULL;
     s_status_callback = NULL;
-    
-    uart_driver_delete(UART_PORT_NUM);
+
+    if (s_ui_flush_timer != NULL) {
+        lv_timer_del(s_ui_flush_timer);
+        s_ui_flush_timer = NULL;
+    }
+    byte_ring_deinit(&s_net_ring);
+    byte_ring_deinit(&s_uart_ring);
+    byte_ring_deinit(&s_tx_ring);
+    byte_ring_deinit(&s_gap_ring);
+    tcp_out_deinit(&s_client_out);
 
     return ESP_OK;
 }
@@ -385,14 +781,11 @@ esp_err_t wireless_serial_stop_server(void)
         s_client_socket = -1;
     }
 
-    if (s_server_socket >= 0) {
-        close(s_server_socket);
-        s_server_socket = -1;
-    }
-
-    /* Wait for task to finish */
+    /* Wait for the server loop to close its sockets (one poll period) */
     if (s_server_task) {
-        vTaskDelay(pdMS_TO_TICKS(100));
+        for (int i = 0; i < 20 && s_hub != NULL; i++) {
+            vTaskDelay(pdMS_TO_TICKS(HUB_POLL_MS));
+        }
         s_server_task = NULL;
     }
 
@@ -459,19 +852,21 @@ esp_err_t wireless_serial_disconnect(void)
 
 esp_err_t wireless_serial_send(const uint8_t *data, size_t len)
 {
-    if (s_client_socket < 0) {
+    /* The network loop sends it: to every client (server) or to the server (client) */
+    if (s_server_task != NULL) {
+        if (s_hub_stats.clients == 0) {
+            ESP_LOGW(TAG, "No clients, cannot send");
+            return ESP_ERR_INVALID_STATE;
+        }
+    } else if (s_client_socket < 0) {
         ESP_LOGW(TAG, "Not connected, cannot send");
         return ESP_ERR_INVALID_STATE;
     }
 
-    int sent = send(s_client_socket, data, len, 0);
-    if (sent < 0) {
-        ESP_LOGE(TAG, "Send failed: errno %d", errno);
-        return ESP_FAIL;
-    }
-
-    ESP_LOGI(TAG, "Sent %d bytes", sent);
-    return ESP_OK;
+    size_t queued = byte_ring_write(&s_tx_ring, data, len);
+    serial_log_write(s_log, SERIAL_LOG_LOCAL_TX, data, queued);
+    ESP_LOGD(TAG, "Queued %u bytes", (unsigned)queued);
+    return queued == len ? ESP_OK : ESP_ERR_NO_MEM;
 }
 
 esp_err_t wireless_serial_enable_uart_passthrough(void)
@@ -481,33 +876,203 @@ esp_err_t wireless_serial_enable_uart_passthrough(void)
         return ESP_ERR_INVALID_STATE;
     }
 
+    /* A bridge left over from a stop that timed out still holds the UART */
+    if (s_bridge != NULL) {
+        esp_err_t ret = wireless_serial_disable_uart_passthrough();
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
     ESP_LOGI(TAG, "Enabling UART passthrough");
-    s_uart_passthrough_enabled = true;
 
-    /* Start UART RX task */
-    xTaskCreate(uart_rx_task, "uart_rx", 4096, NULL, 5, &s_uart_rx_task);
+    uart_bridge_config_t config = UART_BRIDGE_CONFIG_DEFAULT();
+    config.uart_num = UART_PORT_NUM;
+    config.baud_rate = UART_BAUD_RATE;
+    config.tx_pin = UART_TX_PIN;
+    config.rx_pin = UART_RX_PIN;
+    config.rts_pin = WIRELESS_SERIAL_UART_RTS_PIN;
+    config.cts_pin = WIRELESS_SERIAL_UART_CTS_PIN;
+    config.flow = s_bridge_flow;
+    config.mode = s_bridge_mode;
+    config.flush_char = '\n';
+    config.on_uart_data = bridge_uart_data;
+
+    esp_err_t ret = uart_bridge_start(&config, &s_bridge);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    /* The network loop picks the bridge up on its next pass */
+    s_uart_passthrough_enabled = true;
 
+    ESP_LOGI(TAG, "UART passthrough on TX:%d RX:%d", UART_TX_PIN, UART_RX_PIN);
     return ESP_OK;
 }
 
 esp_err_t wireless_serial_disable_uart_passthrough(void)
 {
-    if (!s_uart_passthrough_enabled) {
+    if (s_bridge == NULL) {
         return ESP_OK;
     }
 
     ESP_LOGI(TAG, "Disabling UART passthrough");
     s_uart_passthrough_enabled = false;
 
-    /* Wait for UART task to finish */
-    if (s_uart_rx_task) {
-        vTaskDelay(pdMS_TO_TICKS(100));
-        s_uart_rx_task = NULL;
+    /* Let the network loop let go of the bridge (one poll period) */
+    for (int i = 0; i < 20 && s_bridge_attached; i++) {
+        vTaskDelay(pdMS_TO_TICKS(HUB_POLL_MS));
     }
+    if (s_bridge_attached) {
+        /* Not freed under the loop; a later call retries */
+        ESP_LOGE(TAG, "Network loop still holds the UART bridge");
+        return ESP_ERR_TIMEOUT;
+    }
+
+    esp_err_t ret = uart_bridge_stop(s_bridge);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    s_bridge = NULL;
 
     return ESP_OK;
 }
 
+esp_err_t wireless_serial_set_uart_bridge(uart_bridge_mode_t mode, uart_bridge_flow_t flow)
+{
+    if (flow == UART_BRIDGE_FLOW_RTS_CTS &&
+        (WIRELESS_SERIAL_UART_RTS_PIN < 0 || WIRELESS_SERIAL_UART_CTS_PIN < 0)) {
+        ESP_LOGW(TAG, "RTS/CTS pins not configured");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    s_bridge_mode = mode;
+    s_bridge_flow = flow;
+
+    /* Restart a running bridge to apply it */
+    if (s_uart_passthrough_enabled) {
+        esp_err_t ret = wireless_serial_disable_uart_passthrough();
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        return wireless_serial_enable_uart_passthrough();
+    }
+    return ESP_OK;
+}
+
+esp_err_t wireless_serial_get_bridge_stats(uart_bridge_stats_t *stats)
+{
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_bridge == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    uart_bridge_get_stats(s_bridge, stats);
+    return ESP_OK;
+}
+
+void wireless_serial_set_send_mode(tcp_out_mode_t mode)
+{
+    /* The network task picks it up on its next pass */
+    s_send_mode = mode;
+
+    latency_hist_snapshot_t discard;
+    latency_hist_snapshot(&s_latency, &discard, true);
+    s_latency_logged = 0;
+    ESP_LOGI(TAG, "Send mode: %s", tcp_out_mode_name(mode));
+}
+
+tcp_out_mode_t wireless_serial_get_send_mode(void)
+{
+    return s_send_mode;
+}
+
+void wireless_serial_get_latency(latency_hist_snapshot_t *snap)
+{
+    if (snap != NULL) {
+        latency_hist_snapshot(&s_latency, snap, false);
+    }
+}
+
+esp_err_t wireless_serial_start_log(void)
+{
+    if (s_log == NULL) {
+        esp_err_t ret = serial_log_create(NULL, &s_log);
+        if (ret != ESP_OK) {
+            s_log = NULL;
+            return ret;
+        }
+    }
+
+    struct stat st;
+    if (stat(WIRELESS_SERIAL_LOG_DIR, &st) != 0 && mkdir(WIRELESS_SERIAL_LOG_DIR, 0755) != 0) {
+        ESP_LOGE(TAG, "Failed to create %s: %s", WIRELESS_SERIAL_LOG_DIR, strerror(errno));
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    /* serial_YYYYMMDD_HHMMSS, with -N added if that second is taken */
+    char base[SERIAL_LOG_PATH_MAX - 16];
+    char first[SERIAL_LOG_PATH_MAX];
+    time_t now = time(NULL);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    int n = snprintf(base, sizeof(base), "%s/serial_", WIRELESS_SERIAL_LOG_DIR);
+    strftime(base + n, sizeof(base) - n, "%Y%m%d_%H%M%S", &tm);
+    size_t len = strlen(base);
+    for (int i = 1; i < 100; i++) {
+        snprintf(first, sizeof(first), "%s_0000%s", base, SERIAL_LOG_EXT);
+        if (stat(first, &st) != 0) {
+            break;
+        }
+        snprintf(base + len, sizeof(base) - len, "-%d", i);
+    }
+
+    /* The baud rate goes in the header for the reader; 0 while the UART is off */
+    esp_err_t ret = serial_log_start(s_log, base, s_uart_passthrough_enabled ? UART_BAUD_RATE : 0);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    char note[SERIAL_LOG_PATH_MAX + 16];
+    snprintf(note, sizeof(note), "\n[Log] %s\n", first);
+    wireless_serial_print_receive(note);
+    return ESP_OK;
+}
+
+void wireless_serial_stop_log(void)
+{
+    if (s_log == NULL) {
+        return;
+    }
+
+    serial_log_status_t status;
+    serial_log_get_status(s_log, &status);
+    if (status.state != SERIAL_LOG_LOGGING && status.state != SERIAL_LOG_ERROR) {
+        return;
+    }
+    serial_log_stop(s_log);
+
+    char note[64];
+    snprintf(note, sizeof(note), "\n[Log] stopped: %llu KB, %llu bytes lost\n",
+             status.bytes_logged / 1024, status.lost_bytes);
+    wireless_serial_print_receive(note);
+}
+
+esp_err_t wireless_serial_get_log_status(serial_log_status_t *status)
+{
+    if (status == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_log == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    serial_log_get_status(s_log, status);
+    return ESP_OK;
+}
+
 wireless_serial_status_t wireless_serial_get_status(void)
 {
     return s_status;
@@ -518,6 +1083,32 @@ bool wireless_serial_is_connected(void)
     return (s_status == WS_STATUS_CONNECTED);
 }
 
+void wireless_serial_get_stats(wireless_serial_stats_t *stats)
+{
+    if (stats == NULL) {
+        return;
+    }
+
+    uint32_t net_written, net_dropped, uart_written, uart_dropped;
+    byte_ring_get_counts(&s_net_ring, &net_written, &net_dropped);
+    byte_ring_get_counts(&s_uart_ring, &uart_written, &uart_dropped);
+
+    stats->rx_bytes = net_written + uart_written;
+    stats->rx_dropped = net_dropped + uart_dropped;
+    stats->rx_rendered = s_rx_rendered;
+    stats->rx_pending = byte_ring_used(&s_net_ring) + byte_ring_used(&s_uart_ring);
+    stats->clients = s_hub_stats.clients;
+    stats->tx_dropped = s_hub_stats.fanout_dropped;
+    stats->clients_stalled = s_hub_stats.stalled;
+    if (s_server_task != NULL) {
+        stats->tx_bytes = s_hub_stats.fanout_sent;
+        stats->tx_sends = s_hub_stats.fanout_sends;
+    } else {
+        stats->tx_bytes = s_client_out_stats.bytes;
+        stats->tx_sends = s_client_out_stats.sends;
+    }
+}
+
 /* ==================== UI Interface Functions ==================== */
 
 void wireless_serial_toggle_connection(void)
@@ -541,24 +1132,163 @@ void wireless_serial_send_data(const char *data, size_t len)
 
 void wireless_serial_update_ui_receive(const uint8_t *data, size_t len)
 {
-    /* Get UI reference */
+    if (s_terminal == NULL || data == NULL || len == 0) {
+        return;
+    }
+
+    /* Costs O(len) however full the scrollback is; drawn on the next refresh */
+    lv_terminal_append(s_terminal, data, len);
+    s_rx_rendered += len;
+}
+
+/**
+ * @brief Receive terminal events - forget it with its screen, long press pauses
+ */
+static void receive_view_event_cb(lv_event_t *e)
+{
+    lv_event_code_t code = lv_event_get_code(e);
+    lv_obj_t *obj = lv_event_get_target(e);
+
+    if (code == LV_EVENT_DELETE) {
+        if (obj == s_terminal) {
+            s_terminal = NULL;
+        }
+    } else if (code == LV_EVENT_LONG_PRESSED) {
+        lv_terminal_set_paused(obj, !lv_terminal_get_paused(obj));
+        ESP_LOGI(TAG, "Receive view %s", lv_terminal_get_paused(obj) ? "paused" : "resumed");
+    }
+}
+
+esp_err_t wireless_serial_attach_receive_view(void)
+{
     extern lv_ui guider_ui;
 
-    if (guider_ui.scrWirelessSerial_textareaReceive) {
-        /* Get current text */
-        const char *current_text = lv_textarea_get_text(guider_ui.scrWirelessSerial_textareaReceive);
+    lv_obj_t *ta = guider_ui.scrWirelessSerial_textareaReceive;
+    if (ta == NULL || !lv_obj_is_valid(ta)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_terminal != NULL) {
+        return ESP_OK;
+    }
+
+    lv_obj_t *term = lv_terminal_create(lv_obj_get_parent(ta));
+    if (!lv_terminal_set_scrollback(term, WIRELESS_SERIAL_SCROLLBACK_SIZE, WIRELESS_SERIAL_SCROLLBACK_ROWS)) {
+        ESP_LOGE(TAG, "Failed to allocate receive scrollback");
+        lv_obj_del(term);
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Same card as the textarea; a smaller font fits more columns */
+    lv_obj_set_pos(term, lv_obj_get_x(ta), lv_obj_get_y(ta));
+    lv_obj_set_size(term, lv_obj_get_width(ta), lv_obj_get_height(ta));
+    lv_obj_set_style_bg_opa(term, 255, LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_bg_color(term, lv_obj_get_style_bg_color(ta, LV_PART_MAIN), LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_border_width(term, 0, LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_radius(term, lv_obj_get_style_radius(ta, LV_PART_MAIN), LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_shadow_width(term, 0, LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_pad_all(term, lv_obj_get_style_pad_top(ta, LV_PART_MAIN), LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_text_color(term, lv_obj_get_style_text_color(ta, LV_PART_MAIN), LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(term, &lv_font_montserratMedium_16, LV_PART_MAIN|LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(term, &lv_font_montserratMedium_12, LV_PART_ITEMS|LV_STATE_DEFAULT);    /* Hex rows */
+    lv_obj_add_event_cb(term, receive_view_event_cb, LV_EVENT_ALL, NULL);
+
+    /* Carry over what the textarea shows, then hide it */
+    const char *text = lv_textarea_get_text(ta);
+    lv_terminal_append(term, text, strlen(text));
+    lv_obj_add_flag(ta, LV_OBJ_FLAG_HIDDEN);
+    lv_terminal_set_hex(term, s_receive_hex);
+
+    s_terminal = term;
+    return ESP_OK;
+}
+
+void wireless_serial_clear_receive(void)
+{
+    if (s_terminal != NULL) {
+        lv_terminal_clear(s_terminal);
+    }
+}
+
+void wireless_serial_print_receive(const char *text)
+{
+    if (s_terminal != NULL && text != NULL) {
+        lv_terminal_append(s_terminal, text, strlen(text));
+    }
+}
 
-        /* Create new text with received data appended */
-        char new_text[WIRELESS_SERIAL_BUFFER_SIZE + 256];
-        snprintf(new_text, sizeof(new_text), "%s%.*s",
-                 current_text ? current_text : "", (int)len, data);
+void wireless_serial_set_receive_hex(bool hex)
+{
+    s_receive_hex = hex;
+    if (s_terminal != NULL) {
+        lv_terminal_set_hex(s_terminal, hex);
+    }
+}
+
+bool wireless_serial_search_receive(const char *text)
+{
+    return s_terminal != NULL && lv_terminal_search(s_terminal, text, true);
+}
 
-        /* Update textarea */
-        lv_textarea_set_text(guider_ui.scrWirelessSerial_textareaReceive, new_text);
+void wireless_serial_set_frame_decoder(const frame_decoder_t *decoder)
+{
+    /* Partial frames are dropped; bytes still in the rings go to the new decoder */
+    s_frame_decoder = decoder;
+    if (decoder != NULL) {
+        frame_parser_init(&s_net_frames.parser, decoder, s_net_frames.buf, sizeof(s_net_frames.buf),
+                          frame_row_cb, &s_net_frames);
+        frame_parser_init(&s_uart_frames.parser, decoder, s_uart_frames.buf, sizeof(s_uart_frames.buf),
+                          frame_row_cb, &s_uart_frames);
+    }
+    s_frames_counted = 0;
+    ESP_LOGI(TAG, "Receive view: %s", decoder ? decoder->name : "raw");
+}
 
-        /* Scroll to bottom to show latest data */
-        lv_textarea_set_cursor_pos(guider_ui.scrWirelessSerial_textareaReceive, LV_TEXTAREA_CURSOR_LAST);
+void wireless_serial_print_latency(void)
+{
+    latency_hist_snapshot_t snap;
+    wireless_serial_stats_t stats;
+    latency_hist_snapshot(&s_latency, &snap, false);
+    wireless_serial_get_stats(&stats);
+
+    char row[112];
+    int n = snprintf(row, sizeof(row), "[Latency] UART -> TCP, %s: ", tcp_out_mode_name(s_send_mode));
+    latency_hist_format(&snap, row + n, sizeof(row) - n);
+    ESP_LOGI(TAG, "%s", row);
+    wireless_serial_print_receive("\n");
+    wireless_serial_print_receive(row);
+    wireless_serial_print_receive("\n");
+
+    /* One row per bucket in use: "<  1024us     57 ######" */
+    uint32_t peak = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        if (snap.counts[i] > peak) peak = snap.counts[i];
     }
+    for (int i = 0; i < LATENCY_HIST_BUCKETS && peak > 0; i++) {
+        if (snap.counts[i] == 0) {
+            continue;
+        }
+        uint32_t bound = latency_hist_bucket_us(i);
+        if (bound == UINT32_MAX) {
+            n = snprintf(row, sizeof(row), ">= %6luus %8lu ", (unsigned long)latency_hist_bucket_us(i - 1),
+                         (unsigned long)snap.counts[i]);
+        } else {
+            n = snprintf(row, sizeof(row), "<  %6luus %8lu ", (unsigned long)bound, (unsigned long)snap.counts[i]);
+        }
+        int bar = (int)((uint64_t)snap.counts[i] * 24 / peak);
+        for (int j = 0; j < (bar > 0 ? bar : 1); j++) {
+            row[n++] = '#';
+        }
+        row[n] = '\0';
+        ESP_LOGI(TAG, "%s", row);
+        wireless_serial_print_receive(row);
+        wireless_serial_print_receive("\n");
+    }
+
+    snprintf(row, sizeof(row), "[Latency] %lu sends, %lu bytes per send",
+             (unsigned long)stats.tx_sends, (unsigned long)(stats.tx_sends ? stats.tx_bytes / stats.tx_sends : 0));
+    ESP_LOGI(TAG, "%s", row);
+    wireless_serial_print_receive(row);
+    wireless_serial_print_receive("\n");
 }
 
 void wireless_serial_update_ui_status(wireless_serial_status_t status)
@@ -17,6 +17,53 @@
  * 3. Use wireless_serial_send() to send data
  * 4. Received data is automatically displayed in UI
  * 
+ * Server mode: one task runs a poll() loop (ws_hub) over the listen socket,
+ * up to WIRELESS_SERIAL_MAX_CLIENTS clients and the UART. UART data fans out
+ * to every client through a bounded queue each; a client that falls behind
+ * loses what does not fit and is dropped after WIRELESS_SERIAL_STALL_TIMEOUT_MS,
+ * without holding up the UART or the other clients.
+ * 
+ * UART passthrough runs on a uart_bridge: the UART driver's event queue
+ * wakes a receive task that fills a large ring, the network loop (server or
+ * client) polls the bridge beside its sockets, and a transmit task writes
+ * network data to the UART, so neither side waits on the other. Coalescing
+ * (low latency / throughput) and RTS/CTS or XON/XOFF flow control are set
+ * with wireless_serial_set_uart_bridge().
+ * 
+ * Receive path: the socket task and the UART bridge only copy into
+ * lock-free SPSC byte rings (one per producer). An lv_timer on the LVGL
+ * thread drains them once per display frame, appending at most
+ * WIRELESS_SERIAL_UI_FLUSH_MAX bytes, so LVGL is never touched from the
+ * network tasks and a slow UI drops data (counted) instead of stalling the
+ * link.
+ * 
+ * The receive view is an lv_terminal (wireless_serial_attach_receive_view()):
+ * a fixed scrollback of WIRELESS_SERIAL_SCROLLBACK_SIZE bytes in PSRAM of
+ * which only the visible rows are drawn, so a frame costs the same with an
+ * empty or a full scrollback. The scrollback keeps the raw bytes, so the
+ * hex view (wireless_serial_set_receive_hex()) formats just the rows in
+ * view from them.
+ * 
+ * "Log SD" (wireless_serial_start_log()) captures the UART, network and
+ * screen traffic with microsecond timestamps to WIRELESS_SERIAL_LOG_DIR
+ * through a serial_log: the tasks above only add a copy into one more ring
+ * each, and the card is written by the log's own tasks (see serial_log.h).
+ * 
+ * The receive view can show decoded frames instead of the raw stream
+ * (wireless_serial_set_frame_decoder()): the flush feeds each ring to a
+ * frame_parser straight from the ring memory and appends one row per frame.
+ * The bridge task notes where the UART line was idle for 3.5 characters
+ * before a chunk, which is what ends a Modbus-RTU frame; that needs the
+ * low latency bridge mode, whose short receive timeout keeps gaps apart.
+ * 
+ * Send path: everything bound for a connection (UART data and text from the
+ * screen, in server and client mode alike) goes through a tcp_out buffer
+ * that sends at once, coalesces into full segments within 2 ms, or batches
+ * bulk data (wireless_serial_set_send_mode()). The time from a UART byte
+ * being read to its send() is kept in a histogram, shown with
+ * wireless_serial_print_latency() and logged every
+ * WIRELESS_SERIAL_LATENCY_LOG_MS while there is traffic.
+ * 
  * @note This module is tightly coupled with the scrWirelessSerial UI page.
  */
 
@@ -31,6 +78,10 @@ extern "C" {
 #include <stdbool.h>
 #include <stddef.h>
 #include "esp_err.h"
+#include "uart_bridge.h"
+#include "serial_log.h"
+#include "frame_parser.h"
+#include "tcp_out.h"
 
 /* ==================== Configuration ==================== */
 
@@ -43,6 +94,46 @@ extern "C" {
 /** Size of receive/transmit buffer in bytes */
 #define WIRELESS_SERIAL_BUFFER_SIZE 1024
 
+/** Receive ring between the socket tasks and the UI */
+#define WIRELESS_SERIAL_NET_RING_SIZE   (32 * 1024)
+
+/** Receive ring between the UART bridge and the UI */
+#define WIRELESS_SERIAL_UART_RING_SIZE  (8 * 1024)
+
+/** Send ring between the UI and the server task */
+#define WIRELESS_SERIAL_TX_RING_SIZE    (4 * 1024)
+
+/** UART data queued per client before it is dropped for that client */
+#define WIRELESS_SERIAL_CLIENT_QUEUE_SIZE   (16 * 1024)
+
+/** A client whose queue stays full this long is disconnected */
+#define WIRELESS_SERIAL_STALL_TIMEOUT_MS    5000
+
+/** Most bytes appended to the receive view per frame */
+#define WIRELESS_SERIAL_UI_FLUSH_MAX    (16 * 1024)
+
+/** Receive scrollback text; the oldest rows are dropped when it is full */
+#define WIRELESS_SERIAL_SCROLLBACK_SIZE (256 * 1024)
+
+/** Receive scrollback rows */
+#define WIRELESS_SERIAL_SCROLLBACK_ROWS 8192
+
+/** Longest frame decoded by the frame view (per source) */
+#define WIRELESS_SERIAL_FRAME_MAX       1024
+
+/** UART gap positions queued between the bridge and the frame view */
+#define WIRELESS_SERIAL_GAP_RING_SIZE   (2 * 1024)
+
+/** UART -> network latency summary in the log this often (while there are samples) */
+#define WIRELESS_SERIAL_LATENCY_LOG_MS  10000
+
+/** Capture logs: serial_YYYYMMDD_HHMMSS_NNNN.wsl */
+#define WIRELESS_SERIAL_LOG_DIR         "/sdcard/SerialLog"
+
+/** UART passthrough RTS / CTS pins, -1 while not wired (RTS/CTS flow control unavailable) */
+#define WIRELESS_SERIAL_UART_RTS_PIN    (-1)
+#define WIRELESS_SERIAL_UART_CTS_PIN    (-1)
+
 /* ==================== Type Definitions ==================== */
 
 /**
@@ -55,8 +146,26 @@ typedef enum {
     WS_STATUS_ERROR              /**< Error state */
 } wireless_serial_status_t;
 
+/**
+ * @brief Receive path counters
+ */
+typedef struct {
+    uint32_t rx_bytes;      /**< Received from the network and UART */
+    uint32_t rx_dropped;    /**< Lost because the rings were full (UI behind) */
+    uint32_t rx_rendered;   /**< Appended to the receive view */
+    uint32_t rx_pending;    /**< Waiting in the rings */
+    uint32_t clients;       /**< Clients connected to the server */
+    uint32_t tx_dropped;    /**< UART bytes a slow client's queue could not take */
+    uint32_t clients_stalled;   /**< Clients disconnected for not keeping up */
+    uint32_t tx_bytes;      /**< Sent to the network (all clients) */
+    uint32_t tx_sends;      /**< send() calls that moved them */
+} wireless_serial_stats_t;
+
 /**
  * @brief Data received callback function type
+ * 
+ * Runs in the socket task, not on the LVGL thread.
+ * 
  * @param data Pointer to received data
  * @param len Length of received data in bytes
  */
@@ -124,6 +233,10 @@ esp_err_t wireless_serial_disconnect(void);
 /**
  * @brief Send data via wireless serial
  * 
+ * The data is queued (from one task at a time, normally the UI) and the
+ * network task sends it within one poll period, to every client in server
+ * mode, coalesced as wireless_serial_set_send_mode() says.
+ * 
  * @param data Data buffer to send
  * @param len Length of data in bytes
  * @return esp_err_t ESP_OK on success
@@ -144,6 +257,13 @@ wireless_serial_status_t wireless_serial_get_status(void);
  */
 bool wireless_serial_is_connected(void);
 
+/**
+ * @brief Get receive path counters
+ * 
+ * @param stats Output
+ */
+void wireless_serial_get_stats(wireless_serial_stats_t *stats);
+
 /**
  * @brief Enable UART passthrough for external devices (e.g., STM32)
  * 
@@ -157,10 +277,88 @@ esp_err_t wireless_serial_enable_uart_passthrough(void);
 /**
  * @brief Disable UART passthrough
  * 
- * @return esp_err_t ESP_OK on success
+ * The bridge is stopped only once the network loop has let go of it. If
+ * that loop or the bridge's transmit task (held off by flow control) does
+ * not finish in time, the bridge keeps the UART and a later call, or the
+ * next enable, retries.
+ * 
+ * @return esp_err_t ESP_OK on success, ESP_ERR_TIMEOUT if the bridge is still in use
  */
 esp_err_t wireless_serial_disable_uart_passthrough(void);
 
+/**
+ * @brief Choose how UART passthrough coalesces and flow-controls
+ * 
+ * UART_BRIDGE_THROUGHPUT holds UART data for up to a segment or 5 ms (a
+ * newline sends at once). A running passthrough restarts to apply it.
+ * 
+ * @param mode UART_BRIDGE_LOW_LATENCY (default) or UART_BRIDGE_THROUGHPUT
+ * @param flow Flow control towards the external device
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED (RTS/CTS pins not wired), or the restart's error
+ */
+esp_err_t wireless_serial_set_uart_bridge(uart_bridge_mode_t mode, uart_bridge_flow_t flow);
+
+/**
+ * @brief Get UART passthrough counters, latency and throughput
+ * 
+ * Call from the task that enables / disables passthrough.
+ * 
+ * @param stats Output; latency and rates cover the time since the previous call
+ * @return ESP_OK, ESP_ERR_INVALID_STATE while passthrough is off
+ */
+esp_err_t wireless_serial_get_bridge_stats(uart_bridge_stats_t *stats);
+
+/**
+ * @brief Choose how sends to the network are coalesced
+ * 
+ * Applies to the connections open and to come; the latency histogram
+ * starts over.
+ * 
+ * @param mode TCP_OUT_IMMEDIATE (default), TCP_OUT_COALESCED or TCP_OUT_BULK
+ */
+void wireless_serial_set_send_mode(tcp_out_mode_t mode);
+
+/**
+ * @brief Current send mode
+ */
+tcp_out_mode_t wireless_serial_get_send_mode(void);
+
+/**
+ * @brief Get the UART -> network latency histogram
+ * 
+ * One sample per UART chunk per connection, from the bridge reading it to
+ * its last byte being handed to send(); since the send mode was last set.
+ * 
+ * @param snap Output
+ */
+void wireless_serial_get_latency(latency_hist_snapshot_t *snap);
+
+/**
+ * @brief Start logging the traffic to SD card
+ * 
+ * Creates a new serial_YYYYMMDD_HHMMSS log in WIRELESS_SERIAL_LOG_DIR (see
+ * serial_log.h; tools/serial_log.py converts it to text). UART data, data
+ * from the network and data sent from the screen are logged until
+ * wireless_serial_stop_log(). Call on the LVGL thread.
+ * 
+ * @return ESP_OK, ESP_ERR_INVALID_STATE (already logging or finishing),
+ *         ESP_ERR_NOT_FOUND (no card), ESP_ERR_NO_MEM
+ */
+esp_err_t wireless_serial_start_log(void);
+
+/**
+ * @brief Stop logging (returns at once, the backlog is written in the background)
+ */
+void wireless_serial_stop_log(void);
+
+/**
+ * @brief Get the capture log status
+ * 
+ * @param status Output
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if no log was started
+ */
+esp_err_t wireless_serial_get_log_status(serial_log_status_t *status);
+
 /* ==================== UI Interface Functions ==================== */
 /* These functions are called from events_init.c for UI interaction */
 
@@ -182,13 +380,74 @@ void wireless_serial_send_data(const char *data, size_t len);
 /**
  * @brief Update UI with received data
  * 
- * Called internally when data is received. Updates the receive textarea.
+ * Called on the LVGL thread by the receive flush timer. Appends to the
+ * receive view; does nothing while the view is not attached.
  * 
  * @param data Received data
  * @param len Length of data
  */
 void wireless_serial_update_ui_receive(const uint8_t *data, size_t len);
 
+/**
+ * @brief Put the receive terminal in place of the receive textarea
+ * 
+ * Call on the LVGL thread once the screen is built. The terminal takes the
+ * textarea's place, style and text; it goes away with the screen. A long
+ * press on it pauses / resumes the view.
+ * 
+ * @return ESP_OK, ESP_ERR_INVALID_STATE (screen not built), ESP_ERR_NO_MEM
+ */
+esp_err_t wireless_serial_attach_receive_view(void);
+
+/**
+ * @brief Empty the receive view (LVGL thread)
+ */
+void wireless_serial_clear_receive(void);
+
+/**
+ * @brief Show local text (help, notes) in the receive view (LVGL thread)
+ * 
+ * @param text NUL-terminated text
+ */
+void wireless_serial_print_receive(const char *text);
+
+/**
+ * @brief Show received bytes as a hex dump or as text (LVGL thread)
+ * 
+ * Applies to the whole scrollback at once: only the visible page is
+ * formatted again. Kept for a receive view attached later.
+ * 
+ * @param hex true for offset / hex / ASCII rows
+ */
+void wireless_serial_set_receive_hex(bool hex);
+
+/**
+ * @brief Find text in the receive scrollback (LVGL thread)
+ * 
+ * Searches older rows from the previous hit (or the view), wrapping once,
+ * and scrolls the hit into view highlighted.
+ * 
+ * @param text Text to find (case-insensitive, within one row)
+ * @return true if found
+ */
+bool wireless_serial_search_receive(const char *text);
+
+/**
+ * @brief Show received data as decoded frames, one row each (LVGL thread)
+ * 
+ * Rows read "<U|N><number> <fields> [error]" for UART and network data.
+ * The frames decoded per second are shown on the frame selector.
+ * 
+ * @param decoder frame_decoder_line, _slip, _cobs, _modbus_rtu or another
+ *                frame_decoder_t; NULL for the raw stream
+ */
+void wireless_serial_set_frame_decoder(const frame_decoder_t *decoder);
+
+/**
+ * @brief Show the latency histogram and send counters in the receive view and the log (LVGL thread)
+ */
+void wireless_serial_print_latency(void);
+
 /**
  * @brief Update UI connection status display
  * 
@@ -0,0 +1,443 @@
+/**
+ * @file ws_hub.c
+ * @brief Wireless serial hub - one poll() loop for the listener, the clients and the UART
+ */
+
+#include "ws_hub.h"
+#include "esp_log.h"
+#include <sys/socket.h>
+#include <sys/poll.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *TAG = "WsHub";
+
+/* Serial bytes fanned out per poll, so the clients get a turn in between */
+#define SERIAL_BUDGET       (4 * WS_HUB_CHUNK_SIZE)
+
+/* One connection */
+typedef struct {
+    int fd;                         // -1 if the slot is free
+    tcp_out_t out;                  // Serial data waiting for this client
+    int64_t full_since_ms;          // Queue overflowed at, 0 while it keeps up
+} ws_hub_client_t;
+
+/* Hub context */
+struct ws_hub_t {
+    int listen_fd;
+    ws_hub_config_t config;
+    ws_hub_serial_t serial;
+    bool has_serial;
+    bool serial_more;               // Budget ran out with serial data due
+    ws_hub_client_t clients[WS_HUB_MAX_CLIENTS];
+    uint8_t chunk[WS_HUB_CHUNK_SIZE];
+    ws_hub_stats_t stats;
+};
+
+static void set_nonblocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+static int64_t now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* ========================================================================
+ * Connections
+ * ======================================================================== */
+
+/* Add a closing client's sends to the hub totals */
+static void count_sends(ws_hub_t *hub, ws_hub_client_t *client)
+{
+    tcp_out_stats_t out;
+    tcp_out_get_stats(&client->out, &out);
+    hub->stats.fanout_sent += out.bytes;
+    hub->stats.fanout_sends += out.sends;
+}
+
+static void close_client(ws_hub_t *hub, ws_hub_client_t *client)
+{
+    if (client->fd < 0) return;
+
+    close(client->fd);
+    client->fd = -1;
+    client->full_since_ms = 0;
+    count_sends(hub, client);
+    tcp_out_detach(&client->out);
+    hub->stats.clients--;
+    ESP_LOGI(TAG, "Client disconnected (%lu connected)", (unsigned long)hub->stats.clients);
+}
+
+static void accept_clients(ws_hub_t *hub)
+{
+    for (;;) {
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        int fd = accept(hub->listen_fd, (struct sockaddr *)&addr, &addr_len);
+        if (fd < 0) return;
+
+        ws_hub_client_t *client = NULL;
+        for (int i = 0; i < hub->config.max_clients; i++) {
+            if (hub->clients[i].fd < 0) {
+                client = &hub->clients[i];
+                break;
+            }
+        }
+        if (client == NULL) {
+            ESP_LOGW(TAG, "Connection refused: %d clients connected", hub->config.max_clients);
+            close(fd);
+            hub->stats.refused++;
+            continue;
+        }
+
+        tcp_out_attach(&client->out, fd, hub->config.send_mode, hub->config.latency);
+        client->fd = fd;
+        client->full_since_ms = 0;
+        hub->stats.clients++;
+        hub->stats.connections++;
+        ESP_LOGI(TAG, "Client connected (%lu connected)", (unsigned long)hub->stats.clients);
+    }
+}
+
+/**
+ * @brief Send what the client's queue has due until the socket is full
+ *
+ * @return false if the connection failed
+ */
+static bool flush_client(ws_hub_t *hub, ws_hub_client_t *client)
+{
+    if (!tcp_out_flush(&client->out, false)) return false;
+
+    // Caught up to half a queue: no longer stalled
+    if (client->full_since_ms != 0 && tcp_out_pending(&client->out) <= tcp_out_space(&client->out)) {
+        client->full_since_ms = 0;
+    }
+    return true;
+}
+
+/* Queue bytes to every client and send what is due at once */
+static int fan_out(ws_hub_t *hub, const uint8_t *data, size_t len, int64_t stamp_us)
+{
+    int complete = 0;
+    for (int i = 0; i < hub->config.max_clients; i++) {
+        ws_hub_client_t *client = &hub->clients[i];
+        if (client->fd < 0) continue;
+
+        size_t stored = tcp_out_write(&client->out, data, len, stamp_us);
+        if (stored < len) {
+            hub->stats.fanout_dropped += (uint32_t)(len - stored);
+            if (client->full_since_ms == 0) client->full_since_ms = now_ms();
+        } else {
+            complete++;
+        }
+        if (!flush_client(hub, client)) {
+            close_client(hub, client);
+        }
+    }
+    return complete;
+}
+
+/* Disconnect clients whose queue has stayed full too long */
+static void drop_stalled(ws_hub_t *hub)
+{
+    if (hub->config.stall_timeout_ms == 0) return;
+
+    int64_t now = now_ms();
+    for (int i = 0; i < hub->config.max_clients; i++) {
+        ws_hub_client_t *client = &hub->clients[i];
+        if (client->fd < 0 || client->full_since_ms == 0) continue;
+        if (now - client->full_since_ms > (int64_t)hub->config.stall_timeout_ms) {
+            ESP_LOGW(TAG, "Client too slow, disconnecting");
+            hub->stats.stalled++;
+            close_client(hub, client);
+        }
+    }
+}
+
+/* ========================================================================
+ * Serial port
+ * ======================================================================== */
+
+/* Fan out what the serial side has due, a chunk at a time, up to the budget */
+static void read_serial(ws_hub_t *hub)
+{
+    const ws_hub_serial_t *serial = &hub->serial;
+    size_t budget = SERIAL_BUDGET;
+    const uint8_t *data;
+    size_t n;
+
+    hub->serial_more = false;
+    while ((n = serial->rx_peek(serial->ctx, &data)) > 0) {
+        if (budget == 0) {
+            hub->serial_more = true;
+            return;
+        }
+        if (n > WS_HUB_CHUNK_SIZE) n = WS_HUB_CHUNK_SIZE;
+        if (n > budget) n = budget;
+
+        int64_t stamp_us = serial->rx_stamp_us ? serial->rx_stamp_us(serial->ctx) : 0;
+        hub->stats.serial_rx += (uint32_t)n;
+        if (hub->config.on_serial_data) {
+            hub->config.on_serial_data(data, n, hub->config.user);
+        }
+        fan_out(hub, data, n, stamp_us);
+        serial->rx_consume(serial->ctx, n);
+        budget -= n;
+    }
+}
+
+/**
+ * @brief Take what a client sent
+ *
+ * @return false if the connection closed or failed
+ */
+static bool read_client(ws_hub_t *hub, ws_hub_client_t *client)
+{
+    // Never more than the serial side can take: the rest waits in the socket
+    size_t room = sizeof(hub->chunk);
+    if (hub->has_serial) {
+        size_t space = hub->serial.tx_space(hub->serial.ctx);
+        if (space < room) room = space;
+    }
+    if (room == 0) return true;
+
+    ssize_t n = recv(client->fd, hub->chunk, room, MSG_DONTWAIT);
+    if (n == 0) return false;
+    if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+    hub->stats.client_rx += (uint32_t)n;
+    if (hub->config.on_client_data) {
+        hub->config.on_client_data(hub->chunk, (size_t)n, hub->config.user);
+    }
+    if (hub->has_serial) {
+        hub->stats.serial_tx += (uint32_t)hub->serial.tx_write(hub->serial.ctx, hub->chunk, (size_t)n);
+    }
+    return true;
+}
+
+/* ========================================================================
+ * Public API
+ * ======================================================================== */
+
+/**
+ * @brief Create a hub listening on config->port
+ */
+ws_hub_t *ws_hub_create(const ws_hub_config_t *config)
+{
+    if (config == NULL || config->max_clients <= 0 || config->max_clients > WS_HUB_MAX_CLIENTS ||
+        config->client_queue_size == 0) {
+        return NULL;
+    }
+
+    ws_hub_t *hub = calloc(1, sizeof(ws_hub_t));
+    if (hub == NULL) return NULL;
+    hub->config = *config;
+    hub->listen_fd = -1;
+    hub->config.serial = NULL;
+    ws_hub_set_serial(hub, config->serial);
+    for (int i = 0; i < WS_HUB_MAX_CLIENTS; i++) {
+        hub->clients[i].fd = -1;
+    }
+
+    bool ok = true;
+    for (int i = 0; ok && i < config->max_clients; i++) {
+        ok = tcp_out_init(&hub->clients[i].out, config->client_queue_size) == ESP_OK;
+    }
+    if (!ok) {
+        ESP_LOGE(TAG, "Failed to allocate %d client queues", config->max_clients);
+        ws_hub_destroy(hub);
+        return NULL;
+    }
+
+    hub->listen_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (hub->listen_fd < 0) {
+        ESP_LOGE(TAG, "Failed to create socket: errno %d", errno);
+        ws_hub_destroy(hub);
+        return NULL;
+    }
+
+    int opt = 1;
+    setsockopt(hub->listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr = {
+        .sin_family = AF_INET,
+        .sin_addr.s_addr = htonl(INADDR_ANY),
+        .sin_port = htons(config->port),
+    };
+    if (bind(hub->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(hub->listen_fd, config->max_clients) < 0) {
+        ESP_LOGE(TAG, "Failed to listen on port %u: errno %d", config->port, errno);
+        ws_hub_destroy(hub);
+        return NULL;
+    }
+    set_nonblocking(hub->listen_fd);
+
+    ESP_LOGI(TAG, "Listening on port %u (%d clients, %u byte queues)", config->port,
+             config->max_clients, (unsigned)config->client_queue_size);
+    return hub;
+}
+
+/**
+ * @brief Close the clients and the listener
+ */
+void ws_hub_destroy(ws_hub_t *hub)
+{
+    if (hub == NULL) return;
+
+    for (int i = 0; i < WS_HUB_MAX_CLIENTS; i++) {
+        close_client(hub, &hub->clients[i]);
+        tcp_out_deinit(&hub->clients[i].out);
+    }
+    if (hub->listen_fd >= 0) {
+        close(hub->listen_fd);
+    }
+    free(hub);
+}
+
+/**
+ * @brief Wait for socket or serial events and serve them
+ */
+esp_err_t ws_hub_poll(ws_hub_t *hub, int timeout_ms)
+{
+    if (hub == NULL) return ESP_ERR_INVALID_ARG;
+
+    struct pollfd fds[WS_HUB_MAX_CLIENTS + 2];
+    ws_hub_client_t *owners[WS_HUB_MAX_CLIENTS + 2];
+    int nfds = 0;
+
+    // The clients are read only while the serial side has room for a chunk
+    bool read_clients = !hub->has_serial || hub->serial.tx_space(hub->serial.ctx) >= WS_HUB_CHUNK_SIZE;
+
+    fds[nfds].fd = hub->listen_fd;
+    fds[nfds].events = POLLIN;
+    owners[nfds++] = NULL;
+    if (hub->has_serial) {
+        // Serial data left over or held for a batch bounds the wait
+        int due_ms = hub->serial.rx_due_ms ? hub->serial.rx_due_ms(hub->serial.ctx) : -1;
+        if (hub->serial_more) {
+            timeout_ms = 0;
+        } else if (due_ms >= 0 && (timeout_ms < 0 || due_ms < timeout_ms)) {
+            timeout_ms = due_ms;
+        }
+        if (hub->serial.wake_fd >= 0) {
+            fds[nfds].fd = hub->serial.wake_fd;
+            fds[nfds].events = POLLIN;
+            owners[nfds++] = NULL;
+        }
+    }
+    for (int i = 0; i < hub->config.max_clients; i++) {
+        ws_hub_client_t *client = &hub->clients[i];
+        if (client->fd < 0) continue;
+        // Bytes held for coalescing wait for their time, not for the socket
+        int due_ms = tcp_out_due_ms(&client->out);
+        if (due_ms > 0 && (timeout_ms < 0 || due_ms < timeout_ms)) {
+            timeout_ms = due_ms;
+        }
+        fds[nfds].fd = client->fd;
+        fds[nfds].events = (read_clients ? POLLIN : 0) | (due_ms == 0 ? POLLOUT : 0);
+        owners[nfds++] = client;
+    }
+    for (int i = 0; i < nfds; i++) {
+        fds[i].revents = 0;
+    }
+
+    int ready = poll(fds, nfds, timeout_ms);
+    if (ready < 0) {
+        if (errno == EINTR) return ESP_OK;
+        ESP_LOGE(TAG, "poll failed: errno %d", errno);
+        return ESP_FAIL;
+    }
+
+    // Held batches fall due without a wake-up, so the serial side is always asked
+    if (hub->has_serial) {
+        read_serial(hub);
+    }
+
+    for (int i = 0; i < nfds; i++) {
+        ws_hub_client_t *client = owners[i];
+        short revents = fds[i].revents;
+        if (client == NULL || revents == 0 || client->fd < 0) continue;
+
+        bool ok = (revents & (POLLERR | POLLNVAL)) == 0;
+        if (ok && (revents & (POLLIN | POLLHUP))) {
+            ok = read_client(hub, client);
+        }
+        if (ok && (revents & POLLOUT)) {
+            ok = flush_client(hub, client);
+        }
+        if (!ok) {
+            close_client(hub, client);
+        }
+    }
+
+    drop_stalled(hub);
+
+    if (fds[0].revents & POLLIN) {
+        accept_clients(hub);
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Queue bytes to every client
+ */
+int ws_hub_broadcast(ws_hub_t *hub, const void *data, size_t len)
+{
+    if (hub == NULL || data == NULL || len == 0) return 0;
+    return fan_out(hub, data, len, 0);
+}
+
+/**
+ * @brief Attach or detach the serial side
+ */
+void ws_hub_set_serial(ws_hub_t *hub, const ws_hub_serial_t *serial)
+{
+    if (hub == NULL) return;
+
+    hub->has_serial = serial != NULL;
+    hub->serial_more = false;
+    if (serial != NULL) {
+        hub->serial = *serial;
+    }
+}
+
+/**
+ * @brief Change how sends are coalesced
+ */
+void ws_hub_set_send_mode(ws_hub_t *hub, tcp_out_mode_t mode)
+{
+    if (hub == NULL) return;
+
+    hub->config.send_mode = mode;
+    for (int i = 0; i < hub->config.max_clients; i++) {
+        tcp_out_set_mode(&hub->clients[i].out, mode);
+    }
+}
+
+/**
+ * @brief Get hub counters
+ */
+void ws_hub_get_stats(ws_hub_t *hub, ws_hub_stats_t *stats)
+{
+    if (hub == NULL || stats == NULL) return;
+    *stats = hub->stats;
+
+    // Sends of the connected clients are added in when they close
+    for (int i = 0; i < hub->config.max_clients; i++) {
+        if (hub->clients[i].fd < 0) continue;
+        tcp_out_stats_t out;
+        tcp_out_get_stats(&hub->clients[i].out, &out);
+        stats->fanout_sent += out.bytes;
+        stats->fanout_sends += out.sends;
+    }
+}
@@ -0,0 +1,140 @@
+/**
+ * @file ws_hub.h
+ * @brief Wireless serial hub - one poll() loop for the listener, the clients and the UART
+ *
+ * Everything runs in the task calling ws_hub_poll(): accepting, reading the
+ * clients and the serial port, and every send. Serial data fans out to all
+ * clients through one bounded queue each (a tcp_out_t, which also decides
+ * how sends are coalesced and records the UART -> TCP latency). A client that
+ * cannot keep up loses what does not fit in its queue (counted) and is
+ * disconnected once the queue has stayed full for stall_timeout_ms, so it
+ * never holds up the UART or the other clients. Client data goes straight to the serial side's transmit
+ * queue; while that has no room the clients are not read and TCP flow
+ * control slows the senders down instead of losing their bytes.
+ *
+ * The serial side is a set of callbacks (ws_hub_serial_t) with a file
+ * descriptor to poll, on the ESP32 a uart_bridge. Only sockets and poll() are
+ * used, so the hub also builds on a PC.
+ */
+
+#ifndef WS_HUB_H
+#define WS_HUB_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "esp_err.h"
+#include "tcp_out.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Most clients a hub can be configured for */
+#define WS_HUB_MAX_CLIENTS          8
+
+/** Bytes moved per read() / recv() */
+#define WS_HUB_CHUNK_SIZE           2048
+
+/* Hub context (opaque) */
+typedef struct ws_hub_t ws_hub_t;
+
+/**
+ * @brief Data handler, called in the polling task
+ *
+ * @param data Bytes received (valid during the call only)
+ * @param len Length in bytes
+ * @param user config.user
+ */
+typedef void (*ws_hub_data_cb_t)(const uint8_t *data, size_t len, void *user);
+
+/* Serial side of the hub, called in the polling task only */
+typedef struct {
+    int wake_fd;                    // Polled for POLLIN: rx_peek() may have data
+    size_t (*rx_peek)(void *ctx, const uint8_t **data);    // Bytes due, in place (0 = none yet)
+    void (*rx_consume)(void *ctx, size_t len);
+    int (*rx_due_ms)(void *ctx);    // Held bytes are due in this many ms, -1 if none held
+    int64_t (*rx_stamp_us)(void *ctx);  // UART read time of the first byte rx_peek() returns (may be NULL)
+    size_t (*tx_space)(void *ctx);
+    size_t (*tx_write)(void *ctx, const uint8_t *data, size_t len);    // Up to tx_space()
+    void *ctx;
+} ws_hub_serial_t;
+
+/* Hub configuration */
+typedef struct {
+    uint16_t port;                  // TCP port to listen on
+    int max_clients;                // Up to WS_HUB_MAX_CLIENTS; more are refused
+    size_t client_queue_size;       // Fan-out queue per client (bytes)
+    uint32_t stall_timeout_ms;      // Drop a client whose queue stays full this long (0 = never)
+    const ws_hub_serial_t *serial;  // Serial side (copied), NULL for none
+    tcp_out_mode_t send_mode;       // How sends to the clients are coalesced
+    latency_hist_t *latency;        // UART -> client latency per send, NULL for none
+    ws_hub_data_cb_t on_client_data;    // Bytes from any client (may be NULL)
+    ws_hub_data_cb_t on_serial_data;    // Bytes from the serial port (may be NULL)
+    void *user;
+} ws_hub_config_t;
+
+/* Hub counters */
+typedef struct {
+    uint32_t clients;               // Connected now
+    uint32_t connections;           // Accepted in total
+    uint32_t refused;               // Turned away (hub full)
+    uint32_t stalled;               // Disconnected for not keeping up
+    uint32_t serial_rx;             // Bytes taken from the serial side
+    uint32_t serial_tx;             // Bytes queued to the serial side
+    uint32_t client_rx;             // Bytes received from clients
+    uint32_t fanout_sent;           // Bytes sent to clients (all of them)
+    uint32_t fanout_sends;          // send() calls that moved them
+    uint32_t fanout_dropped;        // Bytes a client's full queue could not take
+} ws_hub_stats_t;
+
+/**
+ * @brief Create a hub listening on config->port
+ *
+ * The client queues are allocated here, up front (PSRAM first).
+ *
+ * @return Hub, or NULL if the socket or the memory could not be set up
+ */
+ws_hub_t *ws_hub_create(const ws_hub_config_t *config);
+
+/**
+ * @brief Close the clients and the listener (the serial side is left alone)
+ */
+void ws_hub_destroy(ws_hub_t *hub);
+
+/**
+ * @brief Wait up to timeout_ms for socket or serial events and serve them
+ *
+ * @return ESP_OK, ESP_FAIL if poll() failed
+ */
+esp_err_t ws_hub_poll(ws_hub_t *hub, int timeout_ms);
+
+/**
+ * @brief Queue bytes to every client (polling task only)
+ *
+ * @return Clients the bytes were queued to in full
+ */
+int ws_hub_broadcast(ws_hub_t *hub, const void *data, size_t len);
+
+/**
+ * @brief Attach or detach the serial side (polling task only)
+ *
+ * @param serial Serial side (copied), NULL for none
+ */
+void ws_hub_set_serial(ws_hub_t *hub, const ws_hub_serial_t *serial);
+
+/**
+ * @brief Change how sends are coalesced, for the clients connected and to come (polling task only)
+ */
+void ws_hub_set_send_mode(ws_hub_t *hub, tcp_out_mode_t mode);
+
+/**
+ * @brief Get hub counters
+ */
+void ws_hub_get_stats(ws_hub_t *hub, ws_hub_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WS_HUB_H */
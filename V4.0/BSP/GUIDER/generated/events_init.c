@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
 #include "lvgl.h"
 #include "lv_textprogress.h"
 
@@ -25,6 +26,7 @@
 #include "esp_wifi.h"
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_heap_caps.h"
 
 /* FreeRTOS includes for thread-safe timing */
 #include "freertos/FreeRTOS.h"
@@ -60,6 +62,9 @@ LV_FONT_DECLARE(lv_font_ShanHaiZhongXiaYeWuYuW_18)
 /* Oscilloscope integration layer - Real ADC sampling */
 #include "oscilloscope_integration.h"
 #include "oscilloscope_core.h"
+#include "oscilloscope_wavefile.h"
+#include "storage_writer.h"
+#include "oscilloscope_scpi.h"
 
 /* WiFi scan check timer callback - NON-BLOCKING version */
 static void wifi_scan_check_timer_cb(lv_timer_t *timer)
@@ -2222,6 +2227,13 @@ static void scrWirelessSerial_event_handler (lv_event_t *e)
 	{
 		// Update IP display when screen loads
 		wireless_serial_update_ip_on_screen_load();
+
+		// Receive pane: scrollback terminal in place of the textarea
+		if (wireless_serial_attach_receive_view() != ESP_OK) {
+			ESP_LOGW("WS_UI", "Receive terminal unavailable");
+		}
+		ws_hex_receive = lv_obj_has_state(guider_ui.scrWirelessSerial_checkboxHexReceive, LV_STATE_CHECKED);
+		wireless_serial_set_receive_hex(ws_hex_receive);
 		
 		// Start TCP server automatically
 		wireless_serial_start_server();
@@ -2389,6 +2401,8 @@ static void scrWirelessSerial_checkboxHexReceive_event_handler (lv_event_t *e)
 	case LV_EVENT_VALUE_CHANGED:
 	{
 		ws_hex_receive = lv_obj_has_state(guider_ui.scrWirelessSerial_checkboxHexReceive, LV_STATE_CHECKED);
+		// Re-renders the visible page only; the scrollback keeps the raw bytes
+		wireless_serial_set_receive_hex(ws_hex_receive);
 		ESP_LOGI("WS_CONFIG", "Hex-Receive: %s", ws_hex_receive ? "ON" : "OFF");
 		break;
 	}
@@ -2461,11 +2475,115 @@ static void scrWirelessSerial_btnClearReceive_event_handler (lv_event_t *e)
 	switch (code) {
 	case LV_EVENT_CLICKED:
 	{
-		// Clear receive textarea
+		// Clear receive view
 		lv_textarea_set_text(guider_ui.scrWirelessSerial_textareaReceive, "");
+		wireless_serial_clear_receive();
 		ESP_LOGI("WS_UI", "Receive buffer cleared");
 		break;
 	}
+	case LV_EVENT_LONG_PRESSED:
+	{
+		// Find the send box text in the receive scrollback (repeat for older hits)
+		const char *needle = lv_textarea_get_text(guider_ui.scrWirelessSerial_textareaSend);
+		if (needle != NULL && needle[0] != '\0') {
+			bool found = wireless_serial_search_receive(needle);
+			ESP_LOGI("WS_UI", "Search \"%s\": %s", needle, found ? "found" : "not found");
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void scrWirelessSerial_btnLogSD_event_handler (lv_event_t *e)
+{
+	lv_event_code_t code = lv_event_get_code(e);
+	lv_obj_t *btn = lv_event_get_target(e);
+
+	switch (code) {
+	case LV_EVENT_VALUE_CHANGED:
+	{
+		// Log the traffic to SD card while checked (progress shown on the button)
+		if (lv_obj_has_state(btn, LV_STATE_CHECKED)) {
+			esp_err_t ret = wireless_serial_start_log();
+			if (ret != ESP_OK) {
+				lv_obj_clear_state(btn, LV_STATE_CHECKED);
+				wireless_serial_print_receive(ret == ESP_ERR_NOT_FOUND ? "\n[Log] No SD card\n" :
+				                              ret == ESP_ERR_INVALID_STATE ? "\n[Log] Previous log still saving\n" :
+				                              "\n[Log] Failed to start\n");
+			}
+			ESP_LOGI("WS_UI", "SD log start: %s", esp_err_to_name(ret));
+		} else {
+			wireless_serial_stop_log();
+			ESP_LOGI("WS_UI", "SD log stopped");
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+// Frame decoder dropdown event handler - raw stream or one row per decoded frame
+static void scrWirelessSerial_dropdownFrames_event_handler (lv_event_t *e)
+{
+	static const frame_decoder_t *const decoders[] = {
+		NULL, &frame_decoder_line, &frame_decoder_slip, &frame_decoder_cobs, &frame_decoder_modbus_rtu,
+	};
+	lv_event_code_t code = lv_event_get_code(e);
+
+	switch (code) {
+	case LV_EVENT_VALUE_CHANGED:
+	{
+		uint16_t sel = lv_dropdown_get_selected(guider_ui.scrWirelessSerial_dropdownFrames);
+		if (sel < sizeof(decoders) / sizeof(decoders[0])) {
+			wireless_serial_set_frame_decoder(decoders[sel]);
+			wireless_serial_print_receive(sel == 0 ? "\n[Frames] Raw stream\n" : "\n[Frames] One row per frame\n");
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+// Send mode dropdown event handler - how sends to the network are coalesced
+static void scrWirelessSerial_dropdownSendMode_event_handler (lv_event_t *e)
+{
+	static const char *const notes[] = {
+		"\n[Send] Immediate: one segment per write\n",
+		"\n[Send] Coalesced: full segments, at most 2 ms held\n",
+		"\n[Send] Bulk: 4 segments per send, at most 20 ms held\n",
+	};
+	lv_event_code_t code = lv_event_get_code(e);
+
+	switch (code) {
+	case LV_EVENT_VALUE_CHANGED:
+	{
+		uint16_t sel = lv_dropdown_get_selected(guider_ui.scrWirelessSerial_dropdownSendMode);
+		if (sel < sizeof(notes) / sizeof(notes[0])) {
+			wireless_serial_set_send_mode((tcp_out_mode_t)sel);
+			wireless_serial_print_receive(notes[sel]);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+// Latency button event handler - print the UART -> network latency histogram
+static void scrWirelessSerial_btnLatency_event_handler (lv_event_t *e)
+{
+	lv_event_code_t code = lv_event_get_code(e);
+
+	switch (code) {
+	case LV_EVENT_CLICKED:
+	{
+		wireless_serial_print_latency();
+		break;
+	}
 	default:
 		break;
 	}
@@ -2625,6 +2743,8 @@ static void scrWirelessSerial_dropdownATType_event_handler (lv_event_t *e)
 
 		if (at_text != NULL) {
 			lv_textarea_set_text(guider_ui.scrWirelessSerial_textareaReceive, at_text);
+			wireless_serial_clear_receive();
+			wireless_serial_print_receive(at_text);
 			ESP_LOGI("WS_UI", "AT command type changed to: %d", sel);
 		}
 		break;
@@ -2639,6 +2759,9 @@ void events_init_scrWirelessSerial(lv_ui *ui)
 {
 	lv_obj_add_event_cb(ui->scrWirelessSerial, scrWirelessSerial_event_handler, LV_EVENT_ALL, ui);
 	lv_obj_add_event_cb(ui->scrWirelessSerial_btnBack, scrWirelessSerial_btnBack_event_handler, LV_EVENT_ALL, ui);
+	lv_obj_add_event_cb(ui->scrWirelessSerial_dropdownSendMode, scrWirelessSerial_dropdownSendMode_event_handler, LV_EVENT_ALL, ui);
+	lv_obj_add_event_cb(ui->scrWirelessSerial_btnLatency, scrWirelessSerial_btnLatency_event_handler, LV_EVENT_ALL, ui);
+	lv_dropdown_set_selected(ui->scrWirelessSerial_dropdownSendMode, wireless_serial_get_send_mode());  // The screen may have been rebuilt
 	// lv_obj_add_event_cb(ui->scrWirelessSerial_btnConnect, scrWirelessSerial_btnConnect_event_handler, LV_EVENT_ALL, ui);  // Button removed
 	lv_obj_add_event_cb(ui->scrWirelessSerial_dropdownBaudRate, scrWirelessSerial_dropdownBaudRate_event_handler, LV_EVENT_ALL, ui);
 	lv_obj_add_event_cb(ui->scrWirelessSerial_dropdownStopBits, scrWirelessSerial_dropdownStopBits_event_handler, LV_EVENT_ALL, ui);
@@ -2649,7 +2772,9 @@ void events_init_scrWirelessSerial(lv_ui *ui)
 	lv_obj_add_event_cb(ui->scrWirelessSerial_checkboxSendNewLine, scrWirelessSerial_checkboxSendNewLine_event_handler, LV_EVENT_ALL, ui);
 	lv_obj_add_event_cb(ui->scrWirelessSerial_btnClear, scrWirelessSerial_btnClear_event_handler, LV_EVENT_ALL, ui);
 	lv_obj_add_event_cb(ui->scrWirelessSerial_btnClearReceive, scrWirelessSerial_btnClearReceive_event_handler, LV_EVENT_ALL, ui);
+	lv_obj_add_event_cb(ui->scrWirelessSerial_btnLogSD, scrWirelessSerial_btnLogSD_event_handler, LV_EVENT_ALL, ui);
 	lv_obj_add_event_cb(ui->scrWirelessSerial_textareaSend, scrWirelessSerial_textareaSend_event_handler, LV_EVENT_ALL, ui);
+	lv_obj_add_event_cb(ui->scrWirelessSerial_dropdownFrames, scrWirelessSerial_dropdownFrames_event_handler, LV_EVENT_ALL, ui);
 	lv_obj_add_event_cb(ui->scrWirelessSerial_dropdownATType, scrWirelessSerial_dropdownATType_event_handler, LV_EVENT_ALL, ui);
 }
 
@@ -2703,6 +2828,10 @@ static bool osc_running = true;
 static bool osc_fft_enabled = false;
 static bool osc_grid_enabled = true;  // Grid display enabled by default
 static bool osc_export_enabled = false;
+static bool osc_export_busy = false;         // Save queued on the storage writer
+static bool osc_export_ui_active = false;    // Export button exists (writer callbacks may arrive late)
+static lv_timer_t *osc_export_reset_timer = NULL;
+#define OSC_EXPORT_FLUSH_MS     30000   // Longest wait for queued saves when leaving the screen
 
 // FFT display parameters
 static int osc_fft_freq_range_index = 2;  // 0=1kHz, 1=10kHz, 2=25kHz (Nyquist), 3=100kHz, 4=1MHz
@@ -2778,6 +2907,165 @@ static lv_obj_t *osc_preview_mask_left = NULL;   // Left mask (hidden data)
 static lv_obj_t *osc_preview_mask_right = NULL;  // Right mask (hidden data)
 static lv_obj_t *osc_preview_trigger_line = NULL;  // Trigger position indicator
 
+// MATH trace (long-press FFT button to cycle through the presets)
+static lv_chart_series_t *osc_math_series = NULL;
+static float osc_math_buffer[OSC_DISPLAY_WIDTH];
+static int osc_math_preset_index = 0;
+static bool osc_math_long_pressed = false;
+static const char *osc_math_presets[] = {
+	NULL,       // OFF
+	"INV",
+	"DIFF",
+	"INTG",
+	"AVG 16",
+	"ABS",
+	"SQR",
+	"FFT"
+};
+#define OSC_MATH_PRESET_COUNT (sizeof(osc_math_presets) / sizeof(osc_math_presets[0]))
+
+// Input coupling and bandwidth filter (long-press coupling to cycle the presets)
+typedef struct {
+	const char *label;
+	osc_filter_stage_config_t stages[2];
+	uint8_t num_stages;
+} osc_filter_preset_t;
+
+static bool osc_coupling_ac = false;
+static int osc_filter_preset_index = 0;
+static bool osc_filter_long_pressed = false;
+static const osc_filter_preset_t osc_filter_presets[] = {
+	{ NULL, {{0}}, 0 },
+	{ "N50", {{ .type = OSC_FILTER_NOTCH, .cutoff_hz = 50.0f, .q = 10.0f }}, 1 },
+	{ "BW20k", {{ .type = OSC_FILTER_LPF, .cutoff_hz = 20000.0f, .order = 4 }}, 1 },
+	{ "N50+BW", {{ .type = OSC_FILTER_NOTCH, .cutoff_hz = 50.0f, .q = 10.0f },
+	             { .type = OSC_FILTER_LPF, .cutoff_hz = 20000.0f, .order = 4 }}, 2 },
+};
+#define OSC_FILTER_PRESET_COUNT (sizeof(osc_filter_presets) / sizeof(osc_filter_presets[0]))
+
+// Serial decode overlay (long-press AUTO to cycle the UART presets)
+#define OSC_DECODE_BOX_COUNT            16      // Annotation boxes drawn over the trace
+#define OSC_DECODE_TABLE_ROWS           6       // Annotations listed in the table
+#define OSC_DECODE_SAMPLES_PER_FRAME    32768   // Decoder budget per refresh (keeps the UI responsive)
+static lv_obj_t *osc_decode_boxes[OSC_DECODE_BOX_COUNT];
+static lv_obj_t *osc_decode_table = NULL;
+static int osc_decode_preset_index = 0;
+static bool osc_decode_long_pressed = false;
+static const uint32_t osc_decode_baud_presets[] = {
+	0,          // OFF
+	9600,
+	115200
+};
+#define OSC_DECODE_PRESET_COUNT (sizeof(osc_decode_baud_presets) / sizeof(osc_decode_baud_presets[0]))
+
+// Mask test (long-press RUN/STOP to cycle: OFF -> MASK -> MASK+STOP -> MASK from SD)
+#define OSC_MASK_TOL_X_DIV      0.2f    // Horizontal tolerance of a new mask
+#define OSC_MASK_TOL_Y_DIV      0.4f    // Vertical tolerance of a new mask
+static const char *osc_mask_modes[] = { "OFF", "MASK", "MASK+STOP", "MASK SD" };
+#define OSC_MASK_MODE_COUNT (sizeof(osc_mask_modes) / sizeof(osc_mask_modes[0]))
+static int osc_mask_mode = 0;
+static bool osc_mask_long_pressed = false;
+static lv_chart_series_t *osc_mask_upper_series = NULL;
+static lv_chart_series_t *osc_mask_lower_series = NULL;
+static lv_obj_t *osc_mask_status_label = NULL;
+static float osc_mask_upper[OSC_DISPLAY_WIDTH];
+static float osc_mask_lower[OSC_DISPLAY_WIDTH];
+
+// Advanced trigger (long-press trigger mode to cycle; RISE/FALL selects the polarity)
+typedef struct {
+	const char *label;
+	osc_trigger_type_t type;
+	osc_trigger_when_t when;
+	float time_min;
+	float time_max;
+} osc_trigger_preset_t;
+static const osc_trigger_preset_t osc_trigger_presets[] = {
+	{ "AUTO",   OSC_TRIGGER_EDGE,        OSC_TRIGGER_WHEN_LESS,    0.0f,     0.0f },     // Free-running
+	{ "PW<2u",  OSC_TRIGGER_PULSE_WIDTH, OSC_TRIGGER_WHEN_LESS,    0.0f,     2e-6f },
+	{ "PW>1m",  OSC_TRIGGER_PULSE_WIDTH, OSC_TRIGGER_WHEN_GREATER, 1e-3f,    0.0f },
+	{ "RUNT",   OSC_TRIGGER_RUNT,        OSC_TRIGGER_WHEN_LESS,    0.0f,     0.0f },
+	{ "SLOW",   OSC_TRIGGER_SLOPE,       OSC_TRIGGER_WHEN_GREATER, 1e-6f,    0.0f },     // Edges slower than 1us
+	{ "WINDOW", OSC_TRIGGER_WINDOW,      OSC_TRIGGER_WHEN_LESS,    0.0f,     0.0f },
+	{ "T/O",    OSC_TRIGGER_TIMEOUT,     OSC_TRIGGER_WHEN_LESS,    10e-3f,   0.0f },     // No edge for 10ms
+};
+#define OSC_TRIGGER_PRESET_COUNT (sizeof(osc_trigger_presets) / sizeof(osc_trigger_presets[0]))
+static int osc_trigger_preset_index = 0;
+static bool osc_trigger_long_pressed = false;
+
+// Capture search (long-press the cursor button in STOP to mark every event matching the
+// current trigger preset on the preview strip; long-press again to clear)
+#define OSC_SEARCH_TICK_COUNT   64      // Tick marks drawn on the preview strip
+static lv_obj_t *osc_search_ticks[OSC_SEARCH_TICK_COUNT];
+static float osc_search_tick_times[OSC_SEARCH_TICK_COUNT];  // Hit times relative to the trigger
+static uint32_t osc_search_tick_count = 0;
+static lv_obj_t *osc_search_bar = NULL;     // "<  i/N  >" navigation
+static lv_obj_t *osc_search_label = NULL;
+static int32_t osc_search_current = -1;     // Event in view, -1 before the first jump
+static bool osc_search_active = false;
+static bool osc_search_long_pressed = false;
+
+// Reference waveforms (long-press V/div to store the visible trace into the next free
+// slot REF A-D; with all four in use the long press clears them). Slots are saved to
+// the SD card and drawn over the live trace, re-projected to the current scales.
+static const uint32_t osc_ref_colors[OSC_REF_SLOT_COUNT] = { 0xFF6E40, 0x40C4FF, 0xB2FF59, 0xFF80AB };
+static lv_chart_series_t *osc_ref_series[OSC_REF_SLOT_COUNT];
+static lv_obj_t *osc_ref_legend = NULL;
+static int16_t osc_ref_columns[OSC_DISPLAY_WIDTH];
+static bool osc_ref_long_pressed = false;
+
+// Histogram / eye diagram / Bode plot (long-press the time scale to cycle WAVE -> HIST ->
+// EYE -> BODE; tap the eye to step the bit rate, AUTO recovers it from the signal). All
+// are drawn as levels on an 8-bit indexed canvas through the persistence color map.
+// Entering BODE starts a sweep of the registered generator; the result goes to the SD card.
+#define OSC_VIEW_WAVE           0
+#define OSC_VIEW_HIST           1
+#define OSC_VIEW_EYE            2
+#define OSC_VIEW_BODE           3
+#define OSC_VIEW_COUNT          4
+#define OSC_BODE_VIEW_WIDTH     OSC_EYE_WIDTH   // Shares the eye diagram's canvas size
+#define OSC_BODE_VIEW_HEIGHT    OSC_EYE_HEIGHT
+#define OSC_BODE_GAIN_TOP       20.0f           // dB at the top row
+#define OSC_BODE_GAIN_SPAN      80.0f           // dB over the height
+#define OSC_HIST_VIEW_WIDTH     96      // Histogram bars along the right edge of the chart
+#define OSC_ANALYSIS_PIXELS     ((OSC_HIST_VIEW_WIDTH * OSC_GRID_HEIGHT) > (OSC_EYE_WIDTH * OSC_EYE_HEIGHT) ? \
+                                 (OSC_HIST_VIEW_WIDTH * OSC_GRID_HEIGHT) : (OSC_EYE_WIDTH * OSC_EYE_HEIGHT))
+static const uint32_t osc_eye_bit_rates[] = { 0, 1200, 9600, 19200, 57600, 115200 };  // 0 = AUTO
+#define OSC_EYE_RATE_COUNT (sizeof(osc_eye_bit_rates) / sizeof(osc_eye_bit_rates[0]))
+static uint8_t osc_analysis_view = OSC_VIEW_WAVE;
+static int osc_eye_rate_index = 0;
+static lv_obj_t *osc_analysis_canvas = NULL;
+static lv_obj_t *osc_analysis_label = NULL;
+static uint8_t *osc_analysis_buf = NULL;        // Palette + levels, allocated once and kept
+static uint32_t osc_analysis_generation = 0;    // Accumulator generation last drawn
+static float osc_hist_stop_x_offset = 0.0f;     // Window the STOP histogram was binned for
+static int osc_hist_stop_time_index = -1;
+static bool osc_analysis_long_pressed = false;
+static osc_bode_point_t osc_bode_points[OSC_BODE_MAX_POINTS];
+static esp_err_t osc_bode_start_result = ESP_OK;
+static bool osc_bode_saved = false;            // Finished sweep written to the SD card
+
+// Deep memory (long-press X-Pos to cycle OFF -> 1M -> 2M -> 4M -> 8M; a depth starts a
+// deep capture that stops the scope once the record is full). While stopped on a deep
+// record the chart shows its min/max envelope and X-Pos pans across the whole record.
+static const uint32_t osc_deep_depths[] = { 0, 1024u * 1024u, 2048u * 1024u, 4096u * 1024u, 8192u * 1024u };
+static const char *osc_deep_labels[] = { "OFF", "1M", "2M", "4M", "8M" };
+#define OSC_DEEP_DEPTH_COUNT (sizeof(osc_deep_depths) / sizeof(osc_deep_depths[0]))
+static uint8_t osc_deep_index = 0;
+static lv_obj_t *osc_deep_label = NULL;
+static bool osc_deep_shown = false;         // Stopped on a deep record
+static float osc_deep_record_time = 0.0f;   // Length of the shown record (seconds)
+static bool osc_deep_long_pressed = false;
+
+// Streaming recorder (export format REC: click EXPORT to start / stop). The label
+// shows the segment, recorded time, card throughput, backlog and dropped samples.
+static lv_obj_t *osc_rec_label = NULL;
+static bool osc_rec_active = false;         // Button shows the recording
+
+// Single acquisition (SCPI :SINGle): stop once the capture generation moves on
+static bool osc_single_armed = false;
+static uint32_t osc_single_generation = 0;
+static void show_export_result(esp_err_t ret);
+
 // Time scale values in seconds per division (s/div)
 // Larger value = slower sweep = fewer cycles visible
 static const float time_scale_values[] = {
@@ -2864,6 +3152,182 @@ static void format_voltage_offset(char *buffer, size_t size, float voltage_volts
 	}
 }
 
+// X offset range of the preview strip when stopped: one screen each way, or half
+// the record each way on a deep record
+static float get_pan_range(void)
+{
+	if (osc_deep_shown && osc_deep_record_time > 0.0f) {
+		return osc_deep_record_time / 2.0f;
+	}
+	return time_scale_values[osc_time_scale_index] * (float)OSC_GRID_COLS;
+}
+
+// Deep capture progress label; follows the core into STOP when the record is full
+static void update_deep_status(void)
+{
+	osc_deep_status_t status;
+
+	if (g_osc_core == NULL || osc_core_get_deep_status(g_osc_core, &status) != ESP_OK) {
+		memset(&status, 0, sizeof(status));
+	}
+
+	// The record filled up and stopped the core: switch the UI to STOP through the normal path
+	if (osc_running && status.shown && !osc_integration_is_running()) {
+		lv_event_send(guider_ui.scrOscilloscope_btnStartStop, LV_EVENT_CLICKED, NULL);
+	}
+
+	osc_deep_shown = status.shown && !osc_running;
+	osc_deep_record_time = (float)status.length * status.time_per_sample;
+
+	if (!status.recording && !osc_deep_shown) {
+		if (osc_deep_label != NULL) lv_obj_add_flag(osc_deep_label, LV_OBJ_FLAG_HIDDEN);
+		return;
+	}
+
+	if (osc_deep_label == NULL) {
+		osc_deep_label = lv_label_create(guider_ui.scrOscilloscope_contWaveform);
+		lv_obj_set_style_text_font(osc_deep_label, &lv_font_montserrat_14, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_text_color(osc_deep_label, lv_color_hex(0xFFC107), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_color(osc_deep_label, lv_color_hex(0x10202A), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_opa(osc_deep_label, LV_OPA_80, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_radius(osc_deep_label, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_pad_all(osc_deep_label, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_clear_flag(osc_deep_label, LV_OBJ_FLAG_CLICKABLE);
+	}
+
+	char buf[48];
+	if (status.recording) {
+		uint32_t percent = status.depth ? (uint32_t)((uint64_t)status.length * 100u / status.depth) : 0;
+		snprintf(buf, sizeof(buf), "DEEP %s %lu%%", osc_deep_labels[osc_deep_index], (unsigned long)percent);
+	} else {
+		snprintf(buf, sizeof(buf), "DEEP %luK pts", (unsigned long)(status.length / 1024u));
+	}
+	lv_label_set_text(osc_deep_label, buf);
+	lv_obj_align_to(osc_deep_label, guider_ui.scrOscilloscope_chartWaveform, LV_ALIGN_TOP_RIGHT, -4, 4);
+	lv_obj_clear_flag(osc_deep_label, LV_OBJ_FLAG_HIDDEN);
+}
+
+// Recorder gauge; restores the export button once a recording has ended (STOP REC, error)
+static void update_rec_status(void)
+{
+	osc_recorder_status_t status;
+
+	if (g_osc_recorder == NULL) {
+		return;
+	}
+	osc_recorder_get_status(g_osc_recorder, &status);
+
+	// A write error ends the recording; the core still feeds the recorder until told
+	if (status.state == OSC_RECORDER_ERROR && osc_core_is_recording(g_osc_core)) {
+		osc_core_stop_recording(g_osc_core);
+	}
+	if (osc_rec_active && !osc_core_is_recording(g_osc_core)) {
+		osc_rec_active = false;
+		show_export_result(status.last_error);
+	}
+
+	if (status.state == OSC_RECORDER_IDLE && !osc_rec_active) {
+		if (osc_rec_label != NULL) lv_obj_add_flag(osc_rec_label, LV_OBJ_FLAG_HIDDEN);
+		return;
+	}
+
+	if (osc_rec_label == NULL) {
+		osc_rec_label = lv_label_create(guider_ui.scrOscilloscope_contWaveform);
+		lv_obj_set_style_text_font(osc_rec_label, &lv_font_montserrat_14, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_color(osc_rec_label, lv_color_hex(0x10202A), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_opa(osc_rec_label, LV_OPA_80, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_radius(osc_rec_label, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_pad_all(osc_rec_label, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_clear_flag(osc_rec_label, LV_OBJ_FLAG_CLICKABLE);
+	}
+
+	// Red while samples are being lost, the card cannot keep up
+	bool dropping = status.dropped_samples > 0;
+	lv_obj_set_style_text_color(osc_rec_label, lv_color_hex(dropping ? 0xFF5252 : 0x69F0AE), LV_PART_MAIN|LV_STATE_DEFAULT);
+
+	char buf[128];
+	uint32_t secs = (uint32_t)status.seconds;
+	snprintf(buf, sizeof(buf), "%s #%lu %02lu:%02lu:%02lu %.1fMB | %lu/%lu KB/s | Q %lu/%lu (pk %lu) | drop %llu",
+	         status.state == OSC_RECORDER_FINISHING ? "SYNC" : "REC", (unsigned long)status.segment,
+	         (unsigned long)(secs / 3600), (unsigned long)(secs / 60 % 60), (unsigned long)(secs % 60),
+	         status.bytes_written / 1048576.0, (unsigned long)status.recent_kbps, (unsigned long)status.input_kbps,
+	         (unsigned long)status.backlog, (unsigned long)status.pool_blocks, (unsigned long)status.backlog_peak,
+	         (unsigned long long)status.dropped_samples);
+	lv_label_set_text(osc_rec_label, buf);
+	lv_obj_align_to(osc_rec_label, guider_ui.scrOscilloscope_chartWaveform, LV_ALIGN_TOP_MID, 0, 4);
+	lv_obj_clear_flag(osc_rec_label, LV_OBJ_FLAG_HIDDEN);
+}
+
+// Long press on X-Pos: step to the next record depth the pool holds and start a deep
+// capture at it (from RUN; a stopped scope is started first), or cancel it at OFF
+static void cycle_deep_depth(void)
+{
+	osc_deepmem_usage_t usage = {0};
+
+	if (g_osc_core == NULL || g_osc_deep == NULL) {
+		ESP_LOGW("OSC_UI", "Deep memory unavailable");
+		return;
+	}
+	osc_deepmem_get_usage(g_osc_deep, &usage);
+
+	do {
+		osc_deep_index = (osc_deep_index + 1) % OSC_DEEP_DEPTH_COUNT;
+	} while (osc_deep_depths[osc_deep_index] > usage.capacity);
+
+	if (osc_deep_depths[osc_deep_index] == 0) {
+		osc_core_cancel_deep_capture(g_osc_core);
+		ESP_LOGI("OSC_UI", "Deep capture off");
+		return;
+	}
+
+	if (!osc_running) {
+		lv_event_send(guider_ui.scrOscilloscope_btnStartStop, LV_EVENT_CLICKED, NULL);
+	}
+	esp_err_t ret = osc_core_start_deep_capture(g_osc_core, osc_deep_depths[osc_deep_index]);
+	ESP_LOGI("OSC_UI", "Deep capture %s: %s", osc_deep_labels[osc_deep_index], esp_err_to_name(ret));
+}
+
+// Search hits as ticks on the preview strip, using the same offset mapping as the
+// visible-window mask so the window lands on a tick after jumping to it
+static void update_search_marks(void)
+{
+	lv_obj_t *preview_container = guider_ui.scrOscilloscope_sliderWavePos;
+	uint32_t shown = 0;
+
+	if (!osc_running && preview_container != NULL) {
+		lv_coord_t preview_w = lv_obj_get_width(preview_container);
+		lv_coord_t preview_h = lv_obj_get_height(preview_container) - 4;
+		float max_offset = get_pan_range();
+
+		for (; shown < osc_search_tick_count; shown++) {
+			lv_obj_t *tick = osc_search_ticks[shown];
+			if (tick == NULL) {
+				tick = lv_obj_create(preview_container);
+				lv_obj_remove_style_all(tick);
+				lv_obj_set_style_bg_color(tick, lv_color_hex(0xFFC107), LV_PART_MAIN|LV_STATE_DEFAULT);  // Amber
+				lv_obj_set_style_bg_opa(tick, LV_OPA_COVER, LV_PART_MAIN|LV_STATE_DEFAULT);
+				lv_obj_clear_flag(tick, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+				osc_search_ticks[shown] = tick;
+			}
+
+			float normalized = osc_search_tick_times[shown] / max_offset;
+			if (normalized < -1.0f) normalized = -1.0f;
+			if (normalized > 1.0f) normalized = 1.0f;
+			float x = (float)preview_w / 2.0f - normalized * (float)preview_w / 2.0f;
+
+			lv_obj_set_size(tick, 2, preview_h);
+			lv_obj_set_pos(tick, (lv_coord_t)x - 1, 0);
+			lv_obj_clear_flag(tick, LV_OBJ_FLAG_HIDDEN);
+		}
+	}
+
+	for (uint32_t i = shown; i < OSC_SEARCH_TICK_COUNT; i++) {
+		if (osc_search_ticks[i] != NULL) {
+			lv_obj_add_flag(osc_search_ticks[i], LV_OBJ_FLAG_HIDDEN);
+		}
+	}
+}
+
 // Helper function to update waveform preview mask based on X offset
 // 真实示波器行为：
 // - 蓝色遮罩表示不在当前显示窗口的数据（隐藏数据）
@@ -2879,6 +3343,7 @@ static void update_preview_mask(void)
 		if (osc_preview_mask_right != NULL) {
 			lv_obj_add_flag(osc_preview_mask_right, LV_OBJ_FLAG_HIDDEN);
 		}
+		update_search_marks();
 		return;
 	}
 
@@ -2898,7 +3363,7 @@ static void update_preview_mask(void)
 	// X偏移范围：-max_offset 到 +max_offset
 	// 预览区域：0 到 preview_w
 	float time_per_div = time_scale_values[osc_time_scale_index];
-	float max_offset = time_per_div * (float)OSC_GRID_COLS;  // 一个屏幕宽度
+	float max_offset = get_pan_range();  // 一个屏幕宽度（深存储时为半个记录）
 	
 	// 相对偏移（相对于停止时的触发位置）
 	float relative_x_offset = osc_x_offset - osc_frozen_x_offset_at_stop;
@@ -2916,6 +3381,12 @@ static void update_preview_mask(void)
 	
 	// 可见窗口宽度（固定为预览区域的中间部分，例如40%）
 	float visible_width = (float)preview_w * 0.4f;
+	if (osc_deep_shown) {
+		// Deep record: the strip spans the whole record, the window its share of it
+		visible_width = (float)preview_w * time_per_div * (float)OSC_GRID_COLS / (2.0f * max_offset);
+		if (visible_width < 2.0f) visible_width = 2.0f;
+		if (visible_width > (float)preview_w) visible_width = (float)preview_w;
+	}
 	float visible_left = visible_center - visible_width / 2.0f;
 	float visible_right = visible_center + visible_width / 2.0f;
 	
@@ -2943,6 +3414,886 @@ static void update_preview_mask(void)
 		float trigger_pos = (float)preview_w / 2.0f - normalized_offset * (float)preview_w / 2.0f;
 		lv_obj_set_x(osc_preview_trigger_line, (lv_coord_t)trigger_pos);
 	}
+
+	update_search_marks();
+}
+
+// Show coupling and active filter preset, e.g. "AC" or "DC N50"
+static void update_coupling_label(void)
+{
+	if (guider_ui.scrOscilloscope_labelCouplingValue == NULL) return;
+
+	const osc_filter_preset_t *preset = &osc_filter_presets[osc_filter_preset_index];
+	char buf[24];
+	if (preset->label != NULL) {
+		snprintf(buf, sizeof(buf), "%s %s", osc_coupling_ac ? "AC" : "DC", preset->label);
+	} else {
+		snprintf(buf, sizeof(buf), "%s", osc_coupling_ac ? "AC" : "DC");
+	}
+	lv_label_set_text(guider_ui.scrOscilloscope_labelCouplingValue, buf);
+}
+
+// Trigger criteria of the selected preset (also used by capture search)
+// Thresholds follow the current signal: level at mid swing, runt/slope/window bands
+// at fixed fractions of the measured amplitude
+static osc_trigger_config_t build_trigger_config(void)
+{
+	const osc_trigger_preset_t *preset = &osc_trigger_presets[osc_trigger_preset_index];
+
+	float freq_hz, vmax, vmin, vpp, vrms;
+	if (g_osc_core == NULL ||
+	    osc_core_get_measurements(g_osc_core, &freq_hz, &vmax, &vmin, &vpp, &vrms) != ESP_OK || vpp < 0.1f) {
+		vmin = 0.0f;
+		vmax = 3.3f;
+		vpp = 3.3f;
+	}
+
+	osc_trigger_config_t trigger = {
+		.enabled = (osc_trigger_preset_index != 0),
+		.level_voltage = vmin + vpp * 0.5f,
+		.rising_edge = (osc_trigger_mode != 1),
+		.pre_trigger_ratio = 0.5f,
+		.type = preset->type,
+		.hysteresis_voltage = vpp * 0.05f,
+		.when = preset->when,
+		.time_min = preset->time_min,
+		.time_max = preset->time_max,
+	};
+	switch (preset->type) {
+	case OSC_TRIGGER_RUNT:
+		trigger.level_low_voltage = vmin + vpp * 0.2f;
+		trigger.level_voltage = vmin + vpp * 0.8f;
+		break;
+	case OSC_TRIGGER_SLOPE:
+		trigger.level_low_voltage = vmin + vpp * 0.1f;
+		trigger.level_voltage = vmin + vpp * 0.9f;
+		break;
+	case OSC_TRIGGER_WINDOW:
+		trigger.level_low_voltage = vmin - vpp * 0.1f;
+		trigger.level_voltage = vmax + vpp * 0.1f;
+		break;
+	default:
+		break;
+	}
+	return trigger;
+}
+
+// Push the selected trigger preset to the core and show it, e.g. "RISE" or "FALL RUNT"
+static void apply_trigger_preset(void)
+{
+	static const char *trigger_modes[] = {"RISE", "FALL", "EDGE"};
+	const osc_trigger_preset_t *preset = &osc_trigger_presets[osc_trigger_preset_index];
+
+	if (guider_ui.scrOscilloscope_labelTriggerModeValue != NULL) {
+		char buf[24];
+		if (osc_trigger_preset_index != 0) {
+			snprintf(buf, sizeof(buf), "%s %s", trigger_modes[osc_trigger_mode], preset->label);
+		} else {
+			snprintf(buf, sizeof(buf), "%s", trigger_modes[osc_trigger_mode]);
+		}
+		lv_label_set_text(guider_ui.scrOscilloscope_labelTriggerModeValue, buf);
+	}
+
+	if (g_osc_core == NULL) return;
+
+	osc_trigger_config_t trigger = build_trigger_config();
+	esp_err_t ret = osc_core_set_trigger(g_osc_core, &trigger);
+	osc_trigger_voltage = trigger.level_voltage;
+	ESP_LOGI("OSC_TRIGGER", "Trigger: %s %s (%s)", trigger.enabled ? osc_trigger_get_type_str(trigger.type) : "AUTO",
+	         trigger.rising_edge ? "+" : "-", esp_err_to_name(ret));
+}
+
+// Update MATH trace from the core
+// MATH is evaluated only over the visible window and cached per capture generation,
+// so redrawing a stopped record (or panning it) never recomputes the whole record
+static void update_math_series(int num_points, float chart_center, float chart_range, float units_per_volt)
+{
+	lv_obj_t *chart = guider_ui.scrOscilloscope_chartWaveform;
+
+	if (g_osc_core == NULL || !osc_math_is_enabled(g_osc_math)) {
+		if (osc_math_series != NULL) {
+			lv_chart_hide_series(chart, osc_math_series, true);
+		}
+		return;
+	}
+
+	if (osc_math_series == NULL) {
+		osc_math_series = lv_chart_add_series(chart, lv_color_hex(0x00E5FF), LV_CHART_AXIS_PRIMARY_Y);  // Cyan
+		if (osc_math_series == NULL) return;
+	}
+	lv_chart_hide_series(chart, osc_math_series, false);
+
+	// STOP mode: follow horizontal panning of the frozen record
+	if (!osc_running) {
+		osc_core_set_x_offset(g_osc_core, osc_x_offset - osc_frozen_x_offset_at_stop);
+	}
+
+	uint32_t math_count = 0;
+	if (osc_core_get_math_waveform(g_osc_core, g_osc_math, osc_math_buffer, &math_count, NULL) != ESP_OK) {
+		math_count = 0;
+	}
+
+	for (int i = 0; i < num_points; i++) {
+		if ((uint32_t)i >= math_count) {
+			osc_math_series->y_points[i] = LV_CHART_POINT_NONE;
+			continue;
+		}
+
+		float y_float = chart_center + (osc_math_buffer[i] * units_per_volt);
+		int val = (int)(y_float + 0.5f);
+		if (val < 0) val = 0;
+		if (val > (int)chart_range) val = (int)chart_range;
+		osc_math_series->y_points[i] = val;
+	}
+}
+
+static void hide_decode_overlay(void)
+{
+	for (int i = 0; i < OSC_DECODE_BOX_COUNT; i++) {
+		if (osc_decode_boxes[i] != NULL) {
+			lv_obj_add_flag(osc_decode_boxes[i], LV_OBJ_FLAG_HIDDEN);
+		}
+	}
+	if (osc_decode_table != NULL) {
+		lv_obj_add_flag(osc_decode_table, LV_OBJ_FLAG_HIDDEN);
+	}
+}
+
+// Protocol decode runs a bounded slice of the record per refresh, so a 128K
+// capture is annotated over a few frames instead of blocking the UI
+static void update_decode_overlay(int num_points)
+{
+	if (g_osc_core == NULL || !osc_decode_is_enabled(g_osc_decode) || num_points < 2) {
+		hide_decode_overlay();
+		return;
+	}
+
+	// STOP mode: follow horizontal panning of the frozen record
+	if (!osc_running) {
+		osc_core_set_x_offset(g_osc_core, osc_x_offset - osc_frozen_x_offset_at_stop);
+	}
+
+	osc_core_decode_step(g_osc_core, g_osc_decode, OSC_DECODE_SAMPLES_PER_FRAME, NULL);
+
+	uint32_t start_idx = 0;
+	float sample_step = 0.0f;
+	if (osc_core_get_display_window(g_osc_core, &start_idx, &sample_step) != ESP_OK || sample_step <= 0.0f) {
+		hide_decode_overlay();
+		return;
+	}
+
+	uint32_t last_idx = start_idx + (uint32_t)(sample_step * (num_points - 1));
+	osc_decode_annotation_t anns[OSC_DECODE_BOX_COUNT];
+	uint32_t count = 0;
+	osc_decode_get_annotations(g_osc_decode, start_idx, last_idx, anns, OSC_DECODE_BOX_COUNT, &count);
+
+	lv_obj_t *chart = guider_ui.scrOscilloscope_chartWaveform;
+	lv_coord_t chart_x = lv_obj_get_x(chart);
+	lv_coord_t chart_y = lv_obj_get_y(chart);
+	lv_coord_t chart_w = lv_obj_get_width(chart);
+	float px_per_sample = (float)chart_w / ((num_points - 1) * sample_step);
+	char text[16];
+
+	// Labeled boxes spanning each decoded frame
+	for (int i = 0; i < OSC_DECODE_BOX_COUNT; i++) {
+		if (osc_decode_boxes[i] == NULL) {
+			lv_obj_t *box = lv_label_create(guider_ui.scrOscilloscope_contWaveform);
+			lv_label_set_long_mode(box, LV_LABEL_LONG_CLIP);
+			lv_obj_set_style_text_font(box, &lv_font_montserrat_12, LV_PART_MAIN|LV_STATE_DEFAULT);
+			lv_obj_set_style_text_align(box, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN|LV_STATE_DEFAULT);
+			lv_obj_set_style_bg_color(box, lv_color_hex(0x10202A), LV_PART_MAIN|LV_STATE_DEFAULT);
+			lv_obj_set_style_bg_opa(box, LV_OPA_80, LV_PART_MAIN|LV_STATE_DEFAULT);
+			lv_obj_set_style_border_width(box, 1, LV_PART_MAIN|LV_STATE_DEFAULT);
+			lv_obj_set_style_radius(box, 3, LV_PART_MAIN|LV_STATE_DEFAULT);
+			lv_obj_set_style_pad_ver(box, 1, LV_PART_MAIN|LV_STATE_DEFAULT);
+			lv_obj_clear_flag(box, LV_OBJ_FLAG_CLICKABLE);
+			osc_decode_boxes[i] = box;
+		}
+
+		lv_obj_t *box = osc_decode_boxes[i];
+		if ((uint32_t)i >= count) {
+			lv_obj_add_flag(box, LV_OBJ_FLAG_HIDDEN);
+			continue;
+		}
+
+		float x0 = ((float)anns[i].start_sample - (float)start_idx) * px_per_sample;
+		float x1 = ((float)anns[i].end_sample - (float)start_idx) * px_per_sample;
+		if (x0 < 0.0f) x0 = 0.0f;
+		if (x1 > chart_w) x1 = chart_w;
+		lv_coord_t width = (lv_coord_t)(x1 - x0);
+		if (width < 16) width = 16;
+
+		uint32_t color = anns[i].flags ? 0xFF5252 : 0x69F0AE;  // Red on error, green otherwise
+		lv_obj_set_style_border_color(box, lv_color_hex(color), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_text_color(box, lv_color_hex(color), LV_PART_MAIN|LV_STATE_DEFAULT);
+
+		osc_decode_format_annotation(&anns[i], text, sizeof(text));
+		lv_label_set_text(box, text);
+		lv_obj_set_pos(box, chart_x + (lv_coord_t)x0, chart_y + 4);
+		lv_obj_set_width(box, width);
+		lv_obj_clear_flag(box, LV_OBJ_FLAG_HIDDEN);
+	}
+
+	// Table of the frames on screen: time from the left edge and value
+	if (osc_decode_table == NULL) {
+		osc_decode_table = lv_table_create(guider_ui.scrOscilloscope_contWaveform);
+		lv_table_set_col_cnt(osc_decode_table, 2);
+		lv_table_set_col_width(osc_decode_table, 0, 80);
+		lv_table_set_col_width(osc_decode_table, 1, 80);
+		lv_obj_set_style_text_font(osc_decode_table, &lv_font_montserrat_12, LV_PART_ITEMS|LV_STATE_DEFAULT);
+		lv_obj_set_style_text_color(osc_decode_table, lv_color_hex(0xFFFFFF), LV_PART_ITEMS|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_opa(osc_decode_table, LV_OPA_TRANSP, LV_PART_ITEMS|LV_STATE_DEFAULT);
+		lv_obj_set_style_pad_all(osc_decode_table, 2, LV_PART_ITEMS|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_color(osc_decode_table, lv_color_hex(0x10202A), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_opa(osc_decode_table, LV_OPA_80, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_border_width(osc_decode_table, 0, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_clear_flag(osc_decode_table, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+		lv_table_set_cell_value(osc_decode_table, 0, 0, "t");
+		lv_table_set_cell_value(osc_decode_table, 0, 1, "UART");
+	}
+
+	uint32_t rows = (count < OSC_DECODE_TABLE_ROWS) ? count : OSC_DECODE_TABLE_ROWS;
+	float sample_rate = osc_decode_get_sample_rate(g_osc_decode);
+	lv_table_set_row_cnt(osc_decode_table, rows + 1);
+	for (uint32_t r = 0; r < rows; r++) {
+		float t_us = (sample_rate > 0.0f) ?
+		             ((float)anns[r].start_sample - (float)start_idx) * 1e6f / sample_rate : 0.0f;
+		snprintf(text, sizeof(text), "%.0fus", t_us);
+		lv_table_set_cell_value(osc_decode_table, r + 1, 0, text);
+		osc_decode_format_annotation(&anns[r], text, sizeof(text));
+		lv_table_set_cell_value(osc_decode_table, r + 1, 1, text);
+	}
+	lv_obj_align_to(osc_decode_table, chart, LV_ALIGN_BOTTOM_RIGHT, -4, -4);
+	lv_obj_clear_flag(osc_decode_table, LV_OBJ_FLAG_HIDDEN);
+}
+
+static int mask_volts_to_chart(float volts, float chart_center, float chart_range, float units_per_volt)
+{
+	int val = (int)(chart_center + ((volts + osc_y_offset) * units_per_volt) + 0.5f);
+	if (val < 0) val = 0;
+	if (val > (int)chart_range) val = (int)chart_range;
+	return val;
+}
+
+// Draws the mask bounds and pass/fail counters; the check itself runs in the
+// core on every capture. Follows the core into STOP when stop-on-fail fires.
+static void update_mask_overlay(int num_points, float chart_center, float chart_range, float units_per_volt)
+{
+	lv_obj_t *chart = guider_ui.scrOscilloscope_chartWaveform;
+
+	if (!osc_mask_is_enabled(g_osc_mask)) {
+		if (osc_mask_upper_series != NULL) lv_chart_hide_series(chart, osc_mask_upper_series, true);
+		if (osc_mask_lower_series != NULL) lv_chart_hide_series(chart, osc_mask_lower_series, true);
+		if (osc_mask_status_label != NULL) lv_obj_add_flag(osc_mask_status_label, LV_OBJ_FLAG_HIDDEN);
+		return;
+	}
+
+	// Stop-on-fail stopped the core: switch the UI to STOP through the normal path
+	if (osc_running && !osc_integration_is_running()) {
+		lv_event_send(guider_ui.scrOscilloscope_btnStartStop, LV_EVENT_CLICKED, NULL);
+	}
+
+	if (osc_mask_upper_series == NULL) {
+		osc_mask_upper_series = lv_chart_add_series(chart, lv_color_hex(0x803030), LV_CHART_AXIS_PRIMARY_Y);  // Dim red
+		osc_mask_lower_series = lv_chart_add_series(chart, lv_color_hex(0x803030), LV_CHART_AXIS_PRIMARY_Y);
+		if (osc_mask_upper_series == NULL || osc_mask_lower_series == NULL) return;
+	}
+	lv_chart_hide_series(chart, osc_mask_upper_series, false);
+	lv_chart_hide_series(chart, osc_mask_lower_series, false);
+
+	uint16_t columns = 0;
+	osc_mask_get_bounds(g_osc_mask, osc_mask_upper, osc_mask_lower, OSC_DISPLAY_WIDTH, &columns);
+	for (int i = 0; i < num_points; i++) {
+		if ((uint16_t)i >= columns) {
+			osc_mask_upper_series->y_points[i] = LV_CHART_POINT_NONE;
+			osc_mask_lower_series->y_points[i] = LV_CHART_POINT_NONE;
+			continue;
+		}
+		osc_mask_upper_series->y_points[i] = mask_volts_to_chart(osc_mask_upper[i], chart_center, chart_range, units_per_volt);
+		osc_mask_lower_series->y_points[i] = mask_volts_to_chart(osc_mask_lower[i], chart_center, chart_range, units_per_volt);
+	}
+
+	if (osc_mask_status_label == NULL) {
+		osc_mask_status_label = lv_label_create(guider_ui.scrOscilloscope_contWaveform);
+		lv_obj_set_style_text_font(osc_mask_status_label, &lv_font_montserrat_14, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_color(osc_mask_status_label, lv_color_hex(0x10202A), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_opa(osc_mask_status_label, LV_OPA_80, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_radius(osc_mask_status_label, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_pad_all(osc_mask_status_label, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_clear_flag(osc_mask_status_label, LV_OBJ_FLAG_CLICKABLE);
+	}
+
+	osc_mask_stats_t stats;
+	osc_mask_get_stats(g_osc_mask, &stats);
+
+	char buf[96];
+	if (stats.has_failure) {
+		float t = stats.first_fail_time;
+		if (t < 1e-3f) {
+			snprintf(buf, sizeof(buf), "PASS %lu  FAIL %lu  VIOL %lu\n1st #%lu @%.1fus",
+			         stats.passed, stats.failed, stats.violations, stats.first_fail_capture, t * 1e6f);
+		} else {
+			snprintf(buf, sizeof(buf), "PASS %lu  FAIL %lu  VIOL %lu\n1st #%lu @%.2fms",
+			         stats.passed, stats.failed, stats.violations, stats.first_fail_capture, t * 1e3f);
+		}
+	} else {
+		snprintf(buf, sizeof(buf), "PASS %lu  FAIL 0", stats.passed);
+	}
+	lv_label_set_text(osc_mask_status_label, buf);
+	lv_obj_set_style_text_color(osc_mask_status_label, lv_color_hex(stats.failed ? 0xFF5252 : 0x69F0AE),
+	                            LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_align_to(osc_mask_status_label, chart, LV_ALIGN_BOTTOM_LEFT, 4, -4);
+	lv_obj_clear_flag(osc_mask_status_label, LV_OBJ_FLAG_HIDDEN);
+}
+
+// Draws the stored reference slots; the projection to chart columns is cached in the
+// ref module, so an unchanged view only costs a copy into the series
+static void update_ref_overlay(int num_points, float chart_center, float chart_range, float units_per_volt)
+{
+	lv_obj_t *chart = guider_ui.scrOscilloscope_chartWaveform;
+
+	osc_ref_view_t view = {
+		.width = (uint16_t)num_points,
+		.time_per_div = time_scale_values[osc_time_scale_index],
+		.grid_cols = OSC_GRID_COLS,
+		.center_time = osc_running ? 0.0f : (osc_x_offset - osc_frozen_x_offset_at_stop),
+		.units_per_volt = units_per_volt,
+		.zero_units = chart_center + osc_y_offset * units_per_volt,
+		.min_units = 0,
+		.max_units = (int16_t)chart_range,
+	};
+
+	for (uint8_t slot = 0; slot < OSC_REF_SLOT_COUNT; slot++) {
+		if (!osc_ref_is_valid(g_osc_ref, slot)) {
+			if (osc_ref_series[slot] != NULL) lv_chart_hide_series(chart, osc_ref_series[slot], true);
+			continue;
+		}
+
+		bool created = false;
+		if (osc_ref_series[slot] == NULL) {
+			osc_ref_series[slot] = lv_chart_add_series(chart, lv_color_hex(osc_ref_colors[slot]), LV_CHART_AXIS_PRIMARY_Y);
+			if (osc_ref_series[slot] == NULL) continue;
+			created = true;
+		}
+		lv_chart_hide_series(chart, osc_ref_series[slot], false);
+
+		bool changed = false;
+		if (osc_ref_render(g_osc_ref, slot, &view, osc_ref_columns, &changed) != ESP_OK) continue;
+		if (changed || created) {
+			memcpy(osc_ref_series[slot]->y_points, osc_ref_columns, num_points * sizeof(lv_coord_t));
+		}
+	}
+}
+
+// Show "REF A 1ms 1V" per used slot in the slot colors (hidden when all are empty)
+static void update_ref_legend(void)
+{
+	char buf[160];
+	size_t len = 0;
+	buf[0] = '\0';
+
+	for (uint8_t slot = 0; slot < OSC_REF_SLOT_COUNT; slot++) {
+		osc_ref_info_t info;
+		if (osc_ref_get_info(g_osc_ref, slot, &info) != ESP_OK) continue;
+
+		uint32_t t = osc_autoset_pick_scale(time_scale_values, TIME_SCALE_COUNT, info.time_per_div * 0.999f);
+		uint32_t v = osc_autoset_pick_scale(volt_scale_values, VOLT_SCALE_COUNT, info.volts_per_div * 0.999f);
+		len += snprintf(buf + len, sizeof(buf) - len, "%s#%06lX REF %c# %s %s",
+		                len ? "\n" : "", (unsigned long)osc_ref_colors[slot], 'A' + slot,
+		                time_scale_labels[t], volt_scale_labels[v]);
+		if (len >= sizeof(buf)) break;
+	}
+
+	if (len == 0) {
+		if (osc_ref_legend != NULL) lv_obj_add_flag(osc_ref_legend, LV_OBJ_FLAG_HIDDEN);
+		return;
+	}
+
+	if (osc_ref_legend == NULL) {
+		osc_ref_legend = lv_label_create(guider_ui.scrOscilloscope_contWaveform);
+		lv_label_set_recolor(osc_ref_legend, true);
+		lv_obj_set_style_text_font(osc_ref_legend, &lv_font_montserrat_14, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_text_color(osc_ref_legend, lv_color_hex(0xFFFFFF), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_color(osc_ref_legend, lv_color_hex(0x10202A), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_opa(osc_ref_legend, LV_OPA_80, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_radius(osc_ref_legend, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_pad_all(osc_ref_legend, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_clear_flag(osc_ref_legend, LV_OBJ_FLAG_CLICKABLE);
+	}
+	lv_label_set_text(osc_ref_legend, buf);
+	lv_obj_align_to(osc_ref_legend, guider_ui.scrOscilloscope_chartWaveform, LV_ALIGN_TOP_LEFT, 4, 4);
+	lv_obj_clear_flag(osc_ref_legend, LV_OBJ_FLAG_HIDDEN);
+}
+
+// Store the visible trace into the next free slot, or clear all slots when none is free
+static void store_or_clear_refs(void)
+{
+	char path[64];
+	uint8_t slot = 0;
+	while (slot < OSC_REF_SLOT_COUNT && osc_ref_is_valid(g_osc_ref, slot)) slot++;
+
+	if (slot == OSC_REF_SLOT_COUNT) {
+		for (slot = 0; slot < OSC_REF_SLOT_COUNT; slot++) {
+			osc_ref_clear(g_osc_ref, slot);
+			osc_ref_get_default_path(slot, path, sizeof(path));
+			remove(path);
+		}
+		ESP_LOGI("OSC_UI", "Reference slots cleared");
+	} else {
+		// In STOP the stored window follows the panned view
+		if (!osc_running) {
+			osc_core_set_x_offset(g_osc_core, osc_x_offset - osc_frozen_x_offset_at_stop);
+		}
+		esp_err_t ret = osc_core_store_ref(g_osc_core, g_osc_ref, slot);
+		if (ret != ESP_OK) {
+			ESP_LOGW("OSC_UI", "No waveform to store as REF %c", 'A' + slot);
+			return;
+		}
+		osc_ref_get_default_path(slot, path, sizeof(path));
+		if (osc_ref_save(g_osc_ref, slot, path) != ESP_OK) {
+			ESP_LOGW("OSC_UI", "REF %c kept in memory only (SD card not available)", 'A' + slot);
+		}
+	}
+
+	update_ref_legend();
+	if (osc_waveform_timer != NULL) lv_timer_ready(osc_waveform_timer);
+}
+
+// Persistence color map: rare hits in dim blue, through cyan, green and yellow,
+// to red and white for the densest pixels (level 0 is background)
+static lv_color_t persistence_color(uint8_t level)
+{
+	static const struct { uint8_t level; uint32_t rgb; } stops[] = {
+		{ 0, 0x000000 }, { 1, 0x101060 }, { 64, 0x0080FF }, { 112, 0x00E0A0 },
+		{ 160, 0x80FF00 }, { 200, 0xFFE000 }, { 235, 0xFF3000 }, { 255, 0xFFFFFF },
+	};
+	int i = 1;
+	while (i < (int)(sizeof(stops) / sizeof(stops[0])) - 1 && level > stops[i].level) i++;
+	if (level <= stops[i - 1].level) return lv_color_hex(stops[i - 1].rgb);
+
+	int span = stops[i].level - stops[i - 1].level;
+	int t = level - stops[i - 1].level;
+	uint32_t a = stops[i - 1].rgb, b = stops[i].rgb;
+	uint8_t r = ((a >> 16 & 0xFF) * (span - t) + (b >> 16 & 0xFF) * t) / span;
+	uint8_t g = ((a >> 8 & 0xFF) * (span - t) + (b >> 8 & 0xFF) * t) / span;
+	uint8_t bl = ((a & 0xFF) * (span - t) + (b & 0xFF) * t) / span;
+	return lv_color_make(r, g, bl);
+}
+
+// Tap on the eye steps the bit rate (AUTO first)
+static void eye_rate_event_cb(lv_event_t *e)
+{
+	if (lv_event_get_code(e) != LV_EVENT_CLICKED || osc_analysis_view != OSC_VIEW_EYE) return;
+
+	osc_eye_rate_index = (osc_eye_rate_index + 1) % OSC_EYE_RATE_COUNT;
+	uint32_t rate = osc_eye_bit_rates[osc_eye_rate_index];
+	osc_eye_set_bit_period(g_osc_eye, rate ? 1.0f / (float)rate : 0.0f);
+	if (osc_waveform_timer != NULL) lv_timer_ready(osc_waveform_timer);
+}
+
+// Show the selected analysis view: size the canvas for it and enable its accumulator
+static void set_analysis_view(uint8_t view)
+{
+	if (g_osc_hist == NULL || g_osc_eye == NULL) view = OSC_VIEW_WAVE;
+	if (view == OSC_VIEW_BODE && g_osc_bode == NULL) view = OSC_VIEW_WAVE;
+	if (osc_analysis_view == OSC_VIEW_BODE && view != OSC_VIEW_BODE && g_osc_bode != NULL) {
+		osc_bode_cancel(g_osc_bode);
+	}
+	osc_analysis_view = view;
+	osc_hist_set_enabled(g_osc_hist, view == OSC_VIEW_HIST);
+	osc_eye_set_enabled(g_osc_eye, view == OSC_VIEW_EYE);
+	osc_hist_stop_time_index = -1;
+
+	if (view == OSC_VIEW_WAVE) {
+		if (osc_analysis_canvas != NULL) lv_obj_add_flag(osc_analysis_canvas, LV_OBJ_FLAG_HIDDEN);
+		if (osc_analysis_label != NULL) lv_obj_add_flag(osc_analysis_label, LV_OBJ_FLAG_HIDDEN);
+		return;
+	}
+
+	if (osc_analysis_buf == NULL) {
+		osc_analysis_buf = heap_caps_malloc(LV_CANVAS_BUF_SIZE_INDEXED_8BIT(OSC_ANALYSIS_PIXELS, 1), MALLOC_CAP_SPIRAM);
+		if (osc_analysis_buf == NULL) {
+			ESP_LOGE("OSC_UI", "No memory for the analysis view");
+			set_analysis_view(OSC_VIEW_WAVE);
+			return;
+		}
+	}
+
+	lv_obj_t *chart = guider_ui.scrOscilloscope_chartWaveform;
+	bool created = (osc_analysis_canvas == NULL);
+	if (created) {
+		osc_analysis_canvas = lv_canvas_create(guider_ui.scrOscilloscope_contWaveform);
+		lv_obj_add_flag(osc_analysis_canvas, LV_OBJ_FLAG_CLICKABLE);
+		lv_obj_add_event_cb(osc_analysis_canvas, eye_rate_event_cb, LV_EVENT_CLICKED, NULL);
+		lv_obj_set_style_img_opa(osc_analysis_canvas, LV_OPA_90, LV_PART_MAIN|LV_STATE_DEFAULT);
+
+		osc_analysis_label = lv_label_create(guider_ui.scrOscilloscope_contWaveform);
+		lv_obj_set_style_text_font(osc_analysis_label, &lv_font_montserrat_14, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_text_color(osc_analysis_label, lv_color_hex(0xFFFFFF), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_color(osc_analysis_label, lv_color_hex(0x10202A), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_opa(osc_analysis_label, LV_OPA_80, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_radius(osc_analysis_label, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_pad_all(osc_analysis_label, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_clear_flag(osc_analysis_label, LV_OBJ_FLAG_CLICKABLE);
+	}
+
+	// Both views share the buffer; the palette sits in its first 1 KB and survives resizing
+	if (view == OSC_VIEW_HIST) {
+		lv_canvas_set_buffer(osc_analysis_canvas, osc_analysis_buf, OSC_HIST_VIEW_WIDTH, OSC_GRID_HEIGHT, LV_IMG_CF_INDEXED_8BIT);
+		lv_obj_align_to(osc_analysis_canvas, chart, LV_ALIGN_RIGHT_MID, 0, 0);
+	} else if (view == OSC_VIEW_EYE) {
+		lv_canvas_set_buffer(osc_analysis_canvas, osc_analysis_buf, OSC_EYE_WIDTH, OSC_EYE_HEIGHT, LV_IMG_CF_INDEXED_8BIT);
+		lv_obj_align_to(osc_analysis_canvas, chart, LV_ALIGN_TOP_RIGHT, -4, 4);
+	} else {
+		lv_canvas_set_buffer(osc_analysis_canvas, osc_analysis_buf, OSC_BODE_VIEW_WIDTH, OSC_BODE_VIEW_HEIGHT, LV_IMG_CF_INDEXED_8BIT);
+		lv_obj_align_to(osc_analysis_canvas, chart, LV_ALIGN_TOP_RIGHT, -4, 4);
+	}
+	if (created) {
+		for (int i = 0; i < 256; i++) {
+			lv_canvas_set_palette(osc_analysis_canvas, (uint8_t)i, persistence_color((uint8_t)i));
+		}
+	}
+	memset(osc_analysis_buf + LV_CANVAS_BUF_SIZE_INDEXED_8BIT(0, 0), 0, OSC_ANALYSIS_PIXELS);
+	osc_analysis_generation = 0;
+
+	lv_obj_clear_flag(osc_analysis_canvas, LV_OBJ_FLAG_HIDDEN);
+	lv_obj_clear_flag(osc_analysis_label, LV_OBJ_FLAG_HIDDEN);
+	lv_label_set_text(osc_analysis_label, view == OSC_VIEW_HIST ? "HIST" : (view == OSC_VIEW_EYE ? "EYE" : "BODE"));
+	lv_obj_align_to(osc_analysis_label, osc_analysis_canvas, LV_ALIGN_OUT_LEFT_TOP, -4, 0);
+
+	if (view == OSC_VIEW_BODE) {
+		osc_bode_start_result = osc_integration_bode_start();
+		osc_bode_saved = false;
+		if (osc_bode_start_result != ESP_OK) {
+			lv_label_set_text(osc_analysis_label, osc_bode_start_result == ESP_ERR_NOT_SUPPORTED ?
+			                  "BODE\nno generator" : "BODE\nscope stopped");
+			lv_obj_align_to(osc_analysis_label, osc_analysis_canvas, LV_ALIGN_OUT_LEFT_TOP, -4, 0);
+		}
+	}
+}
+
+// Connect two plot points with a column-by-column line
+static void bode_plot_line(uint8_t *levels, int x0, int y0, int x1, int y1, uint8_t level)
+{
+	int prev_y = y0;
+	for (int x = x0; x <= x1; x++) {
+		int y = (x1 > x0) ? y0 + (y1 - y0) * (x - x0) / (x1 - x0) : y1;
+		int lo = LV_MIN(prev_y, y), hi = LV_MAX(prev_y, y);
+		for (int row = LV_MAX(lo, 0); row <= LV_MIN(hi, OSC_BODE_VIEW_HEIGHT - 1); row++) {
+			levels[row * OSC_BODE_VIEW_WIDTH + x] = level;
+		}
+		prev_y = y;
+	}
+}
+
+// Draws the measured points (gain bright, phase dimmer) over decade and 20 dB lines;
+// points without a stimulus phase reference (the single-channel ADC path) have no
+// phase trace and the label says so. A finished sweep is saved once as CSV
+static void update_bode_view(uint8_t *levels)
+{
+	osc_bode_progress_t progress;
+	if (osc_bode_start_result != ESP_OK || osc_bode_get_progress(g_osc_bode, &progress) != ESP_OK) return;
+	if (progress.generation == osc_analysis_generation) return;
+	osc_analysis_generation = progress.generation;
+
+	uint16_t count = 0;
+	osc_bode_get_points(g_osc_bode, osc_bode_points, OSC_BODE_MAX_POINTS, &count);
+
+	osc_bode_config_t config;
+	osc_bode_get_default_config(&config);
+	float log_start = log10f(config.start_hz);
+	float x_scale = (OSC_BODE_VIEW_WIDTH - 1) / (log10f(config.stop_hz) - log_start);
+
+	memset(levels, 0, OSC_BODE_VIEW_WIDTH * OSC_BODE_VIEW_HEIGHT);
+	for (float decade = ceilf(log_start); decade <= log10f(config.stop_hz); decade += 1.0f) {
+		int x = (int)((decade - log_start) * x_scale + 0.5f);
+		for (int row = 0; row < OSC_BODE_VIEW_HEIGHT; row++) levels[row * OSC_BODE_VIEW_WIDTH + x] = 40;
+	}
+	for (float db = OSC_BODE_GAIN_TOP - 20.0f; db > OSC_BODE_GAIN_TOP - OSC_BODE_GAIN_SPAN; db -= 20.0f) {
+		int row = (int)((OSC_BODE_GAIN_TOP - db) * OSC_BODE_VIEW_HEIGHT / OSC_BODE_GAIN_SPAN);
+		memset(levels + row * OSC_BODE_VIEW_WIDTH, 40, OSC_BODE_VIEW_WIDTH);
+	}
+
+	int gain_x = -1, gain_y = 0, phase_x = -1, phase_y = 0;
+	float peak_db = -INFINITY, corner_hz = 0.0f;
+	bool has_phase = false;
+	for (uint16_t i = 0; i < count; i++) {
+		const osc_bode_point_t *p = &osc_bode_points[i];
+		int x = (int)((log10f(p->frequency) - log_start) * x_scale + 0.5f);
+		x = LV_MAX(0, LV_MIN(x, OSC_BODE_VIEW_WIDTH - 1));
+		if (!isnan(p->gain_db)) {
+			int y = (int)((OSC_BODE_GAIN_TOP - p->gain_db) * (OSC_BODE_VIEW_HEIGHT - 1) / OSC_BODE_GAIN_SPAN);
+			y = LV_MAX(-1, LV_MIN(y, OSC_BODE_VIEW_HEIGHT));
+			bode_plot_line(levels, gain_x < 0 ? x : gain_x, gain_x < 0 ? y : gain_y, x, y, 255);
+			gain_x = x;
+			gain_y = y;
+
+			// -3 dB point below the pass-band peak seen so far
+			if (p->gain_db > peak_db) {
+				peak_db = p->gain_db;
+				corner_hz = 0.0f;
+			} else if (corner_hz == 0.0f && p->gain_db < peak_db - 3.0f) {
+				corner_hz = p->frequency;
+			}
+		}
+		if (!isnan(p->phase_deg)) {
+			int y = (int)((180.0f - p->phase_deg) * (OSC_BODE_VIEW_HEIGHT - 1) / 360.0f);
+			bode_plot_line(levels, phase_x < 0 ? x : phase_x, phase_x < 0 ? y : phase_y, x, y, 140);
+			phase_x = x;
+			phase_y = y;
+			has_phase = true;
+		}
+	}
+
+	char buf[128];
+	int len = snprintf(buf, sizeof(buf), "BODE %u/%u  %.1fs\n%s", progress.done, progress.total,
+	                   progress.elapsed_us / 1e6f, has_phase ? "gain + phase" : "gain only\nphase unavailable");
+	if (corner_hz > 0.0f) {
+		snprintf(buf + len, sizeof(buf) - len, "\n-3dB %.0f Hz", corner_hz);
+	}
+
+	if (!progress.running) {
+		if (progress.result != ESP_OK) {
+			len = strlen(buf);
+			snprintf(buf + len, sizeof(buf) - len, "\nended: %s", esp_err_to_name(progress.result));
+		} else if (!osc_bode_saved && osc_export_is_sd_available()) {
+			char path[96];
+			time_t now = time(NULL);
+			struct tm *t = localtime(&now);
+			snprintf(path, sizeof(path), "%s/Bode_%04d%02d%02d_%02d%02d%02d.csv", osc_export_get_dir(),
+			         t ? t->tm_year + 1900 : 0, t ? t->tm_mon + 1 : 0, t ? t->tm_mday : 0,
+			         t ? t->tm_hour : 0, t ? t->tm_min : 0, t ? t->tm_sec : 0);
+			osc_bode_saved = (osc_bode_save_csv(g_osc_bode, path) == ESP_OK);
+			len = strlen(buf);
+			snprintf(buf + len, sizeof(buf) - len, osc_bode_saved ? "\nsaved CSV" : "\nsave failed");
+		}
+	}
+
+	lv_obj_invalidate(osc_analysis_canvas);
+	lv_label_set_text(osc_analysis_label, buf);
+	lv_obj_align_to(osc_analysis_label, osc_analysis_canvas, LV_ALIGN_OUT_LEFT_TOP, -4, 0);
+}
+
+// Keeps the accumulator range on the screen range and redraws the view when it
+// has taken new data; counting itself happens in the core on every capture
+static void update_analysis_view(float chart_center, float chart_range, float units_per_volt)
+{
+	if (osc_analysis_view == OSC_VIEW_WAVE || osc_analysis_canvas == NULL) return;
+
+	if (osc_analysis_view == OSC_VIEW_BODE) {
+		update_bode_view(osc_analysis_buf + LV_CANVAS_BUF_SIZE_INDEXED_8BIT(0, 0));
+		return;
+	}
+
+	float v_min = -chart_center / units_per_volt - osc_y_offset;
+	float v_max = (chart_range - chart_center) / units_per_volt - osc_y_offset;
+	uint8_t *levels = osc_analysis_buf + LV_CANVAS_BUF_SIZE_INDEXED_8BIT(0, 0);
+	char buf[128];
+
+	if (osc_analysis_view == OSC_VIEW_HIST) {
+		uint32_t before = osc_hist_get_generation(g_osc_hist);
+		osc_hist_set_range(g_osc_hist, v_min, v_max);
+
+		// No captures arrive in STOP: re-bin the frozen window whenever it moves
+		if (!osc_running && (osc_hist_get_generation(g_osc_hist) != before ||
+		                     osc_x_offset != osc_hist_stop_x_offset ||
+		                     osc_time_scale_index != osc_hist_stop_time_index)) {
+			osc_core_set_x_offset(g_osc_core, osc_x_offset - osc_frozen_x_offset_at_stop);
+			osc_core_update_histogram(g_osc_core, g_osc_hist);
+			osc_hist_stop_x_offset = osc_x_offset;
+			osc_hist_stop_time_index = osc_time_scale_index;
+		}
+
+		uint32_t generation = osc_hist_get_generation(g_osc_hist);
+		if (generation == osc_analysis_generation) return;
+		osc_analysis_generation = generation;
+		osc_hist_render(g_osc_hist, levels, OSC_HIST_VIEW_WIDTH, OSC_GRID_HEIGHT);
+
+		osc_hist_stats_t stats;
+		if (osc_hist_get_stats(g_osc_hist, &stats) == ESP_OK) {
+			snprintf(buf, sizeof(buf), "HIST  %lu pts\nmean %.3fV\nsigma %.1fmV\npeak %.3fV",
+			         stats.total, stats.mean, stats.sigma * 1e3f, stats.peak);
+		} else {
+			snprintf(buf, sizeof(buf), "HIST\nno samples on screen");
+		}
+	} else {
+		osc_eye_set_range(g_osc_eye, v_min, v_max);
+
+		uint32_t generation = osc_eye_get_generation(g_osc_eye);
+		if (generation == osc_analysis_generation) return;
+		osc_analysis_generation = generation;
+		osc_eye_render(g_osc_eye, levels);
+
+		osc_eye_stats_t stats;
+		osc_eye_get_stats(g_osc_eye, &stats);
+		const char *mode = osc_eye_bit_rates[osc_eye_rate_index] ? "FIXED" : "AUTO";
+		if (stats.captures == 0) {
+			snprintf(buf, sizeof(buf), "EYE %s\nwaiting for edges", mode);
+		} else {
+			snprintf(buf, sizeof(buf), "EYE %s\n%.0f bps\n%lu caps",
+			         mode, 1.0f / stats.bit_period, stats.captures);
+		}
+	}
+
+	lv_obj_invalidate(osc_analysis_canvas);
+	lv_label_set_text(osc_analysis_label, buf);
+	lv_obj_align_to(osc_analysis_label, osc_analysis_canvas, LV_ALIGN_OUT_LEFT_TOP, -4, 0);
+}
+
+// Show "i/N" of the search bar ("+" when the index overflowed)
+static void update_search_label(void)
+{
+	if (osc_search_label == NULL) return;
+
+	char buf[24];
+	uint32_t count = osc_search_get_count(g_osc_search);
+	const char *more = osc_search_is_truncated(g_osc_search) ? "+" : "";
+	if (osc_search_current >= 0) {
+		snprintf(buf, sizeof(buf), "%ld/%lu%s", (long)osc_search_current + 1, count, more);
+	} else {
+		snprintf(buf, sizeof(buf), "-/%lu%s", count, more);
+	}
+	lv_label_set_text(osc_search_label, buf);
+}
+
+// Center the view on the next (direction > 0) or previous search hit, wrapping at the ends
+static void search_jump(int direction)
+{
+	uint32_t count = osc_search_get_count(g_osc_search);
+	if (count == 0 || osc_running || g_osc_core == NULL) return;
+
+	// Step from the hit in view, or from the screen center before the first jump
+	uint32_t reference = 0;
+	if (osc_search_current < 0 ||
+	    osc_search_get_hit(g_osc_search, (uint32_t)osc_search_current, &reference) != ESP_OK) {
+		uint32_t start_idx;
+		float sample_step;
+		osc_core_set_x_offset(g_osc_core, osc_x_offset - osc_frozen_x_offset_at_stop);
+		if (osc_core_get_display_window(g_osc_core, &start_idx, &sample_step) == ESP_OK) {
+			reference = start_idx + (uint32_t)(sample_step * OSC_DISPLAY_WIDTH / 2);
+		}
+	}
+
+	uint32_t index;
+	esp_err_t ret = (direction > 0) ? osc_search_find_next(g_osc_search, reference, &index)
+	                                : osc_search_find_prev(g_osc_search, reference, &index);
+	if (ret != ESP_OK) {
+		index = (direction > 0) ? 0 : count - 1;
+	}
+
+	uint32_t position;
+	float hit_time;
+	if (osc_search_get_hit(g_osc_search, index, &position) != ESP_OK ||
+	    osc_core_get_sample_time(g_osc_core, position, &hit_time) != ESP_OK) {
+		return;
+	}
+
+	osc_search_current = (int32_t)index;
+	osc_x_offset = osc_frozen_x_offset_at_stop + hit_time;
+	osc_core_set_x_offset(g_osc_core, hit_time);
+
+	char offset_str[32];
+	format_time_offset(offset_str, sizeof(offset_str), osc_x_offset, osc_time_scale_index);
+	lv_label_set_text(guider_ui.scrOscilloscope_labelXOffsetValue, offset_str);
+
+	update_search_label();
+	update_preview_mask();
+	if (osc_waveform_timer != NULL) {
+		lv_timer_ready(osc_waveform_timer);
+	}
+}
+
+static void search_nav_event_cb(lv_event_t *e)
+{
+	if (lv_event_get_code(e) != LV_EVENT_CLICKED) return;
+	search_jump((int)(intptr_t)lv_event_get_user_data(e));
+}
+
+// Navigation bar over the top-right corner of the waveform: "<  i/N  >"
+static void show_search_bar(bool show)
+{
+	if (!show) {
+		if (osc_search_bar != NULL) {
+			lv_obj_add_flag(osc_search_bar, LV_OBJ_FLAG_HIDDEN);
+		}
+		return;
+	}
+
+	if (osc_search_bar == NULL) {
+		osc_search_bar = lv_obj_create(guider_ui.scrOscilloscope_contWaveform);
+		lv_obj_set_size(osc_search_bar, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+		lv_obj_set_style_bg_color(osc_search_bar, lv_color_hex(0x10202A), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_bg_opa(osc_search_bar, LV_OPA_80, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_border_width(osc_search_bar, 0, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_radius(osc_search_bar, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_pad_all(osc_search_bar, 2, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_style_pad_column(osc_search_bar, 6, LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_obj_set_flex_flow(osc_search_bar, LV_FLEX_FLOW_ROW);
+		lv_obj_set_flex_align(osc_search_bar, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
+		lv_obj_clear_flag(osc_search_bar, LV_OBJ_FLAG_SCROLLABLE);
+
+		static const char *symbols[] = { LV_SYMBOL_LEFT, LV_SYMBOL_RIGHT };
+		for (int i = 0; i < 2; i++) {
+			lv_obj_t *btn = lv_btn_create(osc_search_bar);
+			lv_obj_set_size(btn, 36, 28);
+			lv_obj_set_style_bg_color(btn, lv_color_hex(0x303030), LV_PART_MAIN|LV_STATE_DEFAULT);
+			lv_obj_t *label = lv_label_create(btn);
+			lv_label_set_text(label, symbols[i]);
+			lv_obj_center(label);
+			lv_obj_add_event_cb(btn, search_nav_event_cb, LV_EVENT_CLICKED, (void *)(intptr_t)(i == 0 ? -1 : 1));
+
+			// Position label between the buttons
+			if (i == 0) {
+				osc_search_label = lv_label_create(osc_search_bar);
+				lv_obj_set_style_text_font(osc_search_label, &lv_font_montserrat_14, LV_PART_MAIN|LV_STATE_DEFAULT);
+				lv_obj_set_style_text_color(osc_search_label, lv_color_hex(0xFFC107), LV_PART_MAIN|LV_STATE_DEFAULT);
+			}
+		}
+		lv_obj_align(osc_search_bar, LV_ALIGN_TOP_RIGHT, -4, 4);
+	}
+
+	update_search_label();
+	lv_obj_clear_flag(osc_search_bar, LV_OBJ_FLAG_HIDDEN);
+}
+
+// Search the stopped record with the current trigger preset (AUTO searches for
+// edges of the selected polarity) and mark the hits
+static void run_search(void)
+{
+	if (g_osc_search == NULL || g_osc_core == NULL) return;
+
+	osc_trigger_config_t criteria = build_trigger_config();
+	esp_err_t ret = osc_core_search(g_osc_core, g_osc_search, &criteria);
+	ESP_LOGI("OSC_SEARCH", "Search %s: %lu events (%s)", osc_trigger_get_type_str(criteria.type),
+	         osc_search_get_count(g_osc_search), esp_err_to_name(ret));
+
+	// Tick times are fixed until the next search; more hits than ticks spreads them over the index
+	uint32_t count = osc_search_get_count(g_osc_search);
+	uint32_t ticks = (count < OSC_SEARCH_TICK_COUNT) ? count : OSC_SEARCH_TICK_COUNT;
+	osc_search_tick_count = 0;
+	for (uint32_t i = 0; ret == ESP_OK && i < ticks; i++) {
+		uint32_t position;
+		if (osc_search_get_hit(g_osc_search, (uint32_t)((uint64_t)i * count / ticks), &position) != ESP_OK ||
+		    osc_core_get_sample_time(g_osc_core, position, &osc_search_tick_times[i]) != ESP_OK) {
+			break;
+		}
+		osc_search_tick_count++;
+	}
+
+	osc_search_current = -1;
+	osc_search_active = (ret == ESP_OK);
+	show_search_bar(osc_search_active);
+	update_search_marks();
+}
+
+static void clear_search(void)
+{
+	osc_search_clear(g_osc_search);
+	osc_search_tick_count = 0;
+	osc_search_current = -1;
+	osc_search_active = false;
+	show_search_bar(false);
+	update_search_marks();
 }
 
 // Waveform update timer callback - Generate dynamic waveform data
@@ -2963,6 +4314,15 @@ static void osc_waveform_update_cb(lv_timer_t *timer)
 	if (timer_call_count <= 5 || timer_call_count % 1000 == 0) {
 		ESP_LOGI("OSC_TIMER", "🔄 Timer callback #%lu executed", timer_call_count);
 	}
+
+	update_deep_status();
+	update_rec_status();
+
+	// Single acquisition: the previous tick drew the new capture, freeze it
+	if (osc_single_armed && osc_running && g_osc_core != NULL &&
+	    osc_core_get_capture_generation(g_osc_core) != osc_single_generation) {
+		lv_event_send(guider_ui.scrOscilloscope_btnStartStop, LV_EVENT_CLICKED, NULL);
+	}
 	
 	// Use hardware-accelerated drawing if available
 	if (osc_use_hw_accel && osc_draw_ctx != NULL) {
@@ -3157,16 +4517,86 @@ static void osc_waveform_update_cb(lv_timer_t *timer)
 		
 		return;
 	}
-	
-	// Fallback to original chart-based rendering
-	lv_chart_series_t *ser = lv_chart_get_series_next(guider_ui.scrOscilloscope_chartWaveform, NULL);
-	if (ser == NULL) return;
-
-	// Chart display parameters - 43x43 pixel grid, 16x9 divisions
-	const int num_points = OSC_GRID_WIDTH;  // 688 data points (WAVEFORM_WIDTH - 4)
-	const float chart_center = 500.0f;      // Y center (0V reference) for 0-1000 range
-	const float chart_range = 1000.0f;      // Full Y range (0-1000)
-	const float display_divisions = (float)OSC_GRID_ROWS;  // 9 vertical divisions
+	
+	// Fallback to original chart-based rendering
+	lv_chart_series_t *ser = lv_chart_get_series_next(guider_ui.scrOscilloscope_chartWaveform, NULL);
+	if (ser == NULL) return;
+
+	// Chart display parameters - 43x43 pixel grid, 16x9 divisions
+	const int num_points = OSC_GRID_WIDTH;  // 688 data points (WAVEFORM_WIDTH - 4)
+	const float chart_center = 500.0f;      // Y center (0V reference) for 0-1000 range
+	const float chart_range = 1000.0f;      // Full Y range (0-1000)
+	const float display_divisions = (float)OSC_GRID_ROWS;  // 9 vertical divisions
+
+	// STOP on a deep record: the core draws the min/max envelope of the visible window
+	// straight from the record summaries, so zoom and pan cover the whole record.
+	// MATH, decode and the analysis views stay on the last screen capture.
+	if (!osc_running && osc_deep_shown) {
+		float volts_per_div = volt_scale_values[osc_volt_scale_index];
+		float units_per_volt = (chart_range / display_divisions) / volts_per_div;
+		float deep_buffer[OSC_DISPLAY_WIDTH];
+		uint32_t deep_count = 0;
+
+		osc_core_set_x_offset(g_osc_core, osc_x_offset - osc_frozen_x_offset_at_stop);
+		if (osc_core_get_display_waveform(g_osc_core, deep_buffer, &deep_count) != ESP_OK) {
+			deep_count = 0;
+		}
+
+		for (int i = 0; i < num_points; i++) {
+			if ((uint32_t)i >= deep_count) {
+				ser->y_points[i] = LV_CHART_POINT_NONE;
+				continue;
+			}
+
+			float y_float = chart_center + ((deep_buffer[i] + osc_y_offset) * units_per_volt);
+			int val = (int)(y_float + 0.5f);
+			if (val < 0) val = 0;
+			if (val > (int)chart_range) val = (int)chart_range;
+			ser->y_points[i] = val;
+		}
+
+		float freq_hz, vmax, vmin, vpp, vrms;
+		char buf[32];
+		if (osc_core_get_measurements(g_osc_core, &freq_hz, &vmax, &vmin, &vpp, &vrms) == ESP_OK) {
+			if (guider_ui.scrOscilloscope_labelFreqTitle != NULL) {
+				if (freq_hz >= 1e6f) {
+					snprintf(buf, sizeof(buf), "Freq: %.2fMHz", freq_hz / 1e6f);
+				} else if (freq_hz >= 1e3f) {
+					snprintf(buf, sizeof(buf), "Freq: %.2fkHz", freq_hz / 1e3f);
+				} else {
+					snprintf(buf, sizeof(buf), "Freq: %.1fHz", freq_hz);
+				}
+				lv_label_set_text(guider_ui.scrOscilloscope_labelFreqTitle, buf);
+			}
+			if (guider_ui.scrOscilloscope_labelVmaxTitle != NULL) {
+				snprintf(buf, sizeof(buf), "Vmax: %.2fV", vmax);
+				lv_label_set_text(guider_ui.scrOscilloscope_labelVmaxTitle, buf);
+			}
+			if (guider_ui.scrOscilloscope_labelVminTitle != NULL) {
+				snprintf(buf, sizeof(buf), "Vmin: %.2fV", vmin);
+				lv_label_set_text(guider_ui.scrOscilloscope_labelVminTitle, buf);
+			}
+			if (guider_ui.scrOscilloscope_labelVppTitle != NULL) {
+				snprintf(buf, sizeof(buf), "Vp-p: %.2fV", vpp);
+				lv_label_set_text(guider_ui.scrOscilloscope_labelVppTitle, buf);
+			}
+			if (guider_ui.scrOscilloscope_labelVrmsTitle != NULL) {
+				snprintf(buf, sizeof(buf), "Vrms: %.2fV", vrms);
+				lv_label_set_text(guider_ui.scrOscilloscope_labelVrmsTitle, buf);
+			}
+		}
+
+		if (osc_math_series != NULL) {
+			lv_chart_hide_series(guider_ui.scrOscilloscope_chartWaveform, osc_math_series, true);
+		}
+		hide_decode_overlay();
+		update_mask_overlay(num_points, chart_center, chart_range, units_per_volt);
+		update_ref_overlay(num_points, chart_center, chart_range, units_per_volt);
+
+		lv_chart_refresh(guider_ui.scrOscilloscope_chartWaveform);
+		update_preview_mask();
+		return;
+	}
 
 	// If not running (STOP mode), display frozen data with current scale settings and offsets
 	// 真实示波器行为：
@@ -3228,6 +4658,12 @@ static void osc_waveform_update_cb(lv_timer_t *timer)
 			ser->y_points[i] = val;
 		}
 
+		update_math_series(num_points, chart_center, chart_range, units_per_volt);
+		update_decode_overlay(num_points);
+		update_mask_overlay(num_points, chart_center, chart_range, units_per_volt);
+		update_ref_overlay(num_points, chart_center, chart_range, units_per_volt);
+		update_analysis_view(chart_center, chart_range, units_per_volt);
+
 		lv_chart_refresh(guider_ui.scrOscilloscope_chartWaveform);
 		
 		// 更新波形预览区域的遮罩
@@ -3727,11 +5163,128 @@ static void osc_waveform_update_cb(lv_timer_t *timer)
 				ser->y_points[i] = (int)chart_center;
 			}
 		}
+
+		update_math_series(num_points, chart_center, chart_range, units_per_volt);
+		update_decode_overlay(num_points);
+		update_mask_overlay(num_points, chart_center, chart_range, units_per_volt);
+		update_ref_overlay(num_points, chart_center, chart_range, units_per_volt);
+		update_analysis_view(chart_center, chart_range, units_per_volt);
 	}
 
 	lv_chart_refresh(guider_ui.scrOscilloscope_chartWaveform);
 }
 
+// SCPI remote control: these run on the LVGL thread (see oscilloscope_scpi.h) and go
+// through the same state as the buttons, so the screen shows what a client set
+
+// Show the scales after a remote change and redraw a stopped waveform
+static void show_remote_scales(void)
+{
+	char offset_str[32];
+	if (!osc_fft_enabled) {
+		lv_label_set_text(guider_ui.scrOscilloscope_labelTimeScaleValue, time_scale_labels[osc_time_scale_index]);
+		lv_label_set_text(guider_ui.scrOscilloscope_labelVoltScaleValue, volt_scale_labels[osc_volt_scale_index]);
+	}
+	format_time_offset(offset_str, sizeof(offset_str), osc_x_offset, osc_time_scale_index);
+	lv_label_set_text(guider_ui.scrOscilloscope_labelXOffsetValue, offset_str);
+	format_voltage_offset(offset_str, sizeof(offset_str), osc_y_offset, osc_volt_scale_index);
+	lv_label_set_text(guider_ui.scrOscilloscope_labelYOffsetValue, offset_str);
+	if (osc_y_baseline_marker != NULL && !lv_obj_has_flag(osc_y_baseline_marker, LV_OBJ_FLAG_HIDDEN)) {
+		lv_label_set_text(osc_y_baseline_marker, offset_str);
+	}
+
+	if (!osc_running && osc_frozen_data_valid) {
+		osc_waveform_update_cb(NULL);
+	}
+}
+
+// Time scale: the smallest UI scale showing the requested one
+static esp_err_t scpi_ui_time_scale(float value, float *result)
+{
+	if (!isnan(value)) {
+		if (!(value > 0.0f)) return ESP_ERR_INVALID_ARG;
+		osc_time_scale_index = osc_autoset_pick_scale(time_scale_values, TIME_SCALE_COUNT, value * 0.999f);
+		show_remote_scales();
+	}
+	*result = time_scale_values[osc_time_scale_index];
+	return ESP_OK;
+}
+
+// Voltage scale: the smallest UI scale showing the requested one
+static esp_err_t scpi_ui_volt_scale(float value, float *result)
+{
+	if (!isnan(value)) {
+		if (!(value > 0.0f)) return ESP_ERR_INVALID_ARG;
+		osc_volt_scale_index = osc_autoset_pick_scale(volt_scale_values, VOLT_SCALE_COUNT, value * 0.999f);
+		show_remote_scales();
+	}
+	*result = volt_scale_values[osc_volt_scale_index];
+	return ESP_OK;
+}
+
+// Trigger level: moves the preset's thresholds together, keeping runt/slope/window bands
+static esp_err_t scpi_ui_trigger_level(float value, float *result)
+{
+	if (!isnan(value)) {
+		if (g_osc_core == NULL) return ESP_ERR_INVALID_STATE;
+		osc_trigger_config_t trigger = build_trigger_config();
+		float delta = value - trigger.level_voltage;
+		trigger.level_voltage = value;
+		trigger.level_low_voltage += delta;
+		esp_err_t ret = osc_core_set_trigger(g_osc_core, &trigger);
+		if (ret != ESP_OK) return ret;
+		osc_trigger_voltage = value;
+	}
+	*result = osc_trigger_voltage;
+	return ESP_OK;
+}
+
+// Trigger slope: RISE / FALL / EDGE, keeping the level in effect
+static esp_err_t scpi_ui_trigger_slope(float value, float *result)
+{
+	if (!isnan(value)) {
+		int mode = (int)value;
+		if (mode < OSC_SCPI_SLOPE_POSITIVE || mode > OSC_SCPI_SLOPE_EITHER) return ESP_ERR_INVALID_ARG;
+		float level = osc_trigger_voltage;
+		osc_trigger_mode = mode;
+		apply_trigger_preset();
+		scpi_ui_trigger_level(level, result);
+	}
+	*result = (float)osc_trigger_mode;
+	return ESP_OK;
+}
+
+// Run / stop / single: same path as the RUN/STOP button
+static esp_err_t scpi_ui_run(float value, float *result)
+{
+	int state = isnan(value) ? -1 : (int)value;
+	if (state == OSC_SCPI_RUN || state == OSC_SCPI_SINGLE) {
+		if (!osc_running) {
+			lv_event_send(guider_ui.scrOscilloscope_btnStartStop, LV_EVENT_CLICKED, NULL);
+		}
+		if (state == OSC_SCPI_SINGLE && g_osc_core != NULL) {
+			osc_single_generation = osc_core_get_capture_generation(g_osc_core);
+			osc_single_armed = true;
+		}
+	} else if (state == OSC_SCPI_STOP) {
+		if (osc_running) {
+			lv_event_send(guider_ui.scrOscilloscope_btnStartStop, LV_EVENT_CLICKED, NULL);
+		}
+	} else if (state != -1) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	*result = osc_running ? (osc_single_armed ? OSC_SCPI_SINGLE : OSC_SCPI_RUN) : OSC_SCPI_STOP;
+	return ESP_OK;
+}
+
+static const osc_scpi_ui_t osc_scpi_ui_ops = {
+	.time_scale = scpi_ui_time_scale,
+	.volt_scale = scpi_ui_volt_scale,
+	.trigger_level = scpi_ui_trigger_level,
+	.trigger_slope = scpi_ui_trigger_slope,
+	.run = scpi_ui_run,
+};
+
 // Screen load event handler
 static void scrOscilloscope_event_handler (lv_event_t *e)
 {
@@ -3751,6 +5304,9 @@ static void scrOscilloscope_event_handler (lv_event_t *e)
 		osc_fft_enabled = false;
 		osc_grid_enabled = true;
 		osc_export_enabled = false;
+		osc_export_busy = false;
+		osc_export_ui_active = true;
+		osc_rec_active = false;
 		osc_waveform_phase = 0;
 		osc_x_offset = 0.0f;
 		osc_y_offset = 0.0f;
@@ -3760,6 +5316,49 @@ static void scrOscilloscope_event_handler (lv_event_t *e)
 		osc_trigger_mode = 0;
 		osc_trigger_active = false;
 		osc_frozen_data_valid = false;
+		osc_math_series = NULL;
+		osc_math_preset_index = 0;
+		osc_math_long_pressed = false;
+		osc_coupling_ac = false;
+		osc_filter_preset_index = 0;
+		osc_filter_long_pressed = false;
+		update_coupling_label();
+		osc_decode_preset_index = 0;
+		osc_decode_long_pressed = false;
+		memset(osc_decode_boxes, 0, sizeof(osc_decode_boxes));
+		osc_decode_table = NULL;
+		osc_mask_mode = 0;
+		osc_mask_long_pressed = false;
+		osc_mask_upper_series = NULL;
+		osc_mask_lower_series = NULL;
+		osc_mask_status_label = NULL;
+		osc_trigger_preset_index = 0;
+		osc_trigger_long_pressed = false;
+		apply_trigger_preset();
+		memset(osc_search_ticks, 0, sizeof(osc_search_ticks));
+		osc_search_tick_count = 0;
+		osc_search_bar = NULL;
+		osc_search_label = NULL;
+		osc_search_current = -1;
+		osc_search_active = false;
+		osc_search_long_pressed = false;
+		memset(osc_ref_series, 0, sizeof(osc_ref_series));
+		osc_ref_legend = NULL;
+		osc_ref_long_pressed = false;
+		update_ref_legend();
+		osc_analysis_canvas = NULL;
+		osc_analysis_label = NULL;
+		osc_analysis_long_pressed = false;
+		osc_eye_rate_index = 0;
+		osc_eye_set_bit_period(g_osc_eye, 0.0f);
+		set_analysis_view(OSC_VIEW_WAVE);
+		osc_deep_index = 0;
+		osc_deep_label = NULL;
+		osc_deep_shown = false;
+		osc_deep_record_time = 0.0f;
+		osc_deep_long_pressed = false;
+		osc_single_armed = false;
+		osc_scpi_set_ui(&osc_scpi_ui_ops);
 
 		// Initialize oscilloscope export module
 		ret = osc_export_init();
@@ -3858,6 +5457,51 @@ static void scrOscilloscope_event_handler (lv_event_t *e)
 		osc_preview_mask_right = NULL;
 		osc_preview_trigger_line = NULL;
 
+		// MATH series belongs to the chart, which LVGL deletes with the screen
+		osc_math_series = NULL;
+
+		// Decode boxes and table are children of the waveform container (deleted by LVGL)
+		memset(osc_decode_boxes, 0, sizeof(osc_decode_boxes));
+		osc_decode_table = NULL;
+
+		// Mask series and status label go with the chart / container as well
+		osc_mask_upper_series = NULL;
+		osc_mask_lower_series = NULL;
+		osc_mask_status_label = NULL;
+
+		// Search ticks live on the preview strip, the bar on the waveform container
+		memset(osc_search_ticks, 0, sizeof(osc_search_ticks));
+		osc_search_tick_count = 0;
+		osc_search_bar = NULL;
+		osc_search_label = NULL;
+		osc_search_active = false;
+
+		// Reference series and legend as well (the slots themselves stay in PSRAM)
+		memset(osc_ref_series, 0, sizeof(osc_ref_series));
+		osc_ref_legend = NULL;
+
+		// Analysis canvas goes with the container; its buffer is kept for the next visit
+		osc_analysis_canvas = NULL;
+		osc_analysis_label = NULL;
+		if (osc_analysis_view == OSC_VIEW_BODE && g_osc_bode != NULL) {
+			osc_bode_cancel(g_osc_bode);
+		}
+		osc_analysis_view = OSC_VIEW_WAVE;
+
+		// A deep capture in progress is dropped; its label goes with the container
+		if (g_osc_core != NULL) {
+			osc_core_cancel_deep_capture(g_osc_core);
+		}
+		osc_deep_label = NULL;
+		osc_deep_shown = false;
+
+		// Writer callbacks must not touch the deleted button
+		osc_export_ui_active = false;
+		if (osc_export_reset_timer != NULL) {
+			lv_timer_del(osc_export_reset_timer);
+			osc_export_reset_timer = NULL;
+		}
+
 		// Deinitialize export module
 		osc_export_deinit();
 		
@@ -3873,6 +5517,14 @@ static void scrOscilloscope_event_handler (lv_event_t *e)
 			lv_obj_clear_flag(guider_ui.scrOscilloscope_chartWaveform, LV_OBJ_FLAG_HIDDEN);
 		}
 		
+		// Queued wavefile saves read the core's record; let them finish first
+		if (storage_writer_flush(OSC_EXPORT_FLUSH_MS) != ESP_OK) {
+			ESP_LOGW("OSC", "Storage writer still busy");
+		}
+
+		// Remote settings need this screen
+		osc_scpi_set_ui(NULL);
+
 		// Deinitialize oscilloscope integration (stop ADC sampling)
 		osc_integration_deinit();
 
@@ -3905,15 +5557,56 @@ static void scrOscilloscope_btnStartStop_event_handler (lv_event_t *e)
 	lv_event_code_t code = lv_event_get_code(e);
 
 	switch (code) {
+	case LV_EVENT_LONG_PRESSED:
+	{
+		// Long press cycles the mask test: OFF -> MASK -> MASK+STOP -> MASK SD
+		osc_mask_long_pressed = true;
+		if (g_osc_mask == NULL || g_osc_core == NULL) break;
+
+		osc_mask_mode = (osc_mask_mode + 1) % OSC_MASK_MODE_COUNT;
+		esp_err_t ret = ESP_OK;
+		if (osc_mask_mode == 1) {
+			// New mask around the trace on screen, also saved for other units
+			float tol_y = OSC_MASK_TOL_Y_DIV * volt_scale_values[osc_volt_scale_index];
+			ret = osc_core_create_mask(g_osc_core, g_osc_mask, OSC_MASK_TOL_X_DIV, tol_y);
+			if (ret == ESP_OK) {
+				osc_mask_save(g_osc_mask, OSC_MASK_DEFAULT_PATH);
+			}
+		} else if (osc_mask_mode == 2) {
+			osc_mask_reset_stats(g_osc_mask);
+		} else if (osc_mask_mode == 3) {
+			ret = osc_mask_load(g_osc_mask, OSC_MASK_DEFAULT_PATH);
+		}
+
+		bool enable = (osc_mask_mode != 0 && ret == ESP_OK);
+		if (!enable) osc_mask_mode = 0;
+		osc_mask_set_enabled(g_osc_mask, enable);
+		osc_core_set_mask(g_osc_core, g_osc_mask, enable && osc_mask_mode == 2);
+		ESP_LOGI("OSC_MASK", "Mask: %s (%s)", osc_mask_modes[osc_mask_mode], esp_err_to_name(ret));
+
+		if (osc_waveform_timer != NULL) {
+			lv_timer_ready(osc_waveform_timer);
+		}
+		break;
+	}
 	case LV_EVENT_CLICKED:
 	{
+		// Release after a long press is not a click
+		if (osc_mask_long_pressed) {
+			osc_mask_long_pressed = false;
+			break;
+		}
+
 		osc_running = !osc_running;
+		osc_single_armed = false;
 		if (osc_running) {
 			// 恢复运行 - 启动ADC采样
 			lv_label_set_text(guider_ui.scrOscilloscope_btnStartStop_label, "RUN");
 			lv_obj_set_style_bg_color(guider_ui.scrOscilloscope_btnStartStop, lv_color_hex(0x00FF00), LV_PART_MAIN|LV_STATE_DEFAULT);
 			// 清除冻结数据标记，重新开始采集
 			osc_frozen_data_valid = false;
+			// Search hits refer to the frozen record
+			clear_search();
 			// 启动真实ADC采样
 			osc_integration_start();
 		} else {
@@ -3965,12 +5658,48 @@ static void scrOscilloscope_btnFFT_event_handler (lv_event_t *e)
 	lv_event_code_t code = lv_event_get_code(e);
 
 	switch (code) {
+	case LV_EVENT_LONG_PRESSED:
+	{
+		// Long press cycles the MATH trace: OFF -> INV -> DIFF -> INTG -> AVG -> ABS -> SQR -> FFT
+		osc_math_long_pressed = true;
+		if (g_osc_math == NULL) break;
+
+		osc_math_preset_index = (osc_math_preset_index + 1) % OSC_MATH_PRESET_COUNT;
+		const char *expr = osc_math_presets[osc_math_preset_index];
+		esp_err_t ret = (expr != NULL) ? osc_math_compile_expr(g_osc_math, expr)
+		                               : osc_math_compile(g_osc_math, NULL, 0);
+		ESP_LOGI("OSC_MATH", "MATH: %s (%s)", expr ? expr : "OFF", esp_err_to_name(ret));
+
+		if (osc_waveform_timer != NULL) {
+			lv_timer_ready(osc_waveform_timer);
+		}
+		break;
+	}
 	case LV_EVENT_CLICKED:
 	{
+		// Release after a long press is not a click
+		if (osc_math_long_pressed) {
+			osc_math_long_pressed = false;
+			break;
+		}
+
 		osc_fft_enabled = !osc_fft_enabled;
 		if (osc_fft_enabled) {
 			// Safety check - ensure UI objects are valid
 			if (!guider_ui.scrOscilloscope_btnFFT || !lv_obj_is_valid(guider_ui.scrOscilloscope_btnFFT)) return;
+
+			// MATH trace, decode and mask overlays are time domain only
+			if (osc_math_series != NULL) {
+				lv_chart_hide_series(guider_ui.scrOscilloscope_chartWaveform, osc_math_series, true);
+			}
+			if (osc_mask_upper_series != NULL) {
+				lv_chart_hide_series(guider_ui.scrOscilloscope_chartWaveform, osc_mask_upper_series, true);
+				lv_chart_hide_series(guider_ui.scrOscilloscope_chartWaveform, osc_mask_lower_series, true);
+			}
+			if (osc_mask_status_label != NULL) {
+				lv_obj_add_flag(osc_mask_status_label, LV_OBJ_FLAG_HIDDEN);
+			}
+			hide_decode_overlay();
 			
 			lv_obj_set_style_bg_color(guider_ui.scrOscilloscope_btnFFT, lv_color_hex(0xFFFF00), LV_PART_MAIN|LV_STATE_DEFAULT);  // Bright yellow when active
 
@@ -4061,6 +5790,81 @@ static void scrOscilloscope_btnFFT_event_handler (lv_event_t *e)
 	}
 }
 
+// Restore the export button (one-shot timer)
+static void export_reset_timer_cb(lv_timer_t *timer)
+{
+	osc_export_reset_timer = NULL;
+	lv_obj_set_style_bg_color(guider_ui.scrOscilloscope_btnExport, lv_color_hex(0xA05000), LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, "EXPORT");
+	osc_export_enabled = false;
+}
+
+// Show the outcome of an export on the button, then restore it
+static void show_export_result(esp_err_t ret)
+{
+	osc_export_busy = false;
+	if (!osc_export_ui_active) {
+		return;
+	}
+
+	if (ret != ESP_OK) {
+		ESP_LOGE("OSC", "Failed to save to SD card: %s", esp_err_to_name(ret));
+		lv_obj_set_style_bg_color(guider_ui.scrOscilloscope_btnExport, lv_color_hex(0xFF0000), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, "FAILED");
+	} else {
+		/* Show success */
+		char status_text[32];
+		uint32_t export_num = osc_export_get_counter();
+		snprintf(status_text, sizeof(status_text), "SAVED #%u", (unsigned int)export_num);
+		lv_obj_set_style_bg_color(guider_ui.scrOscilloscope_btnExport, lv_color_hex(0x00FF00), LV_PART_MAIN|LV_STATE_DEFAULT);
+		lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, status_text);
+		ESP_LOGI("OSC", "Oscilloscope data #%u saved to SD card", (unsigned int)export_num);
+	}
+
+	/* Reset button after delay */
+	if (osc_export_reset_timer != NULL) {
+		lv_timer_del(osc_export_reset_timer);
+	}
+	osc_export_reset_timer = lv_timer_create(export_reset_timer_cb, 2000, NULL);
+	lv_timer_set_repeat_count(osc_export_reset_timer, 1);
+}
+
+// Storage writer progress (LVGL thread)
+static void export_progress_cb(void *user, uint64_t bytes_done, uint64_t bytes_total)
+{
+	if (!osc_export_ui_active) {
+		return;
+	}
+	char text[24];
+	if (bytes_total > 0) {
+		snprintf(text, sizeof(text), "SAVING %u%%", (unsigned int)(bytes_done * 100 / bytes_total));
+	} else {
+		snprintf(text, sizeof(text), "SAVING %uK", (unsigned int)(bytes_done / 1024));
+	}
+	lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, text);
+}
+
+// Storage writer completion of the last file of an export (LVGL thread)
+static void export_done_cb(void *user, esp_err_t result, const char *path)
+{
+	show_export_result(result);
+}
+
+// Binary file written; queue its CSV conversion for BIN+CSV (LVGL thread)
+static void export_bin_done_cb(void *user, esp_err_t result, const char *path)
+{
+	if (result == ESP_OK && (bool)(uintptr_t)user) {
+		result = osc_wavefile_to_csv_async(path, export_done_cb, NULL);
+		if (result == ESP_OK) {
+			if (osc_export_ui_active) {
+				lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, "CSV...");
+			}
+			return;
+		}
+	}
+	show_export_result(result);
+}
+
 // Export button event handler - Export waveform data via USB MSC
 static void scrOscilloscope_btnExport_event_handler (lv_event_t *e)
 {
@@ -4072,11 +5876,11 @@ static void scrOscilloscope_btnExport_event_handler (lv_event_t *e)
 		/* Long press to cycle through export formats */
 		if (!osc_export_enabled) {
 			osc_export_format_t current_format = osc_export_get_format();
-			osc_export_format_t new_format = (current_format + 1) % 3;
+			osc_export_format_t new_format = (current_format + 1) % OSC_EXPORT_FORMAT_COUNT;
 			osc_export_set_format(new_format);
 
 			/* Show format on button */
-			const char *format_names[] = {"TXT", "CSV", "BOTH"};
+			const char *format_names[] = {"TXT", "CSV", "BOTH", "BIN", "BIN+CSV", "REC"};
 			static char format_text[16];
 			snprintf(format_text, sizeof(format_text), "FMT:%s", format_names[new_format]);
 			lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, format_text);
@@ -4089,6 +5893,11 @@ static void scrOscilloscope_btnExport_event_handler (lv_event_t *e)
 	}
 	case LV_EVENT_CLICKED:
 	{
+		/* A save is still being written */
+		if (osc_export_busy) {
+			return;
+		}
+
 		/* First restore button text if it was showing format */
 		const char *current_text = lv_label_get_text(guider_ui.scrOscilloscope_btnExport_label);
 		if (current_text != NULL && strncmp(current_text, "FMT:", 4) == 0) {
@@ -4097,6 +5906,32 @@ static void scrOscilloscope_btnExport_event_handler (lv_event_t *e)
 			return;  /* Don't toggle export on format display click */
 		}
 
+		/* REC streams the acquisition to the card until clicked again */
+		if (osc_export_get_format() == OSC_EXPORT_FORMAT_REC || osc_rec_active) {
+			if (osc_rec_active) {
+				osc_core_stop_recording(g_osc_core);    // Button restored by update_rec_status()
+				break;
+			}
+			char base[OSC_RECORDER_PATH_MAX];
+			esp_err_t ret = (g_osc_core != NULL && g_osc_recorder != NULL) ?
+			                osc_export_reserve_path("", base, sizeof(base)) : ESP_ERR_INVALID_STATE;
+			if (ret == ESP_OK) {
+				ret = osc_core_start_recording(g_osc_core, g_osc_recorder, base);
+			}
+			if (ret != ESP_OK) {
+				show_export_result(ret);
+				break;
+			}
+			osc_rec_active = true;
+			if (osc_export_reset_timer != NULL) {
+				lv_timer_del(osc_export_reset_timer);
+				osc_export_reset_timer = NULL;
+			}
+			lv_obj_set_style_bg_color(guider_ui.scrOscilloscope_btnExport, lv_color_hex(0xFF0000), LV_PART_MAIN|LV_STATE_DEFAULT);
+			lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, "STOP REC");
+			break;
+		}
+
 		osc_export_enabled = !osc_export_enabled;
 		if (osc_export_enabled) {
 			/* Show preparing status */
@@ -4104,6 +5939,30 @@ static void scrOscilloscope_btnExport_event_handler (lv_event_t *e)
 			lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, "PREPARING");
 			lv_refr_now(NULL);
 
+			/* Binary formats save the whole record from the core instead of the chart */
+			osc_export_format_t format = osc_export_get_format();
+			if (format == OSC_EXPORT_FORMAT_BIN || format == OSC_EXPORT_FORMAT_BIN_CSV) {
+				char path[128];
+				char timestamp[32];
+				osc_export_get_timestamp(timestamp, sizeof(timestamp));
+
+				lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, "SAVING...");
+
+				esp_err_t ret = (g_osc_core != NULL) ? osc_export_reserve_path(OSC_WAVEFILE_EXT, path, sizeof(path)) :
+				                                       ESP_ERR_INVALID_STATE;
+				if (ret == ESP_OK) {
+					bool with_csv = (format == OSC_EXPORT_FORMAT_BIN_CSV);
+					ret = osc_core_save_wavefile(g_osc_core, path, timestamp, export_progress_cb,
+					                             export_bin_done_cb, (void *)(uintptr_t)with_csv);
+				}
+				if (ret == ESP_OK) {
+					osc_export_busy = true;
+				} else {
+					show_export_result(ret);
+				}
+				break;
+			}
+
 			/* Prepare waveform data for export - use static to avoid stack overflow */
 			static osc_waveform_data_t waveform_data;
 			memset(&waveform_data, 0, sizeof(waveform_data));
@@ -4213,30 +6072,15 @@ static void scrOscilloscope_btnExport_event_handler (lv_event_t *e)
 					osc_export_store_fft(&fft_data);
 				}
 
-				/* Save directly to SD card */
+				/* Queue on the storage writer; the button shows the result when done */
 				lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, "SAVING...");
-				lv_refr_now(NULL);
 
-				esp_err_t ret = osc_export_save_to_sd();
-				if (ret != ESP_OK) {
-					ESP_LOGE("OSC", "Failed to save to SD card: %s", esp_err_to_name(ret));
-					lv_obj_set_style_bg_color(guider_ui.scrOscilloscope_btnExport, lv_color_hex(0xFF0000), LV_PART_MAIN|LV_STATE_DEFAULT);
-					lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, "FAILED");
+				esp_err_t ret = osc_export_save_to_sd(export_done_cb, NULL);
+				if (ret == ESP_OK) {
+					osc_export_busy = true;
 				} else {
-					/* Show success */
-					char status_text[32];
-					uint32_t export_num = osc_export_get_counter();
-					snprintf(status_text, sizeof(status_text), "SAVED #%u", (unsigned int)export_num);
-					lv_obj_set_style_bg_color(guider_ui.scrOscilloscope_btnExport, lv_color_hex(0x00FF00), LV_PART_MAIN|LV_STATE_DEFAULT);
-					lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, status_text);
-					ESP_LOGI("OSC", "Oscilloscope data #%u saved to SD card", (unsigned int)export_num);
+					show_export_result(ret);
 				}
-				
-				/* Reset button after delay */
-				vTaskDelay(pdMS_TO_TICKS(2000));
-				lv_obj_set_style_bg_color(guider_ui.scrOscilloscope_btnExport, lv_color_hex(0xA05000), LV_PART_MAIN|LV_STATE_DEFAULT);
-				lv_label_set_text(guider_ui.scrOscilloscope_btnExport_label, "EXPORT");
-				osc_export_enabled = false;
 			}
 		} else {
 			/* Just reset button state */
@@ -4265,8 +6109,23 @@ static void scrOscilloscope_contTimeScale_event_handler (lv_event_t *e)
 	lv_event_code_t code = lv_event_get_code(e);
 
 	switch (code) {
+	case LV_EVENT_LONG_PRESSED:
+	{
+		// Long press cycles the analysis view: waveform -> histogram -> eye diagram -> Bode
+		osc_analysis_long_pressed = true;
+		if (osc_fft_enabled) break;
+		set_analysis_view((osc_analysis_view + 1) % OSC_VIEW_COUNT);
+		if (osc_waveform_timer != NULL) lv_timer_ready(osc_waveform_timer);
+		break;
+	}
 	case LV_EVENT_CLICKED:
 	{
+		// Release after a long press is not a click
+		if (osc_analysis_long_pressed) {
+			osc_analysis_long_pressed = false;
+			break;
+		}
+
 		// In FFT mode, adjust frequency range instead of time scale
 		if (osc_fft_enabled) {
 			// Cycle through frequency ranges
@@ -4303,8 +6162,22 @@ static void scrOscilloscope_contVoltScale_event_handler (lv_event_t *e)
 	lv_event_code_t code = lv_event_get_code(e);
 
 	switch (code) {
+	case LV_EVENT_LONG_PRESSED:
+	{
+		// Long press stores the visible trace as a reference (clears all when REF A-D are in use)
+		osc_ref_long_pressed = true;
+		if (osc_fft_enabled) break;
+		store_or_clear_refs();
+		break;
+	}
 	case LV_EVENT_CLICKED:
 	{
+		// Release after a long press is not a click
+		if (osc_ref_long_pressed) {
+			osc_ref_long_pressed = false;
+			break;
+		}
+
 		// In FFT mode, adjust amplitude range instead of voltage scale
 		if (osc_fft_enabled) {
 			// Cycle through amplitude ranges
@@ -4347,15 +6220,33 @@ static void scrOscilloscope_contCoupling_event_handler (lv_event_t *e)
 	lv_event_code_t code = lv_event_get_code(e);
 
 	switch (code) {
+	case LV_EVENT_LONG_PRESSED:
+	{
+		// Long press cycles the bandwidth filter: OFF -> N50 -> LPF 20k -> N50 + LPF 20k
+		osc_filter_long_pressed = true;
+		osc_filter_preset_index = (osc_filter_preset_index + 1) % OSC_FILTER_PRESET_COUNT;
+
+		const osc_filter_preset_t *preset = &osc_filter_presets[osc_filter_preset_index];
+		if (g_osc_core != NULL) {
+			osc_core_set_filter(g_osc_core, preset->stages, preset->num_stages);
+		}
+		update_coupling_label();
+		break;
+	}
 	case LV_EVENT_CLICKED:
 	{
-		// Toggle between DC and AC coupling
-		const char *current = lv_label_get_text(guider_ui.scrOscilloscope_labelCouplingValue);
-		if (strcmp(current, "DC") == 0) {
-			lv_label_set_text(guider_ui.scrOscilloscope_labelCouplingValue, "AC");
-		} else {
-			lv_label_set_text(guider_ui.scrOscilloscope_labelCouplingValue, "DC");
+		// Release after a long press is not a click
+		if (osc_filter_long_pressed) {
+			osc_filter_long_pressed = false;
+			break;
+		}
+
+		// Toggle between DC and AC coupling (AC = DC-block filter in the acquisition path)
+		osc_coupling_ac = !osc_coupling_ac;
+		if (g_osc_core != NULL) {
+			osc_core_set_coupling(g_osc_core, osc_coupling_ac ? OSC_COUPLING_AC : OSC_COUPLING_DC);
 		}
+		update_coupling_label();
 		break;
 	}
 	default:
@@ -4369,12 +6260,25 @@ static void scrOscilloscope_contTriggerMode_event_handler (lv_event_t *e)
 	lv_event_code_t code = lv_event_get_code(e);
 
 	switch (code) {
+	case LV_EVENT_LONG_PRESSED:
+	{
+		// Long press cycles the trigger type: AUTO -> PW<2u -> PW>1m -> RUNT -> SLOW -> WINDOW -> T/O
+		osc_trigger_long_pressed = true;
+		osc_trigger_preset_index = (osc_trigger_preset_index + 1) % OSC_TRIGGER_PRESET_COUNT;
+		apply_trigger_preset();
+		break;
+	}
 	case LV_EVENT_CLICKED:
 	{
+		// Release after a long press is not a click
+		if (osc_trigger_long_pressed) {
+			osc_trigger_long_pressed = false;
+			break;
+		}
+
 		// Cycle through trigger modes: RISE, FALL, EDGE
-		const char *trigger_modes[] = {"RISE", "FALL", "EDGE"};
 		osc_trigger_mode = (osc_trigger_mode + 1) % 3;
-		lv_label_set_text(guider_ui.scrOscilloscope_labelTriggerModeValue, trigger_modes[osc_trigger_mode]);
+		apply_trigger_preset();
 		break;
 	}
 	default:
@@ -4391,8 +6295,28 @@ static void scrOscilloscope_contTrigger_event_handler (lv_event_t *e)
 	lv_obj_t *target = lv_event_get_target(e);
 
 	switch (code) {
+	case LV_EVENT_LONG_PRESSED:
+	{
+		// Long press in STOP searches the frozen record with the current trigger preset,
+		// and clears the search marks the second time
+		osc_search_long_pressed = true;
+		if (osc_running) break;
+
+		if (osc_search_active) {
+			clear_search();
+		} else {
+			run_search();
+		}
+		break;
+	}
 	case LV_EVENT_CLICKED:
 	{
+		// Release after a long press is not a click
+		if (osc_search_long_pressed) {
+			osc_search_long_pressed = false;
+			break;
+		}
+
 		// 循环切换游标模式：关闭 → 横轴 → 纵轴 → 关闭
 		osc_cursor_mode = (osc_cursor_mode + 1) % 3;
 		
@@ -4600,8 +6524,22 @@ static void scrOscilloscope_contXOffset_event_handler (lv_event_t *e)
 	lv_obj_t *target = lv_event_get_target(e);
 
 	switch (code) {
+	case LV_EVENT_LONG_PRESSED:
+	{
+		// Long press steps the deep memory depth (OFF/1M/2M/4M/8M)
+		osc_deep_long_pressed = true;
+		if (osc_fft_enabled) break;
+		cycle_deep_depth();
+		break;
+	}
 	case LV_EVENT_CLICKED:
 	{
+		// Release after a long press is not a click
+		if (osc_deep_long_pressed) {
+			osc_deep_long_pressed = false;
+			break;
+		}
+
 		// Toggle X offset control active state
 		osc_x_offset_active = !osc_x_offset_active;
 
@@ -4833,153 +6771,97 @@ static void scrOscilloscope_btnAuto_event_handler (lv_event_t *e)
 	lv_event_code_t code = lv_event_get_code(e);
 
 	switch (code) {
+	case LV_EVENT_LONG_PRESSED:
+	{
+		// Long press cycles the UART decoder: OFF -> 9600 8N1 -> 115200 8N1
+		osc_decode_long_pressed = true;
+		if (g_osc_decode == NULL || g_osc_core == NULL) break;
+
+		osc_decode_preset_index = (osc_decode_preset_index + 1) % OSC_DECODE_PRESET_COUNT;
+		uint32_t baud = osc_decode_baud_presets[osc_decode_preset_index];
+
+		// Threshold halfway between the logic levels, 10% of the swing as hysteresis
+		float freq_hz, vmax, vmin, vpp, vrms;
+		float threshold = 1.65f;
+		float hysteresis = 0.2f;
+		if (osc_core_get_measurements(g_osc_core, &freq_hz, &vmax, &vmin, &vpp, &vrms) == ESP_OK && vpp > 0.1f) {
+			threshold = (vmax + vmin) * 0.5f;
+			hysteresis = vpp * 0.1f;
+		}
+
+		osc_decode_config_t config = {
+			.protocol = (baud != 0) ? OSC_DECODE_UART : OSC_DECODE_NONE,
+			.threshold_v = threshold,
+			.hysteresis_v = hysteresis,
+			.uart = {
+				.baud_rate = (baud != 0) ? baud : 9600,
+				.data_bits = 8,
+				.parity = OSC_DECODE_PARITY_NONE,
+				.stop_bits = 1,
+				.inverted = false,
+			},
+		};
+		esp_err_t ret = osc_decode_configure(g_osc_decode, &config);
+		ESP_LOGI("OSC_DECODE", "Decode: %s %lu (%s)", osc_decode_get_protocol_str(config.protocol),
+		         baud, esp_err_to_name(ret));
+
+		lv_label_set_text(guider_ui.scrOscilloscope_btnAuto_label, (baud != 0) ? "AUTO*" : "AUTO");
+		if (osc_waveform_timer != NULL) {
+			lv_timer_ready(osc_waveform_timer);
+		}
+		break;
+	}
 	case LV_EVENT_CLICKED:
 	{
+		// Release after a long press is not a click
+		if (osc_decode_long_pressed) {
+			osc_decode_long_pressed = false;
+			break;
+		}
+
 		// Visual feedback - show "AUTO" is running
 		lv_obj_set_style_bg_color(guider_ui.scrOscilloscope_btnAuto, lv_color_hex(0xFFFF00), LV_PART_MAIN|LV_STATE_DEFAULT);
 		lv_label_set_text(guider_ui.scrOscilloscope_btnAuto_label, "WAIT");
 		lv_refr_now(NULL);
 
-		// Analyze current waveform to determine optimal settings
-		lv_chart_series_t *ser = lv_chart_get_series_next(guider_ui.scrOscilloscope_chartWaveform, NULL);
-		if (ser != NULL) {
-			// Chart display parameters
-			const float chart_center = 500.0f;  // Y center in chart units (0-1000 range)
-			const float units_per_division = 100.0f;  // 100 chart units = 1 division
-			const int num_points = OSC_GRID_WIDTH;  // 688 data points
-			const float volt_scale_values[] = {0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0, 2.0, 5.0, 12.0};
-			const char *volt_scales[] = {"10mV", "20mV", "50mV", "100mV", "200mV", "500mV", "1V", "2V", "5V", "12V"};
-			const char *time_scales[] = {"1us", "10us", "20us", "50us", "100us", "200us", "500us", "1ms", "10ms", "100ms", "1s"};
-
-			// Step 1: 分析波形的电压范围
-			float min_voltage = 0.0f, max_voltage = 0.0f;
-			float current_volts_per_div = volt_scale_values[osc_volt_scale_index];
-			float current_units_per_volt = units_per_division / current_volts_per_div;
-			bool first_point = true;
-
-			for(int i = 0; i < num_points; i++) {
-				float voltage = ((float)ser->y_points[i] - chart_center) / current_units_per_volt;
-				
-				if (first_point) {
-					min_voltage = voltage;
-					max_voltage = voltage;
-					first_point = false;
-				}
-				
-				if (voltage < min_voltage) min_voltage = voltage;
-				if (voltage > max_voltage) max_voltage = voltage;
-			}
-
-			// Step 2: 计算信号的峰峰值和中心
-			float vpp = max_voltage - min_voltage;
-			float signal_center = (max_voltage + min_voltage) / 2.0f;
-
-			// Step 3: 选择合适的电压档位
-			// 目标：信号占据屏幕的60-80%（6-8个division）
-			// 改进：使用更激进的策略，让信号更充分地显示
-			int best_volt_idx = 6;  // Default to 1V
-			
-			if (vpp > 0.001f) {  // 有效信号
-				// 计算需要的V/div：让峰峰值占据6-7个division
-				float target_volts_per_div = vpp / 6.5f;
-				
-				// 找到最接近的标准档位（稍大一点）
-				for(int i = 0; i < 10; i++) {
-					if (volt_scale_values[i] >= target_volts_per_div) {
-						best_volt_idx = i;
-						break;
-					}
-				}
-				
-				// 如果信号太小，至少使用10mV档
-				if (best_volt_idx == 6 && vpp < 0.1f) {
-					best_volt_idx = 0;  // 10mV
-				}
-			}
-
-			osc_volt_scale_index = best_volt_idx;
-
-			// Step 4: 计算Y偏移，让信号居中显示
-			// 信号中心应该在屏幕中心（0V）
-			osc_y_offset = -signal_center;
-			
-			// 限制Y偏移范围
-			float max_y_offset = volt_scale_values[best_volt_idx] * 3.0f;
-			if (osc_y_offset > max_y_offset) osc_y_offset = max_y_offset;
-			if (osc_y_offset < -max_y_offset) osc_y_offset = -max_y_offset;
-
-			// Step 5: 分析波形频率，选择合适的时间档位
-			// 改进：使用更鲁棒的频率检测方法
-			int zero_crossings = 0;
-			int last_crossing_pos = -1;
-			int total_period_samples = 0;
-			int period_count = 0;
-			
-			// 计算信号的平均值作为零点参考
-			float avg_y = 0.0f;
-			for(int i = 0; i < num_points; i++) {
-				avg_y += ser->y_points[i];
-			}
-			avg_y /= num_points;
-
-			// 检测过零点
-			for(int i = 1; i < num_points; i++) {
-				if (ser->y_points[i-1] < avg_y && ser->y_points[i] >= avg_y) {
-					zero_crossings++;
-					if (last_crossing_pos >= 0) {
-						total_period_samples += (i - last_crossing_pos);
-						period_count++;
-					}
-					last_crossing_pos = i;
-				}
-			}
-
-			int best_time_idx = 7;  // Default to 1ms
-			
-			if (period_count > 0) {
-				// 计算平均周期（采样点数）
-				float avg_period_samples = (float)total_period_samples / (float)period_count;
-				
-				// 目标：显示2-3个完整周期
-				// 屏幕宽度 = 18个division = 720像素 = num_points采样点
-				// 理想情况：2.5个周期 → 每个周期约 720/2.5 = 288个采样点
-				float cycles_on_screen = (float)num_points / avg_period_samples;
-				
-				// 根据当前显示的周期数调整时间档位
-				if (cycles_on_screen < 1.5f) {
-					// 周期太少，放大时间（减小时基）
-					best_time_idx = (osc_time_scale_index > 0) ? osc_time_scale_index - 1 : 0;
-				} else if (cycles_on_screen > 4.0f) {
-					// 周期太多，缩小时间（增大时基）
-					best_time_idx = (osc_time_scale_index < 10) ? osc_time_scale_index + 1 : 10;
-				} else {
-					// 当前时基合适，保持不变
-					best_time_idx = osc_time_scale_index;
-				}
+		// One burst capture + histogram/autocorrelation analysis sets everything at once
+		osc_auto_result_t result;
+		esp_err_t ret = (g_osc_core != NULL) ? osc_core_auto_adjust(g_osc_core, &result) : ESP_ERR_INVALID_STATE;
+		if (ret == ESP_OK) {
+			// Map the exact wanted scales onto the UI tables
+			if (result.analysis.signal == OSC_AUTOSET_SIGNAL_PERIODIC) {
+				osc_time_scale_index = osc_autoset_pick_scale(time_scale_values, TIME_SCALE_COUNT, result.time_per_div);
 			}
+			osc_volt_scale_index = osc_autoset_pick_scale(volt_scale_values, VOLT_SCALE_COUNT, result.volts_per_div);
+			osc_y_offset = result.y_offset;
+			osc_trigger_voltage = result.trigger_level;
+			osc_x_offset = 0.0f;
 
-			osc_time_scale_index = best_time_idx;
-
-			// Step 6: 更新显示
-			lv_label_set_text(guider_ui.scrOscilloscope_labelTimeScaleValue, time_scales[osc_time_scale_index]);
-			lv_label_set_text(guider_ui.scrOscilloscope_labelVoltScaleValue, volt_scales[osc_volt_scale_index]);
+			lv_label_set_text(guider_ui.scrOscilloscope_labelTimeScaleValue, time_scale_labels[osc_time_scale_index]);
+			lv_label_set_text(guider_ui.scrOscilloscope_labelVoltScaleValue, volt_scale_labels[osc_volt_scale_index]);
 
-			// 更新Y偏移显示
 			char offset_str[32];
 			format_voltage_offset(offset_str, sizeof(offset_str), osc_y_offset, osc_volt_scale_index);
 			lv_label_set_text(guider_ui.scrOscilloscope_labelYOffsetValue, offset_str);
-			
-			// X偏移重置为0
-			osc_x_offset = 0.0f;
-			lv_label_set_text(guider_ui.scrOscilloscope_labelXOffsetValue, "0us");
-		}
+			format_time_offset(offset_str, sizeof(offset_str), osc_x_offset, osc_time_scale_index);
+			lv_label_set_text(guider_ui.scrOscilloscope_labelXOffsetValue, offset_str);
 
-		// Simulate analysis delay
-		vTaskDelay(pdMS_TO_TICKS(300));
+			ESP_LOGI("OSC_AUTO", "AUTO: %s %.1fHz -> %s/div, %s/div, trig %.2fV in %lu us",
+			         osc_autoset_get_signal_str(result.analysis.signal), result.analysis.frequency_hz,
+			         time_scale_labels[osc_time_scale_index], volt_scale_labels[osc_volt_scale_index],
+			         osc_trigger_voltage, result.elapsed_us);
+
+			// In STOP mode, redraw the frozen waveform with the new scales
+			if (!osc_running && osc_frozen_data_valid) {
+				osc_waveform_update_cb(NULL);
+			}
+		} else {
+			ESP_LOGW("OSC_AUTO", "AUTO failed: %s", esp_err_to_name(ret));
+		}
 
 		// Restore button appearance
 		lv_obj_set_style_bg_color(guider_ui.scrOscilloscope_btnAuto, lv_color_hex(0x00FFFF), LV_PART_MAIN|LV_STATE_DEFAULT);
-		lv_label_set_text(guider_ui.scrOscilloscope_btnAuto_label, "AUTO");
+		lv_label_set_text(guider_ui.scrOscilloscope_btnAuto_label, osc_decode_is_enabled(g_osc_decode) ? "AUTO*" : "AUTO");
 
 		break;
 	}
@@ -5035,8 +6917,17 @@ static void scrOscilloscope_contWaveform_event_handler (lv_event_t *e)
 			// 限制偏移范围
 			float max_offset = time_per_div * 10.0f;  // ±10个division
 			float new_offset = osc_x_offset_base + offset_change;
-			if (new_offset > max_offset) new_offset = max_offset;
-			if (new_offset < -max_offset) new_offset = -max_offset;
+			if (osc_deep_shown) {
+				// Deep record: pan across the whole record around the stop position
+				max_offset = get_pan_range();
+				new_offset -= osc_frozen_x_offset_at_stop;
+				if (new_offset > max_offset) new_offset = max_offset;
+				if (new_offset < -max_offset) new_offset = -max_offset;
+				new_offset += osc_frozen_x_offset_at_stop;
+			} else {
+				if (new_offset > max_offset) new_offset = max_offset;
+				if (new_offset < -max_offset) new_offset = -max_offset;
+			}
 			osc_x_offset = new_offset;
 
 			// Update display with appropriate unit based on time scale
@@ -5227,7 +7118,6 @@ static void scrOscilloscope_contWaveform_event_handler (lv_event_t *e)
 }
 
 // Initialize all event handlers for oscilloscope screen
-// Note: Trigger mode selector removed - using auto trigger mode only
 // Note: btnPanZoom (GRID) removed - grid is always visible now
 void events_init_scrOscilloscope(lv_ui *ui)
 {
@@ -5244,5 +7134,5 @@ void events_init_scrOscilloscope(lv_ui *ui)
 	lv_obj_add_event_cb(ui->scrOscilloscope_contYOffset, scrOscilloscope_contYOffset_event_handler, LV_EVENT_ALL, ui);
 	lv_obj_add_event_cb(ui->scrOscilloscope_contTrigger, scrOscilloscope_contTrigger_event_handler, LV_EVENT_ALL, ui);
 	lv_obj_add_event_cb(ui->scrOscilloscope_contCoupling, scrOscilloscope_contCoupling_event_handler, LV_EVENT_ALL, ui);
-	// Trigger mode selector removed - using auto trigger mode (RISE edge) by default
+	lv_obj_add_event_cb(ui->scrOscilloscope_contTriggerMode, scrOscilloscope_contTriggerMode_event_handler, LV_EVENT_ALL, ui);
 }
@@ -285,9 +285,15 @@ typedef struct
 	lv_obj_t *scrWirelessSerial_contClearCard;  // White card container for Send-NewLine and Clear
 	lv_obj_t *scrWirelessSerial_btnClearReceive;
 	lv_obj_t *scrWirelessSerial_btnClearReceive_label;
+	lv_obj_t *scrWirelessSerial_btnLogSD;
+	lv_obj_t *scrWirelessSerial_btnLogSD_label;
+	// Header: send mode selector and latency histogram button
+	lv_obj_t *scrWirelessSerial_dropdownSendMode;
+	lv_obj_t *scrWirelessSerial_btnLatency;
+	lv_obj_t *scrWirelessSerial_btnLatency_label;
 	// AT command type selector container
 	lv_obj_t *scrWirelessSerial_contATSelector;  // White card container for AT type selector
-	lv_obj_t *scrWirelessSerial_labelATType;
+	lv_obj_t *scrWirelessSerial_dropdownFrames;  // Raw stream / frame decoder selector
 	lv_obj_t *scrWirelessSerial_dropdownATType;
 	// Send area container
 	lv_obj_t *scrWirelessSerial_contSendCard;  // White card container for Send textarea and Send button
@@ -474,9 +474,10 @@ void setup_scr_scrOscilloscope(lv_ui *ui)
     int spacing = (panel_height - total_items_height) / (CTRL_ITEM_COUNT - 1);
     
     int y = 0;
-    create_control_item(ui, contRightPanel, &ui->scrOscilloscope_contChannel,
-        &ui->scrOscilloscope_labelChannelTitle, &ui->scrOscilloscope_labelChannelValue,
-        y, "CH", "CHA", COLOR_CTRL_GREEN);
+    // Single input channel: the first item selects the trigger (click = slope, long press = type)
+    create_control_item(ui, contRightPanel, &ui->scrOscilloscope_contTriggerMode,
+        &ui->scrOscilloscope_labelTriggerModeTitle, &ui->scrOscilloscope_labelTriggerModeValue,
+        y, "Trig", "RISE", COLOR_CTRL_GREEN);
     y += CTRL_ITEM_HEIGHT + spacing;
     create_control_item(ui, contRightPanel, &ui->scrOscilloscope_contTimeScale,
         &ui->scrOscilloscope_labelTimeScaleTitle, &ui->scrOscilloscope_labelTimeScaleValue,
@@ -95,6 +95,40 @@ void setup_scr_scrWirelessSerial(lv_ui *ui)
 	lv_obj_set_style_text_opa(ui->scrWirelessSerial_btnBack, 255, LV_PART_MAIN|LV_STATE_DEFAULT);
 	lv_obj_set_style_text_align(ui->scrWirelessSerial_btnBack, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN|LV_STATE_DEFAULT);
 
+	// Send mode dropdown - header, between back button and title: how sends to the network are coalesced
+	ui->scrWirelessSerial_dropdownSendMode = lv_dropdown_create(ui->scrWirelessSerial);
+	lv_dropdown_set_options(ui->scrWirelessSerial_dropdownSendMode, "Immediate\nCoalesced\nBulk");
+	lv_obj_set_pos(ui->scrWirelessSerial_dropdownSendMode, 85, 17);
+	lv_obj_set_size(ui->scrWirelessSerial_dropdownSendMode, 120, 35);
+	lv_obj_set_style_bg_color(ui->scrWirelessSerial_dropdownSendMode, lv_color_hex(0xffffff), LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_border_width(ui->scrWirelessSerial_dropdownSendMode, 1, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_border_color(ui->scrWirelessSerial_dropdownSendMode, lv_color_hex(0xc0c0c0), LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_radius(ui->scrWirelessSerial_dropdownSendMode, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_text_font(ui->scrWirelessSerial_dropdownSendMode, &lv_font_montserratMedium_16, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_dropdown_set_selected(ui->scrWirelessSerial_dropdownSendMode, 0);  // Default to immediate
+
+	// Latency button - prints the UART -> network latency histogram in the receive view
+	ui->scrWirelessSerial_btnLatency = lv_btn_create(ui->scrWirelessSerial);
+	ui->scrWirelessSerial_btnLatency_label = lv_label_create(ui->scrWirelessSerial_btnLatency);
+	lv_label_set_text(ui->scrWirelessSerial_btnLatency_label, "Stats");
+	lv_label_set_long_mode(ui->scrWirelessSerial_btnLatency_label, LV_LABEL_LONG_CLIP);
+	lv_obj_align(ui->scrWirelessSerial_btnLatency_label, LV_ALIGN_CENTER, 0, 0);
+	lv_obj_set_style_pad_all(ui->scrWirelessSerial_btnLatency, 0, LV_STATE_DEFAULT);
+	lv_obj_set_width(ui->scrWirelessSerial_btnLatency_label, LV_PCT(100));
+	lv_obj_set_pos(ui->scrWirelessSerial_btnLatency, 210, 17);
+	lv_obj_set_size(ui->scrWirelessSerial_btnLatency, 60, 35);
+	lv_obj_set_style_bg_opa(ui->scrWirelessSerial_btnLatency, 255, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_bg_color(ui->scrWirelessSerial_btnLatency, lv_color_hex(0xffffff), LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_bg_grad_dir(ui->scrWirelessSerial_btnLatency, LV_GRAD_DIR_NONE, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_border_width(ui->scrWirelessSerial_btnLatency, 1, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_border_color(ui->scrWirelessSerial_btnLatency, lv_color_hex(0xc0c0c0), LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_radius(ui->scrWirelessSerial_btnLatency, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_shadow_width(ui->scrWirelessSerial_btnLatency, 0, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_text_color(ui->scrWirelessSerial_btnLatency, lv_color_hex(0x606060), LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_text_font(ui->scrWirelessSerial_btnLatency, &lv_font_montserratMedium_16, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_text_opa(ui->scrWirelessSerial_btnLatency, 255, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_text_align(ui->scrWirelessSerial_btnLatency, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN|LV_STATE_DEFAULT);
+
 	//Write codes scrWirelessSerial_textareaReceive (Left white card - Receive area)
 	ui->scrWirelessSerial_textareaReceive = lv_textarea_create(ui->scrWirelessSerial);
 	lv_textarea_set_text(ui->scrWirelessSerial_textareaReceive,
@@ -285,7 +319,7 @@ void setup_scr_scrWirelessSerial(lv_ui *ui)
 	lv_obj_set_style_pad_all(ui->scrWirelessSerial_btnClearReceive, 0, LV_STATE_DEFAULT);
 	lv_obj_set_width(ui->scrWirelessSerial_btnClearReceive_label, LV_PCT(100));
 	lv_obj_set_pos(ui->scrWirelessSerial_btnClearReceive, 5, 40);  // Below checkbox
-	lv_obj_set_size(ui->scrWirelessSerial_btnClearReceive, 150, 35);  // Full width
+	lv_obj_set_size(ui->scrWirelessSerial_btnClearReceive, 72, 35);  // Left half, Log SD beside it
 	lv_obj_set_style_bg_opa(ui->scrWirelessSerial_btnClearReceive, 255, LV_PART_MAIN|LV_STATE_DEFAULT);
 	lv_obj_set_style_bg_color(ui->scrWirelessSerial_btnClearReceive, lv_color_hex(0xe8ecf0), LV_PART_MAIN|LV_STATE_DEFAULT);  // Light gray background
 	lv_obj_set_style_bg_grad_dir(ui->scrWirelessSerial_btnClearReceive, LV_GRAD_DIR_NONE, LV_PART_MAIN|LV_STATE_DEFAULT);
@@ -297,6 +331,30 @@ void setup_scr_scrWirelessSerial(lv_ui *ui)
 	lv_obj_set_style_text_opa(ui->scrWirelessSerial_btnClearReceive, 255, LV_PART_MAIN|LV_STATE_DEFAULT);
 	lv_obj_set_style_text_align(ui->scrWirelessSerial_btnClearReceive, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN|LV_STATE_DEFAULT);
 
+	// Log SD button - bottom right, checked while the traffic is logged to the card
+	ui->scrWirelessSerial_btnLogSD = lv_btn_create(ui->scrWirelessSerial_contClearCard);
+	ui->scrWirelessSerial_btnLogSD_label = lv_label_create(ui->scrWirelessSerial_btnLogSD);
+	lv_label_set_text(ui->scrWirelessSerial_btnLogSD_label, "Log SD");
+	lv_label_set_long_mode(ui->scrWirelessSerial_btnLogSD_label, LV_LABEL_LONG_CLIP);
+	lv_obj_align(ui->scrWirelessSerial_btnLogSD_label, LV_ALIGN_CENTER, 0, 0);
+	lv_obj_set_style_pad_all(ui->scrWirelessSerial_btnLogSD, 0, LV_STATE_DEFAULT);
+	lv_obj_set_width(ui->scrWirelessSerial_btnLogSD_label, LV_PCT(100));
+	lv_obj_add_flag(ui->scrWirelessSerial_btnLogSD, LV_OBJ_FLAG_CHECKABLE);
+	lv_obj_set_pos(ui->scrWirelessSerial_btnLogSD, 83, 40);
+	lv_obj_set_size(ui->scrWirelessSerial_btnLogSD, 72, 35);
+	lv_obj_set_style_bg_opa(ui->scrWirelessSerial_btnLogSD, 255, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_bg_color(ui->scrWirelessSerial_btnLogSD, lv_color_hex(0xe8ecf0), LV_PART_MAIN|LV_STATE_DEFAULT);  // Light gray background
+	lv_obj_set_style_bg_color(ui->scrWirelessSerial_btnLogSD, lv_color_hex(0xE53935), LV_PART_MAIN|LV_STATE_CHECKED);  // Red while logging
+	lv_obj_set_style_bg_grad_dir(ui->scrWirelessSerial_btnLogSD, LV_GRAD_DIR_NONE, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_border_width(ui->scrWirelessSerial_btnLogSD, 0, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_radius(ui->scrWirelessSerial_btnLogSD, 8, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_shadow_width(ui->scrWirelessSerial_btnLogSD, 0, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_text_color(ui->scrWirelessSerial_btnLogSD, lv_color_hex(0x606060), LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_text_color(ui->scrWirelessSerial_btnLogSD, lv_color_hex(0xffffff), LV_PART_MAIN|LV_STATE_CHECKED);
+	lv_obj_set_style_text_font(ui->scrWirelessSerial_btnLogSD, &lv_font_montserratMedium_16, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_text_opa(ui->scrWirelessSerial_btnLogSD, 255, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_text_align(ui->scrWirelessSerial_btnLogSD, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN|LV_STATE_DEFAULT);
+
 	// Right white card container for AT command type selector (right side of clear card)
 	ui->scrWirelessSerial_contATSelector = lv_obj_create(ui->scrWirelessSerial);
 	lv_obj_set_pos(ui->scrWirelessSerial_contATSelector, 605, 310);  // Right side of clear card (415+180+10)
@@ -315,17 +373,21 @@ void setup_scr_scrWirelessSerial(lv_ui *ui)
 	lv_obj_set_style_pad_right(ui->scrWirelessSerial_contATSelector, 10, LV_PART_MAIN|LV_STATE_DEFAULT);
 	lv_obj_set_style_shadow_width(ui->scrWirelessSerial_contATSelector, 0, LV_PART_MAIN|LV_STATE_DEFAULT);
 
-	// Label for AT command selector
-	ui->scrWirelessSerial_labelATType = lv_label_create(ui->scrWirelessSerial_contATSelector);
-	lv_label_set_text(ui->scrWirelessSerial_labelATType, "AT Type");
-	lv_obj_set_pos(ui->scrWirelessSerial_labelATType, 5, 8);
-	lv_obj_set_size(ui->scrWirelessSerial_labelATType, 150, 25);
-	lv_obj_set_style_text_color(ui->scrWirelessSerial_labelATType, lv_color_hex(0x404040), LV_PART_MAIN|LV_STATE_DEFAULT);
-	lv_obj_set_style_text_font(ui->scrWirelessSerial_labelATType, &lv_font_montserratMedium_16, LV_PART_MAIN|LV_STATE_DEFAULT);
+	// Dropdown for the receive view: raw stream or decoded frames (shows frames/s while decoding)
+	ui->scrWirelessSerial_dropdownFrames = lv_dropdown_create(ui->scrWirelessSerial_contATSelector);
+	lv_dropdown_set_options(ui->scrWirelessSerial_dropdownFrames, "Raw stream\nLine frames\nSLIP frames\nCOBS frames\nModbus RTU");
+	lv_obj_set_pos(ui->scrWirelessSerial_dropdownFrames, 5, 0);
+	lv_obj_set_size(ui->scrWirelessSerial_dropdownFrames, 150, 35);
+	lv_obj_set_style_bg_color(ui->scrWirelessSerial_dropdownFrames, lv_color_hex(0xffffff), LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_border_width(ui->scrWirelessSerial_dropdownFrames, 1, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_border_color(ui->scrWirelessSerial_dropdownFrames, lv_color_hex(0xc0c0c0), LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_radius(ui->scrWirelessSerial_dropdownFrames, 4, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_obj_set_style_text_font(ui->scrWirelessSerial_dropdownFrames, &lv_font_montserratMedium_16, LV_PART_MAIN|LV_STATE_DEFAULT);
+	lv_dropdown_set_selected(ui->scrWirelessSerial_dropdownFrames, 0);  // Default to the raw stream
 
 	// Dropdown for AT command type selection
 	ui->scrWirelessSerial_dropdownATType = lv_dropdown_create(ui->scrWirelessSerial_contATSelector);
-	lv_dropdown_set_options(ui->scrWirelessSerial_dropdownATType, "Basic\nWi-Fi\nTCP/IP\nMQTT\nHTTP\nUser");
+	lv_dropdown_set_options(ui->scrWirelessSerial_dropdownATType, "AT: Basic\nAT: Wi-Fi\nAT: TCP/IP\nAT: MQTT\nAT: HTTP\nAT: User");
 	lv_obj_set_pos(ui->scrWirelessSerial_dropdownATType, 5, 40);
 	lv_obj_set_size(ui->scrWirelessSerial_dropdownATType, 150, 35);
 	lv_obj_set_style_bg_color(ui->scrWirelessSerial_dropdownATType, lv_color_hex(0xffffff), LV_PART_MAIN|LV_STATE_DEFAULT);
@@ -16,6 +16,7 @@
 #include "boot_animation.h"
 #include "screenshot_storage.h"
 #include "screenshot.h"
+#include "storage_writer.h"
 
 /* Time synchronization via OneNet cloud platform */
 #include <time.h>
@@ -122,6 +123,14 @@ void app_main(void)
     screenshot_init();
     ESP_LOGI(TAG, "Screenshot gesture detection initialized");
 
+    /* Background SD writer for exports (its drain timer needs the LVGL lock) */
+    bsp_display_lock(0);
+    esp_err_t writer_ret = storage_writer_init(0);
+    bsp_display_unlock();
+    if (writer_ret != ESP_OK) {
+        ESP_LOGW(TAG, "Storage writer init failed: %s", esp_err_to_name(writer_ret));
+    }
+
     /* Setup main UI in background while boot logo is showing */
     bsp_display_lock(0);
     setup_ui(&guider_ui);
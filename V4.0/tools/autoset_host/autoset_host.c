@@ -0,0 +1,262 @@
+/**
+ * @file autoset_host.c
+ * @brief AUTO set-up analysis on the host: classification tests and timing
+ *
+ * Runs the device's oscilloscope_autoset.c unchanged (portable dot product
+ * in place of esp-dsp). Each case builds a burst the way AUTO takes it
+ * (16384 samples at the 1 MSa/s or 100 kSa/s burst rate) from a sine,
+ * square, narrow pulse, DC level or noise, adds Gaussian noise and
+ * quantizes it like the 12-bit ADC (0..3.3 V). osc_autoset_analyze() must
+ * classify it and recover frequency, top/base, extremes and duty cycle;
+ * a few full-scale spikes must not move the extremes. Every case is run
+ * 20 times with a different phase and noise.
+ *
+ * The analysis time of every case is printed; it is the part of AUTO's
+ * budget spent after the bursts.
+ *
+ *   ./autoset_host                 # tests, exit status 1 on failure
+ */
+
+#include "oscilloscope_autoset.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BURST_POINTS    16384           // OSC_AUTO_BURST_POINTS
+#define ADC_FULL_SCALE  3.3f
+#define ADC_CODES       4095.0f
+#define SIGNAL_ROUNDS   20
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        g_failures++; \
+        printf("  FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+static uint32_t g_seed = 12345;
+
+static uint32_t rnd(void)
+{
+    g_seed = g_seed * 1103515245u + 12345u;
+    return g_seed >> 8;
+}
+
+/* Standard normal sample (Box-Muller) */
+static double gauss(void)
+{
+    double u1 = (rnd() + 1.0) / 16777217.0;
+    double u2 = rnd() / 16777216.0;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* ==================== Signals ==================== */
+
+typedef enum {
+    SHAPE_SINE,
+    SHAPE_SQUARE,       // duty cycle from the case
+    SHAPE_DC,
+    SHAPE_NOISE,        // Gaussian, sigma = amplitude
+} shape_t;
+
+typedef struct {
+    const char *name;
+    shape_t shape;
+    double freq_hz;
+    double rate_hz;
+    double low;             // Base level (DC level, noise mean)
+    double high;            // Top level (unused for DC / noise)
+    double duty;
+    double noise;           // Gaussian noise sigma added to every sample
+    osc_autoset_signal_t expect;
+} signal_case_t;
+
+static float g_burst[BURST_POINTS];
+
+static float quantize(double v)
+{
+    double code = floor(v / ADC_FULL_SCALE * ADC_CODES + 0.5);
+    if (code < 0.0) code = 0.0;
+    if (code > ADC_CODES) code = ADC_CODES;
+    return (float)(code * ADC_FULL_SCALE / ADC_CODES);
+}
+
+static void generate(const signal_case_t *c, float *out, uint32_t n)
+{
+    // Random phase, so the burst does not start on an edge
+    double phase0 = (rnd() % 1000) / 1000.0;
+    for (uint32_t i = 0; i < n; i++) {
+        double cycle = phase0 + c->freq_hz * i / c->rate_hz;
+        cycle -= floor(cycle);
+        double v;
+        switch (c->shape) {
+        case SHAPE_SINE:
+            v = (c->low + c->high) / 2.0 + (c->high - c->low) / 2.0 * sin(2.0 * M_PI * cycle);
+            break;
+        case SHAPE_SQUARE:
+            v = cycle < c->duty ? c->high : c->low;
+            break;
+        case SHAPE_NOISE:
+            v = c->low + c->high * gauss();
+            break;
+        default:
+            v = c->low;
+            break;
+        }
+        out[i] = quantize(v + c->noise * gauss());
+    }
+}
+
+/* ==================== Tests ==================== */
+
+static const signal_case_t s_cases[] = {
+    /* name              shape         f       rate     low   high  duty  noise   expect */
+    { "sine 1k",        SHAPE_SINE,   1000,   1e6,    0.65, 2.65, 0.0,  0.005, OSC_AUTOSET_SIGNAL_PERIODIC },
+    { "sine 100k",      SHAPE_SINE,   100000, 1e6,    1.40, 1.90, 0.0,  0.002, OSC_AUTOSET_SIGNAL_PERIODIC },
+    { "sine 50 (slow)", SHAPE_SINE,   50,     1e5,    1.00, 2.30, 0.0,  0.005, OSC_AUTOSET_SIGNAL_PERIODIC },
+    { "sine 20 (slow)", SHAPE_SINE,   20,     1e5,    0.20, 3.10, 0.0,  0.005, OSC_AUTOSET_SIGNAL_PERIODIC },
+    { "sine noisy",     SHAPE_SINE,   3300,   1e6,    1.20, 2.10, 0.0,  0.100, OSC_AUTOSET_SIGNAL_PERIODIC },
+    { "square 1k",      SHAPE_SQUARE, 1000,   1e6,    0.30, 3.00, 0.5,  0.005, OSC_AUTOSET_SIGNAL_PERIODIC },
+    { "square 25k",     SHAPE_SQUARE, 25000,  1e6,    0.00, 3.30, 0.5,  0.002, OSC_AUTOSET_SIGNAL_PERIODIC },
+    { "pulse 5% 2k",    SHAPE_SQUARE, 2000,   1e6,    0.50, 2.50, 0.05, 0.005, OSC_AUTOSET_SIGNAL_PERIODIC },
+    { "pulse 2% 500",   SHAPE_SQUARE, 500,    1e6,    0.10, 1.80, 0.02, 0.003, OSC_AUTOSET_SIGNAL_PERIODIC },
+    { "pulse 10% 100",  SHAPE_SQUARE, 100,    1e5,    0.20, 3.20, 0.10, 0.005, OSC_AUTOSET_SIGNAL_PERIODIC },
+    { "DC 1.2 V",       SHAPE_DC,     0,      1e6,    1.20, 0.00, 0.0,  0.002, OSC_AUTOSET_SIGNAL_DC },
+    { "DC 0 V",         SHAPE_DC,     0,      1e6,    0.00, 0.00, 0.0,  0.000, OSC_AUTOSET_SIGNAL_DC },
+    { "DC 3.3 V",       SHAPE_DC,     0,      1e5,    3.30, 0.00, 0.0,  0.003, OSC_AUTOSET_SIGNAL_DC },
+    { "noise 0.3 V",    SHAPE_NOISE,  0,      1e6,    1.65, 0.30, 0.0,  0.000, OSC_AUTOSET_SIGNAL_NOISE },
+    { "noise 0.05 V",   SHAPE_NOISE,  0,      1e5,    1.00, 0.05, 0.0,  0.000, OSC_AUTOSET_SIGNAL_NOISE },
+};
+
+static void check_case(const signal_case_t *c, bool verbose, double *worst_us)
+{
+    generate(c, g_burst, BURST_POINTS);
+
+    osc_autoset_analysis_t a;
+    double t0 = now_us();
+    esp_err_t ret = osc_autoset_analyze(g_burst, BURST_POINTS, (float)c->rate_hz, &a);
+    double us = now_us() - t0;
+    if (us > *worst_us) *worst_us = us;
+
+    CHECK(ret == ESP_OK, "%s: analyze returned %d", c->name, ret);
+    CHECK(a.signal == c->expect, "%s: classified %s, expected %s", c->name,
+          osc_autoset_get_signal_str(a.signal), osc_autoset_get_signal_str(c->expect));
+
+    double swing = c->high - c->low;
+    double lsb = ADC_FULL_SCALE / ADC_CODES;
+    if (c->shape == SHAPE_DC) {
+        CHECK(fabs(a.mean - c->low) < 0.005 + lsb, "%s: mean %.4f V", c->name, a.mean);
+    } else if (c->expect == OSC_AUTOSET_SIGNAL_PERIODIC) {
+        // Clean signals to 0.5%; 2% with heavy noise is still ample for a 1-2-5 timebase
+        double ferr = fabs(a.frequency_hz - c->freq_hz) / c->freq_hz;
+        double ftol = c->noise > 0.05 ? 0.02 : 0.005;
+        CHECK(ferr < ftol, "%s: %.2f Hz, expected %.2f Hz", c->name, a.frequency_hz, c->freq_hz);
+
+        // Extremes within 4 noise sigma plus 3% of the swing
+        double tol = 4.0 * c->noise + 0.03 * swing + 2.0 * lsb;
+        double lo = c->low < 0.0 ? 0.0 : c->low;
+        double hi = c->high > ADC_FULL_SCALE ? ADC_FULL_SCALE : c->high;
+        CHECK(fabs(a.vmax - hi) < tol && fabs(a.vmin - lo) < tol,
+              "%s: vmin %.3f vmax %.3f, expected %.3f / %.3f", c->name, a.vmin, a.vmax, lo, hi);
+
+        if (c->shape == SHAPE_SQUARE) {
+            CHECK(fabs(a.top - hi) < tol && fabs(a.base - lo) < tol,
+                  "%s: base %.3f top %.3f, expected %.3f / %.3f", c->name, a.base, a.top, lo, hi);
+            // A partial period at the end of the record skews the duty cycle by up to duty / cycles
+            double cycles = c->freq_hz * BURST_POINTS / c->rate_hz;
+            double dtol = 0.005 + fmin(c->duty, 1.0 - c->duty) / cycles;
+            CHECK(fabs(a.duty - c->duty) < dtol, "%s: duty %.3f, expected %.3f", c->name, a.duty, c->duty);
+        } else {
+            // Top and base of a sine are only histogram modes; AUTO needs their
+            // midpoint (the trigger level) inside the middle half of the swing
+            double level = (a.top + a.base) / 2.0;
+            CHECK(fabs(level - (lo + hi) / 2.0) < swing / 4.0, "%s: trigger level %.3f", c->name, level);
+        }
+    }
+
+    if (!verbose) return;
+    printf("  %-15s %-8s f %10.2f Hz  base %.3f top %.3f  duty %.3f  r %.2f  %6.0f us\n",
+           c->name, osc_autoset_get_signal_str(a.signal), a.frequency_hz, a.base, a.top,
+           a.duty, a.correlation, us);
+}
+
+static void test_signals(void)
+{
+    // Every case again with other phases and noise; only the first round is printed
+    double worst_us = 0.0;
+    for (int round = 0; round < SIGNAL_ROUNDS; round++) {
+        for (size_t i = 0; i < sizeof(s_cases) / sizeof(s_cases[0]); i++) {
+            check_case(&s_cases[i], round == 0, &worst_us);
+        }
+    }
+    printf("  worst analysis time %.0f us (%d points)\n", worst_us, BURST_POINTS);
+}
+
+static void test_spikes(void)
+{
+    // 0.3% of the samples glitch to full scale: extremes and levels ignore them
+    signal_case_t c = { "square+spikes", SHAPE_SQUARE, 1000, 1e6, 0.5, 2.0, 0.5, 0.005, OSC_AUTOSET_SIGNAL_PERIODIC };
+    generate(&c, g_burst, BURST_POINTS);
+    for (uint32_t i = 0; i < BURST_POINTS * 3 / 1000; i++) {
+        g_burst[rnd() % BURST_POINTS] = (rnd() & 1) ? ADC_FULL_SCALE : 0.0f;
+    }
+
+    osc_autoset_analysis_t a;
+    CHECK(osc_autoset_analyze(g_burst, BURST_POINTS, 1e6f, &a) == ESP_OK, "analyze");
+    CHECK(a.signal == OSC_AUTOSET_SIGNAL_PERIODIC, "classified %s", osc_autoset_get_signal_str(a.signal));
+    CHECK(fabs(a.frequency_hz - 1000.0) < 10.0, "frequency %.2f Hz", a.frequency_hz);
+    CHECK(a.vmax < 2.1f && a.vmin > 0.4f, "spikes moved the extremes: %.3f / %.3f", a.vmin, a.vmax);
+    CHECK(fabsf(a.top - 2.0f) < 0.05f && fabsf(a.base - 0.5f) < 0.05f, "levels %.3f / %.3f", a.base, a.top);
+}
+
+static void test_short_and_invalid(void)
+{
+    osc_autoset_analysis_t a;
+    signal_case_t c = { "short sine", SHAPE_SINE, 10000, 1e6, 1.0, 2.0, 0.0, 0.002, OSC_AUTOSET_SIGNAL_PERIODIC };
+
+    // The shortest burst AUTO can get before its timeout (1000 samples)
+    generate(&c, g_burst, 1000);
+    CHECK(osc_autoset_analyze(g_burst, 1000, 1e6f, &a) == ESP_OK, "analyze 1000 points");
+    CHECK(a.signal == OSC_AUTOSET_SIGNAL_PERIODIC && fabs(a.frequency_hz - 10000.0) < 100.0,
+          "1000 points: %s %.1f Hz", osc_autoset_get_signal_str(a.signal), a.frequency_hz);
+
+    CHECK(osc_autoset_analyze(NULL, 100, 1e6f, &a) == ESP_ERR_INVALID_ARG, "NULL data accepted");
+    CHECK(osc_autoset_analyze(g_burst, 15, 1e6f, &a) == ESP_ERR_INVALID_ARG, "15 points accepted");
+    CHECK(osc_autoset_analyze(g_burst, 100, 0.0f, &a) == ESP_ERR_INVALID_ARG, "zero rate accepted");
+    CHECK(osc_autoset_analyze(g_burst, 100, 1e6f, NULL) == ESP_ERR_INVALID_ARG, "NULL result accepted");
+}
+
+static void test_pick_scale(void)
+{
+    static const float table[] = { 0.01f, 0.02f, 0.05f, 0.1f, 0.2f, 0.5f, 1.0f };
+    CHECK(osc_autoset_pick_scale(table, 7, 0.0f) == 0, "zero target");
+    CHECK(osc_autoset_pick_scale(table, 7, 0.05f) == 2, "exact entry");
+    CHECK(osc_autoset_pick_scale(table, 7, 0.0500001f) == 2, "rounding above an entry");
+    CHECK(osc_autoset_pick_scale(table, 7, 0.06f) == 3, "between entries");
+    CHECK(osc_autoset_pick_scale(table, 7, 5.0f) == 6, "above the table");
+}
+
+int main(int argc, char **argv)
+{
+    test_signals();
+    test_spikes();
+    test_short_and_invalid();
+    test_pick_scale();
+
+    printf("%s (%d failure%s)\n", g_failures ? "FAILED" : "passed", g_failures, g_failures == 1 ? "" : "s");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,355 @@
+/**
+ * @file bode_host.c
+ * @brief Bode analyzer on the host against a simulated RC low-pass
+ *
+ * Runs the device's oscilloscope_bode.c unchanged. The io callbacks stand in
+ * for the generator and the scope:
+ *
+ *   - The stimulus is a 1 V sine whose phase stays continuous across
+ *     frequency steps, into an RC low-pass with corner fc. The output is
+ *     the exact solution (steady state plus the decaying transient of every
+ *     step), so the sweep sees real settling at low corners.
+ *   - The sample rate is picked from the ADC tiers like
+ *     osc_core_set_acquire_rate(), and a capture waits like
+ *     osc_core_acquire(). The simulated clock gives the sweep time.
+ *   - Samples are quantized to 12 bits around 1.65 V with 2 mV noise.
+ *
+ * For corners from 5 Hz to 20 kHz the default 100-point sweep must match
+ * the analytic |H| = 1 / sqrt(1 + (f / fc)^2) and angle -atan(f / fc) above
+ * -40 dB. The phase reference is the simulated stimulus phase; the device
+ * path has none, so a sweep without it must leave every phase NAN and
+ * write an empty CSV phase field. Settle detection is compared with
+ * single captures, and a background sweep is cancelled.
+ *
+ *   ./bode_host                    # tests, exit status 1 on failure
+ *   ./bode_host --csv out.csv 500  # also save the sweep of a 500 Hz corner
+ */
+
+#include "oscilloscope_bode.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ADC_FULL_SCALE  3.3
+#define ADC_CODES       4095.0
+#define ADC_MIDPOINT    1.65
+#define NOISE_V         0.002
+#define ADC_BLOCK       64          // OSC_ADC_BLOCK_SIZE
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        g_failures++; \
+        printf("  FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+static uint32_t g_seed = 12345;
+
+static uint32_t rnd(void)
+{
+    g_seed = g_seed * 1103515245u + 12345u;
+    return g_seed >> 8;
+}
+
+static double gauss(void)
+{
+    double u1 = (rnd() + 1.0) / 16777217.0;
+    double u2 = rnd() / 16777216.0;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/* ==================== Simulated DUT ==================== */
+
+static const float s_tiers[] = { 1e6f, 500e3f, 200e3f, 100e3f, 50e3f, 10e3f, 1e3f };
+#define NUM_TIERS (sizeof(s_tiers) / sizeof(s_tiers[0]))
+
+typedef struct {
+    double fc;                  // RC corner
+    double amplitude;           // Stimulus peak
+    bool phase_reference;       // Report the stimulus phase to the analyzer
+    int capture_delay_ms;       // Real time per capture (background sweep test)
+
+    /* Segment since the last frequency step */
+    double f;
+    double t0;
+    double theta0;              // Stimulus phase at t0
+    double y0;                  // Output at t0
+
+    double now;                 // Simulated time
+    float rate;
+    uint32_t rate_switches;
+    uint32_t captures;
+} rc_sim_t;
+
+/* Stimulus phase and RC output at time t >= t0 */
+static double rc_output(const rc_sim_t *sim, double t, double *theta)
+{
+    double th = sim->theta0 + 2.0 * M_PI * sim->f * (t - sim->t0);
+    if (theta) *theta = th;
+    double ratio = sim->f / sim->fc;
+    double mag = sim->amplitude / sqrt(1.0 + ratio * ratio);
+    double arg = -atan(ratio);
+    double steady0 = mag * sin(sim->theta0 + arg);
+    double tau = 1.0 / (2.0 * M_PI * sim->fc);
+    return mag * sin(th + arg) + (sim->y0 - steady0) * exp(-(t - sim->t0) / tau);
+}
+
+static esp_err_t sim_set_stimulus(void *user, float frequency_hz)
+{
+    rc_sim_t *sim = user;
+    double theta;
+    sim->y0 = rc_output(sim, sim->now, &theta);
+    sim->theta0 = fmod(theta, 2.0 * M_PI);
+    sim->t0 = sim->now;
+    sim->f = frequency_hz;
+    return ESP_OK;
+}
+
+/* Same tier choice as osc_core_set_acquire_rate() */
+static float sim_set_sample_rate(void *user, float min_rate, float max_rate)
+{
+    rc_sim_t *sim = user;
+    float pick = 0.0f;
+    for (size_t i = 0; i < NUM_TIERS && pick == 0.0f; i++) {
+        if (s_tiers[i] <= max_rate && s_tiers[i] >= min_rate) pick = s_tiers[i];
+    }
+    for (size_t i = NUM_TIERS; i-- > 0 && pick == 0.0f;) {
+        if (s_tiers[i] >= min_rate) pick = s_tiers[i];
+    }
+    if (pick == 0.0f) pick = s_tiers[0];
+    if (pick != sim->rate) sim->rate_switches++;
+    sim->rate = pick;
+    return pick;
+}
+
+/* Waits like osc_core_acquire(), then returns the newest count samples */
+static esp_err_t sim_capture(void *user, float *buffer, uint32_t count, float *stimulus_phase)
+{
+    rc_sim_t *sim = user;
+    double capture_ms = ceil((count + ADC_BLOCK) * 1000.0 / sim->rate) + 1.0;
+    sim->now += capture_ms / 1000.0;
+    sim->captures++;
+
+    double t_first = sim->now - (double)count / sim->rate;
+    for (uint32_t i = 0; i < count; i++) {
+        double theta;
+        double v = ADC_MIDPOINT + rc_output(sim, t_first + i / (double)sim->rate, &theta) + NOISE_V * gauss();
+        double code = floor(v / ADC_FULL_SCALE * ADC_CODES + 0.5);
+        code = fmin(fmax(code, 0.0), ADC_CODES);
+        buffer[i] = (float)(code * ADC_FULL_SCALE / ADC_CODES);
+        if (i == 0) {
+            *stimulus_phase = sim->phase_reference ? (float)fmod(theta, 2.0 * M_PI) : NAN;
+        }
+    }
+
+    if (sim->capture_delay_ms > 0) vTaskDelay(pdMS_TO_TICKS(sim->capture_delay_ms));
+    return ESP_OK;
+}
+
+static void sim_init(rc_sim_t *sim, double fc, bool phase_reference)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->fc = fc;
+    sim->amplitude = 1.0;
+    sim->phase_reference = phase_reference;
+}
+
+static osc_bode_io_t sim_io(rc_sim_t *sim)
+{
+    osc_bode_io_t io = {
+        .set_stimulus = sim_set_stimulus,
+        .set_sample_rate = sim_set_sample_rate,
+        .capture = sim_capture,
+        .user = sim,
+    };
+    return io;
+}
+
+/* ==================== Tests ==================== */
+
+static osc_bode_ctx_t *g_bode;
+static osc_bode_point_t g_points[OSC_BODE_MAX_POINTS];
+
+typedef struct {
+    double gain_err_db;         // Worst error above -40 dB
+    double phase_err_deg;
+    uint16_t count;
+    uint16_t settled;
+} sweep_result_t;
+
+static sweep_result_t sweep(rc_sim_t *sim, const osc_bode_config_t *config)
+{
+    sweep_result_t r = { 0 };
+    osc_bode_io_t io = sim_io(sim);
+    esp_err_t ret = osc_bode_run(g_bode, config, &io);
+    CHECK(ret == ESP_OK, "fc %.0f Hz: sweep returned %d", sim->fc, ret);
+    osc_bode_get_points(g_bode, g_points, OSC_BODE_MAX_POINTS, &r.count);
+
+    for (uint16_t i = 0; i < r.count; i++) {
+        const osc_bode_point_t *p = &g_points[i];
+        double ratio = p->frequency / sim->fc;
+        double gain_db = -10.0 * log10(1.0 + ratio * ratio);
+        double phase_deg = -atan(ratio) * 180.0 / M_PI;
+        r.settled += p->settled;
+        if (gain_db < -40.0) continue;
+        r.gain_err_db = fmax(r.gain_err_db, fabs(p->gain_db - gain_db));
+        if (!isnan(p->phase_deg)) r.phase_err_deg = fmax(r.phase_err_deg, fabs(p->phase_deg - phase_deg));
+    }
+    return r;
+}
+
+static void test_rc_sweeps(void)
+{
+    static const double corners[] = { 5.0, 50.0, 500.0, 5000.0, 20000.0 };
+    osc_bode_config_t config;
+    osc_bode_get_default_config(&config);
+
+    printf("  %-8s %8s %8s %6s %9s %8s %8s\n", "fc", "gain dB", "phase", "time", "switches", "captures", "settled");
+    for (size_t i = 0; i < sizeof(corners) / sizeof(corners[0]); i++) {
+        rc_sim_t sim;
+        sim_init(&sim, corners[i], true);
+        sweep_result_t r = sweep(&sim, &config);
+
+        printf("  %-8.0f %8.3f %8.2f %5.1fs %9lu %8lu %5u/%u\n", corners[i], r.gain_err_db, r.phase_err_deg,
+               sim.now, (unsigned long)sim.rate_switches, (unsigned long)sim.captures, r.settled, r.count);
+        CHECK(r.count == config.points, "fc %.0f Hz: %u points", corners[i], r.count);
+        CHECK(r.gain_err_db < 0.1, "fc %.0f Hz: gain error %.3f dB", corners[i], r.gain_err_db);
+        CHECK(r.phase_err_deg < 1.0, "fc %.0f Hz: phase error %.2f deg", corners[i], r.phase_err_deg);
+        CHECK(sim.now < 5.0, "fc %.0f Hz: sweep took %.1f s", corners[i], sim.now);
+    }
+}
+
+static void test_settling(void)
+{
+    // A 5 Hz corner settles over tens of milliseconds after every step
+    osc_bode_config_t config;
+    osc_bode_get_default_config(&config);
+    rc_sim_t sim;
+
+    sim_init(&sim, 5.0, true);
+    sweep_result_t with_settle = sweep(&sim, &config);
+
+    config.max_captures = 1;
+    sim_init(&sim, 5.0, true);
+    sweep_result_t single = sweep(&sim, &config);
+
+    printf("  fc 5 Hz: settle detection %.3f dB / %.2f deg, single captures %.3f dB / %.2f deg\n",
+           with_settle.gain_err_db, with_settle.phase_err_deg, single.gain_err_db, single.phase_err_deg);
+    CHECK(single.gain_err_db > 2.0 * with_settle.gain_err_db, "settle detection does not help the gain");
+    CHECK(single.phase_err_deg > 2.0 * with_settle.phase_err_deg, "settle detection does not help the phase");
+}
+
+static void test_no_phase_reference(const char *csv_path)
+{
+    osc_bode_config_t config;
+    osc_bode_get_default_config(&config);
+    config.points = 20;
+    rc_sim_t sim;
+    sim_init(&sim, 500.0, false);
+    sweep_result_t r = sweep(&sim, &config);
+    CHECK(r.gain_err_db < 0.1, "gain error %.3f dB without a phase reference", r.gain_err_db);
+
+    int with_phase = 0;
+    for (uint16_t i = 0; i < r.count; i++) with_phase += !isnan(g_points[i].phase_deg);
+    CHECK(with_phase == 0, "%d points have a phase without a reference", with_phase);
+
+    CHECK(osc_bode_save_csv(g_bode, csv_path) == ESP_OK, "save %s", csv_path);
+    FILE *f = fopen(csv_path, "r");
+    CHECK(f != NULL, "open %s", csv_path);
+    if (f == NULL) return;
+    char line[128];
+    int rows = 0, empty_phase = 0;
+    while (fgets(line, sizeof(line), f)) {
+        if (rows++ == 0) continue;
+        char *c1 = strchr(line, ',');
+        char *c2 = c1 ? strchr(c1 + 1, ',') : NULL;
+        if (c2 && c2[1] == ',') empty_phase++;
+        CHECK(strstr(line, "nan") == NULL, "nan in CSV row: %s", line);
+    }
+    fclose(f);
+    remove(csv_path);
+    CHECK(rows == r.count + 1, "%d CSV rows for %u points", rows, r.count);
+    CHECK(empty_phase == r.count, "%d of %u rows with an empty phase", empty_phase, r.count);
+}
+
+static void test_measure(void)
+{
+    // A pure sine: amplitude and sine phase at the first sample
+    static float data[5000];
+    for (int i = 0; i < 5000; i++) data[i] = 1.0f + 0.7f * sinf(2.0f * (float)M_PI * 1000.0f * i / 100e3f + 0.5f);
+    float amplitude, phase;
+    CHECK(osc_bode_measure(data, 5000, 1000.0f, 100e3f, &amplitude, &phase) == ESP_OK, "measure");
+    CHECK(fabsf(amplitude - 0.7f) < 1e-3f && fabsf(phase - 0.5f) < 1e-3f, "amplitude %.4f phase %.4f",
+          amplitude, phase);
+    CHECK(osc_bode_measure(data, 5000, 50e3f, 100e3f, &amplitude, &phase) == ESP_ERR_INVALID_ARG,
+          "Nyquist frequency accepted");
+
+    rc_sim_t sim;
+    sim_init(&sim, 500.0, true);
+    osc_bode_io_t io = sim_io(&sim);
+    osc_bode_config_t config;
+    osc_bode_get_default_config(&config);
+    config.points = 1;
+    CHECK(osc_bode_run(g_bode, &config, &io) == ESP_ERR_INVALID_ARG, "1-point sweep accepted");
+    osc_bode_get_default_config(&config);
+    config.stop_hz = config.start_hz;
+    CHECK(osc_bode_run(g_bode, &config, &io) == ESP_ERR_INVALID_ARG, "empty range accepted");
+}
+
+static void test_cancel(void)
+{
+    rc_sim_t sim;
+    sim_init(&sim, 500.0, true);
+    sim.capture_delay_ms = 5;
+    osc_bode_io_t io = sim_io(&sim);
+    osc_bode_config_t config;
+    osc_bode_get_default_config(&config);
+
+    CHECK(osc_bode_start(g_bode, &config, &io) == ESP_OK, "start");
+    CHECK(osc_bode_start(g_bode, &config, &io) == ESP_ERR_INVALID_STATE, "second start accepted");
+    osc_bode_progress_t progress;
+    do {
+        vTaskDelay(pdMS_TO_TICKS(5));
+        osc_bode_get_progress(g_bode, &progress);
+    } while (progress.done < 5);
+    osc_bode_cancel(g_bode);
+
+    osc_bode_get_progress(g_bode, &progress);
+    CHECK(!progress.running && progress.result == ESP_ERR_TIMEOUT, "cancelled sweep: running %d result %d",
+          progress.running, progress.result);
+    CHECK(progress.done >= 5 && progress.done < config.points, "cancelled after %u points", progress.done);
+}
+
+int main(int argc, char **argv)
+{
+    osc_bode_config_t defaults;
+    osc_bode_get_default_config(&defaults);
+    g_bode = osc_bode_init(defaults.max_samples);
+    if (g_bode == NULL) return 1;
+
+    test_rc_sweeps();
+    test_settling();
+    test_no_phase_reference("bode_host.csv");
+    test_measure();
+    test_cancel();
+
+    if (argc > 2 && strcmp(argv[1], "--csv") == 0) {
+        rc_sim_t sim;
+        sim_init(&sim, argc > 3 ? atof(argv[3]) : 500.0, true);
+        sweep(&sim, &defaults);
+        osc_bode_save_csv(g_bode, argv[2]);
+        printf("  saved %s\n", argv[2]);
+    }
+
+    osc_bode_deinit(g_bode);
+    printf("%s (%d failure%s)\n", g_failures ? "FAILED" : "passed", g_failures, g_failures == 1 ? "" : "s");
+    return g_failures ? 1 : 0;
+}
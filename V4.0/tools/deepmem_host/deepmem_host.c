@@ -0,0 +1,424 @@
+/**
+ * @file deepmem_host.c
+ * @brief Deep memory on the host: correctness against brute force and an 8M-point benchmark
+ *
+ * Runs the device's oscilloscope_deepmem.c and oscilloscope_search.c
+ * unchanged on an 8M-point record of 12-bit codes (a noisy 1 kHz sine at
+ * 1 MSa/s with 16 sparse glitches). The record is appended in 64-sample
+ * blocks like the ADC task does, then every query is compared with a brute
+ * force pass over a copy of the codes:
+ *
+ *   - envelopes of random windows and zoom factors (exact min/max)
+ *   - statistics of random windows (mean / RMS to 1e-5 relative)
+ *   - edge counts of random windows
+ *   - the summary-pruned deep search against a full linear search
+ *   - a record finished early at an odd length
+ *
+ * With --bench the timings are printed: memory footprint, append cost per
+ * sample, and the latency of one 688-column envelope (a display frame) when
+ * zoomed fully out, at a 64K window and at one sample per column, plus a
+ * pan across the record, full-record statistics, an edge scan and the deep
+ * search against the linear one.
+ *
+ *   ./deepmem_host                 # tests, exit status 1 on failure
+ *   ./deepmem_host --bench         # tests, then timings
+ */
+
+#include "oscilloscope_deepmem.h"
+#include "oscilloscope_search.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define RECORD_POINTS   OSC_DEEPMEM_MAX_POINTS
+#define SAMPLE_RATE     1e6f
+#define VOLTS_PER_CODE  (3.3f / 4095.0f)
+#define COLUMNS         688                 // Waveform area width
+#define APPEND_BLOCK    64                  // OSC_ADC_BLOCK_SIZE
+#define NUM_GLITCHES    16
+#define GLITCH_CODE     3600
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        g_failures++; \
+        printf("  FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+static uint16_t *g_codes;
+static osc_deepmem_t *g_mem;
+static double g_append_ns;
+
+static uint32_t g_seed = 12345;
+
+static uint32_t rnd(void)
+{
+    g_seed = g_seed * 1103515245u + 12345u;
+    return g_seed >> 8;
+}
+
+/* Random number in [0, n) for n up to 2^32 */
+static uint32_t rnd_below(uint32_t n)
+{
+    uint64_t r = ((uint64_t)rnd() << 24) | rnd();
+    return (uint32_t)(r % n);
+}
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static float to_volts(uint32_t code)
+{
+    return code * VOLTS_PER_CODE;
+}
+
+/* ==================== Record ==================== */
+
+static void generate(uint16_t *codes, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        double v = 2048.0 + 600.0 * sin(2.0 * M_PI * 1000.0 * i / SAMPLE_RATE) + (double)(rnd() % 41) - 20.0;
+        codes[i] = (uint16_t)v;
+    }
+    // Sparse glitches well above the sine: the events the deep search looks for
+    for (int g = 0; g < NUM_GLITCHES; g++) {
+        uint32_t pos = 1000 + rnd_below(n - 2000);
+        for (int i = 0; i < 8; i++) codes[pos + i] = GLITCH_CODE;
+    }
+}
+
+static void record(const uint16_t *codes, uint32_t depth, uint32_t count)
+{
+    osc_deepmem_begin(g_mem, depth, 1.0f / SAMPLE_RATE, VOLTS_PER_CODE, 0.0f);
+    double t0 = now_us();
+    for (uint32_t pos = 0; pos < count; pos += APPEND_BLOCK) {
+        uint32_t n = (count - pos < APPEND_BLOCK) ? count - pos : APPEND_BLOCK;
+        osc_deepmem_append(g_mem, codes + pos, n);
+    }
+    g_append_ns = (now_us() - t0) * 1000.0 / count;
+}
+
+/* ==================== Brute force ==================== */
+
+static void brute_minmax(uint32_t s0, uint32_t s1, uint16_t *lo, uint16_t *hi)
+{
+    *lo = 0xFFFF;
+    *hi = 0;
+    for (uint32_t i = s0; i < s1; i++) {
+        if (g_codes[i] < *lo) *lo = g_codes[i];
+        if (g_codes[i] > *hi) *hi = g_codes[i];
+    }
+}
+
+/* Same column geometry as osc_deepmem_get_envelope() */
+static bool check_envelope(uint32_t length, uint32_t start, float spc)
+{
+    float min[COLUMNS], max[COLUMNS];
+    uint16_t filled = 0;
+    if (osc_deepmem_get_envelope(g_mem, start, spc, COLUMNS, min, max, &filled) != ESP_OK) return false;
+
+    uint16_t c = 0;
+    for (; c < COLUMNS; c++) {
+        uint32_t s0 = start + (uint32_t)((double)c * spc);
+        uint32_t s1 = start + (uint32_t)((double)(c + 1) * spc);
+        if (s0 >= length) break;
+        if (s1 <= s0) s1 = s0 + 1;
+        if (s1 > length) s1 = length;
+        uint16_t lo, hi;
+        brute_minmax(s0, s1, &lo, &hi);
+        if (min[c] != to_volts(lo) || max[c] != to_volts(hi)) return false;
+    }
+    return filled == c;
+}
+
+static bool close_to(double a, double b)
+{
+    return fabs(a - b) <= 1e-5 * fabs(b) + 1e-6;
+}
+
+/* ==================== Tests ==================== */
+
+static void test_record(void)
+{
+    osc_deepmem_usage_t usage;
+    osc_deepmem_get_usage(g_mem, &usage);
+    CHECK(usage.capacity == RECORD_POINTS, "capacity %lu", (unsigned long)usage.capacity);
+
+    CHECK(osc_deepmem_begin(g_mem, RECORD_POINTS + 1, 1e-6f, VOLTS_PER_CODE, 0.0f) == ESP_ERR_INVALID_SIZE,
+          "depth above the capacity accepted");
+
+    osc_deepmem_begin(g_mem, RECORD_POINTS, 1.0f / SAMPLE_RATE, VOLTS_PER_CODE, 0.0f);
+    float min[4], max[4];
+    uint16_t filled;
+    osc_deepmem_append(g_mem, g_codes, 1000);
+    CHECK(osc_deepmem_get_envelope(g_mem, 0, 1.0f, 4, min, max, &filled) == ESP_ERR_INVALID_STATE,
+          "envelope of an unfinished record");
+
+    record(g_codes, RECORD_POINTS, RECORD_POINTS);
+    CHECK(osc_deepmem_is_finished(g_mem), "record not finished at its depth");
+    CHECK(osc_deepmem_get_length(g_mem) == RECORD_POINTS, "length %lu", (unsigned long)osc_deepmem_get_length(g_mem));
+    CHECK(osc_deepmem_append(g_mem, g_codes, 64) == 0, "samples stored past the depth");
+    osc_deepmem_get_usage(g_mem, &usage);
+    CHECK(usage.chunks_used == usage.chunks_total, "%lu of %lu chunks used",
+          (unsigned long)usage.chunks_used, (unsigned long)usage.chunks_total);
+
+    float values[100];
+    CHECK(osc_deepmem_read(g_mem, RECORD_POINTS - 100, 100, values) == ESP_OK, "read the tail");
+    bool same = true;
+    for (int i = 0; i < 100; i++) same &= (values[i] == to_volts(g_codes[RECORD_POINTS - 100 + i]));
+    CHECK(same, "read back differs");
+    CHECK(osc_deepmem_read(g_mem, RECORD_POINTS - 99, 100, values) == ESP_ERR_INVALID_ARG, "read past the end");
+}
+
+static void test_envelope(void)
+{
+    // Full record, exact zoom levels, then random windows and zooms
+    CHECK(check_envelope(RECORD_POINTS, 0, (float)RECORD_POINTS / COLUMNS), "full record");
+    CHECK(check_envelope(RECORD_POINTS, 65536, 65536.0f / COLUMNS), "64K window");
+    CHECK(check_envelope(RECORD_POINTS, 12345, 1.0f), "one sample per column");
+    CHECK(check_envelope(RECORD_POINTS, RECORD_POINTS - 100, 1.0f), "window past the end");
+
+    int bad = 0;
+    for (int i = 0; i < 300; i++) {
+        // Zoom from 0.25 to the full record per column, log-uniform
+        double zoom = pow(2.0, -2.0 + (rnd() % 10000) / 10000.0 * (log2((double)RECORD_POINTS / COLUMNS) + 2.0));
+        uint32_t span = (uint32_t)(zoom * COLUMNS);
+        uint32_t start = rnd_below(RECORD_POINTS - (span < RECORD_POINTS ? span : 0) + 1);
+        if (!check_envelope(RECORD_POINTS, start, (float)zoom)) bad++;
+    }
+    CHECK(bad == 0, "%d of 300 random envelopes differ from brute force", bad);
+}
+
+static void test_stats(void)
+{
+    int bad = 0;
+    for (int i = 0; i < 50; i++) {
+        uint32_t start = rnd_below(RECORD_POINTS);
+        uint32_t count = 1 + rnd_below(RECORD_POINTS - start);
+        if (i == 0) {
+            start = 0;
+            count = RECORD_POINTS;
+        }
+
+        osc_deepmem_stats_t stats;
+        if (osc_deepmem_get_stats(g_mem, start, count, &stats) != ESP_OK) {
+            bad++;
+            continue;
+        }
+        uint16_t lo, hi;
+        brute_minmax(start, start + count, &lo, &hi);
+        double sum = 0.0, sum_sq = 0.0;
+        for (uint32_t k = start; k < start + count; k++) {
+            double v = to_volts(g_codes[k]);
+            sum += v;
+            sum_sq += v * v;
+        }
+        double mean = sum / count;
+        double rms = sqrt(sum_sq / count);
+        if (stats.count != count || stats.min != to_volts(lo) || stats.max != to_volts(hi) ||
+            !close_to(stats.mean, mean) || !close_to(stats.rms, rms)) {
+            bad++;
+        }
+    }
+    CHECK(bad == 0, "%d of 50 statistics windows differ from brute force", bad);
+}
+
+static void test_edges(void)
+{
+    const float level = 1.65f, hysteresis = 0.1f;
+    int32_t high_code = (int32_t)ceilf((level + hysteresis) / VOLTS_PER_CODE);
+    int32_t low_code = (int32_t)floorf((level - hysteresis) / VOLTS_PER_CODE);
+
+    int bad = 0;
+    for (int i = 0; i < 50; i++) {
+        uint32_t start = rnd_below(RECORD_POINTS);
+        uint32_t count = rnd_below(1u << 20);
+
+        uint32_t edges, first, last;
+        osc_deepmem_find_edges(g_mem, start, count, level, hysteresis, &edges, &first, &last);
+
+        uint32_t end = (start + count < RECORD_POINTS) ? start + count : RECORD_POINTS;
+        uint32_t n = 0, f = 0, l = 0;
+        bool armed = false;
+        for (uint32_t k = start; k < end; k++) {
+            if (g_codes[k] <= low_code) {
+                armed = true;
+            } else if (armed && g_codes[k] >= high_code) {
+                armed = false;
+                if (n == 0) f = k;
+                l = k;
+                n++;
+            }
+        }
+        if (edges != n || (n > 0 && (first != f || last != l))) bad++;
+    }
+    CHECK(bad == 0, "%d of 50 edge scans differ from brute force", bad);
+}
+
+static osc_trigger_config_t glitch_criteria(void)
+{
+    osc_trigger_config_t criteria = {
+        .enabled = true,
+        .level_voltage = 2.6f,      // Above the sine (at most 2.15 V), below the glitches
+        .rising_edge = true,
+        .pre_trigger_ratio = 0.5f,
+        .type = OSC_TRIGGER_EDGE,
+    };
+    return criteria;
+}
+
+static void test_search(osc_search_ctx_t *search, float *volts)
+{
+    osc_trigger_config_t criteria = glitch_criteria();
+    CHECK(osc_search_run_deep(search, g_mem, &criteria) == ESP_OK, "deep search");
+    uint32_t count = osc_search_get_count(search);
+    uint32_t deep_hits[NUM_GLITCHES + 1];
+    for (uint32_t i = 0; i < count && i <= NUM_GLITCHES; i++) osc_search_get_hit(search, i, &deep_hits[i]);
+
+    osc_search_stats_t stats;
+    osc_search_get_stats(search, &stats);
+    CHECK(stats.samples_read < RECORD_POINTS / 100, "deep search read %lu samples",
+          (unsigned long)stats.samples_read);
+
+    // Reference: every sample through the detector
+    osc_deepmem_read(g_mem, 0, RECORD_POINTS, volts);
+    osc_search_run(search, volts, RECORD_POINTS, NULL, &criteria, SAMPLE_RATE);
+    uint32_t ref_count = osc_search_get_count(search);
+    CHECK(ref_count == count, "deep search found %lu events, linear %lu", (unsigned long)count,
+          (unsigned long)ref_count);
+    CHECK(count > 0 && count <= NUM_GLITCHES, "%lu events for %d glitches", (unsigned long)count, NUM_GLITCHES);
+    for (uint32_t i = 0; i < count && i < ref_count && i <= NUM_GLITCHES; i++) {
+        uint32_t pos;
+        osc_search_get_hit(search, i, &pos);
+        CHECK(pos == deep_hits[i], "event %lu at %lu, linear %lu", (unsigned long)i,
+              (unsigned long)deep_hits[i], (unsigned long)pos);
+    }
+}
+
+static void test_partial(void)
+{
+    // A record stopped early at an odd length seals its partial blocks
+    const uint32_t length = 1000003;
+    osc_deepmem_begin(g_mem, 2 * length, 1.0f / SAMPLE_RATE, VOLTS_PER_CODE, 0.0f);
+    for (uint32_t pos = 0; pos < length; pos += 61) {
+        osc_deepmem_append(g_mem, g_codes + pos, (length - pos < 61) ? length - pos : 61);
+    }
+    CHECK(!osc_deepmem_is_finished(g_mem), "finished before its depth");
+    osc_deepmem_finish(g_mem);
+    CHECK(osc_deepmem_is_finished(g_mem) && osc_deepmem_get_length(g_mem) == length, "finish");
+    CHECK(check_envelope(length, 0, (float)length / COLUMNS), "partial record, full view");
+    CHECK(check_envelope(length, length - 5000, 10.0f), "partial record, tail");
+
+    osc_deepmem_stats_t stats;
+    osc_deepmem_get_stats(g_mem, length - 777, 10000, &stats);
+    CHECK(stats.count == 777, "stats clamped to %lu samples", (unsigned long)stats.count);
+}
+
+/* ==================== Benchmark ==================== */
+
+static double time_envelope(uint32_t start, float spc, int reps)
+{
+    float min[COLUMNS], max[COLUMNS];
+    uint16_t filled;
+    double t0 = now_us();
+    for (int r = 0; r < reps; r++) {
+        osc_deepmem_get_envelope(g_mem, start + (uint32_t)r, spc, COLUMNS, min, max, &filled);
+    }
+    return (now_us() - t0) / reps;
+}
+
+static void bench(osc_search_ctx_t *search, float *volts)
+{
+    record(g_codes, RECORD_POINTS, RECORD_POINTS);
+
+    osc_deepmem_usage_t usage;
+    osc_deepmem_get_usage(g_mem, &usage);
+    printf("\n8M points, %d columns per frame\n", COLUMNS);
+    printf("  memory            %.1f MB pool + %.1f KB summaries (%.1f%%)\n",
+           usage.pool_bytes / 1048576.0, usage.summary_bytes / 1024.0,
+           100.0 * usage.summary_bytes / usage.pool_bytes);
+    printf("  append            %.1f ns/sample (%d-sample blocks)\n", g_append_ns, APPEND_BLOCK);
+
+    printf("  envelope full     %.1f us\n", time_envelope(0, (float)RECORD_POINTS / COLUMNS, 200));
+    printf("  envelope 64K      %.1f us\n", time_envelope(3000000, 65536.0f / COLUMNS, 2000));
+    printf("  envelope 1:1      %.1f us\n", time_envelope(3000000, 1.0f, 2000));
+
+    // Pan: a 64K window dragged across the whole record, 1/8 screen per frame
+    float min[COLUMNS], max[COLUMNS];
+    uint16_t filled;
+    const uint32_t window = 65536, step = window / 8;
+    int frames = 0;
+    double t0 = now_us();
+    for (uint32_t start = 0; start + window <= RECORD_POINTS; start += step, frames++) {
+        osc_deepmem_get_envelope(g_mem, start, (float)window / COLUMNS, COLUMNS, min, max, &filled);
+    }
+    printf("  pan 64K window    %.1f us/frame over %d frames\n", (now_us() - t0) / frames, frames);
+
+    osc_deepmem_stats_t stats;
+    t0 = now_us();
+    for (int r = 0; r < 1000; r++) osc_deepmem_get_stats(g_mem, r, RECORD_POINTS - r, &stats);
+    printf("  stats full        %.1f us\n", (now_us() - t0) / 1000);
+
+    uint32_t edges, first, last;
+    t0 = now_us();
+    for (int r = 0; r < 100; r++) osc_deepmem_find_edges(g_mem, r * 1000, 65536, 1.65f, 0.1f, &edges, &first, &last);
+    printf("  edges 64K         %.1f us\n", (now_us() - t0) / 100);
+
+    osc_trigger_config_t criteria = glitch_criteria();
+    t0 = now_us();
+    osc_search_run_deep(search, g_mem, &criteria);
+    double deep_ms = (now_us() - t0) / 1000.0;
+    osc_search_stats_t search_stats;
+    osc_search_get_stats(search, &search_stats);
+    osc_deepmem_read(g_mem, 0, RECORD_POINTS, volts);
+    t0 = now_us();
+    osc_search_run(search, volts, RECORD_POINTS, NULL, &criteria, SAMPLE_RATE);
+    double linear_ms = (now_us() - t0) / 1000.0;
+    printf("  deep search       %.2f ms, %lu of %lu samples read (linear pass %.1f ms)\n", deep_ms,
+           (unsigned long)search_stats.samples_read, (unsigned long)search_stats.num_points, linear_ms);
+}
+
+int main(int argc, char **argv)
+{
+    bool run_bench = (argc > 1 && strcmp(argv[1], "--bench") == 0);
+
+    g_codes = malloc(RECORD_POINTS * sizeof(uint16_t));
+    float *volts = malloc(RECORD_POINTS * sizeof(float));
+    g_mem = osc_deepmem_init(RECORD_POINTS);
+    osc_search_ctx_t *search = osc_search_init();
+    if (g_codes == NULL || volts == NULL || g_mem == NULL || search == NULL) {
+        printf("out of memory\n");
+        return 1;
+    }
+    generate(g_codes, RECORD_POINTS);
+
+    test_record();
+    test_envelope();
+    test_stats();
+    test_edges();
+    test_search(search, volts);
+    test_partial();
+
+    if (run_bench) {
+        bench(search, volts);
+    }
+
+    osc_search_deinit(search);
+    osc_deepmem_deinit(g_mem);
+    free(volts);
+    free(g_codes);
+
+    printf("%s (%d failure%s)\n", g_failures ? "FAILED" : "passed", g_failures, g_failures == 1 ? "" : "s");
+    return g_failures ? 1 : 0;
+}
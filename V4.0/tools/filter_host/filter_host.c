@@ -0,0 +1,420 @@
+/**
+ * @file filter_host.c
+ * @brief Oscilloscope filter stage on the host: frequency and step response tests
+ *
+ * Runs the device's oscilloscope_filter.c unchanged, with the portable
+ * stand-ins for dsps_biquad_f32 / dsps_fir_f32 (same arithmetic) and the
+ * state-variable sections used for low corners. Steady-state sine gain is measured by a
+ * least-squares fit and compared with the analytic response of the
+ * bilinear-transformed prototypes the sections implement:
+ *
+ *   Butterworth LPF   1 / sqrt(1 + (W / Wc)^2N)
+ *   Butterworth HPF   1 / sqrt(1 + (Wc / W)^2N)
+ *   Notch             |1 - w^2| / sqrt((1 - w^2)^2 + (w / Q)^2)   (w = W / W0)
+ *   DC-block          W / sqrt(W^2 + Wc^2)
+ *
+ * with W = tan(pi f / fs). The 50 Hz notch and the AC-coupling DC-block are
+ * also run at every ADC rate up to 1 MSa/s, where their corners are far
+ * below the sample rate. The FIR is checked for unity DC gain, passband,
+ * stopband and its (taps - 1) / 2 sample delay. A chain fed in random block
+ * sizes, in place or not, must give bit-identical output to one call, so
+ * RUN mode filtering is seamless across ADC blocks.
+ *
+ *   ./filter_host                  # tests, exit status 1 on failure
+ */
+
+#include "oscilloscope_filter.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_SAMPLES     1000000
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        g_failures++; \
+        printf("  FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+static float g_in[MAX_SAMPLES];
+static float g_out[MAX_SAMPLES];
+static float g_ref[MAX_SAMPLES];
+
+static uint32_t g_seed = 12345;
+
+static uint32_t rnd(void)
+{
+    g_seed = g_seed * 1103515245u + 12345u;
+    return g_seed >> 8;
+}
+
+/* ==================== Measurement ==================== */
+
+/**
+ * @brief Amplitude and phase of a sine at f in y[0..n), fitted as a*sin + b*cos + c
+ */
+static void fit_sine(const float *y, uint32_t n, double fs, double f, double *amp, double *phase)
+{
+    // Normal equations of the three-term least-squares fit
+    double m[3][4] = {{0}};
+    for (uint32_t i = 0; i < n; i++) {
+        double t = 2.0 * M_PI * f * i / fs;
+        double v[3] = { sin(t), cos(t), 1.0 };
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) m[r][c] += v[r] * v[c];
+            m[r][3] += v[r] * y[i];
+        }
+    }
+    for (int p = 0; p < 3; p++) {
+        for (int r = p + 1; r < 3; r++) {
+            double k = m[r][p] / m[p][p];
+            for (int c = p; c < 4; c++) m[r][c] -= k * m[p][c];
+        }
+    }
+    double x[3];
+    for (int r = 2; r >= 0; r--) {
+        double s = m[r][3];
+        for (int c = r + 1; c < 3; c++) s -= m[r][c] * x[c];
+        x[r] = s / m[r][r];
+    }
+    *amp = sqrt(x[0] * x[0] + x[1] * x[1]);
+    *phase = atan2(x[1], x[0]);
+}
+
+/**
+ * @brief Steady-state gain (and phase, radians) of the chain at f
+ *
+ * Runs long enough for the slowest section here (a Q = 10 notch at 50 Hz)
+ * to settle, then fits the second half.
+ */
+static double sine_gain(osc_filter_ctx_t *ctx, double fs, double f, double *phase)
+{
+    uint32_t n = (uint32_t)(2.0 * fs);
+    if (n > MAX_SAMPLES) n = MAX_SAMPLES;
+    for (uint32_t i = 0; i < n; i++) g_in[i] = (float)sin(2.0 * M_PI * f * i / fs);
+
+    osc_filter_reset(ctx);
+    osc_filter_process(ctx, g_in, g_out, n);
+
+    double amp, ph;
+    fit_sine(g_out + n / 2, n - n / 2, fs, f, &amp, &ph);
+    if (phase) {
+        // Phase of the input at the same sample is zero; wrap to (-pi, pi]
+        double t0 = 2.0 * M_PI * f * (n / 2) / fs;
+        ph -= atan2(sin(t0), cos(t0));
+        while (ph <= -M_PI) ph += 2.0 * M_PI;
+        while (ph > M_PI) ph -= 2.0 * M_PI;
+        *phase = ph;
+    }
+    return amp;
+}
+
+static double db(double gain)
+{
+    return 20.0 * log10(gain > 1e-12 ? gain : 1e-12);
+}
+
+static osc_filter_ctx_t *make(osc_filter_type_t type, float fc, uint8_t order, float q, float fs)
+{
+    osc_filter_ctx_t *ctx = osc_filter_init();
+    osc_filter_stage_config_t stage = { .type = type, .cutoff_hz = fc, .order = order, .q = q };
+    esp_err_t ret = osc_filter_configure(ctx, &stage, 1, fs);
+    CHECK(ret == ESP_OK, "configure %s fc %.0f order %u: %d", osc_filter_get_type_str(type), fc, order, ret);
+    return ctx;
+}
+
+/* ==================== Tests ==================== */
+
+static void check_butterworth(bool highpass, uint8_t order, double fs)
+{
+    static const double fc = 1000.0;
+    static const double freqs[] = { 100, 500, 900, 1000, 1100, 2000, 5000, 20000 };
+
+    osc_filter_ctx_t *ctx = make(highpass ? OSC_FILTER_HPF : OSC_FILTER_LPF, fc, order, 0, fs);
+    double worst = 0.0;
+    for (size_t i = 0; i < sizeof(freqs) / sizeof(freqs[0]); i++) {
+        double ratio = tan(M_PI * freqs[i] / fs) / tan(M_PI * fc / fs);
+        if (highpass) ratio = 1.0 / ratio;
+        double expect = 1.0 / sqrt(1.0 + pow(ratio, 2.0 * order));
+        double got = sine_gain(ctx, fs, freqs[i], NULL);
+        // Relative above -60 dB, absolute below (float noise floor)
+        double err = expect > 1e-3 ? fabs(db(got) - db(expect)) : fabs(got - expect) * 1e3;
+        if (err > worst) worst = err;
+        CHECK(err < 0.05, "%s%u at %.0f Hz, fs %.0f: %.3f dB, expected %.3f dB",
+              highpass ? "HPF" : "LPF", order, freqs[i], fs, db(got), db(expect));
+    }
+    printf("  %s order %u at %4.0f kSa/s: worst error %.4f dB\n",
+           highpass ? "HPF" : "LPF", order, fs / 1000.0, worst);
+    osc_filter_deinit(ctx);
+}
+
+static void test_butterworth(void)
+{
+    // A 1 kHz corner is a biquad at 100 kSa/s, a state-variable section at 1 MSa/s
+    for (int hp = 0; hp <= 1; hp++) {
+        for (uint8_t order = 2; order <= OSC_FILTER_MAX_ORDER; order += 2) {
+            check_butterworth(hp, order, 100000.0);
+            check_butterworth(hp, order, 1000000.0);
+        }
+    }
+
+    // Step response of the order-2 low-pass: 4.3% overshoot, settles at 1
+    static const double fs = 100000.0;
+    static const double fc = 1000.0;
+    osc_filter_ctx_t *ctx = make(OSC_FILTER_LPF, fc, 2, 0, fs);
+    uint32_t n = 20000;
+    for (uint32_t i = 0; i < n; i++) g_in[i] = 1.0f;
+    osc_filter_process(ctx, g_in, g_out, n);
+    float peak = 0.0f;
+    for (uint32_t i = 0; i < n; i++) if (g_out[i] > peak) peak = g_out[i];
+    CHECK(peak > 1.035f && peak < 1.050f, "LPF2 step overshoot %.2f%%", (peak - 1.0f) * 100.0f);
+    CHECK(fabsf(g_out[n - 1] - 1.0f) < 1e-4f, "LPF2 step settles at %.6f", g_out[n - 1]);
+    osc_filter_deinit(ctx);
+
+    // HPF blocks a step, also with the corner 1/1000 of the sample rate
+    ctx = make(OSC_FILTER_HPF, 100.0f, 4, 0, (float)fs);
+    osc_filter_process(ctx, g_in, g_out, n);
+    CHECK(fabsf(g_out[n - 1]) < 1e-5f, "HPF4 step residue %.7f", g_out[n - 1]);
+    osc_filter_deinit(ctx);
+}
+
+static void test_notch(void)
+{
+    static const double fs = 10000.0;
+    static const double f0 = 50.0;
+    static const double q = 10.0;
+    static const double freqs[] = { 5, 30, 45, 47.5, 50, 52.5, 55, 100, 500, 3000 };
+
+    osc_filter_ctx_t *ctx = make(OSC_FILTER_NOTCH, (float)f0, 0, (float)q, (float)fs);
+    for (size_t i = 0; i < sizeof(freqs) / sizeof(freqs[0]); i++) {
+        double w = tan(M_PI * freqs[i] / fs) / tan(M_PI * f0 / fs);
+        double num = fabs(1.0 - w * w);
+        double expect = num / sqrt(num * num + (w / q) * (w / q));
+        double got = sine_gain(ctx, fs, freqs[i], NULL);
+        CHECK(fabs(got - expect) < 2e-3, "notch at %.1f Hz: %.5f, expected %.5f", freqs[i], got, expect);
+    }
+    double depth = db(sine_gain(ctx, fs, f0, NULL));
+    CHECK(depth < -40.0, "notch depth %.1f dB", depth);
+    printf("  notch 50 Hz Q 10: %.1f dB at f0, %.2f dB at 47.5 Hz\n",
+           depth, db(sine_gain(ctx, fs, 47.5, NULL)));
+    osc_filter_deinit(ctx);
+
+    // Default Q when none is given
+    ctx = make(OSC_FILTER_NOTCH, (float)f0, 0, 0.0f, (float)fs);
+    double w = tan(M_PI * 47.5 / fs) / tan(M_PI * f0 / fs);
+    double num = fabs(1.0 - w * w);
+    double expect = num / sqrt(num * num + (w / 10.0) * (w / 10.0));
+    double got = sine_gain(ctx, fs, 47.5, NULL);
+    CHECK(fabs(got - expect) < 2e-3, "default Q: %.5f, expected %.5f", got, expect);
+    osc_filter_deinit(ctx);
+}
+
+static void test_dc_block(void)
+{
+    static const double fs = 100000.0;
+    osc_filter_ctx_t *ctx = make(OSC_FILTER_DC_BLOCK, OSC_FILTER_AC_CUTOFF_HZ, 0, 0, (float)fs);
+
+    double wc = tan(M_PI * OSC_FILTER_AC_CUTOFF_HZ / fs);
+    static const double freqs[] = { 5, 10, 50, 1000, 20000 };
+    for (size_t i = 0; i < sizeof(freqs) / sizeof(freqs[0]); i++) {
+        double w = tan(M_PI * freqs[i] / fs);
+        double expect = w / sqrt(w * w + wc * wc);
+        double got = sine_gain(ctx, fs, freqs[i], NULL);
+        CHECK(fabs(db(got) - db(expect)) < 0.02, "DC-block at %.0f Hz: %.3f dB, expected %.3f dB",
+              freqs[i], db(got), db(expect));
+    }
+
+    osc_filter_deinit(ctx);
+}
+
+/**
+ * @brief Low corners at the ADC rates: N50 preset and AC coupling
+ *
+ * A 1.5 V offset, 0.5 V of 50 Hz hum and a 0.2 V 1 kHz signal for one
+ * second; over the last half the notch must leave the offset and the
+ * signal, and the DC-block must remove the offset.
+ */
+static void test_low_corners(void)
+{
+    static const double rates[] = { 1000000, 500000, 200000, 100000, 50000, 10000 };
+    osc_filter_stage_config_t notch = { .type = OSC_FILTER_NOTCH, .cutoff_hz = 50.0f, .q = 10.0f };
+    osc_filter_stage_config_t ac = { .type = OSC_FILTER_DC_BLOCK, .cutoff_hz = OSC_FILTER_AC_CUTOFF_HZ };
+
+    for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+        double fs = rates[r];
+        uint32_t n = (uint32_t)fs;
+        for (uint32_t i = 0; i < n; i++) {
+            g_in[i] = (float)(1.5 + 0.5 * sin(2.0 * M_PI * 50.0 * i / fs) + 0.2 * sin(2.0 * M_PI * 1000.0 * i / fs));
+        }
+
+        osc_filter_ctx_t *ctx = osc_filter_init();
+        osc_filter_configure(ctx, &notch, 1, (float)fs);
+        osc_filter_process(ctx, g_in, g_out, n);
+        double w = tan(M_PI * 1000.0 / fs) / tan(M_PI * 50.0 / fs);
+        double g1k = (w * w - 1.0) / sqrt((w * w - 1.0) * (w * w - 1.0) + (w / 10.0) * (w / 10.0));
+        double worst_notch = 0.0;
+        for (uint32_t i = n / 2; i < n; i++) {
+            double expect = 1.5 + 0.2 * g1k * sin(2.0 * M_PI * 1000.0 * i / fs);
+            double err = fabs(g_out[i] - expect);
+            if (err > worst_notch) worst_notch = err;
+        }
+
+        osc_filter_configure(ctx, &ac, 1, (float)fs);
+        osc_filter_process(ctx, g_in, g_out, n);
+        double mean = 0.0;
+        for (uint32_t i = n / 2; i < n; i++) mean += g_out[i];
+        mean /= n - n / 2;
+        osc_filter_deinit(ctx);
+
+        // The notch's own phase shift at 1 kHz is under 0.3 degrees (< 1 mV here)
+        CHECK(worst_notch < 0.005, "N50 at %.0f Sa/s: %.4f V off", fs, worst_notch);
+        CHECK(fabs(mean) < 1e-3, "AC at %.0f Sa/s: mean %.6f V", fs, mean);
+        printf("  %7.0f Sa/s: N50 %.2f mV worst, AC mean %+.3f mV\n", fs, worst_notch * 1e3, mean * 1e3);
+    }
+}
+
+static void test_fir(void)
+{
+    static const double fs = 100000.0;
+    static const double fc = 5000.0;
+    static const uint8_t taps = 31;
+    osc_filter_ctx_t *ctx = make(OSC_FILTER_FIR_LPF, (float)fc, taps, 0, (float)fs);
+
+    // Unity DC gain, and the step is complete after exactly `taps` samples
+    uint32_t n = 200;
+    for (uint32_t i = 0; i < n; i++) g_in[i] = 1.0f;
+    osc_filter_process(ctx, g_in, g_out, n);
+    CHECK(fabsf(g_out[taps - 1] - 1.0f) < 1e-5f && fabsf(g_out[n - 1] - 1.0f) < 1e-5f,
+          "FIR step %.6f at %u, %.6f at end", g_out[taps - 1], taps - 1, g_out[n - 1]);
+
+    // Passband flat, stopband down, linear phase (delay of (taps - 1) / 2)
+    double phase;
+    double pass = sine_gain(ctx, fs, fc / 10.0, &phase);
+    double delay = -phase / (2.0 * M_PI * (fc / 10.0) / fs);
+    CHECK(fabs(pass - 1.0) < 0.01, "FIR passband gain %.4f", pass);
+    CHECK(fabs(delay - (taps - 1) / 2.0) < 0.01, "FIR delay %.3f samples", delay);
+    double stop = db(sine_gain(ctx, fs, 4.0 * fc, NULL));
+    CHECK(stop < -40.0, "FIR stopband %.1f dB", stop);
+    double corner = db(sine_gain(ctx, fs, fc, NULL));
+    CHECK(corner < -3.0 && corner > -9.0, "FIR gain at cutoff %.1f dB", corner);
+    printf("  FIR %u taps: %.4f passband, %.1f dB at fc, %.1f dB at 4 fc, delay %.2f\n",
+           taps, pass, corner, stop, delay);
+    osc_filter_deinit(ctx);
+}
+
+static void test_blocks(void)
+{
+    static const float fs = 1000000.0f;
+    osc_filter_stage_config_t stages[] = {
+        { .type = OSC_FILTER_DC_BLOCK, .cutoff_hz = OSC_FILTER_AC_CUTOFF_HZ },
+        { .type = OSC_FILTER_NOTCH, .cutoff_hz = 50.0f, .q = 5.0f },
+        { .type = OSC_FILTER_LPF, .cutoff_hz = 20000.0f, .order = 4 },
+        { .type = OSC_FILTER_FIR_LPF, .cutoff_hz = 100000.0f, .order = 63 },
+    };
+    uint32_t n = 100000;
+    for (uint32_t i = 0; i < n; i++) {
+        g_in[i] = 0.5f + sinf(2.0f * (float)M_PI * 50.0f * i / fs) +
+                  ((float)(rnd() % 2001) - 1000.0f) / 1000.0f;
+    }
+
+    osc_filter_ctx_t *ctx = osc_filter_init();
+    CHECK(osc_filter_configure(ctx, stages, 4, fs) == ESP_OK, "configure chain");
+    CHECK(osc_filter_is_active(ctx), "chain active");
+    osc_filter_process(ctx, g_in, g_ref, n);
+
+    // Random blocks, alternately in place
+    for (int pass = 0; pass < 4; pass++) {
+        osc_filter_reset(ctx);
+        memcpy(g_out, g_in, n * sizeof(float));
+        uint32_t pos = 0;
+        bool in_place = pass & 1;
+        while (pos < n) {
+            uint32_t len = 1 + rnd() % (pass < 2 ? 64 : 12000);
+            if (len > n - pos) len = n - pos;
+            if (in_place) {
+                osc_filter_process(ctx, g_out + pos, g_out + pos, len);
+            } else {
+                osc_filter_process(ctx, g_in + pos, g_out + pos, len);
+            }
+            pos += len;
+            in_place = !in_place;
+        }
+        uint32_t diff = 0;
+        for (uint32_t i = 0; i < n; i++) if (g_out[i] != g_ref[i]) diff++;
+        CHECK(diff == 0, "pass %d: %u samples differ from one-block output", pass, diff);
+    }
+
+    // Pass-through chain copies
+    CHECK(osc_filter_configure(ctx, NULL, 0, fs) == ESP_OK, "configure empty chain");
+    CHECK(!osc_filter_is_active(ctx), "empty chain inactive");
+    osc_filter_process(ctx, g_in, g_out, n);
+    CHECK(memcmp(g_in, g_out, n * sizeof(float)) == 0, "pass-through changed samples");
+    osc_filter_deinit(ctx);
+}
+
+static void test_sample_rate(void)
+{
+    // Redesign keeps the corner in Hz; cutoffs above 0.45 fs are clamped
+    osc_filter_ctx_t *ctx = make(OSC_FILTER_LPF, 1000.0f, 4, 0, 100000.0f);
+    CHECK(osc_filter_set_sample_rate(ctx, 20000.0f) == ESP_OK, "set sample rate");
+    double g = sine_gain(ctx, 20000.0, 1000.0, NULL);
+    CHECK(fabs(db(g) + 3.0103) < 0.05, "LPF4 at fc after rate change: %.3f dB", db(g));
+    osc_filter_deinit(ctx);
+
+    ctx = make(OSC_FILTER_LPF, 8000.0f, 2, 0, 10000.0f);
+    g = sine_gain(ctx, 10000.0, 4500.0, NULL);
+    CHECK(fabs(db(g) + 3.0103) < 0.05, "clamped LPF2 at 0.45 fs: %.3f dB", db(g));
+    osc_filter_deinit(ctx);
+}
+
+static void test_invalid(void)
+{
+    osc_filter_ctx_t *ctx = osc_filter_init();
+    osc_filter_stage_config_t s[5] = {
+        { .type = OSC_FILTER_LPF, .cutoff_hz = 1000.0f, .order = 8 },
+        { .type = OSC_FILTER_HPF, .cutoff_hz = 10.0f, .order = 8 },
+        { .type = OSC_FILTER_NOTCH, .cutoff_hz = 50.0f },
+        { .type = OSC_FILTER_FIR_LPF, .cutoff_hz = 1000.0f },
+        { .type = OSC_FILTER_FIR_LPF, .cutoff_hz = 1000.0f },
+    };
+    CHECK(osc_filter_configure(ctx, s, 2, 1e5f) == ESP_OK, "8 sections fit");
+    CHECK(osc_filter_configure(ctx, s, 3, 1e5f) == ESP_ERR_INVALID_ARG, "9 sections accepted");
+    CHECK(osc_filter_configure(ctx, s + 3, 2, 1e5f) == ESP_ERR_INVALID_ARG, "two FIRs accepted");
+    CHECK(osc_filter_configure(ctx, s, 5, 1e5f) == ESP_ERR_INVALID_ARG, "five stages accepted");
+    CHECK(osc_filter_configure(ctx, s, 1, 0.0f) == ESP_ERR_INVALID_ARG, "zero sample rate accepted");
+
+    osc_filter_stage_config_t bad[] = {
+        { .type = OSC_FILTER_LPF, .cutoff_hz = 1000.0f, .order = 3 },
+        { .type = OSC_FILTER_LPF, .cutoff_hz = 1000.0f, .order = 10 },
+        { .type = OSC_FILTER_FIR_LPF, .cutoff_hz = 1000.0f, .order = 32 },
+        { .type = OSC_FILTER_FIR_LPF, .cutoff_hz = 1000.0f, .order = 65 },
+        { .type = OSC_FILTER_NONE, .cutoff_hz = 1000.0f },
+        { .type = OSC_FILTER_NOTCH, .cutoff_hz = 0.0f },
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        CHECK(osc_filter_configure(ctx, &bad[i], 1, 1e5f) == ESP_ERR_INVALID_ARG, "bad stage %zu accepted", i);
+    }
+    osc_filter_deinit(ctx);
+}
+
+int main(int argc, char **argv)
+{
+    test_butterworth();
+    test_notch();
+    test_dc_block();
+    test_low_corners();
+    test_fir();
+    test_blocks();
+    test_sample_rate();
+    test_invalid();
+
+    printf("%s (%d failure%s)\n", g_failures ? "FAILED" : "passed", g_failures, g_failures == 1 ? "" : "s");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,509 @@
+/**
+ * @file frame_host.c
+ * @brief Frame decoders on the host: unit tests and a throughput benchmark
+ *
+ * Runs the device's frame_parser.c unchanged. The tests encode random
+ * payloads (line, SLIP, COBS, Modbus-RTU with CRC), feed the stream in
+ * random pieces and check every frame comes back intact, in place when it
+ * could be; each piece is overwritten after frame_parser_sync(), as the
+ * receive ring would, so a frame left pointing at released bytes shows up
+ * as corrupt. Malformed input (bad escapes, truncated COBS blocks, CRC
+ * errors, short and oversized frames) must be reported and resynchronised.
+ *
+ * The benchmark feeds each decoder a long stream in 4 KB spans, as the
+ * receive flush takes them from byte_ring_peek().
+ *
+ *   ./frame_host                  # tests, exit status 1 on failure
+ *   ./frame_host --bench [MB]     # MB per decoder (default 64)
+ */
+
+#include "frame_parser.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_FRAMES      4096
+#define MAX_PAYLOAD     600
+#define FRAME_CAP       1024
+#define STREAM_MAX      (MAX_FRAMES * (2 * MAX_PAYLOAD + 8))
+#define BENCH_SPAN      4096
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        g_failures++; \
+        printf("  FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+/* ==================== Frame collector ==================== */
+
+typedef struct {
+    uint8_t data[MAX_PAYLOAD + 16];
+    size_t len;
+    frame_error_t error;
+    bool in_place;
+} got_frame_t;
+
+static got_frame_t g_got[MAX_FRAMES];
+static size_t g_got_count = 0;
+
+static void collect(const frame_t *frame, void *user)
+{
+    if (g_got_count >= MAX_FRAMES) return;
+    got_frame_t *got = &g_got[g_got_count++];
+    got->len = frame->len < sizeof(got->data) ? frame->len : sizeof(got->data);
+    memcpy(got->data, frame->data, got->len);
+    got->error = frame->error;
+    got->in_place = frame->in_place;
+}
+
+static uint32_t g_seed = 12345;
+
+static uint32_t rnd(void)
+{
+    g_seed = g_seed * 1103515245u + 12345u;
+    return g_seed >> 8;
+}
+
+/**
+ * @brief Feed a stream in random pieces, each overwritten once the parser is done with it
+ */
+static void feed_pieces(frame_parser_t *p, const uint8_t *stream, size_t len, size_t max_piece)
+{
+    static uint8_t scratch[FRAME_CAP * 4];
+    size_t pos = 0;
+    while (pos < len) {
+        size_t n = 1 + rnd() % max_piece;
+        if (n > len - pos) n = len - pos;
+        if (n > sizeof(scratch)) n = sizeof(scratch);
+        memcpy(scratch, stream + pos, n);
+        frame_parser_feed(p, scratch, n);
+        frame_parser_sync(p);
+        memset(scratch, 0xA5, n);
+        pos += n;
+    }
+}
+
+/* ==================== Encoders ==================== */
+
+static size_t slip_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0xC0) { out[n++] = 0xDB; out[n++] = 0xDC; }
+        else if (in[i] == 0xDB) { out[n++] = 0xDB; out[n++] = 0xDD; }
+        else out[n++] = in[i];
+    }
+    out[n++] = 0xC0;
+    return n;
+}
+
+static size_t cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t n = 1, code_pos = 0;
+    uint8_t code = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code_pos] = code;
+            code_pos = n++;
+            code = 1;
+        } else {
+            out[n++] = in[i];
+            if (++code == 0xFF) {
+                out[code_pos] = code;
+                code_pos = n++;
+                code = 1;
+            }
+        }
+    }
+    out[code_pos] = code;
+    out[n++] = 0;
+    return n;
+}
+
+static size_t modbus_build(const uint8_t *pdu, size_t len, uint8_t address, uint8_t *out)
+{
+    out[0] = address;
+    memcpy(out + 1, pdu, len);
+    uint16_t crc = frame_modbus_crc16(out, len + 1);
+    out[len + 1] = crc & 0xFF;
+    out[len + 2] = crc >> 8;
+    return len + 3;
+}
+
+/* Random payload; some all zero, some without zeros, long nonzero runs for COBS */
+static size_t random_payload(uint8_t *out, size_t max)
+{
+    size_t len = 1 + rnd() % max;
+    uint32_t kind = rnd() % 4;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t b = (uint8_t)rnd();
+        if (kind == 0) b = 0;
+        else if (kind == 1 && b == 0) b = 1;
+        else if (kind == 2) b = (rnd() % 3 == 0) ? 0xC0 : (rnd() % 3 == 0) ? 0xDB : b;
+        out[i] = b;
+    }
+    return len;
+}
+
+/* ==================== Tests ==================== */
+
+static frame_parser_t g_parser;
+static uint8_t g_buf[FRAME_CAP];
+static uint8_t g_stream[STREAM_MAX];
+static uint8_t g_payloads[MAX_FRAMES][MAX_PAYLOAD];
+static size_t g_payload_len[MAX_FRAMES];
+
+static void start(const frame_decoder_t *decoder, size_t cap)
+{
+    frame_parser_init(&g_parser, decoder, g_buf, cap, collect, NULL);
+    g_got_count = 0;
+}
+
+static void test_line(void)
+{
+    start(&frame_decoder_line, FRAME_CAP);
+    static const char text[] = "first\r\nsecond\n\n\r\nthird";
+    frame_parser_feed(&g_parser, (const uint8_t *)text, strlen(text));
+    frame_parser_sync(&g_parser);
+    frame_parser_feed(&g_parser, (const uint8_t *)" part\n", 6);
+
+    CHECK(g_got_count == 3, "got %zu lines", g_got_count);
+    CHECK(g_got[0].len == 5 && memcmp(g_got[0].data, "first", 5) == 0 && g_got[0].in_place, "line 1");
+    CHECK(g_got[1].len == 6 && memcmp(g_got[1].data, "second", 6) == 0 && g_got[1].in_place, "line 2");
+    CHECK(g_got[2].len == 10 && memcmp(g_got[2].data, "third part", 10) == 0 && !g_got[2].in_place, "line 3");
+
+    // Random lines in random pieces
+    start(&frame_decoder_line, FRAME_CAP);
+    size_t n = 0, count = 2000;
+    for (size_t i = 0; i < count; i++) {
+        size_t len = 1 + rnd() % 200;
+        for (size_t k = 0; k < len; k++) g_payloads[i][k] = (uint8_t)(' ' + rnd() % 94);
+        g_payload_len[i] = len;
+        memcpy(g_stream + n, g_payloads[i], len);
+        n += len;
+        if (rnd() & 1) g_stream[n++] = '\r';
+        g_stream[n++] = '\n';
+    }
+    feed_pieces(&g_parser, g_stream, n, 700);
+    CHECK(g_got_count == count, "got %zu of %zu lines", g_got_count, count);
+    size_t bad = 0;
+    for (size_t i = 0; i < g_got_count && i < count; i++) {
+        if (g_got[i].len != g_payload_len[i] || memcmp(g_got[i].data, g_payloads[i], g_payload_len[i]) != 0 ||
+            g_got[i].error != FRAME_OK) bad++;
+    }
+    CHECK(bad == 0, "%zu corrupt lines", bad);
+    printf("  line: %zu frames, %u in place\n", g_got_count, (unsigned)g_parser.stats.in_place);
+}
+
+static void test_slip(void)
+{
+    start(&frame_decoder_slip, FRAME_CAP);
+    size_t n = 0, count = 2000;
+    g_stream[n++] = 0xC0;   // Leading END flushes line noise
+    for (size_t i = 0; i < count; i++) {
+        g_payload_len[i] = random_payload(g_payloads[i], MAX_PAYLOAD);
+        n += slip_encode(g_payloads[i], g_payload_len[i], g_stream + n);
+    }
+    feed_pieces(&g_parser, g_stream, n, 900);
+    CHECK(g_got_count == count, "got %zu of %zu frames", g_got_count, count);
+    size_t bad = 0;
+    for (size_t i = 0; i < g_got_count && i < count; i++) {
+        if (g_got[i].len != g_payload_len[i] || memcmp(g_got[i].data, g_payloads[i], g_payload_len[i]) != 0 ||
+            g_got[i].error != FRAME_OK) bad++;
+    }
+    CHECK(bad == 0, "%zu corrupt frames", bad);
+    printf("  slip: %zu frames, %u in place\n", g_got_count, (unsigned)g_parser.stats.in_place);
+
+    // ESC followed by a plain byte: reported, then the next frame is clean
+    start(&frame_decoder_slip, FRAME_CAP);
+    static const uint8_t bad_escape[] = { 'a', 0xDB, 'x', 'b', 0xC0, 'o', 'k', 0xC0 };
+    frame_parser_feed(&g_parser, bad_escape, sizeof(bad_escape));
+    CHECK(g_got_count == 2, "got %zu frames", g_got_count);
+    CHECK(g_got[0].error == FRAME_ERR_ESCAPE, "escape error not reported");
+    CHECK(g_got[1].error == FRAME_OK && g_got[1].len == 2 && memcmp(g_got[1].data, "ok", 2) == 0, "no resync");
+}
+
+static void test_cobs(void)
+{
+    start(&frame_decoder_cobs, FRAME_CAP);
+    size_t n = 0, count = 2000;
+    for (size_t i = 0; i < count; i++) {
+        g_payload_len[i] = random_payload(g_payloads[i], MAX_PAYLOAD);
+        n += cobs_encode(g_payloads[i], g_payload_len[i], g_stream + n);
+    }
+    feed_pieces(&g_parser, g_stream, n, 900);
+    CHECK(g_got_count == count, "got %zu of %zu frames", g_got_count, count);
+    size_t bad = 0;
+    for (size_t i = 0; i < g_got_count && i < count; i++) {
+        if (g_got[i].len != g_payload_len[i] || memcmp(g_got[i].data, g_payloads[i], g_payload_len[i]) != 0 ||
+            g_got[i].error != FRAME_OK) bad++;
+    }
+    CHECK(bad == 0, "%zu corrupt frames", bad);
+    printf("  cobs: %zu frames\n", g_got_count);
+
+    // Known vector: 11 22 00 33 -> 03 11 22 02 33 00
+    start(&frame_decoder_cobs, FRAME_CAP);
+    static const uint8_t vector[] = { 0x03, 0x11, 0x22, 0x02, 0x33, 0x00 };
+    frame_parser_feed(&g_parser, vector, sizeof(vector));
+    CHECK(g_got_count == 1 && g_got[0].len == 4 && memcmp(g_got[0].data, "\x11\x22\x00\x33", 4) == 0, "vector");
+
+    // Delimiter inside a block: reported, next frame clean
+    start(&frame_decoder_cobs, FRAME_CAP);
+    static const uint8_t truncated[] = { 0x05, 0x11, 0x22, 0x00, 0x02, 0x44, 0x00 };
+    frame_parser_feed(&g_parser, truncated, sizeof(truncated));
+    CHECK(g_got_count == 2, "got %zu frames", g_got_count);
+    CHECK(g_got[0].error == FRAME_ERR_COBS, "truncated block not reported");
+    CHECK(g_got[1].error == FRAME_OK && g_got[1].len == 1 && g_got[1].data[0] == 0x44, "no resync");
+}
+
+static void test_modbus(void)
+{
+    // Known vector: read 10 holding registers from 1 -> CRC C5 CD
+    static const uint8_t request[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x0A, 0xC5, 0xCD };
+    CHECK(frame_modbus_crc16(request, 6) == 0xCDC5, "crc %04X", frame_modbus_crc16(request, 6));
+
+    start(&frame_decoder_modbus_rtu, FRAME_CAP);
+    frame_parser_feed(&g_parser, request, sizeof(request));
+    frame_parser_gap(&g_parser);
+    frame_parser_sync(&g_parser);
+    CHECK(g_got_count == 1 && g_got[0].error == FRAME_OK && g_got[0].in_place && g_got[0].len == 8, "request");
+
+    // Random ADUs in random pieces, a gap after each; every 7th corrupted
+    start(&frame_decoder_modbus_rtu, FRAME_CAP);
+    size_t count = 2000, corrupted = 0;
+    uint8_t adu[FRAME_MODBUS_MAX];
+    for (size_t i = 0; i < count; i++) {
+        uint8_t pdu[253];
+        size_t len = 1 + rnd() % 253;
+        for (size_t k = 0; k < len; k++) pdu[k] = (uint8_t)rnd();
+        size_t n = modbus_build(pdu, len, (uint8_t)(1 + rnd() % 247), adu);
+        if (i % 7 == 3) {
+            adu[rnd() % n] ^= (uint8_t)(1 + rnd() % 255);
+            corrupted++;
+        }
+        memcpy(g_payloads[i], adu, n);
+        g_payload_len[i] = n;
+        if (i & 1) {
+            // Whole ADU up to its gap in one span: reported in place
+            static uint8_t span[FRAME_MODBUS_MAX];
+            memcpy(span, adu, n);
+            frame_parser_feed(&g_parser, span, n);
+            frame_parser_gap(&g_parser);
+            frame_parser_sync(&g_parser);
+            memset(span, 0xA5, n);
+        } else {
+            feed_pieces(&g_parser, adu, n, 40);
+            frame_parser_gap(&g_parser);
+        }
+    }
+    CHECK(g_got_count == count, "got %zu of %zu frames", g_got_count, count);
+    size_t crc_errors = 0, bad = 0;
+    for (size_t i = 0; i < g_got_count && i < count; i++) {
+        if (g_got[i].error == FRAME_ERR_CRC) crc_errors++;
+        if (g_got[i].len != g_payload_len[i] || memcmp(g_got[i].data, g_payloads[i], g_payload_len[i]) != 0) bad++;
+        if ((i % 7 == 3) != (g_got[i].error == FRAME_ERR_CRC)) bad++;
+    }
+    CHECK(crc_errors == corrupted && bad == 0, "%zu CRC errors for %zu corrupted, %zu wrong", crc_errors, corrupted, bad);
+    printf("  modbus: %zu frames, %zu CRC errors, %u in place\n", g_got_count, crc_errors,
+           (unsigned)g_parser.stats.in_place);
+
+    // Short and oversized frames
+    start(&frame_decoder_modbus_rtu, FRAME_CAP);
+    frame_parser_feed(&g_parser, request, 3);
+    frame_parser_gap(&g_parser);
+    frame_parser_gap(&g_parser);    // Idle: nothing more to report
+    static uint8_t noise[300];
+    frame_parser_feed(&g_parser, noise, 200);
+    frame_parser_sync(&g_parser);
+    frame_parser_feed(&g_parser, noise, 100);
+    frame_parser_gap(&g_parser);
+    frame_parser_feed(&g_parser, request, sizeof(request));
+    frame_parser_gap(&g_parser);
+    CHECK(g_got_count == 3, "got %zu frames", g_got_count);
+    CHECK(g_got[0].error == FRAME_ERR_SHORT, "short not reported");
+    CHECK(g_got[1].error == FRAME_ERR_TOO_LONG && g_got[1].len == FRAME_MODBUS_MAX, "long not reported");
+    CHECK(g_got[2].error == FRAME_OK, "no resync after a long frame");
+}
+
+static void test_overflow(void)
+{
+    // A line longer than the buffer is reported once, cut; the next is whole
+    start(&frame_decoder_line, 16);
+    static const char text[] = "0123456789abcdefXYZ\nnext\n";
+    feed_pieces(&g_parser, (const uint8_t *)text, strlen(text), 5);
+    CHECK(g_got_count == 2, "got %zu lines", g_got_count);
+    CHECK(g_got[0].error == FRAME_ERR_TOO_LONG && g_got[0].len == 16 && memcmp(g_got[0].data, text, 16) == 0,
+          "overflow");
+    CHECK(g_got[1].error == FRAME_OK && g_got[1].len == 4, "no resync after overflow");
+
+    // The same through decoded bytes (COBS)
+    start(&frame_decoder_cobs, 4);
+    static const uint8_t cobs[] = { 0x07, 1, 2, 3, 4, 5, 6, 0x00, 0x02, 9, 0x00 };
+    frame_parser_feed(&g_parser, cobs, sizeof(cobs));
+    CHECK(g_got_count == 2 && g_got[0].error == FRAME_ERR_TOO_LONG && g_got[1].error == FRAME_OK, "cobs overflow");
+}
+
+static void test_describe(void)
+{
+    char row[64];
+    static const uint8_t response[] = { 0x11, 0x03, 0x04, 0x00, 0x2A, 0x01, 0x00, 0, 0 };
+    uint8_t adu[16];
+    size_t n = modbus_build(response + 1, 6, 0x11, adu);
+    frame_t frame = { adu, n, FRAME_OK, true };
+    frame_parser_init(&g_parser, &frame_decoder_modbus_rtu, g_buf, FRAME_CAP, NULL, NULL);
+    frame_parser_describe(&g_parser, &frame, row, sizeof(row));
+    CHECK(strcmp(row, "@17 fc03 Read Holding: 04 00 2A 01 00") == 0, "'%s'", row);
+
+    static const uint8_t exception[] = { 0x01, 0x83, 0x02, 0xC0, 0xF1 };
+    frame = (frame_t){ exception, sizeof(exception), FRAME_ERR_CRC, false };
+    frame_parser_describe(&g_parser, &frame, row, sizeof(row));
+    CHECK(strcmp(row, "@1 fc83 exc 02 Illegal address [CRC error]") == 0, "'%s'", row);
+
+    // Long text is cut but the error stays
+    static const char text[] = "a\tb\x01 and a long tail that does not fit the row at all";
+    frame = (frame_t){ (const uint8_t *)text, strlen(text), FRAME_ERR_TOO_LONG, false };
+    frame_parser_init(&g_parser, &frame_decoder_line, g_buf, FRAME_CAP, NULL, NULL);
+    int len = frame_parser_describe(&g_parser, &frame, row, 32);
+    CHECK(len == (int)strlen(row) && len < 32 && strstr(row, "[too long]") != NULL &&
+          strncmp(row, "a\\tb\\x01", 8) == 0, "'%s'", row);
+
+    frame = (frame_t){ (const uint8_t *)"\xC0\x01", 2, FRAME_OK, false };
+    frame_parser_init(&g_parser, &frame_decoder_slip, g_buf, FRAME_CAP, NULL, NULL);
+    frame_parser_describe(&g_parser, &frame, row, sizeof(row));
+    CHECK(strcmp(row, "2 B: C0 01") == 0, "'%s'", row);
+}
+
+/* ==================== Benchmark ==================== */
+
+static uint64_t g_bench_bytes;
+
+static void count_frame(const frame_t *frame, void *user)
+{
+    g_bench_bytes += frame->len;
+}
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Feed megabytes of a stream in ring-sized spans; gaps (Modbus) where the ADUs end
+ */
+static void bench(const char *name, const frame_decoder_t *decoder, const uint8_t *stream, size_t len,
+                  const size_t *gaps, size_t gap_count, size_t megabytes)
+{
+    frame_parser_init(&g_parser, decoder, g_buf, FRAME_CAP, count_frame, NULL);
+    g_bench_bytes = 0;
+    uint64_t fed = 0, target = (uint64_t)megabytes << 20;
+
+    double t0 = now_s();
+    while (fed < target) {
+        size_t pos = 0, next_gap = 0;
+        while (pos < len) {
+            size_t n = len - pos < BENCH_SPAN ? len - pos : BENCH_SPAN;
+            if (gaps != NULL && next_gap < gap_count && gaps[next_gap] - pos < n) {
+                n = gaps[next_gap] - pos;
+            }
+            frame_parser_feed(&g_parser, stream + pos, n);
+            pos += n;
+            if (gaps != NULL && next_gap < gap_count && gaps[next_gap] == pos) {
+                frame_parser_gap(&g_parser);
+                next_gap++;
+            }
+            frame_parser_sync(&g_parser);
+        }
+        fed += len;
+    }
+    double elapsed = now_s() - t0;
+
+    printf("%-7s %8.1f MB/s %10.0f frames/s  %5.1f%% in place  %u errors\n", name,
+           fed / elapsed / 1048576.0, g_parser.stats.frames / elapsed,
+           100.0 * g_parser.stats.in_place / (g_parser.stats.frames ? g_parser.stats.frames : 1),
+           (unsigned)g_parser.stats.errors);
+}
+
+static int run_bench(size_t megabytes)
+{
+    static uint8_t payload[MAX_PAYLOAD];
+    static size_t gaps[MAX_FRAMES * 4];
+    size_t n, count;
+
+    // Lines of 20..120 characters
+    n = 0;
+    while (n < STREAM_MAX - 200) {
+        size_t len = 20 + rnd() % 100;
+        for (size_t k = 0; k < len; k++) g_stream[n++] = (uint8_t)(' ' + rnd() % 94);
+        g_stream[n++] = '\r';
+        g_stream[n++] = '\n';
+    }
+    bench("line", &frame_decoder_line, g_stream, n, NULL, 0, megabytes);
+
+    // SLIP / COBS frames of 16..256 random bytes
+    n = 0;
+    while (n < STREAM_MAX - 2 * MAX_PAYLOAD) {
+        size_t len = 16 + rnd() % 240;
+        for (size_t k = 0; k < len; k++) payload[k] = (uint8_t)rnd();
+        n += slip_encode(payload, len, g_stream + n);
+    }
+    bench("slip", &frame_decoder_slip, g_stream, n, NULL, 0, megabytes);
+
+    n = 0;
+    while (n < STREAM_MAX - 2 * MAX_PAYLOAD) {
+        size_t len = 16 + rnd() % 240;
+        for (size_t k = 0; k < len; k++) payload[k] = (uint8_t)rnd();
+        n += cobs_encode(payload, len, g_stream + n);
+    }
+    bench("cobs", &frame_decoder_cobs, g_stream, n, NULL, 0, megabytes);
+
+    // Modbus ADUs of 8..256 bytes, a gap after each
+    n = 0;
+    count = 0;
+    while (n < STREAM_MAX - FRAME_MODBUS_MAX && count < sizeof(gaps) / sizeof(gaps[0])) {
+        size_t len = 5 + rnd() % 249;
+        for (size_t k = 0; k < len; k++) payload[k] = (uint8_t)rnd();
+        n += modbus_build(payload, len, 1, g_stream + n);
+        gaps[count++] = n;
+    }
+    bench("modbus", &frame_decoder_modbus_rtu, g_stream, n, gaps, count, megabytes);
+
+    // Rows for the receive view
+    char row[96];
+    uint8_t adu[16];
+    size_t len = modbus_build((const uint8_t *)"\x03\x04\x00\x2A\x01\x00", 6, 17, adu);
+    frame_t frame = { adu, len, FRAME_OK, true };
+    frame_parser_init(&g_parser, &frame_decoder_modbus_rtu, g_buf, FRAME_CAP, NULL, NULL);
+    size_t rows = 2000000;
+    double t0 = now_s();
+    for (size_t i = 0; i < rows; i++) {
+        adu[3] = (uint8_t)i;
+        frame_parser_describe(&g_parser, &frame, row, sizeof(row));
+    }
+    printf("%-7s %8.0f rows/s (%s)\n", "describe", rows / (now_s() - t0), row);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        return run_bench(argc > 2 ? (size_t)atoi(argv[2]) : 64);
+    }
+
+    test_line();
+    test_slip();
+    test_cobs();
+    test_modbus();
+    test_overflow();
+    test_describe();
+
+    printf("%s (%d failure%s)\n", g_failures ? "FAILED" : "passed", g_failures, g_failures == 1 ? "" : "s");
+    return g_failures ? 1 : 0;
+}
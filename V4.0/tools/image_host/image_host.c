@@ -0,0 +1,542 @@
+/**
+ * @file image_host.c
+ * @brief Image codec on the host: round-trip tests and an encode/decode benchmark
+ *
+ * Runs the device's image_codec.c and image_zlib.c unchanged. The tests
+ * encode synthetic RGB565 images (noise, gradients, flat fields, odd widths)
+ * in every format and PNG level through image_encoder_fill() with random
+ * buffer sizes, as the storage writer hands them out, decode the files again
+ * and require the exact source pixels back. PNGs built here with every
+ * filter type and colour type check the decoder paths the encoder never
+ * produces; damaged files must fail cleanly.
+ *
+ * The benchmark takes raw RGB565 screen snapshots named *_<w>x<h>.rgb565
+ * and reports, per format, encode time, file size against BMP and decode
+ * time.
+ *
+ *   ./image_host                          # tests, exit status 1 on failure
+ *   ./image_host --bench [runs] FILE...   # benchmark (best of runs, default 5)
+ */
+
+#include "image_codec.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WRITER_BUFFER   (32 * 1024)     // STORAGE_WRITER_BUF_SIZE
+#define TMP_FILE        "image_host.tmp"
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        g_failures++; \
+        printf("  FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+typedef struct {
+    const uint16_t *pixels;
+    int width;
+} source_t;
+
+static const uint16_t *source_row(void *user, int y)
+{
+    source_t *src = (source_t *)user;
+    return src->pixels + (size_t)y * src->width;
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Encode into memory the way the storage writer drives a fill function */
+static uint8_t *encode(image_format_t format, int level, const uint16_t *pixels, int w, int h,
+                       size_t max_piece, size_t *out_len)
+{
+    source_t src = {pixels, w};
+    image_encoder_t enc;
+    if (image_encoder_init(&enc, format, level, w, h, source_row, &src) != ESP_OK) {
+        return NULL;
+    }
+
+    size_t min = image_encoder_min_buffer(&enc);
+    size_t cap = 4096 + (size_t)w * h * 4;
+    uint8_t *out = malloc(cap);
+    size_t used = 0;
+
+    for (;;) {
+        size_t size = max_piece;
+        if (max_piece == 0) {
+            size = min + (size_t)rand() % (WRITER_BUFFER - min + 1);
+        }
+        if (size > cap - used) size = cap - used;
+
+        size_t len = 0;
+        esp_err_t ret = image_encoder_fill(&enc, out + used, size, &len);
+        if (ret != ESP_OK) {
+            free(out);
+            out = NULL;
+            break;
+        }
+        if (len == 0) break;
+        used += len;
+    }
+
+    if (out != NULL && image_encoder_bytes(&enc) != used) {
+        free(out);
+        out = NULL;
+    }
+    image_encoder_deinit(&enc);
+    *out_len = used;
+    return out;
+}
+
+static void write_file(const char *path, const uint8_t *data, size_t len)
+{
+    FILE *f = fopen(path, "wb");
+    fwrite(data, 1, len, f);
+    fclose(f);
+}
+
+/* Decode a file; returns pixels (caller frees) or NULL with *err set */
+static uint16_t *decode(const char *path, int *w, int *h, esp_err_t *err)
+{
+    image_decoder_t dec;
+    *err = image_decoder_open(&dec, path);
+    if (*err != ESP_OK) return NULL;
+
+    *w = dec.width;
+    *h = dec.height;
+    uint16_t *pixels = malloc((size_t)dec.width * dec.height * sizeof(uint16_t));
+    *err = image_decoder_read(&dec, pixels);
+    image_decoder_close(&dec);
+    if (*err != ESP_OK) {
+        free(pixels);
+        return NULL;
+    }
+    return pixels;
+}
+
+/* ---------------------------------------------------------------- Test images */
+
+enum { PATTERN_NOISE, PATTERN_GRADIENT, PATTERN_FLAT, PATTERN_UI, PATTERN_COUNT };
+
+static const char *const s_pattern_names[PATTERN_COUNT] = {"noise", "gradient", "flat", "ui"};
+
+static uint16_t *make_image(int pattern, int w, int h)
+{
+    uint16_t *p = malloc((size_t)w * h * sizeof(uint16_t));
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            uint16_t v;
+            switch (pattern) {
+            case PATTERN_NOISE:    v = (uint16_t)rand(); break;
+            case PATTERN_GRADIENT: v = (uint16_t)(((x * 31 / w) << 11) | ((y * 63 / h) << 5) | ((x + y) & 31)); break;
+            case PATTERN_FLAT:     v = 0x0000; break;
+            default:
+                /* Flat panels and text-like speckle, the shape of a UI screen */
+                v = ((x / 40 + y / 30) & 1) ? 0xFFFF : 0x2945;
+                if ((x * 7 + y * 13) % 53 == 0) v = (uint16_t)rand();
+                break;
+            }
+            p[(size_t)y * w + x] = v;
+        }
+    }
+    return p;
+}
+
+static int level_count(image_format_t format)
+{
+    return format == IMAGE_FORMAT_PNG ? IMAGE_DEFLATE_MAX_LEVEL + 1 : 1;
+}
+
+static void test_round_trip(void)
+{
+    static const int sizes[][2] = {{1, 1}, {1, 7}, {3, 2}, {5, 5}, {17, 9}, {255, 3}, {1023, 17}, {1024, 600}};
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int w = sizes[s][0], h = sizes[s][1];
+        for (int pattern = 0; pattern < PATTERN_COUNT; pattern++) {
+            uint16_t *src = make_image(pattern, w, h);
+            for (int format = 0; format < IMAGE_FORMAT_COUNT; format++) {
+                for (int level = 0; level < level_count(format); level++) {
+                    size_t len;
+                    uint8_t *file = encode(format, level, src, w, h, 0, &len);
+                    CHECK(file != NULL, "%s L%d %dx%d %s: encode failed", image_format_name(format),
+                          level, w, h, s_pattern_names[pattern]);
+                    if (file == NULL) continue;
+
+                    write_file(TMP_FILE, file, len);
+                    int dw = 0, dh = 0;
+                    esp_err_t err;
+                    uint16_t *back = decode(TMP_FILE, &dw, &dh, &err);
+                    CHECK(back != NULL && dw == w && dh == h &&
+                          memcmp(back, src, (size_t)w * h * sizeof(uint16_t)) == 0,
+                          "%s L%d %dx%d %s: round trip differs (err 0x%x)", image_format_name(format),
+                          level, w, h, s_pattern_names[pattern], err);
+                    free(back);
+                    free(file);
+                }
+            }
+            free(src);
+        }
+    }
+}
+
+/* Every piece size from the minimum up gives the same file */
+static void test_piece_sizes(void)
+{
+    int w = 97, h = 13;
+    uint16_t *src = make_image(PATTERN_UI, w, h);
+
+    for (int format = 0; format < IMAGE_FORMAT_COUNT; format++) {
+        int level = format == IMAGE_FORMAT_PNG ? 6 : 0;
+        size_t ref_len;
+        uint8_t *ref = encode(format, level, src, w, h, WRITER_BUFFER, &ref_len);
+
+        source_t s = {src, w};
+        image_encoder_t enc;
+        image_encoder_init(&enc, format, level, w, h, source_row, &s);
+        size_t min = image_encoder_min_buffer(&enc);
+        size_t len = 0;
+        uint8_t small[64];
+        CHECK(image_encoder_fill(&enc, small, 8, &len) == ESP_ERR_INVALID_SIZE,
+              "%s: 8-byte buffer accepted", image_format_name(format));
+        image_encoder_deinit(&enc);
+
+        for (size_t piece = min; piece < min + 64; piece++) {
+            size_t n;
+            uint8_t *file = encode(format, level, src, w, h, piece, &n);
+            /* PNG chunks split differently; compare the decoded image instead */
+            bool same = file != NULL;
+            if (same && format != IMAGE_FORMAT_PNG) {
+                same = n == ref_len && memcmp(file, ref, n) == 0;
+            } else if (same) {
+                write_file(TMP_FILE, file, n);
+                int dw, dh;
+                esp_err_t err;
+                uint16_t *back = decode(TMP_FILE, &dw, &dh, &err);
+                same = back != NULL && memcmp(back, src, (size_t)w * h * 2) == 0;
+                free(back);
+            }
+            CHECK(same, "%s: piece %zu differs", image_format_name(format), piece);
+            free(file);
+        }
+        free(ref);
+    }
+    free(src);
+}
+
+/* ---------------------------------------------------------------- Foreign PNGs */
+
+static uint32_t crc_table[256];
+
+static uint32_t crc32_host(const uint8_t *p, size_t n)
+{
+    if (crc_table[1] == 0) {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            crc_table[i] = c;
+        }
+    }
+    uint32_t c = 0xFFFFFFFFu;
+    while (n--) c = crc_table[(c ^ *p++) & 0xFF] ^ (c >> 8);
+    return ~c;
+}
+
+static size_t chunk(uint8_t *out, const char *type, const uint8_t *data, size_t len)
+{
+    out[0] = len >> 24; out[1] = len >> 16; out[2] = len >> 8; out[3] = len;
+    memcpy(out + 4, type, 4);
+    memcpy(out + 8, data, len);
+    uint32_t crc = crc32_host(out + 4, len + 4);
+    out[8 + len] = crc >> 24; out[9 + len] = crc >> 16; out[10 + len] = crc >> 8; out[11 + len] = crc;
+    return len + 12;
+}
+
+static int paeth_host(int a, int b, int c)
+{
+    int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+}
+
+/*
+ * PNG with the given colour type, every row filtered with filter (y % 5 when
+ * filter < 0), split into IDAT chunks of idat_split bytes. Returns the file
+ * length; expected receives the RGB565 pixels a decoder must produce.
+ */
+static size_t build_png(uint8_t *file, int color, int filter, int level, size_t idat_split,
+                        int w, int h, uint16_t *expected)
+{
+    static const int channels[7] = {1, 0, 3, 1, 2, 0, 4};
+    int bpp = channels[color];
+    size_t stride = (size_t)w * bpp;
+    uint8_t *raw = calloc((stride + 1) * h, 1);
+    uint8_t *prior = calloc(stride, 1);
+    uint8_t *cur = malloc(stride);
+    uint16_t palette[256];
+    uint8_t plte[768];
+
+    for (int i = 0; i < 256; i++) {
+        uint8_t r = rand(), g = rand(), b = rand();
+        plte[3 * i] = r; plte[3 * i + 1] = g; plte[3 * i + 2] = b;
+        palette[i] = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+    }
+
+    for (int y = 0; y < h; y++) {
+        for (size_t i = 0; i < stride; i++) {
+            cur[i] = (uint8_t)((i * 7 + y * 3) / 5 + (rand() % 3));
+        }
+        for (int x = 0; x < w; x++) {
+            const uint8_t *p = cur + (size_t)x * bpp;
+            uint16_t v;
+            switch (color) {
+            case 0: case 4: v = ((p[0] >> 3) << 11) | ((p[0] >> 2) << 5) | (p[0] >> 3); break;
+            case 3:         v = palette[p[0]]; break;
+            default:        v = ((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3); break;
+            }
+            expected[(size_t)y * w + x] = v;
+        }
+
+        int type = filter >= 0 ? filter : y % 5;
+        uint8_t *out = raw + (size_t)y * (stride + 1);
+        out[0] = type;
+        for (size_t i = 0; i < stride; i++) {
+            int a = i >= (size_t)bpp ? cur[i - bpp] : 0;
+            int b = prior[i];
+            int c = i >= (size_t)bpp ? prior[i - bpp] : 0;
+            int pred = 0;
+            switch (type) {
+            case 1: pred = a; break;
+            case 2: pred = b; break;
+            case 3: pred = (a + b) / 2; break;
+            case 4: pred = paeth_host(a, b, c); break;
+            }
+            out[1 + i] = (uint8_t)(cur[i] - pred);
+        }
+        memcpy(prior, cur, stride);
+    }
+
+    image_deflate_t *z = malloc(sizeof(*z));
+    size_t raw_len = (stride + 1) * h;
+    uint8_t *zdata = malloc(raw_len * 2 + 64);
+    image_deflate_init(z, level);
+    size_t zlen = image_deflate_write(z, raw, raw_len, zdata);
+    zlen += image_deflate_finish(z, zdata + zlen);
+
+    static const uint8_t sig[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t ihdr[13] = {w >> 24, w >> 16, w >> 8, w, h >> 24, h >> 16, h >> 8, h, 8, color, 0, 0, 0};
+    size_t n = 0;
+    memcpy(file, sig, 8);
+    n = 8;
+    n += chunk(file + n, "IHDR", ihdr, 13);
+    n += chunk(file + n, "tEXt", (const uint8_t *)"Comment\0host", 12);
+    if (color == 3) n += chunk(file + n, "PLTE", plte, sizeof(plte));
+    for (size_t off = 0; off < zlen; off += idat_split) {
+        size_t len = zlen - off < idat_split ? zlen - off : idat_split;
+        n += chunk(file + n, "IDAT", zdata + off, len);
+    }
+    n += chunk(file + n, "IEND", NULL, 0);
+
+    free(z);
+    free(zdata);
+    free(raw);
+    free(prior);
+    free(cur);
+    return n;
+}
+
+static void test_foreign_png(void)
+{
+    static const int colors[] = {0, 2, 3, 4, 6};
+    int w = 61, h = 23;
+    uint16_t *expected = malloc((size_t)w * h * 2);
+    uint8_t *file = malloc(256 * 1024);
+
+    for (size_t c = 0; c < sizeof(colors) / sizeof(colors[0]); c++) {
+        for (int filter = -1; filter <= 4; filter++) {
+            for (int level = 0; level <= 6; level += 6) {
+                size_t split = (filter & 1) ? 7 : 100000;
+                size_t len = build_png(file, colors[c], filter, level, split, w, h, expected);
+                write_file(TMP_FILE, file, len);
+
+                int dw, dh;
+                esp_err_t err;
+                uint16_t *back = decode(TMP_FILE, &dw, &dh, &err);
+                CHECK(back != NULL && memcmp(back, expected, (size_t)w * h * 2) == 0,
+                      "colour %d filter %d level %d: decode differs (err 0x%x)", colors[c], filter, level, err);
+                free(back);
+            }
+        }
+    }
+    free(expected);
+    free(file);
+}
+
+/* Truncated and corrupted files fail without crashing */
+static void test_damaged(void)
+{
+    int w = 64, h = 32;
+    uint16_t *src = make_image(PATTERN_GRADIENT, w, h);
+
+    for (int format = 0; format < IMAGE_FORMAT_COUNT; format++) {
+        size_t len;
+        uint8_t *file = encode(format, 6, src, w, h, WRITER_BUFFER, &len);
+        int dw, dh;
+        esp_err_t err;
+
+        write_file(TMP_FILE, file, len / 2);
+        uint16_t *back = decode(TMP_FILE, &dw, &dh, &err);
+        CHECK(back == NULL && err == ESP_ERR_INVALID_ARG, "%s: truncated file accepted (err 0x%x)",
+              image_format_name(format), err);
+        free(back);
+
+        write_file(TMP_FILE, file, 10);
+        back = decode(TMP_FILE, &dw, &dh, &err);
+        CHECK(back == NULL && err == ESP_ERR_INVALID_ARG, "%s: header-only file accepted",
+              image_format_name(format));
+        free(back);
+
+        if (format == IMAGE_FORMAT_PNG) {
+            file[len / 2] ^= 0x55;                  /* Inside the compressed data */
+            write_file(TMP_FILE, file, len);
+            back = decode(TMP_FILE, &dw, &dh, &err);
+            CHECK(back == NULL, "PNG: corrupt data accepted");
+            free(back);
+        }
+        free(file);
+    }
+
+    esp_err_t err;
+    int dw, dh;
+    CHECK(decode("no-such-file", &dw, &dh, &err) == NULL && err == ESP_ERR_NOT_FOUND, "missing file");
+    free(src);
+}
+
+/* ---------------------------------------------------------------- Benchmark */
+
+static int bench(int runs, int argc, char **argv)
+{
+    static const struct { image_format_t format; int level; } configs[] = {
+        {IMAGE_FORMAT_BMP, 0}, {IMAGE_FORMAT_QOI, 0},
+        {IMAGE_FORMAT_PNG, 0}, {IMAGE_FORMAT_PNG, 1}, {IMAGE_FORMAT_PNG, 2}, {IMAGE_FORMAT_PNG, 3},
+        {IMAGE_FORMAT_PNG, 4}, {IMAGE_FORMAT_PNG, 5}, {IMAGE_FORMAT_PNG, 6},
+    };
+    enum { CONFIGS = sizeof(configs) / sizeof(configs[0]) };
+    double enc_total[CONFIGS] = {0}, dec_total[CONFIGS] = {0};
+    uint64_t size_total[CONFIGS] = {0};
+    int files = 0;
+
+    printf("%-26s %-6s %9s %7s %9s %9s\n", "file", "format", "bytes", "vs BMP", "enc ms", "dec ms");
+    for (int i = 0; i < argc; i++) {
+        int w = 0, h = 0;
+        const char *dims = strrchr(argv[i], '_');
+        if (dims == NULL || sscanf(dims, "_%dx%d", &w, &h) != 2) {
+            printf("%s: name must end in _<w>x<h>.rgb565\n", argv[i]);
+            return 1;
+        }
+        FILE *f = fopen(argv[i], "rb");
+        if (f == NULL) {
+            printf("%s: cannot open\n", argv[i]);
+            return 1;
+        }
+        uint16_t *pixels = malloc((size_t)w * h * 2);
+        size_t got = fread(pixels, 2, (size_t)w * h, f);
+        fclose(f);
+        if (got != (size_t)w * h) {
+            printf("%s: short file\n", argv[i]);
+            return 1;
+        }
+
+        const char *name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+        size_t bmp_size = 0;
+        for (int c = 0; c < CONFIGS; c++) {
+            double best_enc = 1e9, best_dec = 1e9;
+            size_t len = 0;
+            uint8_t *file = NULL;
+            for (int r = 0; r < runs; r++) {
+                free(file);
+                double t0 = now_ms();
+                file = encode(configs[c].format, configs[c].level, pixels, w, h, WRITER_BUFFER, &len);
+                double t = now_ms() - t0;
+                if (t < best_enc) best_enc = t;
+            }
+            write_file(TMP_FILE, file, len);
+            for (int r = 0; r < runs; r++) {
+                int dw, dh;
+                esp_err_t err;
+                double t0 = now_ms();
+                uint16_t *back = decode(TMP_FILE, &dw, &dh, &err);
+                double t = now_ms() - t0;
+                if (t < best_dec) best_dec = t;
+                if (back == NULL || memcmp(back, pixels, (size_t)w * h * 2) != 0) {
+                    printf("%s: %s round trip failed\n", name, image_format_name(configs[c].format));
+                    return 1;
+                }
+                free(back);
+            }
+            if (c == 0) bmp_size = len;
+
+            char fmt[8];
+            snprintf(fmt, sizeof(fmt), configs[c].format == IMAGE_FORMAT_PNG ? "%s%d" : "%s",
+                     image_format_name(configs[c].format), configs[c].level);
+            printf("%-26s %-6s %9zu %6.1f%% %9.2f %9.2f\n", c == 0 ? name : "", fmt, len,
+                   100.0 * len / bmp_size, best_enc, best_dec);
+            enc_total[c] += best_enc;
+            dec_total[c] += best_dec;
+            size_total[c] += len;
+            free(file);
+        }
+        free(pixels);
+        files++;
+    }
+
+    if (files > 1) {
+        printf("\n%-26s %-6s %9s %7s %9s %9s\n", "mean of all files", "format", "bytes", "vs BMP", "enc ms", "dec ms");
+        for (int c = 0; c < CONFIGS; c++) {
+            char fmt[8];
+            snprintf(fmt, sizeof(fmt), configs[c].format == IMAGE_FORMAT_PNG ? "%s%d" : "%s",
+                     image_format_name(configs[c].format), configs[c].level);
+            printf("%-26s %-6s %9llu %6.1f%% %9.2f %9.2f\n", "", fmt,
+                   (unsigned long long)(size_total[c] / files), 100.0 * size_total[c] / size_total[0],
+                   enc_total[c] / files, dec_total[c] / files);
+        }
+    }
+    remove(TMP_FILE);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        int runs = 5;
+        int first = 2;
+        if (argc > 2 && atoi(argv[2]) > 0) {
+            runs = atoi(argv[2]);
+            first = 3;
+        }
+        return bench(runs, argc - first, argv + first);
+    }
+
+    srand(1);
+    printf("round trip\n");
+    test_round_trip();
+    printf("piece sizes\n");
+    test_piece_sizes();
+    printf("foreign PNG\n");
+    test_foreign_png();
+    printf("damaged files\n");
+    test_damaged();
+    remove(TMP_FILE);
+
+    printf("%s (%d failures)\n", g_failures ? "FAILED" : "passed", g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Oscilloscope binary waveform (.osw) reader / converter
+
+Reads the full-depth exports written by the oscilloscope (Oscilloscope_NNN.osw
+plus its .json sidecar) and the segments of a recording
+(Oscilloscope_NNN_SSSS.osw) and converts them to CSV, WAV or NumPy (.npy).
+Only the standard library is needed; NumPy is used when installed.
+
+Usage:
+    python osc_wave.py info Oscilloscope_003.osw
+    python osc_wave.py csv  Oscilloscope_003.osw [out.csv]
+    python osc_wave.py wav  Oscilloscope_003.osw [out.wav]
+    python osc_wave.py npy  Oscilloscope_003.osw [out.npy]
+
+From Python:
+    from osc_wave import load
+    header, volts = load("Oscilloscope_003.osw")   # volts: numpy array or list
+"""
+
+import array
+import struct
+import sys
+import wave
+from pathlib import Path
+
+MAGIC = b"OSCW"
+VERSION = 1
+FORMAT_INT16 = 1
+
+# Mirrors osc_wavefile_header_t (packed, little endian)
+HEADER = struct.Struct("<4sHHHHIIId9f32s")
+HEADER_FIELDS = (
+    "magic", "version", "data_offset", "sample_format", "adc_bits",
+    "num_samples", "trigger_index", "flags", "sample_rate",
+    "volts_per_lsb", "volts_offset", "time_per_div", "volts_per_div",
+    "frequency", "vmax", "vmin", "vpp", "vrms", "timestamp",
+)
+FLAGS = {"deep": 1 << 0, "filtered": 1 << 1, "triggered": 1 << 2, "record": 1 << 3}
+
+# Mirrors osc_record_index_t (recording segments, at RECORD_INDEX_OFFSET)
+RECORD_INDEX_OFFSET = 512
+RECORD_INDEX = struct.Struct("<4sHHIIQdQQ")
+RECORD_GAP = struct.Struct("<II")
+
+try:
+    import numpy as np
+except ImportError:  # 标准库回退
+    np = None
+
+
+def read_header(path):
+    """读取并校验文件头"""
+    with open(path, "rb") as f:
+        raw = f.read(HEADER.size)
+    if len(raw) < HEADER.size:
+        raise ValueError(f"{path}: file too short")
+    header = dict(zip(HEADER_FIELDS, HEADER.unpack(raw)))
+    if header["magic"] != MAGIC or header["version"] != VERSION:
+        raise ValueError(f"{path}: not an oscilloscope waveform file")
+    if header["sample_format"] != FORMAT_INT16:
+        raise ValueError(f"{path}: unsupported sample format {header['sample_format']}")
+    header["timestamp"] = header["timestamp"].split(b"\0", 1)[0].decode("utf-8", "replace")
+    for name, bit in FLAGS.items():
+        header[name] = bool(header["flags"] & bit)
+    return header
+
+
+def read_record_index(path):
+    """读取录制分段的索引（位置, 丢失点数 的间隙列表）"""
+    with open(path, "rb") as f:
+        f.seek(RECORD_INDEX_OFFSET)
+        raw = f.read(RECORD_INDEX.size)
+        magic, version, num_gaps, segment, gap_count, first, start, lost, total = RECORD_INDEX.unpack(raw)
+        if magic != b"OSRI":
+            raise ValueError(f"{path}: missing record index")
+        gaps = [RECORD_GAP.unpack(f.read(RECORD_GAP.size)) for _ in range(num_gaps)]
+    return {"segment": segment, "gap_count": gap_count, "first_sample": first, "start_seconds": start,
+            "lost_samples": lost, "total_lost_samples": total, "gaps": gaps}
+
+
+def read_codes(path, header):
+    """读取原始 int16 采样值"""
+    count = header["num_samples"]
+    if np is not None:
+        return np.fromfile(path, dtype="<i2", count=count, offset=header["data_offset"])
+    codes = array.array("h")
+    with open(path, "rb") as f:
+        f.seek(header["data_offset"])
+        codes.fromfile(f, count)
+    if sys.byteorder != "little":
+        codes.byteswap()
+    return codes
+
+
+def load(path):
+    """返回 (header, volts)；有 NumPy 时 volts 为 float32 数组"""
+    header = read_header(path)
+    codes = read_codes(path, header)
+    scale, offset = header["volts_per_lsb"], header["volts_offset"]
+    if np is not None:
+        return header, (codes.astype(np.float32) * np.float32(scale) + np.float32(offset))
+    return header, [c * scale + offset for c in codes]
+
+
+def to_csv(path, out):
+    header, volts = load(path)
+    dt = 1.0 / header["sample_rate"]
+    with open(out, "w", newline="") as f:
+        f.write("# Oscilloscope Waveform Data\n")
+        f.write(f"# Timestamp: {header['timestamp']}\n")
+        f.write(f"# Sample Rate: {header['sample_rate']:.0f} Hz\n")
+        f.write(f"# Trigger Index: {header['trigger_index']}\n")
+        f.write(f"# Points: {header['num_samples']}\n")
+        f.write("#\n")
+        f.write("Index,Time(s),Voltage(V)\n")
+        f.writelines(f"{i},{i * dt:.9f},{v:.6f}\n" for i, v in enumerate(volts))
+
+
+def to_wav(path, out):
+    """16 位 PCM；采样值按原样写入（满量程即 ADC 满量程 x8）"""
+    header = read_header(path)
+    codes = read_codes(path, header)
+    data = codes.astype("<i2").tobytes() if np is not None else codes.tobytes()
+    rate = int(round(header["sample_rate"]))
+    with wave.open(str(out), "wb") as w:
+        w.setnchannels(1)
+        w.setsampwidth(2)
+        w.setframerate(rate)
+        w.writeframes(data)
+
+
+def to_npy(path, out):
+    """float32 电压数组（.npy 1.0 格式，无需 NumPy 也能写）"""
+    header, volts = load(path)
+    if np is not None:
+        np.save(out, volts)
+        return
+    desc = "{'descr': '<f4', 'fortran_order': False, 'shape': (%d,), }" % len(volts)
+    pad = 64 - (10 + len(desc) + 1) % 64
+    with open(out, "wb") as f:
+        f.write(b"\x93NUMPY\x01\x00")
+        f.write(struct.pack("<H", len(desc) + pad + 1))
+        f.write(desc.encode("latin1") + b" " * pad + b"\n")
+        data = array.array("f", volts)
+        if sys.byteorder != "little":
+            data.byteswap()
+        data.tofile(f)
+
+
+def print_info(path):
+    header = read_header(path)
+    for key in HEADER_FIELDS[1:]:
+        print(f"{key:14s} {header[key]}")
+    print(f"{'duration':14s} {header['num_samples'] / header['sample_rate']:.6f} s")
+    modes = ", ".join(k for k in FLAGS if header[k]) or "-"
+    print(f"{'mode':14s} {modes}")
+    if header["record"]:
+        index = read_record_index(path)
+        for key in ("segment", "first_sample", "start_seconds", "gap_count", "lost_samples", "total_lost_samples"):
+            print(f"{key:14s} {index[key]}")
+        for position, lost in index["gaps"]:
+            print(f"{'gap':14s} {lost} samples lost before {position}")
+
+
+def main(argv):
+    commands = {"csv": to_csv, "wav": to_wav, "npy": to_npy}
+    if len(argv) < 3 or argv[1] not in ("info", *commands):
+        print(__doc__)
+        return 1
+    path = Path(argv[2])
+    if argv[1] == "info":
+        print_info(path)
+        return 0
+    out = Path(argv[3]) if len(argv) > 3 else path.with_suffix("." + argv[1])
+    commands[argv[1]](path, out)
+    print(f"{path} -> {out}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
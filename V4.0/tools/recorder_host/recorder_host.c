@@ -0,0 +1,458 @@
+/**
+ * @file recorder_host.c
+ * @brief Streaming recorder on the host against a slow or stalled SD card
+ *
+ * Runs the device's oscilloscope_recorder.c unchanged on the FreeRTOS shim.
+ * The ADC stand-in pushes 64-sample blocks of a code ramp (code = recording
+ * sample number % 4096), the way adc_sampling_task calls the block hook,
+ * in real time or as one burst. fwrite() and fsync() are wrapped
+ * (-Wl,--wrap) into a simulated card with a bandwidth, a latency per write,
+ * a stall switch and an injected write error.
+ *
+ * Backpressure: an ADC task pushes 1 M samples into a card that hangs on
+ * its first write. It must finish, with exactly the pool accepted and every
+ * other sample dropped and counted per ADC block; once the card recovers
+ * the drops become one gap in the index. A card slower than the input must
+ * drop the difference at a steady card rate, and written plus dropped must
+ * always equal offered. Every segment is read back: trimmed size, header,
+ * gap index, and each sample against the ramp with the listed gaps applied,
+ * continuous across rotations by size and by rate change. A write error
+ * must end in ERROR, and the next recording must start cleanly.
+ *
+ *   ./recorder_host    # tests, exit status 1 on failure
+ */
+
+#include "oscilloscope_recorder.h"
+#include "oscilloscope_wavefile.h"
+#include "esp_timer.h"
+#include "esp_vfs_fat.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TMP_DIR         "recorder_host.tmp"
+#define ADC_BLOCK       64          // OSC_ADC_BLOCK_SIZE: samples per hook call
+#define ADC_CODES       4096
+#define POOL_BLOCKS     16
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        g_failures++; \
+        printf("  FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+/* ==================== Simulated SD card ==================== */
+
+typedef struct {
+    uint32_t latency_us;            // Per write
+    uint32_t kbps;                  // Transfer rate, 0 = unlimited
+    volatile bool stall;            // Hold writes until cleared
+    uint64_t fail_after;            // Fail the write that crosses this many bytes (0 = never)
+    uint64_t bytes;
+    uint32_t syncs;
+    uint32_t preallocs;
+} sim_card_t;
+
+static sim_card_t g_card;
+
+size_t __real_fwrite(const void *ptr, size_t size, size_t count, FILE *f);
+int __real_fsync(int fd);
+
+size_t __wrap_fwrite(const void *ptr, size_t size, size_t count, FILE *f)
+{
+    size_t len = size * count;
+    while (g_card.stall) usleep(500);
+
+    uint64_t us = g_card.latency_us;
+    if (g_card.kbps > 0) us += (uint64_t)len * 1000000 / ((uint64_t)g_card.kbps * 1024);
+    if (us > 0) usleep((useconds_t)us);
+
+    if (g_card.fail_after > 0 && g_card.bytes + len > g_card.fail_after) return 0;
+    g_card.bytes += len;
+    return __real_fwrite(ptr, size, count, f);
+}
+
+int __wrap_fsync(int fd)
+{
+    g_card.syncs++;
+    return __real_fsync(fd);
+}
+
+esp_err_t esp_vfs_fat_create_contiguous_file(const char *base_path, const char *full_path, uint64_t size,
+                                             bool alloc_now)
+{
+    int fd = open(full_path, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (fd < 0) return ESP_FAIL;
+    int ret = posix_fallocate(fd, 0, (off_t)size);
+    close(fd);
+    g_card.preallocs++;
+    return ret == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static void card_reset(uint32_t latency_us, uint32_t kbps)
+{
+    memset(&g_card, 0, sizeof(g_card));
+    g_card.latency_us = latency_us;
+    g_card.kbps = kbps;
+}
+
+/* ==================== ADC stand-in ==================== */
+
+typedef struct {
+    uint64_t offered;               // Samples pushed since the recording started
+    uint64_t pushes;
+    int64_t max_push_us;            // Wall time, preemption included
+} producer_t;
+
+/* Push count samples of the ramp in ADC-sized blocks, back to back */
+static void push_ramp(osc_recorder_ctx_t *rec, producer_t *p, uint64_t count, uint32_t rate_hz)
+{
+    uint16_t raw[ADC_BLOCK];
+    while (count > 0) {
+        uint32_t n = (count < ADC_BLOCK) ? (uint32_t)count : ADC_BLOCK;
+        for (uint32_t i = 0; i < n; i++) raw[i] = (uint16_t)((p->offered + i) % ADC_CODES);
+        int64_t t = esp_timer_get_time();
+        osc_recorder_push(rec, raw, n, rate_hz);
+        t = esp_timer_get_time() - t;
+        if (t > p->max_push_us) p->max_push_us = t;
+        p->pushes++;
+        p->offered += n;
+        count -= n;
+    }
+}
+
+/* Push the ramp in real time for ms milliseconds, as adc_sampling_task does */
+static void produce(osc_recorder_ctx_t *rec, producer_t *p, uint32_t rate_hz, uint32_t ms)
+{
+    uint64_t total = (uint64_t)rate_hz * ms / 1000;
+    uint64_t sent = 0;
+    int64_t t0 = esp_timer_get_time();
+
+    while (sent < total) {
+        uint64_t due = (uint64_t)(esp_timer_get_time() - t0) * rate_hz / 1000000;
+        if (due > total) due = total;
+        push_ramp(rec, p, due - sent, rate_hz);
+        sent = due;
+        usleep(200);
+    }
+}
+
+/* ADC task stand-in for the stall test */
+typedef struct {
+    osc_recorder_ctx_t *rec;
+    producer_t p;
+    uint64_t samples;
+    volatile bool done;
+} burst_t;
+
+static void burst_task(void *arg)
+{
+    burst_t *burst = arg;
+    push_ramp(burst->rec, &burst->p, burst->samples, 1000000);
+    burst->done = true;
+    vTaskDelete(NULL);
+}
+
+static bool wait_idle(osc_recorder_ctx_t *rec, uint32_t timeout_ms, osc_recorder_status_t *status)
+{
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    for (;;) {
+        osc_recorder_get_status(rec, status);
+        if (status->state == OSC_RECORDER_IDLE) return true;
+        if (esp_timer_get_time() > deadline) return false;
+        usleep(2000);
+    }
+}
+
+/* ==================== Segment check ==================== */
+
+typedef struct {
+    uint32_t segments;
+    uint64_t samples;
+    uint64_t lost;                  // Listed in the gap indexes
+    uint32_t gaps;
+    uint64_t first_gap_position;    // Recording sample number after the first gap
+    uint32_t first_gap_lost;
+    uint32_t rates[8];              // Sample rate of the first segments
+} segments_t;
+
+/* Read every segment back and check it against the ramp */
+static segments_t check_segments(const char *base)
+{
+    segments_t r = { 0 };
+    uint64_t next_sample = 0;       // Sample number after the previous segment
+    static uint8_t head[OSC_RECORD_DATA_OFFSET];
+    static int16_t data[OSC_RECORDER_BLOCK_SAMPLES];
+
+    for (;;) {
+        char path[128];
+        snprintf(path, sizeof(path), "%s_%04lu%s", base, (unsigned long)r.segments, OSC_WAVEFILE_EXT);
+        FILE *f = fopen(path, "rb");
+        if (f == NULL) break;
+
+        osc_wavefile_header_t h;
+        osc_record_index_t index;
+        bool ok = fread(head, 1, sizeof(head), f) == sizeof(head);
+        memcpy(&h, head, sizeof(h));
+        memcpy(&index, head + OSC_RECORD_INDEX_OFFSET, sizeof(index));
+        CHECK(ok && memcmp(h.magic, OSC_WAVEFILE_MAGIC, 4) == 0 && h.data_offset == OSC_RECORD_DATA_OFFSET &&
+              (h.flags & OSC_WAVEFILE_FLAG_RECORD), "%s: bad header", path);
+        CHECK(memcmp(index.magic, OSC_RECORD_INDEX_MAGIC, 4) == 0 && index.segment == r.segments,
+              "%s: bad index", path);
+        CHECK(index.num_gaps == index.gap_count, "%s: %u of %lu gaps listed", path, index.num_gaps,
+              (unsigned long)index.gap_count);
+
+        struct stat st;
+        fstat(fileno(f), &st);
+        CHECK(st.st_size == OSC_RECORD_DATA_OFFSET + (off_t)h.num_samples * 2, "%s: %lld bytes for %lu samples",
+              path, (long long)st.st_size, (unsigned long)h.num_samples);
+
+        // A gap at position 0 is already counted in first_sample
+        uint64_t expected = index.first_sample;
+        uint64_t lost_at_start = (index.num_gaps > 0 && index.gaps[0].position == 0) ? index.gaps[0].lost : 0;
+        CHECK(index.first_sample == next_sample + lost_at_start, "%s: first sample %llu, expected %llu", path,
+              (unsigned long long)index.first_sample, (unsigned long long)(next_sample + lost_at_start));
+
+        uint32_t gap = (lost_at_start > 0) ? 1 : 0;
+        uint32_t mismatches = 0;
+        for (uint32_t pos = 0; pos < h.num_samples;) {
+            uint32_t n = h.num_samples - pos;
+            if (n > OSC_RECORDER_BLOCK_SAMPLES) n = OSC_RECORDER_BLOCK_SAMPLES;
+            if (fread(data, sizeof(int16_t), n, f) != n) {
+                mismatches++;
+                break;
+            }
+            for (uint32_t i = 0; i < n; i++, pos++) {
+                if (gap < index.num_gaps && index.gaps[gap].position == pos) expected += index.gaps[gap++].lost;
+                if (data[i] != (int16_t)((expected % ADC_CODES) * OSC_WAVEFILE_SUBCODES)) mismatches++;
+                expected++;
+            }
+        }
+        fclose(f);
+        CHECK(mismatches == 0, "%s: %lu samples off the ramp", path, (unsigned long)mismatches);
+        CHECK(gap == index.num_gaps, "%s: %lu of %u gaps inside the data", path, (unsigned long)gap, index.num_gaps);
+
+        if (r.gaps == 0 && index.num_gaps > 0) {
+            r.first_gap_position = r.samples + index.gaps[0].position;
+            r.first_gap_lost = index.gaps[0].lost;
+        }
+        if (r.segments < 8) r.rates[r.segments] = (uint32_t)h.sample_rate;
+        next_sample = expected;
+        r.samples += h.num_samples;
+        r.lost += index.lost_samples;
+        r.gaps += index.gap_count;
+        r.segments++;
+    }
+    return r;
+}
+
+/* ==================== Tests ==================== */
+
+static osc_recorder_ctx_t *make_recorder(uint64_t segment_bytes)
+{
+    osc_recorder_config_t config;
+    osc_recorder_get_default_config(&config);
+    config.pool_blocks = POOL_BLOCKS;
+    config.segment_bytes = segment_bytes;
+    config.sync_bytes = 256 * 1024;
+    return osc_recorder_init(&config);
+}
+
+static void start(osc_recorder_ctx_t *rec, const char *name, producer_t *p)
+{
+    char base[64];
+    snprintf(base, sizeof(base), "%s/%s", TMP_DIR, name);
+    memset(p, 0, sizeof(*p));
+    CHECK(osc_recorder_start(rec, base, 3.3f / 4095.0f, 0.0f) == ESP_OK, "%s: start", name);
+}
+
+/* Stop, wait for the backlog, check the accounting and read the segments back */
+static segments_t finish(osc_recorder_ctx_t *rec, const char *name, const producer_t *p,
+                         osc_recorder_status_t *status)
+{
+    char base[64];
+    snprintf(base, sizeof(base), "%s/%s", TMP_DIR, name);
+    osc_recorder_stop(rec);
+    CHECK(wait_idle(rec, 10000, status), "%s: backlog not written", name);
+
+    CHECK(status->samples_written + status->dropped_samples == p->offered,
+          "%s: %llu written + %llu dropped != %llu offered", name, (unsigned long long)status->samples_written,
+          (unsigned long long)status->dropped_samples, (unsigned long long)p->offered);
+
+    segments_t seg = check_segments(base);
+    CHECK(seg.samples == status->samples_written, "%s: %llu samples in segments, %llu written", name,
+          (unsigned long long)seg.samples, (unsigned long long)status->samples_written);
+    CHECK(seg.lost <= status->dropped_samples, "%s: %llu lost listed, %llu dropped", name,
+          (unsigned long long)seg.lost, (unsigned long long)status->dropped_samples);
+    return seg;
+}
+
+static segments_t record(osc_recorder_ctx_t *rec, const char *name, uint32_t rate_hz, uint32_t ms,
+                         producer_t *p, osc_recorder_status_t *status)
+{
+    start(rec, name, p);
+    produce(rec, p, rate_hz, ms);
+    return finish(rec, name, p, status);
+}
+
+static void test_stalled_card(void)
+{
+    // The card hangs on the first write; an ADC task pushes 1 M samples into it
+    const uint64_t burst_samples = 1000000;
+    const uint64_t pool_samples = (uint64_t)POOL_BLOCKS * OSC_RECORDER_BLOCK_SAMPLES;
+    osc_recorder_ctx_t *rec = make_recorder(OSC_RECORDER_DEFAULT_SEGMENT);
+    CHECK(rec != NULL, "init");
+    if (rec == NULL) return;
+    card_reset(0, 0);
+    g_card.stall = true;
+
+    static burst_t burst;
+    memset(&burst, 0, sizeof(burst));
+    burst.rec = rec;
+    burst.samples = burst_samples;
+    start(rec, "stall", &burst.p);
+    CHECK(xTaskCreate(burst_task, "adc", 4096, &burst, 5, NULL) == pdPASS, "ADC task");
+    int64_t deadline = esp_timer_get_time() + 5000000;
+    while (!burst.done && esp_timer_get_time() < deadline) usleep(1000);
+    CHECK(burst.done, "the ADC task blocked on a stalled card after %llu samples",
+          (unsigned long long)burst.p.offered);
+
+    osc_recorder_status_t st;
+    osc_recorder_get_status(rec, &st);
+    uint64_t dropped = burst_samples - pool_samples;
+    printf("  stalled card: %llu pushed in %lu ADC blocks, %llu dropped in %lu, backlog %lu/%lu, "
+           "worst push %lld us\n", (unsigned long long)burst.p.offered, (unsigned long)burst.p.pushes,
+           (unsigned long long)st.dropped_samples, (unsigned long)st.dropped_blocks, (unsigned long)st.backlog,
+           (unsigned long)st.pool_blocks, (long long)burst.p.max_push_us);
+    CHECK(st.state == OSC_RECORDER_RECORDING && st.samples_written == 0, "state %d, %llu written", st.state,
+          (unsigned long long)st.samples_written);
+    CHECK(st.backlog == POOL_BLOCKS && st.backlog_peak == POOL_BLOCKS, "backlog %lu, peak %lu",
+          (unsigned long)st.backlog, (unsigned long)st.backlog_peak);
+    CHECK(st.dropped_samples == dropped && st.dropped_blocks == dropped / ADC_BLOCK,
+          "%llu samples in %lu blocks dropped, expected %llu in %llu", (unsigned long long)st.dropped_samples,
+          (unsigned long)st.dropped_blocks, (unsigned long long)dropped, (unsigned long long)(dropped / ADC_BLOCK));
+
+    // The card recovers: the backlog drains and the drops until the first free block become one gap
+    g_card.stall = false;
+    producer_t *p = &burst.p;
+    produce(rec, p, 1000000, 200);
+    segments_t seg = finish(rec, "stall", p, &st);
+    CHECK(seg.gaps == 1 && seg.first_gap_position == pool_samples && seg.first_gap_lost == st.dropped_samples,
+          "%lu gaps, first at %llu losing %lu of %llu dropped", (unsigned long)seg.gaps,
+          (unsigned long long)seg.first_gap_position, (unsigned long)seg.first_gap_lost,
+          (unsigned long long)st.dropped_samples);
+    CHECK(st.state == OSC_RECORDER_IDLE && st.last_error == ESP_OK, "state %d error %d", st.state, st.last_error);
+    osc_recorder_deinit(rec);
+}
+
+static void test_slow_card(void)
+{
+    // 1 MSa/s (1953 KB/s) into a 1200 KB/s card, then 250 kSa/s (488 KB/s) it keeps up with
+    osc_recorder_ctx_t *rec = make_recorder(OSC_RECORDER_DEFAULT_SEGMENT);
+    CHECK(rec != NULL, "init");
+    if (rec == NULL) return;
+    card_reset(0, 1200);
+
+    producer_t p;
+    osc_recorder_status_t st;
+    start(rec, "slow", &p);
+    produce(rec, &p, 1000000, 1500);
+    osc_recorder_get_status(rec, &st);
+    uint32_t recent_kbps = st.recent_kbps;
+    uint64_t fast_dropped = st.dropped_samples;
+    produce(rec, &p, 250000, 1500);
+    segments_t seg = finish(rec, "slow", &p, &st);
+
+    double drop_ratio = fast_dropped / 1500000.0;
+    printf("  slow card: %.0f%% dropped at 1 MSa/s, card %lu KB/s, %llu dropped at 250 kSa/s, "
+           "worst push %lld us\n", drop_ratio * 100.0, (unsigned long)recent_kbps,
+           (unsigned long long)(st.dropped_samples - fast_dropped), (long long)p.max_push_us);
+    // The card takes 61% of the input; the pool absorbs a little more
+    CHECK(drop_ratio > 0.25 && drop_ratio < 0.45, "dropped %.0f%% at 1 MSa/s", drop_ratio * 100.0);
+    CHECK(recent_kbps > 1000 && recent_kbps <= 1250, "card rate %lu KB/s while saturated",
+          (unsigned long)recent_kbps);
+    CHECK(seg.segments == 2 && seg.rates[0] == 1000000 && seg.rates[1] == 250000,
+          "%lu segments at %lu / %lu Hz", (unsigned long)seg.segments, (unsigned long)seg.rates[0],
+          (unsigned long)seg.rates[1]);
+    osc_recorder_deinit(rec);
+}
+
+static void test_rotation(void)
+{
+    // A fast card keeps up: no drops, 1 MB segments
+    osc_recorder_ctx_t *rec = make_recorder(1024 * 1024);
+    CHECK(rec != NULL, "init");
+    if (rec == NULL) return;
+    card_reset(0, 0);
+
+    producer_t p;
+    osc_recorder_status_t st;
+    segments_t seg = record(rec, "rotate", 1000000, 1200, &p, &st);
+
+    CHECK(st.dropped_samples == 0 && seg.gaps == 0, "%llu dropped, %lu gaps on a fast card",
+          (unsigned long long)st.dropped_samples, (unsigned long)seg.gaps);
+    CHECK(seg.segments == 3, "%lu segments for %llu samples", (unsigned long)seg.segments,
+          (unsigned long long)seg.samples);
+    CHECK(g_card.preallocs == seg.segments, "%lu preallocations", (unsigned long)g_card.preallocs);
+    CHECK(g_card.syncs >= seg.samples * 2 / (256 * 1024), "%lu syncs for %llu bytes", (unsigned long)g_card.syncs,
+          (unsigned long long)seg.samples * 2);
+    osc_recorder_deinit(rec);
+}
+
+static void test_write_error(void)
+{
+    osc_recorder_ctx_t *rec = make_recorder(OSC_RECORDER_DEFAULT_SEGMENT);
+    CHECK(rec != NULL, "init");
+    if (rec == NULL) return;
+    card_reset(0, 0);
+    g_card.fail_after = 1024 * 1024;
+
+    char base[64];
+    snprintf(base, sizeof(base), "%s/error", TMP_DIR);
+    CHECK(osc_recorder_start(rec, NULL, 0.001f, 0.0f) == ESP_ERR_INVALID_ARG, "NULL path");
+    CHECK(osc_recorder_start(rec, base, 0.0f, 0.0f) == ESP_ERR_INVALID_ARG, "zero scale");
+    CHECK(osc_recorder_start(rec, base, 0.001f, 0.0f) == ESP_OK, "start");
+    CHECK(osc_recorder_start(rec, base, 0.001f, 0.0f) == ESP_ERR_INVALID_STATE, "second start");
+
+    producer_t p = { 0 };
+    produce(rec, &p, 1000000, 1000);
+    osc_recorder_status_t st;
+    osc_recorder_get_status(rec, &st);
+    CHECK(st.state == OSC_RECORDER_ERROR && st.last_error == ESP_FAIL, "state %d error %d after a write error",
+          st.state, st.last_error);
+    CHECK(osc_recorder_start(rec, base, 0.001f, 0.0f) == ESP_ERR_INVALID_STATE, "start while in error");
+    osc_recorder_stop(rec);
+    CHECK(wait_idle(rec, 5000, &st), "not idle after stopping");
+
+    // The next recording starts cleanly
+    g_card.fail_after = 0;
+    segments_t seg = record(rec, "after_error", 500000, 300, &p, &st);
+    CHECK(st.dropped_samples == 0 && seg.segments == 1 && st.last_error == ESP_OK,
+          "after the error: %llu dropped, %lu segments, error %d", (unsigned long long)st.dropped_samples,
+          (unsigned long)seg.segments, st.last_error);
+    osc_recorder_deinit(rec);
+}
+
+int main(void)
+{
+    mkdir(TMP_DIR, 0755);
+
+    test_stalled_card();
+    test_slow_card();
+    test_rotation();
+    test_write_error();
+
+    printf("%s (%d failure%s)\n", g_failures ? "FAILED" : "passed", g_failures, g_failures == 1 ? "" : "s");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,18 @@
+/**
+ * @file esp_vfs_fat.h
+ * @brief Host stand-in for the FAT preallocation call used by the recorder
+ *
+ * Defined by the harness, which reserves the file with posix_fallocate().
+ */
+
+#ifndef RECORDER_HOST_ESP_VFS_FAT_H
+#define RECORDER_HOST_ESP_VFS_FAT_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+esp_err_t esp_vfs_fat_create_contiguous_file(const char *base_path, const char *full_path, uint64_t size,
+                                             bool alloc_now);
+
+#endif /* RECORDER_HOST_ESP_VFS_FAT_H */
@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Oscilloscope SCPI client (raw socket, port 5025)
+
+Sends commands to the oscilloscope (or to tools/scpi_host on a PC), reads
+:WAVeform:DATA? blocks and measures the transfer rate. Only the standard
+library is needed; NumPy is used when installed.
+
+Usage:
+    python scpi_client.py [--host 192.168.4.1] "*IDN?" ":TIM:SCAL 1ms" ":MEAS:VPP?"
+    python scpi_client.py --save wave.csv          # capture to CSV (time, volts)
+    python scpi_client.py --bench 20               # 20 x :WAV:DATA?, MB/s
+    python scpi_client.py --bench 20 --clients 4   # the same on 4 connections at once
+
+From Python:
+    from scpi_client import Scope
+    with Scope("192.168.4.1") as scope:
+        print(scope.query(":MEAS:FREQ?"))
+        xinc, volts = scope.waveform()
+"""
+
+import argparse
+import array
+import socket
+import sys
+import threading
+import time
+
+DEFAULT_PORT = 5025
+
+
+class Scope:
+    """One SCPI connection."""
+
+    def __init__(self, host="127.0.0.1", port=DEFAULT_PORT, timeout=10.0):
+        self.sock = socket.create_connection((host, port), timeout=timeout)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.buf = bytearray()
+
+    def close(self):
+        self.sock.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def write(self, command):
+        self.sock.sendall(command.encode("ascii") + b"\n")
+
+    def _fill(self):
+        chunk = self.sock.recv(1 << 20)
+        if not chunk:
+            raise ConnectionError("connection closed")
+        self.buf += chunk
+
+    def _read_exact(self, n):
+        while len(self.buf) < n:
+            self._fill()
+        data = bytes(self.buf[:n])
+        del self.buf[:n]
+        return data
+
+    def read_line(self):
+        while b"\n" not in self.buf:
+            self._fill()
+        line, _, rest = bytes(self.buf).partition(b"\n")
+        self.buf = bytearray(rest)
+        return line.decode("ascii").strip()
+
+    def query(self, command):
+        self.write(command)
+        return self.read_line()
+
+    def read_block(self):
+        """Read an IEEE 488.2 definite-length block: #<n><length><bytes>\\n."""
+        head = self._read_exact(2)
+        if head[:1] != b"#" or not head[1:2].isdigit() or head[1:2] == b"0":
+            raise ValueError("not a definite-length block: %r" % head)
+        length = int(self._read_exact(int(head[1:2])))
+        data = self._read_exact(length)
+        if self._read_exact(1) != b"\n":
+            raise ValueError("block not terminated")
+        return data
+
+    def query_block(self, command):
+        self.write(command)
+        return self.read_block()
+
+    def waveform(self):
+        """Return (seconds per sample, volts) of the capture shown."""
+        xinc = float(self.query(":WAV:XINC?"))
+        data = self.query_block(":WAV:DATA?")
+        volts = array.array("f")
+        volts.frombytes(data)
+        if sys.byteorder != "little":
+            volts.byteswap()
+        try:
+            import numpy as np
+            volts = np.frombuffer(volts, dtype=np.float32)
+        except ImportError:
+            pass
+        return xinc, volts
+
+    def errors(self):
+        """Drain :SYST:ERR? and return the entries."""
+        result = []
+        while True:
+            entry = self.query(":SYST:ERR?")
+            if entry.startswith("0,"):
+                return result
+            result.append(entry)
+
+
+def bench(host, port, count, results, index):
+    with Scope(host, port) as scope:
+        points = int(scope.query(":WAV:POIN?"))
+        total = 0
+        start = time.perf_counter()
+        for _ in range(count):
+            data = scope.query_block(":WAV:DATA?")
+            if len(data) != points * 4:
+                raise ValueError("got %d bytes, expected %d" % (len(data), points * 4))
+            total += len(data)
+        results[index] = (total, time.perf_counter() - start, scope.errors())
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Oscilloscope SCPI client")
+    parser.add_argument("commands", nargs="*", help="commands; queries (ending in '?') print the reply")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=DEFAULT_PORT)
+    parser.add_argument("--save", metavar="CSV", help="save :WAV:DATA? as CSV")
+    parser.add_argument("--bench", type=int, metavar="N", help="time N :WAV:DATA? transfers")
+    parser.add_argument("--clients", type=int, default=1, help="connections for --bench")
+    args = parser.parse_args()
+
+    if args.commands or args.save:
+        with Scope(args.host, args.port) as scope:
+            for line in args.commands:
+                # One reply per query of the line ("A?;B?" answers twice)
+                scope.write(line)
+                for command in line.split(";"):
+                    if command.rstrip().endswith("DATA?"):
+                        print("%d bytes" % len(scope.read_block()))
+                    elif command.rstrip().endswith("?"):
+                        print(scope.read_line())
+            if args.save:
+                xinc, volts = scope.waveform()
+                with open(args.save, "w") as f:
+                    f.write("time,volts\n")
+                    for i, v in enumerate(volts):
+                        f.write("%.9g,%.6g\n" % (i * xinc, v))
+                print("%s: %d points" % (args.save, len(volts)))
+            for entry in scope.errors():
+                print("error: " + entry, file=sys.stderr)
+
+    if args.bench:
+        results = [None] * args.clients
+        threads = [threading.Thread(target=bench, args=(args.host, args.port, args.bench, results, i))
+                   for i in range(args.clients)]
+        start = time.perf_counter()
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        elapsed = time.perf_counter() - start
+        if any(r is None for r in results):
+            sys.exit("bench failed")
+        for i, (total, seconds, errors) in enumerate(results):
+            print("client %d: %d blocks, %.1f MB in %.2f s = %.1f MB/s%s"
+                  % (i, args.bench, total / 1e6, seconds, total / 1e6 / seconds,
+                     ", errors: %s" % errors if errors else ""))
+        total = sum(r[0] for r in results)
+        print("total: %.1f MB in %.2f s = %.1f MB/s" % (total / 1e6, elapsed, total / 1e6 / elapsed))
+
+
+if __name__ == "__main__":
+    main()
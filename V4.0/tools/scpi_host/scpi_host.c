@@ -0,0 +1,201 @@
+/**
+ * @file scpi_host.c
+ * @brief SCPI server on the host, serving a synthetic capture
+ *
+ * Runs the oscilloscope's scpi_server.c unchanged against a generated
+ * 1 kHz square wave, so clients and throughput can be tested without the
+ * board. Waveform, measurement and run-state commands behave like the
+ * oscilloscope's; settings are kept locally. While a client is sending the
+ * capture, a new one is not generated (as the oscilloscope holds its display).
+ */
+
+#include "scpi_server.h"
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_POINTS      (256 * 1024)
+#define SAMPLE_RATE         1000000.0f
+#define SIGNAL_HZ           1000.0f
+
+static float *g_volts = NULL;
+static uint32_t g_points = DEFAULT_POINTS;
+static uint32_t g_generation = 0;
+static int g_pins = 0;
+static bool g_running = true;
+static float g_time_scale = 1e-3f;
+static float g_volt_scale = 1.0f;
+static float g_trigger_level = 1.65f;
+static volatile sig_atomic_t g_quit = 0;
+
+/* New capture: square wave with a little noise, phase moving each time */
+static void capture(void)
+{
+    float phase = (float)(g_generation % 100) / 100.0f;
+    for (uint32_t i = 0; i < g_points; i++) {
+        float t = (float)i / SAMPLE_RATE * SIGNAL_HZ + phase;
+        float level = (t - floorf(t)) < 0.5f ? 3.3f : 0.0f;
+        g_volts[i] = level + ((float)rand() / (float)RAND_MAX - 0.5f) * 0.02f;
+    }
+    g_generation++;
+}
+
+static esp_err_t cmd_idn(scpi_client_t *client, const char *args, void *user)
+{
+    return scpi_reply(client, "ESP32-P4,Oscilloscope,0,host");
+}
+
+static esp_err_t cmd_opc(scpi_client_t *client, const char *args, void *user)
+{
+    return scpi_reply(client, "1");
+}
+
+static esp_err_t cmd_cls(scpi_client_t *client, const char *args, void *user)
+{
+    scpi_clear_errors(client);
+    return ESP_OK;
+}
+
+static esp_err_t cmd_syst_err(scpi_client_t *client, const char *args, void *user)
+{
+    const char *message;
+    int code = scpi_pop_error(client, &message);
+    return scpi_reply(client, "%d,\"%s\"", code, message);
+}
+
+static esp_err_t cmd_run(scpi_client_t *client, const char *args, void *user)
+{
+    g_running = true;
+    return ESP_OK;
+}
+
+static esp_err_t cmd_stop(scpi_client_t *client, const char *args, void *user)
+{
+    g_running = false;
+    return ESP_OK;
+}
+
+static esp_err_t cmd_trig_status(scpi_client_t *client, const char *args, void *user)
+{
+    return scpi_reply(client, "%s", g_running ? "RUN" : "STOP");
+}
+
+/* Set or query a local setting */
+static esp_err_t setting(scpi_client_t *client, const char *args, float *value, bool query)
+{
+    if (query) return scpi_reply(client, "%.6e", *value);
+    float parsed;
+    if (!scpi_parse_number(args, &parsed)) {
+        scpi_push_error(client, SCPI_ERROR_DATA_OUT_OF_RANGE, "Data out of range");
+        return ESP_ERR_INVALID_ARG;
+    }
+    *value = parsed;
+    return ESP_OK;
+}
+
+static esp_err_t cmd_tim_scale(scpi_client_t *client, const char *args, void *user) { return setting(client, args, &g_time_scale, false); }
+static esp_err_t cmd_tim_scale_q(scpi_client_t *client, const char *args, void *user) { return setting(client, args, &g_time_scale, true); }
+static esp_err_t cmd_chan_scale(scpi_client_t *client, const char *args, void *user) { return setting(client, args, &g_volt_scale, false); }
+static esp_err_t cmd_chan_scale_q(scpi_client_t *client, const char *args, void *user) { return setting(client, args, &g_volt_scale, true); }
+static esp_err_t cmd_trig_level(scpi_client_t *client, const char *args, void *user) { return setting(client, args, &g_trigger_level, false); }
+static esp_err_t cmd_trig_level_q(scpi_client_t *client, const char *args, void *user) { return setting(client, args, &g_trigger_level, true); }
+
+static esp_err_t cmd_meas_freq(scpi_client_t *client, const char *args, void *user) { return scpi_reply(client, "%.6e", SIGNAL_HZ); }
+static esp_err_t cmd_meas_vpp(scpi_client_t *client, const char *args, void *user) { return scpi_reply(client, "%.6e", 3.3f); }
+
+static esp_err_t cmd_wav_format_q(scpi_client_t *client, const char *args, void *user)
+{
+    return scpi_reply(client, "REAL");
+}
+
+static esp_err_t cmd_wav_points(scpi_client_t *client, const char *args, void *user)
+{
+    return scpi_reply(client, "%u", g_points);
+}
+
+static esp_err_t cmd_wav_xinc(scpi_client_t *client, const char *args, void *user)
+{
+    return scpi_reply(client, "%.6e", 1.0f / SAMPLE_RATE);
+}
+
+static esp_err_t cmd_wav_preamble(scpi_client_t *client, const char *args, void *user)
+{
+    uint32_t trigger_index = g_points / 2;
+    return scpi_reply(client, "REAL,%u,%.6e,%.6e,%u,%u", g_points, 1.0f / SAMPLE_RATE,
+                      -(double)trigger_index / SAMPLE_RATE, trigger_index, g_generation);
+}
+
+static void release_capture(void *user)
+{
+    g_pins--;
+}
+
+static esp_err_t cmd_wav_data(scpi_client_t *client, const char *args, void *user)
+{
+    g_pins++;
+    return scpi_reply_block(client, g_volts, g_points * sizeof(float), release_capture, NULL);
+}
+
+static const scpi_command_t s_commands[] = {
+    { "*IDN?",                  cmd_idn },
+    { "*OPC?",                  cmd_opc },
+    { "*CLS",                   cmd_cls },
+    { ":SYSTem:ERRor?",         cmd_syst_err },
+    { ":RUN",                   cmd_run },
+    { ":STOP",                  cmd_stop },
+    { ":TRIGger:STATus?",       cmd_trig_status },
+    { ":TIMebase:SCALe",        cmd_tim_scale },
+    { ":TIMebase:SCALe?",       cmd_tim_scale_q },
+    { ":CHANnel1:SCALe",        cmd_chan_scale },
+    { ":CHANnel1:SCALe?",       cmd_chan_scale_q },
+    { ":TRIGger:LEVel",         cmd_trig_level },
+    { ":TRIGger:LEVel?",        cmd_trig_level_q },
+    { ":MEASure:FREQuency?",    cmd_meas_freq },
+    { ":MEASure:VPP?",          cmd_meas_vpp },
+    { ":WAVeform:FORMat?",      cmd_wav_format_q },
+    { ":WAVeform:POINts?",      cmd_wav_points },
+    { ":WAVeform:XINCrement?",  cmd_wav_xinc },
+    { ":WAVeform:PREamble?",    cmd_wav_preamble },
+    { ":WAVeform:DATA?",        cmd_wav_data },
+};
+
+static void on_signal(int sig)
+{
+    g_quit = 1;
+}
+
+int main(int argc, char **argv)
+{
+    uint16_t port = (argc > 1) ? (uint16_t)atoi(argv[1]) : 0;
+    if (argc > 2) g_points = (uint32_t)strtoul(argv[2], NULL, 0);
+
+    g_volts = malloc(g_points * sizeof(float));
+    if (g_volts == NULL) return 1;
+    capture();
+
+    scpi_server_config_t config = {
+        .port = port,
+        .commands = s_commands,
+        .num_commands = sizeof(s_commands) / sizeof(s_commands[0]),
+    };
+    scpi_server_t *server = scpi_server_create(&config);
+    if (server == NULL) return 1;
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    while (!g_quit) {
+        scpi_server_poll(server, 20);
+        if (g_running && g_pins == 0) capture();
+    }
+
+    scpi_server_stats_t stats;
+    scpi_server_get_stats(server, &stats);
+    printf("connections %u, commands %u, errors %u, sent %llu bytes (%llu block)\n",
+           stats.connections, stats.commands, stats.errors,
+           (unsigned long long)stats.bytes_sent, (unsigned long long)stats.block_bytes_sent);
+    scpi_server_destroy(server);
+    free(g_volts);
+    return 0;
+}
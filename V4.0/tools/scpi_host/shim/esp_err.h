@@ -0,0 +1,27 @@
+/**
+ * @file esp_err.h
+ * @brief Host stand-in for the ESP-IDF error codes used by the host tools
+ */
+
+#ifndef SCPI_HOST_ESP_ERR_H
+#define SCPI_HOST_ESP_ERR_H
+
+typedef int esp_err_t;
+
+#define ESP_OK                  0
+#define ESP_FAIL                -1
+#define ESP_ERR_NO_MEM          0x101
+#define ESP_ERR_INVALID_ARG     0x102
+#define ESP_ERR_INVALID_STATE   0x103
+#define ESP_ERR_INVALID_SIZE    0x104
+#define ESP_ERR_NOT_FOUND       0x105
+#define ESP_ERR_NOT_SUPPORTED   0x106
+#define ESP_ERR_TIMEOUT         0x107
+#define ESP_ERR_INVALID_RESPONSE 0x108
+
+static inline const char *esp_err_to_name(esp_err_t err)
+{
+    return err == ESP_OK ? "ESP_OK" : "ESP error";
+}
+
+#endif /* SCPI_HOST_ESP_ERR_H */
@@ -0,0 +1,16 @@
+/**
+ * @file esp_log.h
+ * @brief Host stand-in for the ESP-IDF log macros used by scpi_server
+ */
+
+#ifndef SCPI_HOST_ESP_LOG_H
+#define SCPI_HOST_ESP_LOG_H
+
+#include <stdio.h>
+
+#define ESP_LOGE(tag, fmt, ...) fprintf(stderr, "E %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) fprintf(stderr, "W %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) fprintf(stderr, "I %s: " fmt "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) do { } while (0)
+
+#endif /* SCPI_HOST_ESP_LOG_H */
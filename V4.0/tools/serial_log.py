@@ -0,0 +1,225 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+Wireless serial capture log (.wsl) reader / converter
+
+Reads the segments written by "Log SD" on the wireless serial screen
+(/sdcard/SerialLog/serial_YYYYMMDD_HHMMSS_SSSS.wsl plus the .wsx index beside
+each) and prints them as timestamped text, one line per received or sent
+chunk. With --from the index is used to seek straight to the block holding
+that time instead of decoding the segment from the start.
+
+Usage:
+    python serial_log.py info serial_20261019_120000_0000.wsl
+    python serial_log.py text serial_20261019_120000_*.wsl [options]
+
+Options for text:
+    --from S / --to S   Only records between S and S seconds of log time
+    --source LIST       Comma separated: uart, net, local (default all)
+    --hex               Payload as hex bytes instead of escaped text
+    --wall              Wall clock times (if the device clock was set)
+    -o FILE             Write to FILE instead of stdout
+
+Line format:
+    <time> <source> <len>: <payload>
+    time is seconds since the start of the log, or the wall clock with --wall;
+    source is UART< (from the device), NET> (from the network), LOCAL> (sent
+    from the screen), or LOST for bytes the capture had to drop.
+"""
+
+import struct
+import sys
+from datetime import datetime
+from pathlib import Path
+
+MAGIC = b"WSLG"
+INDEX_MAGIC = b"WSLX"
+VERSION = 1
+
+# Mirrors serial_log_header_t (packed, little endian)
+HEADER = struct.Struct("<4sHHIIqQ32s")
+HEADER_FIELDS = ("magic", "version", "header_size", "segment", "baud_rate", "start_unix_us", "first_time_us")
+
+# Mirrors serial_log_record_t / serial_log_lost_t / serial_log_index_t
+RECORD = struct.Struct("<IHBB")
+LOST = struct.Struct("<IB3x")
+INDEX = struct.Struct("<QQ")
+
+REC_TIME = 0x80
+REC_LOST = 0x81
+SOURCES = {0: "UART<", 1: "NET>", 2: "LOCAL>"}
+SOURCE_NAMES = {"uart": 0, "net": 1, "local": 2}
+
+
+def read_header(path, magic=MAGIC):
+    """读取并校验分段或索引文件头"""
+    with open(path, "rb") as f:
+        raw = f.read(HEADER.size)
+    if len(raw) < HEADER.size:
+        raise ValueError(f"{path}: file too short")
+    header = dict(zip(HEADER_FIELDS, HEADER.unpack(raw)))
+    if header["magic"] != magic or header["version"] != VERSION:
+        raise ValueError(f"{path}: not a serial capture file")
+    return header
+
+
+def read_index(path):
+    """读取 .wsx 索引：[(块起始时间 us, 文件偏移)]，缺失时返回空列表"""
+    index_path = Path(path).with_suffix(".wsx")
+    if not index_path.exists():
+        return []
+    header = read_header(index_path, INDEX_MAGIC)
+    data = index_path.read_bytes()[header["header_size"]:]
+    count = len(data) // INDEX.size     # 掉电时最后一项可能不完整
+    return [INDEX.unpack_from(data, i * INDEX.size) for i in range(count)]
+
+
+def records(path, start_us=None):
+    """逐条产出 (log 时间 us, 类型, 载荷)；给定 start_us 时借助索引跳到对应块"""
+    header = read_header(path)
+    offset = header["header_size"]
+    if start_us is not None:
+        for time_us, block_offset in read_index(path):
+            if time_us > start_us:
+                break
+            offset = block_offset
+    with open(path, "rb") as f:
+        f.seek(offset)
+        data = f.read()
+
+    time_us = header["first_time_us"]
+    pos = 0
+    while pos + RECORD.size <= len(data):
+        delta, length, kind, _ = RECORD.unpack_from(data, pos)
+        payload = data[pos + RECORD.size:pos + RECORD.size + length]
+        if len(payload) < length:
+            break   # 掉电时最后一条可能不完整
+        pos += RECORD.size + length
+        if kind == REC_TIME:
+            time_us = struct.unpack("<Q", payload)[0]
+            continue
+        time_us += delta
+        yield time_us, kind, payload
+
+
+def escape(payload):
+    """载荷转为单行可读文本"""
+    out = []
+    for b in payload:
+        if b == 0x0A:
+            out.append("\\n")
+        elif b == 0x0D:
+            out.append("\\r")
+        elif b == 0x09:
+            out.append("\\t")
+        elif b == 0x5C:
+            out.append("\\\\")
+        elif 0x20 <= b < 0x7F:
+            out.append(chr(b))
+        else:
+            out.append(f"\\x{b:02x}")
+    return "".join(out)
+
+
+def format_time(time_us, start_unix_us, wall):
+    if wall and start_unix_us:
+        t = datetime.fromtimestamp((start_unix_us + time_us) / 1e6)
+        return t.strftime("%Y-%m-%d %H:%M:%S.%f")
+    return f"{time_us / 1e6:14.6f}"
+
+
+def to_text(paths, out, t_from=None, t_to=None, sources=None, hex_dump=False, wall=False):
+    start_us = int(t_from * 1e6) if t_from is not None else None
+    end_us = int(t_to * 1e6) if t_to is not None else None
+    for path in paths:
+        header = read_header(path)
+        for time_us, kind, payload in records(path, start_us):
+            if end_us is not None and time_us > end_us:
+                break
+            if start_us is not None and time_us < start_us:
+                continue
+            stamp = format_time(time_us, header["start_unix_us"], wall)
+            if kind == REC_LOST:
+                lost, source = LOST.unpack(payload)
+                if sources is None or source in sources:
+                    out.write(f"{stamp} LOST   {lost} bytes of {SOURCES.get(source, source)}\n")
+                continue
+            if sources is not None and kind not in sources:
+                continue
+            text = payload.hex(" ") if hex_dump else escape(payload)
+            out.write(f"{stamp} {SOURCES.get(kind, kind):6s} {len(payload)}: {text}\n")
+
+
+def print_info(path):
+    header = read_header(path)
+    for key in HEADER_FIELDS[1:]:
+        print(f"{key:14s} {header[key]}")
+    if header["start_unix_us"]:
+        start = datetime.fromtimestamp(header["start_unix_us"] / 1e6)
+        print(f"{'started':14s} {start.strftime('%Y-%m-%d %H:%M:%S.%f')}")
+
+    totals = {kind: [0, 0] for kind in SOURCES}
+    lost = {kind: 0 for kind in SOURCES}
+    first = last = None
+    for time_us, kind, payload in records(path):
+        if kind == REC_LOST:
+            count, source = LOST.unpack(payload)
+            lost[source] = lost.get(source, 0) + count
+            continue
+        first = time_us if first is None else first
+        last = time_us
+        totals.setdefault(kind, [0, 0])
+        totals[kind][0] += 1
+        totals[kind][1] += len(payload)
+    if first is not None:
+        print(f"{'span':14s} {first / 1e6:.6f} .. {last / 1e6:.6f} s")
+    print(f"{'index blocks':14s} {len(read_index(path))}")
+    for kind, (count, size) in totals.items():
+        name = SOURCES.get(kind, kind)
+        print(f"{name:14s} {count} records, {size} bytes, {lost.get(kind, 0)} lost")
+
+
+def main(argv):
+    if len(argv) < 3 or argv[1] not in ("info", "text"):
+        print(__doc__)
+        return 1
+    if argv[1] == "info":
+        for path in argv[2:]:
+            print_info(Path(path))
+        return 0
+
+    args = argv[2:]
+    paths, options = [], {}
+    out_path = None
+    i = 0
+    while i < len(args):
+        arg = args[i]
+        if arg in ("--from", "--to"):
+            options["t_" + arg[2:]] = float(args[i + 1])
+            i += 1
+        elif arg == "--source":
+            options["sources"] = {SOURCE_NAMES[name] for name in args[i + 1].split(",")}
+            i += 1
+        elif arg == "--hex":
+            options["hex_dump"] = True
+        elif arg == "--wall":
+            options["wall"] = True
+        elif arg == "-o":
+            out_path = args[i + 1]
+            i += 1
+        else:
+            paths.append(Path(arg))
+        i += 1
+    paths.sort()    # _0000, _0001, ... in time order
+
+    if out_path is None:
+        to_text(paths, sys.stdout, **options)
+    else:
+        with open(out_path, "w", encoding="utf-8") as out:
+            to_text(paths, out, **options)
+        print(f"{len(paths)} segment(s) -> {out_path}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,38 @@
+/**
+ * @file lv_conf.h
+ * @brief LVGL 8.3 configuration of the terminal host build
+ *
+ * Mirrors the sdkconfig values that matter for drawing text: RGB565, the
+ * 10 ms refresh period, DPI 130, stdlib memory and the font options of the
+ * generated fonts. Unset options take the LVGL defaults.
+ */
+
+#if 1 /* Set this to "1" to enable content */
+
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#define LV_COLOR_DEPTH              16
+#define LV_COLOR_16_SWAP            0
+
+#define LV_MEM_CUSTOM               1
+#define LV_MEM_CUSTOM_INCLUDE       <stdlib.h>
+#define LV_MEMCPY_MEMSET_STD        1
+
+#define LV_DISP_DEF_REFR_PERIOD     10
+#define LV_INDEV_DEF_READ_PERIOD    30
+#define LV_DPI_DEF                  130
+
+#define LV_TICK_CUSTOM              0       /* The harness advances lv_tick_inc() per frame */
+#define LV_USE_LOG                  0
+#define LV_USE_PERF_MONITOR         0
+
+#define LV_FONT_MONTSERRAT_14       1
+#define LV_FONT_DEFAULT             &lv_font_montserrat_14
+#define LV_FONT_FMT_TXT_LARGE       1
+#define LV_USE_FONT_COMPRESSED      1
+#define LV_USE_FONT_PLACEHOLDER     1
+
+#endif /* LV_CONF_H */
+
+#endif /* Enable content */
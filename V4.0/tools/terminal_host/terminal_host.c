@@ -0,0 +1,355 @@
+/**
+ * @file terminal_host.c
+ * @brief Receive terminal widget on the host: tests and a frame-time benchmark
+ *
+ * Runs the device's lv_terminal.c unchanged on LVGL 8.3 with a 480x800
+ * RGB565 display whose flush returns at once, so the times are LVGL's own
+ * CPU cost. The widget sits where wireless_serial_attach_receive_view()
+ * puts it (390x345, montserratMedium 16 text, 12 hex) and the harness
+ * plays the LVGL thread: every 10 ms frame (the UI flush period) it
+ * appends the bytes a UART delivers in that time, then runs
+ * lv_timer_handler().
+ *
+ * The tests check row counting and wrapping, eviction and search against
+ * a small scrollback, and that appending costs the same per byte with a
+ * 16 KB or a 1 MB scrollback.
+ *
+ * The benchmark fills the device-sized scrollback (256 KB, 8192 rows) and
+ * reports append and render time per frame at 115200 and 2 Mbaud, in the
+ * text and hex views, against the 10 ms frame budget. An lv_textarea fed
+ * the same 2 Mbaud stream is timed as the old receive pane for comparison.
+ *
+ *   ./terminal_host            # tests, exit status 1 on failure
+ *   ./terminal_host --bench    # frame-time benchmark
+ */
+
+#include "lvgl.h"
+#include "lv_terminal.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HOR_RES         480
+#define VER_RES         800
+#define FRAME_MS        10          // UI_FLUSH_PERIOD_MS
+#define STREAM_BYTES    (1024 * 1024)
+#define SCROLLBACK      (256 * 1024)    // WIRELESS_SERIAL_SCROLLBACK_SIZE
+#define SCROLLBACK_ROWS 8192            // WIRELESS_SERIAL_SCROLLBACK_ROWS
+
+LV_FONT_DECLARE(lv_font_montserratMedium_12);
+LV_FONT_DECLARE(lv_font_montserratMedium_16);
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        g_failures++; \
+        printf("  FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* ==================== Display ==================== */
+
+static lv_color_t s_frame[HOR_RES * VER_RES];
+static lv_disp_draw_buf_t s_draw_buf;
+static lv_disp_drv_t s_disp_drv;
+
+static void flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    lv_disp_flush_ready(drv);
+}
+
+static void display_init(void)
+{
+    lv_init();
+    lv_disp_draw_buf_init(&s_draw_buf, s_frame, NULL, HOR_RES * VER_RES);
+    lv_disp_drv_init(&s_disp_drv);
+    s_disp_drv.hor_res = HOR_RES;
+    s_disp_drv.ver_res = VER_RES;
+    s_disp_drv.draw_buf = &s_draw_buf;
+    s_disp_drv.flush_cb = flush_cb;
+    lv_disp_drv_register(&s_disp_drv);
+}
+
+/* One UI frame: advance the tick and let LVGL refresh; returns the time taken */
+static double run_frame(void)
+{
+    lv_tick_inc(FRAME_MS);
+    double t0 = now_us();
+    lv_timer_handler();
+    return now_us() - t0;
+}
+
+/* The receive pane as wireless_serial_attach_receive_view() sets it up */
+static lv_obj_t *create_terminal(uint32_t bytes, uint32_t rows)
+{
+    lv_obj_t *term = lv_terminal_create(lv_scr_act());
+    if (!lv_terminal_set_scrollback(term, bytes, rows)) return NULL;
+    lv_obj_set_pos(term, 15, 60);
+    lv_obj_set_size(term, 390, 345);
+    lv_obj_set_style_bg_opa(term, 255, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_bg_color(term, lv_color_hex(0xffffff), LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_border_width(term, 0, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_radius(term, 8, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_pad_all(term, 12, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_color(term, lv_color_hex(0x000000), LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(term, &lv_font_montserratMedium_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+    lv_obj_set_style_text_font(term, &lv_font_montserratMedium_12, LV_PART_ITEMS | LV_STATE_DEFAULT);
+    run_frame();    // Layout: the width fixes the columns
+    return term;
+}
+
+/* ==================== Input ==================== */
+
+static char *s_stream;
+
+/* Log lines of 30..110 bytes, like a device printing sensor readings */
+static void make_stream(void)
+{
+    s_stream = malloc(STREAM_BYTES);
+    uint32_t n = 0, line = 0;
+    while (n < STREAM_BYTES) {
+        char text[160];
+        int len = snprintf(text, sizeof(text), "[%6lu.%03lu] ch%lu adc=%4lu v=%.3f%.*s\r\n",
+                           (unsigned long)(line / 100), (unsigned long)(line % 100) * 10,
+                           (unsigned long)(line % 4), (unsigned long)(line * 2654435761u >> 20) % 4096,
+                           (line % 4096) * 3.3 / 4095.0, (int)(line * 7 % 64),
+                           " status=OK rssi=-61 seq=0000 crc=ok payload=0123456789abcdef0123456789abcdef0123");
+        if (n + (uint32_t)len > STREAM_BYTES) len = (int)(STREAM_BYTES - n);
+        memcpy(s_stream + n, text, (size_t)len);
+        n += (uint32_t)len;
+        line++;
+    }
+}
+
+/* Feed len bytes of the stream from *pos, wrapping around */
+static void feed(lv_obj_t *term, uint32_t *pos, uint32_t len)
+{
+    while (len > 0) {
+        uint32_t n = STREAM_BYTES - *pos;
+        if (n > len) n = len;
+        lv_terminal_append(term, s_stream + *pos, n);
+        *pos = (*pos + n) % STREAM_BYTES;
+        len -= n;
+    }
+}
+
+/* ==================== Tests ==================== */
+
+static void test_rows(void)
+{
+    lv_obj_t *obj = create_terminal(64 * 1024, 1024);
+    lv_terminal_t *term = (lv_terminal_t *)obj;
+    CHECK(obj != NULL && term->cols > 20, "terminal with %u columns", obj ? term->cols : 0);
+    if (obj == NULL) return;
+
+    CHECK(lv_terminal_get_row_count(obj) == 1, "%lu rows when empty", (unsigned long)lv_terminal_get_row_count(obj));
+    char line[32];
+    for (int i = 0; i < 100; i++) {
+        int n = snprintf(line, sizeof(line), "line %d\r\n", i);
+        lv_terminal_append(obj, line, (uint32_t)n);
+    }
+    CHECK(lv_terminal_get_row_count(obj) == 101, "%lu rows after 100 lines",
+          (unsigned long)lv_terminal_get_row_count(obj));
+
+    // A long line wraps at the column count; '\r' takes no cell
+    static char wide[1024];
+    uint32_t len = 3u * term->cols;
+    memset(wide, 'x', len);
+    lv_terminal_append(obj, wide, len);
+    lv_terminal_append(obj, "\r\n", 2);
+    CHECK(lv_terminal_get_row_count(obj) == 104, "%lu rows after a 3-row line",
+          (unsigned long)lv_terminal_get_row_count(obj));
+
+    CHECK(lv_terminal_search(obj, "LINE 42", true), "case-insensitive search");
+    CHECK(!lv_terminal_search(obj, "line 420", true), "search found missing text");
+    run_frame();
+
+    lv_terminal_clear(obj);
+    CHECK(lv_terminal_get_row_count(obj) == 1, "%lu rows after clear", (unsigned long)lv_terminal_get_row_count(obj));
+    lv_obj_del(obj);
+}
+
+static void test_eviction(void)
+{
+    // 4 KB / 64 rows: old text falls off, recent text stays searchable
+    lv_obj_t *obj = create_terminal(4096, 64);
+    CHECK(obj != NULL, "create");
+    if (obj == NULL) return;
+
+    char line[32];
+    for (int i = 0; i < 10000; i++) {
+        int n = snprintf(line, sizeof(line), "token%05d\n", i);
+        lv_terminal_append(obj, line, (uint32_t)n);
+        if (i % 1000 == 0) run_frame();
+    }
+    CHECK(lv_terminal_get_row_count(obj) <= 64, "%lu rows kept of 64", (unsigned long)lv_terminal_get_row_count(obj));
+    CHECK(lv_terminal_search(obj, "token09999", true), "newest line not found");
+    CHECK(lv_terminal_search(obj, "token09940", true), "line 60 back not found");
+    CHECK(!lv_terminal_search(obj, "token00001", true), "evicted line found");
+
+    lv_terminal_set_hex(obj, true);
+    CHECK(lv_terminal_get_hex(obj) && lv_terminal_search(obj, "token09999", true), "search in the hex view");
+    run_frame();
+    lv_terminal_set_hex(obj, false);
+    run_frame();
+    lv_obj_del(obj);
+}
+
+/* ns per byte appending 8 MB in 2 KB chunks, after the scrollback has filled once */
+static double append_cost(uint32_t bytes, uint32_t rows)
+{
+    lv_obj_t *obj = create_terminal(bytes, rows);
+    if (obj == NULL) return 0.0;
+    uint32_t pos = 0;
+    feed(obj, &pos, 2 * bytes);
+    double t0 = now_us();
+    for (int i = 0; i < 4096; i++) feed(obj, &pos, 2048);
+    double ns = (now_us() - t0) * 1000.0 / (4096.0 * 2048.0);
+    lv_obj_del(obj);
+    return ns;
+}
+
+static void test_append_cost(void)
+{
+    double small = append_cost(16 * 1024, 512);
+    double large = append_cost(1024 * 1024, 32768);
+    printf("  append: %.1f ns/byte with 16 KB scrollback, %.1f ns/byte with 1 MB\n", small, large);
+    CHECK(small > 0.0 && large > 0.0, "scrollback allocation");
+    CHECK(large < 2.0 * small + 1.0, "append cost grows with the scrollback: %.1f vs %.1f ns/byte", large, small);
+}
+
+/* ==================== Benchmark ==================== */
+
+typedef struct {
+    double append_sum, append_max;
+    double render_sum, render_max;
+    double frame[1000];
+    int frames;
+} frame_stats_t;
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char *name, frame_stats_t *s)
+{
+    qsort(s->frame, (size_t)s->frames, sizeof(double), cmp_double);
+    double p99 = s->frame[s->frames * 99 / 100];
+    printf("  %-22s %8.1f %8.1f %9.2f %9.2f %9.2f %7.1f%%\n", name, s->append_sum / s->frames, s->append_max,
+           s->render_sum / s->frames / 1000.0, s->render_max / 1000.0, p99 / 1000.0,
+           100.0 * (s->append_sum + s->render_sum) / s->frames / (FRAME_MS * 1000.0));
+}
+
+static void bench_terminal(uint32_t baud, bool hex)
+{
+    lv_obj_t *obj = create_terminal(SCROLLBACK, SCROLLBACK_ROWS);
+    if (obj == NULL) return;
+    lv_terminal_set_hex(obj, hex);
+
+    // Steady state: scrollback full, rows falling off
+    uint32_t pos = 0;
+    feed(obj, &pos, 2 * SCROLLBACK);
+    run_frame();
+
+    static frame_stats_t s;
+    memset(&s, 0, sizeof(s));
+    double bytes_per_frame = baud / 10.0 * FRAME_MS / 1000.0;
+    double due = 0.0;
+    for (s.frames = 0; s.frames < 1000; s.frames++) {
+        due += bytes_per_frame;
+        uint32_t n = (uint32_t)due;
+        due -= n;
+        double t0 = now_us();
+        feed(obj, &pos, n);
+        double append = now_us() - t0;
+        double render = run_frame();
+        s.append_sum += append;
+        s.render_sum += render;
+        if (append > s.append_max) s.append_max = append;
+        if (render > s.render_max) s.render_max = render;
+        s.frame[s.frames] = append + render;
+    }
+
+    char name[32];
+    snprintf(name, sizeof(name), "%s %lu baud", hex ? "hex" : "text", (unsigned long)baud);
+    report(name, &s);
+    lv_obj_del(obj);
+}
+
+/* The old receive pane: every frame appends to one growing string */
+static void bench_textarea(uint32_t baud)
+{
+    lv_obj_t *ta = lv_textarea_create(lv_scr_act());
+    lv_obj_set_pos(ta, 15, 60);
+    lv_obj_set_size(ta, 390, 345);
+    lv_obj_set_style_text_font(ta, &lv_font_montserratMedium_16, LV_PART_MAIN | LV_STATE_DEFAULT);
+    run_frame();
+
+    uint32_t per_frame = baud / 10 * FRAME_MS / 1000;
+    uint32_t pos = 0, size = 0, next_report = 16 * 1024;
+    double window_us = 0.0;
+    int window_frames = 0;
+    static char chunk[4096];
+    while (next_report <= 64 * 1024) {
+        memcpy(chunk, s_stream + pos, per_frame);
+        chunk[per_frame] = '\0';
+        pos += per_frame;
+        double t0 = now_us();
+        lv_textarea_add_text(ta, chunk);
+        window_us += now_us() - t0 + run_frame();
+        window_frames++;
+        size += per_frame;
+        if (size >= next_report) {
+            printf("  textarea %lu baud, up to %2lu KB text: %.2f ms per frame\n", (unsigned long)baud,
+                   (unsigned long)(next_report / 1024), window_us / window_frames / 1000.0);
+            window_us = 0.0;
+            window_frames = 0;
+            next_report *= 2;
+        }
+    }
+    lv_obj_del(ta);
+}
+
+static void bench(void)
+{
+    printf("\nframe = append + lv_timer_handler(), %d ms budget, 256 KB / 8192-row scrollback kept full\n",
+           FRAME_MS);
+    printf("  %-22s %8s %8s %9s %9s %9s %8s\n", "", "app us", "max us", "draw ms", "max ms", "p99 ms", "budget");
+    static const uint32_t rates[] = { 115200, 2000000 };
+    for (int hex = 0; hex <= 1; hex++) {
+        for (int i = 0; i < 2; i++) bench_terminal(rates[i], hex);
+    }
+    bench_textarea(2000000);
+}
+
+int main(int argc, char **argv)
+{
+    display_init();
+    make_stream();
+
+    test_rows();
+    test_eviction();
+    test_append_cost();
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        bench();
+    }
+
+    free(s_stream);
+    printf("%s (%d failure%s)\n", g_failures ? "FAILED" : "passed", g_failures, g_failures == 1 ? "" : "s");
+    return g_failures ? 1 : 0;
+}
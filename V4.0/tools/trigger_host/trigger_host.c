@@ -0,0 +1,480 @@
+/**
+ * @file trigger_host.c
+ * @brief Oscilloscope trigger detector on the host: per-type trigger tests
+ *
+ * Runs the device's oscilloscope_trigger.c unchanged at 1 MSa/s, so times
+ * in microseconds are sample counts. Signals are built from steps and
+ * ramps, and every test checks the number and position of the triggers:
+ *
+ *   Edge          one trigger per edge, noise inside the hysteresis ignored
+ *   Pulse width   less / greater / within, positive and negative pulses
+ *   Runt          pulses that miss the high threshold, not full ones
+ *   Slope         timed LOW -> MID -> HIGH edges only: a dip below the high
+ *                 level, a first sample between the thresholds or a jump
+ *                 between two samples must not fire
+ *   Window        leaving the band on either side
+ *   Timeout       once per quiet period, also through osc_trigger_advance()
+ *
+ * A random signal fed in blocks of 1, 7 and 64 samples must give the same
+ * triggers as one call, for every type.
+ *
+ *   ./trigger_host                 # tests, exit status 1 on failure
+ */
+
+#include "oscilloscope_trigger.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SAMPLE_RATE     1e6f
+#define MAX_SAMPLES     65536
+#define MAX_TRIGGERS    256
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        g_failures++; \
+        printf("  FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+static float g_sig[MAX_SAMPLES];
+static uint32_t g_len;
+
+static uint32_t g_seed = 12345;
+
+static uint32_t rnd(void)
+{
+    g_seed = g_seed * 1103515245u + 12345u;
+    return g_seed >> 8;
+}
+
+/* ==================== Signals ==================== */
+
+static void sig_start(float level)
+{
+    g_sig[0] = level;
+    g_len = 1;
+}
+
+/* Hold the last level for n samples */
+static void sig_hold(uint32_t n)
+{
+    float v = g_sig[g_len - 1];
+    while (n-- > 0 && g_len < MAX_SAMPLES) g_sig[g_len++] = v;
+}
+
+/* Ramp linearly to level over n samples (n = 1: a step) */
+static void sig_ramp(float level, uint32_t n)
+{
+    float v0 = g_sig[g_len - 1];
+    for (uint32_t i = 1; i <= n && g_len < MAX_SAMPLES; i++) {
+        g_sig[g_len++] = v0 + (level - v0) * (float)i / (float)n;
+    }
+}
+
+/* ==================== Detector ==================== */
+
+static osc_trigger_ctx_t *g_trig;
+
+static osc_trigger_config_t make_config(osc_trigger_type_t type, bool rising, float low, float high)
+{
+    osc_trigger_config_t config = {
+        .enabled = true,
+        .level_voltage = high,
+        .rising_edge = rising,
+        .pre_trigger_ratio = 0.5f,
+        .type = type,
+        .level_low_voltage = low,
+    };
+    return config;
+}
+
+static void configure(const osc_trigger_config_t *config)
+{
+    esp_err_t ret = osc_trigger_configure(g_trig, config, SAMPLE_RATE);
+    CHECK(ret == ESP_OK, "configure %s returned %d", osc_trigger_get_type_str(config->type), ret);
+}
+
+/**
+ * @brief Every trigger in data, fed in blocks of block samples (0 = one call)
+ *
+ * Like the acquisition path, processing resumes after each trigger.
+ */
+static uint32_t find_triggers(const float *data, uint32_t len, uint32_t block, uint32_t *out)
+{
+    osc_trigger_reset(g_trig);
+    uint32_t count = 0;
+    uint32_t pos = 0;
+    while (pos < len) {
+        uint32_t end = (block == 0) ? len : (pos / block + 1) * block;
+        if (end > len) end = len;
+        int32_t hit = osc_trigger_process(g_trig, data + pos, end - pos);
+        if (hit < 0) {
+            pos = end;
+            continue;
+        }
+        if (count < MAX_TRIGGERS) out[count++] = pos + (uint32_t)hit;
+        pos += (uint32_t)hit + 1;
+    }
+    return count;
+}
+
+/* Run the signal and expect exactly the listed trigger positions */
+static void expect_triggers(const char *what, const uint32_t *expected, uint32_t num_expected)
+{
+    uint32_t hits[MAX_TRIGGERS];
+    uint32_t count = find_triggers(g_sig, g_len, 0, hits);
+    CHECK(count == num_expected, "%s: %lu trigger(s), expected %lu", what,
+          (unsigned long)count, (unsigned long)num_expected);
+    for (uint32_t i = 0; i < count && i < num_expected; i++) {
+        CHECK(hits[i] == expected[i], "%s: trigger %lu at %lu, expected %lu", what, (unsigned long)i,
+              (unsigned long)hits[i], (unsigned long)expected[i]);
+    }
+}
+
+/* ==================== Tests ==================== */
+
+static void test_edge(void)
+{
+    // Three slow edges with noise around the 1.5 V level inside the 20 mV hysteresis
+    sig_start(0.5f);
+    uint32_t rise[3], fall[3];
+    for (int k = 0; k < 3; k++) {
+        sig_hold(50);
+        sig_ramp(1.495f, 20);
+        for (int i = 0; i < 10; i++) g_sig[g_len++] = (i & 1) ? 1.495f : 1.505f;
+        sig_ramp(2.5f, 20);
+        rise[k] = g_len - 20;           // First sample above 1.51 V
+        while (g_sig[rise[k]] <= 1.51f) rise[k]++;
+        sig_hold(50);
+        sig_ramp(0.5f, 40);
+        fall[k] = g_len - 40;
+        while (g_sig[fall[k]] >= 1.49f) fall[k]++;
+    }
+    sig_hold(20);
+
+    osc_trigger_config_t config = make_config(OSC_TRIGGER_EDGE, true, 0.0f, 1.5f);
+    configure(&config);
+    expect_triggers("rising", rise, 3);
+
+    config.rising_edge = false;
+    configure(&config);
+    expect_triggers("falling", fall, 3);
+
+    // Hysteresis wider than the noise swing is required: 5 mV lets it through
+    config.rising_edge = true;
+    config.hysteresis_voltage = 0.005f;
+    configure(&config);
+    uint32_t hits[MAX_TRIGGERS];
+    CHECK(find_triggers(g_sig, g_len, 0, hits) > 3, "noise not seen with a narrow hysteresis");
+}
+
+static void test_pulse_width(void)
+{
+    // Positive pulses of 5, 20 and 100 samples; the trigger is the sample ending the pulse
+    static const uint32_t widths[] = { 5, 20, 100 };
+    uint32_t ends[3];
+    sig_start(0.5f);
+    for (int k = 0; k < 3; k++) {
+        sig_hold(200);
+        sig_ramp(2.5f, 1);
+        sig_hold(widths[k] - 1);
+        sig_ramp(0.5f, 1);
+        ends[k] = g_len - 1;
+    }
+    sig_hold(200);
+
+    osc_trigger_config_t config = make_config(OSC_TRIGGER_PULSE_WIDTH, true, 0.0f, 1.5f);
+    config.when = OSC_TRIGGER_WHEN_LESS;
+    config.time_max = 10e-6f;
+    configure(&config);
+    expect_triggers("less than 10 us", &ends[0], 1);
+
+    config.when = OSC_TRIGGER_WHEN_GREATER;
+    config.time_min = 50e-6f;
+    configure(&config);
+    expect_triggers("greater than 50 us", &ends[2], 1);
+
+    config.when = OSC_TRIGGER_WHEN_WITHIN;
+    config.time_min = 10e-6f;
+    config.time_max = 50e-6f;
+    configure(&config);
+    expect_triggers("within 10..50 us", &ends[1], 1);
+
+    // Negative pulses: the same signal mirrored about 1.5 V
+    for (uint32_t i = 0; i < g_len; i++) g_sig[i] = 3.0f - g_sig[i];
+    config.rising_edge = false;
+    config.when = OSC_TRIGGER_WHEN_LESS;
+    config.time_max = 10e-6f;
+    configure(&config);
+    expect_triggers("negative less than 10 us", &ends[0], 1);
+}
+
+static void test_runt(void)
+{
+    // Runt to 1.5 V, full pulse to 2.5 V, runt that turns into a full pulse
+    sig_start(0.5f);
+    sig_hold(100);
+    sig_ramp(1.5f, 10);
+    sig_hold(30);
+    sig_ramp(0.5f, 10);
+    uint32_t runt_end = g_len - 10;
+    while (g_sig[runt_end] >= 0.99f) runt_end++;
+    sig_hold(100);
+    sig_ramp(2.5f, 20);
+    sig_hold(30);
+    sig_ramp(0.5f, 20);
+    sig_hold(100);
+    sig_ramp(1.5f, 10);
+    sig_hold(30);
+    sig_ramp(2.5f, 10);
+    sig_hold(30);
+    sig_ramp(0.5f, 20);
+    sig_hold(100);
+
+    osc_trigger_config_t config = make_config(OSC_TRIGGER_RUNT, true, 1.0f, 2.0f);
+    configure(&config);
+    expect_triggers("runt", &runt_end, 1);
+}
+
+static void test_slope(void)
+{
+    // Fast edge (about 4 samples from 1.0 to 2.0 V) and slow edge (about 100 samples)
+    sig_start(0.5f);
+    sig_hold(100);
+    sig_ramp(2.5f, 8);
+    uint32_t fast = g_len - 8;
+    while (g_sig[fast] <= 2.01f) fast++;
+    sig_hold(100);
+    sig_ramp(0.5f, 8);
+    sig_hold(100);
+    sig_ramp(2.5f, 200);
+    uint32_t slow = g_len - 200;
+    while (g_sig[slow] <= 2.01f) slow++;
+    sig_hold(100);
+    sig_ramp(0.5f, 8);
+    sig_hold(100);
+
+    osc_trigger_config_t config = make_config(OSC_TRIGGER_SLOPE, true, 1.0f, 2.0f);
+    config.when = OSC_TRIGGER_WHEN_LESS;
+    config.time_max = 10e-6f;
+    configure(&config);
+    expect_triggers("fast edge", &fast, 1);
+
+    config.when = OSC_TRIGGER_WHEN_GREATER;
+    config.time_min = 50e-6f;
+    configure(&config);
+    expect_triggers("slow edge", &slow, 1);
+
+    config.when = OSC_TRIGGER_WHEN_WITHIN;
+    config.time_min = 50e-6f;
+    config.time_max = 150e-6f;
+    configure(&config);
+    expect_triggers("edge within 50..150 us", &slow, 1);
+
+    // Falling polarity: the fast falling edge
+    for (uint32_t i = 0; i < g_len; i++) g_sig[i] = 3.0f - g_sig[i];
+    config.rising_edge = false;
+    config.when = OSC_TRIGGER_WHEN_LESS;
+    config.time_max = 10e-6f;
+    configure(&config);
+    expect_triggers("fast falling edge", &fast, 1);
+
+    config.rising_edge = true;
+    configure(&config);
+
+    // A dip from HIGH into MID and back is not an edge
+    sig_start(2.5f);
+    sig_hold(100);
+    sig_ramp(1.5f, 3);
+    sig_hold(5);
+    sig_ramp(2.5f, 3);
+    sig_hold(100);
+    expect_triggers("HIGH -> MID -> HIGH dip", NULL, 0);
+
+    // Acquisition starting between the thresholds: the first rise has no start time
+    sig_start(1.5f);
+    sig_hold(20);
+    sig_ramp(2.5f, 2);
+    sig_hold(100);
+    expect_triggers("first sample between the thresholds", NULL, 0);
+
+    // LOW -> HIGH between two samples cannot be timed
+    sig_start(0.5f);
+    sig_hold(100);
+    sig_ramp(2.5f, 1);
+    sig_hold(100);
+    expect_triggers("jump between two samples", NULL, 0);
+
+    // LOW -> MID, back to LOW, then a slow rise: only the completed edge is timed
+    sig_start(0.5f);
+    sig_hold(100);
+    sig_ramp(1.5f, 2);
+    sig_ramp(0.5f, 2);
+    sig_hold(5);
+    sig_ramp(2.5f, 200);
+    sig_hold(100);
+    expect_triggers("aborted edge, then a slow one", NULL, 0);
+}
+
+static void test_window(void)
+{
+    sig_start(1.5f);
+    sig_hold(100);
+    sig_ramp(2.5f, 10);
+    uint32_t exits[2];
+    exits[0] = g_len - 10;
+    while (g_sig[exits[0]] <= 2.01f) exits[0]++;
+    sig_hold(50);
+    sig_ramp(1.5f, 10);
+    sig_hold(50);
+    sig_ramp(0.5f, 10);
+    exits[1] = g_len - 10;
+    while (g_sig[exits[1]] >= 0.99f) exits[1]++;
+    sig_hold(50);
+    sig_ramp(1.5f, 10);
+    sig_hold(50);
+
+    osc_trigger_config_t config = make_config(OSC_TRIGGER_WINDOW, true, 1.0f, 2.0f);
+    configure(&config);
+    expect_triggers("window exits", exits, 2);
+
+    // Falling polarity is ignored: the window is symmetric
+    config.rising_edge = false;
+    configure(&config);
+    expect_triggers("window exits, falling", exits, 2);
+}
+
+static void test_timeout(void)
+{
+    // Square wave with an edge every 50 samples, a 1000-sample gap, then edges again
+    sig_start(0.5f);
+    uint32_t last_edge = 0;
+    for (int k = 0; k < 10; k++) {
+        sig_hold(49);
+        sig_ramp((k & 1) ? 0.5f : 2.5f, 1);
+        last_edge = g_len - 1;
+    }
+    sig_hold(1000);
+    for (int k = 0; k < 10; k++) {
+        sig_hold(49);
+        sig_ramp((k & 1) ? 2.5f : 0.5f, 1);
+    }
+    sig_hold(20);
+
+    osc_trigger_config_t config = make_config(OSC_TRIGGER_TIMEOUT, true, 0.0f, 1.5f);
+    config.time_min = 100e-6f;
+    configure(&config);
+    uint32_t expected = last_edge + 100;
+    expect_triggers("timeout", &expected, 1);
+
+    // Same signal with quiet spans skipped 64 samples at a time
+    osc_trigger_reset(g_trig);
+    uint32_t hits[MAX_TRIGGERS];
+    uint32_t count = 0;
+    uint32_t pos = 0;
+    int skipped = 0;
+    while (pos < g_len) {
+        uint32_t n = (g_len - pos < 64) ? g_len - pos : 64;
+        float lo = g_sig[pos], hi = g_sig[pos];
+        for (uint32_t i = 1; i < n; i++) {
+            lo = fminf(lo, g_sig[pos + i]);
+            hi = fmaxf(hi, g_sig[pos + i]);
+        }
+        int32_t hit;
+        if (osc_trigger_is_quiet(g_trig, lo, hi)) {
+            hit = osc_trigger_advance(g_trig, n);
+            skipped++;
+        } else {
+            hit = osc_trigger_process(g_trig, &g_sig[pos], n);
+        }
+        if (hit >= 0) {
+            hits[count++] = pos + (uint32_t)hit;
+            n = (uint32_t)hit + 1;
+        }
+        pos += n;
+    }
+    CHECK(skipped > 10, "only %d quiet spans skipped", skipped);
+    CHECK(count == 1 && hits[0] == expected, "advance: %lu trigger(s), first at %lu, expected %lu",
+          (unsigned long)count, (unsigned long)(count ? hits[0] : 0), (unsigned long)expected);
+}
+
+static void test_blocks(void)
+{
+    // Random steps and ramps across both thresholds
+    sig_start(1.5f);
+    while (g_len < MAX_SAMPLES - 300) {
+        float level = 0.3f + (rnd() % 2700) / 1000.0f;
+        sig_ramp(level, 1 + rnd() % 40);
+        sig_hold(rnd() % 100);
+    }
+
+    for (int type = 0; type < OSC_TRIGGER_TYPE_MAX; type++) {
+        osc_trigger_config_t config = make_config((osc_trigger_type_t)type, (type & 1) != 0, 1.0f, 2.0f);
+        config.when = OSC_TRIGGER_WHEN_WITHIN;
+        config.time_min = 5e-6f;
+        config.time_max = 60e-6f;
+        configure(&config);
+
+        static uint32_t ref[MAX_TRIGGERS], hits[MAX_TRIGGERS];
+        uint32_t num_ref = find_triggers(g_sig, g_len, 0, ref);
+        CHECK(num_ref > 5, "%s: only %lu trigger(s) on the random signal",
+              osc_trigger_get_type_str(config.type), (unsigned long)num_ref);
+
+        static const uint32_t blocks[] = { 1, 7, 64 };
+        for (int b = 0; b < 3; b++) {
+            uint32_t count = find_triggers(g_sig, g_len, blocks[b], hits);
+            CHECK(count == num_ref && memcmp(hits, ref, count * sizeof(uint32_t)) == 0,
+                  "%s: blocks of %lu differ from one call", osc_trigger_get_type_str(config.type),
+                  (unsigned long)blocks[b]);
+        }
+    }
+}
+
+static void test_invalid(void)
+{
+    osc_trigger_config_t config = make_config(OSC_TRIGGER_RUNT, true, 2.0f, 1.0f);
+    CHECK(osc_trigger_validate(&config) == ESP_ERR_INVALID_ARG, "runt with low above high accepted");
+
+    config = make_config(OSC_TRIGGER_SLOPE, true, 1.0f, 2.0f);
+    config.when = OSC_TRIGGER_WHEN_WITHIN;
+    config.time_min = 10e-6f;
+    config.time_max = 5e-6f;
+    CHECK(osc_trigger_validate(&config) == ESP_ERR_INVALID_ARG, "empty time range accepted");
+
+    config = make_config(OSC_TRIGGER_PULSE_WIDTH, true, 0.0f, 1.5f);
+    config.when = OSC_TRIGGER_WHEN_LESS;
+    CHECK(osc_trigger_validate(&config) == ESP_ERR_INVALID_ARG, "pulse width without time_max accepted");
+
+    config = make_config(OSC_TRIGGER_TIMEOUT, true, 0.0f, 1.5f);
+    CHECK(osc_trigger_validate(&config) == ESP_ERR_INVALID_ARG, "timeout without time_min accepted");
+
+    config = make_config(OSC_TRIGGER_TYPE_MAX, true, 0.0f, 1.5f);
+    CHECK(osc_trigger_validate(&config) == ESP_ERR_INVALID_ARG, "unknown type accepted");
+    CHECK(osc_trigger_configure(g_trig, &config, SAMPLE_RATE) == ESP_ERR_INVALID_ARG, "configure accepted it");
+}
+
+int main(int argc, char **argv)
+{
+    g_trig = osc_trigger_init();
+    if (g_trig == NULL) return 1;
+
+    test_edge();
+    test_pulse_width();
+    test_runt();
+    test_slope();
+    test_window();
+    test_timeout();
+    test_blocks();
+    test_invalid();
+
+    osc_trigger_deinit(g_trig);
+    printf("%s (%d failure%s)\n", g_failures ? "FAILED" : "passed", g_failures, g_failures == 1 ? "" : "s");
+    return g_failures ? 1 : 0;
+}
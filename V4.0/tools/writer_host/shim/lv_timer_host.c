@@ -0,0 +1,63 @@
+/**
+ * @file lv_timer_host.c
+ * @brief Host stand-in for the LVGL timers used by storage_writer
+ */
+
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#define MAX_TIMERS  8
+
+struct _lv_timer_t {
+    lv_timer_cb_t cb;
+    uint32_t period;
+    uint32_t last_run;
+    void *user_data;
+    bool used;
+};
+
+static lv_timer_t s_timers[MAX_TIMERS];
+
+static uint32_t tick_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+
+lv_timer_t *lv_timer_create(lv_timer_cb_t cb, uint32_t period, void *user_data)
+{
+    for (int i = 0; i < MAX_TIMERS; i++) {
+        if (!s_timers[i].used) {
+            s_timers[i] = (lv_timer_t){ .cb = cb, .period = period, .last_run = tick_ms(),
+                                        .user_data = user_data, .used = true };
+            return &s_timers[i];
+        }
+    }
+    return NULL;
+}
+
+void lv_timer_del(lv_timer_t *timer)
+{
+    if (timer != NULL) timer->used = false;
+}
+
+/* Returns the time until the next timer is due */
+uint32_t lv_timer_handler(void)
+{
+    uint32_t next = 500;
+    for (int i = 0; i < MAX_TIMERS; i++) {
+        lv_timer_t *timer = &s_timers[i];
+        if (!timer->used) continue;
+        uint32_t elapsed = tick_ms() - timer->last_run;
+        if (elapsed >= timer->period) {
+            timer->last_run = tick_ms();
+            timer->cb(timer);
+            elapsed = 0;
+        }
+        if (timer->used && timer->period - elapsed < next) next = timer->period - elapsed;
+    }
+    return next;
+}
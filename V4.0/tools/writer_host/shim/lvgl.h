@@ -0,0 +1,21 @@
+/**
+ * @file lvgl.h
+ * @brief Host stand-in for the LVGL timers used by storage_writer
+ *
+ * lv_timer_handler() runs every timer that is due, on the calling thread,
+ * which plays the LVGL thread.
+ */
+
+#ifndef WRITER_HOST_LVGL_H
+#define WRITER_HOST_LVGL_H
+
+#include <stdint.h>
+
+typedef struct _lv_timer_t lv_timer_t;
+typedef void (*lv_timer_cb_t)(lv_timer_t *timer);
+
+lv_timer_t *lv_timer_create(lv_timer_cb_t cb, uint32_t period, void *user_data);
+void lv_timer_del(lv_timer_t *timer);
+uint32_t lv_timer_handler(void);
+
+#endif /* WRITER_HOST_LVGL_H */
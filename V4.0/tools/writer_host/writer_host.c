@@ -0,0 +1,463 @@
+/**
+ * @file writer_host.c
+ * @brief Storage writer on the host: tests and a throughput benchmark
+ *
+ * Runs the device's storage_writer.c unchanged on the FreeRTOS shim. fwrite()
+ * and fsync() are wrapped (-Wl,--wrap) into a simulated SD card that costs a
+ * fixed latency per write plus the transfer at a set bandwidth, and can be
+ * stalled or made to fail. The main thread plays the LVGL thread and runs
+ * the drain timer.
+ *
+ * The tests queue jobs with random fill chunk sizes and require the exact
+ * bytes on disk, one fsync per file, monotonic progress and finish before
+ * done, in submission order. A stalled card must fill the job slots and
+ * time out a flush; fill errors, write errors and bad paths must remove the
+ * partial file and leave the writer usable. With formatting and card time
+ * equal, double buffering must beat the serial sum.
+ *
+ * The benchmark writes an 8 MB binary job and a 4 MB CSV job (snprintf per
+ * line, like the chart export) through every buffer size, against the
+ * card's own limit for that block size and the serial format-then-write
+ * rate.
+ *
+ *   ./writer_host                           # tests, exit status 1 on failure
+ *   ./writer_host --bench [latency_us KB/s] # benchmark (default 800 us, 20000 KB/s)
+ */
+
+#include "storage_writer.h"
+#include "lvgl.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TMP_DIR "writer_host.tmp"
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        g_failures++; \
+        printf("  FAIL %s:%d: ", __func__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+static uint32_t g_seed = 12345;
+
+static uint32_t rnd(void)
+{
+    g_seed = g_seed * 1103515245u + 12345u;
+    return g_seed >> 8;
+}
+
+/* ==================== Simulated SD card ==================== */
+
+typedef struct {
+    uint32_t latency_us;            // Per write: command, FAT update, card busy
+    uint32_t kbps;                  // Transfer rate, 0 = unlimited
+    uint32_t sync_us;
+    volatile bool stall;            // Hold writes until cleared
+    uint64_t fail_after;            // Fail the write that crosses this many bytes (0 = never)
+    uint64_t bytes;
+    uint32_t writes;
+    uint32_t syncs;
+} sim_card_t;
+
+static sim_card_t g_card;
+
+size_t __real_fwrite(const void *ptr, size_t size, size_t count, FILE *f);
+int __real_fsync(int fd);
+
+size_t __wrap_fwrite(const void *ptr, size_t size, size_t count, FILE *f)
+{
+    size_t len = size * count;
+    while (g_card.stall) usleep(1000);
+
+    uint64_t us = g_card.latency_us;
+    if (g_card.kbps > 0) us += (uint64_t)len * 1000000 / ((uint64_t)g_card.kbps * 1024);
+    if (us > 0) usleep((useconds_t)us);
+
+    g_card.writes++;
+    if (g_card.fail_after > 0 && g_card.bytes + len > g_card.fail_after) return 0;
+    g_card.bytes += len;
+    return __real_fwrite(ptr, size, count, f);
+}
+
+int __wrap_fsync(int fd)
+{
+    g_card.syncs++;
+    if (g_card.sync_us > 0) usleep(g_card.sync_us);
+    return __real_fsync(fd);
+}
+
+static void card_reset(uint32_t latency_us, uint32_t kbps)
+{
+    memset(&g_card, 0, sizeof(g_card));
+    g_card.latency_us = latency_us;
+    g_card.kbps = kbps;
+}
+
+/* ==================== Jobs ==================== */
+
+typedef struct {
+    uint64_t total;                 // Bytes to produce
+    uint64_t produced;
+    uint8_t seed;
+    size_t max_chunk;               // Random chunks up to this size, 0 = whole buffer
+    uint32_t fill_us;               // Simulated formatting time per call
+    int fail_call;                  // Fail this call (0 = never)
+    int calls;
+
+    bool finished;
+    esp_err_t finish_result;
+    uint64_t progress;
+    bool progress_backwards;
+    bool done;
+    esp_err_t done_result;
+    bool done_before_finish;
+    int done_order;
+} job_ctx_t;
+
+static int g_done_count = 0;
+
+static uint8_t pattern(uint64_t offset, uint8_t seed)
+{
+    return (uint8_t)(offset * 131 + (offset >> 9) + seed);
+}
+
+static esp_err_t fill_pattern(void *user, uint8_t *buf, size_t size, size_t *len)
+{
+    job_ctx_t *ctx = user;
+    if (++ctx->calls == ctx->fail_call) return ESP_ERR_INVALID_STATE;
+    if (ctx->fill_us > 0) usleep(ctx->fill_us);
+
+    size_t n = size;
+    if (ctx->max_chunk > 0) n = 1 + rnd() % (ctx->max_chunk < size ? ctx->max_chunk : size);
+    if (n > ctx->total - ctx->produced) n = (size_t)(ctx->total - ctx->produced);
+    for (size_t i = 0; i < n; i++) buf[i] = pattern(ctx->produced + i, ctx->seed);
+    ctx->produced += n;
+    *len = n;
+    return ESP_OK;
+}
+
+/* CSV rows of a sine, one snprintf per line, as the chart export formats them */
+static esp_err_t fill_csv(void *user, uint8_t *buf, size_t size, size_t *len)
+{
+    job_ctx_t *ctx = user;
+    size_t n = 0;
+    char line[48];
+    while (ctx->produced + n < ctx->total) {
+        uint64_t row = (uint64_t)ctx->calls++;
+        int l = snprintf(line, sizeof(line), "%.9f,%.6f\n", row * 1e-6, 1.65 + 1.2 * sin(row * 0.0062831853));
+        if (n + (size_t)l > size) {
+            ctx->calls--;
+            break;
+        }
+        memcpy(buf + n, line, (size_t)l);
+        n += (size_t)l;
+    }
+    ctx->produced += n;
+    *len = n;
+    return ESP_OK;
+}
+
+static void job_finish(void *user, esp_err_t result, const char *path)
+{
+    job_ctx_t *ctx = user;
+    ctx->finished = true;
+    ctx->finish_result = result;
+}
+
+static void job_progress(void *user, uint64_t bytes_done, uint64_t bytes_total)
+{
+    job_ctx_t *ctx = user;
+    if (bytes_done < ctx->progress || bytes_done > bytes_total) ctx->progress_backwards = true;
+    ctx->progress = bytes_done;
+}
+
+static void job_done(void *user, esp_err_t result, const char *path)
+{
+    job_ctx_t *ctx = user;
+    ctx->done = true;
+    ctx->done_result = result;
+    ctx->done_before_finish = !ctx->finished;
+    ctx->done_order = g_done_count++;
+}
+
+static esp_err_t submit(job_ctx_t *ctx, const char *name, storage_writer_fill_fn fill)
+{
+    storage_writer_job_t job = {
+        .total_bytes = ctx->total,
+        .fill = fill,
+        .finish = job_finish,
+        .user = ctx,
+        .on_progress = job_progress,
+        .on_done = job_done,
+        .cb_user = ctx,
+    };
+    snprintf(job.path, sizeof(job.path), "%s/%s", TMP_DIR, name);
+    return storage_writer_submit(&job);
+}
+
+/* Run the LVGL side until every job has reported done */
+static bool wait_done(job_ctx_t *jobs, int count, uint32_t timeout_ms)
+{
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    for (;;) {
+        lv_timer_handler();
+        int done = 0;
+        for (int i = 0; i < count; i++) done += jobs[i].done;
+        if (done == count) return true;
+        if (esp_timer_get_time() > deadline) return false;
+        usleep(2000);
+    }
+}
+
+static bool file_matches(const char *name, const job_ctx_t *ctx)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "%s/%s", TMP_DIR, name);
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+    bool ok = true;
+    uint64_t offset = 0;
+    int c;
+    while ((c = fgetc(f)) != EOF) {
+        if (offset >= ctx->total || c != pattern(offset, ctx->seed)) ok = false;
+        offset++;
+    }
+    fclose(f);
+    return ok && offset == ctx->total;
+}
+
+static bool file_exists(const char *name)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "%s/%s", TMP_DIR, name);
+    return access(path, F_OK) == 0;
+}
+
+/* ==================== Tests ==================== */
+
+static void test_round_trip(void)
+{
+    const size_t buffer = 4096;
+    static const uint64_t sizes[STORAGE_WRITER_MAX_JOBS] = {
+        0, 1, 4095, 4096, 4097, 100000, 262144 + 17, 1 << 20,
+    };
+    job_ctx_t jobs[STORAGE_WRITER_MAX_JOBS] = { 0 };
+    char name[16];
+
+    card_reset(0, 0);
+    g_done_count = 0;
+    CHECK(storage_writer_init(buffer) == ESP_OK, "init");
+    for (int i = 0; i < STORAGE_WRITER_MAX_JOBS; i++) {
+        jobs[i].total = sizes[i];
+        jobs[i].seed = (uint8_t)(i * 37);
+        jobs[i].max_chunk = (i % 2) ? buffer : 0;      // Short fills on odd jobs
+        snprintf(name, sizeof(name), "job%d.bin", i);
+        CHECK(submit(&jobs[i], name, fill_pattern) == ESP_OK, "submit %d", i);
+    }
+    CHECK(wait_done(jobs, STORAGE_WRITER_MAX_JOBS, 10000), "jobs did not finish");
+
+    uint64_t total = 0;
+    for (int i = 0; i < STORAGE_WRITER_MAX_JOBS; i++) {
+        snprintf(name, sizeof(name), "job%d.bin", i);
+        CHECK(jobs[i].finish_result == ESP_OK && jobs[i].done_result == ESP_OK, "job %d result %d/%d", i,
+              jobs[i].finish_result, jobs[i].done_result);
+        CHECK(file_matches(name, &jobs[i]), "job %d: file content differs", i);
+        CHECK(!jobs[i].done_before_finish, "job %d: done before finish", i);
+        CHECK(jobs[i].done_order == i, "job %d reported as %d", i, jobs[i].done_order);
+        CHECK(!jobs[i].progress_backwards && (sizes[i] == 0 || jobs[i].progress == sizes[i]),
+              "job %d: progress %llu of %llu", i, (unsigned long long)jobs[i].progress,
+              (unsigned long long)sizes[i]);
+        total += sizes[i];
+    }
+    CHECK(g_card.syncs == STORAGE_WRITER_MAX_JOBS, "%lu syncs for %d files", (unsigned long)g_card.syncs,
+          STORAGE_WRITER_MAX_JOBS);
+
+    storage_writer_stats_t stats;
+    storage_writer_get_stats(&stats);
+    CHECK(stats.jobs_done == STORAGE_WRITER_MAX_JOBS && stats.jobs_failed == 0 && stats.bytes_written == total,
+          "stats: %lu done, %lu failed, %llu bytes", (unsigned long)stats.jobs_done,
+          (unsigned long)stats.jobs_failed, (unsigned long long)stats.bytes_written);
+    storage_writer_deinit();
+}
+
+static void test_stalled_card(void)
+{
+    job_ctx_t jobs[STORAGE_WRITER_MAX_JOBS + 1] = { 0 };
+    char name[16];
+
+    card_reset(0, 0);
+    g_card.stall = true;
+    CHECK(storage_writer_init(4096) == ESP_OK, "init");
+    for (int i = 0; i <= STORAGE_WRITER_MAX_JOBS; i++) {
+        jobs[i].total = 64 * 1024;
+        snprintf(name, sizeof(name), "stall%d.bin", i);
+        int64_t t0 = esp_timer_get_time();
+        esp_err_t ret = submit(&jobs[i], name, fill_pattern);
+        int64_t us = esp_timer_get_time() - t0;
+        CHECK(us < 5000, "submit %d blocked for %lld us", i, (long long)us);
+        if (i < STORAGE_WRITER_MAX_JOBS) {
+            CHECK(ret == ESP_OK, "submit %d: %d", i, ret);
+        } else {
+            CHECK(ret == ESP_ERR_NO_MEM, "submit past the slots: %d", ret);
+        }
+    }
+    CHECK(storage_writer_pending() == STORAGE_WRITER_MAX_JOBS, "%lu pending",
+          (unsigned long)storage_writer_pending());
+    CHECK(storage_writer_flush(50) == ESP_ERR_TIMEOUT, "flush with a stalled card");
+
+    g_card.stall = false;
+    CHECK(storage_writer_flush(5000) == ESP_OK, "flush after the stall");
+    CHECK(wait_done(jobs, STORAGE_WRITER_MAX_JOBS, 1000), "jobs did not report");
+    storage_writer_deinit();
+}
+
+static void test_errors(void)
+{
+    job_ctx_t fill_error = { .total = 100000, .fail_call = 3 };
+    job_ctx_t write_error = { .total = 100000 };
+    job_ctx_t bad_path = { .total = 1000 };
+    job_ctx_t after = { .total = 50000, .seed = 9 };
+
+    card_reset(0, 0);
+    storage_writer_job_t job = { .path = TMP_DIR "/x.bin" };
+    job.fill = fill_pattern;
+    CHECK(storage_writer_submit(&job) == ESP_ERR_INVALID_STATE, "submit before init");
+
+    CHECK(storage_writer_init(8192) == ESP_OK, "init");
+    CHECK(storage_writer_submit(NULL) == ESP_ERR_INVALID_ARG, "NULL job");
+    job.fill = NULL;
+    CHECK(storage_writer_submit(&job) == ESP_ERR_INVALID_ARG, "job without fill");
+    job.fill = fill_pattern;
+    job.path[0] = '\0';
+    CHECK(storage_writer_submit(&job) == ESP_ERR_INVALID_ARG, "job without path");
+
+    CHECK(submit(&fill_error, "fill_error.bin", fill_pattern) == ESP_OK, "submit");
+    CHECK(wait_done(&fill_error, 1, 5000), "fill error did not report");
+    CHECK(fill_error.done_result == ESP_ERR_INVALID_STATE, "fill error reported as %d", fill_error.done_result);
+    CHECK(!file_exists("fill_error.bin"), "partial file left after a fill error");
+
+    g_card.fail_after = g_card.bytes + 20000;
+    CHECK(submit(&write_error, "write_error.bin", fill_pattern) == ESP_OK, "submit");
+    CHECK(wait_done(&write_error, 1, 5000), "write error did not report");
+    CHECK(write_error.done_result == ESP_FAIL, "write error reported as %d", write_error.done_result);
+    CHECK(!file_exists("write_error.bin"), "partial file left after a write error");
+    g_card.fail_after = 0;
+
+    CHECK(submit(&bad_path, "missing/dir.bin", fill_pattern) == ESP_OK, "submit");
+    CHECK(wait_done(&bad_path, 1, 5000), "bad path did not report");
+    CHECK(bad_path.done_result == ESP_FAIL && bad_path.calls == 0, "bad path: result %d, %d fills",
+          bad_path.done_result, bad_path.calls);
+
+    CHECK(submit(&after, "after.bin", fill_pattern) == ESP_OK, "submit");
+    CHECK(wait_done(&after, 1, 5000), "job after the errors did not report");
+    CHECK(after.done_result == ESP_OK && file_matches("after.bin", &after), "job after the errors failed");
+
+    storage_writer_stats_t stats;
+    storage_writer_get_stats(&stats);
+    CHECK(stats.jobs_done == 1 && stats.jobs_failed == 3, "stats: %lu done, %lu failed",
+          (unsigned long)stats.jobs_done, (unsigned long)stats.jobs_failed);
+    storage_writer_deinit();
+    CHECK(storage_writer_submit(&job) == ESP_ERR_INVALID_ARG, "empty path after deinit");
+    snprintf(job.path, sizeof(job.path), "%s/x.bin", TMP_DIR);
+    CHECK(storage_writer_submit(&job) == ESP_ERR_INVALID_STATE, "submit after deinit");
+}
+
+static void test_overlap(void)
+{
+    // Formatting and card time equal: double buffering should approach half the serial time
+    const int blocks = 40;
+    const uint32_t step_us = 2000;
+    job_ctx_t job = { .total = (uint64_t)blocks * 4096, .fill_us = step_us };
+
+    card_reset(step_us, 0);
+    CHECK(storage_writer_init(4096) == ESP_OK, "init");
+    int64_t t0 = esp_timer_get_time();
+    CHECK(submit(&job, "overlap.bin", fill_pattern) == ESP_OK, "submit");
+    CHECK(storage_writer_flush(5000) == ESP_OK, "flush");
+    double ms = (esp_timer_get_time() - t0) / 1000.0;
+    double serial_ms = 2.0 * blocks * step_us / 1000.0;
+    CHECK(wait_done(&job, 1, 1000), "job did not report");
+    storage_writer_deinit();
+
+    printf("  overlap: %d blocks of %.1f ms fill + %.1f ms write in %.0f ms (serial %.0f ms)\n", blocks,
+           step_us / 1000.0, step_us / 1000.0, ms, serial_ms);
+    CHECK(ms < 0.75 * serial_ms, "no overlap: %.0f ms against %.0f ms serial", ms, serial_ms);
+}
+
+/* ==================== Benchmark ==================== */
+
+static uint32_t run_bench_job(size_t buffer, uint64_t total, storage_writer_fill_fn fill)
+{
+    job_ctx_t job = { .total = total };
+    storage_writer_init(buffer);
+    submit(&job, "bench.bin", fill);
+    storage_writer_flush(600000);
+    wait_done(&job, 1, 1000);
+    storage_writer_stats_t stats;
+    storage_writer_get_stats(&stats);
+    storage_writer_deinit();
+    return stats.last_kbps;
+}
+
+static void bench(uint32_t latency_us, uint32_t kbps)
+{
+    static const size_t buffers[] = { 4096, 8192, 16384, 32768, 65536, 131072, 262144 };
+    const uint64_t bin_bytes = 8u << 20;
+    const uint64_t csv_bytes = 4u << 20;
+
+    // Formatting rate alone, for the serial comparison
+    static uint8_t scratch[65536];
+    job_ctx_t csv = { .total = csv_bytes };
+    int64_t t0 = esp_timer_get_time();
+    size_t len;
+    while (csv.produced < csv.total) fill_csv(&csv, scratch, sizeof(scratch), &len);
+    double csv_kbps = csv_bytes / 1024.0 / ((esp_timer_get_time() - t0) / 1e6);
+
+    printf("\ncard: %lu us per write, %lu KB/s; CSV formatting %.0f KB/s\n", (unsigned long)latency_us,
+           (unsigned long)kbps, csv_kbps);
+    printf("  %8s %8s %10s %10s %10s %10s\n", "buffer", "writes", "card KB/s", "bin KB/s", "CSV KB/s",
+           "serial");
+    for (size_t i = 0; i < sizeof(buffers) / sizeof(buffers[0]); i++) {
+        size_t b = buffers[i];
+        double card = b / 1024.0 / (latency_us / 1e6 + b / 1024.0 / kbps);
+        card_reset(latency_us, kbps);
+        uint32_t bin = run_bench_job(b, bin_bytes, fill_pattern);
+        uint32_t writes = g_card.writes;
+        card_reset(latency_us, kbps);
+        uint32_t text = run_bench_job(b, csv_bytes, fill_csv);
+        double serial = 1.0 / (1.0 / card + 1.0 / csv_kbps);
+        printf("  %7zuK %8lu %10.0f %10lu %10lu %10.0f\n", b / 1024, (unsigned long)writes, card,
+               (unsigned long)bin, (unsigned long)text, serial);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    mkdir(TMP_DIR, 0755);
+
+    test_round_trip();
+    test_stalled_card();
+    test_errors();
+    test_overlap();
+
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        uint32_t latency_us = argc > 2 ? (uint32_t)atoi(argv[2]) : 800;
+        uint32_t kbps = argc > 3 ? (uint32_t)atoi(argv[3]) : 20000;
+        bench(latency_us, kbps > 0 ? kbps : 20000);
+    }
+
+    printf("%s (%d failure%s)\n", g_failures ? "FAILED" : "passed", g_failures, g_failures == 1 ? "" : "s");
+    return g_failures ? 1 : 0;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file uart.h
+ * @brief Host stand-in for the ESP-IDF UART driver, on a pseudo-terminal
+ *
+ * uart_shim_attach() hands a port the slave side of a pty. A reader thread
+ * plays the driver's ISR: it moves bytes from the pty into the RX buffer and
+ * posts UART_DATA events. With flow control configured it stops reading while
+ * that buffer is full, so the pty fills and the writer on the master side
+ * blocks, which is what RTS/CTS or XON/XOFF do to a real sender. Without it,
+ * what does not fit is thrown away and a UART_FIFO_OVF is posted.
+ */
+
+#ifndef WS_HOST_UART_H
+#define WS_HOST_UART_H
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int uart_port_t;
+
+#define UART_NUM_MAX            3
+#define UART_PIN_NO_CHANGE      (-1)
+#define UART_SCLK_DEFAULT       0
+#define UART_HW_FIFO_LEN(port)  128
+
+typedef enum { UART_DATA_5_BITS, UART_DATA_6_BITS, UART_DATA_7_BITS, UART_DATA_8_BITS } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE, UART_PARITY_EVEN = 2, UART_PARITY_ODD } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1, UART_STOP_BITS_1_5, UART_STOP_BITS_2 } uart_stop_bits_t;
+typedef enum {
+    UART_HW_FLOWCTRL_DISABLE,
+    UART_HW_FLOWCTRL_RTS,
+    UART_HW_FLOWCTRL_CTS,
+    UART_HW_FLOWCTRL_CTS_RTS,
+} uart_hw_flowcontrol_t;
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uint8_t rx_flow_ctrl_thresh;
+    int source_clk;
+} uart_config_t;
+
+typedef enum {
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR,
+    UART_DATA_BREAK,
+    UART_PATTERN_DET,
+    UART_EVENT_MAX,
+} uart_event_type_t;
+
+typedef struct {
+    uart_event_type_t type;
+    size_t size;
+    bool timeout_flag;
+} uart_event_t;
+
+/** Host only: serve the port from this file descriptor (a pty slave) */
+void uart_shim_attach(uart_port_t port, int fd);
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, QueueHandle_t *queue, int intr_flags);
+esp_err_t uart_driver_delete(uart_port_t port);
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config);
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts);
+esp_err_t uart_set_sw_flow_ctrl(uart_port_t port, bool enable, uint8_t rx_thresh_xon, uint8_t rx_thresh_xoff);
+esp_err_t uart_set_rx_timeout(uart_port_t port, uint8_t tout_thresh);
+esp_err_t uart_set_rx_full_threshold(uart_port_t port, int threshold);
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t *size);
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t length, TickType_t ticks);
+int uart_write_bytes(uart_port_t port, const void *src, size_t size);
+esp_err_t uart_flush_input(uart_port_t port);
+
+#endif /* WS_HOST_UART_H */
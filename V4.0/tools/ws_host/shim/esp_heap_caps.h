@@ -0,0 +1,28 @@
+/**
+ * @file esp_heap_caps.h
+ * @brief Host stand-in for the ESP-IDF capability allocator used by byte_ring,
+ *        storage_writer and the recorder
+ */
+
+#ifndef WS_HOST_ESP_HEAP_CAPS_H
+#define WS_HOST_ESP_HEAP_CAPS_H
+
+#include <stdlib.h>
+
+#define MALLOC_CAP_SPIRAM       (1 << 10)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_DMA          (1 << 3)
+
+#define heap_caps_malloc(size, caps)    malloc(size)
+#define heap_caps_calloc(n, size, caps) calloc(n, size)
+#define heap_caps_free(ptr)             free(ptr)
+
+static inline void *heap_caps_aligned_alloc(size_t alignment, size_t size, unsigned caps)
+{
+    (void)caps;
+    void *ptr = NULL;
+    return posix_memalign(&ptr, alignment, size) == 0 ? ptr : NULL;
+}
+
+#endif /* WS_HOST_ESP_HEAP_CAPS_H */
@@ -0,0 +1,19 @@
+/**
+ * @file esp_timer.h
+ * @brief Host stand-in for esp_timer_get_time()
+ */
+
+#ifndef WS_HOST_ESP_TIMER_H
+#define WS_HOST_ESP_TIMER_H
+
+#include <stdint.h>
+#include <time.h>
+
+static inline int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#endif /* WS_HOST_ESP_TIMER_H */
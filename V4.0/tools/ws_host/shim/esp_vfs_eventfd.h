@@ -0,0 +1,24 @@
+/**
+ * @file esp_vfs_eventfd.h
+ * @brief Host stand-in for the ESP-IDF eventfd VFS (Linux has eventfd built in)
+ */
+
+#ifndef WS_HOST_ESP_VFS_EVENTFD_H
+#define WS_HOST_ESP_VFS_EVENTFD_H
+
+#include "esp_err.h"
+#include <sys/eventfd.h>
+
+typedef struct {
+    int max_fds;
+} esp_vfs_eventfd_config_t;
+
+#define ESP_VFS_EVENTD_CONFIG_DEFAULT() { .max_fds = 5 }
+
+static inline esp_err_t esp_vfs_eventfd_register(const esp_vfs_eventfd_config_t *config)
+{
+    (void)config;
+    return ESP_OK;
+}
+
+#endif /* WS_HOST_ESP_VFS_EVENTFD_H */
@@ -0,0 +1,31 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for the FreeRTOS types used by uart_bridge and the host
+ *        harnesses (1 tick = 1 ms, critical sections on a pthread mutex)
+ */
+
+#ifndef WS_HOST_FREERTOS_H
+#define WS_HOST_FREERTOS_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  pdTRUE
+#define portMAX_DELAY           ((TickType_t)0xffffffffu)
+#define portTICK_PERIOD_MS      1
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+
+typedef pthread_mutex_t portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    PTHREAD_MUTEX_INITIALIZER
+#define portMUX_INITIALIZE(mux)         pthread_mutex_init(mux, NULL)
+#define portENTER_CRITICAL(mux)         pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL(mux)          pthread_mutex_unlock(mux)
+
+#endif /* WS_HOST_FREERTOS_H */
@@ -0,0 +1,19 @@
+/**
+ * @file queue.h
+ * @brief Host stand-in for FreeRTOS queues, on a mutex and a condition variable
+ */
+
+#ifndef WS_HOST_QUEUE_H
+#define WS_HOST_QUEUE_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_queue *QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+void vQueueDelete(QueueHandle_t queue);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks);
+BaseType_t xQueueReset(QueueHandle_t queue);
+
+#endif /* WS_HOST_QUEUE_H */
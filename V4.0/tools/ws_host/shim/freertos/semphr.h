@@ -0,0 +1,22 @@
+/**
+ * @file semphr.h
+ * @brief Host stand-in for FreeRTOS binary semaphores and mutexes
+ *
+ * Both are a count of at most one: a mutex starts given, a binary semaphore
+ * taken. There is no priority inheritance and no owner check.
+ */
+
+#ifndef WS_HOST_SEMPHR_H
+#define WS_HOST_SEMPHR_H
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct host_semaphore *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+
+#endif /* WS_HOST_SEMPHR_H */
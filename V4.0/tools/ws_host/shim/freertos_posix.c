@@ -0,0 +1,252 @@
+/**
+ * @file freertos_posix.c
+ * @brief Host stand-in for the FreeRTOS calls used by uart_bridge and the host
+ *        harnesses, on pthreads
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+struct host_task {
+    pthread_t thread;
+    TaskFunction_t fn;
+    void *arg;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t notified;
+};
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+struct host_semaphore {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint32_t count;
+};
+
+static __thread struct host_task *s_current;
+
+/* Absolute deadline `ticks` ms from now; false for portMAX_DELAY */
+static bool deadline(TickType_t ticks, struct timespec *ts)
+{
+    if (ticks == portMAX_DELAY) return false;
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec += ticks / 1000;
+    ts->tv_nsec += (long)(ticks % 1000) * 1000000;
+    if (ts->tv_nsec >= 1000000000) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+    return true;
+}
+
+/* Wait on cond; false once the deadline has passed */
+static bool wait(pthread_cond_t *cond, pthread_mutex_t *lock, bool timed, const struct timespec *ts)
+{
+    if (!timed) return pthread_cond_wait(cond, lock) == 0;
+    return pthread_cond_timedwait(cond, lock, ts) != ETIMEDOUT;
+}
+
+static void *task_main(void *arg)
+{
+    struct host_task *task = arg;
+    s_current = task;
+    task->fn(task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                       UBaseType_t priority, TaskHandle_t *handle)
+{
+    (void)name;
+    (void)stack;
+    (void)priority;
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task == NULL) return pdFALSE;
+    task->fn = fn;
+    task->arg = arg;
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->cond, NULL);
+    if (handle) *handle = task;
+    if (pthread_create(&task->thread, NULL, task_main, task) != 0) {
+        free(task);
+        return pdFALSE;
+    }
+    pthread_detach(task->thread);
+    return pdPASS;
+}
+
+/* Only vTaskDelete(NULL) is used; the handle is not freed (it may still be notified) */
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL) pthread_exit(NULL);
+}
+
+/* NULL on threads not created by xTaskCreate (e.g. main) */
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return s_current;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    usleep((useconds_t)ticks * 1000);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    pthread_mutex_lock(&task->lock);
+    task->notified++;
+    pthread_cond_signal(&task->cond);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks)
+{
+    struct host_task *task = s_current;
+    struct timespec ts;
+    bool timed = deadline(ticks, &ts);
+
+    pthread_mutex_lock(&task->lock);
+    while (task->notified == 0 && wait(&task->cond, &task->lock, timed, &ts)) {
+    }
+    uint32_t value = task->notified;
+    if (value > 0) task->notified = clear ? 0 : value - 1;
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue *queue = calloc(1, sizeof(*queue));
+    if (queue == NULL) return NULL;
+    queue->items = calloc(length, item_size);
+    queue->length = length;
+    queue->item_size = item_size;
+    pthread_mutex_init(&queue->lock, NULL);
+    pthread_cond_init(&queue->cond, NULL);
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue == NULL) return;
+    free(queue->items);
+    free(queue);
+}
+
+/* Senders and receivers share one condition variable, so every change wakes all waiters */
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    struct timespec ts;
+    bool timed = deadline(ticks, &ts);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length && ticks != 0 && wait(&queue->cond, &queue->lock, timed, &ts)) {
+    }
+    BaseType_t ok = queue->count < queue->length;
+    if (ok) {
+        UBaseType_t slot = (queue->head + queue->count) % queue->length;
+        memcpy(queue->items + slot * queue->item_size, item, queue->item_size);
+        queue->count++;
+        pthread_cond_broadcast(&queue->cond);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    struct timespec ts;
+    bool timed = deadline(ticks, &ts);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && wait(&queue->cond, &queue->lock, timed, &ts)) {
+    }
+    BaseType_t ok = queue->count > 0;
+    if (ok) {
+        memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+        queue->count--;
+        pthread_cond_broadcast(&queue->cond);
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    queue->head = 0;
+    queue->count = 0;
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+static SemaphoreHandle_t semaphore_create(uint32_t count)
+{
+    struct host_semaphore *sem = calloc(1, sizeof(*sem));
+    if (sem == NULL) return NULL;
+    sem->count = count;
+    pthread_mutex_init(&sem->lock, NULL);
+    pthread_cond_init(&sem->cond, NULL);
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return semaphore_create(0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return semaphore_create(1);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    free(sem);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    struct timespec ts;
+    bool timed = deadline(ticks, &ts);
+
+    pthread_mutex_lock(&sem->lock);
+    while (sem->count == 0 && wait(&sem->cond, &sem->lock, timed, &ts)) {
+    }
+    BaseType_t ok = sem->count > 0;
+    if (ok) sem->count = 0;
+    pthread_mutex_unlock(&sem->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    pthread_mutex_lock(&sem->lock);
+    BaseType_t ok = sem->count == 0;
+    sem->count = 1;
+    pthread_cond_signal(&sem->cond);
+    pthread_mutex_unlock(&sem->lock);
+    return ok ? pdTRUE : pdFALSE;
+}
@@ -0,0 +1,212 @@
+/**
+ * @file uart_pty.c
+ * @brief Host stand-in for the ESP-IDF UART driver, on a pseudo-terminal
+ */
+
+#include "driver/uart.h"
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* One port: the pty, the driver's RX buffer and the "ISR" thread */
+typedef struct {
+    int fd;
+    QueueHandle_t events;
+    pthread_t reader;
+    atomic_bool running;
+    bool flow;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t *buf;
+    size_t size;
+    size_t head;
+    size_t count;
+} uart_port_state_t;
+
+static uart_port_state_t s_ports[UART_NUM_MAX] = {
+    { .fd = -1 }, { .fd = -1 }, { .fd = -1 },
+};
+
+static void post(uart_port_state_t *port, uart_event_type_t type, size_t size)
+{
+    uart_event_t event = { .type = type, .size = size };
+    xQueueSend(port->events, &event, 0);
+}
+
+/* The ISR: FIFO -> RX buffer, one event per read */
+static void *reader_main(void *arg)
+{
+    uart_port_state_t *port = arg;
+    uint8_t fifo[UART_HW_FIFO_LEN(0) * 8];
+    bool overflowing = false;
+
+    while (atomic_load(&port->running)) {
+        pthread_mutex_lock(&port->lock);
+        size_t space = port->size - port->count;
+        pthread_mutex_unlock(&port->lock);
+
+        if (space == 0 && port->flow) {
+            // Stop taking bytes: the pty fills up and the sender blocks
+            usleep(200);
+            continue;
+        }
+
+        struct pollfd pfd = { .fd = port->fd, .events = POLLIN };
+        if (poll(&pfd, 1, 10) <= 0) continue;
+        size_t want = sizeof(fifo);
+        if (port->flow && want > space) want = space;
+        ssize_t n = read(port->fd, fifo, want);
+        if (n <= 0) {
+            usleep(1000);
+            continue;
+        }
+
+        pthread_mutex_lock(&port->lock);
+        size_t take = (size_t)n < port->size - port->count ? (size_t)n : port->size - port->count;
+        for (size_t i = 0; i < take; i++) {
+            port->buf[(port->head + port->count + i) % port->size] = fifo[i];
+        }
+        port->count += take;
+        pthread_cond_signal(&port->cond);
+        pthread_mutex_unlock(&port->lock);
+
+        if (take > 0) post(port, UART_DATA, take);
+        if (take < (size_t)n) {
+            if (!overflowing) post(port, UART_FIFO_OVF, 0);
+            overflowing = true;
+        } else {
+            overflowing = false;
+        }
+    }
+    return NULL;
+}
+
+void uart_shim_attach(uart_port_t port, int fd)
+{
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    s_ports[port].fd = fd;
+}
+
+esp_err_t uart_driver_install(uart_port_t num, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, QueueHandle_t *queue, int intr_flags)
+{
+    (void)tx_buffer_size;
+    (void)intr_flags;
+    if (num < 0 || num >= UART_NUM_MAX || s_ports[num].fd < 0) return ESP_ERR_INVALID_ARG;
+
+    uart_port_state_t *port = &s_ports[num];
+    port->buf = malloc((size_t)rx_buffer_size);
+    port->size = (size_t)rx_buffer_size;
+    port->head = 0;
+    port->count = 0;
+    port->events = xQueueCreate((UBaseType_t)queue_size, sizeof(uart_event_t));
+    pthread_mutex_init(&port->lock, NULL);
+    pthread_cond_init(&port->cond, NULL);
+    if (queue) *queue = port->events;
+    atomic_store(&port->running, true);
+    pthread_create(&port->reader, NULL, reader_main, port);
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t num)
+{
+    uart_port_state_t *port = &s_ports[num];
+    if (!atomic_exchange(&port->running, false)) return ESP_OK;
+
+    pthread_join(port->reader, NULL);
+    vQueueDelete(port->events);
+    free(port->buf);
+    port->buf = NULL;
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t num, const uart_config_t *config)
+{
+    s_ports[num].flow = s_ports[num].flow || config->flow_ctrl == UART_HW_FLOWCTRL_CTS_RTS;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t num, int tx, int rx, int rts, int cts)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_set_sw_flow_ctrl(uart_port_t num, bool enable, uint8_t rx_thresh_xon, uint8_t rx_thresh_xoff)
+{
+    s_ports[num].flow = enable;
+    return ESP_OK;
+}
+
+esp_err_t uart_set_rx_timeout(uart_port_t num, uint8_t tout_thresh)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_set_rx_full_threshold(uart_port_t num, int threshold)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t num, size_t *size)
+{
+    uart_port_state_t *port = &s_ports[num];
+    pthread_mutex_lock(&port->lock);
+    *size = port->count;
+    pthread_mutex_unlock(&port->lock);
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t num, void *buf, uint32_t length, TickType_t ticks)
+{
+    uart_port_state_t *port = &s_ports[num];
+    uint8_t *out = buf;
+
+    pthread_mutex_lock(&port->lock);
+    if (port->count == 0 && ticks > 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += (long)ticks * 1000000;
+        ts.tv_sec += ts.tv_nsec / 1000000000;
+        ts.tv_nsec %= 1000000000;
+        pthread_cond_timedwait(&port->cond, &port->lock, &ts);
+    }
+    size_t n = port->count < length ? port->count : length;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = port->buf[(port->head + i) % port->size];
+    }
+    port->head = (port->head + n) % port->size;
+    port->count -= n;
+    pthread_mutex_unlock(&port->lock);
+    return (int)n;
+}
+
+/* Blocks while the pty is full, as the driver does while its TX buffer is */
+int uart_write_bytes(uart_port_t num, const void *src, size_t size)
+{
+    const uint8_t *p = src;
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = write(s_ports[num].fd, p + done, size - done);
+        if (n <= 0) return done > 0 ? (int)done : -1;
+        done += (size_t)n;
+    }
+    return (int)done;
+}
+
+esp_err_t uart_flush_input(uart_port_t num)
+{
+    uart_port_state_t *port = &s_ports[num];
+    pthread_mutex_lock(&port->lock);
+    port->head = 0;
+    port->count = 0;
+    pthread_mutex_unlock(&port->lock);
+    return ESP_OK;
+}
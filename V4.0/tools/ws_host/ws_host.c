@@ -0,0 +1,358 @@
+/**
+ * @file ws_host.c
+ * @brief Wireless serial hub and UART bridge on the host, with a pty as the UART
+ *
+ * Runs the device's ws_hub.c and uart_bridge.c unchanged. The UART is the
+ * slave side of a pseudo-terminal served by a stand-in for the ESP-IDF UART
+ * driver (shim/uart_pty.c); a device thread writes a numbered byte stream
+ * into the master side (optionally at a fixed rate) and another swallows what
+ * the clients send. Client threads connect over TCP, check the stream for
+ * gaps and send a little data back towards the UART. Slow clients read only
+ * 1 KB every 100 ms, to show they lose data and get dropped without slowing
+ * the others down.
+ *
+ * --stall makes the network loop sleep that long every 100 ms, to fill the
+ * bridge ring: without flow control bytes are dropped (gaps), with it the
+ * pty fills and the device's writes wait instead.
+ *
+ * --send picks how the hub coalesces its sends; the UART -> TCP latency
+ * histogram and the bytes per send() show what that costs and saves.
+ *
+ * The CPU time and hub poll count show whether the loop sleeps while the
+ * bridge holds a batch (--mode throughput at a low --rate).
+ *
+ *   ./ws_host [--clients 4] [--slow 1] [--seconds 5] [--rate 200000] [--port 8888]
+ *             [--mode latency|throughput] [--flow none|rtscts|xonxoff] [--stall 0]
+ *             [--send immediate|coalesced|bulk]
+ *   ./ws_host --clients 0      # serve only (connect with nc / a terminal)
+ */
+
+#include "ws_hub.h"
+#include "uart_bridge.h"
+#include "driver/uart.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <pty.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_TEST_CLIENTS    WS_HUB_MAX_CLIENTS
+#define UART_PORT           1
+#define STREAM_MOD          251     /* Byte k of the stream is k % 251 */
+#define ECHO_BYTES          4096    /* Sent back by each client */
+
+typedef struct {
+    int index;
+    bool slow;
+    uint64_t received;
+    uint64_t gaps;
+    bool dropped;                   /* Connection closed by the hub */
+} test_client_t;
+
+static uint16_t g_port = 8888;
+static double g_rate = 0;           /* Bytes/s into the UART, 0 = as fast as it goes */
+static atomic_bool g_stop;
+static atomic_uint_fast64_t g_generated;
+static atomic_uint_fast64_t g_uart_got;
+static volatile sig_atomic_t g_quit = 0;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* CPU time of the whole process: the hub loop, the bridge tasks and the test threads */
+static double cpu_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The device side of the UART: swallow what the clients send */
+static void *uart_device_rx(void *arg)
+{
+    int fd = *(int *)arg;
+    uint8_t buf[4096];
+
+    while (!atomic_load(&g_stop)) {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        ssize_t got = read(fd, buf, sizeof(buf));
+        if (got > 0) atomic_fetch_add(&g_uart_got, (uint64_t)got);
+    }
+    return NULL;
+}
+
+/* The device side of the UART: produce the stream */
+static void *uart_device_tx(void *arg)
+{
+    int fd = *(int *)arg;
+    uint8_t buf[4096];
+    uint64_t k = 0;
+    double start = now_s();
+
+    while (!atomic_load(&g_stop)) {
+        size_t n = sizeof(buf);
+        if (g_rate > 0) {
+            double due = (now_s() - start) * g_rate - (double)k;
+            if (due < 1) {
+                usleep(1000);
+                continue;
+            }
+            if (due < n) n = (size_t)due;
+        }
+        for (size_t i = 0; i < n; i++) buf[i] = (uint8_t)((k + i) % STREAM_MOD);
+        /* Blocks while the pty is full: the bridge is holding the sender off */
+        struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        ssize_t sent = write(fd, buf, n);
+        if (sent < 0 && errno == EAGAIN) continue;
+        if (sent <= 0) break;
+        k += (uint64_t)sent;
+        atomic_store(&g_generated, k);
+    }
+    return NULL;
+}
+
+static void *client_main(void *arg)
+{
+    test_client_t *c = arg;
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(g_port) };
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        perror("connect");
+        return NULL;
+    }
+
+    /* A little traffic towards the UART */
+    uint8_t out[ECHO_BYTES];
+    memset(out, 'a' + c->index, sizeof(out));
+    send(fd, out, sizeof(out), 0);
+
+    struct timeval tv = { .tv_sec = 0, .tv_usec = 200000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    uint8_t buf[65536];
+    int expect = -1;
+    while (!atomic_load(&g_stop)) {
+        ssize_t n = recv(fd, buf, c->slow ? 1024 : sizeof(buf), 0);
+        if (n == 0) {
+            c->dropped = true;
+            break;
+        }
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) continue;
+            c->dropped = true;
+            break;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            if (expect >= 0 && buf[i] != expect) c->gaps++;
+            expect = (buf[i] + 1) % STREAM_MOD;
+        }
+        c->received += (uint64_t)n;
+        if (c->slow) usleep(100000);
+    }
+    close(fd);
+    return NULL;
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_quit = 1;
+}
+
+/* The bridge as the hub's serial side, as on the device */
+static size_t bridge_rx_peek(void *ctx, const uint8_t **data) { return uart_bridge_rx_peek(ctx, data); }
+static void bridge_rx_consume(void *ctx, size_t len) { uart_bridge_rx_consume(ctx, len); }
+static int bridge_rx_due_ms(void *ctx) { return uart_bridge_rx_due_ms(ctx); }
+static int64_t bridge_rx_stamp_us(void *ctx) { return uart_bridge_rx_oldest_us(ctx); }
+static size_t bridge_tx_space(void *ctx) { return uart_bridge_tx_space(ctx); }
+static size_t bridge_tx_write(void *ctx, const uint8_t *data, size_t len) { return uart_bridge_tx_write(ctx, data, len); }
+
+int main(int argc, char **argv)
+{
+    int clients = 4, slow = 1, stall_ms = 0;
+    tcp_out_mode_t send_mode = TCP_OUT_IMMEDIATE;
+    double seconds = 5;
+    uart_bridge_config_t bridge_config = UART_BRIDGE_CONFIG_DEFAULT();
+    bridge_config.uart_num = UART_PORT;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--clients") == 0) clients = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--slow") == 0) slow = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seconds") == 0) seconds = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--rate") == 0) g_rate = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "--port") == 0) g_port = (uint16_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--stall") == 0) stall_ms = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--send") == 0) {
+            send_mode = strcmp(argv[i + 1], "bulk") == 0      ? TCP_OUT_BULK
+                      : strcmp(argv[i + 1], "coalesced") == 0 ? TCP_OUT_COALESCED
+                                                              : TCP_OUT_IMMEDIATE;
+        }
+        else if (strcmp(argv[i], "--mode") == 0) {
+            bridge_config.mode = strcmp(argv[i + 1], "throughput") == 0 ? UART_BRIDGE_THROUGHPUT : UART_BRIDGE_LOW_LATENCY;
+        } else if (strcmp(argv[i], "--flow") == 0) {
+            bridge_config.flow = strcmp(argv[i + 1], "rtscts") == 0  ? UART_BRIDGE_FLOW_RTS_CTS
+                               : strcmp(argv[i + 1], "xonxoff") == 0 ? UART_BRIDGE_FLOW_XON_XOFF
+                                                                     : UART_BRIDGE_FLOW_NONE;
+        }
+    }
+    if (clients > MAX_TEST_CLIENTS) clients = MAX_TEST_CLIENTS;
+    if (slow > clients) slow = clients;
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, on_signal);
+
+    /* The pty slave is the UART, the master is the external device */
+    int master, slave;
+    if (openpty(&master, &slave, NULL, NULL, NULL) < 0) {
+        perror("openpty");
+        return 1;
+    }
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL, 0) | O_NONBLOCK);
+    uart_shim_attach(UART_PORT, slave);
+    if (bridge_config.flow == UART_BRIDGE_FLOW_RTS_CTS) {
+        bridge_config.rts_pin = 0;  /* Any pin: the pty has no lines */
+        bridge_config.cts_pin = 0;
+    }
+
+    uart_bridge_t *bridge;
+    if (uart_bridge_start(&bridge_config, &bridge) != ESP_OK) return 1;
+
+    ws_hub_serial_t serial = {
+        .wake_fd = uart_bridge_wake_fd(bridge),
+        .rx_peek = bridge_rx_peek,
+        .rx_consume = bridge_rx_consume,
+        .rx_due_ms = bridge_rx_due_ms,
+        .rx_stamp_us = bridge_rx_stamp_us,
+        .tx_space = bridge_tx_space,
+        .tx_write = bridge_tx_write,
+        .ctx = bridge,
+    };
+    static latency_hist_t latency;
+    latency_hist_init(&latency);
+    ws_hub_config_t config = {
+        .port = g_port,
+        .max_clients = 4,
+        .client_queue_size = 16 * 1024,
+        .stall_timeout_ms = 2000,
+        .serial = &serial,
+        .send_mode = send_mode,
+        .latency = &latency,
+    };
+    if (clients > config.max_clients) config.max_clients = clients;
+    ws_hub_t *hub = ws_hub_create(&config);
+    if (hub == NULL) return 1;
+
+    pthread_t device_tx, device_rx;
+    pthread_create(&device_rx, NULL, uart_device_rx, &master);
+
+    /* Wait for every client to be accepted before timing */
+    test_client_t tc[MAX_TEST_CLIENTS];
+    pthread_t threads[MAX_TEST_CLIENTS];
+    for (int i = 0; i < clients; i++) {
+        tc[i] = (test_client_t){ .index = i, .slow = i >= clients - slow };
+        pthread_create(&threads[i], NULL, client_main, &tc[i]);
+    }
+    ws_hub_stats_t stats;
+    do {
+        ws_hub_poll(hub, 10);
+        ws_hub_get_stats(hub, &stats);
+    } while ((int)stats.connections < clients && !g_quit);
+    pthread_create(&device_tx, NULL, uart_device_tx, &master);
+
+    uart_bridge_stats_t bs;
+    uart_bridge_get_stats(bridge, &bs);
+    uint32_t latency_max = 0;
+    uint64_t latency_sum = 0, latency_windows = 0;
+    double start = now_s(), last_stall = start, last_stats = start;
+    double cpu_start = cpu_s();
+    uint64_t polls = 0;
+    while (!g_quit && (clients == 0 || now_s() - start < seconds)) {
+        ws_hub_poll(hub, 10);
+        polls++;
+        double now = now_s();
+        if (stall_ms > 0 && now - last_stall >= 0.1) {
+            usleep(stall_ms * 1000);
+            last_stall = now_s();
+        }
+        if (now - last_stats >= 0.5) {
+            uart_bridge_get_stats(bridge, &bs);
+            if (bs.latency_max_us > latency_max) latency_max = bs.latency_max_us;
+            if (bs.batches > 0) {
+                latency_sum += bs.latency_avg_us;
+                latency_windows++;
+            }
+            last_stats = now;
+        }
+    }
+    double elapsed = now_s() - start;
+    double cpu = cpu_s() - cpu_start;
+    atomic_store(&g_stop, true);
+    for (int i = 0; i < clients; i++) {
+        ws_hub_poll(hub, 0);
+        pthread_join(threads[i], NULL);
+    }
+    pthread_join(device_tx, NULL);
+    pthread_join(device_rx, NULL);
+    ws_hub_get_stats(hub, &stats);
+    uart_bridge_get_stats(bridge, &bs);
+    if (bs.latency_max_us > latency_max) latency_max = bs.latency_max_us;
+
+    uint64_t total = 0;
+    for (int i = 0; i < clients; i++) {
+        total += tc[i].received;
+        printf("client %d%s: %8.2f MB  %7.2f MB/s  gaps %llu%s\n", i, tc[i].slow ? " (slow)" : "       ",
+               tc[i].received / 1e6, tc[i].received / 1e6 / elapsed, (unsigned long long)tc[i].gaps,
+               tc[i].dropped ? "  dropped by hub" : "");
+    }
+    printf("uart in: %.2f MB (%.2f MB/s)  uart out: %llu of %d bytes sent by clients\n",
+           bs.uart_rx / 1e6, bs.uart_rx / 1e6 / elapsed,
+           (unsigned long long)atomic_load(&g_uart_got), clients * ECHO_BYTES);
+    printf("bridge: %s, flow %s, %lu batches of %.0f bytes avg, latency avg %.0f us max %lu us, "
+           "ring dropped %lu, overflows %lu\n",
+           bridge_config.mode == UART_BRIDGE_THROUGHPUT ? "throughput" : "low latency",
+           bridge_config.flow == UART_BRIDGE_FLOW_NONE ? "none" : "on",
+           (unsigned long)bs.batches, bs.batches ? (double)bs.net_tx / bs.batches : 0.0,
+           latency_windows ? (double)latency_sum / latency_windows : 0.0, (unsigned long)latency_max,
+           (unsigned long)bs.rx_dropped, (unsigned long)bs.overflows);
+    printf("aggregate to clients: %.2f MB/s  fan-out dropped %.2f MB  stalled clients %lu  refused %lu\n",
+           total / 1e6 / elapsed, stats.fanout_dropped / 1e6, (unsigned long)stats.stalled,
+           (unsigned long)stats.refused);
+
+    latency_hist_snapshot_t snap;
+    char line[96];
+    latency_hist_snapshot(&latency, &snap, false);
+    latency_hist_format(&snap, line, sizeof(line));
+    printf("send %s: %lu send() calls, %.0f bytes per send; uart -> tcp %s\n", tcp_out_mode_name(send_mode),
+           (unsigned long)stats.fanout_sends, stats.fanout_sends ? (double)stats.fanout_sent / stats.fanout_sends : 0.0,
+           line);
+    for (int b = 0; b < LATENCY_HIST_BUCKETS; b++) {
+        if (snap.counts[b] == 0) continue;
+        uint32_t bound = latency_hist_bucket_us(b);
+        if (bound == UINT32_MAX) printf("  >= %7lu us %8lu\n", (unsigned long)latency_hist_bucket_us(b - 1), (unsigned long)snap.counts[b]);
+        else printf("  <  %7lu us %8lu\n", (unsigned long)bound, (unsigned long)snap.counts[b]);
+    }
+
+    printf("cpu: %.2f s in %.1f s (all threads), %llu hub polls (%.0f/s)\n", cpu, elapsed,
+           (unsigned long long)polls, polls / elapsed);
+
+    ws_hub_destroy(hub);
+    if (uart_bridge_stop(bridge) != ESP_OK) fprintf(stderr, "bridge did not stop\n");
+    close(master);
+    close(slave);
+    return 0;
+}